@@ -9,6 +9,116 @@ AC_COMPILE_IFELSE([AC_LANG_PROGRAM([[
 AC_MSG_RESULT([$has_64bit_asm])
 ])
 
+dnl Check whether the assembler accepts MULX/ADCX/ADOX, which are selected at runtime using CPUID.
+AC_DEFUN([SECP_X86_64_ADX_ASM_CHECK],[
+AC_MSG_CHECKING(for x86_64 MULX/ADX assembly availability)
+AC_COMPILE_IFELSE([AC_LANG_PROGRAM([[
+  #include <stdint.h>
+  #include <cpuid.h>]],[[
+  uint64_t a = 11, b = 13;
+  unsigned int w, x, y, z;
+  __cpuid_count(7, 0, w, x, y, z);
+  __asm__ __volatile__("mulxq %%rax, %%rax, %%rcx; adcxq %%rcx, %%rax; adoxq %%rcx, %%rax" : "+a"(a) : "d"(b) : "rcx", "cc");
+  return (int)(a + x);
+  ]])],[has_x86_64_adx_asm=yes],[has_x86_64_adx_asm=no])
+AC_MSG_RESULT([$has_x86_64_adx_asm])
+])
+
+AC_DEFUN([SECP_AARCH64_ASM_CHECK],[
+AC_MSG_CHECKING(for AArch64 assembly availability)
+AC_COMPILE_IFELSE([AC_LANG_PROGRAM([[
+  #include <stdint.h>]],[[
+  uint64_t a = 11, b = 13, r;
+  __asm__ __volatile__("umulh %0, %1, %2\n extr %0, %0, %1, #52" : "=&r"(r) : "r"(a), "r"(b));
+  return (int)r;
+  ]])],[has_aarch64_asm=yes],[has_aarch64_asm=no])
+AC_MSG_RESULT([$has_aarch64_asm])
+])
+
+dnl Check whether the compiler can build the SHA-NI transform, which is selected at runtime using CPUID.
+AC_DEFUN([SECP_SHA256_X86_SHANI_CHECK],[
+AC_MSG_CHECKING(for x86 SHA extensions availability)
+AC_COMPILE_IFELSE([AC_LANG_PROGRAM([[
+  #include <immintrin.h>
+  #include <cpuid.h>
+  __attribute__((target("sha,sse4.1,ssse3")))
+  static __m128i f(__m128i a, __m128i b, __m128i k) { return _mm_sha256rnds2_epu32(a, _mm_sha256msg2_epu32(b, k), _mm_alignr_epi8(a, b, 4)); }]],[[
+  unsigned int a, b, c, d;
+  __m128i x = _mm_setzero_si128();
+  __cpuid_count(7, 0, a, b, c, d);
+  x = f(x, x, x);
+  return _mm_cvtsi128_si32(x) + (int)b;
+  ]])],[has_sha256_x86_shani=yes],[has_sha256_x86_shani=no])
+AC_MSG_RESULT([$has_sha256_x86_shani])
+])
+
+dnl Check whether the compiler can build the AVX-512 IFMA field arithmetic, which is selected at runtime using CPUID.
+AC_DEFUN([SECP_FIELD_AVX512_IFMA_CHECK],[
+AC_MSG_CHECKING(for AVX-512 IFMA availability)
+AC_COMPILE_IFELSE([AC_LANG_PROGRAM([[
+  #include <immintrin.h>
+  #include <cpuid.h>
+  __attribute__((target("avx512f,avx512ifma")))
+  static long long f(long long a) {
+    __m512i x = _mm512_set1_epi64(a);
+    x = _mm512_madd52hi_epu64(_mm512_madd52lo_epu64(x, x, x), x, x);
+    return _mm_cvtsi128_si64(_mm512_castsi512_si128(x));
+  }]],[[
+  unsigned int a, b, c, d;
+  __cpuid_count(7, 0, a, b, c, d);
+  return (int)f(b);
+  ]])],[has_field_avx512_ifma=yes],[has_field_avx512_ifma=no])
+AC_MSG_RESULT([$has_field_avx512_ifma])
+])
+
+dnl Check whether the compiler can build the AVX2 ecmult_gen table scan, which is selected at runtime using CPUID.
+AC_DEFUN([SECP_ECMULT_GEN_AVX2_CHECK],[
+AC_MSG_CHECKING(for AVX2 availability)
+AC_COMPILE_IFELSE([AC_LANG_PROGRAM([[
+  #include <immintrin.h>
+  #include <cpuid.h>
+  __attribute__((target("avx2")))
+  static int f(int a) {
+    __m256i x = _mm256_set1_epi32(a);
+    x = _mm256_and_si256(_mm256_cmpeq_epi32(x, _mm256_add_epi32(x, x)), x);
+    return _mm_cvtsi128_si32(_mm256_castsi256_si128(x));
+  }]],[[
+  unsigned int a, b, c, d;
+  __cpuid_count(7, 0, a, b, c, d);
+  return f((int)b);
+  ]])],[has_ecmult_gen_avx2=yes],[has_ecmult_gen_avx2=no])
+AC_MSG_RESULT([$has_ecmult_gen_avx2])
+])
+
+dnl Check whether the compiler targets ARMv8 with the SHA2 crypto extensions enabled (e.g. -march=armv8-a+crypto).
+AC_DEFUN([SECP_SHA256_ARM_SHA2_CHECK],[
+AC_MSG_CHECKING(for ARMv8 SHA2 extensions availability)
+AC_COMPILE_IFELSE([AC_LANG_PROGRAM([[
+  #if !defined(__ARM_FEATURE_CRYPTO) && !defined(__ARM_FEATURE_SHA2)
+  #error "no SHA2 extensions"
+  #endif
+  #include <arm_neon.h>]],[[
+  uint32x4_t x = vdupq_n_u32(0);
+  x = vsha256hq_u32(x, x, x);
+  return (int)vgetq_lane_u32(x, 0);
+  ]])],[has_sha256_arm_sha2=yes],[has_sha256_arm_sha2=no])
+AC_MSG_RESULT([$has_sha256_arm_sha2])
+])
+
+dnl Check whether the compiler targets NEON, for the 32-bit field and scalar multiplications.
+AC_DEFUN([SECP_ARM_NEON_CHECK],[
+AC_MSG_CHECKING(for NEON availability)
+AC_COMPILE_IFELSE([AC_LANG_PROGRAM([[
+  #if !defined(__ARM_NEON) && !defined(__ARM_NEON__)
+  #error "no NEON"
+  #endif
+  #include <arm_neon.h>]],[[
+  uint64x2_t x = vmlal_u32(vdupq_n_u64(0), vdup_n_u32(1), vdup_n_u32(2));
+  return (int)vgetq_lane_u64(x, 0);
+  ]])],[has_arm_neon=yes],[has_arm_neon=no])
+AC_MSG_RESULT([$has_arm_neon])
+])
+
 dnl
 AC_DEFUN([SECP_OPENSSL_CHECK],[
   has_libcrypto=no
@@ -14,10 +14,14 @@ fi
 
 ./configure \
     --enable-experimental="$EXPERIMENTAL" \
-    --with-test-override-wide-multiply="$WIDEMUL" --with-bignum="$BIGNUM" --with-asm="$ASM" \
-    --enable-ecmult-static-precomputation="$STATICPRECOMPUTATION" --with-ecmult-gen-precision="$ECMULTGENPRECISION" \
+    --with-test-override-wide-multiply="$WIDEMUL" --with-bignum="$BIGNUM" --with-inversion="$INVERSION" --with-asm="$ASM" \
+    --enable-ecmult-static-precomputation="$STATICPRECOMPUTATION" --with-ecmult-gen-precision="$ECMULTGENPRECISION" --with-ecmult-gen-comb="$ECMULTGENCOMB" \
+    --with-ecmult-window-a="$ECMULTWINDOWA" \
+    --enable-ecmult-static-verify-table="$STATICVERIFYTABLE" --with-sha256="$SHA256" --with-field-simd="$FIELDSIMD" \
     --enable-module-ecdh="$ECDH" --enable-module-recovery="$RECOVERY" \
     --enable-module-schnorrsig="$SCHNORRSIG" \
+    --enable-module-ecmult-multi="$ECMULTMULTI" --enable-module-batch="$BATCH" \
+    --enable-module-musig="$MUSIG" --enable-module-schnorrsig-halfagg="$HALFAGG" \
     --with-valgrind="$WITH_VALGRIND" \
     --host="$HOST" $EXTRAFLAGS
 
@@ -48,6 +52,7 @@ then
         $EXEC ./bench_internal
         $EXEC ./bench_sign
         $EXEC ./bench_verify
+        $EXEC ./bench_footprint
     } >> bench.log 2>&1
     if [ "$RECOVERY" = "yes" ]
     then
@@ -36,7 +36,7 @@ extern "C" {
  *  simultaneously, but API calls that take a non-const pointer to a context
  *  need exclusive access to it. In particular this is the case for
  *  secp256k1_context_destroy, secp256k1_context_preallocated_destroy,
- *  and secp256k1_context_randomize.
+ *  secp256k1_context_randomize and secp256k1_context_reblind.
  *
  *  Regarding randomization, either do it once at creation time (in which case
  *  you do not need any locking for the other calls), or use a read-write lock.
@@ -81,6 +81,19 @@ typedef struct {
     unsigned char data[64];
 } secp256k1_ecdsa_signature;
 
+/** Opaque data structure that holds the precomputed state of a tagged hash
+ *  SHA256(SHA256(tag)||SHA256(tag)||msg), as used by BIP-340 and Taproot.
+ *
+ *  The exact representation of data inside is implementation defined and not
+ *  guaranteed to be portable between different platforms or versions. It is
+ *  however guaranteed to be 32 bytes in size, and can be safely copied/moved.
+ *  Initializing it once with secp256k1_tagged_hasher_init saves two SHA256
+ *  compressions on every subsequent hash with the same tag.
+ */
+typedef struct {
+    unsigned char data[32];
+} secp256k1_tagged_hasher;
+
 /** A pointer to a function to deterministically generate a nonce.
  *
  * Returns: 1 if a nonce was successfully generated. 0 will cause signing to fail.
@@ -199,6 +212,10 @@ SECP256K1_API extern const secp256k1_context *secp256k1_context_no_precomp;
  *  Returns: a newly created context object.
  *  In:      flags: which parts of the context to initialize.
  *
+ *  A library configured with --enable-verify-only ignores SECP256K1_CONTEXT_SIGN:
+ *  its contexts cannot sign or compute public keys from secret keys, and the
+ *  functions that would do so fail as for a context created without that flag.
+ *
  *  See also secp256k1_context_randomize.
  */
 SECP256K1_API secp256k1_context* secp256k1_context_create(
@@ -218,6 +235,25 @@ SECP256K1_API secp256k1_context* secp256k1_context_clone(
     const secp256k1_context* ctx
 ) SECP256K1_ARG_NONNULL(1) SECP256K1_WARN_UNUSED_RESULT;
 
+/** Copy a secp256k1 context object without copying its precomputed tables
+ *  (into dynamically allocated memory).
+ *
+ *  The copy refers to the tables of ctx, which are never modified, and only
+ *  allocates the small mutable part of a context: the blinding used for signing,
+ *  the callbacks and the allocator. This makes it cheap to give every thread its
+ *  own context, e.g. to randomize each with secp256k1_context_randomize, without
+ *  copying megabytes of tables. ctx may be used concurrently with its shared copies.
+ *
+ *  ctx must not be destroyed while any context copied from it this way (or
+ *  cloned from such a copy) still exists.
+ *
+ *  Returns: a newly created context object.
+ *  Args:    ctx: an existing context to copy (cannot be NULL)
+ */
+SECP256K1_API secp256k1_context* secp256k1_context_clone_shared(
+    const secp256k1_context* ctx
+) SECP256K1_ARG_NONNULL(1) SECP256K1_WARN_UNUSED_RESULT;
+
 /** Destroy a secp256k1 context object (created in dynamically allocated memory).
  *
  *  The context pointer may not be used afterwards.
@@ -303,6 +339,74 @@ SECP256K1_API void secp256k1_context_set_error_callback(
     const void* data
 ) SECP256K1_ARG_NONNULL(1);
 
+/** The performance degradations reported to the event callback, with the meaning
+ *  of its wanted and available arguments. */
+/** The scratch space, even after growing, is smaller than what the fastest
+ *  algorithm needs to process the whole input at once. wanted and available are
+ *  sizes in bytes. */
+#define SECP256K1_EVENT_SCRATCH_TOO_SMALL 1
+/** A multi-multiplication is split into several batches, which is slower than
+ *  a single one. wanted is the number of points, available the number per batch. */
+#define SECP256K1_EVENT_ECMULT_MULTI_SPLIT 2
+/** A multi-multiplication uses Strauss' algorithm although Pippenger's would be
+ *  faster for its number of points, for lack of scratch space. wanted is the number
+ *  of points, available the number per batch. */
+#define SECP256K1_EVENT_ECMULT_MULTI_STRAUSS 3
+/** A multi-multiplication is done one point at a time, for lack of scratch space
+ *  for any of the faster algorithms. wanted is the number of points, available the
+ *  size of the scratch space in bytes. */
+#define SECP256K1_EVENT_ECMULT_MULTI_SIMPLE 4
+
+/** Set a callback function to be called when an operation runs slower than it
+ *  could, e.g., because the scratch space it was given is too small. There is no
+ *  callback by default.
+ *
+ *  The events are SECP256K1_EVENT_SCRATCH_TOO_SMALL and following. They are
+ *  reported through the scratch spaces, which take the callback of the context
+ *  when they are created with secp256k1_scratch_space_create or
+ *  secp256k1_scratch_space_create_growable, so the callback should be set before
+ *  creating them. It may be called from any thread that uses such a scratch space.
+ *
+ *  Args: ctx:  an existing context object (cannot be NULL)
+ *  In:   fun:  a pointer to a function to call on an event, taking the event,
+ *              the sizes involved and an opaque pointer (NULL removes the
+ *              callback).
+ *        data: the opaque pointer to pass to fun above.
+ */
+SECP256K1_API void secp256k1_context_set_event_callback(
+    secp256k1_context* ctx,
+    void (*fun)(int event, size_t wanted, size_t available, void* data),
+    const void* data
+) SECP256K1_ARG_NONNULL(1);
+
+/** Set the allocator for the memory the library allocates on behalf of a context.
+ *
+ *  It is used for scratch spaces, contexts cloned with secp256k1_context_clone
+ *  and the objects of the modules (such as batches), which are released with it
+ *  when they are destroyed, even if the allocator of ctx has been changed in the
+ *  meantime. A context created by secp256k1_context_create itself is allocated
+ *  with malloc; use secp256k1_context_preallocated_create to place it elsewhere.
+ *
+ *  The allocator can be called concurrently by threads sharing ctx, and must
+ *  return memory suitably aligned to hold an object of any type, or NULL if it
+ *  fails (which triggers the error callback).
+ *
+ *  Args: ctx:      an existing context object (cannot be NULL)
+ *  In:   alloc_fn: a pointer to a function returning a block of at least size
+ *                  bytes, taking the size and an opaque pointer.
+ *        free_fn:  a pointer to a function releasing a block returned by
+ *                  alloc_fn, taking the block and an opaque pointer. Setting
+ *                  both alloc_fn and free_fn to NULL restores malloc and free;
+ *                  setting only one of them is an illegal argument.
+ *        data:     the opaque pointer to pass to alloc_fn and free_fn above.
+ */
+SECP256K1_API void secp256k1_context_set_allocator(
+    secp256k1_context* ctx,
+    void* (*alloc_fn)(size_t size, void* data),
+    void (*free_fn)(void* ptr, void* data),
+    const void* data
+) SECP256K1_ARG_NONNULL(1);
+
 /** Create a secp256k1 scratch space object.
  *
  *  Returns: a newly created scratch space.
@@ -315,6 +419,41 @@ SECP256K1_API SECP256K1_WARN_UNUSED_RESULT secp256k1_scratch_space* secp256k1_sc
     size_t size
 ) SECP256K1_ARG_NONNULL(1);
 
+/** Create a secp256k1 scratch space object that grows on demand.
+ *
+ *  The scratch space starts out empty. Functions taking a scratch space grow it
+ *  on entry, in chunks and up to max_size bytes, to the size that lets them
+ *  process their whole input at once with the fastest algorithm. As it never
+ *  shrinks, reusing one scratch space for many calls (e.g., one per thread)
+ *  stops allocating once it reached the size the workload needs. If growing
+ *  fails, the available space is used, as with a scratch space of fixed size.
+ *
+ *  Returns: a newly created scratch space.
+ *  Args: ctx:      an existing context object (cannot be NULL)
+ *  In:   max_size: the largest amount of memory to be available as scratch
+ *                  space (cannot be 0).
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT secp256k1_scratch_space* secp256k1_scratch_space_create_growable(
+    const secp256k1_context* ctx,
+    size_t max_size
+) SECP256K1_ARG_NONNULL(1);
+
+/** Determine the high-water mark of a scratch space.
+ *
+ *  This is the largest amount of scratch space any function has used, or would
+ *  have liked to use, since the scratch space was created, so a scratch space
+ *  of this size created with secp256k1_scratch_space_create lets the same calls
+ *  process their inputs as fast as possible.
+ *
+ *  Returns: the high-water mark in bytes.
+ *  Args: ctx:     a secp256k1 context object (cannot be NULL)
+ *  In:   scratch: an existing scratch space (cannot be NULL)
+ */
+SECP256K1_API size_t secp256k1_scratch_space_high_water(
+    const secp256k1_context* ctx,
+    const secp256k1_scratch_space* scratch
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2);
+
 /** Destroy a secp256k1 scratch space.
  *
  *  The pointer may not be used afterwards.
@@ -347,6 +486,31 @@ SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_ec_pubkey_parse(
     size_t inputlen
 ) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3);
 
+/** Parse a number of variable-length public keys.
+ *
+ *  Equivalent to calling secp256k1_ec_pubkey_parse for every input, but faster
+ *  for many compressed keys, whose decompression is done for several keys at
+ *  once. The inputs are read where they are, e.g. in a block buffer.
+ *
+ *  Returns: 1 if all public keys were parsed
+ *           0 if at least one was invalid or could not be parsed. Those public
+ *             keys are zeroed, the others are stored.
+ *  Args:    ctx:       a secp256k1 context object.
+ *  Out:     pubkeys:   pointer to an array of n public keys (can be NULL if n is 0)
+ *  In:      inputs:    pointer to an array of n pointers to serialized public keys
+ *                      (can be NULL if n is 0)
+ *           inputlens: pointer to an array of the n lengths of the inputs
+ *                      (can be NULL if n is 0)
+ *           n:         the number of public keys
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_ec_pubkey_parse_batch(
+    const secp256k1_context* ctx,
+    secp256k1_pubkey* pubkeys,
+    const unsigned char * const *inputs,
+    const size_t *inputlens,
+    size_t n
+) SECP256K1_ARG_NONNULL(1);
+
 /** Serialize a pubkey object into a serialized byte sequence.
  *
  *  Returns: 1 always.
@@ -413,6 +577,30 @@ SECP256K1_API int secp256k1_ecdsa_signature_parse_der(
     size_t inputlen
 ) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3);
 
+/** Parse a number of DER ECDSA signatures.
+ *
+ *  Equivalent to calling secp256k1_ecdsa_signature_parse_der for every input.
+ *  The inputs are read where they are, e.g. in a block buffer.
+ *
+ *  Returns: 1 if all signatures were parsed
+ *           0 if at least one could not be parsed. Those signatures are
+ *             zeroed, the others are stored.
+ *  Args:    ctx:       a secp256k1 context object
+ *  Out:     sigs:      pointer to an array of n signatures (can be NULL if n is 0)
+ *  In:      inputs:    pointer to an array of n pointers to DER signatures
+ *                      (can be NULL if n is 0)
+ *           inputlens: pointer to an array of the n lengths of the inputs
+ *                      (can be NULL if n is 0)
+ *           n:         the number of signatures
+ */
+SECP256K1_API int secp256k1_ecdsa_signature_parse_der_batch(
+    const secp256k1_context* ctx,
+    secp256k1_ecdsa_signature* sigs,
+    const unsigned char * const *inputs,
+    const size_t *inputlens,
+    size_t n
+) SECP256K1_ARG_NONNULL(1);
+
 /** Serialize an ECDSA signature in DER format.
  *
  *  Returns: 1 if enough space was available to serialize, 0 otherwise
@@ -471,6 +659,163 @@ SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_ecdsa_verify(
     const secp256k1_pubkey *pubkey
 ) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3) SECP256K1_ARG_NONNULL(4);
 
+/** Verify many independent ECDSA signatures.
+ *
+ *  Returns: 1: all signatures are correct (or n is 0)
+ *           0: some signature is incorrect or unparseable
+ *  Args:    ctx:     a secp256k1 context object, initialized for verification.
+ *  Out:     results: array of n ints, set to 1 for every correct signature and 0
+ *                    for every other one; NULL if only the total result is needed.
+ *  In:      sigs:    array of pointers to n signatures, NULL if n is 0
+ *           msg32:   array of pointers to n 32-byte message hashes, NULL if n is 0
+ *           pubkeys: array of pointers to the n public keys to verify with, NULL
+ *                    if n is 0
+ *           n:       number of signatures
+ *
+ *  Every signature is verified on its own, exactly like by secp256k1_ecdsa_verify,
+ *  so unlike batch verification the results say which signatures are correct.
+ *  The signatures are verified four at a time in lockstep, which shares part of the
+ *  work and makes better use of the CPU than verifying them one after another.
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_ecdsa_verify_many(
+    const secp256k1_context* ctx,
+    int *results,
+    const secp256k1_ecdsa_signature *const *sigs,
+    const unsigned char *const *msg32,
+    const secp256k1_pubkey *const *pubkeys,
+    size_t n
+) SECP256K1_ARG_NONNULL(1);
+
+/** Opaque data structure that holds a public key prepared for verification.
+ *
+ *  Every verification computes a small table of multiples of the public key
+ *  before it multiplies. A prepared public key holds a wider version of that table
+ *  (about 2 kB), so repeated verifications against the same key, such as those of a
+ *  busy wallet's hot keys, skip loading the key and building the table, and need
+ *  fewer additions.
+ *
+ *  It is not modified after creation and can be shared between threads.
+ */
+typedef struct secp256k1_pubkey_prepared_struct secp256k1_pubkey_prepared;
+
+/** Prepare a public key for verification.
+ *
+ *  Returns: a newly created prepared public key, or NULL if an argument was invalid.
+ *  Args:    ctx:    an existing context object (cannot be NULL)
+ *  In:      pubkey: pointer to the public key to prepare (cannot be NULL)
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT secp256k1_pubkey_prepared* secp256k1_pubkey_prepared_create(
+    const secp256k1_context* ctx,
+    const secp256k1_pubkey *pubkey
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2);
+
+/** Destroy a prepared public key.
+ *
+ *  The pointer may not be used afterwards.
+ *  Args:    ctx:      an existing context object (cannot be NULL)
+ *           prepared: prepared public key to destroy (NULL is ignored)
+ */
+SECP256K1_API void secp256k1_pubkey_prepared_destroy(
+    const secp256k1_context* ctx,
+    secp256k1_pubkey_prepared *prepared
+) SECP256K1_ARG_NONNULL(1);
+
+/** Verify an ECDSA signature with a prepared public key.
+ *
+ *  Returns: 1: correct signature
+ *           0: incorrect or unparseable signature
+ *  Args:    ctx:       a secp256k1 context object, initialized for verification.
+ *  In:      sig:       the signature being verified (cannot be NULL)
+ *           msg32:     the 32-byte message hash being verified (cannot be NULL)
+ *           prepared:  pointer to the prepared public key to verify with (cannot be NULL)
+ *
+ * The result is the same as that of secp256k1_ecdsa_verify with the public key
+ * the prepared key was created from; in particular only lower-S signatures are
+ * accepted.
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_ecdsa_verify_prepared(
+    const secp256k1_context* ctx,
+    const secp256k1_ecdsa_signature *sig,
+    const unsigned char *msg32,
+    const secp256k1_pubkey_prepared *prepared
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3) SECP256K1_ARG_NONNULL(4);
+
+/** Opaque data structure that caches successful signature verifications.
+ *
+ *  Signatures that are verified more than once, e.g. when a transaction is
+ *  first relayed and later included in a block, only need to be verified the
+ *  first time. The cache remembers a 128-bit fingerprint of every signature,
+ *  message and public key that verified, keyed with a secret salt so that the
+ *  fingerprints cannot be predicted. When it is full, new entries evict old ones.
+ *
+ *  The cache can be used by several threads at once without locking, provided
+ *  the compiler supports lock-free 64-bit atomics (GCC and clang on 64-bit
+ *  platforms do). Concurrent use may lose entries but never reports a
+ *  signature that did not verify.
+ */
+typedef struct secp256k1_sigcache_struct secp256k1_sigcache;
+
+/** Create a signature verification cache.
+ *
+ *  Returns: a newly created cache, or NULL if an argument was invalid.
+ *  Args:    ctx:       an existing context object (cannot be NULL)
+ *  In:      n_entries: the number of verifications the cache holds, which must
+ *                      be greater than 0 and below 2^32. Each takes 16 bytes.
+ *           salt32:    32 secret random bytes (cannot be NULL)
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT secp256k1_sigcache* secp256k1_sigcache_create(
+    const secp256k1_context* ctx,
+    size_t n_entries,
+    const unsigned char *salt32
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(3);
+
+/** Destroy a signature verification cache.
+ *
+ *  The pointer may not be used afterwards.
+ *  Args:    ctx:   an existing context object (cannot be NULL)
+ *           cache: cache to destroy (NULL is ignored)
+ */
+SECP256K1_API void secp256k1_sigcache_destroy(
+    const secp256k1_context* ctx,
+    secp256k1_sigcache *cache
+) SECP256K1_ARG_NONNULL(1);
+
+/** Read the counters of a signature verification cache.
+ *
+ *  Args:    ctx:       an existing context object (cannot be NULL)
+ *  In:      cache:     the cache (cannot be NULL)
+ *  Out:     hits:      the number of verifications found in the cache (can be NULL)
+ *           misses:    the number of verifications not found in the cache (can be NULL)
+ *           evictions: the number of entries dropped to make room (can be NULL)
+ */
+SECP256K1_API void secp256k1_sigcache_stats(
+    const secp256k1_context* ctx,
+    const secp256k1_sigcache *cache,
+    size_t *hits,
+    size_t *misses,
+    size_t *evictions
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2);
+
+/** Verify an ECDSA signature, consulting a cache of previous verifications.
+ *
+ *  Returns: 1: correct signature
+ *           0: incorrect or unparseable signature
+ *  Args:    ctx:    a secp256k1 context object, initialized for verification.
+ *           cache:  the cache to consult and to add a correct signature to (cannot be NULL)
+ *  In:      sig:    the signature being verified (cannot be NULL)
+ *           msg32:  the 32-byte message hash being verified (cannot be NULL)
+ *           pubkey: pointer to an initialized public key to verify with (cannot be NULL)
+ *
+ *  The result is the same as that of secp256k1_ecdsa_verify.
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_ecdsa_verify_cached(
+    const secp256k1_context* ctx,
+    secp256k1_sigcache *cache,
+    const secp256k1_ecdsa_signature *sig,
+    const unsigned char *msg32,
+    const secp256k1_pubkey *pubkey
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3) SECP256K1_ARG_NONNULL(4) SECP256K1_ARG_NONNULL(5);
+
 /** Convert a signature to a normalized lower-S form.
  *
  *  Returns: 1 if sigin was not normalized, 0 if it already was.
@@ -521,7 +866,8 @@ SECP256K1_API int secp256k1_ecdsa_signature_normalize(
 
 /** An implementation of RFC6979 (using HMAC-SHA256) as nonce generation function.
  * If a data pointer is passed, it is assumed to be a pointer to 32 bytes of
- * extra entropy.
+ * extra entropy. In a library configured with --enable-verify-only it always
+ * fails.
  */
 SECP256K1_API extern const secp256k1_nonce_function secp256k1_nonce_function_rfc6979;
 
@@ -551,6 +897,150 @@ SECP256K1_API int secp256k1_ecdsa_sign(
     const void *ndata
 ) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3) SECP256K1_ARG_NONNULL(4);
 
+/** Opaque data structure that holds a secret key prepared for signing many
+ *  messages with secp256k1_ecdsa_sign_session.
+ *
+ *  It holds the secret key; erase it (for example with memset) when it is no
+ *  longer needed. The exact representation of data inside is implementation
+ *  defined and not guaranteed to be portable between different platforms or
+ *  versions. It is however guaranteed to be 64 bytes in size, and can be safely
+ *  copied/moved.
+ */
+typedef struct {
+    unsigned char data[64];
+} secp256k1_ecdsa_session;
+
+/** Prepare a secret key for signing many messages.
+ *
+ *  RFC6979 starts by hashing the secret key with a fixed HMAC key and prefix;
+ *  the session stores that hash state, so that signatures made with it skip
+ *  the SHA256 compressions of the key.
+ *
+ *  Returns 1 on success, 0 if the secret key is invalid (in which case the
+ *  session is zeroed).
+ *  Args:    ctx: pointer to a context object (cannot be NULL)
+ *  Out: session: pointer to the session to initialize (cannot be NULL)
+ *  In:   seckey: pointer to a 32-byte secret key (cannot be NULL)
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_ecdsa_session_init(
+    const secp256k1_context* ctx,
+    secp256k1_ecdsa_session *session,
+    const unsigned char *seckey
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3);
+
+/** Create an ECDSA signature with a session.
+ *
+ *  The signature is the one secp256k1_ecdsa_sign creates with the secret key
+ *  of the session and secp256k1_nonce_function_rfc6979.
+ *
+ *  Returns: 1: signature created
+ *           0: the session was not initialized with a valid secret key
+ *  Args:    ctx:     pointer to a context object, initialized for signing (cannot be NULL)
+ *  Out:     sig:     pointer to an array where the signature will be placed (cannot be NULL)
+ *  In:      msg32:   the 32-byte message hash being signed (cannot be NULL)
+ *           session: pointer to a session initialized with
+ *                    secp256k1_ecdsa_session_init (cannot be NULL)
+ *           ndata:   pointer to 32 bytes of extra entropy, as for
+ *                    secp256k1_nonce_function_rfc6979, or NULL
+ */
+SECP256K1_API int secp256k1_ecdsa_sign_session(
+    const secp256k1_context* ctx,
+    secp256k1_ecdsa_signature *sig,
+    const unsigned char *msg32,
+    const secp256k1_ecdsa_session *session,
+    const unsigned char *ndata
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3) SECP256K1_ARG_NONNULL(4);
+
+/** Opaque data structure that holds signing nonces computed ahead of time.
+ *
+ *  Signing with a nonce from a pool skips the multiplication R = k*G, which
+ *  dominates the time of a signature, leaving a few scalar operations (and for
+ *  BIP-340, the challenge hash). The nonces are derived from randomness the
+ *  caller provides to secp256k1_nonce_pool_fill, and every nonce is erased from
+ *  the pool when a signature takes it, so no nonce is used twice.
+ *
+ *  This relies on the pool (its memory) never being duplicated: never copy it,
+ *  and do not sign with it in both a process and a child forked from it. Signing
+ *  two different messages with the same nonce reveals the secret key. The seeds
+ *  must be secret and unpredictable; unlike with the default nonce functions,
+ *  signatures with pooled nonces are not deterministic and their security
+ *  depends on the quality of these seeds.
+ *
+ *  A pool must not be used from several threads at once.
+ */
+typedef struct secp256k1_nonce_pool_struct secp256k1_nonce_pool;
+
+/** Create an empty nonce pool.
+ *
+ *  Returns: a newly created pool, or NULL if an argument was invalid.
+ *  Args:    ctx:      an existing context object (cannot be NULL)
+ *  In:      n_nonces: the number of nonces the pool holds, which must be greater
+ *                     than 0. Each takes at most 96 bytes.
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT secp256k1_nonce_pool* secp256k1_nonce_pool_create(
+    const secp256k1_context* ctx,
+    size_t n_nonces
+) SECP256K1_ARG_NONNULL(1);
+
+/** Destroy a nonce pool, erasing the nonces left in it.
+ *
+ *  The pointer may not be used afterwards.
+ *  Args:    ctx:  an existing context object (cannot be NULL)
+ *           pool: pool to destroy (NULL is ignored)
+ */
+SECP256K1_API void secp256k1_nonce_pool_destroy(
+    const secp256k1_context* ctx,
+    secp256k1_nonce_pool *pool
+) SECP256K1_ARG_NONNULL(1);
+
+/** Fill a nonce pool up to its capacity.
+ *
+ *  The nonces are computed by a generator into which every call mixes seed32,
+ *  so passing the same seed to one pool twice does not repeat nonces. Each new
+ *  nonce costs about as much as a signature.
+ *
+ *  Returns: 1 always, except for invalid arguments.
+ *  Args:    ctx:    pointer to a context object, initialized for signing (cannot be NULL)
+ *  In/Out:  pool:   the pool to fill (cannot be NULL)
+ *  In:      seed32: 32 bytes of fresh secret randomness (cannot be NULL)
+ */
+SECP256K1_API int secp256k1_nonce_pool_fill(
+    const secp256k1_context* ctx,
+    secp256k1_nonce_pool *pool,
+    const unsigned char *seed32
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3);
+
+/** Return the number of nonces left in a pool.
+ *
+ *  Args:    ctx:  an existing context object (cannot be NULL)
+ *  In:      pool: the pool (cannot be NULL)
+ */
+SECP256K1_API size_t secp256k1_nonce_pool_count(
+    const secp256k1_context* ctx,
+    const secp256k1_nonce_pool *pool
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2);
+
+/** Create an ECDSA signature with a nonce from a pool.
+ *
+ *  Returns: 1: signature created
+ *           0: the pool was empty, or the secret key was invalid.
+ *  Args:    ctx:    pointer to a context object (cannot be NULL)
+ *  Out:     sig:    pointer to an array where the signature will be placed (cannot be NULL)
+ *  In:      msg32:  the 32-byte message hash being signed (cannot be NULL)
+ *           seckey: pointer to a 32-byte secret key (cannot be NULL)
+ *  In/Out:  pool:   the pool to take a nonce from (cannot be NULL)
+ *
+ *  A nonce is taken from the pool even if the secret key is invalid. The created
+ *  signature is always in lower-S form.
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_ecdsa_sign_pooled(
+    const secp256k1_context* ctx,
+    secp256k1_ecdsa_signature *sig,
+    const unsigned char *msg32,
+    const unsigned char *seckey,
+    secp256k1_nonce_pool *pool
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3) SECP256K1_ARG_NONNULL(4) SECP256K1_ARG_NONNULL(5);
+
 /** Verify an ECDSA secret key.
  *
  *  A secret key is valid if it is not 0 and less than the secp256k1 curve order
@@ -582,6 +1072,58 @@ SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_ec_pubkey_create(
     const unsigned char *seckey
 ) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3);
 
+/** Compute the public keys for a number of secret keys.
+ *
+ *  Equivalent to calling secp256k1_ec_pubkey_create for every secret key, but
+ *  faster because the conversion of the results to affine coordinates shares
+ *  a single field inversion between several keys. It is constant time in the
+ *  secret keys, like secp256k1_ec_pubkey_create.
+ *
+ *  Returns: 1: all secret keys were valid, public keys stored
+ *           0: at least one secret key was invalid. The public keys of the
+ *              invalid secret keys are zeroed, the others are stored.
+ *  Args:   ctx:     pointer to a context object, initialized for signing (cannot be NULL)
+ *  Out:    pubkeys: pointer to an array of n public keys (can be NULL if n is 0)
+ *  In:     seckeys: pointer to an array of n pointers to 32-byte secret keys
+ *                   (can be NULL if n is 0)
+ *          n:       the number of secret keys
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_ec_pubkey_create_batch(
+    const secp256k1_context* ctx,
+    secp256k1_pubkey *pubkeys,
+    const unsigned char * const *seckeys,
+    size_t n
+) SECP256K1_ARG_NONNULL(1);
+
+/** Compute the x coordinates of the public keys of a range of consecutive secret keys.
+ *
+ *  Equivalent to calling secp256k1_ec_pubkey_create for seckey, seckey + 1, ...,
+ *  seckey + n - 1 (modulo the group order) and serializing the x coordinate of each
+ *  result, but much faster: only the first key is found by a multiplication, after
+ *  which every key is the previous one plus the generator, with the inversions of
+ *  these additions shared between many keys.
+ *
+ *  Only the first multiplication is constant time. The time the rest takes depends
+ *  on the resulting public keys, so this should only be used where those are public,
+ *  or where leaking them before they are published is acceptable.
+ *
+ *  Returns: 1: all public keys were computed
+ *           0: the secret key was invalid, or one of the keys in the range is zero
+ *              modulo the group order. The x coordinates of those keys (or of all
+ *              keys, for an invalid secret key) are set to zero.
+ *  Args:    ctx:    pointer to a context object initialized for signing (cannot be NULL)
+ *  Out:     xs32:   pointer to a 32*n-byte array to receive the x coordinates, that of
+ *                   the public key of seckey + i at xs32 + 32*i (can be NULL if n is 0)
+ *  In:      seckey: pointer to the 32-byte first secret key of the range (cannot be NULL)
+ *           n:      the number of keys
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_ec_pubkey_create_range(
+    const secp256k1_context* ctx,
+    unsigned char *xs32,
+    const unsigned char *seckey,
+    size_t n
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(3);
+
 /** Negates a secret key in place.
  *
  *  Returns: 0 if the given secret key is invalid according to
@@ -665,6 +1207,59 @@ SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_ec_pubkey_tweak_add(
     const unsigned char *tweak
 ) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3);
 
+/** Tweak a number of public keys, each by adding its tweak times the generator to it.
+ *
+ *  Equivalent to calling secp256k1_ec_pubkey_tweak_add for every public key, but
+ *  faster because the conversion of the results to affine coordinates shares a
+ *  single field inversion between several keys. To derive many children of one
+ *  key (as in BIP32), pass copies of it.
+ *
+ *  Returns: 1 if all public keys were tweaked
+ *           0 if at least one tweak or resulting public key was invalid. Those
+ *             public keys are set to an invalid value, the others are tweaked.
+ *  Args:    ctx:     pointer to a context object initialized for validation
+ *                    (cannot be NULL).
+ *  In/Out:  pubkeys: pointer to an array of n public keys (can be NULL if n is 0)
+ *  In:      tweaks:  pointer to an array of n pointers to 32-byte tweaks
+ *                    (can be NULL if n is 0)
+ *           n:       the number of public keys
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_ec_pubkey_tweak_add_batch(
+    const secp256k1_context* ctx,
+    secp256k1_pubkey *pubkeys,
+    const unsigned char * const *tweaks,
+    size_t n
+) SECP256K1_ARG_NONNULL(1);
+
+/** Derive a number of children of one public key, each by adding its tweak times
+ *  the generator to the parent.
+ *
+ *  This is the public part of BIP32 non-hardened derivation: with tweaks[i] set to
+ *  the first 32 bytes of HMAC-SHA512(chain code, parent || index), children[i] is
+ *  the public key of that child. Compared to secp256k1_ec_pubkey_tweak_add, the
+ *  parent is loaded once, the tweaks are multiplied using the precomputed
+ *  generator tables of a signing context, and the conversion of the children to
+ *  affine coordinates shares a single field inversion between several of them.
+ *
+ *  Returns: 1 if all children were derived
+ *           0 if the parent is invalid, or at least one tweak or resulting
+ *             public key was invalid. Those children are set to an invalid value.
+ *  Args:    ctx:      pointer to a context object initialized for signing
+ *                     (cannot be NULL).
+ *  Out:     children: pointer to an array of n public keys (can be NULL if n is 0)
+ *  In:      parent:   pointer to the public key to derive from (cannot be NULL)
+ *           tweaks:   pointer to an array of n pointers to 32-byte tweaks
+ *                     (can be NULL if n is 0)
+ *           n:        the number of children
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_ec_pubkey_derive_batch(
+    const secp256k1_context* ctx,
+    secp256k1_pubkey *children,
+    const secp256k1_pubkey *parent,
+    const unsigned char * const *tweaks,
+    size_t n
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(3);
+
 /** Tweak a secret key by multiplying it by a tweak.
  *
  *  Returns: 0 if the arguments are invalid. 1 otherwise.
@@ -740,6 +1335,69 @@ SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_context_randomize(
     const unsigned char *seed32
 ) SECP256K1_ARG_NONNULL(1);
 
+/** Cheaply updates the context randomization, without new randomness.
+ *  Returns: 1 always.
+ *  Args:    ctx:       pointer to a context object (cannot be NULL)
+ *
+ * The blinding values are derived deterministically from the current ones, for a
+ * few percent of the cost of a signature (secp256k1_context_randomize costs about
+ * as much as one). This keeps the values that the multiplications in successive
+ * signatures work with changing, but adds no entropy: it is only as good as the
+ * last seed given to secp256k1_context_randomize, which should still be called
+ * after creating the context and periodically afterwards.
+ *
+ * Like secp256k1_context_randomize, this has an effect only on contexts
+ * initialized for signing, and needs exclusive access to the context. Signing
+ * functions never re-blind by themselves; to re-blind every N signatures, count
+ * them and call this where the context is not shared, e.g. under the same lock
+ * as secp256k1_context_randomize.
+ */
+SECP256K1_API int secp256k1_context_reblind(
+    secp256k1_context* ctx
+) SECP256K1_ARG_NONNULL(1);
+
+/** The operation counters of secp256k1_counters_snapshot. */
+#define SECP256K1_COUNTER_FE_MUL 0              /* field multiplications */
+#define SECP256K1_COUNTER_FE_SQR 1              /* field squarings */
+#define SECP256K1_COUNTER_FE_INV 2              /* field inversions */
+#define SECP256K1_COUNTER_FE_SQRT 3             /* field square roots */
+#define SECP256K1_COUNTER_GEJ_ADD 4             /* point additions */
+#define SECP256K1_COUNTER_GEJ_DOUBLE 5          /* point doublings */
+#define SECP256K1_COUNTER_SHA256_TRANSFORM 6    /* SHA256 blocks */
+#define SECP256K1_COUNTER_SCRATCH_EXHAUSTED 7   /* scratch space allocations that did not fit */
+#define SECP256K1_COUNTER_ECMULT_MULTI_SIMPLE 8 /* multi-multiplications done one point at a
+                                                   time, without (enough) scratch space */
+#define SECP256K1_COUNTER_COUNT 9
+
+/** Read the operation counters of the calling thread.
+ *
+ *  Returns: 1 if the library was built with --enable-counters, 0 otherwise (in
+ *           which case all counts are zero)
+ *  Args:    ctx:    pointer to a context object (cannot be NULL)
+ *  Out:     counts: pointer to an array of n counts, of which count i is set to the
+ *                   number of operations of kind i (see SECP256K1_COUNTER_FE_MUL
+ *                   and following) since the last secp256k1_counters_reset, and any
+ *                   past SECP256K1_COUNTER_COUNT to zero (cannot be NULL)
+ *  In:      n:      the number of counts to read
+ *
+ *  The counters are kept per thread, for all contexts, so as not to slow down
+ *  the operations they count with synchronization. Counting costs little (within
+ *  the noise of the benchmarks); without --enable-counters it costs nothing.
+ */
+SECP256K1_API int secp256k1_counters_snapshot(
+    const secp256k1_context* ctx,
+    size_t *counts,
+    size_t n
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2);
+
+/** Reset the operation counters of the calling thread to zero.
+ *
+ *  Args:    ctx:    pointer to a context object (cannot be NULL)
+ */
+SECP256K1_API void secp256k1_counters_reset(
+    const secp256k1_context* ctx
+) SECP256K1_ARG_NONNULL(1);
+
 /** Add a number of public keys together.
  *
  *  Returns: 1: the sum of the public keys is valid.
@@ -757,6 +1415,74 @@ SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_ec_pubkey_combine(
     size_t n
 ) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3);
 
+/** Add a number of groups of public keys together, one sum per group.
+ *
+ *  Equivalent to calling secp256k1_ec_pubkey_combine once per group, but faster
+ *  because the conversion of the sums to affine coordinates shares a single field
+ *  inversion between several groups. The keys of each group are consecutive in
+ *  ins: the first group_sizes[0] keys are added into outs[0], the next
+ *  group_sizes[1] keys into outs[1], and so on.
+ *
+ *  If vartime is nonzero the sums are computed with variable-time formulas, which
+ *  is faster but must only be used when the public keys are not secret (e.g. when
+ *  aggregating keys that are published anyway).
+ *
+ *  Returns: 1 if all sums are valid
+ *           0 if at least one group is empty or sums to infinity. Those outputs are
+ *             set to an invalid value, the others are set to their sum.
+ *  Args:    ctx:         pointer to a context object (cannot be NULL)
+ *  Out:     outs:        pointer to an array of n_outs public keys (can be NULL if
+ *                        n_outs is 0)
+ *  In:      n_outs:      the number of groups
+ *           ins:         pointer to an array of pointers to public keys, holding the
+ *                        sum of group_sizes[i] entries (can be NULL if that is 0)
+ *           group_sizes: pointer to an array of n_outs group sizes (can be NULL if
+ *                        n_outs is 0)
+ *           vartime:     whether variable-time formulas may be used
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_ec_pubkey_combine_batch(
+    const secp256k1_context* ctx,
+    secp256k1_pubkey *outs,
+    size_t n_outs,
+    const secp256k1_pubkey * const * ins,
+    const size_t *group_sizes,
+    int vartime
+) SECP256K1_ARG_NONNULL(1);
+
+/** Precompute the state of a tagged hash for a given tag.
+ *
+ *  Returns: 0 if the arguments are invalid and 1 otherwise.
+ *  Args:    ctx: pointer to a context object (cannot be NULL)
+ *  Out:  hasher: pointer to a tagged hasher object (cannot be NULL)
+ *  In:      tag: pointer to an array containing the tag (cannot be NULL unless taglen is 0)
+ *        taglen: length of the tag array
+ */
+SECP256K1_API int secp256k1_tagged_hasher_init(
+    const secp256k1_context* ctx,
+    secp256k1_tagged_hasher *hasher,
+    const unsigned char *tag,
+    size_t taglen
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2);
+
+/** Compute a tagged hash SHA256(SHA256(tag)||SHA256(tag)||msg) using a tagged hasher
+ *  initialized with that tag.
+ *
+ *  Returns: 0 if the arguments are invalid and 1 otherwise.
+ *  Args:    ctx: pointer to a context object (cannot be NULL)
+ *  Out:  hash32: pointer to a 32-byte array to store the resulting hash (cannot be NULL)
+ *  In:   hasher: pointer to a tagged hasher initialized with secp256k1_tagged_hasher_init
+ *                (cannot be NULL)
+ *           msg: pointer to an array containing the message (cannot be NULL unless msglen is 0)
+ *        msglen: length of the message array
+ */
+SECP256K1_API int secp256k1_tagged_hasher_hash(
+    const secp256k1_context* ctx,
+    unsigned char *hash32,
+    const secp256k1_tagged_hasher *hasher,
+    const unsigned char *msg,
+    size_t msglen
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3);
+
 #ifdef __cplusplus
 }
 #endif
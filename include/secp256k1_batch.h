@@ -0,0 +1,309 @@
+#ifndef SECP256K1_BATCH_H
+#define SECP256K1_BATCH_H
+
+#include "secp256k1.h"
+#include "secp256k1_extrakeys.h"
+#include "secp256k1_schnorrsig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** This module implements a verification batch: an object that accumulates
+ *  checks of different kinds (Schnorr signatures, x-only tweak checks) and
+ *  verifies all of them with multi-scalar multiplications.
+ *
+ *  Every added check is multiplied by a randomizer that is derived from a hash
+ *  of all checks added so far (including itself), and its terms are appended to
+ *  the batch. Whenever the batch does not have room for the terms of a new
+ *  check, the terms collected so far are evaluated with a single
+ *  multi-scalar multiplication and the batch is emptied. Checks can therefore
+ *  be streamed into a batch of fixed size without buffering the inputs.
+ *
+ *  By default a batch only reports whether all added checks are valid. In
+ *  bisection mode (see secp256k1_batch_set_invalid_callback), it also reports
+ *  which checks failed. */
+
+/** Opaque data structure that holds a verification batch. */
+typedef struct secp256k1_batch_struct secp256k1_batch;
+
+/** Create a verification batch.
+ *
+ *  Returns: a newly created batch object, or NULL if max_terms is invalid.
+ *  Args:       ctx: an existing context object (cannot be NULL)
+ *  In:   max_terms: the number of (scalar, point) terms to collect before they
+ *                   are evaluated. A Schnorr signature or a tweak check uses
+ *                   two terms. Must be at least 2 and less than 2^31.
+ *                   Larger values use more memory and make the evaluation
+ *                   faster per term.
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT secp256k1_batch* secp256k1_batch_create(
+    const secp256k1_context* ctx,
+    size_t max_terms
+) SECP256K1_ARG_NONNULL(1);
+
+/** Destroy a verification batch.
+ *
+ *  The pointer may not be used afterwards.
+ *  Args:   ctx: a secp256k1 context object (cannot be NULL)
+ *        batch: the batch to destroy (can be NULL, in which case nothing happens)
+ */
+SECP256K1_API void secp256k1_batch_destroy(
+    const secp256k1_context* ctx,
+    secp256k1_batch* batch
+) SECP256K1_ARG_NONNULL(1);
+
+/** A pointer to a function that receives the index of a failing check, counting
+ *  the checks added to the batch (with valid arguments) from 0.
+ *
+ *  In:  idx:  the index of the failing check
+ *       data: the data pointer passed to secp256k1_batch_set_invalid_callback
+ */
+typedef void (*secp256k1_batch_invalid_function)(
+    size_t idx,
+    void *data
+);
+
+/** Put a batch into bisection mode, in which the failing checks are reported.
+ *
+ *  Checks that are known to fail without evaluating them are reported when
+ *  they are added. When the evaluation of the collected terms fails, the
+ *  failing checks among them are located by evaluating halves of the failing
+ *  ranges of checks, reusing their terms. If the first half of a failing range
+ *  holds, the second half is known to fail without evaluating it, so k failing
+ *  checks among n cost O(k log n) multi-scalar multiplications instead of n
+ *  individual verifications. The evaluation continues after a failure, so
+ *  every failing check is reported (in no particular order) once
+ *  secp256k1_batch_verify has returned.
+ *
+ *  Returns: 1 if the mode was set, 0 if the arguments are invalid.
+ *  Args:     ctx: a secp256k1 context object (cannot be NULL)
+ *          batch: a batch object to which no checks were added yet (cannot be NULL)
+ *  In:   invalid: function receiving the indices of the failing checks, or NULL to
+ *                 leave bisection mode
+ *           data: arbitrary data pointer passed to invalid
+ */
+SECP256K1_API int secp256k1_batch_set_invalid_callback(
+    const secp256k1_context* ctx,
+    secp256k1_batch *batch,
+    secp256k1_batch_invalid_function invalid,
+    void *data
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2);
+
+/** Verify all checks added to a batch.
+ *
+ *  Evaluates the terms that have not been evaluated yet. The batch stays
+ *  usable: further checks can be added and verified, and the result keeps
+ *  covering all checks added since the batch was created.
+ *
+ *  Returns: 1 if all checks added to the batch are valid (in particular if none
+ *           were added), 0 otherwise.
+ *  Args:    ctx: a secp256k1 context object, initialized for verification
+ *                (cannot be NULL)
+ *         batch: a batch object (cannot be NULL)
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_batch_verify(
+    const secp256k1_context *ctx,
+    secp256k1_batch *batch
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2);
+
+/** Add the check of secp256k1_xonly_pubkey_tweak_add_check to a batch.
+ *
+ *  Returns: 0 if the arguments are invalid or the check is known to fail
+ *           without evaluating it (in which case the batch will fail), or if
+ *           an evaluation of the batch triggered by the addition failed.
+ *           1 otherwise.
+ *  Args:              ctx: a secp256k1 context object, initialized for verification
+ *                          (cannot be NULL)
+ *                   batch: a batch object (cannot be NULL)
+ *  In:   tweaked_pubkey32: pointer to a serialized xonly_pubkey (cannot be NULL)
+ *       tweaked_pk_parity: the parity of the tweaked pubkey, as in
+ *                          secp256k1_xonly_pubkey_tweak_add_check
+ *         internal_pubkey: pointer to the x-only public key the tweak is applied to
+ *                          (cannot be NULL)
+ *                 tweak32: pointer to a 32-byte tweak (cannot be NULL)
+ */
+SECP256K1_API int secp256k1_batch_add_xonly_tweak_check(
+    const secp256k1_context* ctx,
+    secp256k1_batch *batch,
+    const unsigned char *tweaked_pubkey32,
+    int tweaked_pk_parity,
+    const secp256k1_xonly_pubkey *internal_pubkey,
+    const unsigned char *tweak32
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3) SECP256K1_ARG_NONNULL(5) SECP256K1_ARG_NONNULL(6);
+
+/** Add a Schnorr signature verification, as in secp256k1_schnorrsig_verify, to a batch.
+ *
+ *  Returns: 0 if the arguments are invalid or the signature is known to be
+ *           invalid without evaluating it (in which case the batch will fail),
+ *           or if an evaluation of the batch triggered by the addition failed.
+ *           1 otherwise.
+ *  Args:    ctx: a secp256k1 context object, initialized for verification
+ *                (cannot be NULL)
+ *         batch: a batch object (cannot be NULL)
+ *  In:    sig64: pointer to the 64-byte signature (cannot be NULL)
+ *         msg32: the 32-byte message being verified (cannot be NULL)
+ *        pubkey: pointer to an x-only public key (cannot be NULL)
+ */
+SECP256K1_API int secp256k1_batch_add_schnorrsig(
+    const secp256k1_context* ctx,
+    secp256k1_batch *batch,
+    const unsigned char *sig64,
+    const unsigned char *msg32,
+    const secp256k1_xonly_pubkey *pubkey
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3) SECP256K1_ARG_NONNULL(4) SECP256K1_ARG_NONNULL(5);
+
+/** A verification pipeline collects Schnorr signatures as they arrive, and
+ *  verifies them in blocks without blocking the caller.
+ *
+ *  Submitted signatures are appended to the current block, which is handed to
+ *  an executor when it is full, when its oldest signature has waited for a
+ *  given time, or when the pipeline is flushed. The executor runs the
+ *  verification of the block, for example on a worker thread. The block is
+ *  verified with a single multi-scalar multiplication (as in a batch), and if
+ *  that fails, invalid signatures are located by repeatedly splitting the
+ *  failing part of the block in halves, so that k invalid signatures in a
+ *  block of n only cost O(k log n) multi-scalar multiplications. The result of
+ *  every submitted signature is reported through a completion callback. */
+
+/** Opaque data structure that holds a verification pipeline. */
+typedef struct secp256k1_batch_pipeline_struct secp256k1_batch_pipeline;
+
+/** A pointer to a function that receives the result of a submitted signature.
+ *
+ *  It is called exactly once for every submitted signature, from the job that
+ *  verifies its block, i.e. on the thread the executor runs the job on. The
+ *  signatures of a block are completed in the order they were submitted. The
+ *  function must not call any function on the pipeline.
+ *
+ *  In:  tag:   the tag passed to secp256k1_batch_pipeline_submit
+ *       valid: 1 if the signature is valid, 0 otherwise
+ *       data:  the completion data passed to secp256k1_batch_pipeline_create
+ */
+typedef void (*secp256k1_batch_pipeline_complete_function)(
+    void *tag,
+    int valid,
+    void *data
+);
+
+/** A pointer to a function that runs a verification job, for example by
+ *  queueing it on a caller-managed thread pool. The library itself never
+ *  creates threads.
+ *
+ *  The job must be called exactly once, as job(job_data), from any thread and
+ *  at any time. Jobs do not access the pipeline, so they may run concurrently
+ *  with each other and with calls on the pipeline, and after it was destroyed.
+ *
+ *  Returns: 1 if the job was accepted. If 0 is returned, the job is not called
+ *           by the executor, and the pipeline runs it before returning instead.
+ *  In:      job:      function to call as job(job_data)
+ *           job_data: opaque pointer to pass to job
+ *           data:     the executor data passed to secp256k1_batch_pipeline_create
+ */
+typedef int (*secp256k1_batch_pipeline_executor_function)(
+    void (*job)(void *job_data),
+    void *job_data,
+    void *data
+);
+
+/** Create a verification pipeline.
+ *
+ *  Returns: a newly created pipeline object, or NULL if the arguments are invalid.
+ *  Args:          ctx: a secp256k1 context object, initialized for verification
+ *                      (cannot be NULL). The jobs verify with this context, so it
+ *                      must not be destroyed before all jobs have run.
+ *  In:       max_sigs: the number of signatures in a block. Must be at least 1
+ *                      and less than 2^30.
+ *           max_delay: the time, in the units of the now argument of
+ *                      secp256k1_batch_pipeline_submit and
+ *                      secp256k1_batch_pipeline_poll, after which a block is
+ *                      handed to the executor even if it is not full. 0 means
+ *                      that blocks are only handed over when full or flushed.
+ *            complete: function receiving the results (cannot be NULL)
+ *       complete_data: arbitrary data pointer passed to complete
+ *            executor: function running the verification jobs, or NULL to run
+ *                      them synchronously in the call that hands a block over
+ *       executor_data: arbitrary data pointer passed to executor
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT secp256k1_batch_pipeline* secp256k1_batch_pipeline_create(
+    const secp256k1_context* ctx,
+    size_t max_sigs,
+    size_t max_delay,
+    secp256k1_batch_pipeline_complete_function complete,
+    void *complete_data,
+    secp256k1_batch_pipeline_executor_function executor,
+    void *executor_data
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(4);
+
+/** Destroy a verification pipeline.
+ *
+ *  Signatures that have not been handed to the executor yet are handed over
+ *  first, so every submitted signature is completed. Jobs that have not run yet
+ *  are not affected. The pointer may not be used afterwards.
+ *  Args:      ctx: a secp256k1 context object (cannot be NULL)
+ *        pipeline: the pipeline to destroy (can be NULL, in which case nothing happens)
+ */
+SECP256K1_API void secp256k1_batch_pipeline_destroy(
+    const secp256k1_context* ctx,
+    secp256k1_batch_pipeline* pipeline
+) SECP256K1_ARG_NONNULL(1);
+
+/** Submit a Schnorr signature verification, as in secp256k1_schnorrsig_verify,
+ *  to a pipeline.
+ *
+ *  The inputs are copied. If the signature fills the current block, or the
+ *  oldest signature of the block has waited for max_delay, the block is handed
+ *  to the executor.
+ *
+ *  Returns: 1 if the signature was submitted, and will be completed.
+ *           0 if the arguments are invalid or memory for a new block could not
+ *           be allocated; the signature is not completed in this case.
+ *  Args:      ctx: a secp256k1 context object (cannot be NULL)
+ *        pipeline: a pipeline object (cannot be NULL)
+ *  In:      sig64: pointer to the 64-byte signature (cannot be NULL)
+ *           msg32: the 32-byte message being verified (cannot be NULL)
+ *          pubkey: pointer to an x-only public key (cannot be NULL)
+ *             tag: arbitrary pointer passed to the completion function
+ *             now: the current time in caller-defined units, from a clock
+ *                  that does not go backwards (wrapping around is fine)
+ */
+SECP256K1_API int secp256k1_batch_pipeline_submit(
+    const secp256k1_context* ctx,
+    secp256k1_batch_pipeline *pipeline,
+    const unsigned char *sig64,
+    const unsigned char *msg32,
+    const secp256k1_xonly_pubkey *pubkey,
+    void *tag,
+    size_t now
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3) SECP256K1_ARG_NONNULL(4) SECP256K1_ARG_NONNULL(5);
+
+/** Hand the current block to the executor if its oldest signature has waited
+ *  for max_delay. Call this periodically when signatures may stop arriving.
+ *
+ *  Returns: 1 if a block was handed over, 0 otherwise.
+ *  Args:      ctx: a secp256k1 context object (cannot be NULL)
+ *        pipeline: a pipeline object (cannot be NULL)
+ *  In:        now: the current time, as in secp256k1_batch_pipeline_submit
+ */
+SECP256K1_API int secp256k1_batch_pipeline_poll(
+    const secp256k1_context* ctx,
+    secp256k1_batch_pipeline *pipeline,
+    size_t now
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2);
+
+/** Hand the current block to the executor, if it is not empty.
+ *
+ *  Returns: 1 if a block was handed over, 0 otherwise.
+ *  Args:      ctx: a secp256k1 context object (cannot be NULL)
+ *        pipeline: a pipeline object (cannot be NULL)
+ */
+SECP256K1_API int secp256k1_batch_pipeline_flush(
+    const secp256k1_context* ctx,
+    secp256k1_batch_pipeline *pipeline
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SECP256K1_BATCH_H */
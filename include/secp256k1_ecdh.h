@@ -55,6 +55,111 @@ SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_ecdh(
   void *data
 ) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3) SECP256K1_ARG_NONNULL(4);
 
+/** Compute EC Diffie-Hellman secrets of one secret key with a number of public keys,
+ *  in constant time
+ *
+ *  Equivalent to calling secp256k1_ecdh for every public key, but faster because the
+ *  secret key is decomposed only once and the conversion of the shared points to
+ *  affine coordinates shares a single field inversion between several public keys.
+ *
+ *  Returns: 1: exponentiation was successful for all public keys
+ *           0: scalar was invalid (zero or overflow) or hashfp returned 0 for at
+ *              least one public key. hashfp is still called for every public key.
+ *  Args:    ctx:        pointer to a context object (cannot be NULL)
+ *  Out:     outputs:    pointer to an array of n pointers to arrays to be filled by
+ *                       hashfp (can be NULL if n is 0)
+ *  In:      pubkeys:    pointer to an array of n pointers to initialized public keys
+ *                       (can be NULL if n is 0)
+ *           n:          the number of public keys
+ *           seckey:     a 32-byte scalar with which to multiply the points
+ *           hashfp:     pointer to a hash function. If NULL, secp256k1_ecdh_hash_function_sha256 is used
+ *                       (in which case, 32 bytes will be written to every output)
+ *           data:       arbitrary data pointer that is passed through to hashfp
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_ecdh_batch(
+  const secp256k1_context* ctx,
+  unsigned char * const *outputs,
+  const secp256k1_pubkey * const *pubkeys,
+  size_t n,
+  const unsigned char *seckey,
+  secp256k1_ecdh_hash_function hashfp,
+  void *data
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(5);
+
+/** A pointer to a function that hashes the x coordinate of an EC point to obtain
+ *  an ECDH secret
+ *
+ *  Returns: 1 if the x coordinate was successfully hashed.
+ *           0 will cause secp256k1_ecdh_xonly to fail and return 0.
+ *           Other return values are not allowed, and the behaviour of
+ *           secp256k1_ecdh_xonly is undefined for other return values.
+ *  Out:     output:     pointer to an array to be filled by the function
+ *  In:      x32:        pointer to a 32-byte x coordinate
+ *           data:       arbitrary data pointer that is passed through
+ */
+typedef int (*secp256k1_ecdh_xonly_hash_function)(
+  unsigned char *output,
+  const unsigned char *x32,
+  void *data
+);
+
+/** An implementation of SHA256 hash function that applies to the 32-byte x coordinate.
+ * Populates the output parameter with 32 bytes. */
+SECP256K1_API extern const secp256k1_ecdh_xonly_hash_function secp256k1_ecdh_xonly_hash_function_sha256;
+
+/** Compute an EC Diffie-Hellman secret from the x coordinate only, in constant time
+ *
+ *  This is faster than secp256k1_ecdh, as the y coordinate of the shared point is
+ *  never computed. Note that secp256k1_ecdh_hash_function_sha256 hashes the parity of
+ *  y as well, so the outputs of the two functions differ for the same keys.
+ *
+ *  Returns: 1: exponentiation was successful
+ *           0: scalar was invalid (zero or overflow) or hashfp returned 0
+ *  Args:    ctx:        pointer to a context object (cannot be NULL)
+ *  Out:     output:     pointer to an array to be filled by hashfp
+ *  In:      pubkey:     a pointer to a secp256k1_pubkey containing an
+ *                       initialized public key
+ *           seckey:     a 32-byte scalar with which to multiply the point
+ *           hashfp:     pointer to a hash function. If NULL, secp256k1_ecdh_xonly_hash_function_sha256
+ *                       is used (in which case, 32 bytes will be written to output)
+ *           data:       arbitrary data pointer that is passed through to hashfp
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_ecdh_xonly(
+  const secp256k1_context* ctx,
+  unsigned char *output,
+  const secp256k1_pubkey *pubkey,
+  const unsigned char *seckey,
+  secp256k1_ecdh_xonly_hash_function hashfp,
+  void *data
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3) SECP256K1_ARG_NONNULL(4);
+
+/** Compute an x-only EC Diffie-Hellman secret directly from a 32-byte x coordinate
+ *
+ *  Produces the same output as secp256k1_ecdh_xonly for a public key with the given
+ *  x coordinate (of either parity), but does not need a parsed public key: the
+ *  square root needed to recover y from x is avoided entirely, making this cheaper
+ *  than secp256k1_ec_pubkey_parse followed by secp256k1_ecdh_xonly.
+ *
+ *  Returns: 1: exponentiation was successful
+ *           0: x was not the x coordinate of a point on the curve, the scalar was
+ *              invalid (zero or overflow), or hashfp returned 0
+ *  Args:    ctx:        pointer to a context object (cannot be NULL)
+ *  Out:     output:     pointer to an array to be filled by hashfp
+ *  In:      xpoint32:   pointer to the 32-byte big endian x coordinate of the point
+ *           seckey:     a 32-byte scalar with which to multiply the point
+ *           hashfp:     pointer to a hash function. If NULL, secp256k1_ecdh_xonly_hash_function_sha256
+ *                       is used (in which case, 32 bytes will be written to output)
+ *           data:       arbitrary data pointer that is passed through to hashfp
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_ecdh_xonly_x32(
+  const secp256k1_context* ctx,
+  unsigned char *output,
+  const unsigned char *xpoint32,
+  const unsigned char *seckey,
+  secp256k1_ecdh_xonly_hash_function hashfp,
+  void *data
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3) SECP256K1_ARG_NONNULL(4);
+
 #ifdef __cplusplus
 }
 #endif
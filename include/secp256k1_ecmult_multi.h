@@ -0,0 +1,376 @@
+#ifndef SECP256K1_ECMULT_MULTI_H
+#define SECP256K1_ECMULT_MULTI_H
+
+#include "secp256k1.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** This module exposes the library's multi-scalar multiplication, computing
+ *  g*G + sum(s_i*P_i) for a scalar g, the generator G and an arbitrary number
+ *  of (scalar, point) pairs (s_i, P_i). Depending on the number of points and
+ *  the provided scratch space either Strauss' or Pippenger's algorithm is
+ *  used.
+ *
+ *  None of the functions in this module are constant time. They must not be
+ *  used with secret scalars.
+ */
+
+/** A pointer to a function that provides the (scalar, point) pairs of a
+ *  multi-scalar multiplication.
+ *
+ *  Returns: 1 if the pair was successfully provided. 0 will cause
+ *           secp256k1_ecmult_multi to return an error.
+ *  Out:     scalar32: pointer to a 32-byte array to be filled with the
+ *                     big-endian encoded scalar of the idx'th pair. The
+ *                     scalar must be smaller than the group order.
+ *           point:    pointer to a public key object to be filled with the
+ *                     point of the idx'th pair.
+ *  In:      idx:      index of the pair (from 0 to n-1). Pairs may be
+ *                     requested in any order and more than once.
+ *           data:     Arbitrary data pointer that is passed through.
+ */
+typedef int (*secp256k1_ecmult_multi_input_function)(
+    unsigned char *scalar32,
+    secp256k1_pubkey *point,
+    size_t idx,
+    void *data
+);
+
+/** Compute g*G + sum(s_i*P_i) over n (scalar, point) pairs.
+ *
+ *  Returns: 1 if the result was computed and is a valid public key.
+ *           0 if a scalar overflowed, the callback returned 0, or the result
+ *           is the point at infinity.
+ *  Args:    ctx:      pointer to a context object, initialized for
+ *                     verification (cannot be NULL)
+ *           scratch:  scratch space used for the multiplication, or NULL to
+ *                     use a much slower algorithm that needs no scratch space.
+ *                     If the scratch space is too small for all points at
+ *                     once, the points are processed in several batches.
+ *  Out:     result:   pointer to a public key object to store the result
+ *                     (cannot be NULL). If 0 is returned, it is set to an
+ *                     invalid value.
+ *  In:      g_scalar32: 32-byte big-endian scalar to multiply the generator
+ *                     with, or NULL for no generator term.
+ *           cb:       function providing the (scalar, point) pairs. May be
+ *                     NULL iff n is 0.
+ *           cbdata:   arbitrary data pointer passed to cb.
+ *           n:        number of (scalar, point) pairs.
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_ecmult_multi(
+    const secp256k1_context* ctx,
+    secp256k1_scratch_space *scratch,
+    secp256k1_pubkey *result,
+    const unsigned char *g_scalar32,
+    secp256k1_ecmult_multi_input_function cb,
+    void *cbdata,
+    size_t n
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(3);
+
+/** Determine a scratch space size that allows secp256k1_ecmult_multi to
+ *  process n_points points in a single batch with the fastest algorithm.
+ *
+ *  Returns: the size in bytes to pass to secp256k1_scratch_space_create, or 0
+ *           if n_points is 0. Sizes for very large n_points are capped at
+ *           the largest batch the library processes at once.
+ *  Args:    ctx:      an existing context object (cannot be NULL)
+ *  In:      n_points: number of (scalar, point) pairs, excluding the generator.
+ */
+SECP256K1_API size_t secp256k1_ecmult_multi_scratch_size(
+    const secp256k1_context* ctx,
+    size_t n_points
+) SECP256K1_ARG_NONNULL(1);
+
+/** The algorithms secp256k1_ecmult_multi chooses from. */
+#define SECP256K1_ECMULT_MULTI_STRAUSS 1
+#define SECP256K1_ECMULT_MULTI_PIPPENGER 2
+
+/** Determine the algorithm secp256k1_ecmult_multi uses to process n_points
+ *  points in a single batch, given a scratch space of
+ *  secp256k1_ecmult_multi_scratch_size(n_points) bytes.
+ *
+ *  Returns: SECP256K1_ECMULT_MULTI_STRAUSS or SECP256K1_ECMULT_MULTI_PIPPENGER
+ *  Args:    ctx:      an existing context object (cannot be NULL)
+ *  In:      n_points: number of (scalar, point) pairs, excluding the generator.
+ */
+SECP256K1_API int secp256k1_ecmult_multi_algorithm(
+    const secp256k1_context* ctx,
+    size_t n_points
+) SECP256K1_ARG_NONNULL(1);
+
+/** Determine the scratch space size a given algorithm needs to process n_points
+ *  points in a single batch.
+ *
+ *  For the algorithm returned by secp256k1_ecmult_multi_algorithm(n_points),
+ *  this equals secp256k1_ecmult_multi_scratch_size(n_points). Wherever
+ *  Pippenger's algorithm is selected it needs less memory than Strauss', so a
+ *  scratch space sized for Strauss' algorithm does not make
+ *  secp256k1_ecmult_multi use Strauss' algorithm where Pippenger's is faster;
+ *  the other size is meant for judging the memory saved (or spent) by the
+ *  choice.
+ *
+ *  Returns: the size in bytes to pass to secp256k1_scratch_space_create, or 0
+ *           if n_points is 0 or algorithm is invalid. Sizes for very large
+ *           n_points are capped at the largest batch the library processes
+ *           at once.
+ *  Args:    ctx:       an existing context object (cannot be NULL)
+ *  In:      n_points:  number of (scalar, point) pairs, excluding the generator.
+ *           algorithm: SECP256K1_ECMULT_MULTI_STRAUSS or
+ *                      SECP256K1_ECMULT_MULTI_PIPPENGER
+ */
+SECP256K1_API size_t secp256k1_ecmult_multi_scratch_size_for(
+    const secp256k1_context* ctx,
+    size_t n_points,
+    int algorithm
+) SECP256K1_ARG_NONNULL(1);
+
+/** Determine how many points secp256k1_ecmult_multi processes in a single
+ *  batch with the given scratch space.
+ *
+ *  A scratch space of secp256k1_ecmult_multi_scratch_size(n_points) bytes
+ *  always processes n_points points in a single batch. For other sizes, small
+ *  inputs may still be split if the scratch space suffices for Pippenger's
+ *  but not for Strauss' algorithm, which is preferred for few points.
+ *
+ *  Returns: the maximum number of points per batch, or 0 if the scratch space
+ *           is too small to be used (in which case the slow algorithm without
+ *           scratch space is used).
+ *  Args:    ctx:      an existing context object (cannot be NULL)
+ *           scratch:  scratch space (cannot be NULL)
+ */
+SECP256K1_API size_t secp256k1_ecmult_multi_max_points(
+    const secp256k1_context* ctx,
+    secp256k1_scratch_space *scratch
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2);
+
+/** A pointer to a function that runs a task once for every index in
+ *  [0, n_tasks), for example on a caller-managed thread pool. The library
+ *  itself never creates threads.
+ *
+ *  The task calls are independent and may be made concurrently, from any
+ *  thread and in any order, but every index must be run exactly once and the
+ *  function must not return before all calls have finished.
+ *
+ *  Returns: 1 if all tasks were run. 0 will cause
+ *           secp256k1_ecmult_multi_parallel to return an error.
+ *  In:      task:      function to call as task(idx, task_data)
+ *           task_data: opaque pointer to pass to task
+ *           n_tasks:   number of tasks
+ *           data:      Arbitrary data pointer that is passed through.
+ */
+typedef int (*secp256k1_ecmult_multi_runner_function)(
+    void (*task)(size_t idx, void *task_data),
+    void *task_data,
+    size_t n_tasks,
+    void *data
+);
+
+/** Compute g*G + sum(s_i*P_i) over n (scalar, point) pairs, split into
+ *  independent tasks that are run through a caller-supplied runner.
+ *
+ *  The pairs are divided into up to n_tasks contiguous slices, each of which
+ *  gets an equal share of the scratch space. The partial results are added up
+ *  after the runner returned. With a single task (or a single pair) this is
+ *  equivalent to secp256k1_ecmult_multi and the runner is not called.
+ *
+ *  Returns: 1 if the result was computed and is a valid public key.
+ *           0 if a scalar overflowed, the callback or runner returned 0, or
+ *           the result is the point at infinity.
+ *  Args:    ctx:      pointer to a context object, initialized for
+ *                     verification (cannot be NULL)
+ *           scratch:  scratch space to divide between the tasks (cannot be
+ *                     NULL). See secp256k1_ecmult_multi_parallel_scratch_size.
+ *  Out:     result:   pointer to a public key object to store the result
+ *                     (cannot be NULL). If 0 is returned, it is set to an
+ *                     invalid value.
+ *  In:      g_scalar32: 32-byte big-endian scalar to multiply the generator
+ *                     with, or NULL for no generator term.
+ *           cb:       function providing the (scalar, point) pairs. May be
+ *                     NULL iff n is 0. Must be safe to call concurrently from
+ *                     the threads used by runner.
+ *           cbdata:   arbitrary data pointer passed to cb.
+ *           n:        number of (scalar, point) pairs.
+ *           n_tasks:  maximum number of tasks, typically the number of
+ *                     worker threads. Must be at least 1.
+ *           runner:   function running the tasks (cannot be NULL).
+ *           runner_data: arbitrary data pointer passed to runner.
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_ecmult_multi_parallel(
+    const secp256k1_context* ctx,
+    secp256k1_scratch_space *scratch,
+    secp256k1_pubkey *result,
+    const unsigned char *g_scalar32,
+    secp256k1_ecmult_multi_input_function cb,
+    void *cbdata,
+    size_t n,
+    size_t n_tasks,
+    secp256k1_ecmult_multi_runner_function runner,
+    void *runner_data
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3) SECP256K1_ARG_NONNULL(9);
+
+/** Determine a scratch space size that allows secp256k1_ecmult_multi_parallel
+ *  to process n_points points with n_tasks tasks, each of them in a single
+ *  batch with the fastest algorithm.
+ *
+ *  Returns: the size in bytes to pass to secp256k1_scratch_space_create, or 0
+ *           if n_points or n_tasks is 0.
+ *  Args:    ctx:      an existing context object (cannot be NULL)
+ *  In:      n_points: number of (scalar, point) pairs, excluding the generator.
+ *           n_tasks:  maximum number of tasks.
+ */
+SECP256K1_API size_t secp256k1_ecmult_multi_parallel_scratch_size(
+    const secp256k1_context* ctx,
+    size_t n_points,
+    size_t n_tasks
+) SECP256K1_ARG_NONNULL(1);
+
+/** Opaque data structure that holds the precomputed multiples of a fixed point.
+ *
+ *  Multiplying a point by a scalar first computes a small table of multiples of
+ *  the point. A precomputed point holds a much larger table (about 64 kB) that is
+ *  built once, which makes multiplications of the point about as fast as those of
+ *  the generator. This pays off for points that are multiplied by many scalars.
+ *
+ *  It is not modified after creation and can be shared between threads.
+ */
+typedef struct secp256k1_point_precomp_struct secp256k1_point_precomp;
+
+/** Create the precomputed multiples of a point.
+ *
+ *  Returns: a newly created precomputed point, or NULL if an argument was invalid.
+ *  Args:    ctx:   an existing context object (cannot be NULL)
+ *  In:      point: pointer to the public key to precompute (cannot be NULL)
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT secp256k1_point_precomp* secp256k1_point_precomp_create(
+    const secp256k1_context* ctx,
+    const secp256k1_pubkey *point
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2);
+
+/** Destroy a precomputed point.
+ *
+ *  The pointer may not be used afterwards.
+ *  Args:    ctx:     an existing context object (cannot be NULL)
+ *           precomp: precomputed point to destroy (NULL is ignored)
+ */
+SECP256K1_API void secp256k1_point_precomp_destroy(
+    const secp256k1_context* ctx,
+    secp256k1_point_precomp *precomp
+) SECP256K1_ARG_NONNULL(1);
+
+/** Compute g*G + s_1*P_1 + ... + s_n*P_n for precomputed points P_i.
+ *
+ *  Returns: 1 if the result was computed and is a valid public key.
+ *           0 if a scalar overflowed or the result is the point at infinity.
+ *  Args:    ctx:      pointer to a context object, initialized for
+ *                     verification (cannot be NULL)
+ *  Out:     result:   pointer to a public key object to store the result
+ *                     (cannot be NULL). If 0 is returned, it is set to an
+ *                     invalid value.
+ *  In:      g_scalar32: 32-byte big-endian scalar to multiply the generator
+ *                     with, or NULL for no generator term.
+ *           precomps: pointer to an array of n pointers to precomputed points
+ *                     (can be NULL if n is 0)
+ *           scalars32: pointer to an array of n pointers to 32-byte big-endian
+ *                     scalars (can be NULL if n is 0)
+ *           n:        number of precomputed points.
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_ecmult_multi_precomp(
+    const secp256k1_context* ctx,
+    secp256k1_pubkey *result,
+    const unsigned char *g_scalar32,
+    const secp256k1_point_precomp * const *precomps,
+    const unsigned char * const *scalars32,
+    size_t n
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2);
+
+/** Opaque data structure that accumulates a multi-scalar multiplication over
+ *  (scalar, point) pairs that arrive over time.
+ *
+ *  Unlike secp256k1_ecmult_multi, which needs all pairs at once, an accumulator
+ *  buffers the pairs added to it and multiplies them whenever its buffer of
+ *  chunk_points pairs fills up, keeping only the running sum. Its memory is
+ *  bounded by the chunk size, however many pairs are added, and with chunks of
+ *  a few thousand points the multiplications are almost as efficient as a
+ *  single one over all pairs.
+ */
+typedef struct secp256k1_ecmult_multi_acc_struct secp256k1_ecmult_multi_acc;
+
+/** Create an accumulator.
+ *
+ *  Returns: a newly created accumulator, or NULL if chunk_points is invalid or
+ *           memory could not be allocated.
+ *  Args:    ctx:          an existing context object (cannot be NULL)
+ *  In:      chunk_points: number of pairs buffered before they are multiplied.
+ *                         Must be at least 1. The accumulator takes about
+ *                         secp256k1_ecmult_multi_scratch_size(chunk_points)
+ *                         bytes plus 120 bytes per buffered pair.
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT secp256k1_ecmult_multi_acc* secp256k1_ecmult_multi_acc_create(
+    const secp256k1_context* ctx,
+    size_t chunk_points
+) SECP256K1_ARG_NONNULL(1);
+
+/** Destroy an accumulator.
+ *
+ *  The pointer may not be used afterwards.
+ *  Args:    ctx: an existing context object (cannot be NULL)
+ *           acc: accumulator to destroy (NULL is ignored)
+ */
+SECP256K1_API void secp256k1_ecmult_multi_acc_destroy(
+    const secp256k1_context* ctx,
+    secp256k1_ecmult_multi_acc *acc
+) SECP256K1_ARG_NONNULL(1);
+
+/** Add n (scalar, point) pairs to an accumulator.
+ *
+ *  The pairs are requested from cb once each, in order of their index, and may
+ *  be overwritten by the caller once this function returns.
+ *
+ *  Returns: 1 if all pairs were added.
+ *           0 if an argument was invalid, a scalar overflowed or the callback
+ *           returned 0. The accumulator is then marked as failed, and the next
+ *           secp256k1_ecmult_multi_acc_finalize returns 0.
+ *  Args:    ctx:    pointer to a context object, initialized for verification
+ *                   (cannot be NULL)
+ *           acc:    accumulator to add the pairs to (cannot be NULL)
+ *  In:      cb:     function providing the pairs, with indices from 0 to n-1.
+ *                   May be NULL iff n is 0.
+ *           cbdata: arbitrary data pointer passed to cb.
+ *           n:      number of pairs.
+ */
+SECP256K1_API int secp256k1_ecmult_multi_acc_add(
+    const secp256k1_context* ctx,
+    secp256k1_ecmult_multi_acc *acc,
+    secp256k1_ecmult_multi_input_function cb,
+    void *cbdata,
+    size_t n
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2);
+
+/** Compute g*G + sum(s_i*P_i) over all pairs added to an accumulator since it
+ *  was created or last finalized, and reset it to empty.
+ *
+ *  Returns: 1 if the result was computed and is a valid public key.
+ *           0 if adding a pair failed, g_scalar32 overflowed, or the result is
+ *           the point at infinity.
+ *  Args:    ctx:    pointer to a context object, initialized for verification
+ *                   (cannot be NULL)
+ *           acc:    accumulator (cannot be NULL)
+ *  Out:     result: pointer to a public key object to store the result (cannot
+ *                   be NULL). If 0 is returned, it is set to an invalid value.
+ *  In:      g_scalar32: 32-byte big-endian scalar to multiply the generator
+ *                   with, or NULL for no generator term.
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_ecmult_multi_acc_finalize(
+    const secp256k1_context* ctx,
+    secp256k1_ecmult_multi_acc *acc,
+    secp256k1_pubkey *result,
+    const unsigned char *g_scalar32
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SECP256K1_ECMULT_MULTI_H */
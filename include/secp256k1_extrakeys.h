@@ -34,6 +34,22 @@ typedef struct {
     unsigned char data[96];
 } secp256k1_keypair;
 
+/** Opaque data structure that holds a valid public key in Jacobian coordinates.
+ *  Unlike a secp256k1_pubkey, which is affine, it can be the result of a
+ *  point addition without a field inversion, so that a chain of operations
+ *  (such as several tweaks) pays for a single inversion when the result is
+ *  serialized or converted to a secp256k1_pubkey.
+ *
+ *  The exact representation of data inside is implementation defined and not
+ *  guaranteed to be portable between different platforms or versions. It is
+ *  however guaranteed to be 96 bytes in size, and can be safely copied/moved.
+ *  The same point has many representations, so use
+ *  secp256k1_pubkey_jacobian_equal rather than comparing the data.
+ */
+typedef struct {
+    unsigned char data[96];
+} secp256k1_pubkey_jacobian;
+
 /** Parse a 32-byte sequence into a xonly_pubkey object.
  *
  *  Returns: 1 if the public key was fully valid.
@@ -118,6 +134,34 @@ SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_xonly_pubkey_tweak_add(
     const unsigned char *tweak32
 ) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3) SECP256K1_ARG_NONNULL(4);
 
+/** Tweak a number of x-only public keys, each by adding the generator multiplied
+ *  with its tweak to it.
+ *
+ *  Equivalent to calling secp256k1_xonly_pubkey_tweak_add for every key, but
+ *  faster because the conversion of the results to affine coordinates shares a
+ *  single field inversion between several keys.
+ *
+ *  Returns: 1 if all keys were tweaked
+ *           0 if at least one argument or resulting public key was invalid. Those
+ *             output public keys are set to an invalid value, the others are stored.
+ *  Args:            ctx: pointer to a context object initialized for verification
+ *                        (cannot be NULL)
+ *  Out:  output_pubkeys: pointer to an array of n public keys to store the results
+ *                        (can be NULL if n is 0)
+ *  In:  internal_pubkeys: pointer to an array of n pointers to x-only pubkeys to apply
+ *                        the tweaks to (can be NULL if n is 0)
+ *              tweaks32: pointer to an array of n pointers to 32-byte tweaks (can be
+ *                        NULL if n is 0)
+ *                     n: the number of keys
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_xonly_pubkey_tweak_add_batch(
+    const secp256k1_context* ctx,
+    secp256k1_pubkey *output_pubkeys,
+    const secp256k1_xonly_pubkey * const *internal_pubkeys,
+    const unsigned char * const *tweaks32,
+    size_t n
+) SECP256K1_ARG_NONNULL(1);
+
 /** Checks that a tweaked pubkey is the result of calling
  *  secp256k1_xonly_pubkey_tweak_add with internal_pubkey and tweak32.
  *
@@ -151,6 +195,73 @@ SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_xonly_pubkey_tweak_add_
     const unsigned char *tweak32
 ) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(4) SECP256K1_ARG_NONNULL(5);
 
+/** Checks that a tweaked pubkey is the result of calling
+ *  secp256k1_xonly_pubkey_tweak_add with internal_pubkey and the tweak
+ *  tagged_hash(internal_pubkey32 || msg), where internal_pubkey32 is the
+ *  serialization of internal_pubkey and the tagged hash uses the tag of hasher.
+ *
+ *  This is the Taproot commitment check (with the tag "TapTweak" and msg the
+ *  merkle root or empty). Reusing one hasher across calls avoids hashing the tag
+ *  every time.
+ *
+ *  Returns: 0 if the arguments are invalid or the tweaked pubkey is not the
+ *           result of tweaking the internal_pubkey with the tagged hash. 1 otherwise.
+ *  Args:            ctx: pointer to a context object initialized for verification
+ *                       (cannot be NULL)
+ *  In: tweaked_pubkey32: pointer to a serialized xonly_pubkey (cannot be NULL)
+ *     tweaked_pk_parity: the parity of the tweaked pubkey, as in
+ *                        secp256k1_xonly_pubkey_tweak_add_check.
+ *       internal_pubkey: pointer to an x-only public key object to apply the
+ *                        tweak to (cannot be NULL)
+ *                hasher: pointer to a tagged hasher initialized with
+ *                        secp256k1_tagged_hasher_init (cannot be NULL)
+ *                   msg: pointer to the data hashed after internal_pubkey32
+ *                        (cannot be NULL unless msglen is 0)
+ *                msglen: length of the msg array
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_xonly_pubkey_tweak_add_check_tagged(
+    const secp256k1_context* ctx,
+    const unsigned char *tweaked_pubkey32,
+    int tweaked_pk_parity,
+    const secp256k1_xonly_pubkey *internal_pubkey,
+    const secp256k1_tagged_hasher *hasher,
+    const unsigned char *msg,
+    size_t msglen
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(4) SECP256K1_ARG_NONNULL(5);
+
+/** Checks a set of tweaked x-only public keys, as secp256k1_xonly_pubkey_tweak_add_check
+ *  would for each of them.
+ *
+ *  Combines the checks Q_i = P_i + t_i*G with a random linear combination whose
+ *  coefficients are derived deterministically from all inputs, and checks the
+ *  result with a single multi-scalar multiplication. This is considerably
+ *  faster than calling secp256k1_xonly_pubkey_tweak_add_check for every
+ *  check, but does not reveal which check failed if the batch fails.
+ *
+ *  Returns 1 if all checks succeeded, 0 otherwise. In particular, returns 1 if n_checks is 0.
+ *
+ *  Args:             ctx: pointer to a context object initialized for verification
+ *                        (cannot be NULL)
+ *                scratch: scratch space used for the multiexponentiation (cannot be NULL)
+ *  In:  tweaked_pubkey32: array of pointers to serialized tweaked x-only public keys
+ *                         (NULL if n_checks is 0)
+ *      tweaked_pk_parity: array of the parities of the tweaked pubkeys (NULL if n_checks is 0)
+ *        internal_pubkey: array of pointers to the x-only public keys the tweaks are
+ *                         applied to (NULL if n_checks is 0)
+ *                tweak32: array of pointers to 32-byte tweaks (NULL if n_checks is 0)
+ *               n_checks: number of checks in above arrays. Must be below the
+ *                         minimum of 2^31 and SIZE_MAX/2.
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_xonly_pubkey_tweak_add_check_batch(
+    const secp256k1_context* ctx,
+    secp256k1_scratch_space *scratch,
+    const unsigned char *const *tweaked_pubkey32,
+    const int *tweaked_pk_parity,
+    const secp256k1_xonly_pubkey *const *internal_pubkey,
+    const unsigned char *const *tweak32,
+    size_t n_checks
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2);
+
 /** Compute the keypair for a secret key.
  *
  *  Returns: 1: secret was valid, keypair is ready to use
@@ -229,6 +340,139 @@ SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_keypair_xonly_tweak_add
     const unsigned char *tweak32
 ) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3);
 
+/** Converts a secp256k1_pubkey into a secp256k1_pubkey_jacobian.
+ *
+ *  Returns: 1 if the public key was successfully converted
+ *           0 otherwise
+ *
+ *  Args:      ctx: pointer to a context object (cannot be NULL)
+ *  Out:    output: pointer to a Jacobian public key object (cannot be NULL)
+ *  In:     pubkey: pointer to a public key that is converted (cannot be NULL)
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_pubkey_jacobian_from_pubkey(
+    const secp256k1_context* ctx,
+    secp256k1_pubkey_jacobian *output,
+    const secp256k1_pubkey *pubkey
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3);
+
+/** Converts a secp256k1_xonly_pubkey (the point with the even Y coordinate)
+ *  into a secp256k1_pubkey_jacobian.
+ *
+ *  Returns: 1 if the public key was successfully converted
+ *           0 otherwise
+ *
+ *  Args:      ctx: pointer to a context object (cannot be NULL)
+ *  Out:    output: pointer to a Jacobian public key object (cannot be NULL)
+ *  In:     pubkey: pointer to an x-only public key that is converted (cannot be NULL)
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_pubkey_jacobian_from_xonly_pubkey(
+    const secp256k1_context* ctx,
+    secp256k1_pubkey_jacobian *output,
+    const secp256k1_xonly_pubkey *pubkey
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3);
+
+/** Tweak a Jacobian public key by adding tweak32 times the generator to it,
+ *  without converting the result to affine coordinates.
+ *
+ *  Returns: 0 if the arguments are invalid or the resulting public key would be
+ *           invalid (only when the tweak is the negation of the corresponding
+ *           secret key). 1 otherwise.
+ *
+ *  Args:    ctx: pointer to a context object initialized for verification
+ *                (cannot be NULL)
+ *  In/Out: pubkey: pointer to a Jacobian public key to apply the tweak to. Will
+ *                be set to an invalid value if this function returns 0 (cannot
+ *                be NULL).
+ *  In:  tweak32: pointer to a 32-byte tweak. If the tweak is invalid according to
+ *                secp256k1_ec_seckey_verify, this function returns 0. For
+ *                uniformly random 32-byte arrays the chance of being invalid
+ *                is negligible (around 1 in 2^128) (cannot be NULL).
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_pubkey_jacobian_tweak_add(
+    const secp256k1_context* ctx,
+    secp256k1_pubkey_jacobian *pubkey,
+    const unsigned char *tweak32
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3);
+
+/** Converts a secp256k1_pubkey_jacobian into a secp256k1_pubkey, which takes a
+ *  field inversion.
+ *
+ *  Returns: 1 if the public key was successfully converted
+ *           0 otherwise
+ *
+ *  Args:      ctx: pointer to a context object (cannot be NULL)
+ *  Out:    output: pointer to a public key object (cannot be NULL)
+ *  In:     pubkey: pointer to a Jacobian public key that is converted (cannot be NULL)
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_pubkey_jacobian_get(
+    const secp256k1_context* ctx,
+    secp256k1_pubkey *output,
+    const secp256k1_pubkey_jacobian *pubkey
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3);
+
+/** Serialize a Jacobian public key into a byte sequence, exactly like
+ *  secp256k1_ec_pubkey_serialize does for the corresponding secp256k1_pubkey.
+ *  Takes a single field inversion.
+ *
+ *  Returns: 1 always.
+ *  Args:   ctx:        a secp256k1 context object.
+ *  Out:    output:     a pointer to a 65-byte (if compressed==0) or 33-byte (if
+ *                      compressed==1) byte array to place the serialized key
+ *                      in.
+ *  In/Out: outputlen:  a pointer to an integer which is initially set to the
+ *                      size of output, and is overwritten with the written
+ *                      size.
+ *  In:     pubkey:     a pointer to a secp256k1_pubkey_jacobian containing an
+ *                      initialized public key.
+ *          flags:      SECP256K1_EC_COMPRESSED if serialization should be in
+ *                      compressed format, otherwise SECP256K1_EC_UNCOMPRESSED.
+ */
+SECP256K1_API int secp256k1_pubkey_jacobian_serialize(
+    const secp256k1_context* ctx,
+    unsigned char *output,
+    size_t *outputlen,
+    const secp256k1_pubkey_jacobian* pubkey,
+    unsigned int flags
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3) SECP256K1_ARG_NONNULL(4);
+
+/** Serialize the x-only public key of a Jacobian public key, as
+ *  secp256k1_xonly_pubkey_from_pubkey followed by secp256k1_xonly_pubkey_serialize
+ *  would for the corresponding secp256k1_pubkey. This is the output key of a
+ *  Taproot output when pubkey is the tweaked internal key. Takes a single field
+ *  inversion.
+ *
+ *  Returns: 1 if the public key was successfully serialized
+ *           0 otherwise
+ *
+ *  Args:        ctx: pointer to a context object (cannot be NULL)
+ *  Out:    output32: a pointer to a 32-byte array to place the serialized key in
+ *                    (cannot be NULL).
+ *         pk_parity: pointer to an integer that will be set to 1 if the point
+ *                    encoded by output32 is the negation of pubkey and set to 0
+ *                    otherwise. (can be NULL)
+ *  In:       pubkey: pointer to a Jacobian public key (cannot be NULL)
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_pubkey_jacobian_serialize_xonly(
+    const secp256k1_context* ctx,
+    unsigned char *output32,
+    int *pk_parity,
+    const secp256k1_pubkey_jacobian *pubkey
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(4);
+
+/** Compare two Jacobian public keys for equality, without field inversions.
+ *
+ *  Returns: 1 if both hold the same point
+ *           0 if they do not or the arguments are invalid
+ *  Args:    ctx: pointer to a context object (cannot be NULL)
+ *  In:  pubkey1: pointer to the first Jacobian public key (cannot be NULL)
+ *       pubkey2: pointer to the second Jacobian public key (cannot be NULL)
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_pubkey_jacobian_equal(
+    const secp256k1_context* ctx,
+    const secp256k1_pubkey_jacobian *pubkey1,
+    const secp256k1_pubkey_jacobian *pubkey2
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,342 @@
+#ifndef SECP256K1_MUSIG_H
+#define SECP256K1_MUSIG_H
+
+#include "secp256k1_extrakeys.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+/** This module implements the MuSig2 multi-signature scheme (BIP-327 without
+ *  tweaking). The signers aggregate their public keys into a single x-only
+ *  public key, and a MuSig2 signature for it is a BIP-340 Schnorr signature
+ *  that secp256k1_schnorrsig_verify accepts.
+ *
+ *  A signing session proceeds as follows:
+ *   1. All signers aggregate the public keys with secp256k1_musig_pubkey_agg.
+ *   2. Every signer generates a nonce with secp256k1_musig_nonce_gen and
+ *      sends the public nonce to the others (or to an aggregator).
+ *   3. The public nonces are aggregated with secp256k1_musig_nonce_agg, and
+ *      every signer processes the aggregate nonce with
+ *      secp256k1_musig_nonce_process.
+ *   4. Every signer creates a partial signature with
+ *      secp256k1_musig_partial_sign, which can be checked with
+ *      secp256k1_musig_partial_sig_verify.
+ *   5. secp256k1_musig_partial_sig_agg combines the partial signatures.
+ *
+ *  A secret nonce must never be used for more than one signature. Using it
+ *  twice reveals the secret key.
+ *
+ *  The data structures below are opaque. Their representation is
+ *  implementation defined and not guaranteed to be portable between
+ *  different platforms or versions, but their sizes are fixed and they can be
+ *  safely copied/moved.
+ */
+
+/** Cached data of a key aggregation: the aggregate public key and the
+ *  hash of the list of public keys that the key aggregation coefficients are
+ *  derived from. Guaranteed to be 133 bytes in size. */
+typedef struct {
+    unsigned char data[133];
+} secp256k1_musig_keyagg_cache;
+
+/** A secret nonce. Guaranteed to be 132 bytes in size. It is invalidated by
+ *  secp256k1_musig_partial_sign and must not be copied, to avoid reusing it. */
+typedef struct {
+    unsigned char data[132];
+} secp256k1_musig_secnonce;
+
+/** A public nonce. Guaranteed to be 132 bytes in size. */
+typedef struct {
+    unsigned char data[132];
+} secp256k1_musig_pubnonce;
+
+/** An aggregate public nonce. Guaranteed to be 132 bytes in size. */
+typedef struct {
+    unsigned char data[132];
+} secp256k1_musig_aggnonce;
+
+/** The state of a signing session after processing the aggregate nonce.
+ *  Guaranteed to be 101 bytes in size. */
+typedef struct {
+    unsigned char data[101];
+} secp256k1_musig_session;
+
+/** A partial signature. Guaranteed to be 36 bytes in size. */
+typedef struct {
+    unsigned char data[36];
+} secp256k1_musig_partial_sig;
+
+/** Parse a 66-byte public nonce.
+ *
+ *  Returns: 1 if the public nonce was fully valid, 0 otherwise.
+ *  Args:    ctx: a secp256k1 context object (cannot be NULL)
+ *  Out:   nonce: pointer to a public nonce object (cannot be NULL)
+ *  In:     in66: pointer to the 66-byte nonce to be parsed (cannot be NULL)
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_musig_pubnonce_parse(
+    const secp256k1_context* ctx,
+    secp256k1_musig_pubnonce* nonce,
+    const unsigned char *in66
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3);
+
+/** Serialize a public nonce into 66 bytes.
+ *
+ *  Returns: 1 if the nonce was valid, 0 otherwise.
+ *  Args:    ctx: a secp256k1 context object (cannot be NULL)
+ *  Out:   out66: pointer to a 66-byte array to store the serialized nonce
+ *                (cannot be NULL)
+ *  In:    nonce: pointer to the nonce (cannot be NULL)
+ */
+SECP256K1_API int secp256k1_musig_pubnonce_serialize(
+    const secp256k1_context* ctx,
+    unsigned char *out66,
+    const secp256k1_musig_pubnonce* nonce
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3);
+
+/** Parse a 66-byte aggregate nonce. Unlike in a public nonce, either of its
+ *  two points may be the point at infinity, which is encoded as 33 zero bytes.
+ *
+ *  Returns: 1 if the aggregate nonce was fully valid, 0 otherwise.
+ *  Args:    ctx: a secp256k1 context object (cannot be NULL)
+ *  Out:   nonce: pointer to an aggregate nonce object (cannot be NULL)
+ *  In:     in66: pointer to the 66-byte nonce to be parsed (cannot be NULL)
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_musig_aggnonce_parse(
+    const secp256k1_context* ctx,
+    secp256k1_musig_aggnonce* nonce,
+    const unsigned char *in66
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3);
+
+/** Serialize an aggregate nonce into 66 bytes.
+ *
+ *  Returns: 1 if the nonce was valid, 0 otherwise.
+ *  Args:    ctx: a secp256k1 context object (cannot be NULL)
+ *  Out:   out66: pointer to a 66-byte array to store the serialized nonce
+ *                (cannot be NULL)
+ *  In:    nonce: pointer to the nonce (cannot be NULL)
+ */
+SECP256K1_API int secp256k1_musig_aggnonce_serialize(
+    const secp256k1_context* ctx,
+    unsigned char *out66,
+    const secp256k1_musig_aggnonce* nonce
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3);
+
+/** Parse a 32-byte partial signature.
+ *
+ *  Returns: 1 if the partial signature was valid, 0 if it overflowed the
+ *           group order.
+ *  Args:    ctx: a secp256k1 context object (cannot be NULL)
+ *  Out:     sig: pointer to a partial signature object (cannot be NULL)
+ *  In:     in32: pointer to the 32-byte signature to be parsed (cannot be NULL)
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_musig_partial_sig_parse(
+    const secp256k1_context* ctx,
+    secp256k1_musig_partial_sig* sig,
+    const unsigned char *in32
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3);
+
+/** Serialize a partial signature into 32 bytes.
+ *
+ *  Returns: 1 if the partial signature was valid, 0 otherwise.
+ *  Args:    ctx: a secp256k1 context object (cannot be NULL)
+ *  Out:   out32: pointer to a 32-byte array to store the serialized signature
+ *                (cannot be NULL)
+ *  In:      sig: pointer to the partial signature (cannot be NULL)
+ */
+SECP256K1_API int secp256k1_musig_partial_sig_serialize(
+    const secp256k1_context* ctx,
+    unsigned char *out32,
+    const secp256k1_musig_partial_sig* sig
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3);
+
+/** Aggregate public keys into an x-only public key.
+ *
+ *  The aggregate key is the sum of the public keys, each multiplied by its
+ *  key aggregation coefficient, computed with a single multi-scalar
+ *  multiplication. The order of the public keys matters: a different order
+ *  results in a different aggregate key.
+ *
+ *  Returns: 1 if the public keys were successfully aggregated, 0 otherwise.
+ *  Args:        ctx: pointer to a context object initialized for
+ *                    verification (cannot be NULL)
+ *           scratch: scratch space used for the multi-scalar multiplication,
+ *                    or NULL. Without a scratch space the keys are processed in
+ *                    small batches on the stack, which is fast for few keys
+ *                    but considerably slower than a large enough scratch
+ *                    space for many.
+ *  Out:      agg_pk: the x-only aggregate public key (can be NULL)
+ *      keyagg_cache: the data needed for signing with the aggregate key
+ *                    (can be NULL). If 0 is returned, it is set to an invalid
+ *                    value.
+ *  In:      pubkeys: array of pointers to the public keys to aggregate
+ *                    (cannot be NULL)
+ *         n_pubkeys: number of public keys, at least 1
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_musig_pubkey_agg(
+    const secp256k1_context* ctx,
+    secp256k1_scratch_space *scratch,
+    secp256k1_xonly_pubkey *agg_pk,
+    secp256k1_musig_keyagg_cache *keyagg_cache,
+    const secp256k1_pubkey * const* pubkeys,
+    size_t n_pubkeys
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(5);
+
+/** Obtain the aggregate public key (with its Y coordinate) from a
+ *  keyagg_cache.
+ *
+ *  Returns: 1 if the keyagg_cache was valid, 0 otherwise.
+ *  Args:        ctx: pointer to a context object (cannot be NULL)
+ *  Out:      agg_pk: the aggregate public key (cannot be NULL)
+ *  In: keyagg_cache: the output of secp256k1_musig_pubkey_agg (cannot be NULL)
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_musig_pubkey_get(
+    const secp256k1_context* ctx,
+    secp256k1_pubkey *agg_pk,
+    const secp256k1_musig_keyagg_cache *keyagg_cache
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3);
+
+/** Generate a secret and a public nonce for one signing session.
+ *
+ *  The nonce is derived from the session_id32, which must be unique for
+ *  every call and should be 32 bytes of fresh randomness. The optional
+ *  arguments are mixed in as additional protection against a weak
+ *  session_id32; they are not a substitute for it.
+ *
+ *  Returns: 1 if the nonce was generated, 0 if an argument was invalid.
+ *  Args:          ctx: pointer to a context object initialized for signing
+ *                      (cannot be NULL)
+ *  Out:      secnonce: the secret nonce, for secp256k1_musig_partial_sign
+ *                      (cannot be NULL)
+ *            pubnonce: the public nonce, to be sent to the other signers
+ *                      (cannot be NULL)
+ *  In:   session_id32: 32 bytes that are unique for this call (cannot be NULL)
+ *              seckey: the 32-byte secret key that will sign (can be NULL)
+ *              pubkey: the public key that will sign (cannot be NULL)
+ *               msg32: the 32-byte message that will be signed (can be NULL)
+ *        keyagg_cache: the key aggregation of the session (can be NULL)
+ *       extra_input32: 32 bytes of additional input (can be NULL)
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_musig_nonce_gen(
+    const secp256k1_context* ctx,
+    secp256k1_musig_secnonce *secnonce,
+    secp256k1_musig_pubnonce *pubnonce,
+    const unsigned char *session_id32,
+    const unsigned char *seckey,
+    const secp256k1_pubkey *pubkey,
+    const unsigned char *msg32,
+    const secp256k1_musig_keyagg_cache *keyagg_cache,
+    const unsigned char *extra_input32
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3) SECP256K1_ARG_NONNULL(4) SECP256K1_ARG_NONNULL(6);
+
+/** Aggregate the public nonces of all signers.
+ *
+ *  Returns: 1 if the nonces were aggregated, 0 if a nonce was invalid.
+ *  Args:        ctx: pointer to a context object (cannot be NULL)
+ *  Out:    aggnonce: the aggregate nonce (cannot be NULL)
+ *  In:    pubnonces: array of pointers to the public nonces of the signers
+ *                    (cannot be NULL)
+ *       n_pubnonces: number of public nonces, at least 1
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_musig_nonce_agg(
+    const secp256k1_context* ctx,
+    secp256k1_musig_aggnonce *aggnonce,
+    const secp256k1_musig_pubnonce * const* pubnonces,
+    size_t n_pubnonces
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3);
+
+/** Compute the nonce and the challenge of the final signature.
+ *
+ *  Returns: 1 if the session was created, 0 if an argument was invalid.
+ *  Args:        ctx: pointer to a context object initialized for
+ *                    verification (cannot be NULL)
+ *  Out:     session: the signing session (cannot be NULL)
+ *  In:     aggnonce: the aggregate nonce (cannot be NULL)
+ *             msg32: the 32-byte message to sign (cannot be NULL)
+ *      keyagg_cache: the key aggregation of the session (cannot be NULL)
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_musig_nonce_process(
+    const secp256k1_context* ctx,
+    secp256k1_musig_session *session,
+    const secp256k1_musig_aggnonce *aggnonce,
+    const unsigned char *msg32,
+    const secp256k1_musig_keyagg_cache *keyagg_cache
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3) SECP256K1_ARG_NONNULL(4) SECP256K1_ARG_NONNULL(5);
+
+/** Produce a partial signature.
+ *
+ *  The secnonce is overwritten with an invalid value, so that a second call
+ *  with it fails (and calls the illegal callback) instead of leaking the
+ *  secret key.
+ *
+ *  Returns: 1 if the partial signature was created, 0 if the secnonce was
+ *           already used or does not belong to the keypair, or an argument
+ *           was invalid.
+ *  Args:        ctx: pointer to a context object (cannot be NULL)
+ *  Out: partial_sig: the partial signature (cannot be NULL)
+ *  In/Out: secnonce: the secret nonce generated for this session (cannot be
+ *                    NULL)
+ *  In:      keypair: the keypair of the signer (cannot be NULL)
+ *      keyagg_cache: the key aggregation of the session (cannot be NULL)
+ *           session: the signing session (cannot be NULL)
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_musig_partial_sign(
+    const secp256k1_context* ctx,
+    secp256k1_musig_partial_sig *partial_sig,
+    secp256k1_musig_secnonce *secnonce,
+    const secp256k1_keypair *keypair,
+    const secp256k1_musig_keyagg_cache *keyagg_cache,
+    const secp256k1_musig_session *session
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3) SECP256K1_ARG_NONNULL(4) SECP256K1_ARG_NONNULL(5) SECP256K1_ARG_NONNULL(6);
+
+/** Verify the partial signature of one signer.
+ *
+ *  Verifying the partial signatures is not needed to obtain a valid final
+ *  signature, but it identifies a signer that produced an invalid one.
+ *
+ *  Returns: 1 if the partial signature is valid, 0 otherwise.
+ *  Args:        ctx: pointer to a context object initialized for
+ *                    verification (cannot be NULL)
+ *  In:  partial_sig: the partial signature (cannot be NULL)
+ *          pubnonce: the public nonce of the signer (cannot be NULL)
+ *            pubkey: the public key of the signer (cannot be NULL)
+ *      keyagg_cache: the key aggregation of the session (cannot be NULL)
+ *           session: the signing session (cannot be NULL)
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_musig_partial_sig_verify(
+    const secp256k1_context* ctx,
+    const secp256k1_musig_partial_sig *partial_sig,
+    const secp256k1_musig_pubnonce *pubnonce,
+    const secp256k1_pubkey *pubkey,
+    const secp256k1_musig_keyagg_cache *keyagg_cache,
+    const secp256k1_musig_session *session
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3) SECP256K1_ARG_NONNULL(4) SECP256K1_ARG_NONNULL(5) SECP256K1_ARG_NONNULL(6);
+
+/** Aggregate partial signatures into a BIP-340 Schnorr signature.
+ *
+ *  Returns: 1 if the partial signatures were aggregated, 0 if an argument was
+ *           invalid. The result is only a valid signature if all partial
+ *           signatures were valid.
+ *  Args:         ctx: pointer to a context object (cannot be NULL)
+ *  Out:        sig64: pointer to a 64-byte array to store the signature
+ *                     (cannot be NULL)
+ *  In:       session: the signing session (cannot be NULL)
+ *       partial_sigs: array of pointers to the partial signatures (cannot be
+ *                     NULL)
+ *             n_sigs: number of partial signatures
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_musig_partial_sig_agg(
+    const secp256k1_context* ctx,
+    unsigned char *sig64,
+    const secp256k1_musig_session *session,
+    const secp256k1_musig_partial_sig * const* partial_sigs,
+    size_t n_sigs
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3) SECP256K1_ARG_NONNULL(4);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SECP256K1_MUSIG_H */
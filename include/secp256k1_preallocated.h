@@ -97,6 +97,146 @@ SECP256K1_API secp256k1_context* secp256k1_context_preallocated_clone(
     void* prealloc
 ) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_WARN_UNUSED_RESULT;
 
+/** Determine the memory size of a secp256k1 context object to be copied into
+ *  caller-provided memory by secp256k1_context_preallocated_clone_shared.
+ *
+ *  Returns: the required size of the caller-provided memory block.
+ *  In:      ctx: an existing context to copy (cannot be NULL)
+ */
+SECP256K1_API size_t secp256k1_context_preallocated_clone_shared_size(
+    const secp256k1_context* ctx
+) SECP256K1_ARG_NONNULL(1) SECP256K1_WARN_UNUSED_RESULT;
+
+/** Copy a secp256k1 context object into caller-provided memory, without copying
+ *  its precomputed tables.
+ *
+ *  See secp256k1_context_clone_shared. The caller must provide a pointer to a
+ *  rewritable contiguous block of memory of size at least
+ *  secp256k1_context_preallocated_clone_shared_size(ctx) bytes, suitably aligned
+ *  to hold an object of any type. ctx must not be destroyed while the copy exists.
+ *
+ *  Returns: a newly created context object.
+ *  Args:    ctx:      an existing context to copy (cannot be NULL)
+ *  In:      prealloc: a pointer to a rewritable contiguous block of memory of
+ *                     size at least secp256k1_context_preallocated_clone_shared_size(ctx)
+ *                     bytes, as detailed above (cannot be NULL)
+ */
+SECP256K1_API secp256k1_context* secp256k1_context_preallocated_clone_shared(
+    const secp256k1_context* ctx,
+    void* prealloc
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_WARN_UNUSED_RESULT;
+
+/** Determine the size of the serialized verification tables.
+ *
+ *  The size depends on the ECMULT_WINDOW_SIZE the library was built with.
+ *
+ *  Returns: the number of bytes written by secp256k1_context_verify_table_serialize.
+ */
+SECP256K1_API size_t secp256k1_context_verify_table_size(void) SECP256K1_WARN_UNUSED_RESULT;
+
+/** Serialize the precomputed verification tables of a context.
+ *
+ *  The output can be stored, e.g., in a file, and handed to
+ *  secp256k1_context_verify_table_load later in order to avoid recomputing the
+ *  tables. It consists of a header describing the build, a SHA256 checksum and
+ *  the tables in their in-memory representation. It is therefore only portable
+ *  between builds of this library with the same version, ECMULT_WINDOW_SIZE,
+ *  field implementation and endianness.
+ *
+ *  Returns: 1 if the tables were written, 0 otherwise.
+ *  Args:    ctx:       a secp256k1 context object, initialized for verification
+ *                      (cannot be NULL)
+ *  Out:     output:    a pointer to an array of at least outputlen bytes (cannot be NULL)
+ *  In:      outputlen: the size of output, which must be at least
+ *                      secp256k1_context_verify_table_size() bytes
+ */
+SECP256K1_API int secp256k1_context_verify_table_serialize(
+    const secp256k1_context* ctx,
+    unsigned char *output,
+    size_t outputlen
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2);
+
+/** Compute a part of the verification tables, without a context that holds them.
+ *
+ *  The computation is split into n_parts parts of about equal size, which can be
+ *  computed in any order, and concurrently by different threads on the same
+ *  output, so that building the tables does not have to block a single thread,
+ *  and the caller can report progress. Once all parts have been computed,
+ *  secp256k1_context_verify_table_finish completes output, after which it equals
+ *  the output of secp256k1_context_verify_table_serialize: it can be passed to
+ *  secp256k1_context_verify_table_load or stored.
+ *
+ *  Returns: 1 if the part was computed, 0 otherwise.
+ *  Args:    ctx:       any secp256k1 context object, used for its illegal callback
+ *                      (cannot be NULL)
+ *  Out:     output:    a pointer to an array of at least outputlen bytes, suitably
+ *                      aligned to hold an object of any type (cannot be NULL)
+ *  In:      outputlen: the size of output, which must be at least
+ *                      secp256k1_context_verify_table_size() bytes
+ *           part:      the index of the part to compute, smaller than n_parts
+ *           n_parts:   the number of parts
+ */
+SECP256K1_API int secp256k1_context_verify_table_build(
+    const secp256k1_context* ctx,
+    unsigned char *output,
+    size_t outputlen,
+    size_t part,
+    size_t n_parts
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2);
+
+/** Complete verification tables computed by secp256k1_context_verify_table_build.
+ *
+ *  Must be called once all parts have been computed. Writes the header and the
+ *  checksum, which requires reading all of output once.
+ *
+ *  Returns: 1 if output was completed, 0 otherwise.
+ *  Args:    ctx:       any secp256k1 context object, used for its illegal callback
+ *                      (cannot be NULL)
+ *  In/Out:  output:    the tables computed by secp256k1_context_verify_table_build
+ *                      (cannot be NULL)
+ *  In:      outputlen: the size of output, which must be at least
+ *                      secp256k1_context_verify_table_size() bytes
+ */
+SECP256K1_API int secp256k1_context_verify_table_finish(
+    const secp256k1_context* ctx,
+    unsigned char *output,
+    size_t outputlen
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2);
+
+/** Initialize a context for verification using serialized tables.
+ *
+ *  The tables are used in place, i.e., they are not copied into the context,
+ *  so input may point to a read-only mapping of a file written by
+ *  secp256k1_context_verify_table_serialize, which several processes can share.
+ *  The header and checksum are checked, which requires reading all of input once.
+ *
+ *  This also lets the caller choose where the tables live. Lookups into the
+ *  tables are random and, at large ECMULT_WINDOW_SIZE, cause many TLB misses,
+ *  which can be avoided by placing input on huge pages (e.g. with mmap and
+ *  MAP_HUGETLB or MADV_HUGEPAGE). On NUMA systems, a copy of the tables can be
+ *  placed on each node, with one context per node loaded from its local copy.
+ *
+ *  The block of memory pointed to by input must be suitably aligned to hold an
+ *  object of any type (as, e.g., returned by mmap or malloc) and must not be
+ *  modified or released until ctx and all contexts cloned from it have been
+ *  destroyed. Its contents must come from a trusted source: the checksum
+ *  protects against corruption, but maliciously crafted tables cannot be
+ *  detected without recomputing them.
+ *
+ *  Returns: 1 if the tables were accepted, 0 if input has the wrong size, was
+ *           not produced by a compatible build or is corrupted.
+ *  Args:    ctx:      a secp256k1 context object, not initialized for verification
+ *                     (cannot be NULL or secp256k1_context_no_precomp)
+ *  In:      input:    a pointer to the serialized tables (cannot be NULL)
+ *           inputlen: the size of input, which must equal
+ *                     secp256k1_context_verify_table_size()
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_context_verify_table_load(
+    secp256k1_context* ctx,
+    const unsigned char *input,
+    size_t inputlen
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2);
+
 /** Destroy a secp256k1 context object that has been created in
  *  caller-provided memory.
  *
@@ -103,6 +103,66 @@ SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_ecdsa_recover(
     const unsigned char *msg32
 ) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3) SECP256K1_ARG_NONNULL(4);
 
+/** Recover the ECDSA public keys of a number of signatures.
+ *
+ *  Equivalent to calling secp256k1_ecdsa_recover for every signature, but faster
+ *  because the inversions of the r values, and the conversion of the recovered
+ *  keys to affine coordinates, are each shared between several signatures.
+ *
+ *  Returns: 1: all public keys were successfully recovered.
+ *           0: at least one public key could not be recovered. Those public keys
+ *              are set to an invalid value, the others are recovered.
+ *  Args:    ctx:     pointer to a context object, initialized for verification (cannot be NULL)
+ *  Out:     pubkeys: pointer to an array of n public keys (can be NULL if n is 0)
+ *  In:      sigs:    pointer to an array of n pointers to signatures that support
+ *                    pubkey recovery (can be NULL if n is 0)
+ *           msg32s:  pointer to an array of n pointers to the 32-byte message hashes
+ *                    assumed to be signed (can be NULL if n is 0)
+ *           n:       the number of signatures
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_ecdsa_recover_batch(
+    const secp256k1_context* ctx,
+    secp256k1_pubkey *pubkeys,
+    const secp256k1_ecdsa_recoverable_signature *const *sigs,
+    const unsigned char *const *msg32s,
+    size_t n
+) SECP256K1_ARG_NONNULL(1);
+
+/** Verify a set of ECDSA signatures, using their recovery ids as hints.
+ *
+ *  The recovery id of each signature determines the full nonce point R, so
+ *  all signatures can be checked with a random linear combination evaluated
+ *  by a single multi-scalar multiplication. This is considerably faster than
+ *  calling secp256k1_ecdsa_verify for every signature, but does not reveal
+ *  which signature is invalid if the batch fails.
+ *
+ *  A signature with a wrong recovery id makes the batch fail even if it is
+ *  valid according to secp256k1_ecdsa_verify, so on failure callers that
+ *  cannot trust the hints should fall back to verifying individually. As with
+ *  secp256k1_ecdsa_verify, signatures with a high s value are rejected. Note
+ *  that normalizing a signature, i.e. negating s, also flips the lowest bit of
+ *  its recovery id.
+ *
+ *  Returns 1 if all signatures are valid, 0 otherwise. In particular, returns 1
+ *  if n_sigs is 0.
+ *
+ *  Args:    ctx: a secp256k1 context object, initialized for verification.
+ *       scratch: scratch space used for the multiexponentiation
+ *  In:      sig: array of pointers to recoverable signatures, or NULL if there are no signatures
+ *         msg32: array of pointers to 32-byte message hashes, or NULL if there are no signatures
+ *        pubkey: array of pointers to public keys, or NULL if there are no signatures
+ *        n_sigs: number of signatures in above arrays. Must be at most SIZE_MAX/2.
+ *                Must be 0 if above arrays are NULL.
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_ecdsa_verify_batch(
+    const secp256k1_context* ctx,
+    secp256k1_scratch_space *scratch,
+    const secp256k1_ecdsa_recoverable_signature *const *sig,
+    const unsigned char *const *msg32,
+    const secp256k1_pubkey *const *pubkey,
+    size_t n_sigs
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2);
+
 #ifdef __cplusplus
 }
 #endif
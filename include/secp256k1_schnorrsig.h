@@ -88,6 +88,114 @@ SECP256K1_API int secp256k1_schnorrsig_sign(
     void *ndata
 ) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3) SECP256K1_ARG_NONNULL(4);
 
+/** Create Schnorr signatures of a number of messages with one keypair.
+ *
+ *  Equivalent to calling secp256k1_schnorrsig_sign with the noncefp argument
+ *  NULL for every message, but faster: the keypair is loaded once, and the
+ *  nonce commitments R are brought to affine coordinates together, sharing a
+ *  (constant time) field inversion between several signatures.
+ *
+ *  Returns 1 if all signatures were created, 0 on failure (for an invalid
+ *  keypair). Failed signatures are set to zero.
+ *  Args:       ctx: pointer to a context object, initialized for signing (cannot be NULL)
+ *  Out:     sigs64: pointer to a 64*n-byte array to store the serialized signatures,
+ *                   that of message i at sigs64 + 64*i (can be NULL if n is 0)
+ *  In:      msgs32: pointer to an array of n pointers to the 32-byte messages being
+ *                   signed (can be NULL if n is 0)
+ *                n: the number of messages
+ *          keypair: pointer to an initialized keypair (cannot be NULL)
+ *       aux_rand32: NULL, or a pointer to an array of n pointers to 32-byte auxiliary
+ *                   randomness as per BIP-340, each of which can be NULL
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_schnorrsig_sign_batch(
+    const secp256k1_context* ctx,
+    unsigned char *sigs64,
+    const unsigned char * const *msgs32,
+    size_t n,
+    const secp256k1_keypair *keypair,
+    const unsigned char * const *aux_rand32
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(5);
+
+/** Opaque data structure that holds a keypair prepared for signing many
+ *  messages with secp256k1_schnorrsig_sign_session.
+ *
+ *  It holds the secret key; erase it (for example with memset) when it is no
+ *  longer needed. The exact representation of data inside is implementation
+ *  defined and not guaranteed to be portable between different platforms or
+ *  versions. It is however guaranteed to be 96 bytes in size, and can be safely
+ *  copied/moved.
+ */
+typedef struct {
+    unsigned char data[96];
+} secp256k1_schnorrsig_session;
+
+/** Prepare a keypair for signing many messages.
+ *
+ *  Hashes the part of the BIP-340 nonce that does not depend on the message
+ *  (the key, masked with aux_rand32 if given, and the public key) once, so
+ *  that every signature made with the session hashes only its message: two
+ *  SHA256 compressions fewer per signature than secp256k1_schnorrsig_sign with
+ *  auxiliary randomness, and one fewer without.
+ *
+ *  The same aux_rand32 is used for every signature of the session. That is
+ *  safe, as the nonce still depends on the message, but it is not fresh
+ *  randomness per signature; start a new session to change it.
+ *
+ *  Returns 1 on success, 0 if the keypair is invalid (in which case the
+ *  session is zeroed).
+ *  Args:        ctx: pointer to a context object (cannot be NULL)
+ *  Out:     session: pointer to the session to initialize (cannot be NULL)
+ *  In:      keypair: pointer to an initialized keypair (cannot be NULL)
+ *        aux_rand32: 32-byte auxiliary randomness as per BIP-340, or NULL
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_schnorrsig_session_init(
+    const secp256k1_context* ctx,
+    secp256k1_schnorrsig_session *session,
+    const secp256k1_keypair *keypair,
+    const unsigned char *aux_rand32
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3);
+
+/** Create a Schnorr signature with a session.
+ *
+ *  The signature is the one secp256k1_schnorrsig_sign creates with the keypair
+ *  of the session, noncefp NULL and ndata the session's aux_rand32.
+ *
+ *  Returns 1 on success, 0 on failure.
+ *  Args:    ctx: pointer to a context object, initialized for signing (cannot be NULL)
+ *  Out:   sig64: pointer to a 64-byte array to store the serialized signature (cannot be NULL)
+ *  In:    msg32: the 32-byte message being signed (cannot be NULL)
+ *       session: pointer to a session initialized with
+ *                secp256k1_schnorrsig_session_init (cannot be NULL)
+ */
+SECP256K1_API int secp256k1_schnorrsig_sign_session(
+    const secp256k1_context* ctx,
+    unsigned char *sig64,
+    const unsigned char *msg32,
+    const secp256k1_schnorrsig_session *session
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3) SECP256K1_ARG_NONNULL(4);
+
+/** Create a Schnorr signature with a nonce from a pool.
+ *
+ *  The signature is a valid BIP-340 signature, but its nonce is taken from the
+ *  pool instead of derived from the message and key as BIP-340 describes; see
+ *  secp256k1_nonce_pool for what that requires of the caller. Only the challenge
+ *  hash and a scalar multiply-add are left to do.
+ *
+ *  Returns 1 on success, 0 if the pool was empty or the keypair invalid.
+ *  Args:    ctx: pointer to a context object (cannot be NULL)
+ *  Out:   sig64: pointer to a 64-byte array to store the serialized signature (cannot be NULL)
+ *  In:    msg32: the 32-byte message being signed (cannot be NULL)
+ *       keypair: pointer to an initialized keypair (cannot be NULL)
+ *  In/Out: pool: the pool to take a nonce from (cannot be NULL)
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_schnorrsig_sign_pooled(
+    const secp256k1_context* ctx,
+    unsigned char *sig64,
+    const unsigned char *msg32,
+    const secp256k1_keypair *keypair,
+    secp256k1_nonce_pool *pool
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3) SECP256K1_ARG_NONNULL(4) SECP256K1_ARG_NONNULL(5);
+
 /** Verify a Schnorr signature.
  *
  *  Returns: 1: correct signature
@@ -104,6 +212,75 @@ SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_schnorrsig_verify(
     const secp256k1_xonly_pubkey *pubkey
 ) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3) SECP256K1_ARG_NONNULL(4);
 
+/** Verify a Schnorr signature, consulting a cache of previous verifications.
+ *
+ *  Returns: 1: correct signature
+ *           0: incorrect signature
+ *  Args:    ctx: a secp256k1 context object, initialized for verification.
+ *         cache: the cache to consult and to add a correct signature to (cannot be NULL)
+ *  In:    sig64: pointer to the 64-byte signature to verify (cannot be NULL)
+ *         msg32: the 32-byte message being verified (cannot be NULL)
+ *        pubkey: pointer to an x-only public key to verify with (cannot be NULL)
+ *
+ *  The result is the same as that of secp256k1_schnorrsig_verify. The cache
+ *  can be shared with secp256k1_ecdsa_verify_cached.
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_schnorrsig_verify_cached(
+    const secp256k1_context* ctx,
+    secp256k1_sigcache *cache,
+    const unsigned char *sig64,
+    const unsigned char *msg32,
+    const secp256k1_xonly_pubkey *pubkey
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3) SECP256K1_ARG_NONNULL(4) SECP256K1_ARG_NONNULL(5);
+
+/** Verify a Schnorr signature with a prepared public key.
+ *
+ *  The prepared key stands for the x-only public key with its X coordinate, as
+ *  returned by secp256k1_xonly_pubkey_from_pubkey, so the result is the same as
+ *  that of secp256k1_schnorrsig_verify with that key. An x-only key can be
+ *  prepared by parsing its serialization prefixed with 0x02 as a public key.
+ *
+ *  Returns: 1: correct signature
+ *           0: incorrect signature
+ *  Args:       ctx: a secp256k1 context object, initialized for verification.
+ *  In:       sig64: pointer to the 64-byte signature to verify (cannot be NULL)
+ *            msg32: the 32-byte message being verified (cannot be NULL)
+ *         prepared: pointer to a prepared public key to verify with (cannot be NULL)
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_schnorrsig_verify_prepared(
+    const secp256k1_context* ctx,
+    const unsigned char *sig64,
+    const unsigned char *msg32,
+    const secp256k1_pubkey_prepared *prepared
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3) SECP256K1_ARG_NONNULL(4);
+
+/** Verifies a set of Schnorr signatures.
+ *
+ *  Combines the signatures with a random linear combination whose
+ *  coefficients are derived deterministically from all inputs, and checks the
+ *  result with a single multi-scalar multiplication. This is considerably
+ *  faster than calling secp256k1_schnorrsig_verify for every signature, but
+ *  does not reveal which signature is invalid if the batch fails.
+ *
+ *  Returns 1 if all succeeded, 0 otherwise. In particular, returns 1 if n_sigs is 0.
+ *
+ *  Args:    ctx: a secp256k1 context object, initialized for verification.
+ *       scratch: scratch space used for the multiexponentiation
+ *  In:      sig: array of pointers to 64-byte signatures, or NULL if there are no signatures
+ *         msg32: array of pointers to 32-byte messages, or NULL if there are no signatures
+ *            pk: array of pointers to x-only public keys, or NULL if there are no signatures
+ *        n_sigs: number of signatures in above arrays. Must be below the
+ *                minimum of 2^31 and SIZE_MAX/2. Must be 0 if above arrays are NULL.
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_schnorrsig_verify_batch(
+    const secp256k1_context* ctx,
+    secp256k1_scratch_space *scratch,
+    const unsigned char *const *sig,
+    const unsigned char *const *msg32,
+    const secp256k1_xonly_pubkey *const *pk,
+    size_t n_sigs
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,96 @@
+#ifndef SECP256K1_SCHNORRSIG_HALFAGG_H
+#define SECP256K1_SCHNORRSIG_HALFAGG_H
+
+#include "secp256k1.h"
+#include "secp256k1_extrakeys.h"
+#include "secp256k1_schnorrsig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** This module implements half-aggregation of BIP-340 Schnorr signatures, as
+ *  in the draft "Half-Aggregation of BIP 340 Signatures" by Jonas Nick, Tim
+ *  Ruffing and Fabian Jahr.
+ *
+ *  Half-aggregation combines n signatures, possibly by different signers on
+ *  different messages, into one aggregate signature of 32 + 32*n bytes instead
+ *  of 64*n bytes: it keeps the R parts of the signatures and replaces their s
+ *  parts by a single randomized sum. Anyone can aggregate, without the secret
+ *  keys. Verifying the aggregate takes one multi-scalar multiplication of 2*n
+ *  points, like secp256k1_schnorrsig_verify_batch.
+ *
+ *  The aggregate is bound to the order of the signatures: it verifies with the
+ *  messages and public keys in the order the signatures were aggregated in. An
+ *  aggregate cannot be split up into the original signatures again. */
+
+/** The largest number of signatures an aggregate signature can hold. */
+#define SECP256K1_SCHNORRSIG_HALFAGG_MAX_SIGS 65536
+
+/** Half-aggregate Schnorr signatures.
+ *
+ *  The signatures are not verified: the aggregate of valid and invalid
+ *  signatures is an invalid aggregate signature.
+ *
+ *  Returns 1 on success, 0 if a signature has an s part of at least the group
+ *  order or if a public key is invalid. In particular, returns 1 if n_sigs is 0.
+ *
+ *  Args:        ctx: a secp256k1 context object (cannot be NULL)
+ *  Out:      aggsig: pointer to an array of at least 32 + 32*n_sigs bytes to
+ *                    receive the aggregate signature (cannot be NULL)
+ *  In/Out: aggsig_len: pointer to the length of aggsig, set to the length of
+ *                    the aggregate signature, 32 + 32*n_sigs (cannot be NULL)
+ *  In:          sig: array of pointers to 64-byte signatures, or NULL if there
+ *                    are no signatures
+ *             msg32: array of pointers to the 32-byte messages that were
+ *                    signed, or NULL if there are no signatures
+ *                pk: array of pointers to the x-only public keys the
+ *                    signatures were made with, or NULL if there are no
+ *                    signatures
+ *            n_sigs: number of signatures in above arrays. Must be at most
+ *                    SECP256K1_SCHNORRSIG_HALFAGG_MAX_SIGS, and 0 if the
+ *                    arrays are NULL.
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_schnorrsig_halfagg_aggregate(
+    const secp256k1_context* ctx,
+    unsigned char *aggsig,
+    size_t *aggsig_len,
+    const unsigned char *const *sig,
+    const unsigned char *const *msg32,
+    const secp256k1_xonly_pubkey *const *pk,
+    size_t n_sigs
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3);
+
+/** Verify a half-aggregated Schnorr signature.
+ *
+ *  Returns 1 if the aggregate signature is valid for the messages and public
+ *  keys (which implies that every aggregated signature was), 0 otherwise.
+ *
+ *  Args:        ctx: a secp256k1 context object, initialized for verification.
+ *           scratch: scratch space used for the multi-scalar multiplication
+ *                    (cannot be NULL)
+ *  In:       aggsig: pointer to the aggregate signature (cannot be NULL)
+ *        aggsig_len: length of aggsig; anything but 32 + 32*n_sigs is invalid
+ *             msg32: array of pointers to 32-byte messages, or NULL if there
+ *                    are no signatures
+ *                pk: array of pointers to x-only public keys, or NULL if there
+ *                    are no signatures
+ *            n_sigs: number of signatures in the aggregate and in above arrays.
+ *                    Must be at most SECP256K1_SCHNORRSIG_HALFAGG_MAX_SIGS, and
+ *                    0 if the arrays are NULL.
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_schnorrsig_halfagg_verify(
+    const secp256k1_context* ctx,
+    secp256k1_scratch_space *scratch,
+    const unsigned char *aggsig,
+    size_t aggsig_len,
+    const unsigned char *const *msg32,
+    const secp256k1_xonly_pubkey *const *pk,
+    size_t n_sigs
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SECP256K1_SCHNORRSIG_HALFAGG_H */
@@ -9,25 +9,41 @@
 
 #ifdef USE_BASIC_CONFIG
 
+#undef USE_ASM_AARCH64
 #undef USE_ASM_X86_64
+#undef USE_ASM_X86_64_ADX
 #undef USE_ECMULT_STATIC_PRECOMPUTATION
+#undef USE_ECMULT_STATIC_VERIFY_TABLE
+#undef USE_ECMULT_COMPACT_VERIFY_TABLE
 #undef USE_EXTERNAL_ASM
 #undef USE_EXTERNAL_DEFAULT_CALLBACKS
 #undef USE_FIELD_INV_BUILTIN
 #undef USE_FIELD_INV_NUM
+#undef USE_FIELD_INV_SAFEGCD
 #undef USE_NUM_GMP
 #undef USE_NUM_NONE
 #undef USE_SCALAR_INV_BUILTIN
 #undef USE_SCALAR_INV_NUM
+#undef USE_SCALAR_INV_SAFEGCD
+#undef USE_SHA256_ARM_SHA2
+#undef USE_SHA256_X86_SHANI
+#undef USE_FIELD_5X52_IFMA
+#undef USE_FIELD_10X26_NEON
+#undef USE_SCALAR_8X32_NEON
+#undef USE_ECMULT_GEN_X86_AVX2
 #undef USE_FORCE_WIDEMUL_INT64
 #undef USE_FORCE_WIDEMUL_INT128
 #undef ECMULT_WINDOW_SIZE
+#undef ECMULT_WINDOW_A
+#undef ECMULT_CONST_WINDOW
 
 #define USE_NUM_NONE 1
 #define USE_FIELD_INV_BUILTIN 1
 #define USE_SCALAR_INV_BUILTIN 1
 #define USE_WIDEMUL_64 1
 #define ECMULT_WINDOW_SIZE 15
+#define ECMULT_WINDOW_A 5
+#define ECMULT_CONST_WINDOW 5
 
 #endif /* USE_BASIC_CONFIG */
 
@@ -9,15 +9,188 @@
 
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include "sys/time.h"
 
+#if defined(__linux__)
+#  include <sched.h>
+#  include <unistd.h>
+#  include <sys/syscall.h>
+#  include <linux/perf_event.h>
+#endif
+
+/* run_benchmark is configured through the environment:
+ *  SECP256K1_BENCH_ITERS:  the number of operations per sample (see get_iters)
+ *  SECP256K1_BENCH_COUNT:  the number of samples, overriding the benchmark's own
+ *  SECP256K1_BENCH_CLOCK:  "gettimeofday", "monotonic" (CLOCK_MONOTONIC_RAW, the
+ *                          default where available), "tsc" (x86 time stamp counter,
+ *                          in reference cycles) or "perf" (core cycles spent in user
+ *                          space, from a Linux perf counter)
+ *  SECP256K1_BENCH_FORMAT: "text" (the default), "csv" or "json" (one object per line)
+ *  SECP256K1_BENCH_CPU:    the number of the CPU to pin the benchmark to (Linux only)
+ *  SECP256K1_BENCH_TAG:    a string included in csv and json output, for example
+ *                          to record the configuration that was benchmarked
+ */
+
 static int64_t gettime_i64(void) {
     struct timeval tv;
     gettimeofday(&tv, NULL);
     return (int64_t)tv.tv_usec + (int64_t)tv.tv_sec * 1000000LL;
 }
 
+enum {
+    BENCH_CLOCK_GETTIMEOFDAY,
+    BENCH_CLOCK_MONOTONIC,
+    BENCH_CLOCK_TSC,
+    BENCH_CLOCK_PERF
+};
+
+static const char *bench_clock_names[] = { "gettimeofday", "monotonic", "tsc", "perf" };
+
+enum {
+    BENCH_FORMAT_TEXT,
+    BENCH_FORMAT_CSV,
+    BENCH_FORMAT_JSON
+};
+
+static struct {
+    int initialized;
+    int clock;
+    int format;
+    int count;
+    const char *tag;
+    int header_printed;
+#if defined(__linux__)
+    int perf_fd;
+#endif
+} bench_config;
+
+#if defined(__linux__)
+static int bench_perf_open(void) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CPU_CYCLES;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    bench_config.perf_fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    return bench_config.perf_fd >= 0;
+}
+#endif
+
+static int bench_clock_available(int clock) {
+    switch (clock) {
+    case BENCH_CLOCK_GETTIMEOFDAY:
+        return 1;
+    case BENCH_CLOCK_MONOTONIC:
+#if defined(CLOCK_MONOTONIC_RAW)
+        return 1;
+#else
+        return 0;
+#endif
+    case BENCH_CLOCK_TSC:
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+        return 1;
+#else
+        return 0;
+#endif
+    case BENCH_CLOCK_PERF:
+#if defined(__linux__)
+        return bench_perf_open();
+#else
+        return 0;
+#endif
+    }
+    return 0;
+}
+
+static void bench_init(void) {
+    const char *env;
+    int i;
+
+    bench_config.initialized = 1;
+    bench_config.clock = bench_clock_available(BENCH_CLOCK_MONOTONIC) ? BENCH_CLOCK_MONOTONIC : BENCH_CLOCK_GETTIMEOFDAY;
+    env = getenv("SECP256K1_BENCH_CLOCK");
+    if (env != NULL) {
+        for (i = 0; i < (int)(sizeof(bench_clock_names) / sizeof(bench_clock_names[0])); i++) {
+            if (strcmp(env, bench_clock_names[i]) == 0) {
+                break;
+            }
+        }
+        if (i < (int)(sizeof(bench_clock_names) / sizeof(bench_clock_names[0])) && bench_clock_available(i)) {
+            bench_config.clock = i;
+        } else {
+            fprintf(stderr, "Clock %s is not available, using %s.\n", env, bench_clock_names[bench_config.clock]);
+        }
+    }
+
+    bench_config.format = BENCH_FORMAT_TEXT;
+    env = getenv("SECP256K1_BENCH_FORMAT");
+    if (env != NULL && strcmp(env, "csv") == 0) {
+        bench_config.format = BENCH_FORMAT_CSV;
+    } else if (env != NULL && strcmp(env, "json") == 0) {
+        bench_config.format = BENCH_FORMAT_JSON;
+    }
+
+    env = getenv("SECP256K1_BENCH_COUNT");
+    bench_config.count = env != NULL ? strtol(env, NULL, 0) : 0;
+    env = getenv("SECP256K1_BENCH_TAG");
+    bench_config.tag = env != NULL ? env : "";
+
+    env = getenv("SECP256K1_BENCH_CPU");
+    if (env != NULL) {
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(strtol(env, NULL, 0), &set);
+        if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+            fprintf(stderr, "Could not pin to CPU %s.\n", env);
+        }
+#else
+        fprintf(stderr, "CPU pinning is not supported on this platform.\n");
+#endif
+    }
+}
+
+/* Read the configured clock, in nanoseconds or cycles. */
+static int64_t bench_clock_read(void) {
+    switch (bench_config.clock) {
+#if defined(CLOCK_MONOTONIC_RAW)
+    case BENCH_CLOCK_MONOTONIC: {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+        return (int64_t)ts.tv_nsec + (int64_t)ts.tv_sec * 1000000000LL;
+    }
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    case BENCH_CLOCK_TSC: {
+        uint32_t lo, hi;
+        /* lfence keeps rdtsc from being executed before earlier instructions finish. */
+        __asm__ __volatile__("lfence\n\trdtsc" : "=a"(lo), "=d"(hi) : : "memory");
+        return (int64_t)(((uint64_t)hi << 32) | lo);
+    }
+#endif
+#if defined(__linux__)
+    case BENCH_CLOCK_PERF: {
+        int64_t cycles = 0;
+        if (read(bench_config.perf_fd, &cycles, sizeof(cycles)) != (ssize_t)sizeof(cycles)) {
+            return 0;
+        }
+        return cycles;
+    }
+#endif
+    default:
+        return gettime_i64() * 1000LL;
+    }
+}
+
+static int bench_clock_is_time(void) {
+    return bench_config.clock == BENCH_CLOCK_GETTIMEOFDAY || bench_config.clock == BENCH_CLOCK_MONOTONIC;
+}
+
 #define FP_EXP (6)
 #define FP_MULT (1000000LL)
 
@@ -73,37 +246,90 @@ void print_number(const int64_t x) {
     printf("%s", &buffer[ptr]);
 }
 
+static int bench_compare_i64(const void *a, const void *b) {
+    int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/* The p-th percentile of the n sorted samples, by the nearest-rank method. */
+static int64_t bench_percentile(const int64_t *sorted, int n, int p) {
+    int rank = (p * n + 99) / 100;
+    return sorted[rank < 1 ? 0 : rank - 1];
+}
+
 void run_benchmark(char *name, void (*benchmark)(void*, int), void (*setup)(void*), void (*teardown)(void*, int), void* data, int count, int iter) {
     int i;
-    int64_t min = INT64_MAX;
+    int64_t *samples;
     int64_t sum = 0;
-    int64_t max = 0;
+    /* Samples are in ns or cycles; text output shows times in us, as it always did. */
+    int64_t scale = FP_MULT;
+    const char *unit;
+
+    if (!bench_config.initialized) {
+        bench_init();
+    }
+    unit = bench_clock_is_time() ? "ns" : "cycles";
+    if (bench_config.count > 0) {
+        count = bench_config.count;
+    }
+    samples = (int64_t *)malloc(count * sizeof(*samples));
+    if (samples == NULL) {
+        fprintf(stderr, "Out of memory.\n");
+        exit(EXIT_FAILURE);
+    }
     for (i = 0; i < count; i++) {
-        int64_t begin, total;
+        int64_t begin;
         if (setup != NULL) {
             setup(data);
         }
-        begin = gettime_i64();
+        begin = bench_clock_read();
         benchmark(data, iter);
-        total = gettime_i64() - begin;
+        samples[i] = bench_clock_read() - begin;
         if (teardown != NULL) {
             teardown(data, iter);
         }
-        if (total < min) {
-            min = total;
+        sum += samples[i];
+    }
+    qsort(samples, count, sizeof(*samples), bench_compare_i64);
+
+    if (bench_config.format == BENCH_FORMAT_TEXT) {
+        if (bench_clock_is_time()) {
+            scale = FP_MULT / 1000;
+            unit = "us";
+        }
+        printf("%s: min ", name);
+        print_number(samples[0] * scale / iter);
+        printf("%s / avg ", unit);
+        print_number(((sum * scale) / count) / iter);
+        printf("%s / max ", unit);
+        print_number(samples[count - 1] * scale / iter);
+        printf("%s\n", unit);
+    } else {
+        static const int percentiles[] = { 50, 90, 99 };
+        static const char *percentile_names[] = { "median", "p90", "p99" };
+        int json = bench_config.format == BENCH_FORMAT_JSON;
+        if (!json && !bench_config.header_printed) {
+            printf("name,clock,unit,tag,samples,iters,min,median,p90,p99,max,avg\n");
+            bench_config.header_printed = 1;
+        }
+        if (json) {
+            printf("{\"name\": \"%s\", \"clock\": \"%s\", \"unit\": \"%s\", \"tag\": \"%s\", \"samples\": %d, \"iters\": %d, \"min\": ",
+                   name, bench_clock_names[bench_config.clock], unit, bench_config.tag, count, iter);
+        } else {
+            printf("%s,%s,%s,%s,%d,%d,", name, bench_clock_names[bench_config.clock], unit, bench_config.tag, count, iter);
         }
-        if (total > max) {
-            max = total;
+        print_number(samples[0] * scale / iter);
+        for (i = 0; i < 3; i++) {
+            printf(json ? ", \"%s\": " : ",", percentile_names[i]);
+            print_number(bench_percentile(samples, count, percentiles[i]) * scale / iter);
         }
-        sum += total;
-    }
-    printf("%s: min ", name);
-    print_number(min * FP_MULT / iter);
-    printf("us / avg ");
-    print_number(((sum * FP_MULT) / count) / iter);
-    printf("us / max ");
-    print_number(max * FP_MULT / iter);
-    printf("us\n");
+        printf(json ? ", \"max\": " : ",");
+        print_number(samples[count - 1] * scale / iter);
+        printf(json ? ", \"avg\": " : ",");
+        print_number(((sum * scale) / count) / iter);
+        printf(json ? "}\n" : "\n");
+    }
+    free(samples);
 }
 
 int have_flag(int argc, char** argv, char *flag) {
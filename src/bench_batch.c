@@ -0,0 +1,186 @@
+/**********************************************************************
+ * Distributed under the MIT software license, see the accompanying   *
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
+ **********************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "include/secp256k1.h"
+#include "include/secp256k1_extrakeys.h"
+#include "include/secp256k1_schnorrsig.h"
+
+#include "util.h"
+
+/* ecmult_multi compares the number of points of a batch with this variable instead of a
+ * constant, so that the benchmark can force either algorithm: 0 selects Pippenger's
+ * algorithm, SIZE_MAX Strauss', and ECMULT_PIPPENGER_DEFAULT_THRESHOLD the usual choice. */
+static size_t bench_pippenger_threshold;
+#define ECMULT_PIPPENGER_THRESHOLD bench_pippenger_threshold
+
+#include "hash_impl.h"
+#include "num_impl.h"
+#include "field_impl.h"
+#include "group_impl.h"
+#include "scalar_impl.h"
+#include "ecmult_impl.h"
+#include "bench.h"
+#include "secp256k1.c"
+
+/* Measures secp256k1_schnorrsig_verify_batch end to end, for batch sizes from 1 up to
+ * SECP256K1_BENCH_MAX_BATCH (100000 by default) signatures, with fixed-size and growable
+ * scratch spaces, and with either multiplication algorithm. For every combination it
+ * prints the time per signature and the speedup over verifying the signatures one by
+ * one with secp256k1_schnorrsig_verify. Every measurement covers at least
+ * SECP256K1_BENCH_ITERS signatures and is the best of three rounds.
+ *
+ * The arguments, if any, restrict the scratch spaces (64KiB, 1MiB, 16MiB, growable) and
+ * algorithms (auto, strauss, pippenger) to those given; e.g. "bench_batch growable auto". */
+
+static const size_t bench_batch_sizes[] = {
+    1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192, 16384, 32768, 65536, 100000
+};
+
+static const struct {
+    char *name;
+    /* 0 for a growable scratch space */
+    size_t size;
+} bench_scratch_sizes[] = {
+    { "64KiB", (size_t)64 << 10 },
+    { "1MiB", (size_t)1 << 20 },
+    { "16MiB", (size_t)16 << 20 },
+    { "growable", 0 }
+};
+
+/* The largest a growable scratch space may get */
+#define BENCH_BATCH_MAX_SCRATCH ((size_t)256 << 20)
+
+typedef struct {
+    secp256k1_context *ctx;
+    unsigned char (*sigs)[64];
+    unsigned char (*msgs)[32];
+    secp256k1_xonly_pubkey *pks;
+    const unsigned char **sig_ptrs;
+    const unsigned char **msg_ptrs;
+    const secp256k1_xonly_pubkey **pk_ptrs;
+} bench_batch_data;
+
+/* Returns the best time per signature, in microseconds, of verifying the first n
+ * signatures as a batch (or one by one, if scratch is NULL) at least iters times. */
+static double bench_batch_time(const bench_batch_data *data, secp256k1_scratch_space *scratch, size_t n, int iters) {
+    size_t reps = (size_t)iters / n + 1, rep, i;
+    double best = 0;
+    int round;
+
+    for (round = 0; round < 3; round++) {
+        int64_t begin = gettime_i64();
+        double t;
+        for (rep = 0; rep < reps; rep++) {
+            if (scratch == NULL) {
+                for (i = 0; i < n; i++) {
+                    CHECK(secp256k1_schnorrsig_verify(data->ctx, data->sigs[i], data->msgs[i], &data->pks[i]) == 1);
+                }
+            } else {
+                CHECK(secp256k1_schnorrsig_verify_batch(data->ctx, scratch, data->sig_ptrs, data->msg_ptrs, data->pk_ptrs, n) == 1);
+            }
+        }
+        t = (double)(gettime_i64() - begin) / (double)(reps * n);
+        if (round == 0 || t < best) {
+            best = t;
+        }
+    }
+    return best;
+}
+
+int main(int argc, char **argv) {
+    static const struct {
+        char *name;
+        size_t threshold;
+    } algorithms[] = {
+        { "auto", ECMULT_PIPPENGER_DEFAULT_THRESHOLD },
+        { "strauss", SIZE_MAX },
+        { "pippenger", 0 }
+    };
+    bench_batch_data data;
+    const char *env = getenv("SECP256K1_BENCH_MAX_BATCH");
+    size_t max_batch = env != NULL ? (size_t)strtol(env, NULL, 0) : 100000;
+    int iters = get_iters(10000);
+    double single;
+    size_t i, s, a;
+    /* Whether the arguments restrict the scratch spaces and the algorithms */
+    int any_scratch = 0, any_algorithm = 0;
+
+    if (max_batch < 1) {
+        max_batch = 1;
+    }
+    for (s = 0; s < sizeof(bench_scratch_sizes) / sizeof(bench_scratch_sizes[0]); s++) {
+        any_scratch |= argc > 1 && have_flag(argc, argv, bench_scratch_sizes[s].name);
+    }
+    for (a = 0; a < sizeof(algorithms) / sizeof(algorithms[0]); a++) {
+        any_algorithm |= argc > 1 && have_flag(argc, argv, algorithms[a].name);
+    }
+    data.ctx = secp256k1_context_create(SECP256K1_CONTEXT_SIGN | SECP256K1_CONTEXT_VERIFY);
+    data.sigs = malloc(max_batch * sizeof(*data.sigs));
+    data.msgs = malloc(max_batch * sizeof(*data.msgs));
+    data.pks = malloc(max_batch * sizeof(*data.pks));
+    data.sig_ptrs = malloc(max_batch * sizeof(*data.sig_ptrs));
+    data.msg_ptrs = malloc(max_batch * sizeof(*data.msg_ptrs));
+    data.pk_ptrs = malloc(max_batch * sizeof(*data.pk_ptrs));
+    CHECK(data.sigs != NULL && data.msgs != NULL && data.pks != NULL);
+    CHECK(data.sig_ptrs != NULL && data.msg_ptrs != NULL && data.pk_ptrs != NULL);
+
+    for (i = 0; i < max_batch; i++) {
+        unsigned char sk[32] = { 0 };
+        secp256k1_keypair keypair;
+        sk[0] = 1;
+        sk[28] = (unsigned char)(i >> 24);
+        sk[29] = (unsigned char)(i >> 16);
+        sk[30] = (unsigned char)(i >> 8);
+        sk[31] = (unsigned char)i;
+        memcpy(data.msgs[i], sk, 32);
+        data.msgs[i][0] = 2;
+        CHECK(secp256k1_keypair_create(data.ctx, &keypair, sk) == 1);
+        CHECK(secp256k1_keypair_xonly_pub(data.ctx, &data.pks[i], NULL, &keypair) == 1);
+        CHECK(secp256k1_schnorrsig_sign(data.ctx, data.sigs[i], data.msgs[i], &keypair, NULL, NULL) == 1);
+        data.sig_ptrs[i] = data.sigs[i];
+        data.msg_ptrs[i] = data.msgs[i];
+        data.pk_ptrs[i] = &data.pks[i];
+    }
+
+    single = bench_batch_time(&data, NULL, max_batch < 1000 ? max_batch : 1000, iters);
+    printf("schnorrsig_verify: %.2fus per signature\n", single);
+
+    for (s = 0; s < sizeof(bench_scratch_sizes) / sizeof(bench_scratch_sizes[0]); s++) {
+        if (any_scratch && !have_flag(argc, argv, bench_scratch_sizes[s].name)) {
+            continue;
+        }
+        for (a = 0; a < sizeof(algorithms) / sizeof(algorithms[0]); a++) {
+            if (any_algorithm && !have_flag(argc, argv, algorithms[a].name)) {
+                continue;
+            }
+            bench_pippenger_threshold = algorithms[a].threshold;
+            for (i = 0; i < sizeof(bench_batch_sizes) / sizeof(bench_batch_sizes[0]) && bench_batch_sizes[i] <= max_batch; i++) {
+                size_t n = bench_batch_sizes[i];
+                double t;
+                /* A new scratch space every time, so that a growable one only grows as
+                 * much as this batch size needs. */
+                secp256k1_scratch_space *scratch = bench_scratch_sizes[s].size != 0
+                    ? secp256k1_scratch_space_create(data.ctx, bench_scratch_sizes[s].size)
+                    : secp256k1_scratch_space_create_growable(data.ctx, BENCH_BATCH_MAX_SCRATCH);
+                CHECK(scratch != NULL);
+                t = bench_batch_time(&data, scratch, n, iters);
+                printf("schnorrsig_verify_batch: %i signatures, %s scratch space, %s: %.2fus per signature, speedup %.2fx\n",
+                       (int)n, bench_scratch_sizes[s].name, algorithms[a].name, t, single / t);
+                secp256k1_scratch_space_destroy(data.ctx, scratch);
+            }
+        }
+    }
+
+    secp256k1_context_destroy(data.ctx);
+    free(data.sigs);
+    free(data.msgs);
+    free(data.pks);
+    free(data.sig_ptrs);
+    free(data.msg_ptrs);
+    free(data.pk_ptrs);
+    return 0;
+}
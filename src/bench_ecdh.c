@@ -11,10 +11,16 @@
 #include "util.h"
 #include "bench.h"
 
+#define BENCH_ECDH_BATCH 64
+
 typedef struct {
     secp256k1_context *ctx;
     secp256k1_pubkey point;
     unsigned char scalar[32];
+    unsigned char x32[32];
+    const secp256k1_pubkey *points[BENCH_ECDH_BATCH];
+    unsigned char outputs[BENCH_ECDH_BATCH][32];
+    unsigned char *output_ptrs[BENCH_ECDH_BATCH];
 } bench_ecdh_data;
 
 static void bench_ecdh_setup(void* arg) {
@@ -32,6 +38,11 @@ static void bench_ecdh_setup(void* arg) {
         data->scalar[i] = i + 1;
     }
     CHECK(secp256k1_ec_pubkey_parse(data->ctx, &data->point, point, sizeof(point)) == 1);
+    memcpy(data->x32, point + 1, 32);
+    for (i = 0; i < BENCH_ECDH_BATCH; i++) {
+        data->points[i] = &data->point;
+        data->output_ptrs[i] = data->outputs[i];
+    }
 }
 
 static void bench_ecdh(void* arg, int iters) {
@@ -44,6 +55,35 @@ static void bench_ecdh(void* arg, int iters) {
     }
 }
 
+static void bench_ecdh_xonly(void* arg, int iters) {
+    int i;
+    unsigned char res[32];
+    bench_ecdh_data *data = (bench_ecdh_data*)arg;
+
+    for (i = 0; i < iters; i++) {
+        CHECK(secp256k1_ecdh_xonly(data->ctx, res, &data->point, data->scalar, NULL, NULL) == 1);
+    }
+}
+
+static void bench_ecdh_xonly_x32(void* arg, int iters) {
+    int i;
+    unsigned char res[32];
+    bench_ecdh_data *data = (bench_ecdh_data*)arg;
+
+    for (i = 0; i < iters; i++) {
+        CHECK(secp256k1_ecdh_xonly_x32(data->ctx, res, data->x32, data->scalar, NULL, NULL) == 1);
+    }
+}
+
+static void bench_ecdh_batch(void* arg, int iters) {
+    int i;
+    bench_ecdh_data *data = (bench_ecdh_data*)arg;
+
+    for (i = 0; i < iters; i += BENCH_ECDH_BATCH) {
+        CHECK(secp256k1_ecdh_batch(data->ctx, data->output_ptrs, data->points, BENCH_ECDH_BATCH, data->scalar, NULL, NULL) == 1);
+    }
+}
+
 int main(void) {
     bench_ecdh_data data;
 
@@ -53,6 +93,9 @@ int main(void) {
     data.ctx = secp256k1_context_create(SECP256K1_FLAGS_TYPE_CONTEXT);
 
     run_benchmark("ecdh", bench_ecdh, bench_ecdh_setup, NULL, &data, 10, iters);
+    run_benchmark("ecdh_batch", bench_ecdh_batch, bench_ecdh_setup, NULL, &data, 10, iters);
+    run_benchmark("ecdh_xonly", bench_ecdh_xonly, bench_ecdh_setup, NULL, &data, 10, iters);
+    run_benchmark("ecdh_xonly_x32", bench_ecdh_xonly_x32, bench_ecdh_setup, NULL, &data, 10, iters);
 
     secp256k1_context_destroy(data.ctx);
     return 0;
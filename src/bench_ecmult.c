@@ -69,6 +69,25 @@ static void bench_ecmult(void* arg, int iters) {
     }
 }
 
+/* secp256k1_ecmult_small behind the interface of secp256k1_ecmult_multi_var, to compare
+ * it with the algorithms that use the scratch space. */
+static int bench_ecmult_small(const secp256k1_callback* error_callback, const secp256k1_ecmult_context *ctx, secp256k1_scratch *scratch, secp256k1_gej *r, const secp256k1_scalar *inp_g_sc, secp256k1_ecmult_multi_callback cb, void *cbdata, size_t n) {
+    secp256k1_gej points[ECMULT_SMALL_MAX_POINTS];
+    secp256k1_scalar scalars[ECMULT_SMALL_MAX_POINTS];
+    secp256k1_ge ge;
+    size_t i;
+
+    (void)error_callback;
+    (void)scratch;
+    CHECK(n <= ECMULT_SMALL_MAX_POINTS);
+    for (i = 0; i < n; i++) {
+        CHECK(cb(&scalars[i], &ge, i, cbdata));
+        secp256k1_gej_set_ge(&points[i], &ge);
+    }
+    secp256k1_ecmult_small(ctx, r, points, scalars, n, inp_g_sc);
+    return 1;
+}
+
 static void bench_ecmult_setup(void* arg) {
     bench_data* data = (bench_data*)arg;
     data->offset1 = (data->count * 0x537b7f6f + 0x8f66a481) % POINTS;
@@ -87,7 +106,9 @@ static void bench_ecmult_teardown(void* arg, int iters) {
     }
 }
 
-static void generate_scalar(uint32_t num, secp256k1_scalar* scalar) {
+/* Generate the scalar with index num. Short scalars have only their low 128 bits set,
+ * like the structured scalars of range proofs or small tweaks. */
+static void generate_scalar(uint32_t num, secp256k1_scalar* scalar, int short_scalar) {
     secp256k1_sha256 sha256;
     unsigned char c[11] = {'e', 'c', 'm', 'u', 'l', 't', 0, 0, 0, 0};
     unsigned char buf[32];
@@ -99,6 +120,9 @@ static void generate_scalar(uint32_t num, secp256k1_scalar* scalar) {
     secp256k1_sha256_initialize(&sha256);
     secp256k1_sha256_write(&sha256, c, sizeof(c));
     secp256k1_sha256_finalize(&sha256, buf);
+    if (short_scalar) {
+        memset(buf, 0, 16);
+    }
     secp256k1_scalar_set_b32(scalar, buf, &overflow);
     CHECK(!overflow);
 }
@@ -132,11 +156,232 @@ static void run_test(bench_data* data, size_t count, int includes_g, int num_ite
     run_benchmark(str, bench_ecmult, bench_ecmult_setup, bench_ecmult_teardown, data, 10, count * iters);
 }
 
+/* The bucket_window used by bench_pippenger_window_single. */
+static int bench_tune_bucket_window;
+
+static int bench_pippenger_window_single(const secp256k1_callback* error_callback, const secp256k1_ecmult_context *actx, secp256k1_scratch *scratch, secp256k1_gej *r, const secp256k1_scalar *inp_g_sc, secp256k1_ecmult_multi_callback cb, void *cbdata, size_t n) {
+    (void)actx;
+    return secp256k1_ecmult_pippenger_batch_window(error_callback, scratch, r, inp_g_sc, cb, cbdata, n, 0, bench_tune_bucket_window);
+}
+
+/* Returns the fastest time (in microseconds) of a multiplication with count points
+ * (including G), out of a few rounds of repeated calls. */
+static double bench_tune_time(bench_data* data, secp256k1_ecmult_multi_func f, size_t count) {
+    int round, iters = 1 + 5000 / (int)count, iter;
+    double best = 0;
+
+    data->count = count;
+    data->includes_g = 1;
+    bench_ecmult_setup(data);
+    for (round = 0; round < 3; round++) {
+        int64_t begin = gettime_i64();
+        for (iter = 0; iter < iters; iter++) {
+            CHECK(f(&data->ctx->error_callback, &data->ctx->ecmult_ctx, data->scratch, &data->output[0], &data->scalars[data->offset1], bench_callback, data, count - 1));
+            data->offset1 = (data->offset1 + count) % POINTS;
+            data->offset2 = (data->offset2 + count - 1) % POINTS;
+        }
+        if (round == 0 || (double)(gettime_i64() - begin) / iters < best) {
+            best = (double)(gettime_i64() - begin) / iters;
+        }
+    }
+    return best;
+}
+
+/* secp256k1_ecmult_multi_simple_var behind the interface of secp256k1_ecmult_multi_var. */
+static int bench_ecmult_simple(const secp256k1_callback* error_callback, const secp256k1_ecmult_context *ctx, secp256k1_scratch *scratch, secp256k1_gej *r, const secp256k1_scalar *inp_g_sc, secp256k1_ecmult_multi_callback cb, void *cbdata, size_t n) {
+    (void)error_callback;
+    (void)scratch;
+    return secp256k1_ecmult_multi_simple_var(ctx, r, inp_g_sc, cb, cbdata, n);
+}
+
+#define COMPARE_ENGINES 5
+
+/* Runs every algorithm on the same inputs for increasing numbers of points, checks
+ * that they agree with secp256k1_ecmult_multi_simple_var and prints a table of their
+ * times. The inputs only depend on the count, so runs are reproducible and can be
+ * compared across versions to validate the crossover points. */
+static void bench_compare(bench_data* data) {
+    static const char *names[COMPARE_ENGINES] = { "simple", "small", "strauss", "pippenger", "combined" };
+    const secp256k1_ecmult_multi_func funcs[COMPARE_ENGINES] = {
+        bench_ecmult_simple,
+        bench_ecmult_small,
+        secp256k1_ecmult_strauss_batch_single,
+        secp256k1_ecmult_pippenger_batch_single,
+        secp256k1_ecmult_multi_var
+    };
+    size_t count;
+    int e, k;
+
+    printf("%8s", "points");
+    for (e = 0; e < COMPARE_ENGINES; e++) {
+        printf(" %12s", names[e]);
+    }
+    printf("  fastest (times in us)\n");
+    for (k = 0; ; k++) {
+        double t[COMPARE_ENGINES];
+        int best = -1;
+        count = k < 8 ? (size_t)k + 1 : (size_t)(8 + 4 * ((k - 8) % 2 + 1)) << ((k - 8) / 2);
+        if (count > 8192) {
+            break;
+        }
+        for (e = 0; e < COMPARE_ENGINES; e++) {
+            secp256k1_gej expected, tmp;
+            t[e] = 0;
+            if (funcs[e] == bench_ecmult_small && count - 1 > ECMULT_SMALL_MAX_POINTS) {
+                continue;
+            }
+            /* The simple algorithm is only timed where it is competitive. */
+            if (e == 0 && count > 256) {
+                continue;
+            }
+            data->count = count;
+            data->includes_g = 1;
+            bench_ecmult_setup(data);
+            CHECK(bench_ecmult_simple(&data->ctx->error_callback, &data->ctx->ecmult_ctx, NULL, &expected, &data->scalars[data->offset1], bench_callback, data, count - 1));
+            CHECK(funcs[e](&data->ctx->error_callback, &data->ctx->ecmult_ctx, data->scratch, &data->output[0], &data->scalars[data->offset1], bench_callback, data, count - 1));
+            secp256k1_gej_neg(&tmp, &expected);
+            secp256k1_gej_add_var(&tmp, &tmp, &data->output[0], NULL);
+            CHECK(secp256k1_gej_is_infinity(&tmp));
+
+            t[e] = bench_tune_time(data, funcs[e], count);
+            if (e != COMPARE_ENGINES - 1 && (best < 0 || t[e] < t[best])) {
+                best = e;
+            }
+        }
+        printf("%8i", (int)count);
+        for (e = 0; e < COMPARE_ENGINES; e++) {
+            if (t[e] == 0) {
+                printf(" %12s", "-");
+            } else {
+                printf(" %12.2f", t[e]);
+            }
+        }
+        printf("  %s\n", names[best]);
+    }
+}
+
+#define TUNE_COUNTS (7 + 8 * 12)
+#define TUNE_THRESHOLD_COUNTS 63
+
+/* Measures the crossover points of ecmult_multi on this CPU, and prints definitions of
+ * the macros of ecmult_impl.h that select them. */
+static void bench_tune(bench_data* data) {
+    /* For the counts of the benchmark, the time per bucket_window (0 if not measured) */
+    static double times[TUNE_COUNTS][PIPPENGER_MAX_BUCKET_WINDOW + 1];
+    static double cost[TUNE_COUNTS][PIPPENGER_MAX_BUCKET_WINDOW + 1];
+    size_t n_points[TUNE_COUNTS];
+    size_t limits[PIPPENGER_MAX_BUCKET_WINDOW - 1] = { 0 };
+    double t_pippenger[TUNE_THRESHOLD_COUNTS], t_strauss[TUNE_THRESHOLD_COUNTS], best_sum = 0;
+    size_t threshold = 0, count;
+    int i, k, w, best_w;
+
+    /* The threshold, in steps of 8 points, that minimizes the sum of the slowdowns
+     * relative to the faster algorithm (Pippenger's with the default window). */
+    for (k = 0; k < TUNE_THRESHOLD_COUNTS; k++) {
+        count = 16 + 8 * k;
+        bench_tune_bucket_window = secp256k1_pippenger_bucket_window(count - 1);
+        t_pippenger[k] = bench_tune_time(data, bench_pippenger_window_single, count);
+        t_strauss[k] = bench_tune_time(data, secp256k1_ecmult_strauss_batch_single, count);
+    }
+    for (i = 0; i <= TUNE_THRESHOLD_COUNTS; i++) {
+        double sum = 0;
+        for (k = 0; k < TUNE_THRESHOLD_COUNTS; k++) {
+            double t_best = t_pippenger[k] < t_strauss[k] ? t_pippenger[k] : t_strauss[k];
+            sum += (k < i ? t_strauss[k] : t_pippenger[k]) / t_best;
+        }
+        if (i == 0 || sum < best_sum) {
+            best_sum = sum;
+            threshold = 15 + 8 * i;
+        }
+    }
+    fprintf(stderr, "Pippenger beats Strauss from %i points on\n", (int)threshold);
+
+    /* Time the windows up to two away from the default one. */
+    for (k = 0; k < TUNE_COUNTS; k++) {
+        int def;
+        n_points[k] = k < 7 ? (size_t)k + 1 : ((size_t)(9 + (k - 7) % 8) << ((k - 7) / 8)) - 1;
+        def = secp256k1_pippenger_bucket_window(n_points[k]);
+        for (w = 1; w <= PIPPENGER_MAX_BUCKET_WINDOW; w++) {
+            times[k][w] = 0;
+            if (w >= def - 2 && w <= def + 2) {
+                bench_tune_bucket_window = w;
+                times[k][w] = bench_tune_time(data, bench_pippenger_window_single, n_points[k] + 1);
+            }
+        }
+    }
+
+    /* A single window per count is noisy, so choose the non-decreasing assignment of
+     * windows to counts that minimizes the sum of the slowdowns relative to the best
+     * window of every count. cost[k][w] is the smallest such sum for the first k+1
+     * counts where count k uses window w. */
+    for (k = 0; k < TUNE_COUNTS; k++) {
+        double best = 0, prev = -1;
+        for (w = 1; w <= PIPPENGER_MAX_BUCKET_WINDOW; w++) {
+            if (times[k][w] != 0 && (best == 0 || times[k][w] < best)) {
+                best = times[k][w];
+            }
+        }
+        for (w = 1; w <= PIPPENGER_MAX_BUCKET_WINDOW; w++) {
+            /* prev is the cost of the best assignment of the previous counts to windows <= w */
+            if (k > 0 && cost[k - 1][w] >= 0 && (prev < 0 || cost[k - 1][w] < prev)) {
+                prev = cost[k - 1][w];
+            }
+            cost[k][w] = -1;
+            if (times[k][w] != 0 && (k == 0 || prev >= 0)) {
+                cost[k][w] = (k == 0 ? 0 : prev) + times[k][w] / best;
+            }
+        }
+    }
+    best_w = 0;
+    for (w = 1; w <= PIPPENGER_MAX_BUCKET_WINDOW; w++) {
+        if (cost[TUNE_COUNTS - 1][w] >= 0 && (best_w == 0 || cost[TUNE_COUNTS - 1][w] < cost[TUNE_COUNTS - 1][best_w])) {
+            best_w = w;
+        }
+    }
+    /* Walk back through the assignment. A window is used up to the largest count
+     * assigned to it or a smaller window. */
+    for (k = TUNE_COUNTS - 1; k >= 0; k--) {
+        fprintf(stderr, "%i points: bucket_window %i (default %i)\n", (int)n_points[k], best_w, secp256k1_pippenger_bucket_window(n_points[k]));
+        for (w = best_w; w < PIPPENGER_MAX_BUCKET_WINDOW; w++) {
+            if (limits[w - 1] == 0) {
+                limits[w - 1] = n_points[k];
+            }
+        }
+        if (k > 0) {
+            int next_w = 0;
+            for (i = 1; i <= best_w; i++) {
+                if (cost[k - 1][i] >= 0 && (next_w == 0 || cost[k - 1][i] < cost[k - 1][next_w])) {
+                    next_w = i;
+                }
+            }
+            best_w = next_w;
+        }
+    }
+    /* Windows that were assigned to no count are only used beyond them. */
+    for (w = 1; w < PIPPENGER_MAX_BUCKET_WINDOW; w++) {
+        if (limits[w - 1] == 0) {
+            limits[w - 1] = w > 1 ? limits[w - 2] : 1;
+        }
+    }
+
+    printf("/* Generated by bench_ecmult tune */\n");
+    printf("#define ECMULT_PIPPENGER_THRESHOLD %i\n", (int)threshold);
+    printf("#define ECMULT_PIPPENGER_WINDOW_LIMITS");
+    for (w = 1; w < PIPPENGER_MAX_BUCKET_WINDOW; w++) {
+        printf("%s %i", w > 1 ? "," : "", (int)limits[w - 1]);
+    }
+    printf("\n");
+}
+
 int main(int argc, char **argv) {
     bench_data data;
     int i, p;
     secp256k1_gej* pubkeys_gej;
     size_t scratch_size;
+    int tune = 0;
+    int compare = 0;
+    int small = 0;
+    int short_scalars = 0;
 
     int iters = get_iters(10000);
 
@@ -145,21 +390,36 @@ int main(int argc, char **argv) {
     data.scratch = secp256k1_scratch_space_create(data.ctx, scratch_size);
     data.ecmult_multi = secp256k1_ecmult_multi_var;
 
-    if (argc > 1) {
+    if (argc > 1 && have_flag(argc, argv, "short")) {
+        printf("Using short scalars:\n");
+        short_scalars = 1;
+    }
+    if (argc > 1 && have_flag(argc, argv, "tune")) {
+        tune = 1;
+    } else if (argc > 1 && have_flag(argc, argv, "compare")) {
+        compare = 1;
+    } else if (argc > 1) {
         if(have_flag(argc, argv, "pippenger_wnaf")) {
             printf("Using pippenger_wnaf:\n");
             data.ecmult_multi = secp256k1_ecmult_pippenger_batch_single;
         } else if(have_flag(argc, argv, "strauss_wnaf")) {
             printf("Using strauss_wnaf:\n");
             data.ecmult_multi = secp256k1_ecmult_strauss_batch_single;
+        } else if(have_flag(argc, argv, "small")) {
+            printf("Using small:\n");
+            data.ecmult_multi = bench_ecmult_small;
+            small = 1;
         } else if(have_flag(argc, argv, "simple")) {
             printf("Using simple algorithm:\n");
             data.ecmult_multi = secp256k1_ecmult_multi_var;
             secp256k1_scratch_space_destroy(data.ctx, data.scratch);
             data.scratch = NULL;
-        } else {
+        } else if (!short_scalars) {
             fprintf(stderr, "%s: unrecognized argument '%s'.\n", argv[0], argv[1]);
-            fprintf(stderr, "Use 'pippenger_wnaf', 'strauss_wnaf', 'simple' or no argument to benchmark a combined algorithm.\n");
+            fprintf(stderr, "Use 'pippenger_wnaf', 'strauss_wnaf', 'small', 'simple' or no argument to benchmark a combined algorithm,\n");
+            fprintf(stderr, "'tune' to measure the crossover points of the combined algorithm on this CPU,\n");
+            fprintf(stderr, "or 'compare' to check all algorithms against each other and time them side by side.\n");
+            fprintf(stderr, "Add 'short' to use scalars of at most 128 bits.\n");
             return 1;
         }
     }
@@ -176,7 +436,7 @@ int main(int argc, char **argv) {
     secp256k1_gej_set_ge(&pubkeys_gej[0], &secp256k1_ge_const_g);
     secp256k1_scalar_set_int(&data.seckeys[0], 1);
     for (i = 0; i < POINTS; ++i) {
-        generate_scalar(i, &data.scalars[i]);
+        generate_scalar(i, &data.scalars[i], short_scalars);
         if (i) {
             secp256k1_gej_double_var(&pubkeys_gej[i], &pubkeys_gej[i - 1], NULL);
             secp256k1_scalar_add(&data.seckeys[i], &data.seckeys[i - 1], &data.seckeys[i - 1]);
@@ -185,7 +445,14 @@ int main(int argc, char **argv) {
     secp256k1_ge_set_all_gej_var(data.pubkeys, pubkeys_gej, POINTS);
     free(pubkeys_gej);
 
-    for (i = 1; i <= 8; ++i) {
+    if (tune) {
+        bench_tune(&data);
+        iters = 0;
+    } else if (compare) {
+        bench_compare(&data);
+        iters = 0;
+    }
+    for (i = 1; i <= 8 && !tune && !compare; ++i) {
         run_test(&data, i, 1, iters);
     }
 
@@ -193,8 +460,8 @@ int main(int argc, char **argv) {
     * and the higher it goes the longer the computation takes(more points)
     * So we don't run this benchmark with low iterations to prevent slow down */
      if (iters > 2) {
-        for (p = 0; p <= 11; ++p) {
-            for (i = 9; i <= 16; ++i) {
+        for (p = 0; p <= (small ? 0 : 11); ++p) {
+            for (i = 9; i <= (small ? ECMULT_SMALL_MAX_POINTS + 1 : 16); ++i) {
                 run_test(&data, i << p, 1, iters);
             }
         }
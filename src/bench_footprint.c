@@ -0,0 +1,82 @@
+/**********************************************************************
+ * Distributed under the MIT software license, see the accompanying   *
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
+ **********************************************************************/
+
+/* Signs and verifies the way firmware without a heap would: with a context in a
+ * static buffer, created by secp256k1_context_preallocated_create. It reports the
+ * size of that context and the time of a signature and of a verification, and is
+ * linked by "make footprint-report" to show the code size of a sign+verify build.
+ *
+ * Unlike the other benchmarks it does not use bench.h, whose run_benchmark
+ * allocates its samples with malloc, so that the report can check that nothing
+ * in the binary refers to malloc. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "include/secp256k1.h"
+#include "include/secp256k1_preallocated.h"
+#include "util.h"
+
+/* With --enable-minimal-footprint, a context is small enough for this buffer. */
+#define FOOTPRINT_BUFFER_SIZE 4096
+
+static union {
+    long double align;
+    unsigned char data[FOOTPRINT_BUFFER_SIZE];
+} buffer;
+
+static double footprint_seconds_per_iter(clock_t start, int iters) {
+    return (double)(clock() - start) / CLOCKS_PER_SEC / iters;
+}
+
+int main(void) {
+    const unsigned int flags = SECP256K1_CONTEXT_SIGN | SECP256K1_CONTEXT_VERIFY;
+    size_t const size = secp256k1_context_preallocated_size(flags);
+    secp256k1_context *ctx;
+    secp256k1_ecdsa_signature sig;
+    secp256k1_pubkey pubkey;
+    unsigned char msg[32];
+    unsigned char key[32];
+    const char *env = getenv("SECP256K1_BENCH_ITERS");
+    int iters = env != NULL ? atoi(env) : 1000;
+    clock_t start;
+    int i;
+
+    printf("context (sign+verify): %lu bytes\n", (unsigned long)size);
+    if (size > sizeof(buffer.data)) {
+        printf("The context does not fit in the %d byte buffer of this benchmark; configure with\n"
+               "--enable-minimal-footprint to keep the tables out of the context.\n", FOOTPRINT_BUFFER_SIZE);
+        return 0;
+    }
+    if (iters <= 0) {
+        iters = 1;
+    }
+    ctx = secp256k1_context_preallocated_create(buffer.data, flags);
+    CHECK(ctx != NULL);
+
+    for (i = 0; i < 32; i++) {
+        msg[i] = i + 1;
+        key[i] = i + 65;
+    }
+    CHECK(secp256k1_ec_pubkey_create(ctx, &pubkey, key));
+
+    start = clock();
+    for (i = 0; i < iters; i++) {
+        CHECK(secp256k1_ecdsa_sign(ctx, &sig, msg, key, NULL, NULL));
+        msg[i & 31] ^= 1;
+    }
+    printf("ecdsa_sign: %.1fus\n", footprint_seconds_per_iter(start, iters) * 1e6);
+
+    CHECK(secp256k1_ecdsa_sign(ctx, &sig, msg, key, NULL, NULL));
+    start = clock();
+    for (i = 0; i < iters; i++) {
+        CHECK(secp256k1_ecdsa_verify(ctx, &sig, msg, &pubkey));
+    }
+    printf("ecdsa_verify: %.1fus\n", footprint_seconds_per_iter(start, iters) * 1e6);
+
+    secp256k1_context_preallocated_destroy(ctx);
+    return 0;
+}
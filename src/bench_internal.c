@@ -21,15 +21,19 @@
 
 typedef struct {
     secp256k1_scalar scalar[2];
+    /* Half-sized scalars, as produced by secp256k1_scalar_split_lambda */
+    secp256k1_scalar half[1024];
     secp256k1_fe fe[4];
     secp256k1_ge ge[2];
     secp256k1_gej gej[2];
     unsigned char data[64];
     int wnaf[256];
+    secp256k1_context *ctx;
 } bench_inv;
 
 void bench_setup(void* arg) {
     bench_inv *data = (bench_inv*)arg;
+    int i;
 
     static const unsigned char init[4][32] = {
         /* Initializer for scalar[0], fe[0], first half of data, the X coordinate of ge[0],
@@ -78,6 +82,19 @@ void bench_setup(void* arg) {
     secp256k1_gej_rescale(&data->gej[1], &data->fe[3]);
     memcpy(data->data, init[0], 32);
     memcpy(data->data + 32, init[1], 32);
+    for (i = 0; i < 1024; i += 2) {
+        secp256k1_scalar k;
+        secp256k1_scalar_set_int(&k, i);
+        secp256k1_scalar_mul(&k, &k, &data->scalar[1]);
+        secp256k1_scalar_add(&k, &k, &data->scalar[0]);
+        secp256k1_scalar_split_lambda(&data->half[i], &data->half[i + 1], &k);
+        if (secp256k1_scalar_is_high(&data->half[i])) {
+            secp256k1_scalar_negate(&data->half[i], &data->half[i]);
+        }
+        if (secp256k1_scalar_is_high(&data->half[i + 1])) {
+            secp256k1_scalar_negate(&data->half[i + 1], &data->half[i + 1]);
+        }
+    }
 }
 
 void bench_scalar_add(void* arg, int iters) {
@@ -150,6 +167,22 @@ void bench_scalar_inverse_var(void* arg, int iters) {
     CHECK(j <= iters);
 }
 
+void bench_scalar_inverse_all_var(void* arg, int iters) {
+    int i, j;
+    bench_inv *data = (bench_inv*)arg;
+    secp256k1_scalar in[16], out[16];
+
+    for (j = 0; j < 16; j++) {
+        in[j] = data->scalar[0];
+        secp256k1_scalar_add(&data->scalar[0], &data->scalar[0], &data->scalar[1]);
+    }
+    /* Counted per inverse; iters is rounded up to a multiple of 16. */
+    for (i = 0; i < iters; i += 16) {
+        secp256k1_scalar_inverse_all_var(out, in, 16);
+        in[0] = out[15];
+    }
+}
+
 void bench_field_normalize(void* arg, int iters) {
     int i;
     bench_inv *data = (bench_inv*)arg;
@@ -186,6 +219,22 @@ void bench_field_sqr(void* arg, int iters) {
     }
 }
 
+#ifdef SECP256K1_FE_X8
+void bench_field_mul_x8(void* arg, int iters) {
+    int i;
+    bench_inv *data = (bench_inv*)arg;
+    secp256k1_fe_x8 a, b;
+
+    /* Eight copies of fe[0] and fe[1] */
+    secp256k1_fe_x8_load(&a, &data->fe[0], 0);
+    secp256k1_fe_x8_load(&b, &data->fe[1], 0);
+    for (i = 0; i < iters; i++) {
+        secp256k1_fe_x8_mul(&a, &a, &b);
+    }
+    secp256k1_fe_x8_store(&data->fe[0], 0, &a);
+}
+#endif
+
 void bench_field_inverse(void* arg, int iters) {
     int i;
     bench_inv *data = (bench_inv*)arg;
@@ -206,6 +255,160 @@ void bench_field_inverse_var(void* arg, int iters) {
     }
 }
 
+/* The "inversion" benchmarks time each inversion backend directly, whichever one
+ * --with-inversion selected for secp256k1_fe_inv and friends; run them with
+ * SECP256K1_BENCH_CLOCK=tsc or perf to get cycles. */
+
+void bench_field_inverse_addchain(void* arg, int iters) {
+    int i;
+    bench_inv *data = (bench_inv*)arg;
+
+    for (i = 0; i < iters; i++) {
+        secp256k1_fe_inv_addchain(&data->fe[0], &data->fe[0]);
+        secp256k1_fe_add(&data->fe[0], &data->fe[1]);
+    }
+}
+
+void bench_field_inverse_safegcd(void* arg, int iters) {
+    int i;
+    bench_inv *data = (bench_inv*)arg;
+
+    for (i = 0; i < iters; i++) {
+        secp256k1_fe_inv_safegcd(&data->fe[0], &data->fe[0]);
+        secp256k1_fe_add(&data->fe[0], &data->fe[1]);
+    }
+}
+
+void bench_field_inverse_safegcd_var(void* arg, int iters) {
+    int i;
+    bench_inv *data = (bench_inv*)arg;
+
+    for (i = 0; i < iters; i++) {
+        secp256k1_fe_inv_safegcd_var(&data->fe[0], &data->fe[0]);
+        secp256k1_fe_add(&data->fe[0], &data->fe[1]);
+    }
+}
+
+#ifndef USE_NUM_NONE
+void bench_field_inverse_num_var(void* arg, int iters) {
+    int i;
+    bench_inv *data = (bench_inv*)arg;
+
+    for (i = 0; i < iters; i++) {
+        secp256k1_fe_inv_num_var(&data->fe[0], &data->fe[0]);
+        secp256k1_fe_add(&data->fe[0], &data->fe[1]);
+    }
+}
+#endif
+
+void bench_scalar_inverse_addchain(void* arg, int iters) {
+    int i, j = 0;
+    bench_inv *data = (bench_inv*)arg;
+
+    for (i = 0; i < iters; i++) {
+        secp256k1_scalar_inverse_addchain(&data->scalar[0], &data->scalar[0]);
+        j += secp256k1_scalar_add(&data->scalar[0], &data->scalar[0], &data->scalar[1]);
+    }
+    CHECK(j <= iters);
+}
+
+void bench_scalar_inverse_safegcd(void* arg, int iters) {
+    int i, j = 0;
+    bench_inv *data = (bench_inv*)arg;
+
+    for (i = 0; i < iters; i++) {
+        secp256k1_scalar_inverse_safegcd(&data->scalar[0], &data->scalar[0]);
+        j += secp256k1_scalar_add(&data->scalar[0], &data->scalar[0], &data->scalar[1]);
+    }
+    CHECK(j <= iters);
+}
+
+void bench_scalar_inverse_safegcd_var(void* arg, int iters) {
+    int i, j = 0;
+    bench_inv *data = (bench_inv*)arg;
+
+    for (i = 0; i < iters; i++) {
+        secp256k1_scalar_inverse_safegcd_var(&data->scalar[0], &data->scalar[0]);
+        j += secp256k1_scalar_add(&data->scalar[0], &data->scalar[0], &data->scalar[1]);
+    }
+    CHECK(j <= iters);
+}
+
+#ifndef USE_NUM_NONE
+void bench_scalar_inverse_num_var(void* arg, int iters) {
+    int i, j = 0;
+    bench_inv *data = (bench_inv*)arg;
+
+    for (i = 0; i < iters; i++) {
+        secp256k1_scalar_inverse_num_var(&data->scalar[0], &data->scalar[0]);
+        j += secp256k1_scalar_add(&data->scalar[0], &data->scalar[0], &data->scalar[1]);
+    }
+    CHECK(j <= iters);
+}
+#endif
+
+/* Before timing them, check that all the backends agree on a run of inputs: the
+ * edge cases 0, 1 and -1 and then hashes of a counter. */
+static void bench_inversion_check(void) {
+    int i;
+    unsigned char b32[32] = {0};
+
+    for (i = 0; i < 256; i++) {
+        secp256k1_fe x, r, t;
+        secp256k1_scalar xs, rs, ts;
+        int is_zero;
+
+        if (i == 0) {
+            secp256k1_fe_clear(&x);
+        } else if (i <= 2) {
+            secp256k1_fe_set_int(&x, 1);
+            if (i == 2) {
+                secp256k1_fe_negate(&x, &x, 1);
+            }
+        } else {
+            secp256k1_sha256 sha;
+            b32[0] = i;
+            b32[1] = i >> 8;
+            secp256k1_sha256_initialize(&sha);
+            secp256k1_sha256_write(&sha, b32, 32);
+            secp256k1_sha256_finalize(&sha, b32);
+            secp256k1_fe_set_b32(&x, b32);
+        }
+        secp256k1_fe_normalize(&x);
+        secp256k1_fe_get_b32(b32, &x);
+        secp256k1_scalar_set_b32(&xs, b32, NULL);
+        is_zero = secp256k1_fe_is_zero(&x);
+
+        secp256k1_fe_inv_addchain(&r, &x);
+        secp256k1_fe_mul(&t, &r, &x);
+        CHECK(is_zero ? secp256k1_fe_normalizes_to_zero(&t) : secp256k1_fe_equal(&t, &secp256k1_fe_one));
+        secp256k1_fe_inv_safegcd(&t, &x);
+        CHECK(secp256k1_fe_equal_var(&t, &r));
+        secp256k1_fe_inv_safegcd_var(&t, &x);
+        CHECK(secp256k1_fe_equal_var(&t, &r));
+
+        secp256k1_scalar_inverse_addchain(&rs, &xs);
+        secp256k1_scalar_mul(&ts, &rs, &xs);
+        CHECK(secp256k1_scalar_is_zero(&xs) ? secp256k1_scalar_is_zero(&ts) : secp256k1_scalar_is_one(&ts));
+        secp256k1_scalar_inverse_safegcd(&ts, &xs);
+        CHECK(secp256k1_scalar_eq(&ts, &rs));
+        secp256k1_scalar_inverse_safegcd_var(&ts, &xs);
+        CHECK(secp256k1_scalar_eq(&ts, &rs));
+
+#ifndef USE_NUM_NONE
+        /* The bignum library cannot invert 0. */
+        if (!is_zero) {
+            secp256k1_fe_inv_num_var(&t, &x);
+            CHECK(secp256k1_fe_equal_var(&t, &r));
+        }
+        if (!secp256k1_scalar_is_zero(&xs)) {
+            secp256k1_scalar_inverse_num_var(&ts, &xs);
+            CHECK(secp256k1_scalar_eq(&ts, &rs));
+        }
+#endif
+    }
+}
+
 void bench_field_sqrt(void* arg, int iters) {
     int i, j = 0;
     bench_inv *data = (bench_inv*)arg;
@@ -219,6 +422,42 @@ void bench_field_sqrt(void* arg, int iters) {
     CHECK(j <= iters);
 }
 
+void bench_group_set_xo_batch(void* arg, int iters) {
+    int i, j, k = 0;
+    bench_inv *data = (bench_inv*)arg;
+    secp256k1_fe x[32];
+    secp256k1_ge r[32];
+    int odd[32], ret[32];
+
+    for (j = 0; j < 32; j++) {
+        x[j] = data->fe[0];
+        secp256k1_fe_add(&data->fe[0], &data->fe[1]);
+        secp256k1_fe_normalize_var(&data->fe[0]);
+        odd[j] = j & 1;
+    }
+    for (i = 0; i < iters; i += 32) {
+        secp256k1_ge_set_xo_batch_var(r, ret, x, odd, 32);
+        for (j = 0; j < 32; j++) {
+            k += ret[j];
+            x[j] = r[j].y;
+            secp256k1_fe_normalize_var(&x[j]);
+        }
+    }
+    CHECK(k <= iters + 32);
+}
+
+void bench_field_is_quad_var(void* arg, int iters) {
+    int i, j = 0;
+    bench_inv *data = (bench_inv*)arg;
+
+    for (i = 0; i < iters; i++) {
+        j += secp256k1_fe_is_quad_var(&data->fe[0]);
+        secp256k1_fe_add(&data->fe[0], &data->fe[1]);
+        secp256k1_fe_normalize_var(&data->fe[0]);
+    }
+    CHECK(j <= iters);
+}
+
 void bench_group_double_var(void* arg, int iters) {
     int i;
     bench_inv *data = (bench_inv*)arg;
@@ -317,6 +556,70 @@ void bench_wnaf_const(void* arg, int iters) {
     CHECK(bits <= 256*iters);
 }
 
+void bench_wnaf_fixed(void* arg, int iters) {
+    int i, skew = 0;
+    bench_inv *data = (bench_inv*)arg;
+
+    /* The digit size of Pippenger's algorithm with a bucket window of 11, used from
+     * about 10000 points on. */
+    for (i = 0; i < iters; i++) {
+        skew += secp256k1_wnaf_fixed(data->wnaf, &data->half[i & 1023], 12);
+    }
+    CHECK(skew <= iters);
+}
+
+
+void bench_ecmult_gen(void* arg, int iters) {
+    int i;
+    bench_inv *data = (bench_inv*)arg;
+
+    for (i = 0; i < iters; i++) {
+        secp256k1_ecmult_gen(&data->ctx->ecmult_gen_ctx, &data->gej[0], &data->scalar[0]);
+        secp256k1_scalar_add(&data->scalar[0], &data->scalar[0], &data->scalar[1]);
+    }
+}
+
+void bench_ecmult_gen_setup(void* arg) {
+    bench_inv *data = (bench_inv*)arg;
+    bench_setup(arg);
+    data->ctx = secp256k1_context_create(SECP256K1_CONTEXT_SIGN);
+}
+
+void bench_ecmult_gen_teardown(void* arg, int iters) {
+    bench_inv *data = (bench_inv*)arg;
+    (void)iters;
+    secp256k1_context_destroy(data->ctx);
+}
+
+static secp256k1_ecmult_point_table bench_point_table;
+
+void bench_ecmult_setup(void* arg) {
+    bench_inv *data = (bench_inv*)arg;
+    bench_setup(arg);
+    data->ctx = secp256k1_context_create(SECP256K1_CONTEXT_VERIFY);
+    secp256k1_ecmult_point_table_build(&bench_point_table, &data->ge[0]);
+}
+
+void bench_ecmult(void* arg, int iters) {
+    int i;
+    bench_inv *data = (bench_inv*)arg;
+
+    for (i = 0; i < iters; i++) {
+        secp256k1_ecmult(&data->ctx->ecmult_ctx, &data->gej[1], &data->gej[0], &data->scalar[0], NULL);
+        secp256k1_scalar_add(&data->scalar[0], &data->scalar[0], &data->scalar[1]);
+    }
+}
+
+void bench_ecmult_point_table(void* arg, int iters) {
+    int i;
+    bench_inv *data = (bench_inv*)arg;
+    const secp256k1_ecmult_point_table *table = &bench_point_table;
+
+    for (i = 0; i < iters; i++) {
+        secp256k1_ecmult_point_tables(&data->ctx->ecmult_ctx, &data->gej[1], &table, &data->scalar[0], 1, NULL);
+        secp256k1_scalar_add(&data->scalar[0], &data->scalar[0], &data->scalar[1]);
+    }
+}
 
 void bench_sha256(void* arg, int iters) {
     int i;
@@ -398,24 +701,62 @@ int main(int argc, char **argv) {
     if (have_flag(argc, argv, "scalar") || have_flag(argc, argv, "split")) run_benchmark("scalar_split", bench_scalar_split, bench_setup, NULL, &data, 10, iters);
     if (have_flag(argc, argv, "scalar") || have_flag(argc, argv, "inverse")) run_benchmark("scalar_inverse", bench_scalar_inverse, bench_setup, NULL, &data, 10, 2000);
     if (have_flag(argc, argv, "scalar") || have_flag(argc, argv, "inverse")) run_benchmark("scalar_inverse_var", bench_scalar_inverse_var, bench_setup, NULL, &data, 10, 2000);
+    if (have_flag(argc, argv, "scalar") || have_flag(argc, argv, "inverse")) run_benchmark("scalar_inverse_all_var", bench_scalar_inverse_all_var, bench_setup, NULL, &data, 10, 2000);
 
     if (have_flag(argc, argv, "field") || have_flag(argc, argv, "normalize")) run_benchmark("field_normalize", bench_field_normalize, bench_setup, NULL, &data, 10, iters*100);
     if (have_flag(argc, argv, "field") || have_flag(argc, argv, "normalize")) run_benchmark("field_normalize_weak", bench_field_normalize_weak, bench_setup, NULL, &data, 10, iters*100);
     if (have_flag(argc, argv, "field") || have_flag(argc, argv, "sqr")) run_benchmark("field_sqr", bench_field_sqr, bench_setup, NULL, &data, 10, iters*10);
     if (have_flag(argc, argv, "field") || have_flag(argc, argv, "mul")) run_benchmark("field_mul", bench_field_mul, bench_setup, NULL, &data, 10, iters*10);
+#ifdef SECP256K1_FE_X8
+    if (secp256k1_fe_x8_available() && (have_flag(argc, argv, "field") || have_flag(argc, argv, "mul"))) run_benchmark("field_mul_x8", bench_field_mul_x8, bench_setup, NULL, &data, 10, iters*10);
+#endif
     if (have_flag(argc, argv, "field") || have_flag(argc, argv, "inverse")) run_benchmark("field_inverse", bench_field_inverse, bench_setup, NULL, &data, 10, iters);
     if (have_flag(argc, argv, "field") || have_flag(argc, argv, "inverse")) run_benchmark("field_inverse_var", bench_field_inverse_var, bench_setup, NULL, &data, 10, iters);
+    if (have_flag(argc, argv, "inversion")) {
+        bench_inversion_check();
+        run_benchmark("field_inverse_addchain", bench_field_inverse_addchain, bench_setup, NULL, &data, 10, iters);
+        run_benchmark("field_inverse_safegcd", bench_field_inverse_safegcd, bench_setup, NULL, &data, 10, iters);
+        run_benchmark("field_inverse_safegcd_var", bench_field_inverse_safegcd_var, bench_setup, NULL, &data, 10, iters);
+#ifndef USE_NUM_NONE
+        run_benchmark("field_inverse_num_var", bench_field_inverse_num_var, bench_setup, NULL, &data, 10, iters);
+#endif
+        run_benchmark("scalar_inverse_addchain", bench_scalar_inverse_addchain, bench_setup, NULL, &data, 10, 2000);
+        run_benchmark("scalar_inverse_safegcd", bench_scalar_inverse_safegcd, bench_setup, NULL, &data, 10, 2000);
+        run_benchmark("scalar_inverse_safegcd_var", bench_scalar_inverse_safegcd_var, bench_setup, NULL, &data, 10, 2000);
+#ifndef USE_NUM_NONE
+        run_benchmark("scalar_inverse_num_var", bench_scalar_inverse_num_var, bench_setup, NULL, &data, 10, 2000);
+#endif
+    }
     if (have_flag(argc, argv, "field") || have_flag(argc, argv, "sqrt")) run_benchmark("field_sqrt", bench_field_sqrt, bench_setup, NULL, &data, 10, iters);
+    if (have_flag(argc, argv, "field") || have_flag(argc, argv, "jacobi")) run_benchmark("field_is_quad_var", bench_field_is_quad_var, bench_setup, NULL, &data, 10, iters);
 
     if (have_flag(argc, argv, "group") || have_flag(argc, argv, "double")) run_benchmark("group_double_var", bench_group_double_var, bench_setup, NULL, &data, 10, iters*10);
     if (have_flag(argc, argv, "group") || have_flag(argc, argv, "add")) run_benchmark("group_add_var", bench_group_add_var, bench_setup, NULL, &data, 10, iters*10);
     if (have_flag(argc, argv, "group") || have_flag(argc, argv, "add")) run_benchmark("group_add_affine", bench_group_add_affine, bench_setup, NULL, &data, 10, iters*10);
     if (have_flag(argc, argv, "group") || have_flag(argc, argv, "add")) run_benchmark("group_add_affine_var", bench_group_add_affine_var, bench_setup, NULL, &data, 10, iters*10);
+    if (have_flag(argc, argv, "group") || have_flag(argc, argv, "sqrt")) run_benchmark("group_set_xo_batch_var", bench_group_set_xo_batch, bench_setup, NULL, &data, 10, iters);
     if (have_flag(argc, argv, "group") || have_flag(argc, argv, "jacobi")) run_benchmark("group_jacobi_var", bench_group_jacobi_var, bench_setup, NULL, &data, 10, iters);
     if (have_flag(argc, argv, "group") || have_flag(argc, argv, "to_affine")) run_benchmark("group_to_affine_var", bench_group_to_affine_var, bench_setup, NULL, &data, 10, iters);
 
     if (have_flag(argc, argv, "ecmult") || have_flag(argc, argv, "wnaf")) run_benchmark("wnaf_const", bench_wnaf_const, bench_setup, NULL, &data, 10, iters);
     if (have_flag(argc, argv, "ecmult") || have_flag(argc, argv, "wnaf")) run_benchmark("ecmult_wnaf", bench_ecmult_wnaf, bench_setup, NULL, &data, 10, iters);
+    if (have_flag(argc, argv, "ecmult") || have_flag(argc, argv, "wnaf")) run_benchmark("wnaf_fixed", bench_wnaf_fixed, bench_setup, NULL, &data, 10, iters);
+    if (have_flag(argc, argv, "ecmult") || have_flag(argc, argv, "gen")) {
+        /* Name the benchmark after the table configuration, so results of builds with
+         * different --with-ecmult-gen-comb/--with-ecmult-gen-precision can be compared. */
+        char name[64];
+#ifdef USE_ECMULT_GEN_COMB
+        sprintf(name, "ecmult_gen_comb%dx%d_%dkB", ECMULT_GEN_COMB_BLOCKS, ECMULT_GEN_COMB_TEETH, (int)(sizeof(*data.ctx->ecmult_gen_ctx.prec) / 1024));
+#else
+        sprintf(name, "ecmult_gen_prec%d_%dkB", ECMULT_GEN_PREC_BITS, (int)(sizeof(*data.ctx->ecmult_gen_ctx.prec) / 1024));
+#endif
+        run_benchmark(name, bench_ecmult_gen, bench_ecmult_gen_setup, bench_ecmult_gen_teardown, &data, 10, iters);
+    }
+
+    if (have_flag(argc, argv, "ecmult") || have_flag(argc, argv, "point")) {
+        run_benchmark("ecmult_point", bench_ecmult, bench_ecmult_setup, bench_ecmult_gen_teardown, &data, 10, iters);
+        run_benchmark("ecmult_point_table", bench_ecmult_point_table, bench_ecmult_setup, bench_ecmult_gen_teardown, &data, 10, iters);
+    }
 
     if (have_flag(argc, argv, "hash") || have_flag(argc, argv, "sha256")) run_benchmark("hash_sha256", bench_sha256, bench_setup, NULL, &data, 10, iters);
     if (have_flag(argc, argv, "hash") || have_flag(argc, argv, "hmac")) run_benchmark("hash_hmac_sha256", bench_hmac_sha256, bench_setup, NULL, &data, 10, iters);
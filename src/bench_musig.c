@@ -0,0 +1,68 @@
+/**********************************************************************
+ * Distributed under the MIT software license, see the accompanying   *
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "include/secp256k1.h"
+#include "include/secp256k1_musig.h"
+#include "util.h"
+#include "bench.h"
+
+/* The largest number of keys aggregated */
+#define MAX_KEYS 1000
+
+typedef struct {
+    secp256k1_context *ctx;
+    secp256k1_scratch_space *scratch;
+    secp256k1_pubkey pubkeys[MAX_KEYS];
+    const secp256k1_pubkey *pubkey_ptrs[MAX_KEYS];
+    size_t n;
+} bench_musig_data;
+
+static void bench_musig_pubkey_agg(void* arg, int iters) {
+    bench_musig_data *data = (bench_musig_data *)arg;
+    secp256k1_musig_keyagg_cache cache;
+    int i;
+
+    for (i = 0; i < iters; i++) {
+        CHECK(secp256k1_musig_pubkey_agg(data->ctx, data->scratch, NULL, &cache, data->pubkey_ptrs, data->n));
+    }
+}
+
+int main(void) {
+    bench_musig_data data;
+    static const size_t ns[] = { 2, 3, 16, 100, MAX_KEYS };
+    unsigned char sk[32] = { 0 };
+    char name[64];
+    size_t i;
+    int with_scratch;
+
+    int iters = get_iters(100);
+
+    data.ctx = secp256k1_context_create(SECP256K1_CONTEXT_SIGN | SECP256K1_CONTEXT_VERIFY);
+    for (i = 0; i < MAX_KEYS; i++) {
+        sk[0] = i >> 8;
+        sk[1] = i;
+        sk[31] = 1;
+        CHECK(secp256k1_ec_pubkey_create(data.ctx, &data.pubkeys[i], sk));
+        data.pubkey_ptrs[i] = &data.pubkeys[i];
+    }
+
+    for (with_scratch = 0; with_scratch <= 1; with_scratch++) {
+        data.scratch = with_scratch ? secp256k1_scratch_space_create(data.ctx, 16 * 1024 * 1024) : NULL;
+        for (i = 0; i < sizeof(ns) / sizeof(ns[0]); i++) {
+            data.n = ns[i];
+            sprintf(name, "musig_pubkey_agg_%s_%ikeys", with_scratch ? "scratch" : "stack", (int)data.n);
+            run_benchmark(name, bench_musig_pubkey_agg, NULL, NULL, (void *) &data, 10, iters);
+        }
+        if (data.scratch != NULL) {
+            secp256k1_scratch_space_destroy(data.ctx, data.scratch);
+        }
+    }
+
+    secp256k1_context_destroy(data.ctx);
+    return 0;
+}
@@ -4,6 +4,9 @@
  * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
  **********************************************************************/
 
+#include <stdio.h>
+#include <stdlib.h>
+
 #include "include/secp256k1.h"
 #include "include/secp256k1_recovery.h"
 #include "util.h"
@@ -15,6 +18,15 @@ typedef struct {
     unsigned char sig[64];
 } bench_recover_data;
 
+typedef struct {
+    secp256k1_context *ctx;
+    secp256k1_scratch_space *scratch;
+    int n;
+    const secp256k1_ecdsa_recoverable_signature **sigs;
+    const unsigned char **msgs;
+    const secp256k1_pubkey **pubkeys;
+} bench_verify_batch_data;
+
 void bench_recover(void* arg, int iters) {
     int i;
     bench_recover_data *data = (bench_recover_data*)arg;
@@ -48,8 +60,31 @@ void bench_recover_setup(void* arg) {
     }
 }
 
+void bench_recover_batch(void* arg, int iters) {
+    int i;
+    bench_verify_batch_data *data = (bench_verify_batch_data*)arg;
+    secp256k1_pubkey pubkeys[64];
+
+    for (i = 0; i < iters; i += 64) {
+        size_t n = iters - i < 64 ? iters - i : 64;
+        CHECK(secp256k1_ecdsa_recover_batch(data->ctx, pubkeys, &data->sigs[i], &data->msgs[i], n));
+    }
+}
+
+void bench_verify_batch(void* arg, int iters) {
+    int i;
+    bench_verify_batch_data *data = (bench_verify_batch_data*)arg;
+
+    for (i = 0; i < iters; i += data->n) {
+        size_t n = iters - i < data->n ? iters - i : data->n;
+        CHECK(secp256k1_ecdsa_verify_batch(data->ctx, data->scratch, &data->sigs[i], &data->msgs[i], &data->pubkeys[i], n));
+    }
+}
+
 int main(void) {
+    int i;
     bench_recover_data data;
+    bench_verify_batch_data batch_data;
 
     int iters = get_iters(20000);
 
@@ -58,5 +93,47 @@ int main(void) {
     run_benchmark("ecdsa_recover", bench_recover, bench_recover_setup, NULL, &data, 10, iters);
 
     secp256k1_context_destroy(data.ctx);
+
+    batch_data.ctx = secp256k1_context_create(SECP256K1_CONTEXT_SIGN | SECP256K1_CONTEXT_VERIFY);
+    batch_data.scratch = secp256k1_scratch_space_create(batch_data.ctx, 16 * 1024 * 1024);
+    batch_data.sigs = (const secp256k1_ecdsa_recoverable_signature **)malloc(iters * sizeof(secp256k1_ecdsa_recoverable_signature *));
+    batch_data.msgs = (const unsigned char **)malloc(iters * sizeof(unsigned char *));
+    batch_data.pubkeys = (const secp256k1_pubkey **)malloc(iters * sizeof(secp256k1_pubkey *));
+    for (i = 0; i < iters; i++) {
+        unsigned char sk[32];
+        unsigned char *msg = (unsigned char *)malloc(32);
+        secp256k1_ecdsa_recoverable_signature *sig = (secp256k1_ecdsa_recoverable_signature *)malloc(sizeof(*sig));
+        secp256k1_pubkey *pubkey = (secp256k1_pubkey *)malloc(sizeof(*pubkey));
+        int j;
+        for (j = 0; j < 32; j++) {
+            msg[j] = sk[j] = j + 1;
+        }
+        msg[0] = sk[0] = i;
+        msg[1] = sk[1] = i >> 8;
+        CHECK(secp256k1_ec_pubkey_create(batch_data.ctx, pubkey, sk));
+        CHECK(secp256k1_ecdsa_sign_recoverable(batch_data.ctx, sig, msg, sk, NULL, NULL));
+        batch_data.sigs[i] = sig;
+        batch_data.msgs[i] = msg;
+        batch_data.pubkeys[i] = pubkey;
+    }
+
+    run_benchmark("ecdsa_recover_batch", bench_recover_batch, NULL, NULL, &batch_data, 10, iters);
+
+    for (batch_data.n = 1; batch_data.n <= iters && batch_data.n <= 4096; batch_data.n *= 8) {
+        char name[64];
+        sprintf(name, "ecdsa_verify_batch_%i", batch_data.n);
+        run_benchmark(name, bench_verify_batch, NULL, NULL, &batch_data, 10, iters);
+    }
+
+    for (i = 0; i < iters; i++) {
+        free((void *)batch_data.sigs[i]);
+        free((void *)batch_data.msgs[i]);
+        free((void *)batch_data.pubkeys[i]);
+    }
+    free(batch_data.sigs);
+    free(batch_data.msgs);
+    free(batch_data.pubkeys);
+    secp256k1_scratch_space_destroy(batch_data.ctx, batch_data.scratch);
+    secp256k1_context_destroy(batch_data.ctx);
     return 0;
 }
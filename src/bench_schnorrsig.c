@@ -13,6 +13,10 @@
 #include "util.h"
 #include "bench.h"
 
+#ifdef ENABLE_MODULE_SCHNORRSIG_HALFAGG
+#include "include/secp256k1_schnorrsig_halfagg.h"
+#endif
+
 typedef struct {
     secp256k1_context *ctx;
     int n;
@@ -21,6 +25,12 @@ typedef struct {
     const unsigned char **pk;
     const unsigned char **sigs;
     const unsigned char **msgs;
+    const secp256k1_xonly_pubkey **pk_parsed;
+    secp256k1_scratch_space *scratch;
+#ifdef ENABLE_MODULE_SCHNORRSIG_HALFAGG
+    /* The aggregates of consecutive groups of n signatures, each 32 + 32*n bytes */
+    unsigned char *aggsigs;
+#endif
 } bench_schnorrsig_data;
 
 void bench_schnorrsig_sign(void* arg, int iters) {
@@ -36,6 +46,47 @@ void bench_schnorrsig_sign(void* arg, int iters) {
     }
 }
 
+void bench_schnorrsig_sign_aux(void* arg, int iters) {
+    bench_schnorrsig_data *data = (bench_schnorrsig_data *)arg;
+    int i;
+    unsigned char msg[32] = "benchmarkexamplemessagetemplate";
+    unsigned char aux[32] = "benchmarkexampleauxrandomness...";
+    unsigned char sig[64];
+
+    for (i = 0; i < iters; i++) {
+        msg[0] = i;
+        msg[1] = i >> 8;
+        CHECK(secp256k1_schnorrsig_sign(data->ctx, sig, msg, data->keypairs[0], NULL, aux));
+    }
+}
+
+void bench_schnorrsig_sign_session(void* arg, int iters) {
+    bench_schnorrsig_data *data = (bench_schnorrsig_data *)arg;
+    int i;
+    unsigned char msg[32] = "benchmarkexamplemessagetemplate";
+    unsigned char aux[32] = "benchmarkexampleauxrandomness...";
+    unsigned char sig[64];
+    secp256k1_schnorrsig_session session;
+
+    CHECK(secp256k1_schnorrsig_session_init(data->ctx, &session, data->keypairs[0], aux));
+    for (i = 0; i < iters; i++) {
+        msg[0] = i;
+        msg[1] = i >> 8;
+        CHECK(secp256k1_schnorrsig_sign_session(data->ctx, sig, msg, &session));
+    }
+}
+
+void bench_schnorrsig_sign_batch(void* arg, int iters) {
+    bench_schnorrsig_data *data = (bench_schnorrsig_data *)arg;
+    int i;
+    unsigned char sigs[64 * 64];
+
+    for (i = 0; i < iters; i += 64) {
+        size_t n = iters - i < 64 ? iters - i : 64;
+        CHECK(secp256k1_schnorrsig_sign_batch(data->ctx, sigs, &data->msgs[i], n, data->keypairs[0], NULL));
+    }
+}
+
 void bench_schnorrsig_verify(void* arg, int iters) {
     bench_schnorrsig_data *data = (bench_schnorrsig_data *)arg;
     int i;
@@ -47,6 +98,54 @@ void bench_schnorrsig_verify(void* arg, int iters) {
     }
 }
 
+void bench_schnorrsig_verify_batch(void* arg, int iters) {
+    bench_schnorrsig_data *data = (bench_schnorrsig_data *)arg;
+    int i;
+
+    for (i = 0; i < iters; i += data->n) {
+        size_t n = iters - i < data->n ? iters - i : data->n;
+        CHECK(secp256k1_schnorrsig_verify_batch(data->ctx, data->scratch, &data->sigs[i], &data->msgs[i], &data->pk_parsed[i], n));
+    }
+}
+
+#ifdef ENABLE_MODULE_SCHNORRSIG_HALFAGG
+void bench_schnorrsig_halfagg_aggregate(void* arg, int iters) {
+    bench_schnorrsig_data *data = (bench_schnorrsig_data *)arg;
+    int i;
+
+    for (i = 0; i < iters; i += data->n) {
+        size_t n = iters - i < data->n ? iters - i : data->n;
+        size_t len = 32 * (n + 1);
+        CHECK(secp256k1_schnorrsig_halfagg_aggregate(data->ctx, data->aggsigs, &len, &data->sigs[i], &data->msgs[i], &data->pk_parsed[i], n));
+    }
+}
+
+/* Aggregates the groups of n signatures that bench_schnorrsig_halfagg_verify verifies. */
+static void bench_schnorrsig_halfagg_prepare(bench_schnorrsig_data *data, int iters) {
+    unsigned char *aggsig = data->aggsigs;
+    int i;
+
+    for (i = 0; i < iters; i += data->n) {
+        size_t n = iters - i < data->n ? iters - i : data->n;
+        size_t len = 32 * (n + 1);
+        CHECK(secp256k1_schnorrsig_halfagg_aggregate(data->ctx, aggsig, &len, &data->sigs[i], &data->msgs[i], &data->pk_parsed[i], n));
+        aggsig += len;
+    }
+}
+
+void bench_schnorrsig_halfagg_verify(void* arg, int iters) {
+    bench_schnorrsig_data *data = (bench_schnorrsig_data *)arg;
+    const unsigned char *aggsig = data->aggsigs;
+    int i;
+
+    for (i = 0; i < iters; i += data->n) {
+        size_t n = iters - i < data->n ? iters - i : data->n;
+        CHECK(secp256k1_schnorrsig_halfagg_verify(data->ctx, data->scratch, aggsig, 32 * (n + 1), &data->msgs[i], &data->pk_parsed[i], n));
+        aggsig += 32 * (n + 1);
+    }
+}
+#endif
+
 int main(void) {
     int i;
     bench_schnorrsig_data data;
@@ -57,6 +156,8 @@ int main(void) {
     data.pk = (const unsigned char **)malloc(iters * sizeof(unsigned char *));
     data.msgs = (const unsigned char **)malloc(iters * sizeof(unsigned char *));
     data.sigs = (const unsigned char **)malloc(iters * sizeof(unsigned char *));
+    data.pk_parsed = (const secp256k1_xonly_pubkey **)malloc(iters * sizeof(secp256k1_xonly_pubkey *));
+    data.scratch = secp256k1_scratch_space_create(data.ctx, 16 * 1024 * 1024);
 
     for (i = 0; i < iters; i++) {
         unsigned char sk[32];
@@ -64,6 +165,7 @@ int main(void) {
         unsigned char *sig = (unsigned char *)malloc(64);
         secp256k1_keypair *keypair = (secp256k1_keypair *)malloc(sizeof(*keypair));
         unsigned char *pk_char = (unsigned char *)malloc(32);
+        secp256k1_xonly_pubkey *pk_parsed = (secp256k1_xonly_pubkey *)malloc(sizeof(*pk_parsed));
         secp256k1_xonly_pubkey pk;
         msg[0] = sk[0] = i;
         msg[1] = sk[1] = i >> 8;
@@ -76,26 +178,53 @@ int main(void) {
         data.pk[i] = pk_char;
         data.msgs[i] = msg;
         data.sigs[i] = sig;
+        data.pk_parsed[i] = pk_parsed;
 
         CHECK(secp256k1_keypair_create(data.ctx, keypair, sk));
         CHECK(secp256k1_schnorrsig_sign(data.ctx, sig, msg, keypair, NULL, NULL));
         CHECK(secp256k1_keypair_xonly_pub(data.ctx, &pk, NULL, keypair));
         CHECK(secp256k1_xonly_pubkey_serialize(data.ctx, pk_char, &pk) == 1);
+        *pk_parsed = pk;
     }
 
     run_benchmark("schnorrsig_sign", bench_schnorrsig_sign, NULL, NULL, (void *) &data, 10, iters);
+    run_benchmark("schnorrsig_sign_aux", bench_schnorrsig_sign_aux, NULL, NULL, (void *) &data, 10, iters);
+    run_benchmark("schnorrsig_sign_session", bench_schnorrsig_sign_session, NULL, NULL, (void *) &data, 10, iters);
+    run_benchmark("schnorrsig_sign_batch", bench_schnorrsig_sign_batch, NULL, NULL, (void *) &data, 10, iters);
     run_benchmark("schnorrsig_verify", bench_schnorrsig_verify, NULL, NULL, (void *) &data, 10, iters);
+    for (data.n = 1; data.n <= iters && data.n <= 4096; data.n *= 8) {
+        char name[64];
+        sprintf(name, "schnorrsig_verify_batch_%i", data.n);
+        run_benchmark(name, bench_schnorrsig_verify_batch, NULL, NULL, (void *) &data, 10, iters);
+    }
+#ifdef ENABLE_MODULE_SCHNORRSIG_HALFAGG
+    /* An aggregate of n signatures takes 32 + 32*n bytes instead of 64*n, and the groups
+     * of all sizes together at most 64 bytes per signature. */
+    data.aggsigs = (unsigned char *)malloc(64 * iters);
+    for (data.n = 1; data.n <= iters && data.n <= 4096; data.n *= 8) {
+        char name[64];
+        sprintf(name, "schnorrsig_halfagg_aggregate_%i", data.n);
+        run_benchmark(name, bench_schnorrsig_halfagg_aggregate, NULL, NULL, (void *) &data, 10, iters);
+        bench_schnorrsig_halfagg_prepare(&data, iters);
+        sprintf(name, "schnorrsig_halfagg_verify_%i", data.n);
+        run_benchmark(name, bench_schnorrsig_halfagg_verify, NULL, NULL, (void *) &data, 10, iters);
+    }
+    free(data.aggsigs);
+#endif
 
     for (i = 0; i < iters; i++) {
         free((void *)data.keypairs[i]);
         free((void *)data.pk[i]);
         free((void *)data.msgs[i]);
         free((void *)data.sigs[i]);
+        free((void *)data.pk_parsed[i]);
     }
     free(data.keypairs);
     free(data.pk);
     free(data.msgs);
     free(data.sigs);
+    free(data.pk_parsed);
+    secp256k1_scratch_space_destroy(data.ctx, data.scratch);
 
     secp256k1_context_destroy(data.ctx);
     return 0;
@@ -4,6 +4,8 @@
  * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
  **********************************************************************/
 
+#include <string.h>
+
 #include "include/secp256k1.h"
 #include "util.h"
 #include "bench.h"
@@ -44,6 +46,21 @@ static void bench_sign_run(void* arg, int iters) {
     }
 }
 
+static void bench_sign_session_run(void* arg, int iters) {
+    int i;
+    bench_sign_data *data = (bench_sign_data*)arg;
+    secp256k1_ecdsa_session session;
+
+    unsigned char sig[64];
+    CHECK(secp256k1_ecdsa_session_init(data->ctx, &session, data->key));
+    for (i = 0; i < iters; i++) {
+        secp256k1_ecdsa_signature signature;
+        CHECK(secp256k1_ecdsa_sign_session(data->ctx, &signature, data->msg, &session, NULL));
+        CHECK(secp256k1_ecdsa_signature_serialize_compact(data->ctx, sig, &signature));
+        memcpy(data->msg, sig, 32);
+    }
+}
+
 int main(void) {
     bench_sign_data data;
 
@@ -52,6 +69,7 @@ int main(void) {
     data.ctx = secp256k1_context_create(SECP256K1_CONTEXT_SIGN);
 
     run_benchmark("ecdsa_sign", bench_sign_run, bench_sign_setup, NULL, &data, 10, iters);
+    run_benchmark("ecdsa_sign_session", bench_sign_session_run, bench_sign_setup, NULL, &data, 10, iters);
 
     secp256k1_context_destroy(data.ctx);
     return 0;
@@ -0,0 +1,205 @@
+/**********************************************************************
+ * Distributed under the MIT software license, see the accompanying   *
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
+ **********************************************************************/
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "include/secp256k1.h"
+#include "util.h"
+#include "bench.h"
+
+#ifdef ENABLE_MODULE_ECDH
+#include "include/secp256k1_ecdh.h"
+#endif
+#ifdef ENABLE_MODULE_SCHNORRSIG
+#include "include/secp256k1_extrakeys.h"
+#include "include/secp256k1_schnorrsig.h"
+#endif
+
+/* Runs an operation from 1, 2, 4, ... threads at once, all of them sharing a single
+ * context, and reports the aggregate number of operations per second and how close it
+ * is to the single-threaded rate times the number of threads. Numbers well short of
+ * 100% point at limits (memory bandwidth, shared caches, false sharing on the tables)
+ * that the single-threaded benchmarks cannot show.
+ *
+ * SECP256K1_BENCH_THREADS sets the largest number of threads (by default, the number
+ * of online CPUs) and SECP256K1_BENCH_ITERS the number of operations per thread. */
+
+typedef struct {
+    const secp256k1_context *ctx;
+    secp256k1_pubkey pubkey;
+    secp256k1_ecdsa_signature sig;
+    unsigned char key[32];
+#ifdef ENABLE_MODULE_SCHNORRSIG
+    secp256k1_keypair keypair;
+    secp256k1_xonly_pubkey xonly;
+    unsigned char schnorr_sig[64];
+#endif
+} bench_throughput_shared;
+
+/* Each thread only writes to its own state, which is padded by more than a cache line
+ * (of the largest size in common use) so that the benchmark itself adds no false sharing. */
+typedef struct {
+    const bench_throughput_shared *shared;
+    void (*op)(const bench_throughput_shared *shared, unsigned char *msg);
+    int iters;
+    pthread_t thread;
+    unsigned char msg[32];
+    unsigned char padding[128];
+} bench_throughput_thread;
+
+static pthread_mutex_t bench_throughput_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t bench_throughput_cond = PTHREAD_COND_INITIALIZER;
+static int bench_throughput_started;
+
+static void bench_throughput_verify(const bench_throughput_shared *shared, unsigned char *msg) {
+    CHECK(secp256k1_ecdsa_verify(shared->ctx, &shared->sig, msg, &shared->pubkey) == 0);
+}
+
+static void bench_throughput_sign(const bench_throughput_shared *shared, unsigned char *msg) {
+    secp256k1_ecdsa_signature sig;
+    CHECK(secp256k1_ecdsa_sign(shared->ctx, &sig, msg, shared->key, NULL, NULL) == 1);
+    memcpy(msg, &sig, 32);
+}
+
+#ifdef ENABLE_MODULE_ECDH
+static void bench_throughput_ecdh(const bench_throughput_shared *shared, unsigned char *msg) {
+    unsigned char output[32];
+    CHECK(secp256k1_ecdh(shared->ctx, output, &shared->pubkey, msg, NULL, NULL) == 1);
+    memcpy(msg, output, 32);
+}
+#endif
+
+#ifdef ENABLE_MODULE_SCHNORRSIG
+static void bench_throughput_schnorrsig_verify(const bench_throughput_shared *shared, unsigned char *msg) {
+    CHECK(secp256k1_schnorrsig_verify(shared->ctx, shared->schnorr_sig, msg, &shared->xonly) == 0);
+}
+
+static void bench_throughput_schnorrsig_sign(const bench_throughput_shared *shared, unsigned char *msg) {
+    unsigned char sig[64];
+    CHECK(secp256k1_schnorrsig_sign(shared->ctx, sig, msg, &shared->keypair, NULL, NULL) == 1);
+    memcpy(msg, sig, 32);
+}
+#endif
+
+static void *bench_throughput_run(void *arg) {
+    bench_throughput_thread *t = (bench_throughput_thread *)arg;
+    int i;
+
+    pthread_mutex_lock(&bench_throughput_mutex);
+    while (!bench_throughput_started) {
+        pthread_cond_wait(&bench_throughput_cond, &bench_throughput_mutex);
+    }
+    pthread_mutex_unlock(&bench_throughput_mutex);
+    for (i = 0; i < t->iters; i++) {
+        /* A different message each time; the operations above feed their output
+         * back into it, which also keeps them from being optimized out. */
+        t->msg[31] ^= (unsigned char)i;
+        t->op(t->shared, t->msg);
+    }
+    return NULL;
+}
+
+/* Returns the aggregate number of operations per second of nthreads threads. */
+static double bench_throughput_measure(const bench_throughput_shared *shared, void (*op)(const bench_throughput_shared *, unsigned char *), int nthreads, int iters) {
+    bench_throughput_thread *threads = (bench_throughput_thread *)malloc(nthreads * sizeof(*threads));
+    int64_t begin, end;
+    int i;
+
+    CHECK(threads != NULL);
+    bench_throughput_started = 0;
+    for (i = 0; i < nthreads; i++) {
+        threads[i].shared = shared;
+        threads[i].op = op;
+        threads[i].iters = iters;
+        memset(threads[i].msg, 0, sizeof(threads[i].msg));
+        threads[i].msg[0] = (unsigned char)(i + 1);
+        threads[i].msg[1] = (unsigned char)((i + 1) >> 8);
+        CHECK(pthread_create(&threads[i].thread, NULL, bench_throughput_run, &threads[i]) == 0);
+    }
+    pthread_mutex_lock(&bench_throughput_mutex);
+    begin = gettime_i64();
+    bench_throughput_started = 1;
+    pthread_cond_broadcast(&bench_throughput_cond);
+    pthread_mutex_unlock(&bench_throughput_mutex);
+    for (i = 0; i < nthreads; i++) {
+        CHECK(pthread_join(threads[i].thread, NULL) == 0);
+    }
+    end = gettime_i64();
+    free(threads);
+    return (double)nthreads * iters * 1000000.0 / (double)(end - begin > 0 ? end - begin : 1);
+}
+
+static void run_throughput(const char *name, const bench_throughput_shared *shared, void (*op)(const bench_throughput_shared *, unsigned char *), int max_threads, int iters) {
+    double single = 0;
+    int nthreads;
+
+    for (nthreads = 1; ; nthreads *= 2) {
+        double rate;
+        if (nthreads > max_threads) {
+            nthreads = max_threads;
+        }
+        rate = bench_throughput_measure(shared, op, nthreads, iters);
+        if (nthreads == 1) {
+            single = rate;
+        }
+        printf("%s: %d thread%s: %.0f ops/s, %.1f%% of linear scaling\n", name, nthreads, nthreads == 1 ? "" : "s", rate, 100.0 * rate / (single * nthreads));
+        if (nthreads == max_threads) {
+            break;
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    bench_throughput_shared shared;
+    secp256k1_context *ctx;
+    unsigned char msg[32];
+    int iters = get_iters(2000);
+    int max_threads = 0;
+    const char *env = getenv("SECP256K1_BENCH_THREADS");
+    int i;
+
+    if (env != NULL) {
+        max_threads = strtol(env, NULL, 0);
+    }
+#ifdef _SC_NPROCESSORS_ONLN
+    if (max_threads <= 0) {
+        max_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+#endif
+    if (max_threads <= 0) {
+        max_threads = 1;
+    }
+
+    ctx = secp256k1_context_create(SECP256K1_CONTEXT_SIGN | SECP256K1_CONTEXT_VERIFY);
+    shared.ctx = ctx;
+    for (i = 0; i < 32; i++) {
+        shared.key[i] = 33 + i;
+        msg[i] = 1 + i;
+    }
+    CHECK(secp256k1_ec_pubkey_create(ctx, &shared.pubkey, shared.key) == 1);
+    CHECK(secp256k1_ecdsa_sign(ctx, &shared.sig, msg, shared.key, NULL, NULL) == 1);
+#ifdef ENABLE_MODULE_SCHNORRSIG
+    CHECK(secp256k1_keypair_create(ctx, &shared.keypair, shared.key) == 1);
+    CHECK(secp256k1_keypair_xonly_pub(ctx, &shared.xonly, NULL, &shared.keypair) == 1);
+    CHECK(secp256k1_schnorrsig_sign(ctx, shared.schnorr_sig, msg, &shared.keypair, NULL, NULL) == 1);
+#endif
+
+    if (have_flag(argc, argv, "verify")) run_throughput("ecdsa_verify", &shared, bench_throughput_verify, max_threads, iters);
+    if (have_flag(argc, argv, "sign")) run_throughput("ecdsa_sign", &shared, bench_throughput_sign, max_threads, iters);
+#ifdef ENABLE_MODULE_ECDH
+    if (have_flag(argc, argv, "ecdh")) run_throughput("ecdh", &shared, bench_throughput_ecdh, max_threads, iters);
+#endif
+#ifdef ENABLE_MODULE_SCHNORRSIG
+    if (have_flag(argc, argv, "schnorrsig") || have_flag(argc, argv, "verify")) run_throughput("schnorrsig_verify", &shared, bench_throughput_schnorrsig_verify, max_threads, iters);
+    if (have_flag(argc, argv, "schnorrsig") || have_flag(argc, argv, "sign")) run_throughput("schnorrsig_sign", &shared, bench_throughput_schnorrsig_sign, max_threads, iters);
+#endif
+
+    secp256k1_context_destroy(ctx);
+    return 0;
+}
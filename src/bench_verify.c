@@ -4,10 +4,17 @@
  * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
  **********************************************************************/
 
+#if defined(__linux__)
+/* for mmap's MAP_ANONYMOUS and MAP_HUGETLB, and madvise */
+#define _DEFAULT_SOURCE
+#include <sys/mman.h>
+#endif
+
 #include <stdio.h>
 #include <string.h>
 
 #include "include/secp256k1.h"
+#include "include/secp256k1_preallocated.h"
 #include "util.h"
 #include "bench.h"
 
@@ -26,6 +33,7 @@ typedef struct {
     size_t siglen;
     unsigned char pubkey[33];
     size_t pubkeylen;
+    secp256k1_pubkey_prepared *prepared;
 #ifdef ENABLE_OPENSSL_TESTS
     EC_GROUP* ec_group;
 #endif
@@ -50,6 +58,82 @@ static void bench_verify(void* arg, int iters) {
     }
 }
 
+static void bench_verify_prepared(void* arg, int iters) {
+    int i;
+    bench_verify_data* data = (bench_verify_data*)arg;
+
+    for (i = 0; i < iters; i++) {
+        secp256k1_ecdsa_signature sig;
+        data->sig[data->siglen - 1] ^= (i & 0xFF);
+        data->sig[data->siglen - 2] ^= ((i >> 8) & 0xFF);
+        data->sig[data->siglen - 3] ^= ((i >> 16) & 0xFF);
+        CHECK(secp256k1_ecdsa_signature_parse_der(data->ctx, &sig, data->sig, data->siglen) == 1);
+        CHECK(secp256k1_ecdsa_verify_prepared(data->ctx, &sig, data->msg, data->prepared) == (i == 0));
+        data->sig[data->siglen - 1] ^= (i & 0xFF);
+        data->sig[data->siglen - 2] ^= ((i >> 8) & 0xFF);
+        data->sig[data->siglen - 3] ^= ((i >> 16) & 0xFF);
+    }
+}
+
+/* Like bench_verify, but verifies the signatures four at a time with
+ * secp256k1_ecdsa_verify_many. */
+static void bench_verify_many(void* arg, int iters) {
+    int i, j;
+    bench_verify_data* data = (bench_verify_data*)arg;
+
+    for (i = 0; i < iters; i += 4) {
+        secp256k1_pubkey pubkey[4];
+        secp256k1_ecdsa_signature sig[4];
+        const secp256k1_pubkey *pubkeys[4];
+        const secp256k1_ecdsa_signature *sigs[4];
+        const unsigned char *msgs[4];
+        int results[4];
+        int n = iters - i < 4 ? iters - i : 4;
+        for (j = 0; j < n; j++) {
+            int k = i + j;
+            data->sig[data->siglen - 1] ^= (k & 0xFF);
+            data->sig[data->siglen - 2] ^= ((k >> 8) & 0xFF);
+            data->sig[data->siglen - 3] ^= ((k >> 16) & 0xFF);
+            CHECK(secp256k1_ec_pubkey_parse(data->ctx, &pubkey[j], data->pubkey, data->pubkeylen) == 1);
+            CHECK(secp256k1_ecdsa_signature_parse_der(data->ctx, &sig[j], data->sig, data->siglen) == 1);
+            data->sig[data->siglen - 1] ^= (k & 0xFF);
+            data->sig[data->siglen - 2] ^= ((k >> 8) & 0xFF);
+            data->sig[data->siglen - 3] ^= ((k >> 16) & 0xFF);
+            pubkeys[j] = &pubkey[j];
+            sigs[j] = &sig[j];
+            msgs[j] = data->msg;
+        }
+        CHECK(secp256k1_ecdsa_verify_many(data->ctx, results, sigs, msgs, pubkeys, n) == (i == 0 && n == 1));
+        for (j = 0; j < n; j++) {
+            CHECK(results[j] == (i + j == 0));
+        }
+    }
+}
+
+#if defined(__linux__)
+/* Map the verification tables on huge pages, which avoids most of the TLB misses
+ * of the table lookups at large window sizes. Explicit huge pages (MAP_HUGETLB) are
+ * only available if the administrator reserved some, so fall back to asking for
+ * transparent huge pages. Returns NULL if no memory could be mapped. */
+static unsigned char *bench_verify_map_tables(size_t len) {
+    void *p;
+#ifdef MAP_HUGETLB
+    p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (p != MAP_FAILED) {
+        return (unsigned char*)p;
+    }
+#endif
+    p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        return NULL;
+    }
+#ifdef MADV_HUGEPAGE
+    madvise(p, len, MADV_HUGEPAGE);
+#endif
+    return (unsigned char*)p;
+}
+#endif
+
 #ifdef ENABLE_OPENSSL_TESTS
 static void bench_verify_openssl(void* arg, int iters) {
     int i;
@@ -104,6 +188,27 @@ int main(void) {
     CHECK(secp256k1_ec_pubkey_serialize(data.ctx, data.pubkey, &data.pubkeylen, &pubkey, SECP256K1_EC_COMPRESSED) == 1);
 
     run_benchmark("ecdsa_verify", bench_verify, NULL, NULL, &data, 10, iters);
+    run_benchmark("ecdsa_verify_many", bench_verify_many, NULL, NULL, &data, 10, iters);
+    data.prepared = secp256k1_pubkey_prepared_create(data.ctx, &pubkey);
+    CHECK(data.prepared != NULL);
+    run_benchmark("ecdsa_verify_prepared", bench_verify_prepared, NULL, NULL, &data, 10, iters);
+    secp256k1_pubkey_prepared_destroy(data.ctx, data.prepared);
+#if defined(__linux__)
+    {
+        size_t const table_len = secp256k1_context_verify_table_size();
+        unsigned char *table = bench_verify_map_tables(table_len);
+        secp256k1_context *ctx = data.ctx;
+        if (table != NULL) {
+            CHECK(secp256k1_context_verify_table_serialize(ctx, table, table_len) == 1);
+            data.ctx = secp256k1_context_create(SECP256K1_CONTEXT_NONE);
+            CHECK(secp256k1_context_verify_table_load(data.ctx, table, table_len) == 1);
+            run_benchmark("ecdsa_verify_hugepages", bench_verify, NULL, NULL, &data, 10, iters);
+            secp256k1_context_destroy(data.ctx);
+            munmap(table, table_len);
+        }
+        data.ctx = ctx;
+    }
+#endif
 #ifdef ENABLE_OPENSSL_TESTS
     data.ec_group = EC_GROUP_new_by_curve_name(NID_secp256k1);
     run_benchmark("ecdsa_verify_openssl", bench_verify_openssl, NULL, NULL, &data, 10, iters);
@@ -0,0 +1,99 @@
+/**********************************************************************
+ * Distributed under the MIT software license, see the accompanying   *
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
+ **********************************************************************/
+
+#ifndef SECP256K1_CPU_IMPL_H
+#define SECP256K1_CPU_IMPL_H
+
+/* Runtime detection of the CPU features used by the optional x86 code paths (SHA
+ * extensions, MULX/ADX scalar multiplication, AVX-512 IFMA field arithmetic, AVX2
+ * ecmult_gen table scans). Those
+ * paths are compiled in by configure when the toolchain supports them, and each one
+ * checks secp256k1_cpu_x86_has before it is used, so a single binary picks the best
+ * code on every machine. The features are probed once (context creation does so
+ * up front) and cached. */
+
+#include "util.h"
+
+#if defined(USE_SHA256_X86_SHANI) || defined(USE_ASM_X86_64_ADX) || defined(USE_FIELD_5X52_IFMA) || defined(USE_ECMULT_GEN_X86_AVX2)
+#define SECP256K1_CPU_X86 1
+
+#include <cpuid.h>
+
+/** SHA, SSSE3 and SSE4.1 */
+#define SECP256K1_CPU_X86_SHANI (1u << 0)
+/** BMI2 (MULX) and ADX (ADCX/ADOX) */
+#define SECP256K1_CPU_X86_ADX (1u << 1)
+/** AVX-512F and AVX-512 IFMA, with the AVX-512 register state saved by the OS */
+#define SECP256K1_CPU_X86_AVX512_IFMA (1u << 2)
+/** AVX and AVX2, with the YMM register state saved by the OS */
+#define SECP256K1_CPU_X86_AVX2 (1u << 3)
+/** Set once the other bits have been determined */
+#define SECP256K1_CPU_X86_PROBED (1u << 31)
+
+/* The detected features. Any thread may probe them, so they are only accessed with
+ * ATOMIC_LOAD and ATOMIC_STORE; threads that race on the first probe all compute and
+ * store the same value. */
+static unsigned int secp256k1_cpu_x86_state = 0;
+/* Features that secp256k1_cpu_x86_has reports as missing, see secp256k1_cpu_x86_disable. */
+static unsigned int secp256k1_cpu_x86_disabled = 0;
+
+static unsigned int secp256k1_cpu_x86_probe(void) {
+    unsigned int eax, ebx, ecx, edx, xcr0_lo = 0, xcr0_hi;
+    unsigned int ecx1, ebx7, features = 0;
+
+    if (__get_cpuid_max(0, NULL) < 7) {
+        return 0;
+    }
+    __cpuid_count(1, 0, eax, ebx, ecx1, edx);
+    __cpuid_count(7, 0, eax, ebx7, ecx, edx);
+    /* OSXSAVE, so that XGETBV can be used */
+    if (ecx1 & (1u << 27)) {
+        __asm__ ("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+        (void)xcr0_hi;
+    }
+
+    if ((ecx1 & (1u << 9)) && (ecx1 & (1u << 19)) && (ebx7 & (1u << 29))) {
+        features |= SECP256K1_CPU_X86_SHANI;
+    }
+    if ((ebx7 & (1u << 8)) && (ebx7 & (1u << 19))) {
+        features |= SECP256K1_CPU_X86_ADX;
+    }
+    /* SSE, AVX, opmask and ZMM state enabled; AVX512F and AVX512IFMA */
+    if ((xcr0_lo & 0xE6) == 0xE6 && (ebx7 & (1u << 16)) && (ebx7 & (1u << 21))) {
+        features |= SECP256K1_CPU_X86_AVX512_IFMA;
+    }
+    /* SSE and AVX state enabled; AVX and AVX2 */
+    if ((xcr0_lo & 0x6) == 0x6 && (ecx1 & (1u << 28)) && (ebx7 & (1u << 5))) {
+        features |= SECP256K1_CPU_X86_AVX2;
+    }
+    return features;
+}
+
+/** Returns whether the CPU supports all of the given SECP256K1_CPU_X86_* features. */
+static int secp256k1_cpu_x86_has(unsigned int features) {
+    unsigned int state = ATOMIC_LOAD(&secp256k1_cpu_x86_state);
+    if (!(state & SECP256K1_CPU_X86_PROBED)) {
+        state = secp256k1_cpu_x86_probe() | SECP256K1_CPU_X86_PROBED;
+        ATOMIC_STORE(&secp256k1_cpu_x86_state, state);
+    }
+    state &= ~ATOMIC_LOAD(&secp256k1_cpu_x86_disabled);
+    return (state & features) == features;
+}
+
+/** Makes secp256k1_cpu_x86_has report the given features as missing (none, if 0),
+ *  so that tests can run the code that does without them. */
+static void secp256k1_cpu_x86_disable(unsigned int features) {
+    ATOMIC_STORE(&secp256k1_cpu_x86_disabled, features);
+}
+#endif
+
+/** Determines the CPU features, so that the hot paths only test a cached value. */
+static void secp256k1_cpu_probe(void) {
+#ifdef SECP256K1_CPU_X86
+    (void)secp256k1_cpu_x86_has(0);
+#endif
+}
+
+#endif /* SECP256K1_CPU_IMPL_H */
@@ -16,6 +16,14 @@
 static int secp256k1_ecdsa_sig_parse(secp256k1_scalar *r, secp256k1_scalar *s, const unsigned char *sig, size_t size);
 static int secp256k1_ecdsa_sig_serialize(unsigned char *sig, size_t *size, const secp256k1_scalar *r, const secp256k1_scalar *s);
 static int secp256k1_ecdsa_sig_verify(const secp256k1_ecmult_context *ctx, const secp256k1_scalar* r, const secp256k1_scalar* s, const secp256k1_ge *pubkey, const secp256k1_scalar *message);
+/** Like secp256k1_ecdsa_sig_verify, with the public key given by its prepared tables. */
+/** Verify the n (at most ECMULT_LANES) signatures (r[i], s[i]) independently, setting
+ *  valid[i] to the result of secp256k1_ecdsa_sig_verify for signature i. */
+static void secp256k1_ecdsa_sig_verify_lanes(const secp256k1_ecmult_context *ctx, int *valid, const secp256k1_scalar *r, const secp256k1_scalar *s, const secp256k1_ge *pubkey, const secp256k1_scalar *message, size_t n);
+static int secp256k1_ecdsa_sig_verify_prepared(const secp256k1_ecmult_context *ctx, const secp256k1_scalar* r, const secp256k1_scalar* s, const secp256k1_ecmult_prepared_point *pubkey, const secp256k1_scalar *message);
+/** Computes the lower-S form of s = (message + sigr*seckey) / nonce, given the inverse of
+ *  the nonce, and returns whether that negated s. */
+static int secp256k1_ecdsa_sig_sign_s(secp256k1_scalar *sigs, const secp256k1_scalar *sigr, const secp256k1_scalar *seckey, const secp256k1_scalar *message, const secp256k1_scalar *nonce_inv);
 static int secp256k1_ecdsa_sig_sign(const secp256k1_ecmult_gen_context *ctx, secp256k1_scalar* r, secp256k1_scalar* s, const secp256k1_scalar *seckey, const secp256k1_scalar *message, const secp256k1_scalar *nonce, int *recid);
 
 #endif /* SECP256K1_ECDSA_H */
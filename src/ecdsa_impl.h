@@ -204,25 +204,28 @@ static int secp256k1_ecdsa_sig_serialize(unsigned char *sig, size_t *size, const
     return 1;
 }
 
-static int secp256k1_ecdsa_sig_verify(const secp256k1_ecmult_context *ctx, const secp256k1_scalar *sigr, const secp256k1_scalar *sigs, const secp256k1_ge *pubkey, const secp256k1_scalar *message) {
-    unsigned char c[32];
-    secp256k1_scalar sn, u1, u2;
-#if !defined(EXHAUSTIVE_TEST_ORDER)
-    secp256k1_fe xr;
-#endif
-    secp256k1_gej pubkeyj;
-    secp256k1_gej pr;
+/* Compute u1 = message/s and u2 = r/s. Returns 0 if r or s is zero. */
+static int secp256k1_ecdsa_sig_verify_scalars(secp256k1_scalar *u1, secp256k1_scalar *u2, const secp256k1_scalar *sigr, const secp256k1_scalar *sigs, const secp256k1_scalar *message) {
+    secp256k1_scalar sn;
 
     if (secp256k1_scalar_is_zero(sigr) || secp256k1_scalar_is_zero(sigs)) {
         return 0;
     }
 
     secp256k1_scalar_inverse_var(&sn, sigs);
-    secp256k1_scalar_mul(&u1, &sn, message);
-    secp256k1_scalar_mul(&u2, &sn, sigr);
-    secp256k1_gej_set_ge(&pubkeyj, pubkey);
-    secp256k1_ecmult(ctx, &pr, &pubkeyj, &u2, &u1);
-    if (secp256k1_gej_is_infinity(&pr)) {
+    secp256k1_scalar_mul(u1, &sn, message);
+    secp256k1_scalar_mul(u2, &sn, sigr);
+    return 1;
+}
+
+/* Check that pr = u1*G + u2*pubkey is the R point claimed by sigr. */
+static int secp256k1_ecdsa_sig_check_r(const secp256k1_scalar *sigr, const secp256k1_gej *pr) {
+    unsigned char c[32];
+#if !defined(EXHAUSTIVE_TEST_ORDER)
+    secp256k1_fe xr;
+#endif
+
+    if (secp256k1_gej_is_infinity(pr)) {
         return 0;
     }
 
@@ -230,7 +233,8 @@ static int secp256k1_ecdsa_sig_verify(const secp256k1_ecmult_context *ctx, const
 {
     secp256k1_scalar computed_r;
     secp256k1_ge pr_ge;
-    secp256k1_ge_set_gej(&pr_ge, &pr);
+    secp256k1_gej prj = *pr;
+    secp256k1_ge_set_gej(&pr_ge, &prj);
     secp256k1_fe_normalize(&pr_ge.x);
 
     secp256k1_fe_get_b32(c, &pr_ge.x);
@@ -257,7 +261,7 @@ static int secp256k1_ecdsa_sig_verify(const secp256k1_ecmult_context *ctx, const
      *  Thus, we can avoid the inversion, but we have to check both cases separately.
      *  secp256k1_gej_eq_x implements the (xr * pr.z^2 mod p == pr.x) test.
      */
-    if (secp256k1_gej_eq_x_var(&xr, &pr)) {
+    if (secp256k1_gej_eq_x_var(&xr, pr)) {
         /* xr * pr.z^2 mod p == pr.x, so the signature is valid. */
         return 1;
     }
@@ -266,7 +270,7 @@ static int secp256k1_ecdsa_sig_verify(const secp256k1_ecmult_context *ctx, const
         return 0;
     }
     secp256k1_fe_add(&xr, &secp256k1_ecdsa_const_order_as_fe);
-    if (secp256k1_gej_eq_x_var(&xr, &pr)) {
+    if (secp256k1_gej_eq_x_var(&xr, pr)) {
         /* (xr + n) * pr.z^2 mod p == pr.x, so the signature is valid. */
         return 1;
     }
@@ -274,6 +278,73 @@ static int secp256k1_ecdsa_sig_verify(const secp256k1_ecmult_context *ctx, const
 #endif
 }
 
+static int secp256k1_ecdsa_sig_verify(const secp256k1_ecmult_context *ctx, const secp256k1_scalar *sigr, const secp256k1_scalar *sigs, const secp256k1_ge *pubkey, const secp256k1_scalar *message) {
+    secp256k1_scalar u1, u2;
+    secp256k1_gej pubkeyj;
+    secp256k1_gej pr;
+
+    if (!secp256k1_ecdsa_sig_verify_scalars(&u1, &u2, sigr, sigs, message)) {
+        return 0;
+    }
+    secp256k1_gej_set_ge(&pubkeyj, pubkey);
+    secp256k1_ecmult(ctx, &pr, &pubkeyj, &u2, &u1);
+    return secp256k1_ecdsa_sig_check_r(sigr, &pr);
+}
+
+static void secp256k1_ecdsa_sig_verify_lanes(const secp256k1_ecmult_context *ctx, int *valid, const secp256k1_scalar *sigr, const secp256k1_scalar *sigs, const secp256k1_ge *pubkey, const secp256k1_scalar *message, size_t n) {
+    secp256k1_scalar s[ECMULT_LANES], sn[ECMULT_LANES], u1[ECMULT_LANES], u2[ECMULT_LANES];
+    secp256k1_gej pubkeyj[ECMULT_LANES], pr[ECMULT_LANES];
+    size_t sig_idx[ECMULT_LANES];
+    size_t i, k = 0;
+
+    VERIFY_CHECK(n <= ECMULT_LANES);
+    for (i = 0; i < n; i++) {
+        valid[i] = 0;
+        if (secp256k1_scalar_is_zero(&sigr[i]) || secp256k1_scalar_is_zero(&sigs[i])) {
+            continue;
+        }
+        sig_idx[k] = i;
+        s[k] = sigs[i];
+        k++;
+    }
+
+    /* One inversion for all lanes. */
+    secp256k1_scalar_inverse_all_var(sn, s, k);
+    for (i = 0; i < k; i++) {
+        secp256k1_scalar_mul(&u1[i], &sn[i], &message[sig_idx[i]]);
+        secp256k1_scalar_mul(&u2[i], &sn[i], &sigr[sig_idx[i]]);
+        secp256k1_gej_set_ge(&pubkeyj[i], &pubkey[sig_idx[i]]);
+    }
+    secp256k1_ecmult_lanes(ctx, pr, pubkeyj, u2, u1, k);
+    for (i = 0; i < k; i++) {
+        valid[sig_idx[i]] = secp256k1_ecdsa_sig_check_r(&sigr[sig_idx[i]], &pr[i]);
+    }
+}
+
+static int secp256k1_ecdsa_sig_verify_prepared(const secp256k1_ecmult_context *ctx, const secp256k1_scalar *sigr, const secp256k1_scalar *sigs, const secp256k1_ecmult_prepared_point *pubkey, const secp256k1_scalar *message) {
+    secp256k1_scalar u1, u2;
+    secp256k1_gej pr;
+
+    if (!secp256k1_ecdsa_sig_verify_scalars(&u1, &u2, sigr, sigs, message)) {
+        return 0;
+    }
+    secp256k1_ecmult_prepared(ctx, &pr, pubkey, &u2, &u1);
+    return secp256k1_ecdsa_sig_check_r(sigr, &pr);
+}
+
+static int secp256k1_ecdsa_sig_sign_s(secp256k1_scalar *sigs, const secp256k1_scalar *sigr, const secp256k1_scalar *seckey, const secp256k1_scalar *message, const secp256k1_scalar *nonce_inv) {
+    secp256k1_scalar n;
+    int high;
+
+    secp256k1_scalar_mul(&n, sigr, seckey);
+    secp256k1_scalar_add(&n, &n, message);
+    secp256k1_scalar_mul(sigs, nonce_inv, &n);
+    secp256k1_scalar_clear(&n);
+    high = secp256k1_scalar_is_high(sigs);
+    secp256k1_scalar_cond_negate(sigs, high);
+    return high;
+}
+
 static int secp256k1_ecdsa_sig_sign(const secp256k1_ecmult_gen_context *ctx, secp256k1_scalar *sigr, secp256k1_scalar *sigs, const secp256k1_scalar *seckey, const secp256k1_scalar *message, const secp256k1_scalar *nonce, int *recid) {
     unsigned char b[32];
     secp256k1_gej rp;
@@ -294,15 +365,11 @@ static int secp256k1_ecdsa_sig_sign(const secp256k1_ecmult_gen_context *ctx, sec
          */
         *recid = (overflow << 1) | secp256k1_fe_is_odd(&r.y);
     }
-    secp256k1_scalar_mul(&n, sigr, seckey);
-    secp256k1_scalar_add(&n, &n, message);
-    secp256k1_scalar_inverse(sigs, nonce);
-    secp256k1_scalar_mul(sigs, sigs, &n);
+    secp256k1_scalar_inverse(&n, nonce);
+    high = secp256k1_ecdsa_sig_sign_s(sigs, sigr, seckey, message, &n);
     secp256k1_scalar_clear(&n);
     secp256k1_gej_clear(&rp);
     secp256k1_ge_clear(&r);
-    high = secp256k1_scalar_is_high(sigs);
-    secp256k1_scalar_cond_negate(sigs, high);
     if (recid) {
             *recid ^= high;
     }
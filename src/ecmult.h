@@ -12,22 +12,162 @@
 #include "scalar.h"
 #include "scratch.h"
 
+#if defined(EXHAUSTIVE_TEST_ORDER)
+/* We need to lower these values for exhaustive tests because
+ * the tables cannot have infinities in them (this breaks the
+ * affine-isomorphism stuff which tracks z-ratios) */
+#  if EXHAUSTIVE_TEST_ORDER > 128
+#    define WINDOW_A 5
+#    define WINDOW_G 8
+#  elif EXHAUSTIVE_TEST_ORDER > 8
+#    define WINDOW_A 4
+#    define WINDOW_G 4
+#  else
+#    define WINDOW_A 2
+#    define WINDOW_G 2
+#  endif
+#else
+/** Window for the points that are not known in advance. Every multiplication
+ *  builds a table of 2^(WINDOW_A-2) multiples of such a point, so a larger
+ *  window only pays off if the additions it saves outweigh the table, which
+ *  the default (5) is optimal for with 128-bit scalars. */
+#  ifndef ECMULT_WINDOW_A
+#    define ECMULT_WINDOW_A 5
+#  endif
+#  define WINDOW_A ECMULT_WINDOW_A
+/** Larger values for ECMULT_WINDOW_SIZE result in possibly better
+ *  performance at the cost of an exponentially larger precomputed
+ *  table. The exact table size is
+ *      (1 << (WINDOW_G - 2)) * sizeof(secp256k1_ge_storage)  bytes,
+ *  where sizeof(secp256k1_ge_storage) is typically 64 bytes but can
+ *  be larger due to platform-specific padding and alignment.
+ *  Two tables of this size are used (due to the endomorphism
+ *  optimization), or one with USE_ECMULT_COMPACT_VERIFY_TABLE.
+ */
+#  define WINDOW_G ECMULT_WINDOW_SIZE
+#endif
+
+/** The number of precomputed tables of multiples of G. By default, ng is split
+ *  into ng_1 + ng_128*2^128 and there is a table for G and one for 2^128*G. With
+ *  USE_ECMULT_COMPACT_VERIFY_TABLE, ng is split into ng_1 + ng_128*lambda instead,
+ *  and the multiples of lambda*G are derived from those of G with
+ *  secp256k1_ge_mul_lambda, which halves the memory for one field multiplication
+ *  per lookup and a costlier split. */
+#ifdef USE_ECMULT_COMPACT_VERIFY_TABLE
+#  define ECMULT_G_TABLES 1
+#else
+#  define ECMULT_G_TABLES 2
+#endif
+
+/** The number of entries a table with precomputed multiples needs to have. */
+#define ECMULT_TABLE_SIZE(w) (1 << ((w)-2))
+
 typedef struct {
     /* For accelerating the computation of a*P + b*G: */
     secp256k1_ge_storage (*pre_g)[];    /* odd multiples of the generator */
+#ifndef USE_ECMULT_COMPACT_VERIFY_TABLE
     secp256k1_ge_storage (*pre_g_128)[]; /* odd multiples of 2^128*generator */
+#endif
+    int external; /* tables live in memory not owned by the context */
 } secp256k1_ecmult_context;
 
 static const size_t SECP256K1_ECMULT_CONTEXT_PREALLOCATED_SIZE;
+/** Size of the serialized tables: a 64-byte header followed by pre_g and (unless
+ *  USE_ECMULT_COMPACT_VERIFY_TABLE) pre_g_128. */
+static const size_t SECP256K1_ECMULT_CONTEXT_SERIALIZED_SIZE;
 static void secp256k1_ecmult_context_init(secp256k1_ecmult_context *ctx);
 static void secp256k1_ecmult_context_build(secp256k1_ecmult_context *ctx, void **prealloc);
-static void secp256k1_ecmult_context_finalize_memcpy(secp256k1_ecmult_context *dst, const secp256k1_ecmult_context *src);
+/** Make dst a copy of src, copying the tables (if src owns them) into the preallocated memory at *prealloc. */
+static void secp256k1_ecmult_context_clone(secp256k1_ecmult_context *dst, const secp256k1_ecmult_context *src, void **prealloc);
+/** Make dst a copy of src that refers to the tables of src instead of owning them. */
+static void secp256k1_ecmult_context_share(secp256k1_ecmult_context *dst, const secp256k1_ecmult_context *src);
 static void secp256k1_ecmult_context_clear(secp256k1_ecmult_context *ctx);
 static int secp256k1_ecmult_context_is_built(const secp256k1_ecmult_context *ctx);
+static int secp256k1_ecmult_context_is_external(const secp256k1_ecmult_context *ctx);
+
+/** Write the tables of a built context to output, which must hold
+ *  SECP256K1_ECMULT_CONTEXT_SERIALIZED_SIZE bytes. */
+static void secp256k1_ecmult_context_serialize(const secp256k1_ecmult_context *ctx, unsigned char *output);
+
+/** Point an unbuilt context at tables serialized by secp256k1_ecmult_context_serialize,
+ *  without copying them. input must stay valid and unmodified while ctx (or a copy of it)
+ *  is in use. Returns 0 if the header or checksum does not match this build. */
+static int secp256k1_ecmult_context_load(secp256k1_ecmult_context *ctx, const unsigned char *input);
 
 /** Double multiply: R = na*A + ng*G */
 static void secp256k1_ecmult(const secp256k1_ecmult_context *ctx, secp256k1_gej *r, const secp256k1_gej *a, const secp256k1_scalar *na, const secp256k1_scalar *ng);
 
+/** Triple multiply: R = na*A + nb*B + ng*G. The three terms share their doublings,
+ *  which makes this cheaper than two calls to secp256k1_ecmult, and like
+ *  secp256k1_ecmult it needs no scratch space. ng may be NULL. */
+static void secp256k1_ecmult_3(const secp256k1_ecmult_context *ctx, secp256k1_gej *r, const secp256k1_gej *a, const secp256k1_scalar *na, const secp256k1_gej *b, const secp256k1_scalar *nb, const secp256k1_scalar *ng);
+
+/** The number of points secp256k1_ecmult_small handles at once. Its state takes about
+ *  4 kB of stack per point (with WINDOW_A 5), so builds for small stacks may lower it. */
+#ifndef ECMULT_SMALL_MAX_POINTS
+#  define ECMULT_SMALL_MAX_POINTS 16
+#endif
+
+/** Multi-multiply for small batches: R = sum_i na[i]*A[i] + ng*G, with the Strauss
+ *  algorithm and all of its state on the stack, so that unlike secp256k1_ecmult_multi_var
+ *  it needs no scratch space or callback. More than ECMULT_SMALL_MAX_POINTS points are
+ *  split into several multiplications. ng may be NULL. */
+static void secp256k1_ecmult_small(const secp256k1_ecmult_context *ctx, secp256k1_gej *r, const secp256k1_gej *a, const secp256k1_scalar *na, size_t num, const secp256k1_scalar *ng);
+
+/** The number of independent multiplications secp256k1_ecmult_lanes runs in lockstep. */
+#define ECMULT_LANES 4
+
+/** Independent double multiplies: r[i] = na[i]*A[i] + ng[i]*G for i < n, with n at most
+ *  ECMULT_LANES. The multiplications run in lockstep, sharing the Z of their tables and
+ *  the pass over the G tables, which is faster than n calls to secp256k1_ecmult. */
+static void secp256k1_ecmult_lanes(const secp256k1_ecmult_context *ctx, secp256k1_gej *r, const secp256k1_gej *a, const secp256k1_scalar *na, const secp256k1_scalar *ng, size_t n);
+
+/** Window of the tables of a fixed point, see secp256k1_ecmult_point_table. */
+#if defined(EXHAUSTIVE_TEST_ORDER)
+#  define ECMULT_POINT_TABLE_WINDOW 2
+#else
+#  define ECMULT_POINT_TABLE_WINDOW 12
+#endif
+#define ECMULT_POINT_TABLE_SIZE (1 << (ECMULT_POINT_TABLE_WINDOW - 2))
+
+/** Odd multiples of a fixed point P, stored like the context's pre_g, so that
+ *  multiples of P can be computed about as fast as multiples of G. The odd
+ *  multiples of lambda*P are derived from them with secp256k1_ge_mul_lambda. */
+typedef struct {
+    secp256k1_ge_storage pre[ECMULT_POINT_TABLE_SIZE];
+} secp256k1_ecmult_point_table;
+
+/** Fill table with the odd multiples of a, which must not be infinity. */
+static void secp256k1_ecmult_point_table_build(secp256k1_ecmult_point_table *table, const secp256k1_ge *a);
+
+/** Multi-multiply with fixed points: R = sum_i na[i]*P_i + ng*G, where tables[i] holds
+ *  the multiples of P_i. ng may be NULL. */
+static void secp256k1_ecmult_point_tables(const secp256k1_ecmult_context *ctx, secp256k1_gej *r, const secp256k1_ecmult_point_table * const *tables, const secp256k1_scalar *na, size_t num, const secp256k1_scalar *ng);
+
+/** Window of the tables of a prepared point. Unlike the tables secp256k1_ecmult builds
+ *  for every call, these are built once and reused, so a window wider than WINDOW_A
+ *  pays off: at 6 a multiplication needs about 4% fewer field operations than at 5, for
+ *  twice the memory (2 kB per point). */
+#if defined(EXHAUSTIVE_TEST_ORDER)
+#  define ECMULT_PREPARED_WINDOW WINDOW_A
+#elif !defined(ECMULT_PREPARED_WINDOW)
+#  define ECMULT_PREPARED_WINDOW 6
+#endif
+
+/** Odd multiples of a point P and of lambda*P, like those secp256k1_ecmult builds for
+ *  every call for its variable point but in the window ECMULT_PREPARED_WINDOW; keeping
+ *  them affine lets repeated multiplications of the same P skip that work. */
+typedef struct {
+    secp256k1_ge_storage pre_a[ECMULT_TABLE_SIZE(ECMULT_PREPARED_WINDOW)];
+    secp256k1_ge_storage pre_a_lam[ECMULT_TABLE_SIZE(ECMULT_PREPARED_WINDOW)];
+} secp256k1_ecmult_prepared_point;
+
+/** Fill prep with the tables of a, which must not be infinity. */
+static void secp256k1_ecmult_prepared_point_build(secp256k1_ecmult_prepared_point *prep, const secp256k1_ge *a);
+
+/** Double multiply with a prepared point: R = na*A + ng*G, where prep holds the tables of A. */
+static void secp256k1_ecmult_prepared(const secp256k1_ecmult_context *ctx, secp256k1_gej *r, const secp256k1_ecmult_prepared_point *prep, const secp256k1_scalar *na, const secp256k1_scalar *ng);
+
 typedef int (secp256k1_ecmult_multi_callback)(secp256k1_scalar *sc, secp256k1_ge *pt, size_t idx, void *data);
 
 /**
@@ -43,4 +183,24 @@ typedef int (secp256k1_ecmult_multi_callback)(secp256k1_scalar *sc, secp256k1_ge
  */
 static int secp256k1_ecmult_multi_var(const secp256k1_callback* error_callback, const secp256k1_ecmult_context *ctx, secp256k1_scratch *scratch, secp256k1_gej *r, const secp256k1_scalar *inp_g_sc, secp256k1_ecmult_multi_callback cb, void *cbdata, size_t n);
 
+/** Maximum number of tasks secp256k1_ecmult_multi_parallel_var splits the input into. */
+#define ECMULT_MAX_PARALLEL_TASKS 1024
+
+/** Runs task(i, task_data) for every i in [0, n_tasks), possibly concurrently.
+ *  Returns 1 once all tasks have finished, 0 if they could not be run. */
+typedef int (secp256k1_ecmult_multi_runner)(void (*task)(size_t idx, void *task_data), void *task_data, size_t n_tasks, void *data);
+
+/**
+ * Parallel multi-multiply: R = inp_g_sc * G + sum_i ni * Ai.
+ * Splits the points into up to n_tasks contiguous slices, gives every slice
+ * an equal share of the scratch space and hands the slices to runner, which
+ * may process them concurrently. The partial results are added up once all
+ * tasks finished. cb must be safe to call concurrently. Falls back to
+ * secp256k1_ecmult_multi_var if scratch is NULL, there is only a single slice,
+ * or the scratch space cannot hold the per-task bookkeeping.
+ * Returns: 1 on success (including when inp_g_sc is NULL and n is 0)
+ *          0 if runner or a callback returns 0
+ */
+static int secp256k1_ecmult_multi_parallel_var(const secp256k1_callback* error_callback, const secp256k1_ecmult_context *ctx, secp256k1_scratch *scratch, secp256k1_gej *r, const secp256k1_scalar *inp_g_sc, secp256k1_ecmult_multi_callback cb, void *cbdata, size_t n, size_t n_tasks, secp256k1_ecmult_multi_runner runner, void *runner_data);
+
 #endif /* SECP256K1_ECMULT_H */
@@ -17,4 +17,13 @@
  */
 static void secp256k1_ecmult_const(secp256k1_gej *r, const secp256k1_ge *a, const secp256k1_scalar *q, int bits);
 
+/**
+ * Multiply: r = x(q*A) (in constant-time with respect to q), where A is a point with
+ * x coordinate `x`. Only the x coordinate of A is used, and only the x coordinate of the
+ * result is computed, so neither a square root on input nor a y coordinate on output is
+ * needed. Returns 0 if `x` is not the x coordinate of a point on the curve (this check
+ * is variable time in `x`, and skipped if `known_on_curve` is set).
+ */
+static int secp256k1_ecmult_const_xonly(secp256k1_fe *r, const secp256k1_fe *x, const secp256k1_scalar *q, int bits, int known_on_curve);
+
 #endif /* SECP256K1_ECMULT_CONST_H */
@@ -12,6 +12,20 @@
 #include "ecmult_const.h"
 #include "ecmult_impl.h"
 
+/* The window of the constant-time multiplication. A larger window means fewer
+ * additions, but every digit scans the whole table of 2^(ECMULT_CONST_WINDOW-2)
+ * points, so the optimum depends on the relative cost of additions and memory. */
+#if defined(EXHAUSTIVE_TEST_ORDER)
+/* The table cannot have infinities in it, see WINDOW_A. */
+#  undef ECMULT_CONST_WINDOW
+#  define ECMULT_CONST_WINDOW WINDOW_A
+#elif !defined(ECMULT_CONST_WINDOW)
+#  define ECMULT_CONST_WINDOW 5
+#endif
+#if ECMULT_CONST_WINDOW < 2 || ECMULT_CONST_WINDOW > 8
+#  error Set ECMULT_CONST_WINDOW to an integer in range [2..8]
+#endif
+
 /* This is like `ECMULT_TABLE_GET_GE` but is constant time */
 #define ECMULT_CONST_TABLE_GET_GE(r,pre,n,w) do { \
     int m = 0; \
@@ -134,33 +148,59 @@ static int secp256k1_wnaf_const(int *wnaf, const secp256k1_scalar *scalar, int w
     return skew;
 }
 
-static void secp256k1_ecmult_const(secp256k1_gej *r, const secp256k1_ge *a, const secp256k1_scalar *scalar, int size) {
-    secp256k1_ge pre_a[ECMULT_TABLE_SIZE(WINDOW_A)];
-    secp256k1_ge tmpa;
-    secp256k1_fe Z;
+/** Like secp256k1_ecmult_odd_multiples_table_globalz_windowa, for ECMULT_CONST_WINDOW. */
+static void secp256k1_ecmult_const_odd_multiples_table_globalz(secp256k1_ge *pre, secp256k1_fe *globalz, const secp256k1_gej *a) {
+    secp256k1_gej prej[ECMULT_TABLE_SIZE(ECMULT_CONST_WINDOW)];
+    secp256k1_fe zr[ECMULT_TABLE_SIZE(ECMULT_CONST_WINDOW)];
 
+    secp256k1_ecmult_odd_multiples_table(ECMULT_TABLE_SIZE(ECMULT_CONST_WINDOW), prej, zr, a);
+    secp256k1_ge_globalz_set_table_gej(ECMULT_TABLE_SIZE(ECMULT_CONST_WINDOW), pre, globalz, prej, zr);
+}
+
+/** The wNAF digits of a scalar for secp256k1_ecmult_const, kept so that a scalar which
+ *  multiplies several points is only decomposed once. */
+typedef struct {
+    int wnaf_1[1 + WNAF_SIZE(ECMULT_CONST_WINDOW - 1)];
+    int wnaf_lam[1 + WNAF_SIZE(ECMULT_CONST_WINDOW - 1)];
     int skew_1;
-    secp256k1_ge pre_a_lam[ECMULT_TABLE_SIZE(WINDOW_A)];
-    int wnaf_lam[1 + WNAF_SIZE(WINDOW_A - 1)];
     int skew_lam;
-    secp256k1_scalar q_1, q_lam;
-    int wnaf_1[1 + WNAF_SIZE(WINDOW_A - 1)];
+    int size;
+} secp256k1_ecmult_const_digits;
 
-    int i;
+static void secp256k1_ecmult_const_digits_init(secp256k1_ecmult_const_digits *d, const secp256k1_scalar *scalar, int size) {
+    secp256k1_scalar q_1, q_lam;
 
-    /* build wnaf representation for q. */
-    int rsize = size;
+    d->size = size;
     if (size > 128) {
-        rsize = 128;
         /* split q into q_1 and q_lam (where q = q_1 + q_lam*lambda, and q_1 and q_lam are ~128 bit) */
         secp256k1_scalar_split_lambda(&q_1, &q_lam, scalar);
-        skew_1   = secp256k1_wnaf_const(wnaf_1,   &q_1,   WINDOW_A - 1, 128);
-        skew_lam = secp256k1_wnaf_const(wnaf_lam, &q_lam, WINDOW_A - 1, 128);
+        d->skew_1   = secp256k1_wnaf_const(d->wnaf_1,   &q_1,   ECMULT_CONST_WINDOW - 1, 128);
+        d->skew_lam = secp256k1_wnaf_const(d->wnaf_lam, &q_lam, ECMULT_CONST_WINDOW - 1, 128);
+        secp256k1_scalar_clear(&q_1);
+        secp256k1_scalar_clear(&q_lam);
     } else
     {
-        skew_1   = secp256k1_wnaf_const(wnaf_1, scalar, WINDOW_A - 1, size);
-        skew_lam = 0;
+        d->skew_1   = secp256k1_wnaf_const(d->wnaf_1, scalar, ECMULT_CONST_WINDOW - 1, size);
+        d->skew_lam = 0;
     }
+}
+
+/** Multiply: R = q*A (in constant-time), with q given by its digits. */
+static void secp256k1_ecmult_const_with_digits(secp256k1_gej *r, const secp256k1_ge *a, const secp256k1_ecmult_const_digits *d) {
+    secp256k1_ge pre_a[ECMULT_TABLE_SIZE(ECMULT_CONST_WINDOW)];
+    secp256k1_ge tmpa;
+    secp256k1_fe Z;
+
+    secp256k1_ge pre_a_lam[ECMULT_TABLE_SIZE(ECMULT_CONST_WINDOW)];
+    const int *wnaf_1 = d->wnaf_1;
+    const int *wnaf_lam = d->wnaf_lam;
+    int skew_1 = d->skew_1;
+    int skew_lam = d->skew_lam;
+    int size = d->size;
+
+    int i;
+
+    int rsize = size > 128 ? 128 : size;
 
     /* Calculate odd multiples of a.
      * All multiples are brought to the same Z 'denominator', which is stored
@@ -169,12 +209,12 @@ static void secp256k1_ecmult_const(secp256k1_gej *r, const secp256k1_ge *a, cons
      * the Z coordinate of the result once at the end.
      */
     secp256k1_gej_set_ge(r, a);
-    secp256k1_ecmult_odd_multiples_table_globalz_windowa(pre_a, &Z, r);
-    for (i = 0; i < ECMULT_TABLE_SIZE(WINDOW_A); i++) {
+    secp256k1_ecmult_const_odd_multiples_table_globalz(pre_a, &Z, r);
+    for (i = 0; i < ECMULT_TABLE_SIZE(ECMULT_CONST_WINDOW); i++) {
         secp256k1_fe_normalize_weak(&pre_a[i].y);
     }
     if (size > 128) {
-        for (i = 0; i < ECMULT_TABLE_SIZE(WINDOW_A); i++) {
+        for (i = 0; i < ECMULT_TABLE_SIZE(ECMULT_CONST_WINDOW); i++) {
             secp256k1_ge_mul_lambda(&pre_a_lam[i], &pre_a[i]);
         }
 
@@ -183,31 +223,31 @@ static void secp256k1_ecmult_const(secp256k1_gej *r, const secp256k1_ge *a, cons
     /* first loop iteration (separated out so we can directly set r, rather
      * than having it start at infinity, get doubled several times, then have
      * its new value added to it) */
-    i = wnaf_1[WNAF_SIZE_BITS(rsize, WINDOW_A - 1)];
+    i = wnaf_1[WNAF_SIZE_BITS(rsize, ECMULT_CONST_WINDOW - 1)];
     VERIFY_CHECK(i != 0);
-    ECMULT_CONST_TABLE_GET_GE(&tmpa, pre_a, i, WINDOW_A);
+    ECMULT_CONST_TABLE_GET_GE(&tmpa, pre_a, i, ECMULT_CONST_WINDOW);
     secp256k1_gej_set_ge(r, &tmpa);
     if (size > 128) {
-        i = wnaf_lam[WNAF_SIZE_BITS(rsize, WINDOW_A - 1)];
+        i = wnaf_lam[WNAF_SIZE_BITS(rsize, ECMULT_CONST_WINDOW - 1)];
         VERIFY_CHECK(i != 0);
-        ECMULT_CONST_TABLE_GET_GE(&tmpa, pre_a_lam, i, WINDOW_A);
+        ECMULT_CONST_TABLE_GET_GE(&tmpa, pre_a_lam, i, ECMULT_CONST_WINDOW);
         secp256k1_gej_add_ge(r, r, &tmpa);
     }
     /* remaining loop iterations */
-    for (i = WNAF_SIZE_BITS(rsize, WINDOW_A - 1) - 1; i >= 0; i--) {
+    for (i = WNAF_SIZE_BITS(rsize, ECMULT_CONST_WINDOW - 1) - 1; i >= 0; i--) {
         int n;
         int j;
-        for (j = 0; j < WINDOW_A - 1; ++j) {
+        for (j = 0; j < ECMULT_CONST_WINDOW - 1; ++j) {
             secp256k1_gej_double(r, r);
         }
 
         n = wnaf_1[i];
-        ECMULT_CONST_TABLE_GET_GE(&tmpa, pre_a, n, WINDOW_A);
+        ECMULT_CONST_TABLE_GET_GE(&tmpa, pre_a, n, ECMULT_CONST_WINDOW);
         VERIFY_CHECK(n != 0);
         secp256k1_gej_add_ge(r, r, &tmpa);
         if (size > 128) {
             n = wnaf_lam[i];
-            ECMULT_CONST_TABLE_GET_GE(&tmpa, pre_a_lam, n, WINDOW_A);
+            ECMULT_CONST_TABLE_GET_GE(&tmpa, pre_a_lam, n, ECMULT_CONST_WINDOW);
             VERIFY_CHECK(n != 0);
             secp256k1_gej_add_ge(r, r, &tmpa);
         }
@@ -251,4 +291,43 @@ static void secp256k1_ecmult_const(secp256k1_gej *r, const secp256k1_ge *a, cons
     }
 }
 
+static void secp256k1_ecmult_const(secp256k1_gej *r, const secp256k1_ge *a, const secp256k1_scalar *scalar, int size) {
+    secp256k1_ecmult_const_digits d;
+
+    secp256k1_ecmult_const_digits_init(&d, scalar, size);
+    secp256k1_ecmult_const_with_digits(r, a, &d);
+}
+
+static int secp256k1_ecmult_const_xonly(secp256k1_fe *r, const secp256k1_fe *x, const secp256k1_scalar *q, int bits, int known_on_curve) {
+    /* Let g = x^3 + 7. Instead of computing y = sqrt(g), note that the point
+     * (x*g, g^2) lies on the isomorphic curve y^2 = x^3 + 7*g^3, which maps to A
+     * via (X, Y) -> (X/g, Y/g^(3/2)) whenever g is a square. The group law formulas
+     * do not depend on the curve constant, so multiplying on the isomorphic curve
+     * and dividing the resulting x coordinate by g gives x(q*A). */
+    secp256k1_fe g, zz;
+    secp256k1_ge p;
+    secp256k1_gej rj;
+
+    secp256k1_fe_sqr(&g, x);
+    secp256k1_fe_mul(&g, &g, x);
+    secp256k1_fe_add(&g, &secp256k1_fe_const_b);
+    if (!known_on_curve && !secp256k1_fe_is_quad_var(&g)) {
+        return 0;
+    }
+
+    secp256k1_fe_mul(&p.x, x, &g);
+    secp256k1_fe_sqr(&p.y, &g);
+    p.infinity = 0;
+
+    secp256k1_ecmult_const(&rj, &p, q, bits);
+
+    /* r = X / (Z^2 * g), with a single inversion. */
+    secp256k1_fe_sqr(&zz, &rj.z);
+    secp256k1_fe_mul(&zz, &zz, &g);
+    secp256k1_fe_inv(&zz, &zz);
+    secp256k1_fe_mul(r, &rj.x, &zz);
+    secp256k1_fe_normalize(r);
+    return 1;
+}
+
 #endif /* SECP256K1_ECMULT_CONST_IMPL_H */
@@ -10,12 +10,30 @@
 #include "scalar.h"
 #include "group.h"
 
-#if ECMULT_GEN_PREC_BITS != 2 && ECMULT_GEN_PREC_BITS != 4 && ECMULT_GEN_PREC_BITS != 8
-#  error "Set ECMULT_GEN_PREC_BITS to 2, 4 or 8."
+#if defined(ECMULT_GEN_COMB_BLOCKS) && defined(ECMULT_GEN_COMB_TEETH) && !defined(EXHAUSTIVE_TEST_ORDER)
+/* The comb tables would contain the point at infinity for the tiny groups used
+ * by the exhaustive tests, so those always use the fixed-window method. */
+#  define USE_ECMULT_GEN_COMB 1
+#  if ECMULT_GEN_COMB_BLOCKS < 1 || ECMULT_GEN_COMB_BLOCKS > 64
+#    error "Set ECMULT_GEN_COMB_BLOCKS to an integer in range [1..64]."
+#  endif
+#  if ECMULT_GEN_COMB_TEETH < 1 || ECMULT_GEN_COMB_TEETH > 8
+#    error "Set ECMULT_GEN_COMB_TEETH to an integer in range [1..8]."
+#  endif
+/* The distance between the teeth of a comb, chosen such that all blocks together cover at least 256 bits. */
+#  define ECMULT_GEN_COMB_SPACING ((256 + ECMULT_GEN_COMB_BLOCKS * ECMULT_GEN_COMB_TEETH - 1) / (ECMULT_GEN_COMB_BLOCKS * ECMULT_GEN_COMB_TEETH))
+#  define ECMULT_GEN_COMB_BITS (ECMULT_GEN_COMB_BLOCKS * ECMULT_GEN_COMB_TEETH * ECMULT_GEN_COMB_SPACING)
+/* One row per block, one column per combination of signs of all but the top tooth. */
+#  define ECMULT_GEN_PREC_N ECMULT_GEN_COMB_BLOCKS
+#  define ECMULT_GEN_PREC_G (1 << (ECMULT_GEN_COMB_TEETH - 1))
+#else
+#  if ECMULT_GEN_PREC_BITS != 2 && ECMULT_GEN_PREC_BITS != 4 && ECMULT_GEN_PREC_BITS != 8
+#    error "Set ECMULT_GEN_PREC_BITS to 2, 4 or 8."
+#  endif
+#  define ECMULT_GEN_PREC_B ECMULT_GEN_PREC_BITS
+#  define ECMULT_GEN_PREC_G (1 << ECMULT_GEN_PREC_B)
+#  define ECMULT_GEN_PREC_N (256 / ECMULT_GEN_PREC_B)
 #endif
-#define ECMULT_GEN_PREC_B ECMULT_GEN_PREC_BITS
-#define ECMULT_GEN_PREC_G (1 << ECMULT_GEN_PREC_B)
-#define ECMULT_GEN_PREC_N (256 / ECMULT_GEN_PREC_B)
 
 typedef struct {
     /* For accelerating the computation of a*G:
@@ -29,22 +47,43 @@ typedef struct {
      * precomputed (call it prec(i, n_i)). The formula now becomes sum(prec(i, n_i), i=0 ... PREC_N-1).
      * None of the resulting prec group elements have a known scalar, and neither do any of
      * the intermediate sums while computing a*G.
+     *
+     * If USE_ECMULT_GEN_COMB is defined, a signed-digit multi-comb is used instead:
+     * * Write a = 2*d - (2^COMB_BITS - 1), i.e. a = sum((2*d_i - 1) * 2^i, i=0 ... COMB_BITS-1),
+     *   with d_i the bits of d = (a + 2^COMB_BITS - 1) / 2 (mod n).
+     * * The bits at positions (b*COMB_TEETH + t)*COMB_SPACING + c, t=0 ... COMB_TEETH-1, form
+     *   the teeth of block b at comb offset c. prec[b][m] is the sum of
+     *   (2*m_t - 1) * 2^((b*COMB_TEETH + t)*COMB_SPACING) * G over all teeth, where m_t is bit t
+     *   of m and the top tooth is always positive. Combinations with a negative top tooth are
+     *   obtained by negating the entry for the complementary bit pattern.
+     * * a*G is then computed with COMB_SPACING-1 doublings and COMB_BLOCKS additions per
+     *   comb offset. The intermediate sums are protected by the blinding below.
      */
-    secp256k1_ge_storage (*prec)[ECMULT_GEN_PREC_N][ECMULT_GEN_PREC_G]; /* prec[j][i] = (PREC_G)^j * i * G + U_i */
+    secp256k1_ge_storage (*prec)[ECMULT_GEN_PREC_N][ECMULT_GEN_PREC_G]; /* prec[j][i] = (PREC_G)^j * i * G + U_i, or the comb table */
     secp256k1_scalar blind;
     secp256k1_gej initial;
+    int external; /* prec lives in memory not owned by the context */
 } secp256k1_ecmult_gen_context;
 
 static const size_t SECP256K1_ECMULT_GEN_CONTEXT_PREALLOCATED_SIZE;
 static void secp256k1_ecmult_gen_context_init(secp256k1_ecmult_gen_context* ctx);
 static void secp256k1_ecmult_gen_context_build(secp256k1_ecmult_gen_context* ctx, void **prealloc);
-static void secp256k1_ecmult_gen_context_finalize_memcpy(secp256k1_ecmult_gen_context *dst, const secp256k1_ecmult_gen_context* src);
+/** Make dst a copy of src, copying the table (if src owns one) into the preallocated memory at *prealloc. */
+static void secp256k1_ecmult_gen_context_clone(secp256k1_ecmult_gen_context *dst, const secp256k1_ecmult_gen_context* src, void **prealloc);
+/** Make dst a copy of src that refers to the table of src instead of owning one. */
+static void secp256k1_ecmult_gen_context_share(secp256k1_ecmult_gen_context *dst, const secp256k1_ecmult_gen_context* src);
 static void secp256k1_ecmult_gen_context_clear(secp256k1_ecmult_gen_context* ctx);
 static int secp256k1_ecmult_gen_context_is_built(const secp256k1_ecmult_gen_context* ctx);
+static int secp256k1_ecmult_gen_context_is_external(const secp256k1_ecmult_gen_context* ctx);
 
 /** Multiply with the generator: R = a*G */
 static void secp256k1_ecmult_gen(const secp256k1_ecmult_gen_context* ctx, secp256k1_gej *r, const secp256k1_scalar *a);
 
 static void secp256k1_ecmult_gen_blind(secp256k1_ecmult_gen_context *ctx, const unsigned char *seed32);
 
+/** Update the blinding values without new randomness, for a fraction of the cost of
+ *  secp256k1_ecmult_gen_blind: the blinding point is doubled and its projection
+ *  rescaled by a factor derived from the blinding value. */
+static void secp256k1_ecmult_gen_reblind(secp256k1_ecmult_gen_context *ctx);
+
 #endif /* SECP256K1_ECMULT_GEN_H */
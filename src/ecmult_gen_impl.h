@@ -12,35 +12,94 @@
 #include "group.h"
 #include "ecmult_gen.h"
 #include "hash_impl.h"
+
+#ifdef ENABLE_VERIFY_ONLY
+#ifdef USE_ECMULT_STATIC_PRECOMPUTATION
+#error "A verification-only build has no table for signing to precompute."
+#endif
+
+/* A verification-only build never builds the table for the generator. Everything that
+ * needs it first checks secp256k1_ecmult_gen_context_is_built, which is constant 0
+ * here, so the compiler drops the signing code behind those checks along with the
+ * table computation and the blinding that would otherwise be compiled in. */
+static const size_t SECP256K1_ECMULT_GEN_CONTEXT_PREALLOCATED_SIZE = 0;
+
+static void secp256k1_ecmult_gen_context_init(secp256k1_ecmult_gen_context *ctx) {
+    ctx->prec = NULL;
+    ctx->external = 0;
+}
+
+static void secp256k1_ecmult_gen_context_build(secp256k1_ecmult_gen_context *ctx, void **prealloc) {
+    (void)ctx;
+    (void)prealloc;
+}
+
+static int secp256k1_ecmult_gen_context_is_built(const secp256k1_ecmult_gen_context* ctx) {
+    (void)ctx;
+    return 0;
+}
+
+static int secp256k1_ecmult_gen_context_is_external(const secp256k1_ecmult_gen_context* ctx) {
+    return ctx->external;
+}
+
+static void secp256k1_ecmult_gen_context_clone(secp256k1_ecmult_gen_context *dst, const secp256k1_ecmult_gen_context *src, void **prealloc) {
+    (void)prealloc;
+    *dst = *src;
+}
+
+static void secp256k1_ecmult_gen_context_share(secp256k1_ecmult_gen_context *dst, const secp256k1_ecmult_gen_context *src) {
+    *dst = *src;
+    dst->external = 1;
+}
+
+static void secp256k1_ecmult_gen_context_clear(secp256k1_ecmult_gen_context *ctx) {
+    ctx->prec = NULL;
+}
+
+static void secp256k1_ecmult_gen(const secp256k1_ecmult_gen_context *ctx, secp256k1_gej *r, const secp256k1_scalar *gn) {
+    (void)ctx;
+    (void)gn;
+    VERIFY_CHECK(0);
+    secp256k1_gej_set_infinity(r);
+}
+
+static void secp256k1_ecmult_gen_blind(secp256k1_ecmult_gen_context *ctx, const unsigned char *seed32) {
+    (void)ctx;
+    (void)seed32;
+}
+
+static void secp256k1_ecmult_gen_reblind(secp256k1_ecmult_gen_context *ctx) {
+    (void)ctx;
+}
+
+#else
+
+#ifdef USE_ECMULT_GEN_X86_AVX2
+#include "ecmult_gen_x86_avx2_impl.h"
+#endif
 #ifdef USE_ECMULT_STATIC_PRECOMPUTATION
 #include "ecmult_static_context.h"
 #endif
 
 #ifndef USE_ECMULT_STATIC_PRECOMPUTATION
-    static const size_t SECP256K1_ECMULT_GEN_CONTEXT_PREALLOCATED_SIZE = ROUND_TO_ALIGN(sizeof(*((secp256k1_ecmult_gen_context*) NULL)->prec));
+    static const size_t SECP256K1_ECMULT_GEN_CONTEXT_PREALLOCATED_SIZE = CACHE_ALIGNED_ALLOC_SIZE(sizeof(*((secp256k1_ecmult_gen_context*) NULL)->prec));
 #else
     static const size_t SECP256K1_ECMULT_GEN_CONTEXT_PREALLOCATED_SIZE = 0;
 #endif
 
 static void secp256k1_ecmult_gen_context_init(secp256k1_ecmult_gen_context *ctx) {
     ctx->prec = NULL;
+    ctx->external = 0;
 }
 
-static void secp256k1_ecmult_gen_context_build(secp256k1_ecmult_gen_context *ctx, void **prealloc) {
 #ifndef USE_ECMULT_STATIC_PRECOMPUTATION
+#ifndef USE_ECMULT_GEN_COMB
+static void secp256k1_ecmult_gen_compute_table(secp256k1_ge_storage (*table)[ECMULT_GEN_PREC_G]) {
     secp256k1_ge prec[ECMULT_GEN_PREC_N * ECMULT_GEN_PREC_G];
     secp256k1_gej gj;
     secp256k1_gej nums_gej;
     int i, j;
-    size_t const prealloc_size = SECP256K1_ECMULT_GEN_CONTEXT_PREALLOCATED_SIZE;
-    void* const base = *prealloc;
-#endif
-
-    if (ctx->prec != NULL) {
-        return;
-    }
-#ifndef USE_ECMULT_STATIC_PRECOMPUTATION
-    ctx->prec = (secp256k1_ge_storage (*)[ECMULT_GEN_PREC_N][ECMULT_GEN_PREC_G])manual_alloc(prealloc, prealloc_size, base, prealloc_size);
 
     /* get the generator */
     secp256k1_gej_set_ge(&gj, &secp256k1_ge_const_g);
@@ -91,9 +150,67 @@ static void secp256k1_ecmult_gen_context_build(secp256k1_ecmult_gen_context *ctx
     }
     for (j = 0; j < ECMULT_GEN_PREC_N; j++) {
         for (i = 0; i < ECMULT_GEN_PREC_G; i++) {
-            secp256k1_ge_to_storage(&(*ctx->prec)[j][i], &prec[j*ECMULT_GEN_PREC_G + i]);
+            secp256k1_ge_to_storage(&table[j][i], &prec[j*ECMULT_GEN_PREC_G + i]);
+        }
+    }
+}
+#else
+static void secp256k1_ecmult_gen_compute_table(secp256k1_ge_storage (*table)[ECMULT_GEN_PREC_G]) {
+    secp256k1_ge prec[ECMULT_GEN_PREC_N * ECMULT_GEN_PREC_G];
+    secp256k1_gej precj[ECMULT_GEN_PREC_N * ECMULT_GEN_PREC_G];
+    secp256k1_gej teeth[ECMULT_GEN_COMB_TEETH]; /* 2^((block*COMB_TEETH + t)*COMB_SPACING) * G */
+    secp256k1_gej teeth2[ECMULT_GEN_COMB_TEETH]; /* twice the above */
+    secp256k1_gej gj;
+    int block, tooth, m, i;
+
+    secp256k1_gej_set_ge(&gj, &secp256k1_ge_const_g);
+    for (block = 0; block < ECMULT_GEN_COMB_BLOCKS; block++) {
+        secp256k1_gej *row = &precj[block * ECMULT_GEN_PREC_G];
+        for (tooth = 0; tooth < ECMULT_GEN_COMB_TEETH; tooth++) {
+            teeth[tooth] = gj;
+            secp256k1_gej_double_var(&teeth2[tooth], &gj, NULL);
+            for (i = 0; i < ECMULT_GEN_COMB_SPACING; i++) {
+                secp256k1_gej_double_var(&gj, &gj, NULL);
+            }
+        }
+        /* All teeth but the top one negative. */
+        row[0] = teeth[ECMULT_GEN_COMB_TEETH - 1];
+        for (tooth = 0; tooth < ECMULT_GEN_COMB_TEETH - 1; tooth++) {
+            secp256k1_gej neg;
+            secp256k1_gej_neg(&neg, &teeth[tooth]);
+            secp256k1_gej_add_var(&row[0], &row[0], &neg, NULL);
+        }
+        /* Flipping the sign of tooth t from negative to positive adds 2 * teeth[t]. */
+        for (m = 1; m < ECMULT_GEN_PREC_G; m++) {
+            tooth = 0;
+            while ((m >> (tooth + 1)) != 0) {
+                tooth++;
+            }
+            secp256k1_gej_add_var(&row[m], &row[m ^ (1 << tooth)], &teeth2[tooth], NULL);
+        }
+    }
+    secp256k1_ge_set_all_gej_var(prec, precj, ECMULT_GEN_PREC_N * ECMULT_GEN_PREC_G);
+    for (block = 0; block < ECMULT_GEN_PREC_N; block++) {
+        for (m = 0; m < ECMULT_GEN_PREC_G; m++) {
+            secp256k1_ge_to_storage(&table[block][m], &prec[block * ECMULT_GEN_PREC_G + m]);
         }
     }
+}
+#endif
+#endif
+
+static void secp256k1_ecmult_gen_context_build(secp256k1_ecmult_gen_context *ctx, void **prealloc) {
+#ifndef USE_ECMULT_STATIC_PRECOMPUTATION
+    size_t const prealloc_size = SECP256K1_ECMULT_GEN_CONTEXT_PREALLOCATED_SIZE;
+    void* const base = *prealloc;
+#endif
+
+    if (ctx->prec != NULL) {
+        return;
+    }
+#ifndef USE_ECMULT_STATIC_PRECOMPUTATION
+    ctx->prec = (secp256k1_ge_storage (*)[ECMULT_GEN_PREC_N][ECMULT_GEN_PREC_G])manual_alloc_cache_aligned(prealloc, sizeof(*ctx->prec), base, prealloc_size);
+    secp256k1_ecmult_gen_compute_table(*ctx->prec);
 #else
     (void)prealloc;
     ctx->prec = (secp256k1_ge_storage (*)[ECMULT_GEN_PREC_N][ECMULT_GEN_PREC_G])secp256k1_ecmult_static_context;
@@ -105,49 +222,143 @@ static int secp256k1_ecmult_gen_context_is_built(const secp256k1_ecmult_gen_cont
     return ctx->prec != NULL;
 }
 
-static void secp256k1_ecmult_gen_context_finalize_memcpy(secp256k1_ecmult_gen_context *dst, const secp256k1_ecmult_gen_context *src) {
+static int secp256k1_ecmult_gen_context_is_external(const secp256k1_ecmult_gen_context* ctx) {
+    return ctx->external;
+}
+
+static void secp256k1_ecmult_gen_context_clone(secp256k1_ecmult_gen_context *dst, const secp256k1_ecmult_gen_context *src, void **prealloc) {
+#ifndef USE_ECMULT_STATIC_PRECOMPUTATION
+    size_t const prealloc_size = SECP256K1_ECMULT_GEN_CONTEXT_PREALLOCATED_SIZE;
+    void* const base = *prealloc;
+#endif
+
+    *dst = *src;
 #ifndef USE_ECMULT_STATIC_PRECOMPUTATION
-    if (src->prec != NULL) {
-        /* We cast to void* first to suppress a -Wcast-align warning. */
-        dst->prec = (secp256k1_ge_storage (*)[ECMULT_GEN_PREC_N][ECMULT_GEN_PREC_G])(void*)((unsigned char*)dst + ((unsigned char*)src->prec - (unsigned char*)src));
+    if (src->prec == NULL || src->external) {
+        /* There is no table to copy, or it is shared. */
+        return;
     }
+    dst->prec = (secp256k1_ge_storage (*)[ECMULT_GEN_PREC_N][ECMULT_GEN_PREC_G])manual_alloc_cache_aligned(prealloc, sizeof(*dst->prec), base, prealloc_size);
+    memcpy(dst->prec, src->prec, sizeof(*dst->prec));
 #else
-    (void)dst, (void)src;
+    (void)prealloc;
 #endif
 }
 
+static void secp256k1_ecmult_gen_context_share(secp256k1_ecmult_gen_context *dst, const secp256k1_ecmult_gen_context *src) {
+    *dst = *src;
+    /* The table is never written to after it has been built. */
+    dst->external = 1;
+}
+
 static void secp256k1_ecmult_gen_context_clear(secp256k1_ecmult_gen_context *ctx) {
     secp256k1_scalar_clear(&ctx->blind);
     secp256k1_gej_clear(&ctx->initial);
     ctx->prec = NULL;
 }
 
+/** Set *r to row[index] for a table row of ECMULT_GEN_PREC_G entries, in constant time. */
+static void secp256k1_ecmult_gen_table_get(secp256k1_ge_storage *r, const secp256k1_ge_storage *row, uint32_t index) {
+    uint32_t i;
+#ifdef USE_ECMULT_GEN_X86_AVX2
+    if (secp256k1_ecmult_gen_x86_avx2_available()) {
+        secp256k1_ecmult_gen_table_get_avx2(r, row, ECMULT_GEN_PREC_G, index);
+        return;
+    }
+#endif
+    memset(r, 0, sizeof(*r));
+    for (i = 0; i < ECMULT_GEN_PREC_G; i++) {
+        /** This uses a conditional move to avoid any secret data in array indexes.
+         *   _Any_ use of secret indexes has been demonstrated to result in timing
+         *   sidechannels, even when the cache-line access patterns are uniform.
+         *  See also:
+         *   "A word of warning", CHES 2013 Rump Session, by Daniel J. Bernstein and Peter Schwabe
+         *    (https://cryptojedi.org/peter/data/chesrump-20130822.pdf) and
+         *   "Cache Attacks and Countermeasures: the Case of AES", RSA 2006,
+         *    by Dag Arne Osvik, Adi Shamir, and Eran Tromer
+         *    (http://www.tau.ac.il/~tromer/papers/cache.pdf)
+         */
+        secp256k1_ge_storage_cmov(r, &row[i], i == index);
+    }
+}
+
+#ifdef USE_ECMULT_GEN_COMB
+/* (n+1)/2, the inverse of 2 modulo the group order. */
+static const secp256k1_scalar secp256k1_ecmult_gen_comb_half = SECP256K1_SCALAR_CONST(0x7FFFFFFFUL, 0xFFFFFFFFUL, 0xFFFFFFFFUL, 0xFFFFFFFFUL, 0x5D576E73UL, 0x57A4501DUL, 0xDFE92F46UL, 0x681B20A1UL);
+
+/* Set r = 2^k (mod n). */
+static void secp256k1_ecmult_gen_scalar_pow2(secp256k1_scalar *r, int k) {
+    secp256k1_scalar_set_int(r, 1);
+    while (k-- > 0) {
+        secp256k1_scalar_add(r, r, r);
+    }
+}
+
+static void secp256k1_ecmult_gen(const secp256k1_ecmult_gen_context *ctx, secp256k1_gej *r, const secp256k1_scalar *gn) {
+    uint32_t recoded[(ECMULT_GEN_COMB_BITS + 31) >> 5] = {0};
+    unsigned char d32[32];
+    secp256k1_ge add;
+    secp256k1_ge_storage adds;
+    secp256k1_fe neg_y;
+    secp256k1_scalar d;
+    uint32_t bits, sign, abs;
+    int block, tooth, comb_off, bit_pos, i;
+    *r = ctx->initial;
+    /* Blind scalar/point multiplication as below. The blinding value also contains the
+     * 2^COMB_BITS - 1 offset of the signed-digit representation, so that
+     * a*G = sum((2*d_i - 1) * 2^i * G, i=0 ... COMB_BITS-1) with d = (a + blind) / 2. */
+    secp256k1_scalar_add(&d, gn, &ctx->blind);
+    secp256k1_scalar_mul(&d, &d, &secp256k1_ecmult_gen_comb_half);
+    secp256k1_scalar_get_b32(d32, &d);
+    for (i = 0; i < 32; i++) {
+        recoded[i >> 2] |= (uint32_t)d32[31 - i] << ((i & 3) * 8);
+    }
+    add.infinity = 0;
+    comb_off = ECMULT_GEN_COMB_SPACING - 1;
+    for (;;) {
+        for (block = 0; block < ECMULT_GEN_COMB_BLOCKS; block++) {
+            bits = 0;
+            bit_pos = block * ECMULT_GEN_COMB_TEETH * ECMULT_GEN_COMB_SPACING + comb_off;
+            for (tooth = 0; tooth < ECMULT_GEN_COMB_TEETH; tooth++) {
+                bits |= ((recoded[bit_pos >> 5] >> (bit_pos & 31)) & 1) << tooth;
+                bit_pos += ECMULT_GEN_COMB_SPACING;
+            }
+            /* If the top tooth is negative, look up the complementary pattern and negate. */
+            sign = (bits >> (ECMULT_GEN_COMB_TEETH - 1)) & 1;
+            abs = (bits ^ (sign - 1)) & (ECMULT_GEN_PREC_G - 1);
+            secp256k1_ecmult_gen_table_get(&adds, (*ctx->prec)[block], abs);
+            secp256k1_ge_from_storage(&add, &adds);
+            secp256k1_fe_negate(&neg_y, &add.y, 1);
+            secp256k1_fe_cmov(&add.y, &neg_y, sign ^ 1);
+            secp256k1_gej_add_ge(r, r, &add);
+        }
+        if (comb_off-- == 0) {
+            break;
+        }
+        secp256k1_gej_double(r, r);
+    }
+    bits = 0;
+    sign = 0;
+    abs = 0;
+    memset(recoded, 0, sizeof(recoded));
+    memset(d32, 0, sizeof(d32));
+    secp256k1_ge_clear(&add);
+    secp256k1_scalar_clear(&d);
+}
+#else
 static void secp256k1_ecmult_gen(const secp256k1_ecmult_gen_context *ctx, secp256k1_gej *r, const secp256k1_scalar *gn) {
     secp256k1_ge add;
     secp256k1_ge_storage adds;
     secp256k1_scalar gnb;
     int bits;
-    int i, j;
-    memset(&adds, 0, sizeof(adds));
+    int j;
     *r = ctx->initial;
     /* Blind scalar/point multiplication by computing (n-b)G + bG instead of nG. */
     secp256k1_scalar_add(&gnb, gn, &ctx->blind);
     add.infinity = 0;
     for (j = 0; j < ECMULT_GEN_PREC_N; j++) {
         bits = secp256k1_scalar_get_bits(&gnb, j * ECMULT_GEN_PREC_B, ECMULT_GEN_PREC_B);
-        for (i = 0; i < ECMULT_GEN_PREC_G; i++) {
-            /** This uses a conditional move to avoid any secret data in array indexes.
-             *   _Any_ use of secret indexes has been demonstrated to result in timing
-             *   sidechannels, even when the cache-line access patterns are uniform.
-             *  See also:
-             *   "A word of warning", CHES 2013 Rump Session, by Daniel J. Bernstein and Peter Schwabe
-             *    (https://cryptojedi.org/peter/data/chesrump-20130822.pdf) and
-             *   "Cache Attacks and Countermeasures: the Case of AES", RSA 2006,
-             *    by Dag Arne Osvik, Adi Shamir, and Eran Tromer
-             *    (http://www.tau.ac.il/~tromer/papers/cache.pdf)
-             */
-            secp256k1_ge_storage_cmov(&adds, &(*ctx->prec)[j][i], i == bits);
-        }
+        secp256k1_ecmult_gen_table_get(&adds, (*ctx->prec)[j], bits);
         secp256k1_ge_from_storage(&add, &adds);
         secp256k1_gej_add_ge(r, r, &add);
     }
@@ -156,9 +367,15 @@ static void secp256k1_ecmult_gen(const secp256k1_ecmult_gen_context *ctx, secp25
     secp256k1_scalar_clear(&gnb);
 }
 
+#endif
+
 /* Setup blinding values for secp256k1_ecmult_gen. */
 static void secp256k1_ecmult_gen_blind(secp256k1_ecmult_gen_context *ctx, const unsigned char *seed32) {
     secp256k1_scalar b;
+#ifdef USE_ECMULT_GEN_COMB
+    secp256k1_scalar offset;
+    int i;
+#endif
     secp256k1_gej gb;
     secp256k1_fe s;
     unsigned char nonce32[32];
@@ -170,6 +387,15 @@ static void secp256k1_ecmult_gen_blind(secp256k1_ecmult_gen_context *ctx, const
         secp256k1_gej_set_ge(&ctx->initial, &secp256k1_ge_const_g);
         secp256k1_gej_neg(&ctx->initial, &ctx->initial);
         secp256k1_scalar_set_int(&ctx->blind, 1);
+#ifdef USE_ECMULT_GEN_COMB
+        /* The initial point gets doubled COMB_SPACING-1 times, which the blinding
+         * value has to compensate for. Also add the signed-digit offset. */
+        secp256k1_ecmult_gen_scalar_pow2(&ctx->blind, ECMULT_GEN_COMB_SPACING - 1);
+        secp256k1_ecmult_gen_scalar_pow2(&offset, ECMULT_GEN_COMB_BITS);
+        secp256k1_scalar_add(&ctx->blind, &ctx->blind, &offset);
+        secp256k1_scalar_negate(&offset, &secp256k1_scalar_one);
+        secp256k1_scalar_add(&ctx->blind, &ctx->blind, &offset);
+#endif
     }
     /* The prior blinding value (if not reset) is chained forward by including it in the hash. */
     secp256k1_scalar_get_b32(nonce32, &ctx->blind);
@@ -197,12 +423,71 @@ static void secp256k1_ecmult_gen_blind(secp256k1_ecmult_gen_context *ctx, const
     secp256k1_scalar_cmov(&b, &secp256k1_scalar_one, secp256k1_scalar_is_zero(&b));
     secp256k1_rfc6979_hmac_sha256_finalize(&rng);
     memset(nonce32, 0, 32);
+#ifdef USE_ECMULT_GEN_COMB
+    /* Compute gb = b*G / 2^(COMB_SPACING-1), so that it becomes b*G after the doublings. */
+    offset = b;
+    for (i = 0; i < ECMULT_GEN_COMB_SPACING - 1; i++) {
+        secp256k1_scalar_mul(&offset, &offset, &secp256k1_ecmult_gen_comb_half);
+    }
+    secp256k1_ecmult_gen(ctx, &gb, &offset);
+    secp256k1_scalar_negate(&b, &b);
+    secp256k1_ecmult_gen_scalar_pow2(&offset, ECMULT_GEN_COMB_BITS);
+    secp256k1_scalar_add(&b, &b, &offset);
+    secp256k1_scalar_negate(&offset, &secp256k1_scalar_one);
+    secp256k1_scalar_add(&b, &b, &offset);
+    secp256k1_scalar_clear(&offset);
+#else
     secp256k1_ecmult_gen(ctx, &gb, &b);
     secp256k1_scalar_negate(&b, &b);
+#endif
     ctx->blind = b;
     ctx->initial = gb;
     secp256k1_scalar_clear(&b);
     secp256k1_gej_clear(&gb);
 }
 
+static void secp256k1_ecmult_gen_reblind(secp256k1_ecmult_gen_context *ctx) {
+    static const unsigned char tag[16] = "ecmult_gen/blind";
+    secp256k1_sha256 sha;
+    secp256k1_scalar b;
+    secp256k1_fe s;
+    unsigned char buf[32];
+    int overflow;
+#ifdef USE_ECMULT_GEN_COMB
+    secp256k1_scalar offset;
+#endif
+
+    /* ecmult_gen relies on initial and blind together adding nothing to the result,
+     * which holds for multiples of both as long as the signed-digit offset included in
+     * blind (2^COMB_BITS - 1 for the comb, 0 otherwise) is kept out of the scaling:
+     * blind' - offset = 2*(blind - offset). */
+    secp256k1_gej_double(&ctx->initial, &ctx->initial);
+    secp256k1_scalar_add(&b, &ctx->blind, &ctx->blind);
+#ifdef USE_ECMULT_GEN_COMB
+    /* b = 2*blind - (2^COMB_BITS - 1) */
+    secp256k1_ecmult_gen_scalar_pow2(&offset, ECMULT_GEN_COMB_BITS);
+    secp256k1_scalar_negate(&offset, &offset);
+    secp256k1_scalar_add(&offset, &offset, &secp256k1_scalar_one);
+    secp256k1_scalar_add(&b, &b, &offset);
+    secp256k1_scalar_clear(&offset);
+#endif
+    ctx->blind = b;
+
+    secp256k1_sha256_initialize(&sha);
+    secp256k1_sha256_write(&sha, tag, sizeof(tag));
+    secp256k1_scalar_get_b32(buf, &b);
+    secp256k1_sha256_write(&sha, buf, 32);
+    secp256k1_sha256_finalize(&sha, buf);
+    overflow = !secp256k1_fe_set_b32(&s, buf);
+    overflow |= secp256k1_fe_is_zero(&s);
+    secp256k1_fe_cmov(&s, &secp256k1_fe_one, overflow);
+    secp256k1_gej_rescale(&ctx->initial, &s);
+
+    secp256k1_fe_clear(&s);
+    secp256k1_scalar_clear(&b);
+    memset(buf, 0, sizeof(buf));
+}
+
+#endif /* ENABLE_VERIFY_ONLY */
+
 #endif /* SECP256K1_ECMULT_GEN_IMPL_H */
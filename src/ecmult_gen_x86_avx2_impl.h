@@ -0,0 +1,52 @@
+/**********************************************************************
+ * Distributed under the MIT software license, see the accompanying   *
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
+ **********************************************************************/
+
+#ifndef SECP256K1_ECMULT_GEN_X86_AVX2_IMPL_H
+#define SECP256K1_ECMULT_GEN_X86_AVX2_IMPL_H
+
+/* Constant-time table scan for secp256k1_ecmult_gen using AVX2. A
+ * secp256k1_ge_storage is 64 bytes, i.e. two 256-bit registers, so each entry
+ * costs two loads and a masked OR instead of the eight word-sized cmovs of
+ * secp256k1_ge_storage_cmov. Every entry is read and the selection mask is
+ * computed with a vector compare, so neither the memory accesses nor the
+ * branches depend on the index.
+ *
+ * The code is compiled for the required ISA with a target attribute, and must
+ * only be called when secp256k1_ecmult_gen_x86_avx2_available returns 1. */
+
+#include <stdint.h>
+#include <immintrin.h>
+#include "cpu_impl.h"
+#include "group.h"
+
+#define SECP256K1_ECMULT_GEN_AVX2_TARGET __attribute__((target("avx2")))
+
+/** Returns whether the CPU supports AVX2 (with the YMM state saved by the OS). */
+static int secp256k1_ecmult_gen_x86_avx2_available(void) {
+    return secp256k1_cpu_x86_has(SECP256K1_CPU_X86_AVX2);
+}
+
+/** Set *r to row[index], reading all n entries of row. */
+SECP256K1_ECMULT_GEN_AVX2_TARGET
+static void secp256k1_ecmult_gen_table_get_avx2(secp256k1_ge_storage *r, const secp256k1_ge_storage *row, int n, uint32_t index) {
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i target = _mm256_set1_epi32((int)index);
+    __m256i cur = _mm256_setzero_si256();
+    __m256i x = _mm256_setzero_si256();
+    __m256i y = _mm256_setzero_si256();
+    int i;
+
+    VERIFY_CHECK(sizeof(secp256k1_ge_storage) == 64);
+    for (i = 0; i < n; i++) {
+        const __m256i mask = _mm256_cmpeq_epi32(cur, target);
+        x = _mm256_or_si256(x, _mm256_and_si256(mask, _mm256_loadu_si256((const __m256i*)&row[i])));
+        y = _mm256_or_si256(y, _mm256_and_si256(mask, _mm256_loadu_si256((const __m256i*)&row[i] + 1)));
+        cur = _mm256_add_epi32(cur, one);
+    }
+    _mm256_storeu_si256((__m256i*)r, x);
+    _mm256_storeu_si256((__m256i*)r + 1, y);
+}
+
+#endif /* SECP256K1_ECMULT_GEN_X86_AVX2_IMPL_H */
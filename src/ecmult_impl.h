@@ -14,35 +14,7 @@
 #include "group.h"
 #include "scalar.h"
 #include "ecmult.h"
-
-#if defined(EXHAUSTIVE_TEST_ORDER)
-/* We need to lower these values for exhaustive tests because
- * the tables cannot have infinities in them (this breaks the
- * affine-isomorphism stuff which tracks z-ratios) */
-#  if EXHAUSTIVE_TEST_ORDER > 128
-#    define WINDOW_A 5
-#    define WINDOW_G 8
-#  elif EXHAUSTIVE_TEST_ORDER > 8
-#    define WINDOW_A 4
-#    define WINDOW_G 4
-#  else
-#    define WINDOW_A 2
-#    define WINDOW_G 2
-#  endif
-#else
-/* optimal for 128-bit and 256-bit exponents. */
-#  define WINDOW_A 5
-/** Larger values for ECMULT_WINDOW_SIZE result in possibly better
- *  performance at the cost of an exponentially larger precomputed
- *  table. The exact table size is
- *      (1 << (WINDOW_G - 2)) * sizeof(secp256k1_ge_storage)  bytes,
- *  where sizeof(secp256k1_ge_storage) is typically 64 bytes but can
- *  be larger due to platform-specific padding and alignment.
- *  Two tables of this size are used (due to the endomorphism
- *  optimization).
- */
-#  define WINDOW_G ECMULT_WINDOW_SIZE
-#endif
+#include "hash.h"
 
 /* Noone will ever need more than a window size of 24. The code might
  * be correct for larger values of ECMULT_WINDOW_SIZE but this is not
@@ -58,22 +30,50 @@
 #if ECMULT_WINDOW_SIZE < 2 || ECMULT_WINDOW_SIZE > 24
 #  error Set ECMULT_WINDOW_SIZE to an integer in range [2..24].
 #endif
+#if WINDOW_A < 2 || WINDOW_A > 8
+#  error Set ECMULT_WINDOW_A to an integer in range [2..8].
+#endif
+#if ECMULT_PREPARED_WINDOW < 2 || ECMULT_PREPARED_WINDOW > 8
+#  error Set ECMULT_PREPARED_WINDOW to an integer in range [2..8].
+#endif
 
 #define WNAF_BITS 128
 #define WNAF_SIZE_BITS(bits, w) (((bits) + (w) - 1) / (w))
 #define WNAF_SIZE(w) WNAF_SIZE_BITS(WNAF_BITS, w)
 
-/** The number of entries a table with precomputed multiples needs to have. */
-#define ECMULT_TABLE_SIZE(w) (1 << ((w)-2))
+#ifdef USE_ECMULT_STATIC_VERIFY_TABLE
+#include "ecmult_static_verify_table.h"
+#endif
 
 /* The number of objects allocated on the scratch space for ecmult_multi algorithms */
-#define PIPPENGER_SCRATCH_OBJECTS 6
-#define STRAUSS_SCRATCH_OBJECTS 6
+#define PIPPENGER_SCRATCH_OBJECTS 14
+#define STRAUSS_SCRATCH_OBJECTS 8
 
 #define PIPPENGER_MAX_BUCKET_WINDOW 12
 
+/* Smallest bucket_window for which pippenger accumulates the buckets in affine coordinates
+ * (secp256k1_ecmult_pippenger_wnaf_affine). */
+#define PIPPENGER_AFFINE_MIN_WINDOW 9
+
+/* Smallest number of bucket additions that pippenger_wnaf_affine performs with one
+ * (batched) inversion. Fewer remaining additions are done in Jacobian coordinates. */
+#define PIPPENGER_AFFINE_MIN_BATCH 32
+
+/* The crossover points below can be retuned for a CPU with "bench_ecmult tune", which
+ * prints definitions to build with (e.g. from a header passed with -include). */
+
 /* Minimum number of points for which pippenger_wnaf is faster than strauss wnaf */
-#define ECMULT_PIPPENGER_THRESHOLD 88
+#define ECMULT_PIPPENGER_DEFAULT_THRESHOLD 88
+#ifndef ECMULT_PIPPENGER_THRESHOLD
+#define ECMULT_PIPPENGER_THRESHOLD ECMULT_PIPPENGER_DEFAULT_THRESHOLD
+#endif
+
+/* For every bucket_window below PIPPENGER_MAX_BUCKET_WINDOW, the maximum number of
+ * points for which it is optimal. A window whose limit equals the previous one is
+ * never used (like 8, with the endomorphism). */
+#ifndef ECMULT_PIPPENGER_WINDOW_LIMITS
+#define ECMULT_PIPPENGER_WINDOW_LIMITS 1, 4, 20, 57, 136, 235, 1260, 1260, 4420, 7880, 16050
+#endif
 
 #define ECMULT_MAX_POINTS_PER_BATCH 5000000
 
@@ -142,8 +142,10 @@ static void secp256k1_ecmult_odd_multiples_table_globalz_windowa(secp256k1_ge *p
     secp256k1_ge_globalz_set_table_gej(ECMULT_TABLE_SIZE(WINDOW_A), pre, globalz, prej, zr);
 }
 
-static void secp256k1_ecmult_odd_multiples_table_storage_var(const int n, secp256k1_ge_storage *pre, const secp256k1_gej *a) {
-    secp256k1_gej d;
+/** Fill a table 'pre' with the n points a, a + step, ..., a + (n-1)*step, none of which
+ *  may be infinity or equal to +/- step. */
+static void secp256k1_ecmult_table_storage_var(const int n, secp256k1_ge_storage *pre, const secp256k1_gej *a, const secp256k1_gej *step) {
+    secp256k1_gej d = *step;
     secp256k1_ge d_ge, p_ge;
     secp256k1_gej pj;
     secp256k1_fe zi;
@@ -153,8 +155,6 @@ static void secp256k1_ecmult_odd_multiples_table_storage_var(const int n, secp25
 
     VERIFY_CHECK(!a->infinity);
 
-    secp256k1_gej_double_var(&d, a, NULL);
-
     /* First, we perform all the additions in an isomorphic curve obtained by multiplying
      * all `z` coordinates by 1/`d.z`. In these coordinates `d` is affine so we can use
      * `secp256k1_gej_add_ge_var` to perform the additions. For each addition, we store
@@ -273,6 +273,13 @@ static void secp256k1_ecmult_odd_multiples_table_storage_var(const int n, secp25
     }
 }
 
+static void secp256k1_ecmult_odd_multiples_table_storage_var(const int n, secp256k1_ge_storage *pre, const secp256k1_gej *a) {
+    secp256k1_gej d;
+
+    secp256k1_gej_double_var(&d, a, NULL);
+    secp256k1_ecmult_table_storage_var(n, pre, a, &d);
+}
+
 /** The following two macro retrieves a particular odd multiple from a table
  *  of precomputed multiples. */
 #define ECMULT_TABLE_GET_GE(r,pre,n,w) do { \
@@ -299,24 +306,44 @@ static void secp256k1_ecmult_odd_multiples_table_storage_var(const int n, secp25
     } \
 } while(0)
 
+#ifndef USE_ECMULT_STATIC_VERIFY_TABLE
 static const size_t SECP256K1_ECMULT_CONTEXT_PREALLOCATED_SIZE =
-    ROUND_TO_ALIGN(sizeof((*((secp256k1_ecmult_context*) NULL)->pre_g)[0]) * ECMULT_TABLE_SIZE(WINDOW_G))
-    + ROUND_TO_ALIGN(sizeof((*((secp256k1_ecmult_context*) NULL)->pre_g_128)[0]) * ECMULT_TABLE_SIZE(WINDOW_G))
+    CACHE_ALIGNED_ALLOC_SIZE(sizeof((*((secp256k1_ecmult_context*) NULL)->pre_g)[0]) * ECMULT_TABLE_SIZE(WINDOW_G))
+#ifndef USE_ECMULT_COMPACT_VERIFY_TABLE
+    + CACHE_ALIGNED_ALLOC_SIZE(sizeof((*((secp256k1_ecmult_context*) NULL)->pre_g_128)[0]) * ECMULT_TABLE_SIZE(WINDOW_G))
+#endif
     ;
+#else
+static const size_t SECP256K1_ECMULT_CONTEXT_PREALLOCATED_SIZE = 0;
+#endif
+
+/* Serialized tables start with a 32-byte description of the build, followed by
+ * the SHA256 of that description and the tables. */
+#define ECMULT_TABLE_HEADER_SIZE 64
+#define ECMULT_TABLE_VERSION 1
+
+static const size_t SECP256K1_ECMULT_CONTEXT_SERIALIZED_SIZE =
+    ECMULT_TABLE_HEADER_SIZE + ECMULT_G_TABLES * sizeof(secp256k1_ge_storage) * ECMULT_TABLE_SIZE(WINDOW_G);
 
 static void secp256k1_ecmult_context_init(secp256k1_ecmult_context *ctx) {
     ctx->pre_g = NULL;
+#ifndef USE_ECMULT_COMPACT_VERIFY_TABLE
     ctx->pre_g_128 = NULL;
+#endif
+    ctx->external = 0;
 }
 
 static void secp256k1_ecmult_context_build(secp256k1_ecmult_context *ctx, void **prealloc) {
+#ifndef USE_ECMULT_STATIC_VERIFY_TABLE
     secp256k1_gej gj;
     void* const base = *prealloc;
     size_t const prealloc_size = SECP256K1_ECMULT_CONTEXT_PREALLOCATED_SIZE;
+#endif
 
     if (ctx->pre_g != NULL) {
         return;
     }
+#ifndef USE_ECMULT_STATIC_VERIFY_TABLE
 
     /* get the generator */
     secp256k1_gej_set_ge(&gj, &secp256k1_ge_const_g);
@@ -325,12 +352,13 @@ static void secp256k1_ecmult_context_build(secp256k1_ecmult_context *ctx, void *
         size_t size = sizeof((*ctx->pre_g)[0]) * ((size_t)ECMULT_TABLE_SIZE(WINDOW_G));
         /* check for overflow */
         VERIFY_CHECK(size / sizeof((*ctx->pre_g)[0]) == ((size_t)ECMULT_TABLE_SIZE(WINDOW_G)));
-        ctx->pre_g = (secp256k1_ge_storage (*)[])manual_alloc(prealloc, sizeof((*ctx->pre_g)[0]) * ECMULT_TABLE_SIZE(WINDOW_G), base, prealloc_size);
+        ctx->pre_g = (secp256k1_ge_storage (*)[])manual_alloc_cache_aligned(prealloc, sizeof((*ctx->pre_g)[0]) * ECMULT_TABLE_SIZE(WINDOW_G), base, prealloc_size);
     }
 
     /* precompute the tables with odd multiples */
     secp256k1_ecmult_odd_multiples_table_storage_var(ECMULT_TABLE_SIZE(WINDOW_G), *ctx->pre_g, &gj);
 
+#ifndef USE_ECMULT_COMPACT_VERIFY_TABLE
     {
         secp256k1_gej g_128j;
         int i;
@@ -338,7 +366,7 @@ static void secp256k1_ecmult_context_build(secp256k1_ecmult_context *ctx, void *
         size_t size = sizeof((*ctx->pre_g_128)[0]) * ((size_t) ECMULT_TABLE_SIZE(WINDOW_G));
         /* check for overflow */
         VERIFY_CHECK(size / sizeof((*ctx->pre_g_128)[0]) == ((size_t)ECMULT_TABLE_SIZE(WINDOW_G)));
-        ctx->pre_g_128 = (secp256k1_ge_storage (*)[])manual_alloc(prealloc, sizeof((*ctx->pre_g_128)[0]) * ECMULT_TABLE_SIZE(WINDOW_G), base, prealloc_size);
+        ctx->pre_g_128 = (secp256k1_ge_storage (*)[])manual_alloc_cache_aligned(prealloc, sizeof((*ctx->pre_g_128)[0]) * ECMULT_TABLE_SIZE(WINDOW_G), base, prealloc_size);
 
         /* calculate 2^128*generator */
         g_128j = gj;
@@ -347,22 +375,172 @@ static void secp256k1_ecmult_context_build(secp256k1_ecmult_context *ctx, void *
         }
         secp256k1_ecmult_odd_multiples_table_storage_var(ECMULT_TABLE_SIZE(WINDOW_G), *ctx->pre_g_128, &g_128j);
     }
+#endif
+#else
+    (void)prealloc;
+    /* We cast to void* first to suppress a -Wcast-align warning. The tables are
+     * never written to. */
+    ctx->pre_g = (secp256k1_ge_storage (*)[])(void*)secp256k1_ecmult_static_pre_g;
+#ifndef USE_ECMULT_COMPACT_VERIFY_TABLE
+    ctx->pre_g_128 = (secp256k1_ge_storage (*)[])(void*)secp256k1_ecmult_static_pre_g_128;
+#endif
+    ctx->external = 1;
+#endif
 }
 
-static void secp256k1_ecmult_context_finalize_memcpy(secp256k1_ecmult_context *dst, const secp256k1_ecmult_context *src) {
-    if (src->pre_g != NULL) {
-        /* We cast to void* first to suppress a -Wcast-align warning. */
-        dst->pre_g = (secp256k1_ge_storage (*)[])(void*)((unsigned char*)dst + ((unsigned char*)(src->pre_g) - (unsigned char*)src));
-    }
-    if (src->pre_g_128 != NULL) {
-        dst->pre_g_128 = (secp256k1_ge_storage (*)[])(void*)((unsigned char*)dst + ((unsigned char*)(src->pre_g_128) - (unsigned char*)src));
+static void secp256k1_ecmult_context_clone(secp256k1_ecmult_context *dst, const secp256k1_ecmult_context *src, void **prealloc) {
+#ifndef USE_ECMULT_STATIC_VERIFY_TABLE
+    size_t const prealloc_size = SECP256K1_ECMULT_CONTEXT_PREALLOCATED_SIZE;
+    size_t const table_size = sizeof((*src->pre_g)[0]) * ECMULT_TABLE_SIZE(WINDOW_G);
+    void* const base = *prealloc;
+#endif
+
+    *dst = *src;
+    if (src->pre_g == NULL || src->external) {
+        /* There are no tables to copy, or they are shared. */
+        (void)prealloc;
+        return;
     }
+#ifndef USE_ECMULT_STATIC_VERIFY_TABLE
+    dst->pre_g = (secp256k1_ge_storage (*)[])manual_alloc_cache_aligned(prealloc, table_size, base, prealloc_size);
+    memcpy(dst->pre_g, src->pre_g, table_size);
+#ifndef USE_ECMULT_COMPACT_VERIFY_TABLE
+    dst->pre_g_128 = (secp256k1_ge_storage (*)[])manual_alloc_cache_aligned(prealloc, table_size, base, prealloc_size);
+    memcpy(dst->pre_g_128, src->pre_g_128, table_size);
+#endif
+#endif
+}
+
+static void secp256k1_ecmult_context_share(secp256k1_ecmult_context *dst, const secp256k1_ecmult_context *src) {
+    *dst = *src;
+    dst->external = 1;
 }
 
 static int secp256k1_ecmult_context_is_built(const secp256k1_ecmult_context *ctx) {
     return ctx->pre_g != NULL;
 }
 
+static int secp256k1_ecmult_context_is_external(const secp256k1_ecmult_context *ctx) {
+    return ctx->external;
+}
+
+static void secp256k1_ecmult_table_write_be32(unsigned char *p, uint32_t x) {
+    p[0] = x >> 24;
+    p[1] = x >> 16;
+    p[2] = x >> 8;
+    p[3] = x;
+}
+
+/* Describes the tables of this build: a magic string, the format version, the
+ * window size, the size of a table entry and the number of tables. Tables are stored in the native
+ * secp256k1_ge_storage representation, so this does not catch differences in
+ * endianness or field implementation; these are caught by comparing the first
+ * entry with G instead. */
+static void secp256k1_ecmult_table_header(unsigned char *header32) {
+    static const unsigned char magic[16] = "secp256k1ecmult";
+    memcpy(header32, magic, 16);
+    secp256k1_ecmult_table_write_be32(&header32[16], ECMULT_TABLE_VERSION);
+    secp256k1_ecmult_table_write_be32(&header32[20], WINDOW_G);
+    secp256k1_ecmult_table_write_be32(&header32[24], sizeof(secp256k1_ge_storage));
+    secp256k1_ecmult_table_write_be32(&header32[28], ECMULT_G_TABLES);
+}
+
+static void secp256k1_ecmult_table_checksum(unsigned char *hash32, const unsigned char *header32, const unsigned char *tables) {
+    secp256k1_sha256 sha;
+    secp256k1_sha256_initialize(&sha);
+    secp256k1_sha256_write(&sha, header32, 32);
+    secp256k1_sha256_write(&sha, tables, SECP256K1_ECMULT_CONTEXT_SERIALIZED_SIZE - ECMULT_TABLE_HEADER_SIZE);
+    secp256k1_sha256_finalize(&sha, hash32);
+}
+
+/** Fill the entries [start, end) of the concatenation of pre_g and (unless
+ *  USE_ECMULT_COMPACT_VERIFY_TABLE) pre_g_128, as laid out by
+ *  secp256k1_ecmult_context_serialize. Disjoint ranges can be filled
+ *  independently, as every range starts from its own multiple of the base point. */
+static void secp256k1_ecmult_table_build_range(secp256k1_ge_storage *tables, size_t start, size_t end) {
+    size_t const n = ECMULT_TABLE_SIZE(WINDOW_G);
+    VERIFY_CHECK(start <= end && end <= ECMULT_G_TABLES * n);
+
+    while (start < end) {
+        size_t const idx = start % n;
+        size_t const stop = end < start - idx + n ? end : start - idx + n;
+        secp256k1_gej base, a, d;
+        int i;
+
+        /* The base point is G for pre_g and 2^128*G for pre_g_128. */
+        secp256k1_gej_set_ge(&base, &secp256k1_ge_const_g);
+        if (start >= n) {
+            for (i = 0; i < 128; i++) {
+                secp256k1_gej_double_var(&base, &base, NULL);
+            }
+        }
+        /* a = (2*idx + 1)*base */
+        secp256k1_gej_set_infinity(&a);
+        for (i = 8 * sizeof(size_t) - 1; i >= 0; i--) {
+            secp256k1_gej_double_var(&a, &a, NULL);
+            if (((2 * idx + 1) >> i) & 1) {
+                secp256k1_gej_add_var(&a, &a, &base, NULL);
+            }
+        }
+        secp256k1_gej_double_var(&d, &base, NULL);
+        secp256k1_ecmult_table_storage_var((int)(stop - start), &tables[start], &a, &d);
+        start = stop;
+    }
+}
+
+/** Complete output, whose tables have been filled by secp256k1_ecmult_table_build_range,
+ *  by writing the header and checksum of secp256k1_ecmult_context_serialize. */
+static void secp256k1_ecmult_table_finish(unsigned char *output) {
+    secp256k1_ecmult_table_header(output);
+    secp256k1_ecmult_table_checksum(&output[32], output, &output[ECMULT_TABLE_HEADER_SIZE]);
+}
+
+static void secp256k1_ecmult_context_serialize(const secp256k1_ecmult_context *ctx, unsigned char *output) {
+    size_t const table_size = sizeof(secp256k1_ge_storage) * ECMULT_TABLE_SIZE(WINDOW_G);
+    unsigned char *tables = &output[ECMULT_TABLE_HEADER_SIZE];
+    VERIFY_CHECK(secp256k1_ecmult_context_is_built(ctx));
+
+    secp256k1_ecmult_table_header(output);
+    memcpy(tables, *ctx->pre_g, table_size);
+#ifndef USE_ECMULT_COMPACT_VERIFY_TABLE
+    memcpy(tables + table_size, *ctx->pre_g_128, table_size);
+#endif
+    secp256k1_ecmult_table_checksum(&output[32], output, tables);
+}
+
+static int secp256k1_ecmult_context_load(secp256k1_ecmult_context *ctx, const unsigned char *input) {
+#ifndef USE_ECMULT_COMPACT_VERIFY_TABLE
+    size_t const table_size = sizeof(secp256k1_ge_storage) * ECMULT_TABLE_SIZE(WINDOW_G);
+#endif
+    const unsigned char *tables = &input[ECMULT_TABLE_HEADER_SIZE];
+    unsigned char header[32];
+    unsigned char hash[32];
+    secp256k1_ge_storage g;
+    VERIFY_CHECK(!secp256k1_ecmult_context_is_built(ctx));
+
+    secp256k1_ecmult_table_header(header);
+    if (secp256k1_memcmp_var(input, header, 32) != 0) {
+        return 0;
+    }
+    secp256k1_ecmult_table_checksum(hash, header, tables);
+    if (secp256k1_memcmp_var(&input[32], hash, 32) != 0) {
+        return 0;
+    }
+    secp256k1_ge_to_storage(&g, &secp256k1_ge_const_g);
+    if (secp256k1_memcmp_var(tables, &g, sizeof(g)) != 0) {
+        return 0;
+    }
+
+    /* We cast to void* first to suppress a -Wcast-align warning. The tables are
+     * never written to. */
+    ctx->pre_g = (secp256k1_ge_storage (*)[])(void*)tables;
+#ifndef USE_ECMULT_COMPACT_VERIFY_TABLE
+    ctx->pre_g_128 = (secp256k1_ge_storage (*)[])(void*)(tables + table_size);
+#endif
+    ctx->external = 1;
+    return 1;
+}
+
 static void secp256k1_ecmult_context_clear(secp256k1_ecmult_context *ctx) {
     secp256k1_ecmult_context_init(ctx);
 }
@@ -426,12 +604,57 @@ static int secp256k1_ecmult_wnaf(int *wnaf, int len, const secp256k1_scalar *a,
     return last_set_bit + 1;
 }
 
+/* Split na into na_1 and na_lam such that na = na_1 + na_lam*lambda, with both ~128 bits.
+ * A scalar that is already short (na or -na below 2^128, like small tweaks or the
+ * structured scalars of range proofs) is kept whole with na_lam = 0, which saves the
+ * split and leaves no digits to add from the lambda table. Exhaustive tests, where all
+ * scalars are short, keep exercising the split. */
+static SECP256K1_INLINE void secp256k1_ecmult_split_a(secp256k1_scalar *na_1, secp256k1_scalar *na_lam, const secp256k1_scalar *na) {
+#ifndef EXHAUSTIVE_TEST_ORDER
+    secp256k1_scalar s = *na, s_lo, s_hi;
+    if (secp256k1_scalar_get_bits_var(&s, 255, 1)) {
+        secp256k1_scalar_negate(&s, &s);
+    }
+    secp256k1_scalar_split_128(&s_lo, &s_hi, &s);
+    if (secp256k1_scalar_is_zero(&s_hi)) {
+        *na_1 = *na;
+        secp256k1_scalar_clear(na_lam);
+        return;
+    }
+#endif
+    secp256k1_scalar_split_lambda(na_1, na_lam, na);
+}
+
+/* Split ng into ng_1 and ng_128 (~128 bits each) for the tables of multiples of G:
+ * ng = ng_1 + ng_128*2^128, or ng = ng_1 + ng_128*lambda with compact tables. */
+static SECP256K1_INLINE void secp256k1_ecmult_split_g(secp256k1_scalar *ng_1, secp256k1_scalar *ng_128, const secp256k1_scalar *ng) {
+#ifdef USE_ECMULT_COMPACT_VERIFY_TABLE
+    secp256k1_scalar_split_lambda(ng_1, ng_128, ng);
+#else
+    secp256k1_scalar_split_128(ng_1, ng_128, ng);
+#endif
+}
+
+/* The table of odd multiples that digits of ng_128 index: pre_g_128, or pre_g
+ * (whose entries are then multiplied by lambda) with compact tables. */
+static SECP256K1_INLINE const secp256k1_ge_storage *secp256k1_ecmult_table_g_128(const secp256k1_ecmult_context *ctx) {
+#ifdef USE_ECMULT_COMPACT_VERIFY_TABLE
+    return *ctx->pre_g;
+#else
+    return *ctx->pre_g_128;
+#endif
+}
+
+/* Set r to n times the base point of ng_128 (2^128*G, or lambda*G with compact tables). */
+static SECP256K1_INLINE void secp256k1_ecmult_table_get_g_128(secp256k1_ge *r, const secp256k1_ecmult_context *ctx, int n) {
+    ECMULT_TABLE_GET_GE_STORAGE(r, secp256k1_ecmult_table_g_128(ctx), n, WINDOW_G);
+#ifdef USE_ECMULT_COMPACT_VERIFY_TABLE
+    secp256k1_ge_mul_lambda(r, r);
+#endif
+}
+
 struct secp256k1_strauss_point_state {
     secp256k1_scalar na_1, na_lam;
-    int wnaf_na_1[129];
-    int wnaf_na_lam[129];
-    int bits_na_1;
-    int bits_na_lam;
     size_t input_pos;
 };
 
@@ -441,18 +664,40 @@ struct secp256k1_strauss_state {
     secp256k1_ge* pre_a;
     secp256k1_ge* pre_a_lam;
     struct secp256k1_strauss_point_state* ps;
+    /* The wNAF digits of all points, 2*num per bit position (na_1 and na_lam of
+     * every point next to each other), so that the main loop reads one contiguous
+     * row per bit. */
+    int* wnaf;
 };
 
-static void secp256k1_ecmult_strauss_wnaf(const secp256k1_ecmult_context *ctx, const struct secp256k1_strauss_state *state, secp256k1_gej *r, size_t num, const secp256k1_gej *a, const secp256k1_scalar *na, const secp256k1_scalar *ng) {
-    secp256k1_ge tmpa;
-    secp256k1_fe Z;
-    /* Splitted G factors. */
-    secp256k1_scalar ng_1, ng_128;
-    int wnaf_ng_1[129];
-    int bits_ng_1 = 0;
-    int wnaf_ng_128[129];
-    int bits_ng_128 = 0;
-    int i;
+/* Prefetches the table entries for the nonzero digits of the row of wnaf digits
+ * at bit i, to be added by the next iteration of the main loop. */
+static SECP256K1_INLINE void secp256k1_ecmult_strauss_prefetch(const secp256k1_ecmult_context *ctx, const struct secp256k1_strauss_state *state, size_t num, size_t no, int i, const int *wnaf_ng_1, int bits_ng_1, const int *wnaf_ng_128, int bits_ng_128) {
+    const int *row = state->wnaf + (size_t)i * 2 * num;
+    size_t np;
+    int n;
+    for (np = 0; np < no; ++np) {
+        if ((n = row[2 * np])) {
+            PREFETCH(&state->pre_a[np * ECMULT_TABLE_SIZE(WINDOW_A) + ((n > 0 ? n : -n) - 1) / 2]);
+        }
+        if ((n = row[2 * np + 1])) {
+            PREFETCH(&state->pre_a_lam[np * ECMULT_TABLE_SIZE(WINDOW_A) + ((n > 0 ? n : -n) - 1) / 2]);
+        }
+    }
+    if (i < bits_ng_1 && (n = wnaf_ng_1[i])) {
+        PREFETCH(&(*ctx->pre_g)[((n > 0 ? n : -n) - 1) / 2]);
+    }
+    if (i < bits_ng_128 && (n = wnaf_ng_128[i])) {
+        PREFETCH(&secp256k1_ecmult_table_g_128(ctx)[((n > 0 ? n : -n) - 1) / 2]);
+    }
+}
+
+/* Fills the wnaf rows and the tables of odd multiples (and their lambda images) of the
+ * nonzero terms na[i]*a[i], sets *no_out to their number and Z to the common Z of the
+ * tables. Returns the number of rows. */
+static int secp256k1_ecmult_strauss_prepare(const struct secp256k1_strauss_state *state, secp256k1_fe *Z, size_t *no_out, size_t num, const secp256k1_gej *a, const secp256k1_scalar *na) {
+    int wnaf_tmp[129];
+    int i, k;
     int bits = 0;
     size_t np;
     size_t no = 0;
@@ -462,19 +707,18 @@ static void secp256k1_ecmult_strauss_wnaf(const secp256k1_ecmult_context *ctx, c
             continue;
         }
         state->ps[no].input_pos = np;
-        /* split na into na_1 and na_lam (where na = na_1 + na_lam*lambda, and na_1 and na_lam are ~128 bit) */
-        secp256k1_scalar_split_lambda(&state->ps[no].na_1, &state->ps[no].na_lam, &na[np]);
-
-        /* build wnaf representation for na_1 and na_lam. */
-        state->ps[no].bits_na_1   = secp256k1_ecmult_wnaf(state->ps[no].wnaf_na_1,   129, &state->ps[no].na_1,   WINDOW_A);
-        state->ps[no].bits_na_lam = secp256k1_ecmult_wnaf(state->ps[no].wnaf_na_lam, 129, &state->ps[no].na_lam, WINDOW_A);
-        VERIFY_CHECK(state->ps[no].bits_na_1 <= 129);
-        VERIFY_CHECK(state->ps[no].bits_na_lam <= 129);
-        if (state->ps[no].bits_na_1 > bits) {
-            bits = state->ps[no].bits_na_1;
-        }
-        if (state->ps[no].bits_na_lam > bits) {
-            bits = state->ps[no].bits_na_lam;
+        secp256k1_ecmult_split_a(&state->ps[no].na_1, &state->ps[no].na_lam, &na[np]);
+
+        /* build wnaf representation for na_1 and na_lam, and scatter it into the rows. */
+        for (k = 0; k < 2; k++) {
+            int bits_k = secp256k1_ecmult_wnaf(wnaf_tmp, 129, k == 0 ? &state->ps[no].na_1 : &state->ps[no].na_lam, WINDOW_A);
+            VERIFY_CHECK(bits_k <= 129);
+            for (i = 0; i < 129; i++) {
+                state->wnaf[(size_t)i * 2 * num + 2 * no + k] = wnaf_tmp[i];
+            }
+            if (bits_k > bits) {
+                bits = bits_k;
+            }
         }
         ++no;
     }
@@ -502,20 +746,42 @@ static void secp256k1_ecmult_strauss_wnaf(const secp256k1_ecmult_context *ctx, c
             secp256k1_fe_mul(state->zr + np * ECMULT_TABLE_SIZE(WINDOW_A), state->zr + np * ECMULT_TABLE_SIZE(WINDOW_A), &(a[state->ps[np].input_pos].z));
         }
         /* Bring them to the same Z denominator. */
-        secp256k1_ge_globalz_set_table_gej(ECMULT_TABLE_SIZE(WINDOW_A) * no, state->pre_a, &Z, state->prej, state->zr);
+        secp256k1_ge_globalz_set_table_gej(ECMULT_TABLE_SIZE(WINDOW_A) * no, state->pre_a, Z, state->prej, state->zr);
     } else {
-        secp256k1_fe_set_int(&Z, 1);
+        secp256k1_fe_set_int(Z, 1);
     }
 
     for (np = 0; np < no; ++np) {
+        if (secp256k1_scalar_is_zero(&state->ps[np].na_lam)) {
+            /* No digit of this point indexes its lambda table. */
+            continue;
+        }
         for (i = 0; i < ECMULT_TABLE_SIZE(WINDOW_A); i++) {
             secp256k1_ge_mul_lambda(&state->pre_a_lam[np * ECMULT_TABLE_SIZE(WINDOW_A) + i], &state->pre_a[np * ECMULT_TABLE_SIZE(WINDOW_A) + i]);
         }
     }
+    *no_out = no;
+    return bits;
+}
+
+static void secp256k1_ecmult_strauss_wnaf(const secp256k1_ecmult_context *ctx, const struct secp256k1_strauss_state *state, secp256k1_gej *r, size_t num, const secp256k1_gej *a, const secp256k1_scalar *na, const secp256k1_scalar *ng) {
+    secp256k1_ge tmpa;
+    secp256k1_fe Z;
+    /* Splitted G factors. */
+    secp256k1_scalar ng_1, ng_128;
+    int wnaf_ng_1[129];
+    int bits_ng_1 = 0;
+    int wnaf_ng_128[129];
+    int bits_ng_128 = 0;
+    int i;
+    int bits;
+    size_t np;
+    size_t no;
+
+    bits = secp256k1_ecmult_strauss_prepare(state, &Z, &no, num, a, na);
 
     if (ng) {
-        /* split ng into ng_1 and ng_128 (where gn = gn_1 + gn_128*2^128, and gn_1 and gn_128 are ~128 bit) */
-        secp256k1_scalar_split_128(&ng_1, &ng_128, ng);
+        secp256k1_ecmult_split_g(&ng_1, &ng_128, ng);
 
         /* Build wnaf representation for ng_1 and ng_128 */
         bits_ng_1   = secp256k1_ecmult_wnaf(wnaf_ng_1,   129, &ng_1,   WINDOW_G);
@@ -530,15 +796,22 @@ static void secp256k1_ecmult_strauss_wnaf(const secp256k1_ecmult_context *ctx, c
 
     secp256k1_gej_set_infinity(r);
 
+    if (bits > 0) {
+        secp256k1_ecmult_strauss_prefetch(ctx, state, num, no, bits - 1, wnaf_ng_1, bits_ng_1, wnaf_ng_128, bits_ng_128);
+    }
     for (i = bits - 1; i >= 0; i--) {
+        const int *row = state->wnaf + (size_t)i * 2 * num;
         int n;
+        if (i > 0) {
+            secp256k1_ecmult_strauss_prefetch(ctx, state, num, no, i - 1, wnaf_ng_1, bits_ng_1, wnaf_ng_128, bits_ng_128);
+        }
         secp256k1_gej_double_var(r, r, NULL);
         for (np = 0; np < no; ++np) {
-            if (i < state->ps[np].bits_na_1 && (n = state->ps[np].wnaf_na_1[i])) {
+            if ((n = row[2 * np])) {
                 ECMULT_TABLE_GET_GE(&tmpa, state->pre_a + np * ECMULT_TABLE_SIZE(WINDOW_A), n, WINDOW_A);
                 secp256k1_gej_add_ge_var(r, r, &tmpa, NULL);
             }
-            if (i < state->ps[np].bits_na_lam && (n = state->ps[np].wnaf_na_lam[i])) {
+            if ((n = row[2 * np + 1])) {
                 ECMULT_TABLE_GET_GE(&tmpa, state->pre_a_lam + np * ECMULT_TABLE_SIZE(WINDOW_A), n, WINDOW_A);
                 secp256k1_gej_add_ge_var(r, r, &tmpa, NULL);
             }
@@ -548,7 +821,7 @@ static void secp256k1_ecmult_strauss_wnaf(const secp256k1_ecmult_context *ctx, c
             secp256k1_gej_add_zinv_var(r, r, &tmpa, &Z);
         }
         if (i < bits_ng_128 && (n = wnaf_ng_128[i])) {
-            ECMULT_TABLE_GET_GE_STORAGE(&tmpa, *ctx->pre_g_128, n, WINDOW_G);
+            secp256k1_ecmult_table_get_g_128(&tmpa, ctx, n);
             secp256k1_gej_add_zinv_var(r, r, &tmpa, &Z);
         }
     }
@@ -564,6 +837,7 @@ static void secp256k1_ecmult(const secp256k1_ecmult_context *ctx, secp256k1_gej
     secp256k1_ge pre_a[ECMULT_TABLE_SIZE(WINDOW_A)];
     struct secp256k1_strauss_point_state ps[1];
     secp256k1_ge pre_a_lam[ECMULT_TABLE_SIZE(WINDOW_A)];
+    int wnaf[2 * 129];
     struct secp256k1_strauss_state state;
 
     state.prej = prej;
@@ -571,11 +845,293 @@ static void secp256k1_ecmult(const secp256k1_ecmult_context *ctx, secp256k1_gej
     state.pre_a = pre_a;
     state.pre_a_lam = pre_a_lam;
     state.ps = ps;
+    state.wnaf = wnaf;
     secp256k1_ecmult_strauss_wnaf(ctx, &state, r, 1, a, na, ng);
 }
 
+static void secp256k1_ecmult_3(const secp256k1_ecmult_context *ctx, secp256k1_gej *r, const secp256k1_gej *a, const secp256k1_scalar *na, const secp256k1_gej *b, const secp256k1_scalar *nb, const secp256k1_scalar *ng) {
+    secp256k1_gej prej[2 * ECMULT_TABLE_SIZE(WINDOW_A)];
+    secp256k1_fe zr[2 * ECMULT_TABLE_SIZE(WINDOW_A)];
+    secp256k1_ge pre_a[2 * ECMULT_TABLE_SIZE(WINDOW_A)];
+    struct secp256k1_strauss_point_state ps[2];
+    secp256k1_ge pre_a_lam[2 * ECMULT_TABLE_SIZE(WINDOW_A)];
+    int wnaf[4 * 129];
+    secp256k1_gej points[2];
+    secp256k1_scalar scalars[2];
+    struct secp256k1_strauss_state state;
+
+    points[0] = *a;
+    points[1] = *b;
+    scalars[0] = *na;
+    scalars[1] = *nb;
+    state.prej = prej;
+    state.zr = zr;
+    state.pre_a = pre_a;
+    state.pre_a_lam = pre_a_lam;
+    state.ps = ps;
+    state.wnaf = wnaf;
+    secp256k1_ecmult_strauss_wnaf(ctx, &state, r, 2, points, scalars, ng);
+}
+
+static void secp256k1_ecmult_small(const secp256k1_ecmult_context *ctx, secp256k1_gej *r, const secp256k1_gej *a, const secp256k1_scalar *na, size_t num, const secp256k1_scalar *ng) {
+    secp256k1_gej prej[ECMULT_SMALL_MAX_POINTS * ECMULT_TABLE_SIZE(WINDOW_A)];
+    secp256k1_fe zr[ECMULT_SMALL_MAX_POINTS * ECMULT_TABLE_SIZE(WINDOW_A)];
+    secp256k1_ge pre_a[ECMULT_SMALL_MAX_POINTS * ECMULT_TABLE_SIZE(WINDOW_A)];
+    struct secp256k1_strauss_point_state ps[ECMULT_SMALL_MAX_POINTS];
+    secp256k1_ge pre_a_lam[ECMULT_SMALL_MAX_POINTS * ECMULT_TABLE_SIZE(WINDOW_A)];
+    int wnaf[ECMULT_SMALL_MAX_POINTS * 2 * 129];
+    struct secp256k1_strauss_state state;
+    secp256k1_gej tmp;
+    size_t n = num < ECMULT_SMALL_MAX_POINTS ? num : ECMULT_SMALL_MAX_POINTS;
+    size_t i;
+
+    state.prej = prej;
+    state.zr = zr;
+    state.pre_a = pre_a;
+    state.pre_a_lam = pre_a_lam;
+    state.ps = ps;
+    state.wnaf = wnaf;
+    secp256k1_ecmult_strauss_wnaf(ctx, &state, r, n, a, na, ng);
+    for (i = n; i < num; i += n) {
+        n = num - i < ECMULT_SMALL_MAX_POINTS ? num - i : ECMULT_SMALL_MAX_POINTS;
+        secp256k1_ecmult_strauss_wnaf(ctx, &state, &tmp, n, a + i, na + i, NULL);
+        secp256k1_gej_add_var(r, r, &tmp, NULL);
+    }
+}
+
+static void secp256k1_ecmult_lanes(const secp256k1_ecmult_context *ctx, secp256k1_gej *r, const secp256k1_gej *a, const secp256k1_scalar *na, const secp256k1_scalar *ng, size_t n) {
+    secp256k1_gej prej[ECMULT_LANES * ECMULT_TABLE_SIZE(WINDOW_A)];
+    secp256k1_fe zr[ECMULT_LANES * ECMULT_TABLE_SIZE(WINDOW_A)];
+    secp256k1_ge pre_a[ECMULT_LANES * ECMULT_TABLE_SIZE(WINDOW_A)];
+    struct secp256k1_strauss_point_state ps[ECMULT_LANES];
+    secp256k1_ge pre_a_lam[ECMULT_LANES * ECMULT_TABLE_SIZE(WINDOW_A)];
+    int wnaf[ECMULT_LANES * 2 * 129];
+    int wnaf_ng_1[ECMULT_LANES][129];
+    int wnaf_ng_128[ECMULT_LANES][129];
+    int bits_ng_1[ECMULT_LANES];
+    int bits_ng_128[ECMULT_LANES];
+    struct secp256k1_strauss_state state;
+    secp256k1_scalar ng_1, ng_128;
+    secp256k1_ge tmpa;
+    secp256k1_fe Z;
+    size_t np, no, l;
+    int bits, i;
+
+    VERIFY_CHECK(n <= ECMULT_LANES);
+    state.prej = prej;
+    state.zr = zr;
+    state.pre_a = pre_a;
+    state.pre_a_lam = pre_a_lam;
+    state.ps = ps;
+    state.wnaf = wnaf;
+    /* The tables of all lanes are brought to one Z, like the tables of the points of a
+     * single multi-multiplication, so the lanes share the isomorphism and the G tables
+     * are added with the same Z inverse in every lane. */
+    bits = secp256k1_ecmult_strauss_prepare(&state, &Z, &no, n, a, na);
+    for (l = 0; l < n; l++) {
+        secp256k1_ecmult_split_g(&ng_1, &ng_128, &ng[l]);
+        bits_ng_1[l]   = secp256k1_ecmult_wnaf(wnaf_ng_1[l],   129, &ng_1,   WINDOW_G);
+        bits_ng_128[l] = secp256k1_ecmult_wnaf(wnaf_ng_128[l], 129, &ng_128, WINDOW_G);
+        if (bits_ng_1[l] > bits) {
+            bits = bits_ng_1[l];
+        }
+        if (bits_ng_128[l] > bits) {
+            bits = bits_ng_128[l];
+        }
+        secp256k1_gej_set_infinity(&r[l]);
+    }
+
+    /* Every step of the main loop does the same step of all lanes, whose dependency
+     * chains are independent and can overlap. */
+    for (i = bits - 1; i >= 0; i--) {
+        const int *row = state.wnaf + (size_t)i * 2 * n;
+        int d;
+        for (l = 0; l < n; l++) {
+            secp256k1_gej_double_var(&r[l], &r[l], NULL);
+        }
+        for (np = 0; np < no; ++np) {
+            secp256k1_gej *rl = &r[ps[np].input_pos];
+            if ((d = row[2 * np])) {
+                ECMULT_TABLE_GET_GE(&tmpa, pre_a + np * ECMULT_TABLE_SIZE(WINDOW_A), d, WINDOW_A);
+                secp256k1_gej_add_ge_var(rl, rl, &tmpa, NULL);
+            }
+            if ((d = row[2 * np + 1])) {
+                ECMULT_TABLE_GET_GE(&tmpa, pre_a_lam + np * ECMULT_TABLE_SIZE(WINDOW_A), d, WINDOW_A);
+                secp256k1_gej_add_ge_var(rl, rl, &tmpa, NULL);
+            }
+        }
+        for (l = 0; l < n; l++) {
+            if (i < bits_ng_1[l] && (d = wnaf_ng_1[l][i])) {
+                ECMULT_TABLE_GET_GE_STORAGE(&tmpa, *ctx->pre_g, d, WINDOW_G);
+                secp256k1_gej_add_zinv_var(&r[l], &r[l], &tmpa, &Z);
+            }
+            if (i < bits_ng_128[l] && (d = wnaf_ng_128[l][i])) {
+                secp256k1_ecmult_table_get_g_128(&tmpa, ctx, d);
+                secp256k1_gej_add_zinv_var(&r[l], &r[l], &tmpa, &Z);
+            }
+        }
+    }
+
+    for (l = 0; l < n; l++) {
+        if (!r[l].infinity) {
+            secp256k1_fe_mul(&r[l].z, &r[l].z, &Z);
+        }
+    }
+}
+
+static void secp256k1_ecmult_point_table_build(secp256k1_ecmult_point_table *table, const secp256k1_ge *a) {
+    secp256k1_gej aj;
+
+    secp256k1_gej_set_ge(&aj, a);
+    secp256k1_ecmult_odd_multiples_table_storage_var(ECMULT_POINT_TABLE_SIZE, table->pre, &aj);
+}
+
+static void secp256k1_ecmult_prepared_point_build(secp256k1_ecmult_prepared_point *prep, const secp256k1_ge *a) {
+    secp256k1_gej aj;
+    secp256k1_ge tmp;
+    int i;
+
+    secp256k1_gej_set_ge(&aj, a);
+    secp256k1_ecmult_odd_multiples_table_storage_var(ECMULT_TABLE_SIZE(ECMULT_PREPARED_WINDOW), prep->pre_a, &aj);
+    for (i = 0; i < ECMULT_TABLE_SIZE(ECMULT_PREPARED_WINDOW); i++) {
+        secp256k1_ge_from_storage(&tmp, &prep->pre_a[i]);
+        secp256k1_ge_mul_lambda(&tmp, &tmp);
+        secp256k1_ge_to_storage(&prep->pre_a_lam[i], &tmp);
+    }
+}
+
+static void secp256k1_ecmult_prepared(const secp256k1_ecmult_context *ctx, secp256k1_gej *r, const secp256k1_ecmult_prepared_point *prep, const secp256k1_scalar *na, const secp256k1_scalar *ng) {
+    int wnaf_na_1[129];
+    int wnaf_na_lam[129];
+    int wnaf_ng_1[129];
+    int wnaf_ng_128[129];
+    int bits_na_1, bits_na_lam, bits_ng_1, bits_ng_128;
+    int bits, i, n;
+    secp256k1_scalar na_1, na_lam, ng_1, ng_128;
+    secp256k1_ge tmpa;
+
+    secp256k1_ecmult_split_a(&na_1, &na_lam, na);
+    bits_na_1   = secp256k1_ecmult_wnaf(wnaf_na_1,   129, &na_1,   ECMULT_PREPARED_WINDOW);
+    bits_na_lam = secp256k1_ecmult_wnaf(wnaf_na_lam, 129, &na_lam, ECMULT_PREPARED_WINDOW);
+    VERIFY_CHECK(bits_na_1 <= 129);
+    VERIFY_CHECK(bits_na_lam <= 129);
+    bits = bits_na_1 > bits_na_lam ? bits_na_1 : bits_na_lam;
+
+    secp256k1_ecmult_split_g(&ng_1, &ng_128, ng);
+    bits_ng_1   = secp256k1_ecmult_wnaf(wnaf_ng_1,   129, &ng_1,   WINDOW_G);
+    bits_ng_128 = secp256k1_ecmult_wnaf(wnaf_ng_128, 129, &ng_128, WINDOW_G);
+    if (bits_ng_1 > bits) {
+        bits = bits_ng_1;
+    }
+    if (bits_ng_128 > bits) {
+        bits = bits_ng_128;
+    }
+
+    /* All tables are affine, so unlike in secp256k1_ecmult_strauss_wnaf there is
+     * no common Z to correct for. */
+    secp256k1_gej_set_infinity(r);
+    for (i = bits - 1; i >= 0; i--) {
+        secp256k1_gej_double_var(r, r, NULL);
+        if (i < bits_na_1 && (n = wnaf_na_1[i])) {
+            ECMULT_TABLE_GET_GE_STORAGE(&tmpa, prep->pre_a, n, ECMULT_PREPARED_WINDOW);
+            secp256k1_gej_add_ge_var(r, r, &tmpa, NULL);
+        }
+        if (i < bits_na_lam && (n = wnaf_na_lam[i])) {
+            ECMULT_TABLE_GET_GE_STORAGE(&tmpa, prep->pre_a_lam, n, ECMULT_PREPARED_WINDOW);
+            secp256k1_gej_add_ge_var(r, r, &tmpa, NULL);
+        }
+        if (i < bits_ng_1 && (n = wnaf_ng_1[i])) {
+            ECMULT_TABLE_GET_GE_STORAGE(&tmpa, *ctx->pre_g, n, WINDOW_G);
+            secp256k1_gej_add_ge_var(r, r, &tmpa, NULL);
+        }
+        if (i < bits_ng_128 && (n = wnaf_ng_128[i])) {
+            secp256k1_ecmult_table_get_g_128(&tmpa, ctx, n);
+            secp256k1_gej_add_ge_var(r, r, &tmpa, NULL);
+        }
+    }
+}
+
+/* The number of fixed points whose digits secp256k1_ecmult_point_tables keeps on the
+ * stack at once. Larger inputs are processed in batches, each with its own doublings. */
+#define ECMULT_POINT_TABLES_BATCH 8
+
+static void secp256k1_ecmult_point_tables(const secp256k1_ecmult_context *ctx, secp256k1_gej *r, const secp256k1_ecmult_point_table * const *tables, const secp256k1_scalar *na, size_t num, const secp256k1_scalar *ng) {
+    int wnaf_na_1[ECMULT_POINT_TABLES_BATCH][129];
+    int wnaf_na_lam[ECMULT_POINT_TABLES_BATCH][129];
+    int bits_na_1[ECMULT_POINT_TABLES_BATCH];
+    int bits_na_lam[ECMULT_POINT_TABLES_BATCH];
+    int wnaf_ng_1[129];
+    int wnaf_ng_128[129];
+    secp256k1_scalar na_1, na_lam, ng_1, ng_128;
+    secp256k1_gej acc;
+    secp256k1_ge tmpa;
+    size_t np, k = 0, batch;
+
+    secp256k1_gej_set_infinity(r);
+    /* The generator is handled together with the first batch. */
+    do {
+        int bits_ng_1 = 0, bits_ng_128 = 0;
+        int bits = 0;
+        int i, n;
+
+        batch = num - k < ECMULT_POINT_TABLES_BATCH ? num - k : ECMULT_POINT_TABLES_BATCH;
+        for (np = 0; np < batch; np++) {
+            secp256k1_ecmult_split_a(&na_1, &na_lam, &na[k + np]);
+            bits_na_1[np]   = secp256k1_ecmult_wnaf(wnaf_na_1[np],   129, &na_1,   ECMULT_POINT_TABLE_WINDOW);
+            bits_na_lam[np] = secp256k1_ecmult_wnaf(wnaf_na_lam[np], 129, &na_lam, ECMULT_POINT_TABLE_WINDOW);
+            VERIFY_CHECK(bits_na_1[np] <= 129);
+            VERIFY_CHECK(bits_na_lam[np] <= 129);
+            if (bits_na_1[np] > bits) {
+                bits = bits_na_1[np];
+            }
+            if (bits_na_lam[np] > bits) {
+                bits = bits_na_lam[np];
+            }
+        }
+        if (k == 0 && ng != NULL) {
+            secp256k1_ecmult_split_g(&ng_1, &ng_128, ng);
+            bits_ng_1   = secp256k1_ecmult_wnaf(wnaf_ng_1,   129, &ng_1,   WINDOW_G);
+            bits_ng_128 = secp256k1_ecmult_wnaf(wnaf_ng_128, 129, &ng_128, WINDOW_G);
+            if (bits_ng_1 > bits) {
+                bits = bits_ng_1;
+            }
+            if (bits_ng_128 > bits) {
+                bits = bits_ng_128;
+            }
+        }
+
+        /* All tables are affine, so unlike in secp256k1_ecmult_strauss_wnaf there is
+         * no common Z to correct for. */
+        secp256k1_gej_set_infinity(&acc);
+        for (i = bits - 1; i >= 0; i--) {
+            secp256k1_gej_double_var(&acc, &acc, NULL);
+            for (np = 0; np < batch; np++) {
+                if (i < bits_na_1[np] && (n = wnaf_na_1[np][i])) {
+                    ECMULT_TABLE_GET_GE_STORAGE(&tmpa, tables[k + np]->pre, n, ECMULT_POINT_TABLE_WINDOW);
+                    secp256k1_gej_add_ge_var(&acc, &acc, &tmpa, NULL);
+                }
+                if (i < bits_na_lam[np] && (n = wnaf_na_lam[np][i])) {
+                    ECMULT_TABLE_GET_GE_STORAGE(&tmpa, tables[k + np]->pre, n, ECMULT_POINT_TABLE_WINDOW);
+                    secp256k1_ge_mul_lambda(&tmpa, &tmpa);
+                    secp256k1_gej_add_ge_var(&acc, &acc, &tmpa, NULL);
+                }
+            }
+            if (i < bits_ng_1 && (n = wnaf_ng_1[i])) {
+                ECMULT_TABLE_GET_GE_STORAGE(&tmpa, *ctx->pre_g, n, WINDOW_G);
+                secp256k1_gej_add_ge_var(&acc, &acc, &tmpa, NULL);
+            }
+            if (i < bits_ng_128 && (n = wnaf_ng_128[i])) {
+                secp256k1_ecmult_table_get_g_128(&tmpa, ctx, n);
+                secp256k1_gej_add_ge_var(&acc, &acc, &tmpa, NULL);
+            }
+        }
+        secp256k1_gej_add_var(r, r, &acc, NULL);
+        k += batch;
+    } while (k < num);
+}
+
 static size_t secp256k1_strauss_scratch_size(size_t n_points) {
-    static const size_t point_size = (2 * sizeof(secp256k1_ge) + sizeof(secp256k1_gej) + sizeof(secp256k1_fe)) * ECMULT_TABLE_SIZE(WINDOW_A) + sizeof(struct secp256k1_strauss_point_state) + sizeof(secp256k1_gej) + sizeof(secp256k1_scalar);
+    static const size_t point_size = (2 * sizeof(secp256k1_ge) + sizeof(secp256k1_gej) + sizeof(secp256k1_fe)) * ECMULT_TABLE_SIZE(WINDOW_A) + sizeof(struct secp256k1_strauss_point_state) + 2 * 129 * sizeof(int) + sizeof(secp256k1_gej) + sizeof(secp256k1_scalar);
     return n_points*point_size;
 }
 
@@ -598,8 +1154,9 @@ static int secp256k1_ecmult_strauss_batch(const secp256k1_callback* error_callba
     state.pre_a = (secp256k1_ge*)secp256k1_scratch_alloc(error_callback, scratch, n_points * ECMULT_TABLE_SIZE(WINDOW_A) * sizeof(secp256k1_ge));
     state.pre_a_lam = (secp256k1_ge*)secp256k1_scratch_alloc(error_callback, scratch, n_points * ECMULT_TABLE_SIZE(WINDOW_A) * sizeof(secp256k1_ge));
     state.ps = (struct secp256k1_strauss_point_state*)secp256k1_scratch_alloc(error_callback, scratch, n_points * sizeof(struct secp256k1_strauss_point_state));
+    state.wnaf = (int*)secp256k1_scratch_alloc(error_callback, scratch, n_points * 2 * 129 * sizeof(int));
 
-    if (points == NULL || scalars == NULL || state.prej == NULL || state.zr == NULL || state.pre_a == NULL || state.pre_a_lam == NULL || state.ps == NULL) {
+    if (points == NULL || scalars == NULL || state.prej == NULL || state.zr == NULL || state.pre_a == NULL || state.pre_a_lam == NULL || state.ps == NULL || state.wnaf == NULL) {
         secp256k1_scratch_apply_checkpoint(error_callback, scratch, scratch_checkpoint);
         return 0;
     }
@@ -668,26 +1225,25 @@ static int secp256k1_wnaf_fixed(int *wnaf, const secp256k1_scalar *s, int w) {
     max_pos = pos;
     pos = 1;
 
+    /* The digit loop is written without data-dependent branches: the recoded
+     * inputs of a multi-point multiplication are random, so the branches of the
+     * straightforward version would be mispredicted about half of the time. */
     while (pos <= max_pos) {
         int val = secp256k1_scalar_get_bits_var(work, pos * w, pos == WNAF_SIZE(w)-1 ? last_w : w);
-        if ((val & 1) == 0) {
-            wnaf[pos - 1] -= (1 << w);
-            wnaf[pos] = (val + 1);
-        } else {
-            wnaf[pos] = val;
-        }
+        int even = (val & 1) ^ 1;
+        wnaf[pos - 1] -= even << w;
+        wnaf[pos] = val + even;
         /* Set a coefficient to zero if it is 1 or -1 and the proceeding digit
          * is strictly negative or strictly positive respectively. Only change
          * coefficients at previous positions because above code assumes that
          * wnaf[pos - 1] is odd.
          */
-        if (pos >= 2 && ((wnaf[pos - 1] == 1 && wnaf[pos - 2] < 0) || (wnaf[pos - 1] == -1 && wnaf[pos - 2] > 0))) {
-            if (wnaf[pos - 1] == 1) {
-                wnaf[pos - 2] += 1 << w;
-            } else {
-                wnaf[pos - 2] -= 1 << w;
-            }
-            wnaf[pos - 1] = 0;
+        if (pos >= 2) {
+            int prev = wnaf[pos - 1];
+            int up = (prev == 1) & (wnaf[pos - 2] < 0);
+            int down = (prev == -1) & (wnaf[pos - 2] > 0);
+            wnaf[pos - 2] += (up - down) * (1 << w);
+            wnaf[pos - 1] = prev & -((up | down) ^ 1);
         }
         ++pos;
     }
@@ -700,11 +1256,50 @@ struct secp256k1_pippenger_point_state {
     size_t input_pos;
 };
 
+/* An addition of (possibly negated) pt[input_pos] to a bucket. */
+struct secp256k1_pippenger_add {
+    size_t input_pos;
+    int neg;
+};
+
 struct secp256k1_pippenger_state {
     int *wnaf_na;
     struct secp256k1_pippenger_point_state* ps;
+    /* Only used by pippenger_wnaf_affine: the additions of a window (up to two per
+     * point), sorted by bucket, with the first addition of every bucket in start (-1
+     * once a bucket has moved to Jacobian coordinates in buckets) and the end of its
+     * pending additions in next; the buckets with pending additions; the (negated)
+     * points, buckets, and denominators and their inverses of the additions of a round
+     * (at most one per bucket); and the affine buckets. */
+    struct secp256k1_pippenger_add *adds;
+    int *start;
+    int *next;
+    int *active;
+    secp256k1_ge *round_pts;
+    int *round_buckets;
+    secp256k1_fe *den;
+    secp256k1_ge *abuckets;
 };
 
+/* Recode the scalars of the nonzero terms directly into state->wnaf_na (n_wnaf
+ * digits per term) and record their input positions and skews in state->ps.
+ * Returns the number of recoded terms. */
+static size_t secp256k1_ecmult_pippenger_recode(struct secp256k1_pippenger_state *state, const secp256k1_scalar *sc, const secp256k1_ge *pt, size_t num, int bucket_window) {
+    size_t n_wnaf = WNAF_SIZE(bucket_window+1);
+    size_t np;
+    size_t no = 0;
+
+    for (np = 0; np < num; ++np) {
+        if (secp256k1_scalar_is_zero(&sc[np]) || secp256k1_ge_is_infinity(&pt[np])) {
+            continue;
+        }
+        state->ps[no].input_pos = np;
+        state->ps[no].skew_na = secp256k1_wnaf_fixed(&state->wnaf_na[no*n_wnaf], &sc[np], bucket_window+1);
+        no++;
+    }
+    return no;
+}
+
 /*
  * pippenger_wnaf computes the result of a multi-point multiplication as
  * follows: The scalars are brought into wnaf with n_wnaf elements each. Then
@@ -715,18 +1310,11 @@ struct secp256k1_pippenger_state {
 static int secp256k1_ecmult_pippenger_wnaf(secp256k1_gej *buckets, int bucket_window, struct secp256k1_pippenger_state *state, secp256k1_gej *r, const secp256k1_scalar *sc, const secp256k1_ge *pt, size_t num) {
     size_t n_wnaf = WNAF_SIZE(bucket_window+1);
     size_t np;
-    size_t no = 0;
+    size_t no;
     int i;
     int j;
 
-    for (np = 0; np < num; ++np) {
-        if (secp256k1_scalar_is_zero(&sc[np]) || secp256k1_ge_is_infinity(&pt[np])) {
-            continue;
-        }
-        state->ps[no].input_pos = np;
-        state->ps[no].skew_na = secp256k1_wnaf_fixed(&state->wnaf_na[no*n_wnaf], &sc[np], bucket_window+1);
-        no++;
-    }
+    no = secp256k1_ecmult_pippenger_recode(state, sc, pt, num, bucket_window);
     secp256k1_gej_set_infinity(r);
 
     if (no == 0) {
@@ -789,55 +1377,244 @@ static int secp256k1_ecmult_pippenger_wnaf(secp256k1_gej *buckets, int bucket_wi
     return 1;
 }
 
+/* Same as pippenger_wnaf, but the points are added to affine buckets, which makes an
+ * addition cost about 6M instead of about 11M for gej_add_ge_var. The additions of a
+ * window are first sorted by bucket (a counting sort on the digits), and then done in
+ * rounds that add the next pending point to every bucket that has one, walking the
+ * buckets in order, so that the denominators of the slopes in a round can be inverted
+ * together. The sort makes the accesses to the buckets sequential: unsorted, every
+ * addition of a round touches a random bucket, and once the buckets outgrow the cache
+ * (2^12 of them take over 300 kB with their bookkeeping) that is a cache miss per
+ * addition. Once a round would have fewer than PIPPENGER_AFFINE_MIN_BATCH additions,
+ * which happens when a few buckets (e.g. the one that corrects the skew) have many more
+ * additions than the others, the remaining additions are done in Jacobian coordinates.
+ * The summation of the buckets then uses gej_add_ge_var instead of gej_add_var. */
+static int secp256k1_ecmult_pippenger_wnaf_affine(secp256k1_gej *buckets, int bucket_window, struct secp256k1_pippenger_state *state, secp256k1_gej *r, const secp256k1_scalar *sc, const secp256k1_ge *pt, size_t num) {
+    size_t n_wnaf = WNAF_SIZE(bucket_window+1);
+    int n_buckets = ECMULT_TABLE_SIZE(bucket_window+2);
+    struct secp256k1_pippenger_add *adds = state->adds;
+    int *start = state->start;
+    int *next = state->next;
+    int *active = state->active;
+    secp256k1_ge *round_pts = state->round_pts;
+    int *round_buckets = state->round_buckets;
+    secp256k1_fe *den = state->den;
+    secp256k1_fe *inv = &state->den[n_buckets];
+    secp256k1_ge *abuckets = state->abuckets;
+    size_t np, k;
+    size_t no;
+    int i;
+    int j;
+
+    no = secp256k1_ecmult_pippenger_recode(state, sc, pt, num, bucket_window);
+    secp256k1_gej_set_infinity(r);
+
+    if (no == 0) {
+        return 1;
+    }
+
+    for (i = n_wnaf - 1; i >= 0; i--) {
+        secp256k1_gej running_sum;
+        int n_active = 0;
+
+        /* Count the additions to every bucket, ... */
+        for (j = 0; j <= n_buckets; j++) {
+            start[j] = 0;
+        }
+        for (np = 0; np < no; ++np) {
+            int n = state->wnaf_na[np*n_wnaf + i];
+            if (i == 0 && state->ps[np].skew_na) {
+                start[1]++;
+            }
+            if (n != 0) {
+                start[(n > 0 ? (n - 1)/2 : -(n + 1)/2) + 1]++;
+            }
+        }
+        for (j = 0; j < n_buckets; j++) {
+            start[j + 1] += start[j];
+            next[j] = start[j];
+            secp256k1_ge_set_infinity(&abuckets[j]);
+        }
+        /* ... and sort them into place by bucket. */
+        for (np = 0; np < no; ++np) {
+            int n = state->wnaf_na[np*n_wnaf + i];
+            size_t pos = state->ps[np].input_pos;
+
+            if (i == 0 && state->ps[np].skew_na) {
+                /* correct for wnaf skew */
+                adds[next[0]].input_pos = pos;
+                adds[next[0]].neg = 1;
+                next[0]++;
+            }
+            if (n != 0) {
+                int b = n > 0 ? (n - 1)/2 : -(n + 1)/2;
+                adds[next[b]].input_pos = pos;
+                adds[next[b]].neg = n < 0;
+                next[b]++;
+            }
+        }
+        for (j = 0; j < n_buckets; j++) {
+            if (next[j] > start[j]) {
+                active[n_active++] = j;
+            }
+        }
+
+        while (n_active > 0) {
+            size_t n_round = 0, n_done = 0;
+            int n_left = 0, a;
+            for (a = 0; a < n_active; a++) {
+                int b = active[a];
+                const struct secp256k1_pippenger_add *add = &adds[--next[b]];
+                secp256k1_ge *bucket = &abuckets[b];
+                secp256k1_ge *p = &round_pts[n_round];
+
+                if (next[b] > start[b]) {
+                    active[n_left++] = b;
+                }
+                if (add->neg) {
+                    secp256k1_ge_neg(p, &pt[add->input_pos]);
+                } else {
+                    *p = pt[add->input_pos];
+                }
+                secp256k1_fe_normalize_weak(&p->y);
+                /* Additions to an empty bucket, or of the negation of the bucket, need
+                 * no inversion. */
+                if (bucket->infinity) {
+                    *bucket = *p;
+                    n_done++;
+                    continue;
+                }
+                if (secp256k1_fe_equal_var(&bucket->x, &p->x)) {
+                    if (!secp256k1_fe_equal_var(&bucket->y, &p->y)) {
+                        secp256k1_ge_set_infinity(bucket);
+                        n_done++;
+                        continue;
+                    }
+                    /* Doubling: the denominator is 2*y */
+                    den[n_round] = bucket->y;
+                    secp256k1_fe_mul_int(&den[n_round], 2);
+                } else {
+                    secp256k1_fe_negate(&den[n_round], &bucket->x, 1);
+                    secp256k1_fe_add(&den[n_round], &p->x);
+                }
+                round_buckets[n_round++] = b;
+            }
+            n_active = n_left;
+
+            if (n_round < PIPPENGER_AFFINE_MIN_BATCH && n_done == 0) {
+                /* Too few additions to pay for an inversion: finish this window in
+                 * Jacobian coordinates. */
+                for (a = 0; a < n_active; a++) {
+                    int b = active[a];
+                    secp256k1_gej_set_ge(&buckets[b], &abuckets[b]);
+                    while (next[b] > start[b]) {
+                        const struct secp256k1_pippenger_add *add = &adds[--next[b]];
+                        secp256k1_ge p;
+                        if (add->neg) {
+                            secp256k1_ge_neg(&p, &pt[add->input_pos]);
+                        } else {
+                            p = pt[add->input_pos];
+                        }
+                        secp256k1_gej_add_ge_var(&buckets[b], &buckets[b], &p, NULL);
+                    }
+                    start[b] = -1;
+                }
+                for (k = 0; k < n_round; k++) {
+                    int b = round_buckets[k];
+                    if (start[b] != -1) {
+                        secp256k1_gej_set_ge(&buckets[b], &abuckets[b]);
+                        start[b] = -1;
+                    }
+                    secp256k1_gej_add_ge_var(&buckets[b], &buckets[b], &round_pts[k], NULL);
+                }
+                break;
+            }
+
+            secp256k1_fe_inv_all_var(inv, den, n_round);
+            for (k = 0; k < n_round; k++) {
+                secp256k1_ge *b = &abuckets[round_buckets[k]];
+                secp256k1_ge *p = &round_pts[k];
+                secp256k1_fe lambda, t;
+
+                /* lambda = (y2 - y1) / (x2 - x1), or 3*x1^2 / (2*y1) for a doubling */
+                if (secp256k1_fe_equal_var(&b->x, &p->x)) {
+                    secp256k1_fe_sqr(&t, &b->x);
+                    secp256k1_fe_mul_int(&t, 3);
+                } else {
+                    secp256k1_fe_negate(&t, &b->y, 1);
+                    secp256k1_fe_add(&t, &p->y);
+                }
+                secp256k1_fe_mul(&lambda, &t, &inv[k]);
+                /* x3 = lambda^2 - x1 - x2 */
+                secp256k1_fe_sqr(&t, &lambda);
+                secp256k1_fe_negate(&p->y, &b->x, 1);
+                secp256k1_fe_add(&t, &p->y);
+                secp256k1_fe_negate(&p->x, &p->x, 1);
+                secp256k1_fe_add(&t, &p->x);
+                /* y3 = lambda*(x1 - x3) - y1 */
+                secp256k1_fe_negate(&p->x, &t, 5);
+                secp256k1_fe_add(&p->x, &b->x);
+                b->x = t;
+                secp256k1_fe_normalize_weak(&b->x);
+                secp256k1_fe_mul(&t, &lambda, &p->x);
+                secp256k1_fe_negate(&b->y, &b->y, 1);
+                secp256k1_fe_add(&b->y, &t);
+                secp256k1_fe_normalize_weak(&b->y);
+            }
+        }
+
+        for(j = 0; j < bucket_window; j++) {
+            secp256k1_gej_double_var(r, r, NULL);
+        }
+
+        /* Accumulate the sum as in pippenger_wnaf. */
+        secp256k1_gej_set_infinity(&running_sum);
+        for(j = n_buckets - 1; j >= 0; j--) {
+            if (start[j] == -1) {
+                secp256k1_gej_add_var(&running_sum, &running_sum, &buckets[j], NULL);
+            } else {
+                secp256k1_gej_add_ge_var(&running_sum, &running_sum, &abuckets[j], NULL);
+            }
+            if (j == 0) {
+                break;
+            }
+            secp256k1_gej_add_var(r, r, &running_sum, NULL);
+        }
+        secp256k1_gej_double_var(r, r, NULL);
+        secp256k1_gej_add_var(r, r, &running_sum, NULL);
+    }
+    return 1;
+}
+
 /**
  * Returns optimal bucket_window (number of bits of a scalar represented by a
  * set of buckets) for a given number of points.
  */
+static const size_t secp256k1_pippenger_window_limits[PIPPENGER_MAX_BUCKET_WINDOW - 1] = {
+    ECMULT_PIPPENGER_WINDOW_LIMITS
+};
+
 static int secp256k1_pippenger_bucket_window(size_t n) {
-    if (n <= 1) {
-        return 1;
-    } else if (n <= 4) {
-        return 2;
-    } else if (n <= 20) {
-        return 3;
-    } else if (n <= 57) {
-        return 4;
-    } else if (n <= 136) {
-        return 5;
-    } else if (n <= 235) {
-        return 6;
-    } else if (n <= 1260) {
-        return 7;
-    } else if (n <= 4420) {
-        return 9;
-    } else if (n <= 7880) {
-        return 10;
-    } else if (n <= 16050) {
-        return 11;
-    } else {
-        return PIPPENGER_MAX_BUCKET_WINDOW;
+    int bucket_window;
+    for (bucket_window = 1; bucket_window < PIPPENGER_MAX_BUCKET_WINDOW; bucket_window++) {
+        if (n <= secp256k1_pippenger_window_limits[bucket_window - 1]) {
+            return bucket_window;
+        }
     }
+    return PIPPENGER_MAX_BUCKET_WINDOW;
 }
 
 /**
  * Returns the maximum optimal number of points for a bucket_window.
  */
 static size_t secp256k1_pippenger_bucket_window_inv(int bucket_window) {
-    switch(bucket_window) {
-        case 1: return 1;
-        case 2: return 4;
-        case 3: return 20;
-        case 4: return 57;
-        case 5: return 136;
-        case 6: return 235;
-        case 7: return 1260;
-        case 8: return 1260;
-        case 9: return 4420;
-        case 10: return 7880;
-        case 11: return 16050;
-        case PIPPENGER_MAX_BUCKET_WINDOW: return SIZE_MAX;
+    if (bucket_window < 1 || bucket_window > PIPPENGER_MAX_BUCKET_WINDOW) {
+        return 0;
     }
-    return 0;
+    if (bucket_window == PIPPENGER_MAX_BUCKET_WINDOW) {
+        return SIZE_MAX;
+    }
+    return secp256k1_pippenger_window_limits[bucket_window - 1];
 }
 
 
@@ -856,17 +1633,37 @@ SECP256K1_INLINE static void secp256k1_ecmult_endo_split(secp256k1_scalar *s1, s
     }
 }
 
+/** Returns the scratch size needed per entry (a point of the endomorphism split). */
+static size_t secp256k1_pippenger_entry_size(int bucket_window) {
+    size_t entry_size = sizeof(secp256k1_ge) + sizeof(secp256k1_scalar) + sizeof(struct secp256k1_pippenger_point_state) + (WNAF_SIZE(bucket_window+1)+1)*sizeof(int);
+    if (bucket_window >= PIPPENGER_AFFINE_MIN_WINDOW) {
+        entry_size += 2*sizeof(struct secp256k1_pippenger_add);
+    }
+    return entry_size;
+}
+
+/** Returns the scratch size needed for the buckets. */
+static size_t secp256k1_pippenger_buckets_size(int bucket_window) {
+    size_t bucket_size = sizeof(secp256k1_gej);
+    if (bucket_window >= PIPPENGER_AFFINE_MIN_WINDOW) {
+        bucket_size += 2*sizeof(secp256k1_ge) + 2*sizeof(secp256k1_fe) + 4*sizeof(int);
+        /* start has one more entry than there are buckets */
+        return (bucket_size << bucket_window) + sizeof(int);
+    }
+    return bucket_size << bucket_window;
+}
+
 /**
  * Returns the scratch size required for a given number of points (excluding
  * base point G) without considering alignment.
  */
 static size_t secp256k1_pippenger_scratch_size(size_t n_points, int bucket_window) {
     size_t entries = 2*n_points + 2;
-    size_t entry_size = sizeof(secp256k1_ge) + sizeof(secp256k1_scalar) + sizeof(struct secp256k1_pippenger_point_state) + (WNAF_SIZE(bucket_window+1)+1)*sizeof(int);
-    return (sizeof(secp256k1_gej) << bucket_window) + sizeof(struct secp256k1_pippenger_state) + entries * entry_size;
+    return secp256k1_pippenger_buckets_size(bucket_window) + sizeof(struct secp256k1_pippenger_state) + entries * secp256k1_pippenger_entry_size(bucket_window);
 }
 
-static int secp256k1_ecmult_pippenger_batch(const secp256k1_callback* error_callback, const secp256k1_ecmult_context *ctx, secp256k1_scratch *scratch, secp256k1_gej *r, const secp256k1_scalar *inp_g_sc, secp256k1_ecmult_multi_callback cb, void *cbdata, size_t n_points, size_t cb_offset) {
+/* Like secp256k1_ecmult_pippenger_batch, with a given bucket_window. */
+static int secp256k1_ecmult_pippenger_batch_window(const secp256k1_callback* error_callback, secp256k1_scratch *scratch, secp256k1_gej *r, const secp256k1_scalar *inp_g_sc, secp256k1_ecmult_multi_callback cb, void *cbdata, size_t n_points, size_t cb_offset, int bucket_window) {
     const size_t scratch_checkpoint = secp256k1_scratch_checkpoint(error_callback, scratch);
     /* Use 2(n+1) with the endomorphism, when calculating batch
      * sizes. The reason for +1 is that we add the G scalar to the list of
@@ -879,15 +1676,13 @@ static int secp256k1_ecmult_pippenger_batch(const secp256k1_callback* error_call
     size_t idx = 0;
     size_t point_idx = 0;
     int i, j;
-    int bucket_window;
 
-    (void)ctx;
+    VERIFY_CHECK(bucket_window >= 1 && bucket_window <= PIPPENGER_MAX_BUCKET_WINDOW);
     secp256k1_gej_set_infinity(r);
     if (inp_g_sc == NULL && n_points == 0) {
         return 1;
     }
 
-    bucket_window = secp256k1_pippenger_bucket_window(n_points);
     points = (secp256k1_ge *) secp256k1_scratch_alloc(error_callback, scratch, entries * sizeof(*points));
     scalars = (secp256k1_scalar *) secp256k1_scratch_alloc(error_callback, scratch, entries * sizeof(*scalars));
     state_space = (struct secp256k1_pippenger_state *) secp256k1_scratch_alloc(error_callback, scratch, sizeof(*state_space));
@@ -903,6 +1698,21 @@ static int secp256k1_ecmult_pippenger_batch(const secp256k1_callback* error_call
         secp256k1_scratch_apply_checkpoint(error_callback, scratch, scratch_checkpoint);
         return 0;
     }
+    if (bucket_window >= PIPPENGER_AFFINE_MIN_WINDOW) {
+        state_space->adds = (struct secp256k1_pippenger_add *) secp256k1_scratch_alloc(error_callback, scratch, 2*entries * sizeof(*state_space->adds));
+        state_space->start = (int *) secp256k1_scratch_alloc(error_callback, scratch, ((1<<bucket_window) + 1) * sizeof(*state_space->start));
+        state_space->next = (int *) secp256k1_scratch_alloc(error_callback, scratch, (1<<bucket_window) * sizeof(*state_space->next));
+        state_space->active = (int *) secp256k1_scratch_alloc(error_callback, scratch, (1<<bucket_window) * sizeof(*state_space->active));
+        state_space->round_pts = (secp256k1_ge *) secp256k1_scratch_alloc(error_callback, scratch, (1<<bucket_window) * sizeof(*state_space->round_pts));
+        state_space->round_buckets = (int *) secp256k1_scratch_alloc(error_callback, scratch, (1<<bucket_window) * sizeof(*state_space->round_buckets));
+        state_space->den = (secp256k1_fe *) secp256k1_scratch_alloc(error_callback, scratch, (2<<bucket_window) * sizeof(*state_space->den));
+        state_space->abuckets = (secp256k1_ge *) secp256k1_scratch_alloc(error_callback, scratch, (1<<bucket_window) * sizeof(*state_space->abuckets));
+        if (state_space->adds == NULL || state_space->start == NULL || state_space->next == NULL || state_space->active == NULL
+            || state_space->round_pts == NULL || state_space->round_buckets == NULL || state_space->den == NULL || state_space->abuckets == NULL) {
+            secp256k1_scratch_apply_checkpoint(error_callback, scratch, scratch_checkpoint);
+            return 0;
+        }
+    }
 
     if (inp_g_sc != NULL) {
         scalars[0] = *inp_g_sc;
@@ -923,7 +1733,11 @@ static int secp256k1_ecmult_pippenger_batch(const secp256k1_callback* error_call
         point_idx++;
     }
 
-    secp256k1_ecmult_pippenger_wnaf(buckets, bucket_window, state_space, r, scalars, points, idx);
+    if (bucket_window >= PIPPENGER_AFFINE_MIN_WINDOW) {
+        secp256k1_ecmult_pippenger_wnaf_affine(buckets, bucket_window, state_space, r, scalars, points, idx);
+    } else {
+        secp256k1_ecmult_pippenger_wnaf(buckets, bucket_window, state_space, r, scalars, points, idx);
+    }
 
     /* Clear data */
     for(i = 0; (size_t)i < idx; i++) {
@@ -936,10 +1750,20 @@ static int secp256k1_ecmult_pippenger_batch(const secp256k1_callback* error_call
     for(i = 0; i < 1<<bucket_window; i++) {
         secp256k1_gej_clear(&buckets[i]);
     }
+    if (bucket_window >= PIPPENGER_AFFINE_MIN_WINDOW) {
+        for(i = 0; i < 1<<bucket_window; i++) {
+            secp256k1_ge_clear(&state_space->abuckets[i]);
+        }
+    }
     secp256k1_scratch_apply_checkpoint(error_callback, scratch, scratch_checkpoint);
     return 1;
 }
 
+static int secp256k1_ecmult_pippenger_batch(const secp256k1_callback* error_callback, const secp256k1_ecmult_context *ctx, secp256k1_scratch *scratch, secp256k1_gej *r, const secp256k1_scalar *inp_g_sc, secp256k1_ecmult_multi_callback cb, void *cbdata, size_t n_points, size_t cb_offset) {
+    (void)ctx;
+    return secp256k1_ecmult_pippenger_batch_window(error_callback, scratch, r, inp_g_sc, cb, cbdata, n_points, cb_offset, secp256k1_pippenger_bucket_window(n_points));
+}
+
 /* Wrapper for secp256k1_ecmult_multi_func interface */
 static int secp256k1_ecmult_pippenger_batch_single(const secp256k1_callback* error_callback, const secp256k1_ecmult_context *actx, secp256k1_scratch *scratch, secp256k1_gej *r, const secp256k1_scalar *inp_g_sc, secp256k1_ecmult_multi_callback cb, void *cbdata, size_t n) {
     return secp256k1_ecmult_pippenger_batch(error_callback, actx, scratch, r, inp_g_sc, cb, cbdata, n, 0);
@@ -960,10 +1784,9 @@ static size_t secp256k1_pippenger_max_points(const secp256k1_callback* error_cal
         size_t max_points = secp256k1_pippenger_bucket_window_inv(bucket_window);
         size_t space_for_points;
         size_t space_overhead;
-        size_t entry_size = sizeof(secp256k1_ge) + sizeof(secp256k1_scalar) + sizeof(struct secp256k1_pippenger_point_state) + (WNAF_SIZE(bucket_window+1)+1)*sizeof(int);
+        size_t entry_size = 2*secp256k1_pippenger_entry_size(bucket_window);
 
-        entry_size = 2*entry_size;
-        space_overhead = (sizeof(secp256k1_gej) << bucket_window) + entry_size + sizeof(struct secp256k1_pippenger_state);
+        space_overhead = secp256k1_pippenger_buckets_size(bucket_window) + entry_size + sizeof(struct secp256k1_pippenger_state);
         if (space_overhead > max_alloc) {
             break;
         }
@@ -991,6 +1814,7 @@ static int secp256k1_ecmult_multi_simple_var(const secp256k1_ecmult_context *ctx
     secp256k1_scalar szero;
     secp256k1_gej tmpj;
 
+    SECP256K1_COUNT(ECMULT_MULTI_SIMPLE);
     secp256k1_scalar_set_int(&szero, 0);
     secp256k1_gej_set_infinity(r);
     secp256k1_gej_set_infinity(&tmpj);
@@ -1031,6 +1855,34 @@ static int secp256k1_ecmult_multi_batch_size_helper(size_t *n_batches, size_t *n
     return 1;
 }
 
+/* The scratch space size for a single batch of n_points points (capped at the
+ * largest batch) with Pippenger's algorithm if pippenger is set, and Strauss'
+ * otherwise. */
+static size_t secp256k1_ecmult_multi_algorithm_scratch_size(size_t n_points, int pippenger) {
+    if (n_points == 0) {
+        return 0;
+    }
+    if (n_points > ECMULT_MAX_POINTS_PER_BATCH) {
+        n_points = ECMULT_MAX_POINTS_PER_BATCH;
+    }
+    if (pippenger) {
+        return secp256k1_pippenger_scratch_size(n_points, secp256k1_pippenger_bucket_window(n_points)) + PIPPENGER_SCRATCH_OBJECTS*ALIGNMENT;
+    }
+    return secp256k1_strauss_scratch_size(n_points) + STRAUSS_SCRATCH_OBJECTS*ALIGNMENT;
+}
+
+/* Whether secp256k1_ecmult_multi_var uses Pippenger's algorithm for n_points points,
+ * given enough scratch space. */
+static int secp256k1_ecmult_multi_use_pippenger(size_t n_points) {
+    return n_points >= ECMULT_PIPPENGER_THRESHOLD;
+}
+
+/* The scratch space size that lets secp256k1_ecmult_multi_var process n_points
+ * points in a single batch with the fastest algorithm. */
+static size_t secp256k1_ecmult_multi_scratch_size_helper(size_t n_points) {
+    return secp256k1_ecmult_multi_algorithm_scratch_size(n_points, secp256k1_ecmult_multi_use_pippenger(n_points));
+}
+
 typedef int (*secp256k1_ecmult_multi_func)(const secp256k1_callback* error_callback, const secp256k1_ecmult_context*, secp256k1_scratch*, secp256k1_gej*, const secp256k1_scalar*, secp256k1_ecmult_multi_callback cb, void*, size_t);
 static int secp256k1_ecmult_multi_var(const secp256k1_callback* error_callback, const secp256k1_ecmult_context *ctx, secp256k1_scratch *scratch, secp256k1_gej *r, const secp256k1_scalar *inp_g_sc, secp256k1_ecmult_multi_callback cb, void *cbdata, size_t n) {
     size_t i;
@@ -1038,6 +1890,8 @@ static int secp256k1_ecmult_multi_var(const secp256k1_callback* error_callback,
     int (*f)(const secp256k1_callback* error_callback, const secp256k1_ecmult_context*, secp256k1_scratch*, secp256k1_gej*, const secp256k1_scalar*, secp256k1_ecmult_multi_callback cb, void*, size_t, size_t);
     size_t n_batches;
     size_t n_batch_points;
+    size_t pippenger_max_points;
+    size_t scratch_size;
 
     secp256k1_gej_set_infinity(r);
     if (inp_g_sc == NULL && n == 0) {
@@ -1051,21 +1905,34 @@ static int secp256k1_ecmult_multi_var(const secp256k1_callback* error_callback,
     if (scratch == NULL) {
         return secp256k1_ecmult_multi_simple_var(ctx, r, inp_g_sc, cb, cbdata, n);
     }
+    scratch_size = secp256k1_ecmult_multi_scratch_size_helper(n);
+    if (!secp256k1_scratch_grow(error_callback, scratch, scratch_size)) {
+        secp256k1_event_callback_call(&scratch->event_callback, SECP256K1_EVENT_SCRATCH_TOO_SMALL, scratch_size, scratch->max_size - scratch->alloc_size);
+    }
 
     /* Compute the batch sizes for Pippenger's algorithm given a scratch space. If it's greater than
-     * a threshold use Pippenger's algorithm. Otherwise use Strauss' algorithm.
-     * As a first step check if there's enough space for Pippenger's algo (which requires less space
-     * than Strauss' algo) and if not, use the simple algorithm. */
-    if (!secp256k1_ecmult_multi_batch_size_helper(&n_batches, &n_batch_points, secp256k1_pippenger_max_points(error_callback, scratch), n)) {
-        return secp256k1_ecmult_multi_simple_var(ctx, r, inp_g_sc, cb, cbdata, n);
-    }
-    if (n_batch_points >= ECMULT_PIPPENGER_THRESHOLD) {
+     * a threshold use Pippenger's algorithm. Otherwise use Strauss' algorithm, unless the scratch
+     * space does not fit a single point for it, and fall back to Pippenger's in that case.
+     * Neither algorithm needs less space than the other for very few points: Pippenger's has a
+     * fixed overhead, and Strauss' tables grow with WINDOW_A. If neither fits a single point, use
+     * the simple algorithm. */
+    pippenger_max_points = secp256k1_pippenger_max_points(error_callback, scratch);
+    if (secp256k1_ecmult_multi_batch_size_helper(&n_batches, &n_batch_points, pippenger_max_points, n)
+        && n_batch_points >= ECMULT_PIPPENGER_THRESHOLD) {
         f = secp256k1_ecmult_pippenger_batch;
-    } else {
-        if (!secp256k1_ecmult_multi_batch_size_helper(&n_batches, &n_batch_points, secp256k1_strauss_max_points(error_callback, scratch), n)) {
-            return secp256k1_ecmult_multi_simple_var(ctx, r, inp_g_sc, cb, cbdata, n);
+    } else if (secp256k1_ecmult_multi_batch_size_helper(&n_batches, &n_batch_points, secp256k1_strauss_max_points(error_callback, scratch), n)) {
+        if (secp256k1_ecmult_multi_use_pippenger(n)) {
+            secp256k1_event_callback_call(&scratch->event_callback, SECP256K1_EVENT_ECMULT_MULTI_STRAUSS, n, n_batch_points);
         }
         f = secp256k1_ecmult_strauss_batch;
+    } else if (secp256k1_ecmult_multi_batch_size_helper(&n_batches, &n_batch_points, pippenger_max_points, n)) {
+        f = secp256k1_ecmult_pippenger_batch;
+    } else {
+        secp256k1_event_callback_call(&scratch->event_callback, SECP256K1_EVENT_ECMULT_MULTI_SIMPLE, n, scratch->max_size - scratch->alloc_size);
+        return secp256k1_ecmult_multi_simple_var(ctx, r, inp_g_sc, cb, cbdata, n);
+    }
+    if (n_batches > 1) {
+        secp256k1_event_callback_call(&scratch->event_callback, SECP256K1_EVENT_ECMULT_MULTI_SPLIT, n, n_batch_points);
     }
     for(i = 0; i < n_batches; i++) {
         size_t nbp = n < n_batch_points ? n : n_batch_points;
@@ -1080,4 +1947,141 @@ static int secp256k1_ecmult_multi_var(const secp256k1_callback* error_callback,
     return 1;
 }
 
+/* Adds an offset to the indices passed to the wrapped callback, to let a task
+ * of secp256k1_ecmult_multi_parallel_var see its slice of the input as [0, n). */
+typedef struct {
+    secp256k1_ecmult_multi_callback *cb;
+    void *cbdata;
+    size_t offset;
+} secp256k1_ecmult_multi_offset_data;
+
+static int secp256k1_ecmult_multi_offset_callback(secp256k1_scalar *sc, secp256k1_ge *pt, size_t idx, void *data) {
+    const secp256k1_ecmult_multi_offset_data *offset_data = (const secp256k1_ecmult_multi_offset_data *) data;
+    return offset_data->cb(sc, pt, idx + offset_data->offset, offset_data->cbdata);
+}
+
+/* State shared by all tasks of secp256k1_ecmult_multi_parallel_var. Every
+ * task only writes to its own entries of scratch, r and ret. */
+typedef struct {
+    const secp256k1_callback *error_callback;
+    const secp256k1_ecmult_context *ctx;
+    secp256k1_scratch *scratch;
+    secp256k1_gej *r;
+    int *ret;
+    const secp256k1_scalar *inp_g_sc;
+    secp256k1_ecmult_multi_callback *cb;
+    void *cbdata;
+    size_t n;
+    size_t n_tasks;
+    size_t n_task_points;
+} secp256k1_ecmult_multi_parallel_context;
+
+static void secp256k1_ecmult_multi_parallel_task(size_t idx, void *data) {
+    const secp256k1_ecmult_multi_parallel_context *pctx = (const secp256k1_ecmult_multi_parallel_context *) data;
+    secp256k1_ecmult_multi_offset_data offset_data;
+    size_t offset, n;
+
+    if (idx >= pctx->n_tasks) {
+        return;
+    }
+    offset = idx * pctx->n_task_points;
+    n = pctx->n - offset < pctx->n_task_points ? pctx->n - offset : pctx->n_task_points;
+    offset_data.cb = pctx->cb;
+    offset_data.cbdata = pctx->cbdata;
+    offset_data.offset = offset;
+    /* The generator term is only added by the first task */
+    pctx->ret[idx] = secp256k1_ecmult_multi_var(pctx->error_callback, pctx->ctx, &pctx->scratch[idx], &pctx->r[idx], idx == 0 ? pctx->inp_g_sc : NULL, secp256k1_ecmult_multi_offset_callback, &offset_data, n);
+}
+
+/* Number of tasks secp256k1_ecmult_multi_parallel_var creates for n points. */
+static size_t secp256k1_ecmult_multi_parallel_n_tasks(size_t n, size_t n_tasks) {
+    if (n_tasks > ECMULT_MAX_PARALLEL_TASKS) {
+        n_tasks = ECMULT_MAX_PARALLEL_TASKS;
+    }
+    if (n_tasks > n) {
+        n_tasks = n;
+    }
+    if (n_tasks <= 1) {
+        return n_tasks;
+    }
+    /* Every task gets ceil(n/n_tasks) points, which may leave the last ones empty */
+    return 1 + (n - 1) / (1 + (n - 1) / n_tasks);
+}
+
+/* Scratch space used by secp256k1_ecmult_multi_parallel_var for its own
+ * bookkeeping, before the rest is divided between the tasks. */
+static size_t secp256k1_ecmult_multi_parallel_scratch_overhead(size_t n_tasks) {
+    return ROUND_TO_ALIGN(n_tasks * sizeof(secp256k1_scratch))
+        + ROUND_TO_ALIGN(n_tasks * sizeof(secp256k1_gej))
+        + ROUND_TO_ALIGN(n_tasks * sizeof(int));
+}
+
+/* The scratch space size that lets every task of secp256k1_ecmult_multi_parallel_var
+ * process its points in a single batch with the fastest algorithm. */
+static size_t secp256k1_ecmult_multi_parallel_scratch_size_helper(size_t n_points, size_t n_tasks) {
+    size_t task_size;
+
+    n_tasks = secp256k1_ecmult_multi_parallel_n_tasks(n_points, n_tasks);
+    if (n_tasks <= 1) {
+        return n_tasks == 0 ? 0 : secp256k1_ecmult_multi_scratch_size_helper(n_points);
+    }
+    /* Every task gets an equal share rounded down to the alignment, so round
+     * each share up to make sure that it is not truncated. */
+    task_size = ROUND_TO_ALIGN(secp256k1_ecmult_multi_scratch_size_helper(1 + (n_points - 1) / n_tasks));
+    return secp256k1_ecmult_multi_parallel_scratch_overhead(n_tasks) + n_tasks * task_size;
+}
+
+static int secp256k1_ecmult_multi_parallel_var(const secp256k1_callback* error_callback, const secp256k1_ecmult_context *ctx, secp256k1_scratch *scratch, secp256k1_gej *r, const secp256k1_scalar *inp_g_sc, secp256k1_ecmult_multi_callback cb, void *cbdata, size_t n, size_t n_tasks, secp256k1_ecmult_multi_runner runner, void *runner_data) {
+    secp256k1_ecmult_multi_parallel_context pctx;
+    size_t checkpoint, task_scratch_size, i;
+    int ret = 1;
+
+    n_tasks = secp256k1_ecmult_multi_parallel_n_tasks(n, n_tasks);
+    if (n_tasks <= 1 || scratch == NULL) {
+        return secp256k1_ecmult_multi_var(error_callback, ctx, scratch, r, inp_g_sc, cb, cbdata, n);
+    }
+    secp256k1_scratch_grow(error_callback, scratch, secp256k1_ecmult_multi_parallel_scratch_size_helper(n, n_tasks));
+
+    checkpoint = secp256k1_scratch_checkpoint(error_callback, scratch);
+    pctx.scratch = (secp256k1_scratch *) secp256k1_scratch_alloc(error_callback, scratch, n_tasks * sizeof(secp256k1_scratch));
+    pctx.r = (secp256k1_gej *) secp256k1_scratch_alloc(error_callback, scratch, n_tasks * sizeof(secp256k1_gej));
+    pctx.ret = (int *) secp256k1_scratch_alloc(error_callback, scratch, n_tasks * sizeof(int));
+    if (pctx.scratch == NULL || pctx.r == NULL || pctx.ret == NULL) {
+        secp256k1_scratch_apply_checkpoint(error_callback, scratch, checkpoint);
+        return secp256k1_ecmult_multi_var(error_callback, ctx, scratch, r, inp_g_sc, cb, cbdata, n);
+    }
+    /* Divide the remaining space evenly. A task whose share is too small for
+     * Strauss' or Pippenger's algorithm falls back to the simple one. */
+    task_scratch_size = secp256k1_scratch_max_allocation(error_callback, scratch, 0) / n_tasks;
+    task_scratch_size -= task_scratch_size % ALIGNMENT;
+    for (i = 0; i < n_tasks; i++) {
+        int res = secp256k1_scratch_alloc_child(error_callback, scratch, &pctx.scratch[i], task_scratch_size);
+        VERIFY_CHECK(res);
+        (void)res;
+    }
+
+    pctx.error_callback = error_callback;
+    pctx.ctx = ctx;
+    pctx.inp_g_sc = inp_g_sc;
+    pctx.cb = cb;
+    pctx.cbdata = cbdata;
+    pctx.n = n;
+    pctx.n_tasks = n_tasks;
+    pctx.n_task_points = 1 + (n - 1) / n_tasks;
+    /* ret was zeroed by the allocation, so tasks that are not run count as failed */
+    if (!runner(secp256k1_ecmult_multi_parallel_task, &pctx, n_tasks, runner_data)) {
+        ret = 0;
+    }
+
+    secp256k1_gej_set_infinity(r);
+    for (i = 0; i < n_tasks && ret; i++) {
+        ret = pctx.ret[i];
+        if (ret) {
+            secp256k1_gej_add_var(r, r, &pctx.r[i], NULL);
+        }
+    }
+    secp256k1_scratch_apply_checkpoint(error_callback, scratch, checkpoint);
+    return ret;
+}
+
 #endif /* SECP256K1_ECMULT_IMPL_H */
@@ -86,6 +86,10 @@ static void secp256k1_fe_negate(secp256k1_fe *r, const secp256k1_fe *a, int m);
  *  small integer. */
 static void secp256k1_fe_mul_int(secp256k1_fe *r, int a);
 
+/** Halves the passed field element (modulo p). Requires the input magnitude to be at most 31; the
+ *  output has magnitude (m >> 1) + 1 and is not normalized. Runs in constant time. */
+static void secp256k1_fe_half(secp256k1_fe *r);
+
 /** Adds a field element to another. The result has the sum of the inputs' magnitudes as magnitude. */
 static void secp256k1_fe_add(secp256k1_fe *r, const secp256k1_fe *a);
 
@@ -117,6 +121,9 @@ static void secp256k1_fe_inv_var(secp256k1_fe *r, const secp256k1_fe *a);
 /** Calculate the (modular) inverses of a batch of field elements. Requires the inputs' magnitudes to be
  *  at most 8. The output magnitudes are 1 (but not guaranteed to be normalized). The inputs and
  *  outputs must not overlap in memory. */
+static void secp256k1_fe_inv_all(secp256k1_fe *r, const secp256k1_fe *a, size_t len);
+
+/** Potentially faster version of secp256k1_fe_inv_all, without constant-time guarantee. */
 static void secp256k1_fe_inv_all_var(secp256k1_fe *r, const secp256k1_fe *a, size_t len);
 
 /** Convert a field element to the storage type. */
@@ -52,4 +52,9 @@ typedef struct {
     (uint32_t)(d.n[1] >> 32), (uint32_t)d.n[1], \
     (uint32_t)(d.n[0] >> 32), (uint32_t)d.n[0]
 
+#if defined(USE_FIELD_5X52_IFMA)
+/* Eight-way field multiplication is available, see field_5x52_ifma_impl.h. */
+#define SECP256K1_FE_X8 1
+#endif
+
 #endif /* SECP256K1_FIELD_REPR_H */
@@ -0,0 +1,403 @@
+/**********************************************************************
+ * Distributed under the MIT software license, see the accompanying   *
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
+ **********************************************************************/
+
+#ifndef SECP256K1_FIELD_INNER5X52_IMPL_H
+#define SECP256K1_FIELD_INNER5X52_IMPL_H
+
+/* AArch64 versions of secp256k1_fe_mul_inner and secp256k1_fe_sqr_inner, following the
+ * same steps as field_5x52_int128_impl.h (which documents the limb bounds). Each 128-bit
+ * accumulator is kept in a register pair (xl, xh), products are formed with mul/umulh,
+ * and a 128-bit shift right by 52 is an extr/lsr pair. M = 2^52 - 1 is encoded as a
+ * logical immediate; R = 0x1000003D10 is built with mov/movk. */
+
+#include <stdint.h>
+
+SECP256K1_INLINE static void secp256k1_fe_mul_inner(uint64_t *r, const uint64_t *a, const uint64_t * SECP256K1_RESTRICT b) {
+    uint64_t a0, a1, a2, a3, a4, bx, cl, ch, dl, dh, pl, ph, t, t3, t4, tx, R;
+
+    VERIFY_CHECK(r != b);
+    VERIFY_CHECK(a != b);
+
+__asm__ __volatile__(
+    "ldp %[a0], %[a1], [%[a]]\n"
+    "ldp %[a2], %[a3], [%[a], #16]\n"
+    "ldr %[a4], [%[a], #32]\n"
+    "mov %[R], #0x3d10\n"
+    "movk %[R], #0x10, lsl #32\n"
+    /* d = a0*b3 + a1*b2 + a2*b1 + a3*b0 */
+    "ldr %[bx], [%[b], #24]\n"
+    "mul %[dl], %[a0], %[bx]\n"
+    "umulh %[dh], %[a0], %[bx]\n"
+    "ldr %[bx], [%[b], #16]\n"
+    "mul %[pl], %[a1], %[bx]\n"
+    "umulh %[ph], %[a1], %[bx]\n"
+    "adds %[dl], %[dl], %[pl]\n"
+    "adc %[dh], %[dh], %[ph]\n"
+    "ldr %[bx], [%[b], #8]\n"
+    "mul %[pl], %[a2], %[bx]\n"
+    "umulh %[ph], %[a2], %[bx]\n"
+    "adds %[dl], %[dl], %[pl]\n"
+    "adc %[dh], %[dh], %[ph]\n"
+    "ldr %[bx], [%[b]]\n"
+    "mul %[pl], %[a3], %[bx]\n"
+    "umulh %[ph], %[a3], %[bx]\n"
+    "adds %[dl], %[dl], %[pl]\n"
+    "adc %[dh], %[dh], %[ph]\n"
+    /* c = a4*b4 */
+    "ldr %[bx], [%[b], #32]\n"
+    "mul %[cl], %[a4], %[bx]\n"
+    "umulh %[ch], %[a4], %[bx]\n"
+    /* d += (c & M) * R; c >>= 52 */
+    "and %[t], %[cl], #0xfffffffffffff\n"
+    "mul %[pl], %[t], %[R]\n"
+    "umulh %[ph], %[t], %[R]\n"
+    "adds %[dl], %[dl], %[pl]\n"
+    "adc %[dh], %[dh], %[ph]\n"
+    "extr %[cl], %[ch], %[cl], #52\n"
+    /* t3 = d & M; d >>= 52 */
+    "and %[t3], %[dl], #0xfffffffffffff\n"
+    "extr %[dl], %[dh], %[dl], #52\n"
+    "lsr %[dh], %[dh], #52\n"
+    /* d += a0*b4 + a1*b3 + a2*b2 + a3*b1 + a4*b0 */
+    "ldr %[bx], [%[b], #32]\n"
+    "mul %[pl], %[a0], %[bx]\n"
+    "umulh %[ph], %[a0], %[bx]\n"
+    "adds %[dl], %[dl], %[pl]\n"
+    "adc %[dh], %[dh], %[ph]\n"
+    "ldr %[bx], [%[b], #24]\n"
+    "mul %[pl], %[a1], %[bx]\n"
+    "umulh %[ph], %[a1], %[bx]\n"
+    "adds %[dl], %[dl], %[pl]\n"
+    "adc %[dh], %[dh], %[ph]\n"
+    "ldr %[bx], [%[b], #16]\n"
+    "mul %[pl], %[a2], %[bx]\n"
+    "umulh %[ph], %[a2], %[bx]\n"
+    "adds %[dl], %[dl], %[pl]\n"
+    "adc %[dh], %[dh], %[ph]\n"
+    "ldr %[bx], [%[b], #8]\n"
+    "mul %[pl], %[a3], %[bx]\n"
+    "umulh %[ph], %[a3], %[bx]\n"
+    "adds %[dl], %[dl], %[pl]\n"
+    "adc %[dh], %[dh], %[ph]\n"
+    "ldr %[bx], [%[b]]\n"
+    "mul %[pl], %[a4], %[bx]\n"
+    "umulh %[ph], %[a4], %[bx]\n"
+    "adds %[dl], %[dl], %[pl]\n"
+    "adc %[dh], %[dh], %[ph]\n"
+    /* d += c * R */
+    "mul %[pl], %[cl], %[R]\n"
+    "umulh %[ph], %[cl], %[R]\n"
+    "adds %[dl], %[dl], %[pl]\n"
+    "adc %[dh], %[dh], %[ph]\n"
+    /* t4 = d & M; d >>= 52; tx = t4 >> 48; t4 &= (M >> 4) */
+    "and %[t4], %[dl], #0xfffffffffffff\n"
+    "extr %[dl], %[dh], %[dl], #52\n"
+    "lsr %[dh], %[dh], #52\n"
+    "lsr %[tx], %[t4], #48\n"
+    "and %[t4], %[t4], #0xffffffffffff\n"
+    /* c = a0*b0 */
+    "ldr %[bx], [%[b]]\n"
+    "mul %[cl], %[a0], %[bx]\n"
+    "umulh %[ch], %[a0], %[bx]\n"
+    /* d += a1*b4 + a2*b3 + a3*b2 + a4*b1 */
+    "ldr %[bx], [%[b], #32]\n"
+    "mul %[pl], %[a1], %[bx]\n"
+    "umulh %[ph], %[a1], %[bx]\n"
+    "adds %[dl], %[dl], %[pl]\n"
+    "adc %[dh], %[dh], %[ph]\n"
+    "ldr %[bx], [%[b], #24]\n"
+    "mul %[pl], %[a2], %[bx]\n"
+    "umulh %[ph], %[a2], %[bx]\n"
+    "adds %[dl], %[dl], %[pl]\n"
+    "adc %[dh], %[dh], %[ph]\n"
+    "ldr %[bx], [%[b], #16]\n"
+    "mul %[pl], %[a3], %[bx]\n"
+    "umulh %[ph], %[a3], %[bx]\n"
+    "adds %[dl], %[dl], %[pl]\n"
+    "adc %[dh], %[dh], %[ph]\n"
+    "ldr %[bx], [%[b], #8]\n"
+    "mul %[pl], %[a4], %[bx]\n"
+    "umulh %[ph], %[a4], %[bx]\n"
+    "adds %[dl], %[dl], %[pl]\n"
+    "adc %[dh], %[dh], %[ph]\n"
+    /* u0 = d & M; d >>= 52; u0 = (u0 << 4) | tx; c += u0 * (R >> 4) */
+    "and %[t], %[dl], #0xfffffffffffff\n"
+    "extr %[dl], %[dh], %[dl], #52\n"
+    "lsr %[dh], %[dh], #52\n"
+    "orr %[t], %[tx], %[t], lsl #4\n"
+    "lsr %[ph], %[R], #4\n"
+    "mul %[pl], %[t], %[ph]\n"
+    "umulh %[ph], %[t], %[ph]\n"
+    "adds %[cl], %[cl], %[pl]\n"
+    "adc %[ch], %[ch], %[ph]\n"
+    /* r[0] = c & M; c >>= 52 */
+    "and %[t], %[cl], #0xfffffffffffff\n"
+    "str %[t], [%[r]]\n"
+    "extr %[cl], %[ch], %[cl], #52\n"
+    "lsr %[ch], %[ch], #52\n"
+    /* c += a0*b1 + a1*b0 */
+    "ldr %[bx], [%[b], #8]\n"
+    "mul %[pl], %[a0], %[bx]\n"
+    "umulh %[ph], %[a0], %[bx]\n"
+    "adds %[cl], %[cl], %[pl]\n"
+    "adc %[ch], %[ch], %[ph]\n"
+    "ldr %[bx], [%[b]]\n"
+    "mul %[pl], %[a1], %[bx]\n"
+    "umulh %[ph], %[a1], %[bx]\n"
+    "adds %[cl], %[cl], %[pl]\n"
+    "adc %[ch], %[ch], %[ph]\n"
+    /* d += a2*b4 + a3*b3 + a4*b2 */
+    "ldr %[bx], [%[b], #32]\n"
+    "mul %[pl], %[a2], %[bx]\n"
+    "umulh %[ph], %[a2], %[bx]\n"
+    "adds %[dl], %[dl], %[pl]\n"
+    "adc %[dh], %[dh], %[ph]\n"
+    "ldr %[bx], [%[b], #24]\n"
+    "mul %[pl], %[a3], %[bx]\n"
+    "umulh %[ph], %[a3], %[bx]\n"
+    "adds %[dl], %[dl], %[pl]\n"
+    "adc %[dh], %[dh], %[ph]\n"
+    "ldr %[bx], [%[b], #16]\n"
+    "mul %[pl], %[a4], %[bx]\n"
+    "umulh %[ph], %[a4], %[bx]\n"
+    "adds %[dl], %[dl], %[pl]\n"
+    "adc %[dh], %[dh], %[ph]\n"
+    /* c += (d & M) * R; d >>= 52 */
+    "and %[t], %[dl], #0xfffffffffffff\n"
+    "mul %[pl], %[t], %[R]\n"
+    "umulh %[ph], %[t], %[R]\n"
+    "adds %[cl], %[cl], %[pl]\n"
+    "adc %[ch], %[ch], %[ph]\n"
+    "extr %[dl], %[dh], %[dl], #52\n"
+    "lsr %[dh], %[dh], #52\n"
+    /* r[1] = c & M; c >>= 52 */
+    "and %[t], %[cl], #0xfffffffffffff\n"
+    "str %[t], [%[r], #8]\n"
+    "extr %[cl], %[ch], %[cl], #52\n"
+    "lsr %[ch], %[ch], #52\n"
+    /* c += a0*b2 + a1*b1 + a2*b0 */
+    "ldr %[bx], [%[b], #16]\n"
+    "mul %[pl], %[a0], %[bx]\n"
+    "umulh %[ph], %[a0], %[bx]\n"
+    "adds %[cl], %[cl], %[pl]\n"
+    "adc %[ch], %[ch], %[ph]\n"
+    "ldr %[bx], [%[b], #8]\n"
+    "mul %[pl], %[a1], %[bx]\n"
+    "umulh %[ph], %[a1], %[bx]\n"
+    "adds %[cl], %[cl], %[pl]\n"
+    "adc %[ch], %[ch], %[ph]\n"
+    "ldr %[bx], [%[b]]\n"
+    "mul %[pl], %[a2], %[bx]\n"
+    "umulh %[ph], %[a2], %[bx]\n"
+    "adds %[cl], %[cl], %[pl]\n"
+    "adc %[ch], %[ch], %[ph]\n"
+    /* d += a3*b4 + a4*b3 */
+    "ldr %[bx], [%[b], #32]\n"
+    "mul %[pl], %[a3], %[bx]\n"
+    "umulh %[ph], %[a3], %[bx]\n"
+    "adds %[dl], %[dl], %[pl]\n"
+    "adc %[dh], %[dh], %[ph]\n"
+    "ldr %[bx], [%[b], #24]\n"
+    "mul %[pl], %[a4], %[bx]\n"
+    "umulh %[ph], %[a4], %[bx]\n"
+    "adds %[dl], %[dl], %[pl]\n"
+    "adc %[dh], %[dh], %[ph]\n"
+    /* c += (d & M) * R; d >>= 52 */
+    "and %[t], %[dl], #0xfffffffffffff\n"
+    "mul %[pl], %[t], %[R]\n"
+    "umulh %[ph], %[t], %[R]\n"
+    "adds %[cl], %[cl], %[pl]\n"
+    "adc %[ch], %[ch], %[ph]\n"
+    "extr %[dl], %[dh], %[dl], #52\n"
+    /* r[2] = c & M; c >>= 52 */
+    "and %[t], %[cl], #0xfffffffffffff\n"
+    "str %[t], [%[r], #16]\n"
+    "extr %[cl], %[ch], %[cl], #52\n"
+    "lsr %[ch], %[ch], #52\n"
+    /* c += d * R + t3 */
+    "mul %[pl], %[dl], %[R]\n"
+    "umulh %[ph], %[dl], %[R]\n"
+    "adds %[cl], %[cl], %[pl]\n"
+    "adc %[ch], %[ch], %[ph]\n"
+    "adds %[cl], %[cl], %[t3]\n"
+    "adc %[ch], %[ch], xzr\n"
+    /* r[3] = c & M; c >>= 52 */
+    "and %[t], %[cl], #0xfffffffffffff\n"
+    "str %[t], [%[r], #24]\n"
+    "extr %[cl], %[ch], %[cl], #52\n"
+    /* r[4] = c + t4 */
+    "add %[cl], %[cl], %[t4]\n"
+    "str %[cl], [%[r], #32]\n"
+    : [a0] "=&r"(a0), [a1] "=&r"(a1), [a2] "=&r"(a2), [a3] "=&r"(a3), [a4] "=&r"(a4), [bx] "=&r"(bx),
+      [cl] "=&r"(cl), [ch] "=&r"(ch), [dl] "=&r"(dl), [dh] "=&r"(dh), [pl] "=&r"(pl), [ph] "=&r"(ph),
+      [t] "=&r"(t), [t3] "=&r"(t3), [t4] "=&r"(t4), [tx] "=&r"(tx), [R] "=&r"(R)
+    : [r] "r"(r), [a] "r"(a), [b] "r"(b)
+    : "cc", "memory"
+);
+}
+
+SECP256K1_INLINE static void secp256k1_fe_sqr_inner(uint64_t *r, const uint64_t *a) {
+    uint64_t a0, a1, a2, a3, a4, cl, ch, dl, dh, pl, ph, t, t3, t4, tx, R;
+
+__asm__ __volatile__(
+    "ldp %[a0], %[a1], [%[a]]\n"
+    "ldp %[a2], %[a3], [%[a], #16]\n"
+    "ldr %[a4], [%[a], #32]\n"
+    "mov %[R], #0x3d10\n"
+    "movk %[R], #0x10, lsl #32\n"
+    /* d = (a0*2) * a3 + (a1*2) * a2 */
+    "lsl %[t], %[a0], #1\n"
+    "mul %[dl], %[t], %[a3]\n"
+    "umulh %[dh], %[t], %[a3]\n"
+    "lsl %[t], %[a1], #1\n"
+    "mul %[pl], %[t], %[a2]\n"
+    "umulh %[ph], %[t], %[a2]\n"
+    "adds %[dl], %[dl], %[pl]\n"
+    "adc %[dh], %[dh], %[ph]\n"
+    /* c = a4*a4 */
+    "mul %[cl], %[a4], %[a4]\n"
+    "umulh %[ch], %[a4], %[a4]\n"
+    /* d += (c & M) * R; c >>= 52 */
+    "and %[t], %[cl], #0xfffffffffffff\n"
+    "mul %[pl], %[t], %[R]\n"
+    "umulh %[ph], %[t], %[R]\n"
+    "adds %[dl], %[dl], %[pl]\n"
+    "adc %[dh], %[dh], %[ph]\n"
+    "extr %[cl], %[ch], %[cl], #52\n"
+    /* t3 = d & M; d >>= 52 */
+    "and %[t3], %[dl], #0xfffffffffffff\n"
+    "extr %[dl], %[dh], %[dl], #52\n"
+    "lsr %[dh], %[dh], #52\n"
+    /* a4 *= 2; d += a0*a4 + (a1*2) * a3 + a2*a2 */
+    "lsl %[a4], %[a4], #1\n"
+    "mul %[pl], %[a0], %[a4]\n"
+    "umulh %[ph], %[a0], %[a4]\n"
+    "adds %[dl], %[dl], %[pl]\n"
+    "adc %[dh], %[dh], %[ph]\n"
+    "lsl %[t], %[a1], #1\n"
+    "mul %[pl], %[t], %[a3]\n"
+    "umulh %[ph], %[t], %[a3]\n"
+    "adds %[dl], %[dl], %[pl]\n"
+    "adc %[dh], %[dh], %[ph]\n"
+    "mul %[pl], %[a2], %[a2]\n"
+    "umulh %[ph], %[a2], %[a2]\n"
+    "adds %[dl], %[dl], %[pl]\n"
+    "adc %[dh], %[dh], %[ph]\n"
+    /* d += c * R */
+    "mul %[pl], %[cl], %[R]\n"
+    "umulh %[ph], %[cl], %[R]\n"
+    "adds %[dl], %[dl], %[pl]\n"
+    "adc %[dh], %[dh], %[ph]\n"
+    /* t4 = d & M; d >>= 52; tx = t4 >> 48; t4 &= (M >> 4) */
+    "and %[t4], %[dl], #0xfffffffffffff\n"
+    "extr %[dl], %[dh], %[dl], #52\n"
+    "lsr %[dh], %[dh], #52\n"
+    "lsr %[tx], %[t4], #48\n"
+    "and %[t4], %[t4], #0xffffffffffff\n"
+    /* c = a0*a0 */
+    "mul %[cl], %[a0], %[a0]\n"
+    "umulh %[ch], %[a0], %[a0]\n"
+    /* d += a1*a4 + (a2*2) * a3 */
+    "mul %[pl], %[a1], %[a4]\n"
+    "umulh %[ph], %[a1], %[a4]\n"
+    "adds %[dl], %[dl], %[pl]\n"
+    "adc %[dh], %[dh], %[ph]\n"
+    "lsl %[t], %[a2], #1\n"
+    "mul %[pl], %[t], %[a3]\n"
+    "umulh %[ph], %[t], %[a3]\n"
+    "adds %[dl], %[dl], %[pl]\n"
+    "adc %[dh], %[dh], %[ph]\n"
+    /* u0 = d & M; d >>= 52; u0 = (u0 << 4) | tx; c += u0 * (R >> 4) */
+    "and %[t], %[dl], #0xfffffffffffff\n"
+    "extr %[dl], %[dh], %[dl], #52\n"
+    "lsr %[dh], %[dh], #52\n"
+    "orr %[t], %[tx], %[t], lsl #4\n"
+    "lsr %[ph], %[R], #4\n"
+    "mul %[pl], %[t], %[ph]\n"
+    "umulh %[ph], %[t], %[ph]\n"
+    "adds %[cl], %[cl], %[pl]\n"
+    "adc %[ch], %[ch], %[ph]\n"
+    /* r[0] = c & M; c >>= 52 */
+    "and %[t], %[cl], #0xfffffffffffff\n"
+    "str %[t], [%[r]]\n"
+    "extr %[cl], %[ch], %[cl], #52\n"
+    "lsr %[ch], %[ch], #52\n"
+    /* a0 *= 2; c += a0*a1 */
+    "lsl %[a0], %[a0], #1\n"
+    "mul %[pl], %[a0], %[a1]\n"
+    "umulh %[ph], %[a0], %[a1]\n"
+    "adds %[cl], %[cl], %[pl]\n"
+    "adc %[ch], %[ch], %[ph]\n"
+    /* d += a2*a4 + a3*a3 */
+    "mul %[pl], %[a2], %[a4]\n"
+    "umulh %[ph], %[a2], %[a4]\n"
+    "adds %[dl], %[dl], %[pl]\n"
+    "adc %[dh], %[dh], %[ph]\n"
+    "mul %[pl], %[a3], %[a3]\n"
+    "umulh %[ph], %[a3], %[a3]\n"
+    "adds %[dl], %[dl], %[pl]\n"
+    "adc %[dh], %[dh], %[ph]\n"
+    /* c += (d & M) * R; d >>= 52 */
+    "and %[t], %[dl], #0xfffffffffffff\n"
+    "mul %[pl], %[t], %[R]\n"
+    "umulh %[ph], %[t], %[R]\n"
+    "adds %[cl], %[cl], %[pl]\n"
+    "adc %[ch], %[ch], %[ph]\n"
+    "extr %[dl], %[dh], %[dl], #52\n"
+    "lsr %[dh], %[dh], #52\n"
+    /* r[1] = c & M; c >>= 52 */
+    "and %[t], %[cl], #0xfffffffffffff\n"
+    "str %[t], [%[r], #8]\n"
+    "extr %[cl], %[ch], %[cl], #52\n"
+    "lsr %[ch], %[ch], #52\n"
+    /* c += a0*a2 + a1*a1 */
+    "mul %[pl], %[a0], %[a2]\n"
+    "umulh %[ph], %[a0], %[a2]\n"
+    "adds %[cl], %[cl], %[pl]\n"
+    "adc %[ch], %[ch], %[ph]\n"
+    "mul %[pl], %[a1], %[a1]\n"
+    "umulh %[ph], %[a1], %[a1]\n"
+    "adds %[cl], %[cl], %[pl]\n"
+    "adc %[ch], %[ch], %[ph]\n"
+    /* d += a3*a4 */
+    "mul %[pl], %[a3], %[a4]\n"
+    "umulh %[ph], %[a3], %[a4]\n"
+    "adds %[dl], %[dl], %[pl]\n"
+    "adc %[dh], %[dh], %[ph]\n"
+    /* c += (d & M) * R; d >>= 52 */
+    "and %[t], %[dl], #0xfffffffffffff\n"
+    "mul %[pl], %[t], %[R]\n"
+    "umulh %[ph], %[t], %[R]\n"
+    "adds %[cl], %[cl], %[pl]\n"
+    "adc %[ch], %[ch], %[ph]\n"
+    "extr %[dl], %[dh], %[dl], #52\n"
+    /* r[2] = c & M; c >>= 52 */
+    "and %[t], %[cl], #0xfffffffffffff\n"
+    "str %[t], [%[r], #16]\n"
+    "extr %[cl], %[ch], %[cl], #52\n"
+    "lsr %[ch], %[ch], #52\n"
+    /* c += d * R + t3 */
+    "mul %[pl], %[dl], %[R]\n"
+    "umulh %[ph], %[dl], %[R]\n"
+    "adds %[cl], %[cl], %[pl]\n"
+    "adc %[ch], %[ch], %[ph]\n"
+    "adds %[cl], %[cl], %[t3]\n"
+    "adc %[ch], %[ch], xzr\n"
+    /* r[3] = c & M; c >>= 52 */
+    "and %[t], %[cl], #0xfffffffffffff\n"
+    "str %[t], [%[r], #24]\n"
+    "extr %[cl], %[ch], %[cl], #52\n"
+    /* r[4] = c + t4 */
+    "add %[cl], %[cl], %[t4]\n"
+    "str %[cl], [%[r], #32]\n"
+    : [a0] "=&r"(a0), [a1] "=&r"(a1), [a2] "=&r"(a2), [a3] "=&r"(a3), [a4] "=&r"(a4), [cl] "=&r"(cl),
+      [ch] "=&r"(ch), [dl] "=&r"(dl), [dh] "=&r"(dh), [pl] "=&r"(pl), [ph] "=&r"(ph), [t] "=&r"(t),
+      [t3] "=&r"(t3), [t4] "=&r"(t4), [tx] "=&r"(tx), [R] "=&r"(R)
+    : [r] "r"(r), [a] "r"(a)
+    : "cc", "memory"
+);
+}
+
+#endif /* SECP256K1_FIELD_INNER5X52_IMPL_H */
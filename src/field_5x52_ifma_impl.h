@@ -0,0 +1,267 @@
+/**********************************************************************
+ * Distributed under the MIT software license, see the accompanying   *
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
+ **********************************************************************/
+
+#ifndef SECP256K1_FIELD_5X52_IFMA_IMPL_H
+#define SECP256K1_FIELD_5X52_IFMA_IMPL_H
+
+/* Eight independent field multiplications at once, using the AVX-512 IFMA
+ * instructions (vpmadd52luq/vpmadd52huq), which accumulate the low or high 52
+ * bits of a 52x52-bit product and so match the 5x52 representation exactly.
+ *
+ * The elements are transposed into a secp256k1_fe_x8, whose vector n[i] holds
+ * limb i of all eight elements. The instructions ignore the upper 12 bits of
+ * their inputs, so the limbs of a secp256k1_fe_x8 are kept below 2^52 (the
+ * last one below 2^49): loading weakly normalizes, and the results of mul and
+ * sqr already satisfy this. There are no data dependent branches or memory
+ * accesses, so the code is constant time.
+ *
+ * The code is compiled for the required ISA with a target attribute, and must
+ * only be called when secp256k1_fe_x8_available returns 1. */
+
+#include <stdint.h>
+#include <immintrin.h>
+#include "cpu_impl.h"
+
+#define SECP256K1_FE_X8_TARGET __attribute__((target("avx512f,avx512ifma")))
+
+typedef struct {
+    __m512i n[5];
+} secp256k1_fe_x8;
+
+/** Returns the gather/scatter indices for elements that are stride bytes apart. */
+SECP256K1_FE_X8_TARGET
+static __m512i secp256k1_fe_x8_index(size_t stride) {
+    const long long s = (long long)(stride / sizeof(uint64_t));
+    VERIFY_CHECK(stride % sizeof(uint64_t) == 0);
+    return _mm512_set_epi64(7 * s, 6 * s, 5 * s, 4 * s, 3 * s, 2 * s, s, 0);
+}
+
+/** Load the eight field elements a, (a + stride bytes), ..., each of magnitude at most 8. */
+SECP256K1_FE_X8_TARGET
+static void secp256k1_fe_x8_load(secp256k1_fe_x8 *r, const secp256k1_fe *a, size_t stride) {
+    const __m512i m52 = _mm512_set1_epi64(0xFFFFFFFFFFFFFULL);
+    const __m512i m48 = _mm512_set1_epi64(0x0FFFFFFFFFFFFULL);
+    const __m512i idx = secp256k1_fe_x8_index(stride);
+    __m512i t0, t1, t2, t3, t4, x;
+#ifdef VERIFY
+    int j;
+    for (j = 0; j < 8; j++) {
+        const secp256k1_fe *e = (const secp256k1_fe *)((const unsigned char *)a + j * stride);
+        secp256k1_fe_verify(e);
+        VERIFY_CHECK(e->magnitude <= 8);
+    }
+#endif
+
+    t0 = _mm512_i64gather_epi64(idx, (const void *)&a->n[0], 8);
+    t1 = _mm512_i64gather_epi64(idx, (const void *)&a->n[1], 8);
+    t2 = _mm512_i64gather_epi64(idx, (const void *)&a->n[2], 8);
+    t3 = _mm512_i64gather_epi64(idx, (const void *)&a->n[3], 8);
+    t4 = _mm512_i64gather_epi64(idx, (const void *)&a->n[4], 8);
+
+    /* As in secp256k1_fe_normalize_weak; x is below 2^4, so x * 0x1000003D1 fits in 52 bits. */
+    x = _mm512_srli_epi64(t4, 48); t4 = _mm512_and_si512(t4, m48);
+    t0 = _mm512_madd52lo_epu64(t0, x, _mm512_set1_epi64(0x1000003D1ULL));
+    t1 = _mm512_add_epi64(t1, _mm512_srli_epi64(t0, 52)); t0 = _mm512_and_si512(t0, m52);
+    t2 = _mm512_add_epi64(t2, _mm512_srli_epi64(t1, 52)); t1 = _mm512_and_si512(t1, m52);
+    t3 = _mm512_add_epi64(t3, _mm512_srli_epi64(t2, 52)); t2 = _mm512_and_si512(t2, m52);
+    t4 = _mm512_add_epi64(t4, _mm512_srli_epi64(t3, 52)); t3 = _mm512_and_si512(t3, m52);
+
+    r->n[0] = t0; r->n[1] = t1; r->n[2] = t2; r->n[3] = t3; r->n[4] = t4;
+}
+
+/** Store the eight field elements of a to r, (r + stride bytes), ..., with magnitude 1. */
+SECP256K1_FE_X8_TARGET
+static void secp256k1_fe_x8_store(secp256k1_fe *r, size_t stride, const secp256k1_fe_x8 *a) {
+    const __m512i idx = secp256k1_fe_x8_index(stride);
+    int i;
+#ifdef VERIFY
+    int j;
+#endif
+    for (i = 0; i < 5; i++) {
+        _mm512_i64scatter_epi64((void *)&r->n[i], idx, a->n[i], 8);
+    }
+#ifdef VERIFY
+    for (j = 0; j < 8; j++) {
+        secp256k1_fe *e = (secp256k1_fe *)((unsigned char *)r + j * stride);
+        e->magnitude = 1;
+        e->normalized = 0;
+        secp256k1_fe_verify(e);
+    }
+#endif
+}
+
+/* Accumulate the low and high halves of x * y into the columns l and h. */
+#define SECP256K1_FE_X8_MADD(l, h, x, y) do { \
+    (l) = _mm512_madd52lo_epu64((l), (x), (y)); \
+    (h) = _mm512_madd52hi_epu64((h), (x), (y)); \
+} while(0)
+
+/* Move the bits of x above 52 into y. */
+#define SECP256K1_FE_X8_CARRY(x, y) do { \
+    (y) = _mm512_add_epi64((y), _mm512_srli_epi64((x), 52)); \
+    (x) = _mm512_and_si512((x), m52); \
+} while(0)
+
+/** Reduce the product with column sums l[k] (low halves) and h[k] (high halves) of the
+ *  52x52-bit limb products of weight 2^(52k), each below 2^56. */
+SECP256K1_FE_X8_TARGET
+static SECP256K1_INLINE void secp256k1_fe_x8_reduce(secp256k1_fe_x8 *r, const __m512i *l, const __m512i *h) {
+    const __m512i m52 = _mm512_set1_epi64(0xFFFFFFFFFFFFFULL);
+    const __m512i m48 = _mm512_set1_epi64(0x0FFFFFFFFFFFFULL);
+    const __m512i R = _mm512_set1_epi64(0x1000003D10ULL);
+    const __m512i R1 = _mm512_set1_epi64(0x1000003D1ULL);
+    __m512i d0, d1, d2, d3, d4, d5, d6, d7, d8, d9, t;
+
+    /* Combine the halves into ten limbs of 52 bits. The product is below 2^514, so the
+     * last limb is too. */
+    d0 = l[0];
+    d1 = _mm512_add_epi64(l[1], h[0]);
+    d2 = _mm512_add_epi64(l[2], h[1]);
+    d3 = _mm512_add_epi64(l[3], h[2]);
+    d4 = _mm512_add_epi64(l[4], h[3]);
+    d5 = _mm512_add_epi64(l[5], h[4]);
+    d6 = _mm512_add_epi64(l[6], h[5]);
+    d7 = _mm512_add_epi64(l[7], h[6]);
+    d8 = _mm512_add_epi64(l[8], h[7]);
+    d9 = h[8];
+    SECP256K1_FE_X8_CARRY(d0, d1); SECP256K1_FE_X8_CARRY(d1, d2); SECP256K1_FE_X8_CARRY(d2, d3);
+    SECP256K1_FE_X8_CARRY(d3, d4); SECP256K1_FE_X8_CARRY(d4, d5); SECP256K1_FE_X8_CARRY(d5, d6);
+    SECP256K1_FE_X8_CARRY(d6, d7); SECP256K1_FE_X8_CARRY(d7, d8); SECP256K1_FE_X8_CARRY(d8, d9);
+
+    /* Fold the upper five limbs in using 2^260 = R (mod p), leaving a sixth limb t below 2^32. */
+    t = _mm512_madd52hi_epu64(_mm512_setzero_si512(), d9, R);
+    d4 = _mm512_madd52lo_epu64(d4, d9, R);
+    SECP256K1_FE_X8_MADD(d3, d4, d8, R);
+    SECP256K1_FE_X8_MADD(d2, d3, d7, R);
+    SECP256K1_FE_X8_MADD(d1, d2, d6, R);
+    SECP256K1_FE_X8_MADD(d0, d1, d5, R);
+    SECP256K1_FE_X8_CARRY(d0, d1); SECP256K1_FE_X8_CARRY(d1, d2); SECP256K1_FE_X8_CARRY(d2, d3);
+    SECP256K1_FE_X8_CARRY(d3, d4); SECP256K1_FE_X8_CARRY(d4, t);
+
+    /* Fold in the bits from 2^256 up using 2^256 = 0x1000003D1 (mod p); t is then below 2^37. */
+    t = _mm512_add_epi64(_mm512_srli_epi64(d4, 48), _mm512_slli_epi64(t, 4));
+    d4 = _mm512_and_si512(d4, m48);
+    SECP256K1_FE_X8_MADD(d0, d1, t, R1);
+    SECP256K1_FE_X8_CARRY(d0, d1); SECP256K1_FE_X8_CARRY(d1, d2); SECP256K1_FE_X8_CARRY(d2, d3);
+    SECP256K1_FE_X8_CARRY(d3, d4);
+
+    /* The last limb is now at most 2^48. */
+    r->n[0] = d0; r->n[1] = d1; r->n[2] = d2; r->n[3] = d3; r->n[4] = d4;
+}
+
+/** Sets each element of r to the product of the corresponding elements of a and b.
+ *  r may alias a or b. */
+SECP256K1_FE_X8_TARGET
+static void secp256k1_fe_x8_mul(secp256k1_fe_x8 *r, const secp256k1_fe_x8 *a, const secp256k1_fe_x8 *b) {
+    const __m512i a0 = a->n[0], a1 = a->n[1], a2 = a->n[2], a3 = a->n[3], a4 = a->n[4];
+    const __m512i b0 = b->n[0], b1 = b->n[1], b2 = b->n[2], b3 = b->n[3], b4 = b->n[4];
+    __m512i l[9], h[9];
+
+    l[0] = l[1] = l[2] = l[3] = l[4] = l[5] = l[6] = l[7] = l[8] = _mm512_setzero_si512();
+    h[0] = h[1] = h[2] = h[3] = h[4] = h[5] = h[6] = h[7] = h[8] = l[0];
+    SECP256K1_FE_X8_MADD(l[0], h[0], a0, b0);
+    SECP256K1_FE_X8_MADD(l[1], h[1], a0, b1); SECP256K1_FE_X8_MADD(l[1], h[1], a1, b0);
+    SECP256K1_FE_X8_MADD(l[2], h[2], a0, b2); SECP256K1_FE_X8_MADD(l[2], h[2], a1, b1);
+    SECP256K1_FE_X8_MADD(l[2], h[2], a2, b0);
+    SECP256K1_FE_X8_MADD(l[3], h[3], a0, b3); SECP256K1_FE_X8_MADD(l[3], h[3], a1, b2);
+    SECP256K1_FE_X8_MADD(l[3], h[3], a2, b1); SECP256K1_FE_X8_MADD(l[3], h[3], a3, b0);
+    SECP256K1_FE_X8_MADD(l[4], h[4], a0, b4); SECP256K1_FE_X8_MADD(l[4], h[4], a1, b3);
+    SECP256K1_FE_X8_MADD(l[4], h[4], a2, b2); SECP256K1_FE_X8_MADD(l[4], h[4], a3, b1);
+    SECP256K1_FE_X8_MADD(l[4], h[4], a4, b0);
+    SECP256K1_FE_X8_MADD(l[5], h[5], a1, b4); SECP256K1_FE_X8_MADD(l[5], h[5], a2, b3);
+    SECP256K1_FE_X8_MADD(l[5], h[5], a3, b2); SECP256K1_FE_X8_MADD(l[5], h[5], a4, b1);
+    SECP256K1_FE_X8_MADD(l[6], h[6], a2, b4); SECP256K1_FE_X8_MADD(l[6], h[6], a3, b3);
+    SECP256K1_FE_X8_MADD(l[6], h[6], a4, b2);
+    SECP256K1_FE_X8_MADD(l[7], h[7], a3, b4); SECP256K1_FE_X8_MADD(l[7], h[7], a4, b3);
+    SECP256K1_FE_X8_MADD(l[8], h[8], a4, b4);
+    secp256k1_fe_x8_reduce(r, l, h);
+}
+
+/** Sets each element of r to the square of the corresponding element of a. r may alias a. */
+SECP256K1_FE_X8_TARGET
+static void secp256k1_fe_x8_sqr(secp256k1_fe_x8 *r, const secp256k1_fe_x8 *a) {
+    const __m512i a0 = a->n[0], a1 = a->n[1], a2 = a->n[2], a3 = a->n[3], a4 = a->n[4];
+    __m512i l[9], h[9];
+    int i;
+
+    /* The cross products are computed once and doubled, the squares are added after. */
+    l[0] = l[1] = l[2] = l[3] = l[4] = l[5] = l[6] = l[7] = l[8] = _mm512_setzero_si512();
+    h[0] = h[1] = h[2] = h[3] = h[4] = h[5] = h[6] = h[7] = h[8] = l[0];
+    SECP256K1_FE_X8_MADD(l[1], h[1], a0, a1);
+    SECP256K1_FE_X8_MADD(l[2], h[2], a0, a2);
+    SECP256K1_FE_X8_MADD(l[3], h[3], a0, a3); SECP256K1_FE_X8_MADD(l[3], h[3], a1, a2);
+    SECP256K1_FE_X8_MADD(l[4], h[4], a0, a4); SECP256K1_FE_X8_MADD(l[4], h[4], a1, a3);
+    SECP256K1_FE_X8_MADD(l[5], h[5], a1, a4); SECP256K1_FE_X8_MADD(l[5], h[5], a2, a3);
+    SECP256K1_FE_X8_MADD(l[6], h[6], a2, a4);
+    SECP256K1_FE_X8_MADD(l[7], h[7], a3, a4);
+    for (i = 1; i < 9; i++) {
+        l[i] = _mm512_add_epi64(l[i], l[i]);
+        h[i] = _mm512_add_epi64(h[i], h[i]);
+    }
+    SECP256K1_FE_X8_MADD(l[0], h[0], a0, a0);
+    SECP256K1_FE_X8_MADD(l[2], h[2], a1, a1);
+    SECP256K1_FE_X8_MADD(l[4], h[4], a2, a2);
+    SECP256K1_FE_X8_MADD(l[6], h[6], a3, a3);
+    SECP256K1_FE_X8_MADD(l[8], h[8], a4, a4);
+    secp256k1_fe_x8_reduce(r, l, h);
+}
+
+#undef SECP256K1_FE_X8_CARRY
+#undef SECP256K1_FE_X8_MADD
+
+/** Sets r to a squared n times. r may alias a. */
+SECP256K1_FE_X8_TARGET
+static void secp256k1_fe_x8_sqr_n(secp256k1_fe_x8 *r, const secp256k1_fe_x8 *a, int n) {
+    int j;
+    *r = *a;
+    for (j = 0; j < n; j++) {
+        secp256k1_fe_x8_sqr(r, r);
+    }
+}
+
+/** Sets each element of r to the (p+1)/4'th power of the corresponding element of a,
+ *  which is its square root if it has one, using the addition chain of secp256k1_fe_sqrt.
+ *  The caller has to check the results. */
+SECP256K1_FE_X8_TARGET
+static void secp256k1_fe_x8_sqrt_var(secp256k1_fe_x8 *r, const secp256k1_fe_x8 *a) {
+    secp256k1_fe_x8 x2, x3, x6, x9, x11, x22, x44, x88, x176, x220, x223, t1;
+
+    secp256k1_fe_x8_sqr(&x2, a);
+    secp256k1_fe_x8_mul(&x2, &x2, a);
+    secp256k1_fe_x8_sqr(&x3, &x2);
+    secp256k1_fe_x8_mul(&x3, &x3, a);
+    secp256k1_fe_x8_sqr_n(&x6, &x3, 3);
+    secp256k1_fe_x8_mul(&x6, &x6, &x3);
+    secp256k1_fe_x8_sqr_n(&x9, &x6, 3);
+    secp256k1_fe_x8_mul(&x9, &x9, &x3);
+    secp256k1_fe_x8_sqr_n(&x11, &x9, 2);
+    secp256k1_fe_x8_mul(&x11, &x11, &x2);
+    secp256k1_fe_x8_sqr_n(&x22, &x11, 11);
+    secp256k1_fe_x8_mul(&x22, &x22, &x11);
+    secp256k1_fe_x8_sqr_n(&x44, &x22, 22);
+    secp256k1_fe_x8_mul(&x44, &x44, &x22);
+    secp256k1_fe_x8_sqr_n(&x88, &x44, 44);
+    secp256k1_fe_x8_mul(&x88, &x88, &x44);
+    secp256k1_fe_x8_sqr_n(&x176, &x88, 88);
+    secp256k1_fe_x8_mul(&x176, &x176, &x88);
+    secp256k1_fe_x8_sqr_n(&x220, &x176, 44);
+    secp256k1_fe_x8_mul(&x220, &x220, &x44);
+    secp256k1_fe_x8_sqr_n(&x223, &x220, 3);
+    secp256k1_fe_x8_mul(&x223, &x223, &x3);
+
+    secp256k1_fe_x8_sqr_n(&t1, &x223, 23);
+    secp256k1_fe_x8_mul(&t1, &t1, &x22);
+    secp256k1_fe_x8_sqr_n(&t1, &t1, 6);
+    secp256k1_fe_x8_mul(&t1, &t1, &x2);
+    secp256k1_fe_x8_sqr_n(r, &t1, 2);
+}
+
+/** Returns whether the CPU supports AVX-512F and AVX-512 IFMA, and the OS saves the
+ *  AVX-512 register state. */
+static int secp256k1_fe_x8_available(void) {
+    return secp256k1_cpu_x86_has(SECP256K1_CPU_X86_AVX512_IFMA);
+}
+
+#endif /* SECP256K1_FIELD_5X52_IFMA_IMPL_H */
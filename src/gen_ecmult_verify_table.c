@@ -0,0 +1,110 @@
+/**********************************************************************
+ * Copyright (c) 2013, 2014, 2015 Thomas Daede, Cory Fields           *
+ * Distributed under the MIT software license, see the accompanying   *
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
+ **********************************************************************/
+
+// Autotools creates libsecp256k1-config.h, of which ECMULT_WINDOW_SIZE is needed.
+// ifndef guard so downstream users can define their own if they do not use autotools.
+#if !defined(ECMULT_WINDOW_SIZE)
+#include "libsecp256k1-config.h"
+#endif
+
+// basic-config.h redefines ECMULT_WINDOW_SIZE, so remember the configured value.
+static const int window_g = ECMULT_WINDOW_SIZE;
+// Likewise for USE_ECMULT_COMPACT_VERIFY_TABLE, which it undefines.
+#ifdef USE_ECMULT_COMPACT_VERIFY_TABLE
+static const int compact = 1;
+#else
+static const int compact = 0;
+#endif
+
+#define USE_BASIC_CONFIG 1
+#include "basic-config.h"
+
+#include "include/secp256k1.h"
+#include "assumptions.h"
+#include "util.h"
+#include "field_impl.h"
+#include "scalar_impl.h"
+#include "group_impl.h"
+#include "hash_impl.h"
+#include "scratch_impl.h"
+#include "ecmult_impl.h"
+
+static void default_error_callback_fn(const char* str, void* data) {
+    (void)data;
+    fprintf(stderr, "[libsecp256k1] internal consistency check failed: %s\n", str);
+    abort();
+}
+
+static const secp256k1_callback default_error_callback = {
+    default_error_callback_fn,
+    NULL
+};
+
+static void print_table(FILE *fp, const char *name, const secp256k1_ge_storage *table, int n) {
+    int i;
+    fprintf(fp, "static const secp256k1_ge_storage %s[ECMULT_TABLE_SIZE(WINDOW_G)] = {\n", name);
+    for (i = 0; i < n; i++) {
+        fprintf(fp,"    SC(%uu, %uu, %uu, %uu, %uu, %uu, %uu, %uu, %uu, %uu, %uu, %uu, %uu, %uu, %uu, %uu)", SECP256K1_GE_STORAGE_CONST_GET(table[i]));
+        if (i != n - 1) {
+            fprintf(fp,",\n");
+        } else {
+            fprintf(fp,"\n");
+        }
+    }
+    fprintf(fp,"};\n");
+}
+
+int main(int argc, char **argv) {
+    secp256k1_ge_storage *table;
+    secp256k1_gej gj;
+    int n = ECMULT_TABLE_SIZE(window_g);
+    int i;
+    FILE* fp;
+
+    (void)argc;
+    (void)argv;
+
+    fp = fopen("src/ecmult_static_verify_table.h","w");
+    if (fp == NULL) {
+        fprintf(stderr, "Could not open src/ecmult_static_verify_table.h for writing!\n");
+        return -1;
+    }
+
+    fprintf(fp, "#ifndef SECP256K1_ECMULT_STATIC_VERIFY_TABLE_H\n");
+    fprintf(fp, "#define SECP256K1_ECMULT_STATIC_VERIFY_TABLE_H\n");
+    fprintf(fp, "#include \"src/group.h\"\n");
+    fprintf(fp, "#define SC SECP256K1_GE_STORAGE_CONST\n");
+    fprintf(fp, "#if WINDOW_G != %d\n", window_g);
+    fprintf(fp, "   #error configuration mismatch, invalid ECMULT_WINDOW_SIZE. Try deleting ecmult_static_verify_table.h before the build.\n");
+    fprintf(fp, "#endif\n");
+    fprintf(fp, "#%s USE_ECMULT_COMPACT_VERIFY_TABLE\n", compact ? "ifndef" : "ifdef");
+    fprintf(fp, "   #error configuration mismatch, invalid USE_ECMULT_COMPACT_VERIFY_TABLE. Try deleting ecmult_static_verify_table.h before the build.\n");
+    fprintf(fp, "#endif\n");
+
+    table = (secp256k1_ge_storage*)checked_malloc(&default_error_callback, sizeof(secp256k1_ge_storage) * n);
+
+    /* odd multiples of the generator */
+    secp256k1_gej_set_ge(&gj, &secp256k1_ge_const_g);
+    secp256k1_ecmult_odd_multiples_table_storage_var(n, table, &gj);
+    print_table(fp, "secp256k1_ecmult_static_pre_g", table, n);
+
+    if (!compact) {
+        /* odd multiples of 2^128*generator */
+        for (i = 0; i < 128; i++) {
+            secp256k1_gej_double_var(&gj, &gj, NULL);
+        }
+        secp256k1_ecmult_odd_multiples_table_storage_var(n, table, &gj);
+        print_table(fp, "secp256k1_ecmult_static_pre_g_128", table, n);
+    }
+
+    free(table);
+
+    fprintf(fp, "#undef SC\n");
+    fprintf(fp, "#endif\n");
+    fclose(fp);
+
+    return 0;
+}
@@ -70,6 +70,29 @@ static void secp256k1_ge_set_gej_zinv(secp256k1_ge *r, const secp256k1_gej *a, c
     r->infinity = a->infinity;
 }
 
+#ifdef SECP256K1_FE_X8
+/** secp256k1_ge_set_gej_zinv for the eight points a[0..7], where the inverses of their z
+ *  coordinates are passed in r[0..7].x. Must only be called if secp256k1_fe_x8_available(). */
+SECP256K1_FE_X8_TARGET
+static void secp256k1_ge_set_gej_zinv_x8(secp256k1_ge *r, const secp256k1_gej *a) {
+    secp256k1_fe_x8 zi, zi2, t;
+    int i;
+
+    secp256k1_fe_x8_load(&zi, &r[0].x, sizeof(secp256k1_ge));
+    secp256k1_fe_x8_sqr(&zi2, &zi);
+    secp256k1_fe_x8_mul(&zi, &zi, &zi2);
+    secp256k1_fe_x8_load(&t, &a[0].x, sizeof(secp256k1_gej));
+    secp256k1_fe_x8_mul(&t, &t, &zi2);
+    secp256k1_fe_x8_store(&r[0].x, sizeof(secp256k1_ge), &t);
+    secp256k1_fe_x8_load(&t, &a[0].y, sizeof(secp256k1_gej));
+    secp256k1_fe_x8_mul(&t, &t, &zi);
+    secp256k1_fe_x8_store(&r[0].y, sizeof(secp256k1_ge), &t);
+    for (i = 0; i < 8; i++) {
+        r[i].infinity = a[i].infinity;
+    }
+}
+#endif
+
 static void secp256k1_ge_set_xy(secp256k1_ge *r, const secp256k1_fe *x, const secp256k1_fe *y) {
     r->infinity = 0;
     r->x = *x;
@@ -148,7 +171,29 @@ static void secp256k1_ge_set_all_gej_var(secp256k1_ge *r, const secp256k1_gej *a
     VERIFY_CHECK(!a[last_i].infinity);
     r[last_i].x = u;
 
-    for (i = 0; i < len; i++) {
+    i = 0;
+#ifdef SECP256K1_FE_X8
+    if (secp256k1_fe_x8_available()) {
+        for (; i + 8 <= len; i += 8) {
+            size_t j;
+            int any_infinity = 0;
+            for (j = i; j < i + 8; j++) {
+                any_infinity |= a[j].infinity;
+            }
+            if (!any_infinity) {
+                secp256k1_ge_set_gej_zinv_x8(&r[i], &a[i]);
+                continue;
+            }
+            for (j = i; j < i + 8; j++) {
+                r[j].infinity = a[j].infinity;
+                if (!a[j].infinity) {
+                    secp256k1_ge_set_gej_zinv(&r[j], &a[j], &r[j].x);
+                }
+            }
+        }
+    }
+#endif
+    for (; i < len; i++) {
         r[i].infinity = a[i].infinity;
         if (!a[i].infinity) {
             secp256k1_ge_set_gej_zinv(&r[i], &a[i], &r[i].x);
@@ -156,6 +201,41 @@ static void secp256k1_ge_set_all_gej_var(secp256k1_ge *r, const secp256k1_gej *a
     }
 }
 
+static void secp256k1_ge_set_all_gej(secp256k1_ge *r, const secp256k1_gej *a, size_t len) {
+    secp256k1_fe u;
+    size_t i;
+
+    if (len == 0) {
+        return;
+    }
+    /* Use destination's x coordinates as scratch space */
+    r[0].x = a[0].z;
+    for (i = 1; i < len; i++) {
+        VERIFY_CHECK(!a[i].infinity);
+        secp256k1_fe_mul(&r[i].x, &r[i - 1].x, &a[i].z);
+    }
+    secp256k1_fe_inv(&u, &r[len - 1].x);
+
+    for (i = len - 1; i > 0; i--) {
+        secp256k1_fe_mul(&r[i].x, &r[i - 1].x, &u);
+        secp256k1_fe_mul(&u, &u, &a[i].z);
+    }
+    VERIFY_CHECK(!a[0].infinity);
+    r[0].x = u;
+
+    i = 0;
+#ifdef SECP256K1_FE_X8
+    if (secp256k1_fe_x8_available()) {
+        for (; i + 8 <= len; i += 8) {
+            secp256k1_ge_set_gej_zinv_x8(&r[i], &a[i]);
+        }
+    }
+#endif
+    for (; i < len; i++) {
+        secp256k1_ge_set_gej_zinv(&r[i], &a[i], &r[i].x);
+    }
+}
+
 static void secp256k1_ge_globalz_set_table_gej(size_t len, secp256k1_ge *r, secp256k1_fe *globalz, const secp256k1_gej *a, const secp256k1_fe *zr) {
     size_t i = len - 1;
     secp256k1_fe zs;
@@ -229,6 +309,52 @@ static int secp256k1_ge_set_xo_var(secp256k1_ge *r, const secp256k1_fe *x, int o
 
 }
 
+#ifdef SECP256K1_FE_X8
+/** secp256k1_ge_set_xo_batch_var for eight coordinates, with their square roots computed
+ *  together. Must only be called if secp256k1_fe_x8_available(). */
+SECP256K1_FE_X8_TARGET
+static void secp256k1_ge_set_xo_x8(secp256k1_ge *r, int *ret, const secp256k1_fe *x, const int *odd) {
+    secp256k1_fe rhs[8], y[8], t;
+    secp256k1_fe_x8 a, root;
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        secp256k1_fe_sqr(&t, &x[i]);
+        secp256k1_fe_mul(&rhs[i], &t, &x[i]);
+        secp256k1_fe_add(&rhs[i], &secp256k1_fe_const_b);
+    }
+    secp256k1_fe_x8_load(&a, rhs, sizeof(secp256k1_fe));
+    secp256k1_fe_x8_sqrt_var(&root, &a);
+    secp256k1_fe_x8_store(y, sizeof(secp256k1_fe), &root);
+    for (i = 0; i < 8; i++) {
+        r[i].x = x[i];
+        r[i].infinity = 0;
+        /* Check that a square root was actually calculated */
+        secp256k1_fe_sqr(&t, &y[i]);
+        ret[i] = secp256k1_fe_equal_var(&t, &rhs[i]);
+        secp256k1_fe_normalize_var(&y[i]);
+        if (secp256k1_fe_is_odd(&y[i]) != odd[i]) {
+            secp256k1_fe_negate(&y[i], &y[i], 1);
+        }
+        r[i].y = y[i];
+    }
+}
+#endif
+
+static void secp256k1_ge_set_xo_batch_var(secp256k1_ge *r, int *ret, const secp256k1_fe *x, const int *odd, size_t n) {
+    size_t i = 0;
+#ifdef SECP256K1_FE_X8
+    if (secp256k1_fe_x8_available()) {
+        for (; i + 8 <= n; i += 8) {
+            secp256k1_ge_set_xo_x8(&r[i], &ret[i], &x[i], &odd[i]);
+        }
+    }
+#endif
+    for (; i < n; i++) {
+        ret[i] = secp256k1_ge_set_xo_var(&r[i], &x[i], odd[i]);
+    }
+}
+
 static void secp256k1_gej_set_ge(secp256k1_gej *r, const secp256k1_ge *a) {
    r->infinity = a->infinity;
    r->x = a->x;
@@ -270,6 +396,16 @@ static int secp256k1_ge_is_valid_var(const secp256k1_ge *a) {
     return secp256k1_fe_equal_var(&y2, &x3);
 }
 
+/* Check that the coordinates of a are within the SECP256K1_GEJ_*_MAGNITUDE_MAX bounds. */
+static void secp256k1_gej_verify_magnitudes(const secp256k1_gej *a) {
+#ifdef VERIFY
+    VERIFY_CHECK(a->x.magnitude <= SECP256K1_GEJ_X_MAGNITUDE_MAX);
+    VERIFY_CHECK(a->y.magnitude <= SECP256K1_GEJ_Y_MAGNITUDE_MAX);
+    VERIFY_CHECK(a->z.magnitude <= SECP256K1_GEJ_Z_MAGNITUDE_MAX);
+#endif
+    (void)a;
+}
+
 static SECP256K1_INLINE void secp256k1_gej_double(secp256k1_gej *r, const secp256k1_gej *a) {
     /* Operations: 3 mul, 4 sqr, 0 normalize, 12 mul_int/add/negate.
      *
@@ -280,6 +416,8 @@ static SECP256K1_INLINE void secp256k1_gej_double(secp256k1_gej *r, const secp25
      */
     secp256k1_fe t1,t2,t3,t4;
 
+    SECP256K1_COUNT(GEJ_DOUBLE);
+    secp256k1_gej_verify_magnitudes(a);
     r->infinity = a->infinity;
 
     secp256k1_fe_mul(&r->z, &a->z, &a->y);
@@ -336,6 +474,7 @@ static void secp256k1_gej_add_var(secp256k1_gej *r, const secp256k1_gej *a, cons
     /* Operations: 12 mul, 4 sqr, 2 normalize, 12 mul_int/add/negate */
     secp256k1_fe z22, z12, u1, u2, s1, s2, h, i, i2, h2, h3, t;
 
+    SECP256K1_COUNT(GEJ_ADD);
     if (a->infinity) {
         VERIFY_CHECK(rzr == NULL);
         *r = *b;
@@ -351,6 +490,8 @@ static void secp256k1_gej_add_var(secp256k1_gej *r, const secp256k1_gej *a, cons
     }
 
     r->infinity = 0;
+    secp256k1_gej_verify_magnitudes(a);
+    secp256k1_gej_verify_magnitudes(b);
     secp256k1_fe_sqr(&z22, &b->z);
     secp256k1_fe_sqr(&z12, &a->z);
     secp256k1_fe_mul(&u1, &a->x, &z22);
@@ -386,8 +527,9 @@ static void secp256k1_gej_add_var(secp256k1_gej *r, const secp256k1_gej *a, cons
 }
 
 static void secp256k1_gej_add_ge_var(secp256k1_gej *r, const secp256k1_gej *a, const secp256k1_ge *b, secp256k1_fe *rzr) {
-    /* 8 mul, 3 sqr, 4 normalize, 12 mul_int/add/negate */
+    /* 8 mul, 3 sqr, 2 normalize, 12 mul_int/add/negate */
     secp256k1_fe z12, u1, u2, s1, s2, h, i, i2, h2, h3, t;
+    SECP256K1_COUNT(GEJ_ADD);
     if (a->infinity) {
         VERIFY_CHECK(rzr == NULL);
         secp256k1_gej_set_ge(r, b);
@@ -401,14 +543,17 @@ static void secp256k1_gej_add_ge_var(secp256k1_gej *r, const secp256k1_gej *a, c
         return;
     }
     r->infinity = 0;
+    secp256k1_gej_verify_magnitudes(a);
 
+    /* u1 and s1 are copied because r may alias a, but need not be normalized: with the
+     * magnitude bounds of a, h and i stay within the input bounds of mul and sqr. */
     secp256k1_fe_sqr(&z12, &a->z);
-    u1 = a->x; secp256k1_fe_normalize_weak(&u1);
+    u1 = a->x;
     secp256k1_fe_mul(&u2, &b->x, &z12);
-    s1 = a->y; secp256k1_fe_normalize_weak(&s1);
+    s1 = a->y;
     secp256k1_fe_mul(&s2, &b->y, &z12); secp256k1_fe_mul(&s2, &s2, &a->z);
-    secp256k1_fe_negate(&h, &u1, 1); secp256k1_fe_add(&h, &u2);
-    secp256k1_fe_negate(&i, &s1, 1); secp256k1_fe_add(&i, &s2);
+    secp256k1_fe_negate(&h, &u1, SECP256K1_GEJ_X_MAGNITUDE_MAX); secp256k1_fe_add(&h, &u2);
+    secp256k1_fe_negate(&i, &s1, SECP256K1_GEJ_Y_MAGNITUDE_MAX); secp256k1_fe_add(&i, &s2);
     if (secp256k1_fe_normalizes_to_zero_var(&h)) {
         if (secp256k1_fe_normalizes_to_zero_var(&i)) {
             secp256k1_gej_double_var(r, a, rzr);
@@ -435,9 +580,10 @@ static void secp256k1_gej_add_ge_var(secp256k1_gej *r, const secp256k1_gej *a, c
 }
 
 static void secp256k1_gej_add_zinv_var(secp256k1_gej *r, const secp256k1_gej *a, const secp256k1_ge *b, const secp256k1_fe *bzinv) {
-    /* 9 mul, 3 sqr, 4 normalize, 12 mul_int/add/negate */
+    /* 9 mul, 3 sqr, 2 normalize, 12 mul_int/add/negate */
     secp256k1_fe az, z12, u1, u2, s1, s2, h, i, i2, h2, h3, t;
 
+    SECP256K1_COUNT(GEJ_ADD);
     if (b->infinity) {
         *r = *a;
         return;
@@ -462,15 +608,16 @@ static void secp256k1_gej_add_zinv_var(secp256k1_gej *r, const secp256k1_gej *a,
      *  The variable az below holds the modified Z coordinate for a, which is used
      *  for the computation of rx and ry, but not for rz.
      */
+    secp256k1_gej_verify_magnitudes(a);
     secp256k1_fe_mul(&az, &a->z, bzinv);
 
     secp256k1_fe_sqr(&z12, &az);
-    u1 = a->x; secp256k1_fe_normalize_weak(&u1);
+    u1 = a->x;
     secp256k1_fe_mul(&u2, &b->x, &z12);
-    s1 = a->y; secp256k1_fe_normalize_weak(&s1);
+    s1 = a->y;
     secp256k1_fe_mul(&s2, &b->y, &z12); secp256k1_fe_mul(&s2, &s2, &az);
-    secp256k1_fe_negate(&h, &u1, 1); secp256k1_fe_add(&h, &u2);
-    secp256k1_fe_negate(&i, &s1, 1); secp256k1_fe_add(&i, &s2);
+    secp256k1_fe_negate(&h, &u1, SECP256K1_GEJ_X_MAGNITUDE_MAX); secp256k1_fe_add(&h, &u2);
+    secp256k1_fe_negate(&i, &s1, SECP256K1_GEJ_Y_MAGNITUDE_MAX); secp256k1_fe_add(&i, &s2);
     if (secp256k1_fe_normalizes_to_zero_var(&h)) {
         if (secp256k1_fe_normalizes_to_zero_var(&i)) {
             secp256k1_gej_double_var(r, a, NULL);
@@ -492,13 +639,16 @@ static void secp256k1_gej_add_zinv_var(secp256k1_gej *r, const secp256k1_gej *a,
 
 
 static void secp256k1_gej_add_ge(secp256k1_gej *r, const secp256k1_gej *a, const secp256k1_ge *b) {
-    /* Operations: 7 mul, 5 sqr, 4 normalize, 21 mul_int/add/negate/cmov */
-    static const secp256k1_fe fe_1 = SECP256K1_FE_CONST(0, 0, 0, 0, 0, 0, 0, 1);
+    /* Operations: 7 mul, 5 sqr, 20 add/cmov/half/mul_int/negate/normalizes_to_zero */
     secp256k1_fe zz, u1, u2, s1, s2, t, tt, m, n, q, rr;
     secp256k1_fe m_alt, rr_alt;
-    int infinity, degenerate;
+    int degenerate;
+    SECP256K1_COUNT(GEJ_ADD);
     VERIFY_CHECK(!b->infinity);
     VERIFY_CHECK(a->infinity == 0 || a->infinity == 1);
+    if (!a->infinity) {
+        secp256k1_gej_verify_magnitudes(a);
+    }
 
     /** In:
      *    Eric Brier and Marc Joye, Weierstrass Elliptic Curves and Side-Channel Attacks.
@@ -516,9 +666,9 @@ static void secp256k1_gej_add_ge(secp256k1_gej *r, const secp256k1_gej *a, const
      *    M = S1+S2
      *    Q = T*M^2
      *    R = T^2-U1*U2
-     *    X3 = 4*(R^2-Q)
-     *    Y3 = 4*(R*(3*Q-2*R^2)-M^4)
-     *    Z3 = 2*M*Z
+     *    X3 = R^2-Q
+     *    Y3 = -(R*(2*X3-Q)+M^4)/2
+     *    Z3 = M*Z
      *  (Note that the paper uses xi = Xi / Zi and yi = Yi / Zi instead.)
      *
      *  This formula has the benefit of being the same for both addition
@@ -551,29 +701,30 @@ static void secp256k1_gej_add_ge(secp256k1_gej *r, const secp256k1_gej *a, const
      */
 
     secp256k1_fe_sqr(&zz, &a->z);                       /* z = Z1^2 */
-    u1 = a->x; secp256k1_fe_normalize_weak(&u1);        /* u1 = U1 = X1*Z2^2 (1) */
+    u1 = a->x;                                          /* u1 = U1 = X1*Z2^2 (MAX_X) */
     secp256k1_fe_mul(&u2, &b->x, &zz);                  /* u2 = U2 = X2*Z1^2 (1) */
-    s1 = a->y; secp256k1_fe_normalize_weak(&s1);        /* s1 = S1 = Y1*Z2^3 (1) */
+    s1 = a->y;                                          /* s1 = S1 = Y1*Z2^3 (MAX_Y) */
     secp256k1_fe_mul(&s2, &b->y, &zz);                  /* s2 = Y2*Z1^2 (1) */
     secp256k1_fe_mul(&s2, &s2, &a->z);                  /* s2 = S2 = Y2*Z1^3 (1) */
-    t = u1; secp256k1_fe_add(&t, &u2);                  /* t = T = U1+U2 (2) */
-    m = s1; secp256k1_fe_add(&m, &s2);                  /* m = M = S1+S2 (2) */
+    t = u1; secp256k1_fe_add(&t, &u2);                  /* t = T = U1+U2 (MAX_X+1) */
+    m = s1; secp256k1_fe_add(&m, &s2);                  /* m = M = S1+S2 (MAX_Y+1) */
     secp256k1_fe_sqr(&rr, &t);                          /* rr = T^2 (1) */
-    secp256k1_fe_negate(&m_alt, &u2, 1);                /* Malt = -X2*Z1^2 */
-    secp256k1_fe_mul(&tt, &u1, &m_alt);                 /* tt = -U1*U2 (2) */
-    secp256k1_fe_add(&rr, &tt);                         /* rr = R = T^2-U1*U2 (3) */
-    /** If lambda = R/M = 0/0 we have a problem (except in the "trivial"
+    secp256k1_fe_negate(&m_alt, &u2, 1);                /* Malt = -X2*Z1^2 (2) */
+    secp256k1_fe_mul(&tt, &u1, &m_alt);                 /* tt = -U1*U2 (1) */
+    secp256k1_fe_add(&rr, &tt);                         /* rr = R = T^2-U1*U2 (2) */
+    /** If lambda = R/M = R/0 we have a problem (except in the "trivial"
      *  case that Z = z1z2 = 0, and this is special-cased later on). */
-    degenerate = secp256k1_fe_normalizes_to_zero(&m) &
-                 secp256k1_fe_normalizes_to_zero(&rr);
-    /* This only occurs when y1 == -y2 and x1^3 == x2^3, but x1 != x2.
-     * This means either x1 == beta*x2 or beta*x1 == x2, where beta is
-     * a nontrivial cube root of one. In either case, an alternate
-     * non-indeterminate expression for lambda is (y1 - y2)/(x1 - x2),
-     * so we set R/M equal to this. */
+    degenerate = secp256k1_fe_normalizes_to_zero(&m);
+    /* This only occurs when y1 == -y2. If additionally x1 != x2 (which
+     * means x1^3 == x2^3 if R is also zero, i.e. either x1 == beta*x2 or
+     * beta*x1 == x2 for a nontrivial cube root of one beta), an alternate
+     * non-indeterminate expression for lambda is (y1 - y2)/(x1 - x2), so we
+     * set R/M equal to this. If x1 == x2 the alternate denominator is zero
+     * as well, and the result is (correctly) infinity. Using the alternate
+     * for every M == 0 therefore only costs one normalizes_to_zero. */
     rr_alt = s1;
-    secp256k1_fe_mul_int(&rr_alt, 2);       /* rr = Y1*Z2^3 - Y2*Z1^3 (2) */
-    secp256k1_fe_add(&m_alt, &u1);          /* Malt = X1*Z2^2 - X2*Z1^2 */
+    secp256k1_fe_mul_int(&rr_alt, 2);       /* rr_alt = Y1*Z2^3 - Y2*Z1^3 (2*MAX_Y) */
+    secp256k1_fe_add(&m_alt, &u1);          /* Malt = X1*Z2^2 - X2*Z1^2 (MAX_X+2) */
 
     secp256k1_fe_cmov(&rr_alt, &rr, !degenerate);
     secp256k1_fe_cmov(&m_alt, &m, !degenerate);
@@ -582,35 +733,32 @@ static void secp256k1_gej_add_ge(secp256k1_gej *r, const secp256k1_gej *a, const
      * and denominator of lambda; R and M represent the explicit
      * expressions x1^2 + x2^2 + x1x2 and y1 + y2. */
     secp256k1_fe_sqr(&n, &m_alt);                       /* n = Malt^2 (1) */
-    secp256k1_fe_mul(&q, &n, &t);                       /* q = Q = T*Malt^2 (1) */
+    secp256k1_fe_negate(&q, &t, SECP256K1_GEJ_X_MAGNITUDE_MAX + 1); /* q = -T (MAX_X+2) */
+    secp256k1_fe_mul(&q, &q, &n);                       /* q = Q = -T*Malt^2 (1) */
     /* These two lines use the observation that either M == Malt or M == 0,
      * so M^3 * Malt is either Malt^4 (which is computed by squaring), or
      * zero (which is "computed" by cmov). So the cost is one squaring
      * versus two multiplications. */
     secp256k1_fe_sqr(&n, &n);
-    secp256k1_fe_cmov(&n, &m, degenerate);              /* n = M^3 * Malt (2) */
+    secp256k1_fe_cmov(&n, &m, degenerate);              /* n = M^3 * Malt (MAX_Y+1) */
     secp256k1_fe_sqr(&t, &rr_alt);                      /* t = Ralt^2 (1) */
-    secp256k1_fe_mul(&r->z, &a->z, &m_alt);             /* r->z = Malt*Z (1) */
-    infinity = secp256k1_fe_normalizes_to_zero(&r->z) * (1 - a->infinity);
-    secp256k1_fe_mul_int(&r->z, 2);                     /* r->z = Z3 = 2*Malt*Z (2) */
-    secp256k1_fe_negate(&q, &q, 1);                     /* q = -Q (2) */
-    secp256k1_fe_add(&t, &q);                           /* t = Ralt^2-Q (3) */
-    secp256k1_fe_normalize_weak(&t);
-    r->x = t;                                           /* r->x = Ralt^2-Q (1) */
-    secp256k1_fe_mul_int(&t, 2);                        /* t = 2*x3 (2) */
-    secp256k1_fe_add(&t, &q);                           /* t = 2*x3 - Q: (4) */
-    secp256k1_fe_mul(&t, &t, &rr_alt);                  /* t = Ralt*(2*x3 - Q) (1) */
-    secp256k1_fe_add(&t, &n);                           /* t = Ralt*(2*x3 - Q) + M^3*Malt (3) */
-    secp256k1_fe_negate(&r->y, &t, 3);                  /* r->y = Ralt*(Q - 2x3) - M^3*Malt (4) */
-    secp256k1_fe_normalize_weak(&r->y);
-    secp256k1_fe_mul_int(&r->x, 4);                     /* r->x = X3 = 4*(Ralt^2-Q) */
-    secp256k1_fe_mul_int(&r->y, 4);                     /* r->y = Y3 = 4*Ralt*(Q - 2x3) - 4*M^3*Malt (4) */
+    secp256k1_fe_mul(&r->z, &a->z, &m_alt);             /* r->z = Z3 = Malt*Z (1) */
+    secp256k1_fe_add(&t, &q);                           /* t = Ralt^2 + Q (2) */
+    r->x = t;                                           /* r->x = X3 = Ralt^2 + Q (2) */
+    secp256k1_fe_mul_int(&t, 2);                        /* t = 2*X3 (4) */
+    secp256k1_fe_add(&t, &q);                           /* t = 2*X3 + Q (5) */
+    secp256k1_fe_mul(&t, &t, &rr_alt);                  /* t = Ralt*(2*X3 + Q) (1) */
+    secp256k1_fe_add(&t, &n);                           /* t = Ralt*(2*X3 + Q) + M^3*Malt (MAX_Y+2) */
+    secp256k1_fe_negate(&r->y, &t, SECP256K1_GEJ_Y_MAGNITUDE_MAX + 2); /* r->y = -(Ralt*(2*X3 + Q) + M^3*Malt) (MAX_Y+3) */
+    secp256k1_fe_half(&r->y);                           /* r->y = Y3 = -(Ralt*(2*X3 + Q) + M^3*Malt)/2 ((MAX_Y+3)/2+1) */
 
     /** In case a->infinity == 1, replace r with (b->x, b->y, 1). */
     secp256k1_fe_cmov(&r->x, &b->x, a->infinity);
     secp256k1_fe_cmov(&r->y, &b->y, a->infinity);
-    secp256k1_fe_cmov(&r->z, &fe_1, a->infinity);
-    r->infinity = infinity;
+    secp256k1_fe_cmov(&r->z, &secp256k1_fe_one, a->infinity);
+
+    /* Set r->infinity if r->z is 0. */
+    r->infinity = secp256k1_fe_normalizes_to_zero(&r->z);
 }
 
 static void secp256k1_gej_rescale(secp256k1_gej *r, const secp256k1_fe *s) {
@@ -20,6 +20,13 @@ static void secp256k1_sha256_initialize(secp256k1_sha256 *hash);
 static void secp256k1_sha256_write(secp256k1_sha256 *hash, const unsigned char *data, size_t size);
 static void secp256k1_sha256_finalize(secp256k1_sha256 *hash, unsigned char *out32);
 
+/** Serialize the state of a hash that has processed a nonzero multiple of 64 bytes (such as a
+ *  tagged hash after initialization) into 32 bytes, and restore a hash from such a
+ *  serialization. Restoring sets the number of bytes processed to 64; a caller that saved a
+ *  later state sets it afterwards. */
+static void secp256k1_sha256_save_midstate(unsigned char *out32, const secp256k1_sha256 *hash);
+static void secp256k1_sha256_load_midstate(secp256k1_sha256 *hash, const unsigned char *in32);
+
 typedef struct {
     secp256k1_sha256 inner, outer;
 } secp256k1_hmac_sha256;
@@ -28,13 +35,21 @@ static void secp256k1_hmac_sha256_initialize(secp256k1_hmac_sha256 *hash, const
 static void secp256k1_hmac_sha256_write(secp256k1_hmac_sha256 *hash, const unsigned char *data, size_t size);
 static void secp256k1_hmac_sha256_finalize(secp256k1_hmac_sha256 *hash, unsigned char *out32);
 
+/* The key K is kept as an HMAC that has absorbed it, as every K is used for at
+ * least two HMACs. */
 typedef struct {
     unsigned char v[32];
-    unsigned char k[32];
+    secp256k1_hmac_sha256 k;
     int retry;
 } secp256k1_rfc6979_hmac_sha256;
 
 static void secp256k1_rfc6979_hmac_sha256_initialize(secp256k1_rfc6979_hmac_sha256 *rng, const unsigned char *key, size_t keylen);
+/** Split secp256k1_rfc6979_hmac_sha256_initialize, for callers that reuse a state of the
+ *  first HMAC (whose key and first 33 bytes of message are fixed) across keys with a common
+ *  prefix: _start sets inner to that HMAC's inner hash, to which the caller writes key, then
+ *  _initialize_started completes the initialization (and needs key again). */
+static void secp256k1_rfc6979_hmac_sha256_start(secp256k1_sha256 *inner);
+static void secp256k1_rfc6979_hmac_sha256_initialize_started(secp256k1_rfc6979_hmac_sha256 *rng, secp256k1_sha256 *inner, const unsigned char *key, size_t keylen);
 static void secp256k1_rfc6979_hmac_sha256_generate(secp256k1_rfc6979_hmac_sha256 *rng, unsigned char *out, size_t outlen);
 static void secp256k1_rfc6979_hmac_sha256_finalize(secp256k1_rfc6979_hmac_sha256 *rng);
 
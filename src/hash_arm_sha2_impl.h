@@ -0,0 +1,55 @@
+/**********************************************************************
+ * Distributed under the MIT software license, see the accompanying   *
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
+ **********************************************************************/
+
+#ifndef SECP256K1_HASH_ARM_SHA2_IMPL_H
+#define SECP256K1_HASH_ARM_SHA2_IMPL_H
+
+/* SHA-256 transform using the ARMv8 SHA2 crypto extensions. Unlike the x86 variant
+ * this is selected at compile time: configure only enables it when the compiler
+ * targets the extensions (e.g. -march=armv8-a+crypto). The round constants are
+ * secp256k1_sha256_k from hash_impl.h. */
+
+#include <stdint.h>
+#include <arm_neon.h>
+
+/** Perform the SHA-256 transformation for blocks consecutive 64-byte chunks. */
+static void secp256k1_sha256_transform_arm_sha2(uint32_t* s, const unsigned char* chunk, size_t blocks) {
+    uint32x4_t s0, s1, so0, so1, tmp, wk;
+    uint32x4_t m[4];
+    int g;
+
+    s0 = vld1q_u32(s);
+    s1 = vld1q_u32(s + 4);
+
+    while (blocks--) {
+        so0 = s0;
+        so1 = s1;
+
+        for (g = 0; g < 4; g++) {
+            m[g] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(chunk + 16 * g)));
+        }
+
+        /* 16 groups of four rounds; from the fifth group on, the message words
+         * w[4g..4g+3] are expanded in place from the previous sixteen. */
+        for (g = 0; g < 16; g++) {
+            if (g >= 4) {
+                m[g & 3] = vsha256su1q_u32(vsha256su0q_u32(m[g & 3], m[(g + 1) & 3]), m[(g + 2) & 3], m[(g + 3) & 3]);
+            }
+            wk = vaddq_u32(m[g & 3], vld1q_u32(&secp256k1_sha256_k[4 * g]));
+            tmp = s0;
+            s0 = vsha256hq_u32(s0, s1, wk);
+            s1 = vsha256h2q_u32(s1, tmp, wk);
+        }
+
+        s0 = vaddq_u32(s0, so0);
+        s1 = vaddq_u32(s1, so1);
+        chunk += 64;
+    }
+
+    vst1q_u32(s, s0);
+    vst1q_u32(s + 4, s1);
+}
+
+#endif /* SECP256K1_HASH_ARM_SHA2_IMPL_H */
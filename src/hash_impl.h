@@ -34,6 +34,25 @@
 #define BE32(p) ((((p) & 0xFF) << 24) | (((p) & 0xFF00) << 8) | (((p) & 0xFF0000) >> 8) | (((p) & 0xFF000000) >> 24))
 #endif
 
+#if defined(USE_SHA256_X86_SHANI) || defined(USE_SHA256_ARM_SHA2)
+static const uint32_t secp256k1_sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+#endif
+
+#if defined(USE_SHA256_X86_SHANI)
+#include "hash_x86_shani_impl.h"
+#elif defined(USE_SHA256_ARM_SHA2)
+#include "hash_arm_sha2_impl.h"
+#endif
+
 static void secp256k1_sha256_initialize(secp256k1_sha256 *hash) {
     hash->s[0] = 0x6a09e667ul;
     hash->s[1] = 0xbb67ae85ul;
@@ -129,19 +148,47 @@ static void secp256k1_sha256_transform(uint32_t* s, const uint32_t* chunk) {
     s[7] += h;
 }
 
+/** Perform the SHA-256 transformation for blocks consecutive 64-byte chunks, using the
+ *  hardware implementation if one was configured and is supported by the CPU. */
+static void secp256k1_sha256_transform_blocks(uint32_t* s, const unsigned char* chunk, size_t blocks) {
+    uint32_t buf[16];
+    SECP256K1_COUNT_N(SHA256_TRANSFORM, blocks);
+#if defined(USE_SHA256_X86_SHANI)
+    if (secp256k1_sha256_x86_shani_available()) {
+        secp256k1_sha256_transform_x86_shani(s, chunk, blocks);
+        return;
+    }
+#elif defined(USE_SHA256_ARM_SHA2)
+    secp256k1_sha256_transform_arm_sha2(s, chunk, blocks);
+    return;
+#endif
+    while (blocks--) {
+        memcpy(buf, chunk, 64);
+        secp256k1_sha256_transform(s, buf);
+        chunk += 64;
+    }
+}
+
 static void secp256k1_sha256_write(secp256k1_sha256 *hash, const unsigned char *data, size_t len) {
     size_t bufsize = hash->bytes & 0x3F;
     hash->bytes += len;
     VERIFY_CHECK(hash->bytes >= len);
-    while (len >= 64 - bufsize) {
+    if (bufsize && len >= 64 - bufsize) {
         /* Fill the buffer, and process it. */
         size_t chunk_len = 64 - bufsize;
         memcpy(((unsigned char*)hash->buf) + bufsize, data, chunk_len);
         data += chunk_len;
         len -= chunk_len;
-        secp256k1_sha256_transform(hash->s, hash->buf);
+        secp256k1_sha256_transform_blocks(hash->s, (const unsigned char*)hash->buf, 1);
         bufsize = 0;
     }
+    if (len >= 64) {
+        /* Process all remaining full chunks directly from the input. */
+        size_t blocks = len >> 6;
+        secp256k1_sha256_transform_blocks(hash->s, data, blocks);
+        data += blocks << 6;
+        len &= 0x3F;
+    }
     if (len) {
         /* Fill the buffer with what remains. */
         memcpy(((unsigned char*)hash->buf) + bufsize, data, len);
@@ -177,6 +224,25 @@ static void secp256k1_sha256_initialize_tagged(secp256k1_sha256 *hash, const uns
     secp256k1_sha256_write(hash, buf, 32);
 }
 
+static void secp256k1_sha256_save_midstate(unsigned char *out32, const secp256k1_sha256 *hash) {
+    int i;
+    VERIFY_CHECK(hash->bytes != 0 && (hash->bytes & 63) == 0);
+    for (i = 0; i < 8; i++) {
+        out32[4*i + 0] = hash->s[i] >> 24;
+        out32[4*i + 1] = hash->s[i] >> 16;
+        out32[4*i + 2] = hash->s[i] >> 8;
+        out32[4*i + 3] = hash->s[i];
+    }
+}
+
+static void secp256k1_sha256_load_midstate(secp256k1_sha256 *hash, const unsigned char *in32) {
+    int i;
+    for (i = 0; i < 8; i++) {
+        hash->s[i] = (uint32_t)in32[4*i + 0] << 24 | (uint32_t)in32[4*i + 1] << 16 | (uint32_t)in32[4*i + 2] << 8 | (uint32_t)in32[4*i + 3];
+    }
+    hash->bytes = 64;
+}
+
 static void secp256k1_hmac_sha256_initialize(secp256k1_hmac_sha256 *hash, const unsigned char *key, size_t keylen) {
     size_t n;
     unsigned char rkey[64];
@@ -218,56 +284,102 @@ static void secp256k1_hmac_sha256_finalize(secp256k1_hmac_sha256 *hash, unsigned
 }
 
 
-static void secp256k1_rfc6979_hmac_sha256_initialize(secp256k1_rfc6979_hmac_sha256 *rng, const unsigned char *key, size_t keylen) {
+/* Sets V = HMAC_K(V). */
+static void secp256k1_rfc6979_hmac_sha256_update_v(secp256k1_rfc6979_hmac_sha256 *rng) {
+    secp256k1_hmac_sha256 hmac = rng->k;
+    secp256k1_hmac_sha256_write(&hmac, rng->v, 32);
+    secp256k1_hmac_sha256_finalize(&hmac, rng->v);
+}
+
+static void secp256k1_rfc6979_hmac_sha256_start(secp256k1_sha256 *inner) {
+    static const unsigned char v_zero[33] = {
+        0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+        0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+        0x00
+    };
+
+    /* The first HMAC is keyed with K = 0x00...00 (RFC6979 3.2.c.), so its inner
+     * hash starts from a fixed midstate: SHA256 after one block of 0x36 bytes. */
+    secp256k1_sha256_initialize(inner);
+    inner->s[0] = 0xf454deadul;
+    inner->s[1] = 0x9725214ful;
+    inner->s[2] = 0x90daf2a0ul;
+    inner->s[3] = 0xdf1228eaul;
+    inner->s[4] = 0x64e5750ful;
+    inner->s[5] = 0xa3924181ul;
+    inner->s[6] = 0x824a932bul;
+    inner->s[7] = 0xf8e04e32ul;
+    inner->bytes = 64;
+
+    /* RFC6979 3.2.b. and the start of 3.2.d.: V = 0x01...01, followed by 0x00. */
+    secp256k1_sha256_write(inner, v_zero, sizeof(v_zero));
+}
+
+static void secp256k1_rfc6979_hmac_sha256_initialize_started(secp256k1_rfc6979_hmac_sha256 *rng, secp256k1_sha256 *inner, const unsigned char *key, size_t keylen) {
+    secp256k1_sha256 outer;
     secp256k1_hmac_sha256 hmac;
-    static const unsigned char zero[1] = {0x00};
+    unsigned char k[32];
     static const unsigned char one[1] = {0x01};
 
-    memset(rng->v, 0x01, 32); /* RFC6979 3.2.b. */
-    memset(rng->k, 0x00, 32); /* RFC6979 3.2.c. */
-
-    /* RFC6979 3.2.d. */
-    secp256k1_hmac_sha256_initialize(&hmac, rng->k, 32);
-    secp256k1_hmac_sha256_write(&hmac, rng->v, 32);
-    secp256k1_hmac_sha256_write(&hmac, zero, 1);
-    secp256k1_hmac_sha256_write(&hmac, key, keylen);
-    secp256k1_hmac_sha256_finalize(&hmac, rng->k);
-    secp256k1_hmac_sha256_initialize(&hmac, rng->k, 32);
-    secp256k1_hmac_sha256_write(&hmac, rng->v, 32);
-    secp256k1_hmac_sha256_finalize(&hmac, rng->v);
+    /* RFC6979 3.2.d., with the outer hash of K = 0x00...00 starting from the
+     * midstate after one block of 0x5c bytes. */
+    secp256k1_sha256_finalize(inner, k);
+    secp256k1_sha256_initialize(&outer);
+    outer.s[0] = 0xd385480ful;
+    outer.s[1] = 0x7abb6477ul;
+    outer.s[2] = 0x37c9c538ul;
+    outer.s[3] = 0x5dd82467ul;
+    outer.s[4] = 0x8e043a72ul;
+    outer.s[5] = 0x753434b0ul;
+    outer.s[6] = 0xdeb82818ul;
+    outer.s[7] = 0x361d45a6ul;
+    outer.bytes = 64;
+    secp256k1_sha256_write(&outer, k, 32);
+    secp256k1_sha256_finalize(&outer, k);
+    secp256k1_hmac_sha256_initialize(&rng->k, k, 32);
+    memset(rng->v, 0x01, 32);
+    secp256k1_rfc6979_hmac_sha256_update_v(rng);
 
     /* RFC6979 3.2.f. */
-    secp256k1_hmac_sha256_initialize(&hmac, rng->k, 32);
+    hmac = rng->k;
     secp256k1_hmac_sha256_write(&hmac, rng->v, 32);
     secp256k1_hmac_sha256_write(&hmac, one, 1);
     secp256k1_hmac_sha256_write(&hmac, key, keylen);
-    secp256k1_hmac_sha256_finalize(&hmac, rng->k);
-    secp256k1_hmac_sha256_initialize(&hmac, rng->k, 32);
-    secp256k1_hmac_sha256_write(&hmac, rng->v, 32);
-    secp256k1_hmac_sha256_finalize(&hmac, rng->v);
+    secp256k1_hmac_sha256_finalize(&hmac, k);
+    secp256k1_hmac_sha256_initialize(&rng->k, k, 32);
+    secp256k1_rfc6979_hmac_sha256_update_v(rng);
     rng->retry = 0;
+
+    memset(k, 0, sizeof(k));
+    memset(&outer, 0, sizeof(outer));
+    memset(&hmac, 0, sizeof(hmac));
+}
+
+static void secp256k1_rfc6979_hmac_sha256_initialize(secp256k1_rfc6979_hmac_sha256 *rng, const unsigned char *key, size_t keylen) {
+    secp256k1_sha256 inner;
+
+    secp256k1_rfc6979_hmac_sha256_start(&inner);
+    secp256k1_sha256_write(&inner, key, keylen);
+    secp256k1_rfc6979_hmac_sha256_initialize_started(rng, &inner, key, keylen);
 }
 
 static void secp256k1_rfc6979_hmac_sha256_generate(secp256k1_rfc6979_hmac_sha256 *rng, unsigned char *out, size_t outlen) {
     /* RFC6979 3.2.h. */
     static const unsigned char zero[1] = {0x00};
     if (rng->retry) {
-        secp256k1_hmac_sha256 hmac;
-        secp256k1_hmac_sha256_initialize(&hmac, rng->k, 32);
+        secp256k1_hmac_sha256 hmac = rng->k;
+        unsigned char k[32];
         secp256k1_hmac_sha256_write(&hmac, rng->v, 32);
         secp256k1_hmac_sha256_write(&hmac, zero, 1);
-        secp256k1_hmac_sha256_finalize(&hmac, rng->k);
-        secp256k1_hmac_sha256_initialize(&hmac, rng->k, 32);
-        secp256k1_hmac_sha256_write(&hmac, rng->v, 32);
-        secp256k1_hmac_sha256_finalize(&hmac, rng->v);
+        secp256k1_hmac_sha256_finalize(&hmac, k);
+        secp256k1_hmac_sha256_initialize(&rng->k, k, 32);
+        secp256k1_rfc6979_hmac_sha256_update_v(rng);
+        memset(k, 0, sizeof(k));
     }
 
     while (outlen > 0) {
-        secp256k1_hmac_sha256 hmac;
         int now = outlen;
-        secp256k1_hmac_sha256_initialize(&hmac, rng->k, 32);
-        secp256k1_hmac_sha256_write(&hmac, rng->v, 32);
-        secp256k1_hmac_sha256_finalize(&hmac, rng->v);
+        secp256k1_rfc6979_hmac_sha256_update_v(rng);
         if (now > 32) {
             now = 32;
         }
@@ -280,7 +392,7 @@ static void secp256k1_rfc6979_hmac_sha256_generate(secp256k1_rfc6979_hmac_sha256
 }
 
 static void secp256k1_rfc6979_hmac_sha256_finalize(secp256k1_rfc6979_hmac_sha256 *rng) {
-    memset(rng->k, 0, 32);
+    memset(&rng->k, 0, sizeof(rng->k));
     memset(rng->v, 0, 32);
     rng->retry = 0;
 }
@@ -0,0 +1,121 @@
+/**********************************************************************
+ * Distributed under the MIT software license, see the accompanying   *
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
+ **********************************************************************/
+
+#ifndef SECP256K1_HASH_X86_SHANI_IMPL_H
+#define SECP256K1_HASH_X86_SHANI_IMPL_H
+
+/* SHA-256 transform using the x86 SHA extensions (based on the Intel whitepaper
+ * "Intel SHA Extensions: New Instructions Supporting the Secure Hash Algorithm on
+ * Intel Architecture Processors"). The code is compiled for the required ISA with
+ * a target attribute, and is only called when CPUID reports the extensions
+ * (see secp256k1_sha256_x86_shani_available). The round constants are
+ * secp256k1_sha256_k from hash_impl.h. */
+
+#include <stdint.h>
+#include <immintrin.h>
+#include "cpu_impl.h"
+
+#define SECP256K1_SHANI_TARGET __attribute__((target("sha,sse4.1,ssse3")))
+
+/* Four rounds, using message words m (plus round constants k[i..i+3]). */
+#define SECP256K1_SHANI_QUADROUND(s0, s1, m, i) do { \
+    __m128i msg_ = _mm_add_epi32((m), _mm_loadu_si128((const __m128i*)&secp256k1_sha256_k[(i)])); \
+    (s1) = _mm_sha256rnds2_epu32((s1), (s0), msg_); \
+    (s0) = _mm_sha256rnds2_epu32((s0), (s1), _mm_shuffle_epi32(msg_, 0x0e)); \
+} while(0)
+
+/* Message schedule steps: A starts the expansion of m0, C completes the expansion of m2. */
+#define SECP256K1_SHANI_SHIFT_A(m0, m1) do { \
+    (m0) = _mm_sha256msg1_epu32((m0), (m1)); \
+} while(0)
+
+#define SECP256K1_SHANI_SHIFT_C(m0, m1, m2) do { \
+    (m2) = _mm_sha256msg2_epu32(_mm_add_epi32((m2), _mm_alignr_epi8((m1), (m0), 4)), (m1)); \
+} while(0)
+
+#define SECP256K1_SHANI_SHIFT_B(m0, m1, m2) do { \
+    SECP256K1_SHANI_SHIFT_C(m0, m1, m2); \
+    SECP256K1_SHANI_SHIFT_A(m0, m1); \
+} while(0)
+
+/** Perform the SHA-256 transformation for blocks consecutive 64-byte chunks. */
+SECP256K1_SHANI_TARGET
+static void secp256k1_sha256_transform_x86_shani(uint32_t* s, const unsigned char* chunk, size_t blocks) {
+    const __m128i mask = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+    __m128i m0, m1, m2, m3, s0, s1, so0, so1, t1, t2;
+
+    /* Load the state, and rearrange it into the ABEF/CDGH order used by the instructions. */
+    s0 = _mm_loadu_si128((const __m128i*)s);
+    s1 = _mm_loadu_si128((const __m128i*)(s + 4));
+    t1 = _mm_shuffle_epi32(s0, 0xB1);
+    t2 = _mm_shuffle_epi32(s1, 0x1B);
+    s0 = _mm_alignr_epi8(t1, t2, 0x08);
+    s1 = _mm_blend_epi16(t2, t1, 0xF0);
+
+    while (blocks--) {
+        so0 = s0;
+        so1 = s1;
+
+        m0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)chunk), mask);
+        SECP256K1_SHANI_QUADROUND(s0, s1, m0, 0);
+        m1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(chunk + 16)), mask);
+        SECP256K1_SHANI_QUADROUND(s0, s1, m1, 4);
+        SECP256K1_SHANI_SHIFT_A(m0, m1);
+        m2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(chunk + 32)), mask);
+        SECP256K1_SHANI_QUADROUND(s0, s1, m2, 8);
+        SECP256K1_SHANI_SHIFT_A(m1, m2);
+        m3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(chunk + 48)), mask);
+        SECP256K1_SHANI_QUADROUND(s0, s1, m3, 12);
+        SECP256K1_SHANI_SHIFT_B(m2, m3, m0);
+        SECP256K1_SHANI_QUADROUND(s0, s1, m0, 16);
+        SECP256K1_SHANI_SHIFT_B(m3, m0, m1);
+        SECP256K1_SHANI_QUADROUND(s0, s1, m1, 20);
+        SECP256K1_SHANI_SHIFT_B(m0, m1, m2);
+        SECP256K1_SHANI_QUADROUND(s0, s1, m2, 24);
+        SECP256K1_SHANI_SHIFT_B(m1, m2, m3);
+        SECP256K1_SHANI_QUADROUND(s0, s1, m3, 28);
+        SECP256K1_SHANI_SHIFT_B(m2, m3, m0);
+        SECP256K1_SHANI_QUADROUND(s0, s1, m0, 32);
+        SECP256K1_SHANI_SHIFT_B(m3, m0, m1);
+        SECP256K1_SHANI_QUADROUND(s0, s1, m1, 36);
+        SECP256K1_SHANI_SHIFT_B(m0, m1, m2);
+        SECP256K1_SHANI_QUADROUND(s0, s1, m2, 40);
+        SECP256K1_SHANI_SHIFT_B(m1, m2, m3);
+        SECP256K1_SHANI_QUADROUND(s0, s1, m3, 44);
+        SECP256K1_SHANI_SHIFT_B(m2, m3, m0);
+        SECP256K1_SHANI_QUADROUND(s0, s1, m0, 48);
+        SECP256K1_SHANI_SHIFT_B(m3, m0, m1);
+        SECP256K1_SHANI_QUADROUND(s0, s1, m1, 52);
+        SECP256K1_SHANI_SHIFT_C(m0, m1, m2);
+        SECP256K1_SHANI_QUADROUND(s0, s1, m2, 56);
+        SECP256K1_SHANI_SHIFT_C(m1, m2, m3);
+        SECP256K1_SHANI_QUADROUND(s0, s1, m3, 60);
+
+        s0 = _mm_add_epi32(s0, so0);
+        s1 = _mm_add_epi32(s1, so1);
+        chunk += 64;
+    }
+
+    /* Restore the ABCD/EFGH order and store the state. */
+    t1 = _mm_shuffle_epi32(s0, 0x1B);
+    t2 = _mm_shuffle_epi32(s1, 0xB1);
+    s0 = _mm_blend_epi16(t1, t2, 0xF0);
+    s1 = _mm_alignr_epi8(t2, t1, 0x08);
+    _mm_storeu_si128((__m128i*)s, s0);
+    _mm_storeu_si128((__m128i*)(s + 4), s1);
+}
+
+#undef SECP256K1_SHANI_SHIFT_B
+#undef SECP256K1_SHANI_SHIFT_C
+#undef SECP256K1_SHANI_SHIFT_A
+#undef SECP256K1_SHANI_QUADROUND
+#undef SECP256K1_SHANI_TARGET
+
+/** Returns whether the CPU supports the SHA, SSSE3 and SSE4.1 instructions. */
+static int secp256k1_sha256_x86_shani_available(void) {
+    return secp256k1_cpu_x86_has(SECP256K1_CPU_X86_SHANI);
+}
+
+#endif /* SECP256K1_HASH_X86_SHANI_IMPL_H */
@@ -0,0 +1,219 @@
+/* src/libsecp256k1-config.h.  Generated from libsecp256k1-config.h.in by configure.  */
+/* src/libsecp256k1-config.h.in.  Generated from configure.ac by autoheader.  */
+
+#ifndef LIBSECP256K1_CONFIG_H
+
+#define LIBSECP256K1_CONFIG_H
+
+/* Define this symbol to compile out all VERIFY code */
+/* #undef COVERAGE */
+
+/* Set window size for constant-time ecmult */
+#define ECMULT_CONST_WINDOW 5
+
+/* Set number of blocks of the ecmult gen comb */
+/* #undef ECMULT_GEN_COMB_BLOCKS */
+
+/* Set number of teeth per block of the ecmult gen comb */
+/* #undef ECMULT_GEN_COMB_TEETH */
+
+/* Set ecmult gen precision bits */
+#define ECMULT_GEN_PREC_BITS 4
+
+/* Set window size for the variable points of ecmult */
+#define ECMULT_WINDOW_A 5
+
+/* Set window size for ecmult precomputation */
+#define ECMULT_WINDOW_SIZE 15
+
+/* Define this symbol to count operations for secp256k1_counters_snapshot */
+/* #undef ENABLE_COUNTERS */
+
+/* Define this symbol to enable the verification batch module */
+#define ENABLE_MODULE_BATCH 1
+
+/* Define this symbol to enable the ECDH module */
+#define ENABLE_MODULE_ECDH 1
+
+/* Define this symbol to enable the ecmult_multi module */
+#define ENABLE_MODULE_ECMULT_MULTI 1
+
+/* Define this symbol to enable the extrakeys module */
+#define ENABLE_MODULE_EXTRAKEYS 1
+
+/* Define this symbol to enable the MuSig2 module */
+#define ENABLE_MODULE_MUSIG 1
+
+/* Define this symbol to enable the ECDSA pubkey recovery module */
+#define ENABLE_MODULE_RECOVERY 1
+
+/* Define this symbol to enable the schnorrsig module */
+#define ENABLE_MODULE_SCHNORRSIG 1
+
+/* Define this symbol to enable the Schnorr signature half-aggregation module
+   */
+#define ENABLE_MODULE_SCHNORRSIG_HALFAGG 1
+
+/* Define this symbol if OpenSSL EC functions are available */
+/* #undef ENABLE_OPENSSL_TESTS */
+
+/* Define this symbol to leave signing out of the library */
+/* #undef ENABLE_VERIFY_ONLY */
+
+/* Define to 1 if you have the <dlfcn.h> header file. */
+#define HAVE_DLFCN_H 1
+
+/* Define to 1 if you have the `fork' function. */
+#define HAVE_FORK 1
+
+/* Define to 1 if you have the <inttypes.h> header file. */
+#define HAVE_INTTYPES_H 1
+
+/* Define this symbol if libcrypto is installed */
+#define HAVE_LIBCRYPTO 1
+
+/* Define this symbol if libgmp is installed */
+#define HAVE_LIBGMP 1
+
+/* Define to 1 if you have the <stdint.h> header file. */
+#define HAVE_STDINT_H 1
+
+/* Define to 1 if you have the <stdio.h> header file. */
+#define HAVE_STDIO_H 1
+
+/* Define to 1 if you have the <stdlib.h> header file. */
+#define HAVE_STDLIB_H 1
+
+/* Define to 1 if you have the <strings.h> header file. */
+#define HAVE_STRINGS_H 1
+
+/* Define to 1 if you have the <string.h> header file. */
+#define HAVE_STRING_H 1
+
+/* Define to 1 if you have the <sys/stat.h> header file. */
+#define HAVE_SYS_STAT_H 1
+
+/* Define to 1 if you have the <sys/types.h> header file. */
+#define HAVE_SYS_TYPES_H 1
+
+/* Define to 1 if you have the <sys/wait.h> header file. */
+#define HAVE_SYS_WAIT_H 1
+
+/* Define to 1 if you have the <unistd.h> header file. */
+#define HAVE_UNISTD_H 1
+
+/* Define to the sub-directory where libtool stores uninstalled libraries. */
+#define LT_OBJDIR ".libs/"
+
+/* Name of package */
+#define PACKAGE "libsecp256k1"
+
+/* Define to the address where bug reports for this package should be sent. */
+#define PACKAGE_BUGREPORT ""
+
+/* Define to the full name of this package. */
+#define PACKAGE_NAME "libsecp256k1"
+
+/* Define to the full name and version of this package. */
+#define PACKAGE_STRING "libsecp256k1 0.1"
+
+/* Define to the one symbol short name of this package. */
+#define PACKAGE_TARNAME "libsecp256k1"
+
+/* Define to the home page for this package. */
+#define PACKAGE_URL ""
+
+/* Define to the version of this package. */
+#define PACKAGE_VERSION "0.1"
+
+/* Define to 1 if all of the C90 standard headers exist (not just the ones
+   required in a freestanding environment). This macro is provided for
+   backward compatibility; new code need not use it. */
+#define STDC_HEADERS 1
+
+/* Define this symbol to enable AArch64 assembly optimizations */
+/* #undef USE_ASM_AARCH64 */
+
+/* Define this symbol to enable x86_64 assembly optimizations */
+#define USE_ASM_X86_64 1
+
+/* Define this symbol to use MULX/ADX x86_64 assembly when available at
+   runtime */
+#define USE_ASM_X86_64_ADX 1
+
+/* Define this symbol to keep a single ecmult table for verification */
+/* #undef USE_ECMULT_COMPACT_VERIFY_TABLE */
+
+/* Define this symbol to use AVX2 for the ecmult gen table scan when available
+   at runtime */
+#define USE_ECMULT_GEN_X86_AVX2 1
+
+/* Define this symbol to use a statically generated ecmult table */
+#define USE_ECMULT_STATIC_PRECOMPUTATION 1
+
+/* Define this symbol to use a statically generated ecmult table for
+   verification */
+/* #undef USE_ECMULT_STATIC_VERIFY_TABLE */
+
+/* Define this symbol if an external (non-inline) assembly implementation is
+   used */
+/* #undef USE_EXTERNAL_ASM */
+
+/* Define this symbol if an external implementation of the default callbacks
+   is used */
+/* #undef USE_EXTERNAL_DEFAULT_CALLBACKS */
+
+/* Define this symbol to use NEON for the 10x26 field multiplication */
+/* #undef USE_FIELD_10X26_NEON */
+
+/* Define this symbol to use AVX-512 IFMA for eight-way field arithmetic when
+   available at runtime */
+#define USE_FIELD_5X52_IFMA 1
+
+/* Define this symbol to use the native field inverse implementation */
+/* #undef USE_FIELD_INV_BUILTIN */
+
+/* Define this symbol to use the num-based field inverse implementation */
+/* #undef USE_FIELD_INV_NUM */
+
+/* Define this symbol to use the safegcd-based field inverse implementation */
+#define USE_FIELD_INV_SAFEGCD 1
+
+/* Define this symbol to force the use of the (unsigned) __int128 based wide
+   multiplication implementation */
+/* #undef USE_FORCE_WIDEMUL_INT128 */
+
+/* Define this symbol to force the use of the (u)int64_t based wide
+   multiplication implementation */
+/* #undef USE_FORCE_WIDEMUL_INT64 */
+
+/* Define this symbol to use the gmp implementation for num */
+#define USE_NUM_GMP 1
+
+/* Define this symbol to use no num implementation */
+/* #undef USE_NUM_NONE */
+
+/* Define this symbol to use NEON for the 8x32 scalar multiplication */
+/* #undef USE_SCALAR_8X32_NEON */
+
+/* Define this symbol to use the native scalar inverse implementation */
+/* #undef USE_SCALAR_INV_BUILTIN */
+
+/* Define this symbol to use the num-based scalar inverse implementation */
+/* #undef USE_SCALAR_INV_NUM */
+
+/* Define this symbol to use the safegcd-based scalar inverse implementation
+   */
+#define USE_SCALAR_INV_SAFEGCD 1
+
+/* Define this symbol to use the ARMv8 SHA2 extensions for SHA-256 */
+/* #undef USE_SHA256_ARM_SHA2 */
+
+/* Define this symbol to use the x86 SHA extensions for SHA-256 when available
+   at runtime */
+#define USE_SHA256_X86_SHANI 1
+
+/* Version number of package */
+#define VERSION "0.1"
+
+#endif /*LIBSECP256K1_CONFIG_H*/
@@ -0,0 +1,530 @@
+/**********************************************************************
+ * Distributed under the MIT software license, see the accompanying   *
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
+ **********************************************************************/
+
+#ifndef SECP256K1_MODULE_BATCH_MAIN_H
+#define SECP256K1_MODULE_BATCH_MAIN_H
+
+#include "include/secp256k1_batch.h"
+
+/* Domain separation of the check types in the transcript */
+#define SECP256K1_BATCH_TYPE_SCHNORRSIG 1
+#define SECP256K1_BATCH_TYPE_XONLY_TWEAK_CHECK 2
+
+struct secp256k1_batch_struct {
+    /* Holds the terms, followed by the working space of ecmult_multi */
+    secp256k1_scratch *scratch;
+    secp256k1_scalar *scalars;
+    secp256k1_ge *points;
+    /* Scalar of the generator of every check whose terms are collected, the index of
+     * the check among all added ones, and room for the results of a bisection */
+    secp256k1_scalar *check_sc_g;
+    size_t *check_idx;
+    unsigned char *check_valid;
+    /* Number of checks added so far */
+    size_t n_added;
+    /* Receives the indices of the failing checks in bisection mode, or NULL */
+    secp256k1_batch_invalid_function invalid;
+    void *invalid_data;
+    /* Transcript of all checks added so far, used to derive the randomizers */
+    secp256k1_sha256 sha;
+    size_t len;
+    size_t capacity;
+    int result;
+    /* The allocator of the context the batch was created with */
+    secp256k1_allocator allocator;
+};
+
+/* Initializes SHA256 as a tagged hash with tag "secp256k1/batch". */
+static void secp256k1_batch_sha256_tagged(secp256k1_sha256 *sha) {
+    static const unsigned char tag[] = {'s', 'e', 'c', 'p', '2', '5', '6', 'k', '1', '/', 'b', 'a', 't', 'c', 'h'};
+    secp256k1_sha256_initialize_tagged(sha, tag, sizeof(tag));
+}
+
+/* Computes the scratch size needed by ecmult_multi to evaluate n terms in one go. */
+static size_t secp256k1_batch_ecmult_scratch_size(size_t n) {
+    if (n >= ECMULT_PIPPENGER_THRESHOLD) {
+        return secp256k1_pippenger_scratch_size(n, secp256k1_pippenger_bucket_window(n)) + PIPPENGER_SCRATCH_OBJECTS*ALIGNMENT;
+    }
+    return secp256k1_strauss_scratch_size(n) + STRAUSS_SCRATCH_OBJECTS*ALIGNMENT;
+}
+
+secp256k1_batch* secp256k1_batch_create(const secp256k1_context* ctx, size_t max_terms) {
+    secp256k1_batch *batch;
+    size_t terms_size, max_checks;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(max_terms >= 2);
+    ARG_CHECK(max_terms < ((uint32_t)1 << 31));
+
+    batch = (secp256k1_batch *)secp256k1_allocator_alloc(&ctx->allocator, &ctx->error_callback, sizeof(*batch));
+    if (batch == NULL) {
+        return NULL;
+    }
+    batch->allocator = ctx->allocator;
+    /* Every check has two terms. */
+    max_checks = max_terms / 2;
+    terms_size = ROUND_TO_ALIGN(max_terms * sizeof(secp256k1_scalar)) + ROUND_TO_ALIGN(max_terms * sizeof(secp256k1_ge))
+               + ROUND_TO_ALIGN(max_checks * sizeof(secp256k1_scalar)) + ROUND_TO_ALIGN(max_checks * sizeof(size_t)) + ROUND_TO_ALIGN(max_checks);
+    batch->scratch = secp256k1_scratch_create_with_allocator(&ctx->error_callback, &ctx->allocator, terms_size + secp256k1_batch_ecmult_scratch_size(max_terms));
+    if (batch->scratch == NULL) {
+        secp256k1_allocator_free(&ctx->allocator, batch);
+        return NULL;
+    }
+    batch->scalars = (secp256k1_scalar *)secp256k1_scratch_alloc(&ctx->error_callback, batch->scratch, max_terms * sizeof(secp256k1_scalar));
+    batch->points = (secp256k1_ge *)secp256k1_scratch_alloc(&ctx->error_callback, batch->scratch, max_terms * sizeof(secp256k1_ge));
+    batch->check_sc_g = (secp256k1_scalar *)secp256k1_scratch_alloc(&ctx->error_callback, batch->scratch, max_checks * sizeof(secp256k1_scalar));
+    batch->check_idx = (size_t *)secp256k1_scratch_alloc(&ctx->error_callback, batch->scratch, max_checks * sizeof(size_t));
+    batch->check_valid = (unsigned char *)secp256k1_scratch_alloc(&ctx->error_callback, batch->scratch, max_checks);
+    VERIFY_CHECK(batch->scalars != NULL && batch->points != NULL && batch->check_sc_g != NULL && batch->check_idx != NULL && batch->check_valid != NULL);
+
+    batch->n_added = 0;
+    batch->invalid = NULL;
+    batch->invalid_data = NULL;
+    secp256k1_batch_sha256_tagged(&batch->sha);
+    batch->len = 0;
+    batch->capacity = max_terms;
+    batch->result = 1;
+    return batch;
+}
+
+void secp256k1_batch_destroy(const secp256k1_context* ctx, secp256k1_batch* batch) {
+    VERIFY_CHECK(ctx != NULL);
+    if (batch != NULL) {
+        /* Release the term arrays, which are the only allocations held between calls. */
+        secp256k1_scratch_apply_checkpoint(&ctx->error_callback, batch->scratch, 0);
+        secp256k1_scratch_destroy(&ctx->error_callback, batch->scratch);
+        secp256k1_allocator_free(&batch->allocator, batch);
+    }
+}
+
+/* The terms of a range of checks, for secp256k1_batch_terms_callback */
+typedef struct {
+    const secp256k1_scalar *scalars;
+    const secp256k1_ge *points;
+} secp256k1_batch_terms;
+
+static int secp256k1_batch_terms_callback(secp256k1_scalar *sc, secp256k1_ge *pt, size_t idx, void *data) {
+    const secp256k1_batch_terms *terms = (const secp256k1_batch_terms *) data;
+    *sc = terms->scalars[idx];
+    *pt = terms->points[idx];
+    return 1;
+}
+
+/* Returns whether the checks [lo, hi) hold together, where check i consists of the terms
+ * 2*i and 2*i+1 and the generator scalar sc_g[i]. */
+static int secp256k1_batch_check_range(const secp256k1_context* ctx, secp256k1_scratch *scratch, const secp256k1_scalar *scalars, const secp256k1_ge *points, const secp256k1_scalar *sc_g, size_t lo, size_t hi) {
+    secp256k1_batch_terms terms;
+    secp256k1_scalar g;
+    secp256k1_gej rj;
+    size_t i;
+
+    secp256k1_scalar_set_int(&g, 0);
+    for (i = lo; i < hi; i++) {
+        secp256k1_scalar_add(&g, &g, &sc_g[i]);
+    }
+    terms.scalars = &scalars[2 * lo];
+    terms.points = &points[2 * lo];
+    return secp256k1_ecmult_multi_var(&ctx->error_callback, &ctx->ecmult_ctx, scratch, &rj, &g, secp256k1_batch_terms_callback, &terms, 2 * (hi - lo))
+           && secp256k1_gej_is_infinity(&rj);
+}
+
+/* Clears valid[i] for every check i in [lo, hi) that fails, given that the checks of the
+ * range do not hold together. A range is only split further if it fails, and if the first
+ * half of a failing range holds the second half is known to fail without evaluating it, so
+ * k failing checks out of n are found with O(k log n) evaluations. */
+static void secp256k1_batch_bisect(const secp256k1_context* ctx, secp256k1_scratch *scratch, const secp256k1_scalar *scalars, const secp256k1_ge *points, const secp256k1_scalar *sc_g, size_t lo, size_t hi, unsigned char *valid) {
+    size_t mid;
+
+    VERIFY_CHECK(lo < hi);
+    if (hi - lo == 1) {
+        valid[lo] = 0;
+        return;
+    }
+    mid = lo + (hi - lo) / 2;
+    if (secp256k1_batch_check_range(ctx, scratch, scalars, points, sc_g, lo, mid)) {
+        secp256k1_batch_bisect(ctx, scratch, scalars, points, sc_g, mid, hi, valid);
+    } else {
+        secp256k1_batch_bisect(ctx, scratch, scalars, points, sc_g, lo, mid, valid);
+        if (!secp256k1_batch_check_range(ctx, scratch, scalars, points, sc_g, mid, hi)) {
+            secp256k1_batch_bisect(ctx, scratch, scalars, points, sc_g, mid, hi, valid);
+        }
+    }
+}
+
+/* Evaluates the collected terms, and empties the batch. In bisection mode, the terms are
+ * evaluated even if the batch already failed, and the failing checks are reported. */
+static void secp256k1_batch_flush(const secp256k1_context* ctx, secp256k1_batch *batch) {
+    size_t n_checks = batch->len / 2, i;
+
+    if (n_checks == 0 || (!batch->result && batch->invalid == NULL)) {
+        batch->len = 0;
+        return;
+    }
+    if (!secp256k1_batch_check_range(ctx, batch->scratch, batch->scalars, batch->points, batch->check_sc_g, 0, n_checks)) {
+        batch->result = 0;
+        if (batch->invalid != NULL) {
+            memset(batch->check_valid, 1, n_checks);
+            secp256k1_batch_bisect(ctx, batch->scratch, batch->scalars, batch->points, batch->check_sc_g, 0, n_checks, batch->check_valid);
+            for (i = 0; i < n_checks; i++) {
+                if (!batch->check_valid[i]) {
+                    batch->invalid(batch->check_idx[i], batch->invalid_data);
+                }
+            }
+        }
+    }
+    batch->len = 0;
+}
+
+/* Appends the type and data of a check to the transcript and derives the randomizer of the
+ * check from it. Since the randomizer depends on the check itself, a check cannot be chosen
+ * to cancel out earlier ones. */
+static void secp256k1_batch_randomizer(secp256k1_sha256 *transcript, secp256k1_scalar *r, unsigned char type, const unsigned char *data, size_t len) {
+    secp256k1_sha256 sha;
+    unsigned char buf[32];
+
+    secp256k1_sha256_write(transcript, &type, 1);
+    secp256k1_sha256_write(transcript, data, len);
+    sha = *transcript;
+    secp256k1_sha256_finalize(&sha, buf);
+    secp256k1_scalar_set_b32(r, buf, NULL);
+}
+
+/* Records the result of adding a check. If the check is known to fail without evaluating
+ * it (valid is 0), the batch fails. Otherwise its terms are appended, evaluating the batch
+ * first if it is full. Returns the result of the batch. */
+static int secp256k1_batch_add_check(const secp256k1_context* ctx, secp256k1_batch *batch, int valid, const secp256k1_scalar *scalars, const secp256k1_ge *points, const secp256k1_scalar *sc_g) {
+    size_t idx = batch->n_added++;
+
+    if (!valid) {
+        batch->result = 0;
+        if (batch->invalid != NULL) {
+            batch->invalid(idx, batch->invalid_data);
+        }
+        return 0;
+    }
+    if (batch->capacity - batch->len < 2) {
+        secp256k1_batch_flush(ctx, batch);
+    }
+    batch->scalars[batch->len] = scalars[0];
+    batch->points[batch->len] = points[0];
+    batch->scalars[batch->len + 1] = scalars[1];
+    batch->points[batch->len + 1] = points[1];
+    batch->check_sc_g[batch->len / 2] = *sc_g;
+    batch->check_idx[batch->len / 2] = idx;
+    batch->len += 2;
+    return batch->result;
+}
+
+int secp256k1_batch_set_invalid_callback(const secp256k1_context* ctx, secp256k1_batch *batch, secp256k1_batch_invalid_function invalid, void *data) {
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(batch != NULL);
+    ARG_CHECK(batch->n_added == 0);
+
+    batch->invalid = invalid;
+    batch->invalid_data = data;
+    return 1;
+}
+
+int secp256k1_batch_verify(const secp256k1_context *ctx, secp256k1_batch *batch) {
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(batch != NULL);
+
+    secp256k1_batch_flush(ctx, batch);
+    return batch->result;
+}
+
+int secp256k1_batch_add_xonly_tweak_check(const secp256k1_context* ctx, secp256k1_batch *batch, const unsigned char *tweaked_pubkey32, int tweaked_pk_parity, const secp256k1_xonly_pubkey *internal_pubkey, const unsigned char *tweak32) {
+    unsigned char buf[97];
+    secp256k1_scalar r, t, scalars[2];
+    secp256k1_ge points[2];
+    secp256k1_fe qx;
+    int overflow;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(batch != NULL);
+    ARG_CHECK(tweaked_pubkey32 != NULL);
+    ARG_CHECK(internal_pubkey != NULL);
+    ARG_CHECK(tweak32 != NULL);
+
+    if (!batch->result && batch->invalid == NULL) {
+        return 0;
+    }
+    secp256k1_scalar_set_b32(&t, tweak32, &overflow);
+    if (overflow
+        || (tweaked_pk_parity & ~1) != 0
+        || !secp256k1_xonly_pubkey_load(ctx, &points[0], internal_pubkey)
+        || !secp256k1_fe_set_b32(&qx, tweaked_pubkey32)
+        || !secp256k1_ge_set_xo_var(&points[1], &qx, tweaked_pk_parity)) {
+        return secp256k1_batch_add_check(ctx, batch, 0, NULL, NULL, NULL);
+    }
+
+    memcpy(&buf[0], tweaked_pubkey32, 32);
+    buf[32] = (unsigned char)tweaked_pk_parity;
+    secp256k1_fe_get_b32(&buf[33], &points[0].x);
+    memcpy(&buf[65], tweak32, 32);
+    secp256k1_batch_randomizer(&batch->sha, &r, SECP256K1_BATCH_TYPE_XONLY_TWEAK_CHECK, buf, sizeof(buf));
+
+    /* r*(P - Q + t*G) = 0 */
+    scalars[0] = r;
+    secp256k1_scalar_negate(&scalars[1], &r);
+    secp256k1_scalar_mul(&t, &t, &r);
+    return secp256k1_batch_add_check(ctx, batch, 1, scalars, points, &t);
+}
+
+/* Computes the terms r*R, (e*r)*P and the generator scalar -s*r of a Schnorr signature
+ * check, appending it to the transcript. Returns 0 if the signature is known to be invalid
+ * without evaluating the terms. */
+static int secp256k1_batch_schnorrsig_terms(const secp256k1_context* ctx, secp256k1_sha256 *transcript, secp256k1_scalar *scalars, secp256k1_ge *points, secp256k1_scalar *sc_g, const unsigned char *sig64, const unsigned char *msg32, const secp256k1_xonly_pubkey *pubkey) {
+    unsigned char buf[128];
+    secp256k1_scalar r, s, e;
+    secp256k1_fe rx;
+    int overflow;
+
+    secp256k1_scalar_set_b32(&s, &sig64[32], &overflow);
+    if (overflow
+        || !secp256k1_fe_set_b32(&rx, &sig64[0])
+        || !secp256k1_ge_set_xo_var(&points[0], &rx, 0)
+        || !secp256k1_xonly_pubkey_load(ctx, &points[1], pubkey)) {
+        return 0;
+    }
+
+    memcpy(&buf[0], sig64, 64);
+    memcpy(&buf[64], msg32, 32);
+    secp256k1_fe_get_b32(&buf[96], &points[1].x);
+    secp256k1_schnorrsig_challenge(&e, &sig64[0], msg32, &buf[96]);
+    secp256k1_batch_randomizer(transcript, &r, SECP256K1_BATCH_TYPE_SCHNORRSIG, buf, sizeof(buf));
+
+    /* r*(R + e*P - s*G) = 0 */
+    scalars[0] = r;
+    secp256k1_scalar_mul(&scalars[1], &e, &r);
+    secp256k1_scalar_mul(&s, &s, &r);
+    secp256k1_scalar_negate(sc_g, &s);
+    return 1;
+}
+
+int secp256k1_batch_add_schnorrsig(const secp256k1_context* ctx, secp256k1_batch *batch, const unsigned char *sig64, const unsigned char *msg32, const secp256k1_xonly_pubkey *pubkey) {
+    secp256k1_scalar scalars[2], sc_g;
+    secp256k1_ge points[2];
+    int valid;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(batch != NULL);
+    ARG_CHECK(sig64 != NULL);
+    ARG_CHECK(msg32 != NULL);
+    ARG_CHECK(pubkey != NULL);
+
+    if (!batch->result && batch->invalid == NULL) {
+        return 0;
+    }
+    valid = secp256k1_batch_schnorrsig_terms(ctx, &batch->sha, scalars, points, &sc_g, sig64, msg32, pubkey);
+    return secp256k1_batch_add_check(ctx, batch, valid, scalars, points, &sc_g);
+}
+
+typedef struct {
+    unsigned char sig[64];
+    unsigned char msg[32];
+    secp256k1_xonly_pubkey pk;
+    void *tag;
+} secp256k1_batch_pipeline_item;
+
+/* A block of submitted signatures. It holds everything its job needs, so that the pipeline
+ * can move on to the next block (or be destroyed) while the job is pending. */
+typedef struct {
+    const secp256k1_context *ctx;
+    secp256k1_allocator allocator;
+    secp256k1_batch_pipeline_complete_function complete;
+    void *complete_data;
+    /* Holds the terms and the working space of the job */
+    secp256k1_scratch *scratch;
+    secp256k1_batch_pipeline_item *items;
+    size_t n;
+} secp256k1_batch_pipeline_block;
+
+struct secp256k1_batch_pipeline_struct {
+    const secp256k1_context *ctx;
+    secp256k1_allocator allocator;
+    size_t max_sigs;
+    size_t max_delay;
+    secp256k1_batch_pipeline_complete_function complete;
+    void *complete_data;
+    secp256k1_batch_pipeline_executor_function executor;
+    void *executor_data;
+    /* The block being filled (NULL if none), and the time its first signature was submitted */
+    secp256k1_batch_pipeline_block *block;
+    size_t block_time;
+};
+
+secp256k1_batch_pipeline* secp256k1_batch_pipeline_create(const secp256k1_context* ctx, size_t max_sigs, size_t max_delay, secp256k1_batch_pipeline_complete_function complete, void *complete_data, secp256k1_batch_pipeline_executor_function executor, void *executor_data) {
+    secp256k1_batch_pipeline *pipeline;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(max_sigs >= 1);
+    ARG_CHECK(max_sigs < ((uint32_t)1 << 30));
+    ARG_CHECK(complete != NULL);
+
+    pipeline = (secp256k1_batch_pipeline *)secp256k1_allocator_alloc(&ctx->allocator, &ctx->error_callback, sizeof(*pipeline));
+    if (pipeline == NULL) {
+        return NULL;
+    }
+    pipeline->ctx = ctx;
+    pipeline->allocator = ctx->allocator;
+    pipeline->max_sigs = max_sigs;
+    pipeline->max_delay = max_delay;
+    pipeline->complete = complete;
+    pipeline->complete_data = complete_data;
+    pipeline->executor = executor;
+    pipeline->executor_data = executor_data;
+    pipeline->block = NULL;
+    pipeline->block_time = 0;
+    return pipeline;
+}
+
+static secp256k1_batch_pipeline_block* secp256k1_batch_pipeline_block_create(const secp256k1_batch_pipeline *pipeline) {
+    const secp256k1_context *ctx = pipeline->ctx;
+    size_t n = pipeline->max_sigs;
+    size_t block_size = ROUND_TO_ALIGN(sizeof(secp256k1_batch_pipeline_block));
+    size_t terms_size = ROUND_TO_ALIGN(2 * n * sizeof(secp256k1_scalar)) + ROUND_TO_ALIGN(2 * n * sizeof(secp256k1_ge))
+                      + ROUND_TO_ALIGN(n * sizeof(secp256k1_scalar)) + ROUND_TO_ALIGN(n * sizeof(size_t)) + ROUND_TO_ALIGN(n);
+    secp256k1_batch_pipeline_block *block;
+
+    block = (secp256k1_batch_pipeline_block *)secp256k1_allocator_alloc(&pipeline->allocator, &ctx->error_callback, block_size + n * sizeof(secp256k1_batch_pipeline_item));
+    if (block == NULL) {
+        return NULL;
+    }
+    block->scratch = secp256k1_scratch_create_with_allocator(&ctx->error_callback, &pipeline->allocator, terms_size + secp256k1_batch_ecmult_scratch_size(2 * n));
+    if (block->scratch == NULL) {
+        secp256k1_allocator_free(&pipeline->allocator, block);
+        return NULL;
+    }
+    block->ctx = ctx;
+    block->allocator = pipeline->allocator;
+    block->complete = pipeline->complete;
+    block->complete_data = pipeline->complete_data;
+    block->items = (secp256k1_batch_pipeline_item *)((unsigned char *)block + block_size);
+    block->n = 0;
+    return block;
+}
+
+/* Verifies a block, delivers the results and frees the block. */
+static void secp256k1_batch_pipeline_job(void *job_data) {
+    secp256k1_batch_pipeline_block *block = (secp256k1_batch_pipeline_block *) job_data;
+    const secp256k1_context *ctx = block->ctx;
+    secp256k1_sha256 transcript;
+    secp256k1_scalar *scalars, *sc_g;
+    secp256k1_ge *points;
+    size_t *check_item;
+    unsigned char *valid;
+    size_t i, n_checks = 0;
+
+    scalars = (secp256k1_scalar *)secp256k1_scratch_alloc(&ctx->error_callback, block->scratch, 2 * block->n * sizeof(secp256k1_scalar));
+    points = (secp256k1_ge *)secp256k1_scratch_alloc(&ctx->error_callback, block->scratch, 2 * block->n * sizeof(secp256k1_ge));
+    sc_g = (secp256k1_scalar *)secp256k1_scratch_alloc(&ctx->error_callback, block->scratch, block->n * sizeof(secp256k1_scalar));
+    check_item = (size_t *)secp256k1_scratch_alloc(&ctx->error_callback, block->scratch, block->n * sizeof(size_t));
+    valid = (unsigned char *)secp256k1_scratch_alloc(&ctx->error_callback, block->scratch, block->n);
+    VERIFY_CHECK(scalars != NULL && points != NULL && sc_g != NULL && check_item != NULL && valid != NULL);
+
+    /* Signatures that are known to be invalid get no check. */
+    secp256k1_batch_sha256_tagged(&transcript);
+    for (i = 0; i < block->n; i++) {
+        const secp256k1_batch_pipeline_item *item = &block->items[i];
+        valid[i] = 0;
+        if (secp256k1_batch_schnorrsig_terms(ctx, &transcript, &scalars[2 * n_checks], &points[2 * n_checks], &sc_g[n_checks], item->sig, item->msg, &item->pk)) {
+            check_item[n_checks++] = i;
+        }
+    }
+    /* valid is indexed by check until the results are mapped back to the items. */
+    memset(valid, 1, n_checks);
+    if (n_checks > 0 && !secp256k1_batch_check_range(ctx, block->scratch, scalars, points, sc_g, 0, n_checks)) {
+        secp256k1_batch_bisect(ctx, block->scratch, scalars, points, sc_g, 0, n_checks, valid);
+    }
+    for (i = n_checks; i > 0; i--) {
+        unsigned char v = valid[i - 1];
+        valid[i - 1] = 0;
+        valid[check_item[i - 1]] = v;
+    }
+
+    for (i = 0; i < block->n; i++) {
+        block->complete(block->items[i].tag, valid[i], block->complete_data);
+    }
+    secp256k1_scratch_apply_checkpoint(&ctx->error_callback, block->scratch, 0);
+    secp256k1_scratch_destroy(&ctx->error_callback, block->scratch);
+    secp256k1_allocator_free(&block->allocator, block);
+}
+
+/* Hands the current block (if any) to the executor, or runs its job if there is no
+ * executor or the executor does not accept it. */
+static int secp256k1_batch_pipeline_dispatch(secp256k1_batch_pipeline *pipeline) {
+    secp256k1_batch_pipeline_block *block = pipeline->block;
+
+    if (block == NULL) {
+        return 0;
+    }
+    pipeline->block = NULL;
+    if (pipeline->executor == NULL || !pipeline->executor(secp256k1_batch_pipeline_job, block, pipeline->executor_data)) {
+        secp256k1_batch_pipeline_job(block);
+    }
+    return 1;
+}
+
+void secp256k1_batch_pipeline_destroy(const secp256k1_context* ctx, secp256k1_batch_pipeline* pipeline) {
+    VERIFY_CHECK(ctx != NULL);
+    if (pipeline != NULL) {
+        secp256k1_batch_pipeline_dispatch(pipeline);
+        secp256k1_allocator_free(&pipeline->allocator, pipeline);
+    }
+}
+
+int secp256k1_batch_pipeline_submit(const secp256k1_context* ctx, secp256k1_batch_pipeline *pipeline, const unsigned char *sig64, const unsigned char *msg32, const secp256k1_xonly_pubkey *pubkey, void *tag, size_t now) {
+    secp256k1_batch_pipeline_item *item;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(pipeline != NULL);
+    ARG_CHECK(sig64 != NULL);
+    ARG_CHECK(msg32 != NULL);
+    ARG_CHECK(pubkey != NULL);
+
+    if (pipeline->block == NULL) {
+        pipeline->block = secp256k1_batch_pipeline_block_create(pipeline);
+        if (pipeline->block == NULL) {
+            return 0;
+        }
+        pipeline->block_time = now;
+    }
+    item = &pipeline->block->items[pipeline->block->n++];
+    memcpy(item->sig, sig64, 64);
+    memcpy(item->msg, msg32, 32);
+    item->pk = *pubkey;
+    item->tag = tag;
+    if (pipeline->block->n == pipeline->max_sigs) {
+        secp256k1_batch_pipeline_dispatch(pipeline);
+    } else {
+        secp256k1_batch_pipeline_poll(ctx, pipeline, now);
+    }
+    return 1;
+}
+
+int secp256k1_batch_pipeline_poll(const secp256k1_context* ctx, secp256k1_batch_pipeline *pipeline, size_t now) {
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(pipeline != NULL);
+
+    /* Unsigned subtraction gives the elapsed time even if the clock wrapped around. */
+    if (pipeline->block == NULL || pipeline->max_delay == 0 || now - pipeline->block_time < pipeline->max_delay) {
+        return 0;
+    }
+    return secp256k1_batch_pipeline_dispatch(pipeline);
+}
+
+int secp256k1_batch_pipeline_flush(const secp256k1_context* ctx, secp256k1_batch_pipeline *pipeline) {
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(pipeline != NULL);
+
+    return secp256k1_batch_pipeline_dispatch(pipeline);
+}
+
+#endif /* SECP256K1_MODULE_BATCH_MAIN_H */
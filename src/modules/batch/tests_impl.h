@@ -0,0 +1,430 @@
+/**********************************************************************
+ * Distributed under the MIT software license, see the accompanying   *
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
+ **********************************************************************/
+
+#ifndef SECP256K1_MODULE_BATCH_TESTS_H
+#define SECP256K1_MODULE_BATCH_TESTS_H
+
+#include "include/secp256k1_batch.h"
+
+#define BATCH_TEST_N 24
+
+typedef struct {
+    secp256k1_xonly_pubkey pk[BATCH_TEST_N];
+    unsigned char msg[BATCH_TEST_N][32];
+    unsigned char sig[BATCH_TEST_N][64];
+    secp256k1_xonly_pubkey internal_pk[BATCH_TEST_N];
+    unsigned char tweak[BATCH_TEST_N][32];
+    unsigned char tweaked_pk32[BATCH_TEST_N][32];
+    int parity[BATCH_TEST_N];
+} batch_test_data;
+
+static void batch_test_data_create(batch_test_data *data) {
+    int i;
+    for (i = 0; i < BATCH_TEST_N; i++) {
+        unsigned char sk[32];
+        secp256k1_keypair keypair;
+        secp256k1_pubkey output_pk;
+        secp256k1_xonly_pubkey output_xonly_pk;
+
+        secp256k1_testrand256(sk);
+        secp256k1_testrand256(data->msg[i]);
+        CHECK(secp256k1_keypair_create(ctx, &keypair, sk));
+        CHECK(secp256k1_keypair_xonly_pub(ctx, &data->pk[i], NULL, &keypair));
+        CHECK(secp256k1_schnorrsig_sign(ctx, data->sig[i], data->msg[i], &keypair, NULL, NULL));
+
+        secp256k1_testrand256(data->tweak[i]);
+        CHECK(secp256k1_ec_pubkey_create(ctx, &output_pk, sk));
+        CHECK(secp256k1_xonly_pubkey_from_pubkey(ctx, &data->internal_pk[i], NULL, &output_pk));
+        CHECK(secp256k1_xonly_pubkey_tweak_add(ctx, &output_pk, &data->internal_pk[i], data->tweak[i]));
+        CHECK(secp256k1_xonly_pubkey_from_pubkey(ctx, &output_xonly_pk, &data->parity[i], &output_pk));
+        CHECK(secp256k1_xonly_pubkey_serialize(ctx, data->tweaked_pk32[i], &output_xonly_pk));
+    }
+}
+
+/* Adds all checks of data to a new batch of the given capacity, interleaving the two types,
+ * and returns the result of verifying it. */
+static int batch_test_run(const batch_test_data *data, size_t max_terms) {
+    secp256k1_batch *batch = secp256k1_batch_create(ctx, max_terms);
+    int i, ret, add_ret = 1;
+
+    CHECK(batch != NULL);
+    for (i = 0; i < BATCH_TEST_N; i++) {
+        add_ret &= secp256k1_batch_add_schnorrsig(ctx, batch, data->sig[i], data->msg[i], &data->pk[i]);
+        add_ret &= secp256k1_batch_add_xonly_tweak_check(ctx, batch, data->tweaked_pk32[i], data->parity[i], &data->internal_pk[i], data->tweak[i]);
+    }
+    ret = secp256k1_batch_verify(ctx, batch);
+    /* A failure found while adding is also reported by verify. */
+    CHECK(add_ret || !ret);
+    /* Verifying again gives the same result. */
+    CHECK(secp256k1_batch_verify(ctx, batch) == ret);
+    secp256k1_batch_destroy(ctx, batch);
+    return ret;
+}
+
+void test_batch_api(void) {
+    secp256k1_batch *batch;
+    batch_test_data data;
+    int ecount;
+    secp256k1_context *none = api_test_context(SECP256K1_CONTEXT_NONE, &ecount);
+    secp256k1_context *vrfy = api_test_context(SECP256K1_CONTEXT_VERIFY, &ecount);
+
+    batch_test_data_create(&data);
+    ecount = 0;
+    CHECK(secp256k1_batch_create(vrfy, 0) == NULL);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_batch_create(vrfy, 1) == NULL);
+    CHECK(ecount == 2);
+    CHECK(secp256k1_batch_create(vrfy, (size_t)1 << 31) == NULL);
+    CHECK(ecount == 3);
+    secp256k1_batch_destroy(vrfy, NULL);
+
+    batch = secp256k1_batch_create(none, 2);
+    CHECK(batch != NULL);
+    CHECK(secp256k1_batch_verify(none, batch) == 0);
+    CHECK(ecount == 4);
+    CHECK(secp256k1_batch_add_schnorrsig(none, batch, data.sig[0], data.msg[0], &data.pk[0]) == 0);
+    CHECK(ecount == 5);
+    CHECK(secp256k1_batch_add_xonly_tweak_check(none, batch, data.tweaked_pk32[0], data.parity[0], &data.internal_pk[0], data.tweak[0]) == 0);
+    CHECK(ecount == 6);
+    /* An empty batch verifies. */
+    CHECK(secp256k1_batch_verify(vrfy, batch) == 1);
+    CHECK(secp256k1_batch_verify(vrfy, NULL) == 0);
+    CHECK(ecount == 7);
+
+    CHECK(secp256k1_batch_add_schnorrsig(vrfy, NULL, data.sig[0], data.msg[0], &data.pk[0]) == 0);
+    CHECK(ecount == 8);
+    CHECK(secp256k1_batch_add_schnorrsig(vrfy, batch, NULL, data.msg[0], &data.pk[0]) == 0);
+    CHECK(ecount == 9);
+    CHECK(secp256k1_batch_add_schnorrsig(vrfy, batch, data.sig[0], NULL, &data.pk[0]) == 0);
+    CHECK(ecount == 10);
+    CHECK(secp256k1_batch_add_schnorrsig(vrfy, batch, data.sig[0], data.msg[0], NULL) == 0);
+    CHECK(ecount == 11);
+    CHECK(secp256k1_batch_add_xonly_tweak_check(vrfy, NULL, data.tweaked_pk32[0], data.parity[0], &data.internal_pk[0], data.tweak[0]) == 0);
+    CHECK(ecount == 12);
+    CHECK(secp256k1_batch_add_xonly_tweak_check(vrfy, batch, NULL, data.parity[0], &data.internal_pk[0], data.tweak[0]) == 0);
+    CHECK(ecount == 13);
+    CHECK(secp256k1_batch_add_xonly_tweak_check(vrfy, batch, data.tweaked_pk32[0], data.parity[0], NULL, data.tweak[0]) == 0);
+    CHECK(ecount == 14);
+    CHECK(secp256k1_batch_add_xonly_tweak_check(vrfy, batch, data.tweaked_pk32[0], data.parity[0], &data.internal_pk[0], NULL) == 0);
+    CHECK(ecount == 15);
+
+    /* Invalid arguments do not affect the batch. */
+    CHECK(secp256k1_batch_add_schnorrsig(vrfy, batch, data.sig[0], data.msg[0], &data.pk[0]) == 1);
+    CHECK(secp256k1_batch_add_xonly_tweak_check(vrfy, batch, data.tweaked_pk32[0], data.parity[0], &data.internal_pk[0], data.tweak[0]) == 1);
+    CHECK(secp256k1_batch_verify(vrfy, batch) == 1);
+    CHECK(ecount == 15);
+
+    secp256k1_batch_destroy(vrfy, batch);
+    secp256k1_context_destroy(none);
+    secp256k1_context_destroy(vrfy);
+}
+
+void test_batch_verify(void) {
+    /* Capacities that flush after every check, after some, and never before verify. */
+    static const size_t capacities[4] = {2, 3, 10, 4 * BATCH_TEST_N};
+    batch_test_data data;
+    int i;
+
+    batch_test_data_create(&data);
+    for (i = 0; i < 4; i++) {
+        size_t bad = secp256k1_testrand_int(BATCH_TEST_N);
+        unsigned char sig_bak[64];
+        CHECK(batch_test_run(&data, capacities[i]) == 1);
+
+        /* Wrong message */
+        data.msg[bad][0] ^= 1;
+        CHECK(batch_test_run(&data, capacities[i]) == 0);
+        data.msg[bad][0] ^= 1;
+
+        /* Wrong signature s, an s that overflows and an R that is not on the curve
+         * (the latter two are detected while adding) */
+        memcpy(sig_bak, data.sig[bad], 64);
+        data.sig[bad][63] ^= 1;
+        CHECK(batch_test_run(&data, capacities[i]) == 0);
+        memset(&data.sig[bad][32], 0xFF, 32);
+        CHECK(batch_test_run(&data, capacities[i]) == 0);
+        memcpy(data.sig[bad], sig_bak, 64);
+        memset(&data.sig[bad][0], 0xFF, 32);
+        CHECK(batch_test_run(&data, capacities[i]) == 0);
+        memcpy(data.sig[bad], sig_bak, 64);
+
+        /* Wrong tweak, and a wrong or invalid parity */
+        data.tweak[bad][0] ^= 1;
+        CHECK(batch_test_run(&data, capacities[i]) == 0);
+        data.tweak[bad][0] ^= 1;
+        data.parity[bad] ^= 1;
+        CHECK(batch_test_run(&data, capacities[i]) == 0);
+        data.parity[bad] ^= 3;
+        CHECK(batch_test_run(&data, capacities[i]) == 0);
+        data.parity[bad] ^= 2;
+
+        CHECK(batch_test_run(&data, capacities[i]) == 1);
+    }
+}
+
+/* Counts the reports of every check index in data. */
+static void batch_test_invalid(size_t idx, void *data) {
+    int *reported = (int *) data;
+    CHECK(idx < 2 * BATCH_TEST_N);
+    reported[idx]++;
+}
+
+void test_batch_bisection(void) {
+    static const size_t capacities[4] = {2, 3, 10, 4 * BATCH_TEST_N};
+    batch_test_data data;
+    int ecount, i, j, k;
+    int reported[2 * BATCH_TEST_N];
+    secp256k1_context *vrfy = api_test_context(SECP256K1_CONTEXT_VERIFY, &ecount);
+    secp256k1_batch *batch;
+
+    batch_test_data_create(&data);
+    ecount = 0;
+    batch = secp256k1_batch_create(vrfy, 2);
+    CHECK(secp256k1_batch_set_invalid_callback(vrfy, NULL, batch_test_invalid, reported) == 0);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_batch_set_invalid_callback(vrfy, batch, batch_test_invalid, reported) == 1);
+    CHECK(secp256k1_batch_set_invalid_callback(vrfy, batch, NULL, NULL) == 1);
+    CHECK(secp256k1_batch_add_schnorrsig(vrfy, batch, data.sig[0], data.msg[0], &data.pk[0]) == 1);
+    /* The mode cannot change once checks were added. */
+    CHECK(secp256k1_batch_set_invalid_callback(vrfy, batch, batch_test_invalid, reported) == 0);
+    CHECK(ecount == 2);
+    secp256k1_batch_destroy(vrfy, batch);
+    secp256k1_context_destroy(vrfy);
+
+    for (i = 0; i < 4; i++) {
+        for (j = 0; j < 4; j++) {
+            unsigned char msgs[BATCH_TEST_N][32], sigs[BATCH_TEST_N][64];
+            unsigned char tweaks[BATCH_TEST_N][32];
+            int parity[BATCH_TEST_N];
+            int expected[2 * BATCH_TEST_N];
+            int add_ret = 1, n_expected = 0;
+
+            /* Invalidate none, one, or random checks of both kinds, including checks
+             * that are rejected while adding. */
+            memcpy(msgs, data.msg, sizeof(msgs));
+            memcpy(sigs, data.sig, sizeof(sigs));
+            memcpy(tweaks, data.tweak, sizeof(tweaks));
+            memcpy(parity, data.parity, sizeof(parity));
+            memset(expected, 0, sizeof(expected));
+            memset(reported, 0, sizeof(reported));
+            if (j == 1) {
+                k = secp256k1_testrand_int(BATCH_TEST_N);
+                msgs[k][0] ^= 1;
+                expected[2 * k] = 1;
+            } else if (j >= 2) {
+                for (k = 0; k < BATCH_TEST_N; k++) {
+                    switch (secp256k1_testrand_int(j == 2 ? 8 : 3)) {
+                    case 0:
+                        sigs[k][63] ^= 1;
+                        expected[2 * k] = 1;
+                        break;
+                    case 1:
+                        memset(&sigs[k][32], 0xFF, 32);
+                        expected[2 * k] = 1;
+                        break;
+                    case 2:
+                        tweaks[k][0] ^= 1;
+                        expected[2 * k + 1] = 1;
+                        break;
+                    case 3:
+                        parity[k] ^= 1;
+                        expected[2 * k + 1] = 1;
+                        break;
+                    }
+                }
+            }
+            for (k = 0; k < 2 * BATCH_TEST_N; k++) {
+                n_expected += expected[k];
+            }
+
+            batch = secp256k1_batch_create(ctx, capacities[i]);
+            CHECK(batch != NULL);
+            CHECK(secp256k1_batch_set_invalid_callback(ctx, batch, batch_test_invalid, reported) == 1);
+            for (k = 0; k < BATCH_TEST_N; k++) {
+                add_ret &= secp256k1_batch_add_schnorrsig(ctx, batch, sigs[k], msgs[k], &data.pk[k]);
+                add_ret &= secp256k1_batch_add_xonly_tweak_check(ctx, batch, data.tweaked_pk32[k], parity[k], &data.internal_pk[k], tweaks[k]);
+            }
+            CHECK(secp256k1_batch_verify(ctx, batch) == (n_expected == 0));
+            CHECK(add_ret || n_expected > 0);
+            /* Every failing check is reported exactly once. */
+            for (k = 0; k < 2 * BATCH_TEST_N; k++) {
+                CHECK(reported[k] == expected[k]);
+            }
+            CHECK(secp256k1_batch_verify(ctx, batch) == (n_expected == 0));
+            secp256k1_batch_destroy(ctx, batch);
+        }
+    }
+}
+
+/* Records the results of a pipeline. The tag of signature i points to result[i], which
+ * counts completions as valid (+1) or invalid (+2). */
+static void batch_test_complete(void *tag, int valid, void *data) {
+    int *result = (int *) tag;
+    int *n_complete = (int *) data;
+    *result += valid ? 1 : 2;
+    (*n_complete)++;
+}
+
+/* An executor that queues the jobs, to run them later in reverse order. Once the queue is
+ * full, it refuses further jobs. */
+typedef struct {
+    void (*job[4])(void *job_data);
+    void *job_data[4];
+    size_t n;
+} batch_test_executor_data;
+
+static int batch_test_executor(void (*job)(void *job_data), void *job_data, void *data) {
+    batch_test_executor_data *exec = (batch_test_executor_data *) data;
+    if (exec->n == 4) {
+        return 0;
+    }
+    exec->job[exec->n] = job;
+    exec->job_data[exec->n] = job_data;
+    exec->n++;
+    return 1;
+}
+
+static void batch_test_executor_run(batch_test_executor_data *exec) {
+    while (exec->n > 0) {
+        exec->n--;
+        exec->job[exec->n](exec->job_data[exec->n]);
+    }
+}
+
+void test_batch_pipeline_api(void) {
+    secp256k1_batch_pipeline *pipeline;
+    batch_test_data data;
+    int ecount, n_complete = 0, result = 0;
+    secp256k1_context *none = api_test_context(SECP256K1_CONTEXT_NONE, &ecount);
+    secp256k1_context *vrfy = api_test_context(SECP256K1_CONTEXT_VERIFY, &ecount);
+
+    batch_test_data_create(&data);
+    ecount = 0;
+    CHECK(secp256k1_batch_pipeline_create(none, 1, 0, batch_test_complete, &n_complete, NULL, NULL) == NULL);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_batch_pipeline_create(vrfy, 0, 0, batch_test_complete, &n_complete, NULL, NULL) == NULL);
+    CHECK(ecount == 2);
+    CHECK(secp256k1_batch_pipeline_create(vrfy, (size_t)1 << 30, 0, batch_test_complete, &n_complete, NULL, NULL) == NULL);
+    CHECK(ecount == 3);
+    CHECK(secp256k1_batch_pipeline_create(vrfy, 1, 0, NULL, &n_complete, NULL, NULL) == NULL);
+    CHECK(ecount == 4);
+    secp256k1_batch_pipeline_destroy(vrfy, NULL);
+
+    pipeline = secp256k1_batch_pipeline_create(vrfy, 2, 0, batch_test_complete, &n_complete, NULL, NULL);
+    CHECK(pipeline != NULL);
+    CHECK(secp256k1_batch_pipeline_submit(vrfy, NULL, data.sig[0], data.msg[0], &data.pk[0], &result, 0) == 0);
+    CHECK(ecount == 5);
+    CHECK(secp256k1_batch_pipeline_submit(vrfy, pipeline, NULL, data.msg[0], &data.pk[0], &result, 0) == 0);
+    CHECK(ecount == 6);
+    CHECK(secp256k1_batch_pipeline_submit(vrfy, pipeline, data.sig[0], NULL, &data.pk[0], &result, 0) == 0);
+    CHECK(ecount == 7);
+    CHECK(secp256k1_batch_pipeline_submit(vrfy, pipeline, data.sig[0], data.msg[0], NULL, &result, 0) == 0);
+    CHECK(ecount == 8);
+    CHECK(secp256k1_batch_pipeline_poll(vrfy, NULL, 0) == 0);
+    CHECK(ecount == 9);
+    CHECK(secp256k1_batch_pipeline_flush(vrfy, NULL) == 0);
+    CHECK(ecount == 10);
+    CHECK(n_complete == 0);
+
+    /* Without a delay, polling never hands over a block, and flushing an empty
+     * pipeline does nothing. */
+    CHECK(secp256k1_batch_pipeline_submit(vrfy, pipeline, data.sig[0], data.msg[0], &data.pk[0], &result, 0) == 1);
+    CHECK(secp256k1_batch_pipeline_poll(vrfy, pipeline, (size_t)-1) == 0);
+    CHECK(n_complete == 0);
+    CHECK(secp256k1_batch_pipeline_flush(vrfy, pipeline) == 1);
+    CHECK(n_complete == 1 && result == 1);
+    CHECK(secp256k1_batch_pipeline_flush(vrfy, pipeline) == 0);
+
+    /* Destroying completes pending signatures. */
+    CHECK(secp256k1_batch_pipeline_submit(vrfy, pipeline, data.sig[0], data.msg[1], &data.pk[0], &result, 0) == 1);
+    secp256k1_batch_pipeline_destroy(vrfy, pipeline);
+    CHECK(n_complete == 2 && result == 3);
+    CHECK(ecount == 10);
+
+    secp256k1_context_destroy(none);
+    secp256k1_context_destroy(vrfy);
+}
+
+void test_batch_pipeline(void) {
+    /* Block sizes of a single signature, some, and all of them */
+    static const size_t max_sigs[3] = {1, 5, BATCH_TEST_N};
+    batch_test_data data;
+    int i, j;
+
+    batch_test_data_create(&data);
+    for (i = 0; i < 3; i++) {
+        for (j = 0; j < 4; j++) {
+            batch_test_executor_data exec;
+            secp256k1_batch_pipeline *pipeline;
+            int expected[BATCH_TEST_N], result[BATCH_TEST_N];
+            unsigned char msgs[BATCH_TEST_N][32], sigs[BATCH_TEST_N][64];
+            int k, n_complete = 0;
+            size_t now = (size_t)-3;
+
+            /* Invalidate none, one, two adjacent, or random signatures, including
+             * signatures that are rejected before evaluating the block. */
+            memcpy(msgs, data.msg, sizeof(msgs));
+            memcpy(sigs, data.sig, sizeof(sigs));
+            for (k = 0; k < BATCH_TEST_N; k++) {
+                expected[k] = 1;
+                result[k] = 0;
+            }
+            if (j == 1 || j == 2) {
+                k = secp256k1_testrand_int(BATCH_TEST_N - 1);
+                msgs[k][0] ^= 1;
+                expected[k] = 2;
+                if (j == 2) {
+                    sigs[k + 1][63] ^= 1;
+                    expected[k + 1] = 2;
+                }
+            } else if (j == 3) {
+                for (k = 0; k < BATCH_TEST_N; k++) {
+                    switch (secp256k1_testrand_int(4)) {
+                    case 0:
+                        sigs[k][63] ^= 1;
+                        expected[k] = 2;
+                        break;
+                    case 1:
+                        memset(&sigs[k][32], 0xFF, 32);
+                        expected[k] = 2;
+                        break;
+                    }
+                }
+            }
+
+            exec.n = 0;
+            pipeline = secp256k1_batch_pipeline_create(ctx, max_sigs[i], 3, batch_test_complete, &n_complete, batch_test_executor, &exec);
+            CHECK(pipeline != NULL);
+            for (k = 0; k < BATCH_TEST_N; k++) {
+                CHECK(secp256k1_batch_pipeline_submit(ctx, pipeline, sigs[k], msgs[k], &data.pk[k], &result[k], now++));
+                if (k % 4 == 3) {
+                    /* Blocks whose first signature waited for 3 time units are handed
+                     * over, also across a wrap-around of the clock. */
+                    secp256k1_batch_pipeline_poll(ctx, pipeline, now);
+                    batch_test_executor_run(&exec);
+                    CHECK(n_complete > 0);
+                }
+            }
+            secp256k1_batch_pipeline_destroy(ctx, pipeline);
+            batch_test_executor_run(&exec);
+            CHECK(n_complete == BATCH_TEST_N);
+            for (k = 0; k < BATCH_TEST_N; k++) {
+                CHECK(result[k] == expected[k]);
+            }
+        }
+    }
+}
+
+void run_batch_tests(void) {
+    test_batch_api();
+    test_batch_verify();
+    test_batch_bisection();
+    test_batch_pipeline_api();
+    test_batch_pipeline();
+}
+
+#undef BATCH_TEST_N
+
+#endif /* SECP256K1_MODULE_BATCH_TESTS_H */
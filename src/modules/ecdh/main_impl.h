@@ -26,12 +26,43 @@ static int ecdh_hash_function_sha256(unsigned char *output, const unsigned char
 const secp256k1_ecdh_hash_function secp256k1_ecdh_hash_function_sha256 = ecdh_hash_function_sha256;
 const secp256k1_ecdh_hash_function secp256k1_ecdh_hash_function_default = ecdh_hash_function_sha256;
 
+static int ecdh_xonly_hash_function_sha256(unsigned char *output, const unsigned char *x32, void *data) {
+    secp256k1_sha256 sha;
+    (void)data;
+
+    secp256k1_sha256_initialize(&sha);
+    secp256k1_sha256_write(&sha, x32, 32);
+    secp256k1_sha256_finalize(&sha, output);
+
+    return 1;
+}
+
+const secp256k1_ecdh_xonly_hash_function secp256k1_ecdh_xonly_hash_function_sha256 = ecdh_xonly_hash_function_sha256;
+
+/* Computes scalar*point for a public key and a secret key, in constant time. Returns
+ * whether the secret key was invalid, in which case 1 is used instead. */
+static int secp256k1_ecdh_mult(const secp256k1_context* ctx, secp256k1_gej *res, const secp256k1_pubkey *point, const unsigned char *scalar) {
+    int overflow = 0;
+    secp256k1_ge pt;
+    secp256k1_scalar s;
+
+    secp256k1_pubkey_load(ctx, &pt, point);
+    secp256k1_scalar_set_b32(&s, scalar, &overflow);
+
+    overflow |= secp256k1_scalar_is_zero(&s);
+    secp256k1_scalar_cmov(&s, &secp256k1_scalar_one, overflow);
+
+    secp256k1_ecmult_const(res, &pt, &s, 256);
+    secp256k1_scalar_clear(&s);
+
+    return overflow;
+}
+
 int secp256k1_ecdh(const secp256k1_context* ctx, unsigned char *output, const secp256k1_pubkey *point, const unsigned char *scalar, secp256k1_ecdh_hash_function hashfp, void *data) {
     int ret = 0;
-    int overflow = 0;
+    int overflow;
     secp256k1_gej res;
     secp256k1_ge pt;
-    secp256k1_scalar s;
     unsigned char x[32];
     unsigned char y[32];
 
@@ -44,13 +75,7 @@ int secp256k1_ecdh(const secp256k1_context* ctx, unsigned char *output, const se
         hashfp = secp256k1_ecdh_hash_function_default;
     }
 
-    secp256k1_pubkey_load(ctx, &pt, point);
-    secp256k1_scalar_set_b32(&s, scalar, &overflow);
-
-    overflow |= secp256k1_scalar_is_zero(&s);
-    secp256k1_scalar_cmov(&s, &secp256k1_scalar_one, overflow);
-
-    secp256k1_ecmult_const(&res, &pt, &s, 256);
+    overflow = secp256k1_ecdh_mult(ctx, &res, point, scalar);
     secp256k1_ge_set_gej(&pt, &res);
 
     /* Compute a hash of the point */
@@ -63,7 +88,140 @@ int secp256k1_ecdh(const secp256k1_context* ctx, unsigned char *output, const se
 
     memset(x, 0, 32);
     memset(y, 0, 32);
+
+    return !!ret & !overflow;
+}
+
+/* The number of shared points that are converted to affine coordinates together in
+ * secp256k1_ecdh_batch. */
+#define ECDH_BATCH_SIZE 32
+
+int secp256k1_ecdh_batch(const secp256k1_context* ctx, unsigned char * const *outputs, const secp256k1_pubkey * const *pubkeys, size_t n, const unsigned char *scalar, secp256k1_ecdh_hash_function hashfp, void *data) {
+    secp256k1_gej resj[ECDH_BATCH_SIZE];
+    secp256k1_ge res[ECDH_BATCH_SIZE];
+    secp256k1_ecmult_const_digits digits;
+    secp256k1_ge pt;
+    secp256k1_scalar s;
+    unsigned char x[32];
+    unsigned char y[32];
+    size_t i, j, batch;
+    int ret = 1;
+    int overflow = 0;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(outputs != NULL || n == 0);
+    ARG_CHECK(pubkeys != NULL || n == 0);
+    for (i = 0; i < n; i++) {
+        ARG_CHECK(outputs[i] != NULL);
+        ARG_CHECK(pubkeys[i] != NULL);
+    }
+    ARG_CHECK(scalar != NULL);
+
+    if (hashfp == NULL) {
+        hashfp = secp256k1_ecdh_hash_function_default;
+    }
+
+    secp256k1_scalar_set_b32(&s, scalar, &overflow);
+    overflow |= secp256k1_scalar_is_zero(&s);
+    secp256k1_scalar_cmov(&s, &secp256k1_scalar_one, overflow);
+    secp256k1_ecmult_const_digits_init(&digits, &s, 256);
+
+    for (i = 0; i < n; i += batch) {
+        batch = n - i < ECDH_BATCH_SIZE ? n - i : ECDH_BATCH_SIZE;
+        for (j = 0; j < batch; j++) {
+            secp256k1_pubkey_load(ctx, &pt, pubkeys[i + j]);
+            secp256k1_ecmult_const_with_digits(&resj[j], &pt, &digits);
+        }
+        secp256k1_ge_set_all_gej(res, resj, batch);
+        for (j = 0; j < batch; j++) {
+            /* Compute a hash of the point */
+            secp256k1_fe_normalize(&res[j].x);
+            secp256k1_fe_normalize(&res[j].y);
+            secp256k1_fe_get_b32(x, &res[j].x);
+            secp256k1_fe_get_b32(y, &res[j].y);
+            ret &= !!hashfp(outputs[i + j], x, y, data);
+        }
+    }
+
+    memset(x, 0, 32);
+    memset(y, 0, 32);
+    memset(resj, 0, sizeof(resj));
+    memset(res, 0, sizeof(res));
+    memset(&digits, 0, sizeof(digits));
+    secp256k1_scalar_clear(&s);
+
+    return ret & !overflow;
+}
+
+int secp256k1_ecdh_xonly(const secp256k1_context* ctx, unsigned char *output, const secp256k1_pubkey *point, const unsigned char *scalar, secp256k1_ecdh_xonly_hash_function hashfp, void *data) {
+    int ret = 0;
+    int overflow;
+    secp256k1_gej res;
+    secp256k1_fe zi2;
+    unsigned char x[32];
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(output != NULL);
+    ARG_CHECK(point != NULL);
+    ARG_CHECK(scalar != NULL);
+
+    if (hashfp == NULL) {
+        hashfp = secp256k1_ecdh_xonly_hash_function_sha256;
+    }
+
+    overflow = secp256k1_ecdh_mult(ctx, &res, point, scalar);
+
+    /* Only x = X/Z^2 is needed, so invert Z^2 directly instead of converting the
+     * whole point to affine coordinates. */
+    secp256k1_fe_sqr(&zi2, &res.z);
+    secp256k1_fe_inv(&zi2, &zi2);
+    secp256k1_fe_mul(&res.x, &res.x, &zi2);
+    secp256k1_fe_normalize(&res.x);
+    secp256k1_fe_get_b32(x, &res.x);
+
+    ret = hashfp(output, x, data);
+
+    memset(x, 0, 32);
+
+    return !!ret & !overflow;
+}
+
+int secp256k1_ecdh_xonly_x32(const secp256k1_context* ctx, unsigned char *output, const unsigned char *xpoint32, const unsigned char *scalar, secp256k1_ecdh_xonly_hash_function hashfp, void *data) {
+    int ret = 0;
+    int overflow = 0;
+    secp256k1_fe xp, xr;
+    secp256k1_scalar s;
+    unsigned char x[32];
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(output != NULL);
+    ARG_CHECK(xpoint32 != NULL);
+    ARG_CHECK(scalar != NULL);
+
+    if (hashfp == NULL) {
+        hashfp = secp256k1_ecdh_xonly_hash_function_sha256;
+    }
+
+    /* The input point is public, so rejecting an invalid x early is fine. */
+    if (!secp256k1_fe_set_b32(&xp, xpoint32)) {
+        return 0;
+    }
+
+    secp256k1_scalar_set_b32(&s, scalar, &overflow);
+    overflow |= secp256k1_scalar_is_zero(&s);
+    secp256k1_scalar_cmov(&s, &secp256k1_scalar_one, overflow);
+
+    if (!secp256k1_ecmult_const_xonly(&xr, &xp, &s, 256, 0)) {
+        secp256k1_scalar_clear(&s);
+        return 0;
+    }
     secp256k1_scalar_clear(&s);
+    secp256k1_fe_get_b32(x, &xr);
+
+    ret = hashfp(output, x, data);
+
+    memset(x, 0, 32);
+    secp256k1_fe_clear(&xr);
 
     return !!ret & !overflow;
 }
@@ -24,6 +24,19 @@ int ecdh_hash_function_custom(unsigned char *output, const unsigned char *x, con
     return 1;
 }
 
+int ecdh_xonly_hash_function_test_fail(unsigned char *output, const unsigned char *x, void *data) {
+    (void)output;
+    (void)x;
+    (void)data;
+    return 0;
+}
+
+int ecdh_xonly_hash_function_custom(unsigned char *output, const unsigned char *x, void *data) {
+    (void)data;
+    memcpy(output, x, 32);
+    return 1;
+}
+
 void test_ecdh_api(void) {
     /* Setup context that just counts errors */
     secp256k1_context *tctx = secp256k1_context_create(SECP256K1_CONTEXT_SIGN);
@@ -48,6 +61,20 @@ void test_ecdh_api(void) {
     CHECK(ecount == 3);
     CHECK(secp256k1_ecdh(tctx, res, &point, s_one, NULL, NULL) == 1);
     CHECK(ecount == 3);
+    CHECK(secp256k1_ecdh_xonly(tctx, NULL, &point, s_one, NULL, NULL) == 0);
+    CHECK(ecount == 4);
+    CHECK(secp256k1_ecdh_xonly(tctx, res, NULL, s_one, NULL, NULL) == 0);
+    CHECK(ecount == 5);
+    CHECK(secp256k1_ecdh_xonly(tctx, res, &point, NULL, NULL, NULL) == 0);
+    CHECK(ecount == 6);
+    CHECK(secp256k1_ecdh_xonly(tctx, res, &point, s_one, NULL, NULL) == 1);
+    CHECK(ecount == 6);
+    CHECK(secp256k1_ecdh_xonly_x32(tctx, NULL, res, s_one, NULL, NULL) == 0);
+    CHECK(ecount == 7);
+    CHECK(secp256k1_ecdh_xonly_x32(tctx, res, NULL, s_one, NULL, NULL) == 0);
+    CHECK(ecount == 8);
+    CHECK(secp256k1_ecdh_xonly_x32(tctx, res, res, NULL, NULL, NULL) == 0);
+    CHECK(ecount == 9);
 
     /* Cleanup */
     secp256k1_context_destroy(tctx);
@@ -91,6 +118,15 @@ void test_ecdh_generator_basepoint(void) {
         secp256k1_sha256_finalize(&sha, output_ser);
         /* compare */
         CHECK(secp256k1_memcmp_var(output_ecdh, output_ser, 32) == 0);
+
+        /* x-only ECDH, with a custom and with the default hash function */
+        CHECK(secp256k1_ecdh_xonly(ctx, output_ecdh, &point[0], s_b32, ecdh_xonly_hash_function_custom, NULL) == 1);
+        CHECK(secp256k1_memcmp_var(output_ecdh, point_ser + 1, 32) == 0);
+        CHECK(secp256k1_ecdh_xonly(ctx, output_ecdh, &point[0], s_b32, NULL, NULL) == 1);
+        secp256k1_sha256_initialize(&sha);
+        secp256k1_sha256_write(&sha, point_ser + 1, 32);
+        secp256k1_sha256_finalize(&sha, output_ser);
+        CHECK(secp256k1_memcmp_var(output_ecdh, output_ser, 32) == 0);
     }
 }
 
@@ -121,12 +157,126 @@ void test_bad_scalar(void) {
 
     /* Hash function failure results in ecdh failure */
     CHECK(secp256k1_ecdh(ctx, output, &point, s_overflow, ecdh_hash_function_test_fail, NULL) == 0);
+
+    /* Same for x-only ECDH */
+    s_overflow[31] += 1;
+    CHECK(secp256k1_ecdh_xonly(ctx, output, &point, s_zero, NULL, NULL) == 0);
+    CHECK(secp256k1_ecdh_xonly(ctx, output, &point, s_overflow, NULL, NULL) == 0);
+    s_overflow[31] -= 1;
+    CHECK(secp256k1_ecdh_xonly(ctx, output, &point, s_overflow, NULL, NULL) == 1);
+    CHECK(secp256k1_ecdh_xonly(ctx, output, &point, s_overflow, ecdh_xonly_hash_function_test_fail, NULL) == 0);
+}
+
+void test_ecdh_batch(void) {
+    unsigned char s_zero[32] = { 0 };
+    unsigned char s_b32[32];
+    unsigned char outputs[70][65];
+    unsigned char *output_ptrs[70];
+    unsigned char output[65];
+    secp256k1_pubkey points[70];
+    const secp256k1_pubkey *point_ptrs[70];
+    secp256k1_scalar s;
+    int32_t ecount = 0;
+    size_t i, n;
+
+    for (i = 0; i < 70; i++) {
+        random_scalar_order(&s);
+        secp256k1_scalar_get_b32(s_b32, &s);
+        CHECK(secp256k1_ec_pubkey_create(ctx, &points[i], s_b32) == 1);
+        point_ptrs[i] = &points[i];
+        output_ptrs[i] = outputs[i];
+    }
+    random_scalar_order(&s);
+    secp256k1_scalar_get_b32(s_b32, &s);
+
+    secp256k1_context_set_illegal_callback(ctx, counting_illegal_callback_fn, &ecount);
+    CHECK(secp256k1_ecdh_batch(ctx, NULL, NULL, 0, s_b32, NULL, NULL) == 1);
+    CHECK(ecount == 0);
+    CHECK(secp256k1_ecdh_batch(ctx, NULL, point_ptrs, 1, s_b32, NULL, NULL) == 0);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_ecdh_batch(ctx, output_ptrs, NULL, 1, s_b32, NULL, NULL) == 0);
+    CHECK(ecount == 2);
+    CHECK(secp256k1_ecdh_batch(ctx, output_ptrs, point_ptrs, 1, NULL, NULL, NULL) == 0);
+    CHECK(ecount == 3);
+    point_ptrs[0] = NULL;
+    CHECK(secp256k1_ecdh_batch(ctx, output_ptrs, point_ptrs, 1, s_b32, NULL, NULL) == 0);
+    CHECK(ecount == 4);
+    point_ptrs[0] = &points[0];
+    secp256k1_context_set_illegal_callback(ctx, NULL, NULL);
+
+    /* Compare with secp256k1_ecdh, for sizes around the internal batch size. */
+    for (n = 1; n <= 70; n += 1 + secp256k1_testrand_int(16)) {
+        CHECK(secp256k1_ecdh_batch(ctx, output_ptrs, point_ptrs, n, s_b32, ecdh_hash_function_custom, NULL) == 1);
+        for (i = 0; i < n; i++) {
+            CHECK(secp256k1_ecdh(ctx, output, &points[i], s_b32, ecdh_hash_function_custom, NULL) == 1);
+            CHECK(secp256k1_memcmp_var(output, outputs[i], 65) == 0);
+        }
+        CHECK(secp256k1_ecdh_batch(ctx, output_ptrs, point_ptrs, n, s_b32, NULL, NULL) == 1);
+        CHECK(secp256k1_ecdh(ctx, output, &points[n - 1], s_b32, NULL, NULL) == 1);
+        CHECK(secp256k1_memcmp_var(output, outputs[n - 1], 32) == 0);
+    }
+
+    /* Invalid scalars and hash function failures */
+    CHECK(secp256k1_ecdh_batch(ctx, output_ptrs, point_ptrs, 3, s_zero, NULL, NULL) == 0);
+    CHECK(secp256k1_ecdh_batch(ctx, output_ptrs, point_ptrs, 3, s_b32, ecdh_hash_function_test_fail, NULL) == 0);
+}
+
+void test_ecdh_xonly_x32(void) {
+    unsigned char s_zero[32] = { 0 };
+    unsigned char s_b32[32];
+    unsigned char x32[32];
+    unsigned char point_ser[33];
+    unsigned char output[32];
+    unsigned char output_ref[32];
+    size_t point_ser_len;
+    secp256k1_pubkey point;
+    secp256k1_scalar s;
+    secp256k1_fe x;
+    int i;
+
+    for (i = 0; i < 64; i++) {
+        random_scalar_order(&s);
+        secp256k1_scalar_get_b32(s_b32, &s);
+        CHECK(secp256k1_ec_pubkey_create(ctx, &point, s_b32) == 1);
+        point_ser_len = sizeof(point_ser);
+        CHECK(secp256k1_ec_pubkey_serialize(ctx, point_ser, &point_ser_len, &point, SECP256K1_EC_COMPRESSED) == 1);
+        memcpy(x32, point_ser + 1, 32);
+
+        random_scalar_order(&s);
+        secp256k1_scalar_get_b32(s_b32, &s);
+        CHECK(secp256k1_ecdh_xonly(ctx, output_ref, &point, s_b32, NULL, NULL) == 1);
+        CHECK(secp256k1_ecdh_xonly_x32(ctx, output, x32, s_b32, NULL, NULL) == 1);
+        CHECK(secp256k1_memcmp_var(output, output_ref, 32) == 0);
+
+        /* The parity of the input point does not matter. */
+        CHECK(secp256k1_ec_pubkey_negate(ctx, &point) == 1);
+        CHECK(secp256k1_ecdh_xonly(ctx, output_ref, &point, s_b32, ecdh_xonly_hash_function_custom, NULL) == 1);
+        CHECK(secp256k1_ecdh_xonly_x32(ctx, output, x32, s_b32, ecdh_xonly_hash_function_custom, NULL) == 1);
+        CHECK(secp256k1_memcmp_var(output, output_ref, 32) == 0);
+
+        /* Bad scalars and hash function failures */
+        CHECK(secp256k1_ecdh_xonly_x32(ctx, output, x32, s_zero, NULL, NULL) == 0);
+        CHECK(secp256k1_ecdh_xonly_x32(ctx, output, x32, s_b32, ecdh_xonly_hash_function_test_fail, NULL) == 0);
+    }
+
+    /* x coordinates not on the curve are rejected, as are ones that overflow. */
+    for (i = 0; i < 64; i++) {
+        random_field_element_test(&x);
+        secp256k1_fe_get_b32(x32, &x);
+        point_ser[0] = SECP256K1_TAG_PUBKEY_EVEN;
+        memcpy(point_ser + 1, x32, 32);
+        CHECK(secp256k1_ecdh_xonly_x32(ctx, output, x32, s_b32, NULL, NULL) == secp256k1_ec_pubkey_parse(ctx, &point, point_ser, 33));
+    }
+    memset(x32, 0xff, 32);
+    CHECK(secp256k1_ecdh_xonly_x32(ctx, output, x32, s_b32, NULL, NULL) == 0);
 }
 
 void run_ecdh_tests(void) {
     test_ecdh_api();
     test_ecdh_generator_basepoint();
     test_bad_scalar();
+    test_ecdh_batch();
+    test_ecdh_xonly_x32();
 }
 
 #endif /* SECP256K1_MODULE_ECDH_TESTS_H */
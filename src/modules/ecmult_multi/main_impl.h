@@ -0,0 +1,371 @@
+/**********************************************************************
+ * Distributed under the MIT software license, see the accompanying   *
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
+ **********************************************************************/
+
+#ifndef SECP256K1_MODULE_ECMULT_MULTI_MAIN_H
+#define SECP256K1_MODULE_ECMULT_MULTI_MAIN_H
+
+#include "include/secp256k1_ecmult_multi.h"
+
+typedef struct {
+    const secp256k1_context *ctx;
+    secp256k1_ecmult_multi_input_function cb;
+    void *cbdata;
+} secp256k1_ecmult_multi_input_context;
+
+/* Adapts the public (serialized scalar, pubkey) callback to the internal one */
+static int secp256k1_ecmult_multi_input_callback(secp256k1_scalar *sc, secp256k1_ge *pt, size_t idx, void *data) {
+    secp256k1_ecmult_multi_input_context *ecmult_context = (secp256k1_ecmult_multi_input_context *) data;
+    unsigned char buf[32];
+    secp256k1_pubkey pubkey;
+    int overflow;
+
+    if (!ecmult_context->cb(buf, &pubkey, idx, ecmult_context->cbdata)) {
+        return 0;
+    }
+    secp256k1_scalar_set_b32(sc, buf, &overflow);
+    if (overflow) {
+        return 0;
+    }
+    return secp256k1_pubkey_load(ecmult_context->ctx, pt, &pubkey);
+}
+
+int secp256k1_ecmult_multi(const secp256k1_context* ctx, secp256k1_scratch_space *scratch, secp256k1_pubkey *result, const unsigned char *g_scalar32, secp256k1_ecmult_multi_input_function cb, void *cbdata, size_t n) {
+    secp256k1_ecmult_multi_input_context ecmult_context;
+    secp256k1_scalar g_sc;
+    secp256k1_gej rj;
+    secp256k1_ge r;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(result != NULL);
+    memset(result, 0, sizeof(*result));
+    ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(cb != NULL || n == 0);
+
+    if (g_scalar32 != NULL) {
+        int overflow;
+        secp256k1_scalar_set_b32(&g_sc, g_scalar32, &overflow);
+        if (overflow) {
+            return 0;
+        }
+    }
+
+    ecmult_context.ctx = ctx;
+    ecmult_context.cb = cb;
+    ecmult_context.cbdata = cbdata;
+    if (!secp256k1_ecmult_multi_var(&ctx->error_callback, &ctx->ecmult_ctx, scratch, &rj, g_scalar32 != NULL ? &g_sc : NULL, secp256k1_ecmult_multi_input_callback, (void *) &ecmult_context, n)) {
+        return 0;
+    }
+    if (secp256k1_gej_is_infinity(&rj)) {
+        return 0;
+    }
+    secp256k1_ge_set_gej_var(&r, &rj);
+    secp256k1_pubkey_save(result, &r);
+    return 1;
+}
+
+size_t secp256k1_ecmult_multi_scratch_size(const secp256k1_context* ctx, size_t n_points) {
+    VERIFY_CHECK(ctx != NULL);
+    (void)ctx;
+
+    return secp256k1_ecmult_multi_scratch_size_helper(n_points);
+}
+
+int secp256k1_ecmult_multi_algorithm(const secp256k1_context* ctx, size_t n_points) {
+    VERIFY_CHECK(ctx != NULL);
+    (void)ctx;
+
+    return secp256k1_ecmult_multi_use_pippenger(n_points) ? SECP256K1_ECMULT_MULTI_PIPPENGER : SECP256K1_ECMULT_MULTI_STRAUSS;
+}
+
+size_t secp256k1_ecmult_multi_scratch_size_for(const secp256k1_context* ctx, size_t n_points, int algorithm) {
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(algorithm == SECP256K1_ECMULT_MULTI_STRAUSS || algorithm == SECP256K1_ECMULT_MULTI_PIPPENGER);
+
+    return secp256k1_ecmult_multi_algorithm_scratch_size(n_points, algorithm == SECP256K1_ECMULT_MULTI_PIPPENGER);
+}
+
+size_t secp256k1_ecmult_multi_max_points(const secp256k1_context* ctx, secp256k1_scratch_space *scratch) {
+    size_t max_points;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(scratch != NULL);
+
+    /* Mirrors the algorithm selection in secp256k1_ecmult_multi_var */
+    max_points = secp256k1_pippenger_max_points(&ctx->error_callback, scratch);
+    if (max_points < ECMULT_PIPPENGER_THRESHOLD) {
+        size_t strauss_max_points = secp256k1_strauss_max_points(&ctx->error_callback, scratch);
+        if (strauss_max_points != 0) {
+            max_points = strauss_max_points;
+        }
+    }
+    if (max_points > ECMULT_MAX_POINTS_PER_BATCH) {
+        max_points = ECMULT_MAX_POINTS_PER_BATCH;
+    }
+    return max_points;
+}
+
+int secp256k1_ecmult_multi_parallel(const secp256k1_context* ctx, secp256k1_scratch_space *scratch, secp256k1_pubkey *result, const unsigned char *g_scalar32, secp256k1_ecmult_multi_input_function cb, void *cbdata, size_t n, size_t n_tasks, secp256k1_ecmult_multi_runner_function runner, void *runner_data) {
+    secp256k1_ecmult_multi_input_context ecmult_context;
+    secp256k1_scalar g_sc;
+    secp256k1_gej rj;
+    secp256k1_ge r;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(result != NULL);
+    memset(result, 0, sizeof(*result));
+    ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(scratch != NULL);
+    ARG_CHECK(cb != NULL || n == 0);
+    ARG_CHECK(n_tasks > 0);
+    ARG_CHECK(runner != NULL);
+
+    if (g_scalar32 != NULL) {
+        int overflow;
+        secp256k1_scalar_set_b32(&g_sc, g_scalar32, &overflow);
+        if (overflow) {
+            return 0;
+        }
+    }
+
+    ecmult_context.ctx = ctx;
+    ecmult_context.cb = cb;
+    ecmult_context.cbdata = cbdata;
+    if (!secp256k1_ecmult_multi_parallel_var(&ctx->error_callback, &ctx->ecmult_ctx, scratch, &rj, g_scalar32 != NULL ? &g_sc : NULL, secp256k1_ecmult_multi_input_callback, (void *) &ecmult_context, n, n_tasks, runner, runner_data)) {
+        return 0;
+    }
+    if (secp256k1_gej_is_infinity(&rj)) {
+        return 0;
+    }
+    secp256k1_ge_set_gej_var(&r, &rj);
+    secp256k1_pubkey_save(result, &r);
+    return 1;
+}
+
+size_t secp256k1_ecmult_multi_parallel_scratch_size(const secp256k1_context* ctx, size_t n_points, size_t n_tasks) {
+    VERIFY_CHECK(ctx != NULL);
+    (void)ctx;
+
+    return secp256k1_ecmult_multi_parallel_scratch_size_helper(n_points, n_tasks);
+}
+
+struct secp256k1_point_precomp_struct {
+    secp256k1_ecmult_point_table table;
+    /* The allocator of the context the object was created with */
+    secp256k1_allocator allocator;
+};
+
+secp256k1_point_precomp* secp256k1_point_precomp_create(const secp256k1_context* ctx, const secp256k1_pubkey *point) {
+    secp256k1_point_precomp *precomp;
+    secp256k1_ge p;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(point != NULL);
+    if (!secp256k1_pubkey_load(ctx, &p, point)) {
+        return NULL;
+    }
+
+    precomp = (secp256k1_point_precomp *) secp256k1_allocator_alloc(&ctx->allocator, &ctx->error_callback, sizeof(*precomp));
+    if (precomp != NULL) {
+        secp256k1_ecmult_point_table_build(&precomp->table, &p);
+        precomp->allocator = ctx->allocator;
+    }
+    return precomp;
+}
+
+void secp256k1_point_precomp_destroy(const secp256k1_context* ctx, secp256k1_point_precomp *precomp) {
+    VERIFY_CHECK(ctx != NULL);
+    (void)ctx;
+    if (precomp != NULL) {
+        secp256k1_allocator_free(&precomp->allocator, precomp);
+    }
+}
+
+int secp256k1_ecmult_multi_precomp(const secp256k1_context* ctx, secp256k1_pubkey *result, const unsigned char *g_scalar32, const secp256k1_point_precomp * const *precomps, const unsigned char * const *scalars32, size_t n) {
+    const secp256k1_ecmult_point_table *tables[ECMULT_POINT_TABLES_BATCH];
+    secp256k1_scalar sc[ECMULT_POINT_TABLES_BATCH];
+    secp256k1_scalar g_sc;
+    secp256k1_gej rj, tmpj;
+    secp256k1_ge r;
+    size_t i, j, batch;
+    int overflow;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(result != NULL);
+    memset(result, 0, sizeof(*result));
+    ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(precomps != NULL || n == 0);
+    ARG_CHECK(scalars32 != NULL || n == 0);
+    for (i = 0; i < n; i++) {
+        ARG_CHECK(precomps[i] != NULL);
+        ARG_CHECK(scalars32[i] != NULL);
+    }
+
+    if (g_scalar32 != NULL) {
+        secp256k1_scalar_set_b32(&g_sc, g_scalar32, &overflow);
+        if (overflow) {
+            return 0;
+        }
+    }
+
+    /* Convert the scalars in batches of the size secp256k1_ecmult_point_tables uses. */
+    secp256k1_gej_set_infinity(&rj);
+    i = 0;
+    do {
+        batch = n - i < ECMULT_POINT_TABLES_BATCH ? n - i : ECMULT_POINT_TABLES_BATCH;
+        for (j = 0; j < batch; j++) {
+            tables[j] = &precomps[i + j]->table;
+            secp256k1_scalar_set_b32(&sc[j], scalars32[i + j], &overflow);
+            if (overflow) {
+                return 0;
+            }
+        }
+        secp256k1_ecmult_point_tables(&ctx->ecmult_ctx, &tmpj, tables, sc, batch, i == 0 && g_scalar32 != NULL ? &g_sc : NULL);
+        secp256k1_gej_add_var(&rj, &rj, &tmpj, NULL);
+        i += batch;
+    } while (i < n);
+
+    if (secp256k1_gej_is_infinity(&rj)) {
+        return 0;
+    }
+    secp256k1_ge_set_gej_var(&r, &rj);
+    secp256k1_pubkey_save(result, &r);
+    return 1;
+}
+
+struct secp256k1_ecmult_multi_acc_struct {
+    /* Holds the buffered pairs, followed by the working space of ecmult_multi */
+    secp256k1_scratch *scratch;
+    secp256k1_scalar *scalars;
+    secp256k1_ge *points;
+    size_t len;
+    size_t capacity;
+    /* Sum of the chunks multiplied so far */
+    secp256k1_gej sum;
+    int valid;
+    /* The allocator of the context the accumulator was created with */
+    secp256k1_allocator allocator;
+};
+
+secp256k1_ecmult_multi_acc* secp256k1_ecmult_multi_acc_create(const secp256k1_context* ctx, size_t chunk_points) {
+    secp256k1_ecmult_multi_acc *acc;
+    size_t pairs_size;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(chunk_points >= 1);
+    ARG_CHECK(chunk_points <= ECMULT_MAX_POINTS_PER_BATCH);
+
+    acc = (secp256k1_ecmult_multi_acc *)secp256k1_allocator_alloc(&ctx->allocator, &ctx->error_callback, sizeof(*acc));
+    if (acc == NULL) {
+        return NULL;
+    }
+    acc->allocator = ctx->allocator;
+    pairs_size = ROUND_TO_ALIGN(chunk_points * sizeof(secp256k1_scalar)) + ROUND_TO_ALIGN(chunk_points * sizeof(secp256k1_ge));
+    acc->scratch = secp256k1_scratch_create_with_allocator(&ctx->error_callback, &ctx->allocator, pairs_size + secp256k1_ecmult_multi_scratch_size_helper(chunk_points));
+    if (acc->scratch == NULL) {
+        secp256k1_allocator_free(&ctx->allocator, acc);
+        return NULL;
+    }
+    acc->scalars = (secp256k1_scalar *)secp256k1_scratch_alloc(&ctx->error_callback, acc->scratch, chunk_points * sizeof(secp256k1_scalar));
+    acc->points = (secp256k1_ge *)secp256k1_scratch_alloc(&ctx->error_callback, acc->scratch, chunk_points * sizeof(secp256k1_ge));
+    VERIFY_CHECK(acc->scalars != NULL && acc->points != NULL);
+
+    acc->len = 0;
+    acc->capacity = chunk_points;
+    secp256k1_gej_set_infinity(&acc->sum);
+    acc->valid = 1;
+    return acc;
+}
+
+void secp256k1_ecmult_multi_acc_destroy(const secp256k1_context* ctx, secp256k1_ecmult_multi_acc *acc) {
+    VERIFY_CHECK(ctx != NULL);
+    if (acc != NULL) {
+        /* Release the pair buffers, which are the only allocations held between calls. */
+        secp256k1_scratch_apply_checkpoint(&ctx->error_callback, acc->scratch, 0);
+        secp256k1_scratch_destroy(&ctx->error_callback, acc->scratch);
+        secp256k1_allocator_free(&acc->allocator, acc);
+    }
+}
+
+static int secp256k1_ecmult_multi_acc_callback(secp256k1_scalar *sc, secp256k1_ge *pt, size_t idx, void *data) {
+    const secp256k1_ecmult_multi_acc *acc = (const secp256k1_ecmult_multi_acc *) data;
+    *sc = acc->scalars[idx];
+    *pt = acc->points[idx];
+    return 1;
+}
+
+/* Multiply the buffered pairs (and the generator by g_sc, unless it is NULL) and add
+ * the result to the running sum. */
+static void secp256k1_ecmult_multi_acc_flush(const secp256k1_context* ctx, secp256k1_ecmult_multi_acc *acc, const secp256k1_scalar *g_sc) {
+    secp256k1_gej tmpj;
+
+    if (acc->len == 0 && g_sc == NULL) {
+        return;
+    }
+    /* The scratch space is sized for a chunk, so this is a single multiplication. */
+    if (secp256k1_ecmult_multi_var(&ctx->error_callback, &ctx->ecmult_ctx, acc->scratch, &tmpj, g_sc, secp256k1_ecmult_multi_acc_callback, (void *) acc, acc->len)) {
+        secp256k1_gej_add_var(&acc->sum, &acc->sum, &tmpj, NULL);
+    } else {
+        acc->valid = 0;
+    }
+    acc->len = 0;
+}
+
+int secp256k1_ecmult_multi_acc_add(const secp256k1_context* ctx, secp256k1_ecmult_multi_acc *acc, secp256k1_ecmult_multi_input_function cb, void *cbdata, size_t n) {
+    secp256k1_ecmult_multi_input_context ecmult_context;
+    size_t i;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(acc != NULL);
+    ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(cb != NULL || n == 0);
+
+    ecmult_context.ctx = ctx;
+    ecmult_context.cb = cb;
+    ecmult_context.cbdata = cbdata;
+    for (i = 0; i < n; i++) {
+        if (!secp256k1_ecmult_multi_input_callback(&acc->scalars[acc->len], &acc->points[acc->len], i, (void *) &ecmult_context)) {
+            acc->valid = 0;
+            return 0;
+        }
+        if (++acc->len == acc->capacity) {
+            secp256k1_ecmult_multi_acc_flush(ctx, acc, NULL);
+        }
+    }
+    return acc->valid;
+}
+
+int secp256k1_ecmult_multi_acc_finalize(const secp256k1_context* ctx, secp256k1_ecmult_multi_acc *acc, secp256k1_pubkey *result, const unsigned char *g_scalar32) {
+    secp256k1_scalar g_sc;
+    secp256k1_ge r;
+    int ret;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(result != NULL);
+    memset(result, 0, sizeof(*result));
+    ARG_CHECK(acc != NULL);
+    ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+
+    ret = acc->valid;
+    if (g_scalar32 != NULL) {
+        int overflow;
+        secp256k1_scalar_set_b32(&g_sc, g_scalar32, &overflow);
+        ret &= !overflow;
+    }
+    if (ret) {
+        secp256k1_ecmult_multi_acc_flush(ctx, acc, g_scalar32 != NULL ? &g_sc : NULL);
+        ret = acc->valid && !secp256k1_gej_is_infinity(&acc->sum);
+    }
+    if (ret) {
+        secp256k1_ge_set_gej_var(&r, &acc->sum);
+        secp256k1_pubkey_save(result, &r);
+    }
+
+    acc->len = 0;
+    secp256k1_gej_set_infinity(&acc->sum);
+    acc->valid = 1;
+    return ret;
+}
+
+#endif /* SECP256K1_MODULE_ECMULT_MULTI_MAIN_H */
@@ -0,0 +1,591 @@
+/**********************************************************************
+ * Distributed under the MIT software license, see the accompanying   *
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
+ **********************************************************************/
+
+#ifndef SECP256K1_MODULE_ECMULT_MULTI_TESTS_H
+#define SECP256K1_MODULE_ECMULT_MULTI_TESTS_H
+
+#include "secp256k1_ecmult_multi.h"
+
+#define ECMULT_MULTI_TEST_MAX_POINTS 200
+
+typedef struct {
+    const unsigned char (*scalar)[32];
+    const secp256k1_pubkey *point;
+    size_t fail_idx;
+} ecmult_multi_test_data;
+
+static int ecmult_multi_test_input(unsigned char *scalar32, secp256k1_pubkey *point, size_t idx, void *data) {
+    ecmult_multi_test_data *d = (ecmult_multi_test_data *) data;
+    if (idx == d->fail_idx) {
+        return 0;
+    }
+    memcpy(scalar32, d->scalar[idx], 32);
+    *point = d->point[idx];
+    return 1;
+}
+
+void test_ecmult_multi_api(void) {
+    secp256k1_context *none = secp256k1_context_create(SECP256K1_CONTEXT_NONE);
+    secp256k1_context *vrfy = secp256k1_context_create(SECP256K1_CONTEXT_VERIFY);
+    secp256k1_scratch_space *scratch_space = secp256k1_scratch_space_create(ctx, secp256k1_ecmult_multi_scratch_size(ctx, 1));
+    unsigned char scalar[1][32];
+    unsigned char g_scalar[32] = { 0 };
+    secp256k1_pubkey point[1];
+    secp256k1_pubkey result;
+    secp256k1_pubkey zero_pk;
+    ecmult_multi_test_data data;
+    int ecount = 0;
+
+    secp256k1_context_set_error_callback(none, counting_illegal_callback_fn, &ecount);
+    secp256k1_context_set_illegal_callback(none, counting_illegal_callback_fn, &ecount);
+    secp256k1_context_set_error_callback(vrfy, counting_illegal_callback_fn, &ecount);
+    secp256k1_context_set_illegal_callback(vrfy, counting_illegal_callback_fn, &ecount);
+
+    g_scalar[31] = 1;
+    memset(scalar[0], 0, 32);
+    scalar[0][31] = 2;
+    CHECK(secp256k1_ec_pubkey_create(ctx, &point[0], g_scalar) == 1);
+    memset(&zero_pk, 0, sizeof(zero_pk));
+    data.scalar = (const unsigned char (*)[32]) scalar;
+    data.point = point;
+    data.fail_idx = 1;
+
+    CHECK(secp256k1_ecmult_multi(vrfy, scratch_space, &result, g_scalar, ecmult_multi_test_input, &data, 1) == 1);
+    CHECK(secp256k1_ecmult_multi(vrfy, NULL, &result, g_scalar, ecmult_multi_test_input, &data, 1) == 1);
+    CHECK(secp256k1_ecmult_multi(vrfy, scratch_space, &result, NULL, ecmult_multi_test_input, &data, 1) == 1);
+    CHECK(secp256k1_ecmult_multi(vrfy, scratch_space, &result, g_scalar, NULL, NULL, 0) == 1);
+    CHECK(ecount == 0);
+    CHECK(secp256k1_ecmult_multi(none, scratch_space, &result, g_scalar, ecmult_multi_test_input, &data, 1) == 0);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_ecmult_multi(vrfy, scratch_space, NULL, g_scalar, ecmult_multi_test_input, &data, 1) == 0);
+    CHECK(ecount == 2);
+    CHECK(secp256k1_ecmult_multi(vrfy, scratch_space, &result, g_scalar, NULL, &data, 1) == 0);
+    CHECK(ecount == 3);
+    /* Nothing to compute results in infinity */
+    CHECK(secp256k1_ecmult_multi(vrfy, scratch_space, &result, NULL, NULL, NULL, 0) == 0);
+    CHECK(ecount == 3);
+    point[0] = zero_pk;
+    CHECK(secp256k1_ecmult_multi(vrfy, scratch_space, &result, g_scalar, ecmult_multi_test_input, &data, 1) == 0);
+    CHECK(ecount == 4);
+
+    CHECK(secp256k1_ecmult_multi_scratch_size(none, 0) == 0);
+    CHECK(secp256k1_ecmult_multi_scratch_size(none, 1) > 0);
+    CHECK(secp256k1_ecmult_multi_max_points(none, scratch_space) > 0);
+    CHECK(secp256k1_ecmult_multi_max_points(none, NULL) == 0);
+    CHECK(ecount == 5);
+    CHECK(secp256k1_ecmult_multi_scratch_size_for(none, 1, SECP256K1_ECMULT_MULTI_STRAUSS) > 0);
+    CHECK(secp256k1_ecmult_multi_scratch_size_for(none, 1, 0) == 0);
+    CHECK(ecount == 6);
+    CHECK(secp256k1_ecmult_multi_scratch_size_for(none, 1, 3) == 0);
+    CHECK(ecount == 7);
+
+    secp256k1_scratch_space_destroy(ctx, scratch_space);
+    secp256k1_context_destroy(none);
+    secp256k1_context_destroy(vrfy);
+}
+
+void test_ecmult_multi_scratch_size(void) {
+    static const size_t n_points[] = { 1, 2, 10, ECMULT_PIPPENGER_THRESHOLD - 1, ECMULT_PIPPENGER_THRESHOLD, 136, 137, 1260, 1261, 5000 };
+    size_t i;
+
+    for (i = 0; i < sizeof(n_points) / sizeof(n_points[0]); i++) {
+        size_t size = secp256k1_ecmult_multi_scratch_size(ctx, n_points[i]);
+        int algorithm = secp256k1_ecmult_multi_algorithm(ctx, n_points[i]);
+        secp256k1_scratch_space *scratch_space = secp256k1_scratch_space_create(ctx, size);
+        CHECK(algorithm == (n_points[i] < ECMULT_PIPPENGER_THRESHOLD ? SECP256K1_ECMULT_MULTI_STRAUSS : SECP256K1_ECMULT_MULTI_PIPPENGER));
+        CHECK(secp256k1_ecmult_multi_scratch_size_for(ctx, n_points[i], algorithm) == size);
+        CHECK(secp256k1_ecmult_multi_max_points(ctx, scratch_space) >= n_points[i]);
+        if (n_points[i] >= ECMULT_PIPPENGER_THRESHOLD) {
+            CHECK(secp256k1_ecmult_multi_scratch_size_for(ctx, n_points[i], SECP256K1_ECMULT_MULTI_PIPPENGER) <= secp256k1_ecmult_multi_scratch_size_for(ctx, n_points[i], SECP256K1_ECMULT_MULTI_STRAUSS));
+        } else {
+            /* Strauss' algorithm is selected for few points, so the scratch
+             * space must be large enough for it. */
+            CHECK(secp256k1_strauss_max_points(&ctx->error_callback, scratch_space) >= n_points[i]);
+        }
+        secp256k1_scratch_space_destroy(ctx, scratch_space);
+    }
+    CHECK(secp256k1_ecmult_multi_scratch_size(ctx, SIZE_MAX) == secp256k1_ecmult_multi_scratch_size(ctx, ECMULT_MAX_POINTS_PER_BATCH));
+}
+
+void test_ecmult_multi_random(size_t n, secp256k1_scratch_space *scratch_space) {
+    unsigned char scalar[ECMULT_MULTI_TEST_MAX_POINTS][32];
+    secp256k1_pubkey point[ECMULT_MULTI_TEST_MAX_POINTS];
+    unsigned char g_scalar[32];
+    ecmult_multi_test_data data;
+    secp256k1_scalar sc, g_sc;
+    secp256k1_gej expected, tmpj;
+    secp256k1_ge ge;
+    secp256k1_pubkey result;
+    size_t i;
+
+    VERIFY_CHECK(n <= ECMULT_MULTI_TEST_MAX_POINTS);
+    random_scalar_order_test(&g_sc);
+    secp256k1_scalar_get_b32(g_scalar, &g_sc);
+    secp256k1_gej_set_infinity(&tmpj);
+    secp256k1_ecmult(&ctx->ecmult_ctx, &expected, &tmpj, &secp256k1_scalar_zero, &g_sc);
+    for (i = 0; i < n; i++) {
+        random_scalar_order_test(&sc);
+        random_group_element_test(&ge);
+        secp256k1_scalar_get_b32(scalar[i], &sc);
+        secp256k1_pubkey_save(&point[i], &ge);
+        secp256k1_gej_set_ge(&tmpj, &ge);
+        secp256k1_ecmult(&ctx->ecmult_ctx, &tmpj, &tmpj, &sc, NULL);
+        secp256k1_gej_add_var(&expected, &expected, &tmpj, NULL);
+    }
+    data.scalar = (const unsigned char (*)[32]) scalar;
+    data.point = point;
+    data.fail_idx = n;
+
+    CHECK(secp256k1_ecmult_multi(ctx, scratch_space, &result, g_scalar, ecmult_multi_test_input, &data, n) == 1);
+    CHECK(secp256k1_pubkey_load(ctx, &ge, &result));
+    ge_equals_gej(&ge, &expected);
+
+    /* A failing callback makes the whole computation fail */
+    if (n > 0) {
+        data.fail_idx = secp256k1_testrand_int(n);
+        CHECK(secp256k1_ecmult_multi(ctx, scratch_space, &result, g_scalar, ecmult_multi_test_input, &data, n) == 0);
+        data.fail_idx = n;
+    }
+
+    /* Overflowing scalars are rejected */
+    memset(g_scalar, 0xFF, 32);
+    CHECK(secp256k1_ecmult_multi(ctx, scratch_space, &result, g_scalar, ecmult_multi_test_input, &data, n) == 0);
+    if (n > 0) {
+        memset(scalar[n - 1], 0xFF, 32);
+        CHECK(secp256k1_ecmult_multi(ctx, scratch_space, &result, NULL, ecmult_multi_test_input, &data, n) == 0);
+    }
+}
+
+void test_ecmult_multi_infinity(void) {
+    unsigned char scalar[2][32];
+    secp256k1_pubkey point[2];
+    ecmult_multi_test_data data;
+    secp256k1_scalar sc;
+    secp256k1_ge ge;
+    secp256k1_pubkey result;
+
+    /* s*P + s*(-P) is the point at infinity */
+    random_scalar_order_test(&sc);
+    random_group_element_test(&ge);
+    secp256k1_scalar_get_b32(scalar[0], &sc);
+    secp256k1_scalar_get_b32(scalar[1], &sc);
+    secp256k1_pubkey_save(&point[0], &ge);
+    secp256k1_ge_neg(&ge, &ge);
+    secp256k1_pubkey_save(&point[1], &ge);
+    data.scalar = (const unsigned char (*)[32]) scalar;
+    data.point = point;
+    data.fail_idx = 2;
+    CHECK(secp256k1_ecmult_multi(ctx, NULL, &result, NULL, ecmult_multi_test_input, &data, 2) == 0);
+}
+
+typedef struct {
+    int fail;
+    size_t skip_idx;
+    size_t n_calls;
+} ecmult_multi_test_runner_data;
+
+/* Runs the tasks serially in reverse order, optionally failing or skipping a task */
+static int ecmult_multi_test_runner(void (*task)(size_t idx, void *task_data), void *task_data, size_t n_tasks, void *data) {
+    ecmult_multi_test_runner_data *d = (ecmult_multi_test_runner_data *) data;
+    size_t i;
+    d->n_calls++;
+    if (d->fail) {
+        return 0;
+    }
+    for (i = n_tasks; i > 0; i--) {
+        if (i - 1 != d->skip_idx) {
+            task(i - 1, task_data);
+        }
+    }
+    return 1;
+}
+
+void test_ecmult_multi_parallel_api(void) {
+    secp256k1_context *none = secp256k1_context_create(SECP256K1_CONTEXT_NONE);
+    secp256k1_scratch_space *scratch_space = secp256k1_scratch_space_create(ctx, secp256k1_ecmult_multi_parallel_scratch_size(ctx, 2, 2));
+    unsigned char scalar[2][32];
+    unsigned char g_scalar[32] = { 0 };
+    secp256k1_pubkey point[2];
+    secp256k1_pubkey result;
+    ecmult_multi_test_data data;
+    ecmult_multi_test_runner_data runner_data;
+    int ecount = 0;
+
+    secp256k1_context_set_illegal_callback(none, counting_illegal_callback_fn, &ecount);
+    secp256k1_context_set_illegal_callback(ctx, counting_illegal_callback_fn, &ecount);
+
+    g_scalar[31] = 1;
+    memset(scalar, 0, sizeof(scalar));
+    scalar[0][31] = 2;
+    scalar[1][31] = 3;
+    CHECK(secp256k1_ec_pubkey_create(ctx, &point[0], g_scalar) == 1);
+    point[1] = point[0];
+    data.scalar = (const unsigned char (*)[32]) scalar;
+    data.point = point;
+    data.fail_idx = 2;
+    runner_data.fail = 0;
+    runner_data.skip_idx = 2;
+    runner_data.n_calls = 0;
+
+    CHECK(secp256k1_ecmult_multi_parallel(ctx, scratch_space, &result, g_scalar, ecmult_multi_test_input, &data, 2, 2, ecmult_multi_test_runner, &runner_data) == 1);
+    CHECK(runner_data.n_calls == 1);
+    /* A single task does not use the runner */
+    CHECK(secp256k1_ecmult_multi_parallel(ctx, scratch_space, &result, g_scalar, ecmult_multi_test_input, &data, 2, 1, ecmult_multi_test_runner, &runner_data) == 1);
+    CHECK(secp256k1_ecmult_multi_parallel(ctx, scratch_space, &result, g_scalar, NULL, NULL, 0, 4, ecmult_multi_test_runner, &runner_data) == 1);
+    CHECK(runner_data.n_calls == 1);
+    CHECK(ecount == 0);
+    CHECK(secp256k1_ecmult_multi_parallel(none, scratch_space, &result, g_scalar, ecmult_multi_test_input, &data, 2, 2, ecmult_multi_test_runner, &runner_data) == 0);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_ecmult_multi_parallel(ctx, NULL, &result, g_scalar, ecmult_multi_test_input, &data, 2, 2, ecmult_multi_test_runner, &runner_data) == 0);
+    CHECK(ecount == 2);
+    CHECK(secp256k1_ecmult_multi_parallel(ctx, scratch_space, NULL, g_scalar, ecmult_multi_test_input, &data, 2, 2, ecmult_multi_test_runner, &runner_data) == 0);
+    CHECK(ecount == 3);
+    CHECK(secp256k1_ecmult_multi_parallel(ctx, scratch_space, &result, g_scalar, NULL, &data, 2, 2, ecmult_multi_test_runner, &runner_data) == 0);
+    CHECK(ecount == 4);
+    CHECK(secp256k1_ecmult_multi_parallel(ctx, scratch_space, &result, g_scalar, ecmult_multi_test_input, &data, 2, 0, ecmult_multi_test_runner, &runner_data) == 0);
+    CHECK(ecount == 5);
+    CHECK(secp256k1_ecmult_multi_parallel(ctx, scratch_space, &result, g_scalar, ecmult_multi_test_input, &data, 2, 2, NULL, &runner_data) == 0);
+    CHECK(ecount == 6);
+    CHECK(runner_data.n_calls == 1);
+
+    /* Failing or incomplete runners make the computation fail */
+    runner_data.fail = 1;
+    CHECK(secp256k1_ecmult_multi_parallel(ctx, scratch_space, &result, g_scalar, ecmult_multi_test_input, &data, 2, 2, ecmult_multi_test_runner, &runner_data) == 0);
+    runner_data.fail = 0;
+    runner_data.skip_idx = 1;
+    CHECK(secp256k1_ecmult_multi_parallel(ctx, scratch_space, &result, g_scalar, ecmult_multi_test_input, &data, 2, 2, ecmult_multi_test_runner, &runner_data) == 0);
+    CHECK(runner_data.n_calls == 3);
+
+    CHECK(secp256k1_ecmult_multi_parallel_scratch_size(ctx, 0, 2) == 0);
+    CHECK(secp256k1_ecmult_multi_parallel_scratch_size(ctx, 2, 0) == 0);
+    CHECK(secp256k1_ecmult_multi_parallel_scratch_size(ctx, 2, 1) == secp256k1_ecmult_multi_scratch_size(ctx, 2));
+    CHECK(ecount == 6);
+
+    secp256k1_context_set_illegal_callback(ctx, NULL, NULL);
+    secp256k1_scratch_space_destroy(ctx, scratch_space);
+    secp256k1_context_destroy(none);
+}
+
+/* Compares secp256k1_ecmult_multi_parallel_var with secp256k1_ecmult_multi_var
+ * for every number of tasks up to max_tasks */
+void test_ecmult_multi_parallel_random(size_t n, size_t max_tasks) {
+    secp256k1_scalar scalars[ECMULT_MULTI_TEST_MAX_POINTS];
+    secp256k1_ge points[ECMULT_MULTI_TEST_MAX_POINTS];
+    secp256k1_scalar g_sc;
+    ecmult_multi_data data;
+    ecmult_multi_test_runner_data runner_data;
+    secp256k1_gej expected, r;
+    size_t i, n_tasks;
+
+    VERIFY_CHECK(n <= ECMULT_MULTI_TEST_MAX_POINTS);
+    random_scalar_order_test(&g_sc);
+    for (i = 0; i < n; i++) {
+        random_scalar_order_test(&scalars[i]);
+        random_group_element_test(&points[i]);
+    }
+    data.sc = scalars;
+    data.pt = points;
+    runner_data.fail = 0;
+    runner_data.skip_idx = max_tasks;
+    CHECK(secp256k1_ecmult_multi_var(&ctx->error_callback, &ctx->ecmult_ctx, NULL, &expected, &g_sc, ecmult_multi_callback, &data, n));
+    secp256k1_gej_neg(&expected, &expected);
+
+    for (n_tasks = 1; n_tasks <= max_tasks; n_tasks++) {
+        /* Enough scratch space for a single batch per task, and for one point */
+        secp256k1_scratch *scratch_large = secp256k1_scratch_create(&ctx->error_callback, secp256k1_ecmult_multi_parallel_scratch_size(ctx, n, n_tasks));
+        secp256k1_scratch *scratch_small = secp256k1_scratch_create(&ctx->error_callback, secp256k1_ecmult_multi_parallel_scratch_size(ctx, n_tasks, n_tasks));
+        /* A growable one, which grows to the size of scratch_large */
+        secp256k1_scratch *scratch_growable = secp256k1_scratch_create_growable(&ctx->error_callback, &default_allocator, SIZE_MAX);
+        secp256k1_scratch *scratch_list[4];
+        int k;
+        scratch_list[0] = scratch_large;
+        scratch_list[1] = scratch_small;
+        scratch_list[2] = scratch_growable;
+        scratch_list[3] = NULL;
+        for (k = 0; k < 4; k++) {
+            secp256k1_scratch *scratch_k = scratch_list[k];
+            CHECK(secp256k1_ecmult_multi_parallel_var(&ctx->error_callback, &ctx->ecmult_ctx, scratch_k, &r, &g_sc, ecmult_multi_callback, &data, n, n_tasks, ecmult_multi_test_runner, &runner_data));
+            secp256k1_gej_add_var(&r, &r, &expected, NULL);
+            CHECK(secp256k1_gej_is_infinity(&r));
+            if (scratch_k != NULL) {
+                CHECK(scratch_k->alloc_size == 0);
+            }
+        }
+        CHECK(scratch_growable->max_size >= scratch_large->max_size);
+        CHECK(scratch_growable->high_water >= scratch_large->max_size);
+        CHECK(scratch_small->high_water >= scratch_large->max_size);
+        secp256k1_scratch_destroy(&ctx->error_callback, scratch_large);
+        secp256k1_scratch_destroy(&ctx->error_callback, scratch_small);
+        secp256k1_scratch_destroy(&ctx->error_callback, scratch_growable);
+    }
+}
+
+#define POINT_PRECOMP_TEST_MAX_POINTS 20
+
+void test_point_precomp_api(void) {
+    secp256k1_context *none = secp256k1_context_create(SECP256K1_CONTEXT_NONE);
+    secp256k1_point_precomp *precomp;
+    const secp256k1_point_precomp *precomps[1];
+    const unsigned char *scalars[1];
+    unsigned char scalar[32] = { 0 };
+    unsigned char overflow[32];
+    secp256k1_pubkey point, zero_pk, result;
+    int ecount = 0;
+
+    secp256k1_context_set_illegal_callback(none, counting_illegal_callback_fn, &ecount);
+    secp256k1_context_set_illegal_callback(ctx, counting_illegal_callback_fn, &ecount);
+    scalar[31] = 1;
+    memset(overflow, 0xFF, 32);
+    memset(&zero_pk, 0, sizeof(zero_pk));
+    CHECK(secp256k1_ec_pubkey_create(ctx, &point, scalar) == 1);
+
+    CHECK(secp256k1_point_precomp_create(none, NULL) == NULL);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_point_precomp_create(none, &zero_pk) == NULL);
+    CHECK(ecount == 2);
+    precomp = secp256k1_point_precomp_create(none, &point);
+    CHECK(precomp != NULL);
+    precomps[0] = precomp;
+    scalars[0] = scalar;
+
+    CHECK(secp256k1_ecmult_multi_precomp(ctx, &result, scalar, precomps, scalars, 1) == 1);
+    CHECK(secp256k1_ecmult_multi_precomp(ctx, &result, NULL, precomps, scalars, 1) == 1);
+    CHECK(secp256k1_memcmp_var(&result, &point, sizeof(point)) == 0);
+    CHECK(secp256k1_ecmult_multi_precomp(ctx, &result, scalar, NULL, NULL, 0) == 1);
+    CHECK(secp256k1_memcmp_var(&result, &point, sizeof(point)) == 0);
+    CHECK(ecount == 2);
+    CHECK(secp256k1_ecmult_multi_precomp(none, &result, scalar, precomps, scalars, 1) == 0);
+    CHECK(ecount == 3);
+    CHECK(secp256k1_ecmult_multi_precomp(ctx, NULL, scalar, precomps, scalars, 1) == 0);
+    CHECK(ecount == 4);
+    CHECK(secp256k1_ecmult_multi_precomp(ctx, &result, scalar, NULL, scalars, 1) == 0);
+    CHECK(ecount == 5);
+    CHECK(secp256k1_ecmult_multi_precomp(ctx, &result, scalar, precomps, NULL, 1) == 0);
+    CHECK(ecount == 6);
+    scalars[0] = NULL;
+    CHECK(secp256k1_ecmult_multi_precomp(ctx, &result, scalar, precomps, scalars, 1) == 0);
+    CHECK(ecount == 7);
+    /* Overflowing scalars, and results at infinity */
+    scalars[0] = overflow;
+    CHECK(secp256k1_ecmult_multi_precomp(ctx, &result, scalar, precomps, scalars, 1) == 0);
+    scalars[0] = scalar;
+    CHECK(secp256k1_ecmult_multi_precomp(ctx, &result, overflow, precomps, scalars, 1) == 0);
+    CHECK(secp256k1_ecmult_multi_precomp(ctx, &result, NULL, NULL, NULL, 0) == 0);
+    CHECK(secp256k1_memcmp_var(&result, &zero_pk, sizeof(zero_pk)) == 0);
+    memcpy(overflow, scalar, 32);
+    CHECK(secp256k1_ec_seckey_negate(ctx, overflow) == 1);
+    CHECK(secp256k1_ecmult_multi_precomp(ctx, &result, overflow, precomps, scalars, 1) == 0);
+    CHECK(ecount == 7);
+
+    secp256k1_point_precomp_destroy(none, precomp);
+    secp256k1_point_precomp_destroy(none, NULL);
+    secp256k1_context_set_illegal_callback(ctx, NULL, NULL);
+    secp256k1_context_destroy(none);
+}
+
+void test_point_precomp_random(size_t n) {
+    unsigned char scalar[POINT_PRECOMP_TEST_MAX_POINTS][32];
+    const unsigned char *scalars[POINT_PRECOMP_TEST_MAX_POINTS];
+    secp256k1_point_precomp *precomp[POINT_PRECOMP_TEST_MAX_POINTS];
+    const secp256k1_point_precomp *precomps[POINT_PRECOMP_TEST_MAX_POINTS];
+    unsigned char g_scalar[32];
+    secp256k1_scalar sc, g_sc;
+    secp256k1_gej expected, tmpj;
+    secp256k1_ge ge;
+    secp256k1_pubkey point, result;
+    size_t i;
+
+    VERIFY_CHECK(n <= POINT_PRECOMP_TEST_MAX_POINTS);
+    random_scalar_order_test(&g_sc);
+    secp256k1_scalar_get_b32(g_scalar, &g_sc);
+    secp256k1_gej_set_infinity(&tmpj);
+    secp256k1_ecmult(&ctx->ecmult_ctx, &expected, &tmpj, &secp256k1_scalar_zero, &g_sc);
+    for (i = 0; i < n; i++) {
+        random_scalar_order_test(&sc);
+        if (i > 0 && secp256k1_testrand_bits(2) == 0) {
+            secp256k1_scalar_set_int(&sc, 0);
+        }
+        random_group_element_test(&ge);
+        secp256k1_scalar_get_b32(scalar[i], &sc);
+        scalars[i] = scalar[i];
+        secp256k1_pubkey_save(&point, &ge);
+        precomp[i] = secp256k1_point_precomp_create(ctx, &point);
+        CHECK(precomp[i] != NULL);
+        precomps[i] = precomp[i];
+        secp256k1_gej_set_ge(&tmpj, &ge);
+        secp256k1_ecmult(&ctx->ecmult_ctx, &tmpj, &tmpj, &sc, NULL);
+        secp256k1_gej_add_var(&expected, &expected, &tmpj, NULL);
+    }
+
+    CHECK(secp256k1_ecmult_multi_precomp(ctx, &result, g_scalar, precomps, scalars, n) == 1);
+    CHECK(secp256k1_pubkey_load(ctx, &ge, &result));
+    ge_equals_gej(&ge, &expected);
+
+    for (i = 0; i < n; i++) {
+        secp256k1_point_precomp_destroy(ctx, precomp[i]);
+    }
+}
+
+void test_ecmult_multi_acc_api(void) {
+    secp256k1_context *none = secp256k1_context_create(SECP256K1_CONTEXT_NONE);
+    secp256k1_ecmult_multi_acc *acc;
+    unsigned char scalar[1][32];
+    unsigned char g_scalar[32] = { 0 };
+    secp256k1_pubkey point[1];
+    secp256k1_pubkey result;
+    secp256k1_pubkey zero_pk;
+    ecmult_multi_test_data data;
+    int ecount = 0;
+
+    secp256k1_context_set_error_callback(none, counting_illegal_callback_fn, &ecount);
+    secp256k1_context_set_illegal_callback(none, counting_illegal_callback_fn, &ecount);
+    secp256k1_context_set_illegal_callback(ctx, counting_illegal_callback_fn, &ecount);
+
+    g_scalar[31] = 1;
+    memset(scalar[0], 0, 32);
+    scalar[0][31] = 2;
+    CHECK(secp256k1_ec_pubkey_create(ctx, &point[0], g_scalar) == 1);
+    memset(&zero_pk, 0, sizeof(zero_pk));
+    data.scalar = (const unsigned char (*)[32]) scalar;
+    data.point = point;
+    data.fail_idx = 1;
+
+    CHECK(secp256k1_ecmult_multi_acc_create(none, 0) == NULL);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_ecmult_multi_acc_create(none, ECMULT_MAX_POINTS_PER_BATCH + 1) == NULL);
+    CHECK(ecount == 2);
+    acc = secp256k1_ecmult_multi_acc_create(none, 1);
+    CHECK(acc != NULL);
+
+    CHECK(secp256k1_ecmult_multi_acc_add(none, acc, ecmult_multi_test_input, &data, 1) == 0);
+    CHECK(ecount == 3);
+    CHECK(secp256k1_ecmult_multi_acc_add(ctx, NULL, ecmult_multi_test_input, &data, 1) == 0);
+    CHECK(ecount == 4);
+    CHECK(secp256k1_ecmult_multi_acc_add(ctx, acc, NULL, &data, 1) == 0);
+    CHECK(ecount == 5);
+    CHECK(secp256k1_ecmult_multi_acc_add(ctx, acc, NULL, NULL, 0) == 1);
+    CHECK(secp256k1_ecmult_multi_acc_finalize(none, acc, &result, g_scalar) == 0);
+    CHECK(ecount == 6);
+    CHECK(secp256k1_ecmult_multi_acc_finalize(ctx, NULL, &result, g_scalar) == 0);
+    CHECK(ecount == 7);
+    CHECK(secp256k1_ecmult_multi_acc_finalize(ctx, acc, NULL, g_scalar) == 0);
+    CHECK(ecount == 8);
+
+    /* 2*G + G = 3*G, and finalizing resets the accumulator */
+    CHECK(secp256k1_ecmult_multi_acc_add(ctx, acc, ecmult_multi_test_input, &data, 1) == 1);
+    CHECK(secp256k1_ecmult_multi_acc_finalize(ctx, acc, &result, g_scalar) == 1);
+    CHECK(secp256k1_ecmult_multi_acc_finalize(ctx, acc, &result, g_scalar) == 1);
+    CHECK(secp256k1_ecmult_multi_acc_finalize(ctx, acc, &result, NULL) == 0);
+    CHECK(memcmp(&result, &zero_pk, sizeof(result)) == 0);
+    CHECK(ecount == 8);
+
+    /* A failing callback or invalid point makes the next finalize fail */
+    CHECK(secp256k1_ecmult_multi_acc_add(ctx, acc, ecmult_multi_test_input, &data, 2) == 0);
+    CHECK(secp256k1_ecmult_multi_acc_add(ctx, acc, ecmult_multi_test_input, &data, 1) == 0);
+    CHECK(secp256k1_ecmult_multi_acc_finalize(ctx, acc, &result, g_scalar) == 0);
+    CHECK(memcmp(&result, &zero_pk, sizeof(result)) == 0);
+    point[0] = zero_pk;
+    CHECK(secp256k1_ecmult_multi_acc_add(ctx, acc, ecmult_multi_test_input, &data, 1) == 0);
+    CHECK(ecount == 9);
+    CHECK(secp256k1_ecmult_multi_acc_finalize(ctx, acc, &result, g_scalar) == 0);
+    CHECK(secp256k1_ecmult_multi_acc_finalize(ctx, acc, &result, g_scalar) == 1);
+    CHECK(ecount == 9);
+
+    secp256k1_ecmult_multi_acc_destroy(none, acc);
+    secp256k1_ecmult_multi_acc_destroy(none, NULL);
+    secp256k1_context_set_illegal_callback(ctx, NULL, NULL);
+    secp256k1_context_destroy(none);
+}
+
+/* Adds n random pairs to an accumulator with room for chunk_points pairs, in calls
+ * of random sizes, and compares the result to a single multiplication over all of
+ * them. */
+void test_ecmult_multi_acc_random(size_t n, size_t chunk_points) {
+    unsigned char scalar[ECMULT_MULTI_TEST_MAX_POINTS][32];
+    secp256k1_pubkey point[ECMULT_MULTI_TEST_MAX_POINTS];
+    unsigned char g_scalar[32];
+    ecmult_multi_test_data data;
+    secp256k1_ecmult_multi_acc *acc;
+    secp256k1_scalar sc;
+    secp256k1_ge ge;
+    secp256k1_pubkey result, expected;
+    size_t i, len;
+    int use_g = secp256k1_testrand_bits(1);
+    int round;
+
+    VERIFY_CHECK(n <= ECMULT_MULTI_TEST_MAX_POINTS);
+    acc = secp256k1_ecmult_multi_acc_create(ctx, chunk_points);
+    CHECK(acc != NULL);
+    random_scalar_order_test(&sc);
+    secp256k1_scalar_get_b32(g_scalar, &sc);
+    for (i = 0; i < n; i++) {
+        random_scalar_order_test(&sc);
+        random_group_element_test(&ge);
+        secp256k1_scalar_get_b32(scalar[i], &sc);
+        secp256k1_pubkey_save(&point[i], &ge);
+    }
+    data.scalar = (const unsigned char (*)[32]) scalar;
+    data.point = point;
+    data.fail_idx = n;
+    if (!secp256k1_ecmult_multi(ctx, NULL, &expected, use_g ? g_scalar : NULL, ecmult_multi_test_input, &data, n)) {
+        /* Only happens for n == 0 without a generator term */
+        CHECK(n == 0 && !use_g);
+    }
+
+    /* The accumulator is reused for all rounds. In the second one a callback fails,
+     * which must only affect the pairs up to the next finalize. */
+    for (round = 0; round < 3; round++) {
+        size_t fail = round == 1 && n > 0 ? secp256k1_testrand_int(n) : n;
+        int ret = 1;
+        for (i = 0; i < n; i += len) {
+            len = secp256k1_testrand_int(n - i) + 1;
+            data.scalar = (const unsigned char (*)[32]) &scalar[i];
+            data.point = &point[i];
+            data.fail_idx = fail >= i && fail < i + len ? fail - i : len;
+            ret &= secp256k1_ecmult_multi_acc_add(ctx, acc, ecmult_multi_test_input, &data, len);
+        }
+        CHECK(ret == (fail == n));
+        if (secp256k1_ecmult_multi_acc_finalize(ctx, acc, &result, use_g ? g_scalar : NULL)) {
+            CHECK(fail == n);
+            CHECK(memcmp(&result, &expected, sizeof(result)) == 0);
+        } else {
+            CHECK(fail < n || (n == 0 && !use_g));
+        }
+    }
+    secp256k1_ecmult_multi_acc_destroy(ctx, acc);
+}
+
+void run_ecmult_multi_module_tests(void) {
+    static const size_t n_points[] = { 0, 1, 2, 5, ECMULT_PIPPENGER_THRESHOLD, ECMULT_MULTI_TEST_MAX_POINTS };
+    secp256k1_scratch_space *small_scratch = secp256k1_scratch_space_create(ctx, secp256k1_ecmult_multi_scratch_size(ctx, 3));
+    secp256k1_scratch_space *large_scratch = secp256k1_scratch_space_create(ctx, secp256k1_ecmult_multi_scratch_size(ctx, ECMULT_MULTI_TEST_MAX_POINTS));
+    size_t i;
+    int j;
+
+    test_ecmult_multi_api();
+    test_ecmult_multi_scratch_size();
+    test_ecmult_multi_parallel_api();
+    test_point_precomp_api();
+    test_ecmult_multi_acc_api();
+    for (j = 0; j < count; j++) {
+        test_point_precomp_random(secp256k1_testrand_int(POINT_PRECOMP_TEST_MAX_POINTS + 1));
+        for (i = 0; i < sizeof(n_points) / sizeof(n_points[0]); i++) {
+            test_ecmult_multi_random(n_points[i], NULL);
+            test_ecmult_multi_random(n_points[i], small_scratch);
+            test_ecmult_multi_random(n_points[i], large_scratch);
+        }
+        test_ecmult_multi_infinity();
+        test_ecmult_multi_parallel_random(secp256k1_testrand_int(ECMULT_MULTI_TEST_MAX_POINTS + 1), 9);
+        test_ecmult_multi_acc_random(secp256k1_testrand_int(ECMULT_MULTI_TEST_MAX_POINTS + 1), 1);
+        test_ecmult_multi_acc_random(secp256k1_testrand_int(ECMULT_MULTI_TEST_MAX_POINTS + 1), 1 + secp256k1_testrand_int(ECMULT_PIPPENGER_THRESHOLD));
+        test_ecmult_multi_acc_random(secp256k1_testrand_int(ECMULT_MULTI_TEST_MAX_POINTS + 1), ECMULT_PIPPENGER_THRESHOLD + secp256k1_testrand_int(ECMULT_MULTI_TEST_MAX_POINTS));
+    }
+    test_ecmult_multi_parallel_random(ECMULT_MULTI_TEST_MAX_POINTS, 3);
+
+    secp256k1_scratch_space_destroy(ctx, small_scratch);
+    secp256k1_scratch_space_destroy(ctx, large_scratch);
+}
+
+#endif /* SECP256K1_MODULE_ECMULT_MULTI_TESTS_H */
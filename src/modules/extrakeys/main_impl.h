@@ -106,9 +106,58 @@ int secp256k1_xonly_pubkey_tweak_add(const secp256k1_context* ctx, secp256k1_pub
     return 1;
 }
 
+int secp256k1_xonly_pubkey_tweak_add_batch(const secp256k1_context* ctx, secp256k1_pubkey *output_pubkeys, const secp256k1_xonly_pubkey * const *internal_pubkeys, const unsigned char * const *tweaks32, size_t n) {
+    secp256k1_ge pk[EC_PUBKEY_TWEAK_ADD_BATCH_SIZE];
+    int valid[EC_PUBKEY_TWEAK_ADD_BATCH_SIZE];
+    size_t i, j, batch;
+    int ret = 1;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(output_pubkeys != NULL || n == 0);
+    for (i = 0; i < n; i++) {
+        memset(&output_pubkeys[i], 0, sizeof(output_pubkeys[i]));
+    }
+    ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(internal_pubkeys != NULL || n == 0);
+    ARG_CHECK(tweaks32 != NULL || n == 0);
+    for (i = 0; i < n; i++) {
+        ARG_CHECK(internal_pubkeys[i] != NULL);
+        ARG_CHECK(tweaks32[i] != NULL);
+    }
+
+    for (i = 0; i < n; i += batch) {
+        batch = n - i < EC_PUBKEY_TWEAK_ADD_BATCH_SIZE ? n - i : EC_PUBKEY_TWEAK_ADD_BATCH_SIZE;
+        for (j = 0; j < batch; j++) {
+            valid[j] = secp256k1_xonly_pubkey_load(ctx, &pk[j], internal_pubkeys[i + j]);
+        }
+        secp256k1_ec_pubkey_tweak_add_batch_helper(&ctx->ecmult_ctx, pk, valid, &tweaks32[i], batch);
+        for (j = 0; j < batch; j++) {
+            if (valid[j]) {
+                secp256k1_pubkey_save(&output_pubkeys[i + j], &pk[j]);
+            }
+            ret &= valid[j];
+        }
+    }
+    return ret;
+}
+
+/* Checks that pk + tweak32*G has x coordinate tweaked_pubkey32 and Y parity tweaked_pk_parity. */
+static int secp256k1_xonly_pubkey_tweak_add_check_helper(const secp256k1_ecmult_context* ecmult_ctx, const unsigned char *tweaked_pubkey32, int tweaked_pk_parity, secp256k1_ge *pk, const unsigned char *tweak32) {
+    unsigned char pk_expected32[32];
+
+    if (!secp256k1_ec_pubkey_tweak_add_helper(ecmult_ctx, pk, tweak32)) {
+        return 0;
+    }
+    secp256k1_fe_normalize_var(&pk->x);
+    secp256k1_fe_normalize_var(&pk->y);
+    secp256k1_fe_get_b32(pk_expected32, &pk->x);
+
+    return secp256k1_memcmp_var(&pk_expected32, tweaked_pubkey32, 32) == 0
+            && secp256k1_fe_is_odd(&pk->y) == tweaked_pk_parity;
+}
+
 int secp256k1_xonly_pubkey_tweak_add_check(const secp256k1_context* ctx, const unsigned char *tweaked_pubkey32, int tweaked_pk_parity, const secp256k1_xonly_pubkey *internal_pubkey, const unsigned char *tweak32) {
     secp256k1_ge pk;
-    unsigned char pk_expected32[32];
 
     VERIFY_CHECK(ctx != NULL);
     ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
@@ -116,16 +165,167 @@ int secp256k1_xonly_pubkey_tweak_add_check(const secp256k1_context* ctx, const u
     ARG_CHECK(tweaked_pubkey32 != NULL);
     ARG_CHECK(tweak32 != NULL);
 
-    if (!secp256k1_xonly_pubkey_load(ctx, &pk, internal_pubkey)
-        || !secp256k1_ec_pubkey_tweak_add_helper(&ctx->ecmult_ctx, &pk, tweak32)) {
+    if (!secp256k1_xonly_pubkey_load(ctx, &pk, internal_pubkey)) {
+        return 0;
+    }
+    return secp256k1_xonly_pubkey_tweak_add_check_helper(&ctx->ecmult_ctx, tweaked_pubkey32, tweaked_pk_parity, &pk, tweak32);
+}
+
+int secp256k1_xonly_pubkey_tweak_add_check_tagged(const secp256k1_context* ctx, const unsigned char *tweaked_pubkey32, int tweaked_pk_parity, const secp256k1_xonly_pubkey *internal_pubkey, const secp256k1_tagged_hasher *hasher, const unsigned char *msg, size_t msglen) {
+    secp256k1_ge pk;
+    secp256k1_sha256 sha;
+    unsigned char pk32[32];
+    unsigned char tweak32[32];
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(internal_pubkey != NULL);
+    ARG_CHECK(tweaked_pubkey32 != NULL);
+    ARG_CHECK(hasher != NULL);
+    ARG_CHECK(msg != NULL || msglen == 0);
+
+    if (!secp256k1_xonly_pubkey_load(ctx, &pk, internal_pubkey)) {
         return 0;
     }
+    /* tweak32 = tagged hash(internal_pubkey || msg) */
     secp256k1_fe_normalize_var(&pk.x);
-    secp256k1_fe_normalize_var(&pk.y);
-    secp256k1_fe_get_b32(pk_expected32, &pk.x);
+    secp256k1_fe_get_b32(pk32, &pk.x);
+    secp256k1_sha256_load_midstate(&sha, hasher->data);
+    secp256k1_sha256_write(&sha, pk32, 32);
+    secp256k1_sha256_write(&sha, msg, msglen);
+    secp256k1_sha256_finalize(&sha, tweak32);
 
-    return secp256k1_memcmp_var(&pk_expected32, tweaked_pubkey32, 32) == 0
-            && secp256k1_fe_is_odd(&pk.y) == tweaked_pk_parity;
+    return secp256k1_xonly_pubkey_tweak_add_check_helper(&ctx->ecmult_ctx, tweaked_pubkey32, tweaked_pk_parity, &pk, tweak32);
+}
+
+typedef struct {
+    const secp256k1_context *ctx;
+    /* Seed for the random number generator */
+    unsigned char seed[32];
+    /* Caches the randomizer of the check at randomizer_idx */
+    secp256k1_scalar randomizer;
+    size_t randomizer_idx;
+    /* Tweak check inputs */
+    const unsigned char *const *tweaked_pubkey32;
+    const int *tweaked_pk_parity;
+    const secp256k1_xonly_pubkey *const *internal_pubkey;
+    size_t n_checks;
+} secp256k1_xonly_pubkey_tweak_check_ecmult_context;
+
+/* Computes the randomizer of the idx-th check from the seed. As in Schnorr batch
+ * verification, the first randomizer is always 1. */
+static void secp256k1_xonly_pubkey_tweak_check_batch_randomizer(secp256k1_scalar *r, const unsigned char *seed32, size_t idx) {
+    secp256k1_sha256 sha;
+    unsigned char buf[32];
+    int i;
+
+    if (idx == 0) {
+        secp256k1_scalar_set_int(r, 1);
+        return;
+    }
+    for (i = 0; i < 8; i++) {
+        buf[i] = (unsigned char)((uint64_t)idx >> (8 * i));
+    }
+    secp256k1_sha256_initialize(&sha);
+    secp256k1_sha256_write(&sha, seed32, 32);
+    secp256k1_sha256_write(&sha, buf, 8);
+    secp256k1_sha256_finalize(&sha, buf);
+    secp256k1_scalar_set_b32(r, buf, NULL);
+}
+
+/* Callback function for ecmult_multi. Every check Q = P + t*G results in two
+ * (scalar,point)-tuples:
+ * (randomizer, P)
+ * (-randomizer, Q) */
+static int secp256k1_xonly_pubkey_tweak_check_batch_ecmult_callback(secp256k1_scalar *sc, secp256k1_ge *pt, size_t idx, void *data) {
+    secp256k1_xonly_pubkey_tweak_check_ecmult_context *ecmult_context = (secp256k1_xonly_pubkey_tweak_check_ecmult_context *) data;
+    size_t check_idx = idx / 2;
+
+    VERIFY_CHECK(check_idx < ecmult_context->n_checks);
+    if (ecmult_context->randomizer_idx != check_idx) {
+        secp256k1_xonly_pubkey_tweak_check_batch_randomizer(&ecmult_context->randomizer, ecmult_context->seed, check_idx);
+        ecmult_context->randomizer_idx = check_idx;
+    }
+
+    if (idx % 2 == 0) {
+        *sc = ecmult_context->randomizer;
+        if (!secp256k1_xonly_pubkey_load(ecmult_context->ctx, pt, ecmult_context->internal_pubkey[check_idx])) {
+            return 0;
+        }
+    } else {
+        secp256k1_fe qx;
+        secp256k1_scalar_negate(sc, &ecmult_context->randomizer);
+        if (!secp256k1_fe_set_b32(&qx, ecmult_context->tweaked_pubkey32[check_idx])) {
+            return 0;
+        }
+        if (!secp256k1_ge_set_xo_var(pt, &qx, ecmult_context->tweaked_pk_parity[check_idx])) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int secp256k1_xonly_pubkey_tweak_add_check_batch(const secp256k1_context* ctx, secp256k1_scratch_space *scratch, const unsigned char *const *tweaked_pubkey32, const int *tweaked_pk_parity, const secp256k1_xonly_pubkey *const *internal_pubkey, const unsigned char *const *tweak32, size_t n_checks) {
+    static const unsigned char tag[] = {'s', 'e', 'c', 'p', '2', '5', '6', 'k', '1', '/', 't', 'w', 'e', 'a', 'k', '_', 'c', 'h', 'e', 'c', 'k', '_', 'b', 'a', 't', 'c', 'h'};
+    secp256k1_xonly_pubkey_tweak_check_ecmult_context ecmult_context;
+    secp256k1_sha256 sha;
+    secp256k1_scalar s;
+    secp256k1_gej rj;
+    size_t i;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(scratch != NULL);
+    /* As in secp256k1_schnorrsig_verify_batch, every check adds two points to ecmult_multi. */
+    ARG_CHECK(n_checks <= SIZE_MAX / 2);
+    ARG_CHECK(n_checks < ((uint32_t)1 << 31));
+    ARG_CHECK(n_checks == 0 || (tweaked_pubkey32 != NULL && tweaked_pk_parity != NULL && internal_pubkey != NULL && tweak32 != NULL));
+
+    /* Derive the seed for the randomizers from all inputs. */
+    secp256k1_sha256_initialize_tagged(&sha, tag, sizeof(tag));
+    for (i = 0; i < n_checks; i++) {
+        secp256k1_ge pk;
+        unsigned char buf[33];
+        ARG_CHECK(tweaked_pubkey32[i] != NULL);
+        ARG_CHECK(internal_pubkey[i] != NULL);
+        ARG_CHECK(tweak32[i] != NULL);
+        if ((tweaked_pk_parity[i] & ~1) != 0) {
+            return 0;
+        }
+        if (!secp256k1_xonly_pubkey_load(ctx, &pk, internal_pubkey[i])) {
+            return 0;
+        }
+        secp256k1_fe_get_b32(buf, &pk.x);
+        buf[32] = (unsigned char)tweaked_pk_parity[i];
+        secp256k1_sha256_write(&sha, tweaked_pubkey32[i], 32);
+        secp256k1_sha256_write(&sha, buf, 33);
+        secp256k1_sha256_write(&sha, tweak32[i], 32);
+    }
+    ecmult_context.ctx = ctx;
+    secp256k1_sha256_finalize(&sha, ecmult_context.seed);
+    ecmult_context.tweaked_pubkey32 = tweaked_pubkey32;
+    ecmult_context.tweaked_pk_parity = tweaked_pk_parity;
+    ecmult_context.internal_pubkey = internal_pubkey;
+    ecmult_context.n_checks = n_checks;
+
+    /* Compute s = sum(randomizer_i * tweak_i), the scalar of the generator. */
+    secp256k1_scalar_set_int(&s, 0);
+    for (i = 0; i < n_checks; i++) {
+        int overflow;
+        secp256k1_scalar term;
+        secp256k1_scalar_set_b32(&term, tweak32[i], &overflow);
+        if (overflow) {
+            return 0;
+        }
+        secp256k1_xonly_pubkey_tweak_check_batch_randomizer(&ecmult_context.randomizer, ecmult_context.seed, i);
+        secp256k1_scalar_mul(&term, &term, &ecmult_context.randomizer);
+        secp256k1_scalar_add(&s, &s, &term);
+    }
+    /* Invalidate the cache, the callback starts at the first check. */
+    ecmult_context.randomizer_idx = SIZE_MAX;
+
+    return secp256k1_ecmult_multi_var(&ctx->error_callback, &ctx->ecmult_ctx, scratch, &rj, &s, secp256k1_xonly_pubkey_tweak_check_batch_ecmult_callback, (void *) &ecmult_context, 2 * n_checks)
+            && secp256k1_gej_is_infinity(&rj);
 }
 
 static void secp256k1_keypair_save(secp256k1_keypair *keypair, const secp256k1_scalar *sk, secp256k1_ge *pk) {
@@ -248,4 +448,166 @@ int secp256k1_keypair_xonly_tweak_add(const secp256k1_context* ctx, secp256k1_ke
     return ret;
 }
 
+static int secp256k1_pubkey_jacobian_load(const secp256k1_context* ctx, secp256k1_gej *gej, const secp256k1_pubkey_jacobian *pubkey) {
+    secp256k1_fe_set_b32(&gej->x, &pubkey->data[0]);
+    secp256k1_fe_set_b32(&gej->y, &pubkey->data[32]);
+    secp256k1_fe_set_b32(&gej->z, &pubkey->data[64]);
+    gej->infinity = 0;
+    /* A valid point never has Z = 0, so a zeroed (invalid) object is caught here. */
+    ARG_CHECK(!secp256k1_fe_is_zero(&gej->z));
+    return 1;
+}
+
+static void secp256k1_pubkey_jacobian_save(secp256k1_pubkey_jacobian *pubkey, secp256k1_gej *gej) {
+    VERIFY_CHECK(!secp256k1_gej_is_infinity(gej));
+    secp256k1_fe_normalize_var(&gej->x);
+    secp256k1_fe_normalize_var(&gej->y);
+    secp256k1_fe_normalize_var(&gej->z);
+    secp256k1_fe_get_b32(&pubkey->data[0], &gej->x);
+    secp256k1_fe_get_b32(&pubkey->data[32], &gej->y);
+    secp256k1_fe_get_b32(&pubkey->data[64], &gej->z);
+}
+
+int secp256k1_pubkey_jacobian_from_pubkey(const secp256k1_context* ctx, secp256k1_pubkey_jacobian *output, const secp256k1_pubkey *pubkey) {
+    secp256k1_ge pk;
+    secp256k1_gej pkj;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(output != NULL);
+    memset(output, 0, sizeof(*output));
+    ARG_CHECK(pubkey != NULL);
+
+    if (!secp256k1_pubkey_load(ctx, &pk, pubkey)) {
+        return 0;
+    }
+    secp256k1_gej_set_ge(&pkj, &pk);
+    secp256k1_pubkey_jacobian_save(output, &pkj);
+    return 1;
+}
+
+int secp256k1_pubkey_jacobian_from_xonly_pubkey(const secp256k1_context* ctx, secp256k1_pubkey_jacobian *output, const secp256k1_xonly_pubkey *pubkey) {
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(pubkey != NULL);
+    return secp256k1_pubkey_jacobian_from_pubkey(ctx, output, (const secp256k1_pubkey *) pubkey);
+}
+
+int secp256k1_pubkey_jacobian_tweak_add(const secp256k1_context* ctx, secp256k1_pubkey_jacobian *pubkey, const unsigned char *tweak32) {
+    secp256k1_gej pkj, tj;
+    secp256k1_scalar tweak, zero;
+    int overflow = 0;
+    int ret;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(pubkey != NULL);
+    ARG_CHECK(tweak32 != NULL);
+
+    ret = secp256k1_pubkey_jacobian_load(ctx, &pkj, pubkey);
+    memset(pubkey, 0, sizeof(*pubkey));
+    secp256k1_scalar_set_b32(&tweak, tweak32, &overflow);
+    if (!ret || overflow) {
+        return 0;
+    }
+    /* tj = tweak*G, with a zero multiple of pkj, which spares secp256k1_ecmult the
+     * table of multiples that secp256k1_eckey_pubkey_tweak_add has it build. */
+    secp256k1_scalar_set_int(&zero, 0);
+    secp256k1_ecmult(&ctx->ecmult_ctx, &tj, &pkj, &zero, &tweak);
+    secp256k1_gej_add_var(&pkj, &pkj, &tj, NULL);
+    if (secp256k1_gej_is_infinity(&pkj)) {
+        return 0;
+    }
+    secp256k1_pubkey_jacobian_save(pubkey, &pkj);
+    return 1;
+}
+
+int secp256k1_pubkey_jacobian_get(const secp256k1_context* ctx, secp256k1_pubkey *output, const secp256k1_pubkey_jacobian *pubkey) {
+    secp256k1_gej pkj;
+    secp256k1_ge pk;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(output != NULL);
+    memset(output, 0, sizeof(*output));
+    ARG_CHECK(pubkey != NULL);
+
+    if (!secp256k1_pubkey_jacobian_load(ctx, &pkj, pubkey)) {
+        return 0;
+    }
+    secp256k1_ge_set_gej_var(&pk, &pkj);
+    secp256k1_pubkey_save(output, &pk);
+    return 1;
+}
+
+int secp256k1_pubkey_jacobian_serialize(const secp256k1_context* ctx, unsigned char *output, size_t *outputlen, const secp256k1_pubkey_jacobian* pubkey, unsigned int flags) {
+    secp256k1_gej pkj;
+    secp256k1_ge pk;
+    size_t len;
+    int ret = 0;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(outputlen != NULL);
+    ARG_CHECK(*outputlen >= ((flags & SECP256K1_FLAGS_BIT_COMPRESSION) ? 33u : 65u));
+    len = *outputlen;
+    *outputlen = 0;
+    ARG_CHECK(output != NULL);
+    memset(output, 0, len);
+    ARG_CHECK(pubkey != NULL);
+    ARG_CHECK((flags & SECP256K1_FLAGS_TYPE_MASK) == SECP256K1_FLAGS_TYPE_COMPRESSION);
+    if (secp256k1_pubkey_jacobian_load(ctx, &pkj, pubkey)) {
+        secp256k1_ge_set_gej_var(&pk, &pkj);
+        ret = secp256k1_eckey_pubkey_serialize(&pk, output, &len, flags & SECP256K1_FLAGS_BIT_COMPRESSION);
+        if (ret) {
+            *outputlen = len;
+        }
+    }
+    return ret;
+}
+
+int secp256k1_pubkey_jacobian_serialize_xonly(const secp256k1_context* ctx, unsigned char *output32, int *pk_parity, const secp256k1_pubkey_jacobian *pubkey) {
+    secp256k1_gej pkj;
+    secp256k1_ge pk;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(output32 != NULL);
+    memset(output32, 0, 32);
+    ARG_CHECK(pubkey != NULL);
+
+    if (!secp256k1_pubkey_jacobian_load(ctx, &pkj, pubkey)) {
+        return 0;
+    }
+    secp256k1_ge_set_gej_var(&pk, &pkj);
+    secp256k1_fe_normalize_var(&pk.x);
+    secp256k1_fe_normalize_var(&pk.y);
+    if (pk_parity != NULL) {
+        *pk_parity = secp256k1_fe_is_odd(&pk.y);
+    }
+    secp256k1_fe_get_b32(output32, &pk.x);
+    return 1;
+}
+
+int secp256k1_pubkey_jacobian_equal(const secp256k1_context* ctx, const secp256k1_pubkey_jacobian *pubkey1, const secp256k1_pubkey_jacobian *pubkey2) {
+    secp256k1_gej a, b;
+    secp256k1_fe az2, bz2, u1, u2, s1, s2;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(pubkey1 != NULL);
+    ARG_CHECK(pubkey2 != NULL);
+
+    if (!secp256k1_pubkey_jacobian_load(ctx, &a, pubkey1) || !secp256k1_pubkey_jacobian_load(ctx, &b, pubkey2)) {
+        return 0;
+    }
+    /* (x1/z1^2, y1/z1^3) == (x2/z2^2, y2/z2^3) iff x1*z2^2 == x2*z1^2 and y1*z2^3 == y2*z1^3. */
+    secp256k1_fe_sqr(&az2, &a.z);
+    secp256k1_fe_sqr(&bz2, &b.z);
+    secp256k1_fe_mul(&u1, &a.x, &bz2);
+    secp256k1_fe_mul(&u2, &b.x, &az2);
+    if (!secp256k1_fe_equal_var(&u1, &u2)) {
+        return 0;
+    }
+    secp256k1_fe_mul(&s1, &a.y, &bz2);
+    secp256k1_fe_mul(&s1, &s1, &b.z);
+    secp256k1_fe_mul(&s2, &b.y, &az2);
+    secp256k1_fe_mul(&s2, &s2, &a.z);
+    return secp256k1_fe_equal_var(&s1, &s2);
+}
+
 #endif
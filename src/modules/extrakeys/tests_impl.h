@@ -209,6 +209,70 @@ void test_xonly_pubkey_tweak(void) {
     secp256k1_context_destroy(verify);
 }
 
+void test_xonly_pubkey_tweak_add_batch(void) {
+    /* A mix of valid and invalid tweaks, compared to tweaking one key at a time. */
+    unsigned char tweaks[40][32];
+    const unsigned char *tweak_ptrs[40];
+    secp256k1_xonly_pubkey internal_pks[40];
+    const secp256k1_xonly_pubkey *internal_pk_ptrs[40];
+    secp256k1_pubkey output_pks[40], expected[40];
+    size_t i, n = 1 + secp256k1_testrand_int(40);
+    int all = 1;
+    int ecount;
+    secp256k1_context *sign = api_test_context(SECP256K1_CONTEXT_SIGN, &ecount);
+    secp256k1_context *verify = api_test_context(SECP256K1_CONTEXT_VERIFY, &ecount);
+
+    for (i = 0; i < n; i++) {
+        unsigned char sk[32];
+        secp256k1_pubkey pk;
+        secp256k1_scalar tw;
+        int kind = secp256k1_testrand_int(8);
+
+        secp256k1_testrand256(sk);
+        CHECK(secp256k1_ec_pubkey_create(ctx, &pk, sk) == 1);
+        CHECK(secp256k1_xonly_pubkey_from_pubkey(ctx, &internal_pks[i], NULL, &pk) == 1);
+        secp256k1_testrand256(tweaks[i]);
+        if (kind < 2) {
+            /* One of sk and -sk cancels the key */
+            secp256k1_scalar_set_b32(&tw, sk, NULL);
+            if (kind == 1) {
+                secp256k1_scalar_negate(&tw, &tw);
+            }
+            secp256k1_scalar_get_b32(tweaks[i], &tw);
+        } else if (kind == 2) {
+            memset(tweaks[i], 0xFF, 32);
+        }
+        tweak_ptrs[i] = tweaks[i];
+        internal_pk_ptrs[i] = &internal_pks[i];
+        all &= secp256k1_xonly_pubkey_tweak_add(verify, &expected[i], &internal_pks[i], tweaks[i]);
+    }
+    CHECK(secp256k1_xonly_pubkey_tweak_add_batch(verify, output_pks, internal_pk_ptrs, tweak_ptrs, n) == all);
+    CHECK(secp256k1_memcmp_var(expected, output_pks, n * sizeof(output_pks[0])) == 0);
+
+    ecount = 0;
+    CHECK(secp256k1_xonly_pubkey_tweak_add_batch(verify, NULL, NULL, NULL, 0) == 1);
+    CHECK(secp256k1_xonly_pubkey_tweak_add_batch(sign, output_pks, internal_pk_ptrs, tweak_ptrs, n) == 0);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_xonly_pubkey_tweak_add_batch(verify, NULL, internal_pk_ptrs, tweak_ptrs, 1) == 0);
+    CHECK(ecount == 2);
+    CHECK(secp256k1_xonly_pubkey_tweak_add_batch(verify, output_pks, NULL, tweak_ptrs, 1) == 0);
+    CHECK(ecount == 3);
+    CHECK(secp256k1_xonly_pubkey_tweak_add_batch(verify, output_pks, internal_pk_ptrs, NULL, 1) == 0);
+    CHECK(ecount == 4);
+    tweak_ptrs[0] = NULL;
+    CHECK(secp256k1_xonly_pubkey_tweak_add_batch(verify, output_pks, internal_pk_ptrs, tweak_ptrs, 1) == 0);
+    CHECK(ecount == 5);
+
+    /* Invalid pk with a valid tweak */
+    memset(&internal_pks[0], 0, sizeof(internal_pks[0]));
+    tweak_ptrs[0] = tweaks[0];
+    CHECK(secp256k1_xonly_pubkey_tweak_add_batch(verify, output_pks, internal_pk_ptrs, tweak_ptrs, 1) == 0);
+    CHECK(ecount == 6);
+
+    secp256k1_context_destroy(sign);
+    secp256k1_context_destroy(verify);
+}
+
 void test_xonly_pubkey_tweak_check(void) {
     unsigned char zeros64[64] = { 0 };
     unsigned char overflows[32];
@@ -276,6 +340,170 @@ void test_xonly_pubkey_tweak_check(void) {
     secp256k1_context_destroy(verify);
 }
 
+void test_xonly_pubkey_tweak_check_tagged(void) {
+    /* First scriptPubKey test vector of BIP-341 (no script tree) */
+    static const unsigned char internal_pk32[32] = {
+        0xd6, 0x88, 0x9c, 0xb0, 0x81, 0x03, 0x6e, 0x0f, 0xae, 0xfa, 0x3a, 0x35, 0x15, 0x7a, 0xd7, 0x10,
+        0x86, 0xb1, 0x23, 0xb2, 0xb1, 0x44, 0xb6, 0x49, 0x79, 0x8b, 0x49, 0x4c, 0x30, 0x0a, 0x96, 0x1d
+    };
+    static const unsigned char expected_tweak[32] = {
+        0xb8, 0x6e, 0x7b, 0xe8, 0xf3, 0x9b, 0xab, 0x32, 0xa6, 0xf2, 0xc0, 0x44, 0x3a, 0xbb, 0xc2, 0x10,
+        0xf0, 0xed, 0xac, 0x0e, 0x2c, 0x53, 0xd5, 0x01, 0xb3, 0x6b, 0x64, 0x43, 0x7d, 0x9c, 0x6c, 0x70
+    };
+    static const unsigned char tweaked_pk32[32] = {
+        0x53, 0xa1, 0xf6, 0xe4, 0x54, 0xdf, 0x1a, 0xa2, 0x77, 0x6a, 0x28, 0x14, 0xa7, 0x21, 0x37, 0x2d,
+        0x62, 0x58, 0x05, 0x0d, 0xe3, 0x30, 0xb3, 0xc6, 0xd1, 0x0e, 0xe8, 0xf4, 0xe0, 0xdd, 0xa3, 0x43
+    };
+    static const unsigned char tag[8] = "TapTweak";
+    secp256k1_tagged_hasher hasher;
+    secp256k1_xonly_pubkey internal_xonly_pk;
+    secp256k1_xonly_pubkey output_xonly_pk;
+    secp256k1_pubkey output_pk;
+    unsigned char tweak[32];
+    unsigned char msg[32];
+    unsigned char buf32[32];
+    int pk_parity;
+    int ecount;
+    secp256k1_context *none = api_test_context(SECP256K1_CONTEXT_NONE, &ecount);
+    secp256k1_context *verify = api_test_context(SECP256K1_CONTEXT_VERIFY, &ecount);
+
+    ecount = 0;
+    CHECK(secp256k1_tagged_hasher_init(none, &hasher, tag, sizeof(tag)) == 1);
+    CHECK(secp256k1_tagged_hasher_hash(none, tweak, &hasher, internal_pk32, 32) == 1);
+    CHECK(secp256k1_memcmp_var(tweak, expected_tweak, 32) == 0);
+    CHECK(secp256k1_xonly_pubkey_parse(none, &internal_xonly_pk, internal_pk32) == 1);
+    CHECK(secp256k1_xonly_pubkey_tweak_add_check(verify, tweaked_pk32, 1, &internal_xonly_pk, tweak) == 1);
+    CHECK(secp256k1_xonly_pubkey_tweak_add_check_tagged(none, tweaked_pk32, 1, &internal_xonly_pk, &hasher, NULL, 0) == 0);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_xonly_pubkey_tweak_add_check_tagged(verify, tweaked_pk32, 1, &internal_xonly_pk, &hasher, NULL, 0) == 1);
+    CHECK(secp256k1_xonly_pubkey_tweak_add_check_tagged(verify, tweaked_pk32, 0, &internal_xonly_pk, &hasher, NULL, 0) == 0);
+    CHECK(secp256k1_xonly_pubkey_tweak_add_check_tagged(verify, internal_pk32, 1, &internal_xonly_pk, &hasher, NULL, 0) == 0);
+    CHECK(secp256k1_xonly_pubkey_tweak_add_check_tagged(verify, NULL, 1, &internal_xonly_pk, &hasher, NULL, 0) == 0);
+    CHECK(ecount == 2);
+    CHECK(secp256k1_xonly_pubkey_tweak_add_check_tagged(verify, tweaked_pk32, 1, NULL, &hasher, NULL, 0) == 0);
+    CHECK(ecount == 3);
+    CHECK(secp256k1_xonly_pubkey_tweak_add_check_tagged(verify, tweaked_pk32, 1, &internal_xonly_pk, NULL, NULL, 0) == 0);
+    CHECK(ecount == 4);
+    CHECK(secp256k1_xonly_pubkey_tweak_add_check_tagged(verify, tweaked_pk32, 1, &internal_xonly_pk, &hasher, NULL, 32) == 0);
+    CHECK(ecount == 5);
+
+    /* With a random internal key and merkle root, the result matches hashing manually. */
+    secp256k1_testrand256(buf32);
+    secp256k1_testrand256(msg);
+    CHECK(secp256k1_ec_pubkey_create(ctx, &output_pk, buf32) == 1);
+    CHECK(secp256k1_xonly_pubkey_from_pubkey(ctx, &internal_xonly_pk, NULL, &output_pk) == 1);
+    {
+        secp256k1_sha256 sha;
+        CHECK(secp256k1_xonly_pubkey_serialize(ctx, buf32, &internal_xonly_pk) == 1);
+        secp256k1_sha256_initialize_tagged(&sha, tag, sizeof(tag));
+        secp256k1_sha256_write(&sha, buf32, 32);
+        secp256k1_sha256_write(&sha, msg, 32);
+        secp256k1_sha256_finalize(&sha, tweak);
+    }
+    CHECK(secp256k1_xonly_pubkey_tweak_add(ctx, &output_pk, &internal_xonly_pk, tweak) == 1);
+    CHECK(secp256k1_xonly_pubkey_from_pubkey(ctx, &output_xonly_pk, &pk_parity, &output_pk) == 1);
+    CHECK(secp256k1_xonly_pubkey_serialize(ctx, buf32, &output_xonly_pk) == 1);
+    CHECK(secp256k1_xonly_pubkey_tweak_add_check_tagged(ctx, buf32, pk_parity, &internal_xonly_pk, &hasher, msg, 32) == 1);
+    CHECK(secp256k1_xonly_pubkey_tweak_add_check_tagged(ctx, buf32, pk_parity, &internal_xonly_pk, &hasher, msg, 31) == 0);
+    CHECK(ecount == 5);
+
+    secp256k1_context_destroy(none);
+    secp256k1_context_destroy(verify);
+}
+
+void test_xonly_pubkey_tweak_check_batch(void) {
+    const size_t n_max = 64;
+    unsigned char sk[32];
+    unsigned char invalid32[32];
+    unsigned char (*tweak)[32] = (unsigned char (*)[32])checked_malloc(&ctx->error_callback, n_max * 32);
+    unsigned char (*tweaked_pk32)[32] = (unsigned char (*)[32])checked_malloc(&ctx->error_callback, n_max * 32);
+    int *parity = (int *)checked_malloc(&ctx->error_callback, n_max * sizeof(*parity));
+    secp256k1_xonly_pubkey *pk = (secp256k1_xonly_pubkey *)checked_malloc(&ctx->error_callback, n_max * sizeof(*pk));
+    const unsigned char **tweak_arr = (const unsigned char **)checked_malloc(&ctx->error_callback, n_max * sizeof(*tweak_arr));
+    const unsigned char **tweaked_pk_arr = (const unsigned char **)checked_malloc(&ctx->error_callback, n_max * sizeof(*tweaked_pk_arr));
+    const secp256k1_xonly_pubkey **pk_arr = (const secp256k1_xonly_pubkey **)checked_malloc(&ctx->error_callback, n_max * sizeof(*pk_arr));
+    secp256k1_scratch_space *scratch = secp256k1_scratch_space_create(ctx, 1000000);
+    secp256k1_scratch_space *small_scratch = secp256k1_scratch_space_create(ctx, secp256k1_strauss_scratch_size(5) + STRAUSS_SCRATCH_OBJECTS*ALIGNMENT);
+    size_t i, n;
+    int ecount;
+    secp256k1_context *none = api_test_context(SECP256K1_CONTEXT_NONE, &ecount);
+    secp256k1_context *verify = api_test_context(SECP256K1_CONTEXT_VERIFY, &ecount);
+
+    memset(invalid32, 0xFF, sizeof(invalid32));
+    for (i = 0; i < n_max; i++) {
+        secp256k1_pubkey output_pk;
+        secp256k1_xonly_pubkey output_xonly_pk;
+        secp256k1_testrand256(sk);
+        secp256k1_testrand256(tweak[i]);
+        CHECK(secp256k1_ec_pubkey_create(ctx, &output_pk, sk) == 1);
+        CHECK(secp256k1_xonly_pubkey_from_pubkey(ctx, &pk[i], NULL, &output_pk) == 1);
+        CHECK(secp256k1_xonly_pubkey_tweak_add(ctx, &output_pk, &pk[i], tweak[i]) == 1);
+        CHECK(secp256k1_xonly_pubkey_from_pubkey(ctx, &output_xonly_pk, &parity[i], &output_pk) == 1);
+        CHECK(secp256k1_xonly_pubkey_serialize(ctx, tweaked_pk32[i], &output_xonly_pk) == 1);
+        tweak_arr[i] = tweak[i];
+        tweaked_pk_arr[i] = tweaked_pk32[i];
+        pk_arr[i] = &pk[i];
+    }
+
+    ecount = 0;
+    CHECK(secp256k1_xonly_pubkey_tweak_add_check_batch(none, scratch, tweaked_pk_arr, parity, pk_arr, tweak_arr, 1) == 0);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_xonly_pubkey_tweak_add_check_batch(verify, scratch, tweaked_pk_arr, parity, pk_arr, tweak_arr, 1) == 1);
+    CHECK(secp256k1_xonly_pubkey_tweak_add_check_batch(verify, scratch, NULL, NULL, NULL, NULL, 0) == 1);
+    CHECK(secp256k1_xonly_pubkey_tweak_add_check_batch(verify, NULL, tweaked_pk_arr, parity, pk_arr, tweak_arr, 1) == 0);
+    CHECK(ecount == 2);
+    CHECK(secp256k1_xonly_pubkey_tweak_add_check_batch(verify, scratch, NULL, parity, pk_arr, tweak_arr, 1) == 0);
+    CHECK(ecount == 3);
+    CHECK(secp256k1_xonly_pubkey_tweak_add_check_batch(verify, scratch, tweaked_pk_arr, NULL, pk_arr, tweak_arr, 1) == 0);
+    CHECK(ecount == 4);
+    CHECK(secp256k1_xonly_pubkey_tweak_add_check_batch(verify, scratch, tweaked_pk_arr, parity, NULL, tweak_arr, 1) == 0);
+    CHECK(ecount == 5);
+    CHECK(secp256k1_xonly_pubkey_tweak_add_check_batch(verify, scratch, tweaked_pk_arr, parity, pk_arr, NULL, 1) == 0);
+    CHECK(ecount == 6);
+    CHECK(secp256k1_xonly_pubkey_tweak_add_check_batch(verify, scratch, tweaked_pk_arr, parity, pk_arr, tweak_arr, (size_t)1 << 31) == 0);
+    CHECK(ecount == 7);
+
+    for (n = 1; n <= n_max; n += 1 + secp256k1_testrand_int(16)) {
+        size_t bad = secp256k1_testrand_int(n);
+        unsigned char tweak_bak[32];
+        CHECK(secp256k1_xonly_pubkey_tweak_add_check_batch(ctx, scratch, tweaked_pk_arr, parity, pk_arr, tweak_arr, n));
+        CHECK(secp256k1_xonly_pubkey_tweak_add_check_batch(ctx, small_scratch, tweaked_pk_arr, parity, pk_arr, tweak_arr, n));
+        /* Wrong parity, including one that is not 0 or 1 */
+        parity[bad] ^= 1;
+        CHECK(!secp256k1_xonly_pubkey_tweak_add_check(ctx, tweaked_pk32[bad], parity[bad], &pk[bad], tweak[bad]));
+        CHECK(!secp256k1_xonly_pubkey_tweak_add_check_batch(ctx, scratch, tweaked_pk_arr, parity, pk_arr, tweak_arr, n));
+        CHECK(!secp256k1_xonly_pubkey_tweak_add_check_batch(ctx, small_scratch, tweaked_pk_arr, parity, pk_arr, tweak_arr, n));
+        parity[bad] ^= 1;
+        parity[bad] += 2;
+        CHECK(!secp256k1_xonly_pubkey_tweak_add_check_batch(ctx, scratch, tweaked_pk_arr, parity, pk_arr, tweak_arr, n));
+        parity[bad] -= 2;
+        /* Wrong tweak, and an overflowing one */
+        memcpy(tweak_bak, tweak[bad], 32);
+        tweak[bad][31] ^= 1;
+        CHECK(!secp256k1_xonly_pubkey_tweak_add_check_batch(ctx, scratch, tweaked_pk_arr, parity, pk_arr, tweak_arr, n));
+        memset(tweak[bad], 0xFF, 32);
+        CHECK(!secp256k1_xonly_pubkey_tweak_add_check_batch(ctx, scratch, tweaked_pk_arr, parity, pk_arr, tweak_arr, n));
+        memcpy(tweak[bad], tweak_bak, 32);
+        /* A tweaked pubkey that is not a valid field element */
+        tweaked_pk_arr[bad] = invalid32;
+        CHECK(!secp256k1_xonly_pubkey_tweak_add_check_batch(ctx, scratch, tweaked_pk_arr, parity, pk_arr, tweak_arr, n));
+        tweaked_pk_arr[bad] = tweaked_pk32[bad];
+        CHECK(secp256k1_xonly_pubkey_tweak_add_check_batch(ctx, scratch, tweaked_pk_arr, parity, pk_arr, tweak_arr, n));
+    }
+
+    secp256k1_context_destroy(none);
+    secp256k1_context_destroy(verify);
+    secp256k1_scratch_space_destroy(ctx, scratch);
+    secp256k1_scratch_space_destroy(ctx, small_scratch);
+    free(tweak);
+    free(tweaked_pk32);
+    free(parity);
+    free(pk);
+    free(tweak_arr);
+    free(tweaked_pk_arr);
+    free(pk_arr);
+}
+
 /* Starts with an initial pubkey and recursively creates N_PUBKEYS - 1
  * additional pubkeys by calling tweak_add. Then verifies every tweak starting
  * from the last pubkey. */
@@ -509,13 +737,202 @@ void test_keypair_add(void) {
     secp256k1_context_destroy(verify);
 }
 
+void test_pubkey_jacobian_api(void) {
+    unsigned char zeros96[96] = { 0 };
+    unsigned char sk[32];
+    unsigned char tweak[32];
+    unsigned char buf[65];
+    size_t len;
+    secp256k1_pubkey pk;
+    secp256k1_xonly_pubkey xonly_pk;
+    secp256k1_pubkey_jacobian pkj, pkj2;
+
+    int ecount;
+    secp256k1_context *none = api_test_context(SECP256K1_CONTEXT_NONE, &ecount);
+    secp256k1_context *sign = api_test_context(SECP256K1_CONTEXT_SIGN, &ecount);
+    secp256k1_context *verify = api_test_context(SECP256K1_CONTEXT_VERIFY, &ecount);
+
+    secp256k1_testrand256(sk);
+    secp256k1_testrand256(tweak);
+    CHECK(secp256k1_ec_pubkey_create(ctx, &pk, sk) == 1);
+    CHECK(secp256k1_xonly_pubkey_from_pubkey(ctx, &xonly_pk, NULL, &pk) == 1);
+
+    ecount = 0;
+    CHECK(secp256k1_pubkey_jacobian_from_pubkey(none, &pkj, &pk) == 1);
+    CHECK(secp256k1_pubkey_jacobian_from_pubkey(none, NULL, &pk) == 0);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_pubkey_jacobian_from_pubkey(none, &pkj2, NULL) == 0);
+    CHECK(ecount == 2);
+    CHECK(secp256k1_memcmp_var(&pkj2, zeros96, sizeof(pkj2)) == 0);
+    CHECK(secp256k1_pubkey_jacobian_from_xonly_pubkey(none, &pkj2, &xonly_pk) == 1);
+    CHECK(secp256k1_pubkey_jacobian_from_xonly_pubkey(none, &pkj2, NULL) == 0);
+    CHECK(ecount == 3);
+
+    ecount = 0;
+    CHECK(secp256k1_pubkey_jacobian_tweak_add(none, &pkj, tweak) == 0);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_pubkey_jacobian_tweak_add(sign, &pkj, tweak) == 0);
+    CHECK(ecount == 2);
+    CHECK(secp256k1_pubkey_jacobian_tweak_add(verify, &pkj, tweak) == 1);
+    CHECK(secp256k1_pubkey_jacobian_tweak_add(verify, NULL, tweak) == 0);
+    CHECK(ecount == 3);
+    CHECK(secp256k1_pubkey_jacobian_tweak_add(verify, &pkj, NULL) == 0);
+    CHECK(ecount == 4);
+    /* An overflowing tweak zeroes pkj, which is then rejected */
+    memset(buf, 0xff, 32);
+    CHECK(secp256k1_pubkey_jacobian_tweak_add(verify, &pkj, buf) == 0);
+    CHECK(secp256k1_memcmp_var(&pkj, zeros96, sizeof(pkj)) == 0);
+    CHECK(ecount == 4);
+    CHECK(secp256k1_pubkey_jacobian_tweak_add(verify, &pkj, tweak) == 0);
+    CHECK(ecount == 5);
+    /* A zero tweak is fine */
+    CHECK(secp256k1_pubkey_jacobian_from_pubkey(none, &pkj, &pk) == 1);
+    CHECK(secp256k1_pubkey_jacobian_tweak_add(verify, &pkj, zeros96) == 1);
+
+    ecount = 0;
+    CHECK(secp256k1_pubkey_jacobian_get(none, &pk, &pkj) == 1);
+    CHECK(secp256k1_pubkey_jacobian_get(none, NULL, &pkj) == 0);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_pubkey_jacobian_get(none, &pk, NULL) == 0);
+    CHECK(ecount == 2);
+    CHECK(secp256k1_pubkey_jacobian_get(none, &pk, &pkj2) == 1);
+
+    ecount = 0;
+    len = 33;
+    CHECK(secp256k1_pubkey_jacobian_serialize(none, buf, &len, &pkj, SECP256K1_EC_COMPRESSED) == 1);
+    CHECK(len == 33);
+    CHECK(secp256k1_pubkey_jacobian_serialize(none, buf, &len, &pkj, SECP256K1_EC_UNCOMPRESSED) == 0);
+    CHECK(ecount == 1);
+    CHECK(len == 33);
+    CHECK(secp256k1_pubkey_jacobian_serialize(none, buf, &len, NULL, SECP256K1_EC_COMPRESSED) == 0);
+    CHECK(ecount == 2);
+    CHECK(len == 0);
+    len = 65;
+    CHECK(secp256k1_pubkey_jacobian_serialize(none, buf, &len, &pkj, SECP256K1_EC_UNCOMPRESSED) == 1);
+    CHECK(len == 65);
+
+    ecount = 0;
+    CHECK(secp256k1_pubkey_jacobian_serialize_xonly(none, buf, NULL, &pkj) == 1);
+    CHECK(secp256k1_pubkey_jacobian_serialize_xonly(none, NULL, NULL, &pkj) == 0);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_pubkey_jacobian_serialize_xonly(none, buf, NULL, NULL) == 0);
+    CHECK(ecount == 2);
+    CHECK(secp256k1_memcmp_var(buf, zeros96, 32) == 0);
+
+    ecount = 0;
+    CHECK(secp256k1_pubkey_jacobian_equal(none, &pkj, &pkj) == 1);
+    CHECK(secp256k1_pubkey_jacobian_equal(none, NULL, &pkj) == 0);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_pubkey_jacobian_equal(none, &pkj, NULL) == 0);
+    CHECK(ecount == 2);
+    /* A zeroed object is invalid */
+    memset(&pkj2, 0, sizeof(pkj2));
+    CHECK(secp256k1_pubkey_jacobian_equal(none, &pkj, &pkj2) == 0);
+    CHECK(ecount == 3);
+
+    secp256k1_context_destroy(none);
+    secp256k1_context_destroy(sign);
+    secp256k1_context_destroy(verify);
+}
+
+/* Applies a chain of tweaks to a Jacobian pubkey and to a secp256k1_pubkey, and
+ * checks that the results serialize and compare alike at every step. */
+#define N_TWEAKS 8
+void test_pubkey_jacobian_chain(void) {
+    unsigned char sk[32];
+    unsigned char tweak[32];
+    unsigned char ser1[65], ser2[65];
+    size_t len1, len2;
+    secp256k1_pubkey pk, pk2;
+    secp256k1_xonly_pubkey xonly_pk;
+    secp256k1_pubkey_jacobian pkj, pkj_start, pkj2;
+    secp256k1_scalar s;
+    int parity1, parity2;
+    int i, xonly;
+
+    secp256k1_testrand256(sk);
+    CHECK(secp256k1_ec_pubkey_create(ctx, &pk, sk) == 1);
+    xonly = secp256k1_testrand_bits(1);
+    if (xonly) {
+        /* The Taproot case: tweak the even-Y point of an x-only internal key. */
+        CHECK(secp256k1_xonly_pubkey_from_pubkey(ctx, &xonly_pk, NULL, &pk) == 1);
+        CHECK(secp256k1_pubkey_jacobian_from_xonly_pubkey(ctx, &pkj, &xonly_pk) == 1);
+    } else {
+        CHECK(secp256k1_pubkey_jacobian_from_pubkey(ctx, &pkj, &pk) == 1);
+    }
+    pkj_start = pkj;
+    for (i = 0; i < N_TWEAKS; i++) {
+        secp256k1_testrand256(tweak);
+        if (i == 0 && xonly) {
+            CHECK(secp256k1_xonly_pubkey_tweak_add(ctx, &pk, &xonly_pk, tweak) == 1);
+        } else {
+            CHECK(secp256k1_ec_pubkey_tweak_add(ctx, &pk, tweak) == 1);
+        }
+        CHECK(secp256k1_pubkey_jacobian_tweak_add(ctx, &pkj, tweak) == 1);
+
+        CHECK(secp256k1_pubkey_jacobian_get(ctx, &pk2, &pkj) == 1);
+        CHECK(secp256k1_memcmp_var(&pk, &pk2, sizeof(pk)) == 0);
+        len1 = len2 = 33;
+        CHECK(secp256k1_ec_pubkey_serialize(ctx, ser1, &len1, &pk, SECP256K1_EC_COMPRESSED) == 1);
+        CHECK(secp256k1_pubkey_jacobian_serialize(ctx, ser2, &len2, &pkj, SECP256K1_EC_COMPRESSED) == 1);
+        CHECK(len1 == 33 && len2 == 33);
+        CHECK(secp256k1_memcmp_var(ser1, ser2, 33) == 0);
+        len1 = len2 = 65;
+        CHECK(secp256k1_ec_pubkey_serialize(ctx, ser1, &len1, &pk, SECP256K1_EC_UNCOMPRESSED) == 1);
+        CHECK(secp256k1_pubkey_jacobian_serialize(ctx, ser2, &len2, &pkj, SECP256K1_EC_UNCOMPRESSED) == 1);
+        CHECK(len1 == 65 && len2 == 65);
+        CHECK(secp256k1_memcmp_var(ser1, ser2, 65) == 0);
+        CHECK(secp256k1_xonly_pubkey_from_pubkey(ctx, &xonly_pk, &parity1, &pk) == 1);
+        CHECK(secp256k1_xonly_pubkey_serialize(ctx, ser1, &xonly_pk) == 1);
+        CHECK(secp256k1_pubkey_jacobian_serialize_xonly(ctx, ser2, &parity2, &pkj) == 1);
+        CHECK(secp256k1_memcmp_var(ser1, ser2, 32) == 0);
+        CHECK(parity1 == parity2);
+
+        /* The affine copy holds the same point in a different representation. */
+        CHECK(secp256k1_pubkey_jacobian_from_pubkey(ctx, &pkj2, &pk) == 1);
+        CHECK(secp256k1_pubkey_jacobian_equal(ctx, &pkj, &pkj2) == 1);
+        CHECK(secp256k1_pubkey_jacobian_equal(ctx, &pkj2, &pkj) == 1);
+        CHECK(secp256k1_pubkey_jacobian_equal(ctx, &pkj, &pkj_start) == 0);
+        /* The negation has the same X but not the same Y. */
+        CHECK(secp256k1_ec_pubkey_negate(ctx, &pk2) == 1);
+        CHECK(secp256k1_pubkey_jacobian_from_pubkey(ctx, &pkj2, &pk2) == 1);
+        CHECK(secp256k1_pubkey_jacobian_equal(ctx, &pkj, &pkj2) == 0);
+    }
+
+    /* Fails if the result is infinity: G + 1*G + (-2)*G, where the first
+     * tweak leaves pkj in Jacobian coordinates. */
+    memset(tweak, 0, sizeof(tweak));
+    tweak[31] = 1;
+    CHECK(secp256k1_ec_pubkey_create(ctx, &pk, tweak) == 1);
+    CHECK(secp256k1_pubkey_jacobian_from_pubkey(ctx, &pkj, &pk) == 1);
+    CHECK(secp256k1_pubkey_jacobian_tweak_add(ctx, &pkj, tweak) == 1);
+    secp256k1_scalar_set_int(&s, 2);
+    secp256k1_scalar_negate(&s, &s);
+    secp256k1_scalar_get_b32(tweak, &s);
+    CHECK(secp256k1_pubkey_jacobian_tweak_add(ctx, &pkj, tweak) == 0);
+}
+#undef N_TWEAKS
+
 void run_extrakeys_tests(void) {
+    int i;
+
     /* xonly key test cases */
     test_xonly_pubkey();
     test_xonly_pubkey_tweak();
+    for (i = 0; i < count; i++) {
+        test_xonly_pubkey_tweak_add_batch();
+    }
     test_xonly_pubkey_tweak_check();
+    test_xonly_pubkey_tweak_check_tagged();
+    test_xonly_pubkey_tweak_check_batch();
     test_xonly_pubkey_tweak_recursive();
 
+    /* Jacobian pubkey tests */
+    test_pubkey_jacobian_api();
+    for (i = 0; i < count; i++) {
+        test_pubkey_jacobian_chain();
+    }
+
     /* keypair tests */
     test_keypair();
     test_keypair_add();
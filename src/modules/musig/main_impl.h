@@ -0,0 +1,809 @@
+/**********************************************************************
+ * Distributed under the MIT software license, see the accompanying   *
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
+ **********************************************************************/
+
+#ifndef SECP256K1_MODULE_MUSIG_MAIN_H
+#define SECP256K1_MODULE_MUSIG_MAIN_H
+
+#include "include/secp256k1.h"
+#include "include/secp256k1_musig.h"
+#include "hash.h"
+
+static const unsigned char secp256k1_musig_keyagg_cache_magic[4] = { 0xf4, 0xad, 0xbb, 0xdf };
+static const unsigned char secp256k1_musig_secnonce_magic[4] = { 0x22, 0x0e, 0xdc, 0xf1 };
+static const unsigned char secp256k1_musig_pubnonce_magic[4] = { 0xf5, 0x7a, 0x3d, 0xa0 };
+static const unsigned char secp256k1_musig_aggnonce_magic[4] = { 0xa8, 0xb7, 0xe4, 0x67 };
+static const unsigned char secp256k1_musig_session_magic[4] = { 0x9d, 0xed, 0xe9, 0x17 };
+static const unsigned char secp256k1_musig_partial_sig_magic[4] = { 0xeb, 0xfb, 0x1a, 0x32 };
+
+/* Initializes SHA256 with fixed midstate. This midstate was computed by applying
+ * SHA256 to SHA256("KeyAgg list")||SHA256("KeyAgg list"). */
+static void secp256k1_musig_keyagglist_sha256(secp256k1_sha256 *sha) {
+    secp256k1_sha256_initialize(sha);
+    sha->s[0] = 0xb399d5e0ul;
+    sha->s[1] = 0xc8fff302ul;
+    sha->s[2] = 0x6badac71ul;
+    sha->s[3] = 0x07c5b7f1ul;
+    sha->s[4] = 0x9701e2eful;
+    sha->s[5] = 0x2a72ecf8ul;
+    sha->s[6] = 0x201a4c7bul;
+    sha->s[7] = 0xab148a38ul;
+    sha->bytes = 64;
+}
+
+/* Initializes SHA256 with fixed midstate. This midstate was computed by applying
+ * SHA256 to SHA256("KeyAgg coefficient")||SHA256("KeyAgg coefficient"). */
+static void secp256k1_musig_keyaggcoef_sha256(secp256k1_sha256 *sha) {
+    secp256k1_sha256_initialize(sha);
+    sha->s[0] = 0x6ef02c5aul;
+    sha->s[1] = 0x06a480deul;
+    sha->s[2] = 0x1f298665ul;
+    sha->s[3] = 0x1d1134f2ul;
+    sha->s[4] = 0x56a0b063ul;
+    sha->s[5] = 0x52da4147ul;
+    sha->s[6] = 0xf280d9d4ul;
+    sha->s[7] = 0x4484be15ul;
+    sha->bytes = 64;
+}
+
+/* Initializes SHA256 with fixed midstate. This midstate was computed by applying
+ * SHA256 to SHA256("MuSig/noncecoef")||SHA256("MuSig/noncecoef"). */
+static void secp256k1_musig_noncecoef_sha256(secp256k1_sha256 *sha) {
+    secp256k1_sha256_initialize(sha);
+    sha->s[0] = 0x2c7d5a45ul;
+    sha->s[1] = 0x06bf7e53ul;
+    sha->s[2] = 0x89be68a6ul;
+    sha->s[3] = 0x971254c0ul;
+    sha->s[4] = 0x60ac12d2ul;
+    sha->s[5] = 0x72846dcdul;
+    sha->s[6] = 0x6c81212ful;
+    sha->s[7] = 0xde7a2500ul;
+    sha->bytes = 64;
+}
+
+/* Initializes SHA256 with fixed midstate. This midstate was computed by applying
+ * SHA256 to SHA256("MuSig/nonce")||SHA256("MuSig/nonce"). */
+static void secp256k1_musig_nonce_sha256(secp256k1_sha256 *sha) {
+    secp256k1_sha256_initialize(sha);
+    sha->s[0] = 0x07101b64ul;
+    sha->s[1] = 0x18003414ul;
+    sha->s[2] = 0x0391bc43ul;
+    sha->s[3] = 0x0e6258eeul;
+    sha->s[4] = 0x29d26b72ul;
+    sha->s[5] = 0x8343937eul;
+    sha->s[6] = 0xb7a0a4fbul;
+    sha->s[7] = 0xff568a30ul;
+    sha->bytes = 64;
+}
+
+/* Initializes SHA256 with fixed midstate. This midstate was computed by applying
+ * SHA256 to SHA256("MuSig/aux")||SHA256("MuSig/aux"). */
+static void secp256k1_musig_aux_sha256(secp256k1_sha256 *sha) {
+    secp256k1_sha256_initialize(sha);
+    sha->s[0] = 0xa19e884bul;
+    sha->s[1] = 0xf463fe7eul;
+    sha->s[2] = 0x2f18f9a2ul;
+    sha->s[3] = 0xbeb0f9fful;
+    sha->s[4] = 0x0f37e8b0ul;
+    sha->s[5] = 0x06ebd26ful;
+    sha->s[6] = 0xe3b243d2ul;
+    sha->s[7] = 0x522fb150ul;
+    sha->bytes = 64;
+}
+
+/* Saves a point that may be infinity into 64 bytes, which are all zero for infinity. */
+static void secp256k1_musig_ge_save_ext(unsigned char *data, secp256k1_ge *ge) {
+    if (secp256k1_ge_is_infinity(ge)) {
+        memset(data, 0, 64);
+    } else {
+        secp256k1_pubkey_save((secp256k1_pubkey *) data, ge);
+    }
+}
+
+static int secp256k1_musig_ge_load_ext(const secp256k1_context* ctx, secp256k1_ge *ge, const unsigned char *data) {
+    static const unsigned char zeros[64] = { 0 };
+    if (secp256k1_memcmp_var(data, zeros, sizeof(zeros)) == 0) {
+        secp256k1_ge_set_infinity(ge);
+        return 1;
+    }
+    return secp256k1_pubkey_load(ctx, ge, (const secp256k1_pubkey *) data);
+}
+
+/* Serializes a point that may be infinity into 33 bytes, which are all zero for infinity. */
+static void secp256k1_musig_ge_serialize_ext(unsigned char *out33, secp256k1_ge *ge) {
+    if (secp256k1_ge_is_infinity(ge)) {
+        memset(out33, 0, 33);
+    } else {
+        size_t size = 33;
+        int ret = secp256k1_eckey_pubkey_serialize(ge, out33, &size, 1);
+        VERIFY_CHECK(ret && size == 33);
+        (void)ret;
+    }
+}
+
+static int secp256k1_musig_ge_parse_ext(secp256k1_ge *ge, const unsigned char *in33) {
+    static const unsigned char zeros[33] = { 0 };
+    if (secp256k1_memcmp_var(in33, zeros, sizeof(zeros)) == 0) {
+        secp256k1_ge_set_infinity(ge);
+        return 1;
+    }
+    return secp256k1_eckey_pubkey_parse(ge, in33, 33);
+}
+
+/* keyagg_cache: magic[4] | Q[64] | pk_hash[32] | second_pk[33], where Q is the
+ * aggregate public key, pk_hash the hash of all public keys and second_pk the
+ * first public key that differs from the first one (all zero if there is none). */
+static void secp256k1_musig_keyagg_cache_save(secp256k1_musig_keyagg_cache *cache, secp256k1_ge *q, const unsigned char *pk_hash, const unsigned char *second_pk33) {
+    memcpy(&cache->data[0], secp256k1_musig_keyagg_cache_magic, 4);
+    secp256k1_pubkey_save((secp256k1_pubkey *) &cache->data[4], q);
+    memcpy(&cache->data[68], pk_hash, 32);
+    memcpy(&cache->data[100], second_pk33, 33);
+}
+
+static int secp256k1_musig_keyagg_cache_load(const secp256k1_context* ctx, secp256k1_ge *q, const unsigned char **pk_hash, const unsigned char **second_pk33, const secp256k1_musig_keyagg_cache *cache) {
+    ARG_CHECK(secp256k1_memcmp_var(&cache->data[0], secp256k1_musig_keyagg_cache_magic, 4) == 0);
+    *pk_hash = &cache->data[68];
+    *second_pk33 = &cache->data[100];
+    return secp256k1_pubkey_load(ctx, q, (const secp256k1_pubkey *) &cache->data[4]);
+}
+
+/* secnonce: magic[4] | k1[32] | k2[32] | pk[64] */
+static void secp256k1_musig_secnonce_save(secp256k1_musig_secnonce *secnonce, const secp256k1_scalar *k, secp256k1_ge *pk) {
+    memcpy(&secnonce->data[0], secp256k1_musig_secnonce_magic, 4);
+    secp256k1_scalar_get_b32(&secnonce->data[4], &k[0]);
+    secp256k1_scalar_get_b32(&secnonce->data[36], &k[1]);
+    secp256k1_pubkey_save((secp256k1_pubkey *) &secnonce->data[68], pk);
+}
+
+static int secp256k1_musig_secnonce_load(const secp256k1_context* ctx, secp256k1_scalar *k, secp256k1_ge *pk, const secp256k1_musig_secnonce *secnonce) {
+    int is_magic;
+
+    /* The magic is declassified because it is zeroed after a secnonce was
+     * used, which is checked here. */
+    is_magic = secp256k1_memcmp_var(&secnonce->data[0], secp256k1_musig_secnonce_magic, 4) == 0;
+    secp256k1_declassify(ctx, &is_magic, sizeof(is_magic));
+    ARG_CHECK(is_magic);
+    secp256k1_scalar_set_b32(&k[0], &secnonce->data[4], NULL);
+    secp256k1_scalar_set_b32(&k[1], &secnonce->data[36], NULL);
+    secp256k1_declassify(ctx, &secnonce->data[68], 64);
+    return secp256k1_pubkey_load(ctx, pk, (const secp256k1_pubkey *) &secnonce->data[68]);
+}
+
+/* pubnonce and aggnonce: magic[4] | R1[64] | R2[64] */
+static void secp256k1_musig_nonce_save(unsigned char *data, const unsigned char *magic, secp256k1_ge *r) {
+    memcpy(&data[0], magic, 4);
+    secp256k1_musig_ge_save_ext(&data[4], &r[0]);
+    secp256k1_musig_ge_save_ext(&data[68], &r[1]);
+}
+
+static int secp256k1_musig_pubnonce_load(const secp256k1_context* ctx, secp256k1_ge *r, const secp256k1_musig_pubnonce *nonce) {
+    ARG_CHECK(secp256k1_memcmp_var(&nonce->data[0], secp256k1_musig_pubnonce_magic, 4) == 0);
+    return secp256k1_pubkey_load(ctx, &r[0], (const secp256k1_pubkey *) &nonce->data[4])
+        && secp256k1_pubkey_load(ctx, &r[1], (const secp256k1_pubkey *) &nonce->data[68]);
+}
+
+static int secp256k1_musig_aggnonce_load(const secp256k1_context* ctx, secp256k1_ge *r, const secp256k1_musig_aggnonce *nonce) {
+    ARG_CHECK(secp256k1_memcmp_var(&nonce->data[0], secp256k1_musig_aggnonce_magic, 4) == 0);
+    return secp256k1_musig_ge_load_ext(ctx, &r[0], &nonce->data[4])
+        && secp256k1_musig_ge_load_ext(ctx, &r[1], &nonce->data[68]);
+}
+
+/* session: magic[4] | fin_nonce_parity[1] | fin_nonce_x[32] | b[32] | e[32] */
+typedef struct {
+    int fin_nonce_parity;
+    unsigned char fin_nonce_x[32];
+    secp256k1_scalar noncecoef;
+    secp256k1_scalar challenge;
+} secp256k1_musig_session_internal;
+
+static void secp256k1_musig_session_save(secp256k1_musig_session *session, const secp256k1_musig_session_internal *session_i) {
+    memcpy(&session->data[0], secp256k1_musig_session_magic, 4);
+    session->data[4] = session_i->fin_nonce_parity;
+    memcpy(&session->data[5], session_i->fin_nonce_x, 32);
+    secp256k1_scalar_get_b32(&session->data[37], &session_i->noncecoef);
+    secp256k1_scalar_get_b32(&session->data[69], &session_i->challenge);
+}
+
+static int secp256k1_musig_session_load(const secp256k1_context* ctx, secp256k1_musig_session_internal *session_i, const secp256k1_musig_session *session) {
+    ARG_CHECK(secp256k1_memcmp_var(&session->data[0], secp256k1_musig_session_magic, 4) == 0);
+    session_i->fin_nonce_parity = session->data[4];
+    memcpy(session_i->fin_nonce_x, &session->data[5], 32);
+    secp256k1_scalar_set_b32(&session_i->noncecoef, &session->data[37], NULL);
+    secp256k1_scalar_set_b32(&session_i->challenge, &session->data[69], NULL);
+    return 1;
+}
+
+/* partial_sig: magic[4] | s[32] */
+static void secp256k1_musig_partial_sig_save(secp256k1_musig_partial_sig *sig, const secp256k1_scalar *s) {
+    memcpy(&sig->data[0], secp256k1_musig_partial_sig_magic, 4);
+    secp256k1_scalar_get_b32(&sig->data[4], s);
+}
+
+static int secp256k1_musig_partial_sig_load(const secp256k1_context* ctx, secp256k1_scalar *s, const secp256k1_musig_partial_sig *sig) {
+    int overflow;
+
+    ARG_CHECK(secp256k1_memcmp_var(&sig->data[0], secp256k1_musig_partial_sig_magic, 4) == 0);
+    secp256k1_scalar_set_b32(s, &sig->data[4], &overflow);
+    /* Parsing checks the overflow, so a saved partial signature never overflows. */
+    VERIFY_CHECK(!overflow);
+    return 1;
+}
+
+int secp256k1_musig_pubnonce_parse(const secp256k1_context* ctx, secp256k1_musig_pubnonce* nonce, const unsigned char *in66) {
+    secp256k1_ge r[2];
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(nonce != NULL);
+    memset(nonce, 0, sizeof(*nonce));
+    ARG_CHECK(in66 != NULL);
+
+    if (!secp256k1_eckey_pubkey_parse(&r[0], &in66[0], 33)
+        || !secp256k1_eckey_pubkey_parse(&r[1], &in66[33], 33)) {
+        return 0;
+    }
+    secp256k1_musig_nonce_save(nonce->data, secp256k1_musig_pubnonce_magic, r);
+    return 1;
+}
+
+int secp256k1_musig_pubnonce_serialize(const secp256k1_context* ctx, unsigned char *out66, const secp256k1_musig_pubnonce* nonce) {
+    secp256k1_ge r[2];
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(out66 != NULL);
+    memset(out66, 0, 66);
+    ARG_CHECK(nonce != NULL);
+
+    if (!secp256k1_musig_pubnonce_load(ctx, r, nonce)) {
+        return 0;
+    }
+    secp256k1_musig_ge_serialize_ext(&out66[0], &r[0]);
+    secp256k1_musig_ge_serialize_ext(&out66[33], &r[1]);
+    return 1;
+}
+
+int secp256k1_musig_aggnonce_parse(const secp256k1_context* ctx, secp256k1_musig_aggnonce* nonce, const unsigned char *in66) {
+    secp256k1_ge r[2];
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(nonce != NULL);
+    memset(nonce, 0, sizeof(*nonce));
+    ARG_CHECK(in66 != NULL);
+
+    if (!secp256k1_musig_ge_parse_ext(&r[0], &in66[0])
+        || !secp256k1_musig_ge_parse_ext(&r[1], &in66[33])) {
+        return 0;
+    }
+    secp256k1_musig_nonce_save(nonce->data, secp256k1_musig_aggnonce_magic, r);
+    return 1;
+}
+
+int secp256k1_musig_aggnonce_serialize(const secp256k1_context* ctx, unsigned char *out66, const secp256k1_musig_aggnonce* nonce) {
+    secp256k1_ge r[2];
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(out66 != NULL);
+    memset(out66, 0, 66);
+    ARG_CHECK(nonce != NULL);
+
+    if (!secp256k1_musig_aggnonce_load(ctx, r, nonce)) {
+        return 0;
+    }
+    secp256k1_musig_ge_serialize_ext(&out66[0], &r[0]);
+    secp256k1_musig_ge_serialize_ext(&out66[33], &r[1]);
+    return 1;
+}
+
+int secp256k1_musig_partial_sig_parse(const secp256k1_context* ctx, secp256k1_musig_partial_sig* sig, const unsigned char *in32) {
+    secp256k1_scalar s;
+    int overflow;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(sig != NULL);
+    memset(sig, 0, sizeof(*sig));
+    ARG_CHECK(in32 != NULL);
+
+    secp256k1_scalar_set_b32(&s, in32, &overflow);
+    if (overflow) {
+        return 0;
+    }
+    secp256k1_musig_partial_sig_save(sig, &s);
+    return 1;
+}
+
+int secp256k1_musig_partial_sig_serialize(const secp256k1_context* ctx, unsigned char *out32, const secp256k1_musig_partial_sig* sig) {
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(out32 != NULL);
+    ARG_CHECK(sig != NULL);
+    ARG_CHECK(secp256k1_memcmp_var(&sig->data[0], secp256k1_musig_partial_sig_magic, 4) == 0);
+
+    memcpy(out32, &sig->data[4], 32);
+    return 1;
+}
+
+/* Computes the key aggregation coefficient of a public key. The coefficient of
+ * the second distinct public key is 1, which saves a hash and makes the
+ * scalar multiplication by it free. */
+static void secp256k1_musig_keyaggcoef(secp256k1_scalar *r, const unsigned char *pk_hash, const unsigned char *pk33, const unsigned char *second_pk33) {
+    secp256k1_sha256 sha;
+    unsigned char buf[32];
+
+    if (secp256k1_memcmp_var(pk33, second_pk33, 33) == 0) {
+        secp256k1_scalar_set_int(r, 1);
+        return;
+    }
+    secp256k1_musig_keyaggcoef_sha256(&sha);
+    secp256k1_sha256_write(&sha, pk_hash, 32);
+    secp256k1_sha256_write(&sha, pk33, 33);
+    secp256k1_sha256_finalize(&sha, buf);
+    secp256k1_scalar_set_b32(r, buf, NULL);
+}
+
+typedef struct {
+    const secp256k1_context *ctx;
+    const secp256k1_pubkey * const* pubkeys;
+    unsigned char pk_hash[32];
+    unsigned char second_pk33[33];
+} secp256k1_musig_pubkey_agg_ecmult_data;
+
+/* Provides the (coefficient, public key) pairs of the key aggregation to ecmult_multi. */
+static int secp256k1_musig_pubkey_agg_callback(secp256k1_scalar *sc, secp256k1_ge *pt, size_t idx, void *data) {
+    secp256k1_musig_pubkey_agg_ecmult_data *ecmult_data = (secp256k1_musig_pubkey_agg_ecmult_data *) data;
+    unsigned char pk33[33];
+    size_t size = sizeof(pk33);
+
+    if (!secp256k1_pubkey_load(ecmult_data->ctx, pt, ecmult_data->pubkeys[idx])
+        || !secp256k1_eckey_pubkey_serialize(pt, pk33, &size, 1)) {
+        return 0;
+    }
+    secp256k1_musig_keyaggcoef(sc, ecmult_data->pk_hash, pk33, ecmult_data->second_pk33);
+    return 1;
+}
+
+int secp256k1_musig_pubkey_agg(const secp256k1_context* ctx, secp256k1_scratch_space *scratch, secp256k1_xonly_pubkey *agg_pk, secp256k1_musig_keyagg_cache *keyagg_cache, const secp256k1_pubkey * const* pubkeys, size_t n_pubkeys) {
+    secp256k1_musig_pubkey_agg_ecmult_data ecmult_data;
+    secp256k1_sha256 sha;
+    unsigned char first_pk33[33];
+    secp256k1_gej qj;
+    secp256k1_ge q;
+    size_t i;
+
+    VERIFY_CHECK(ctx != NULL);
+    if (agg_pk != NULL) {
+        memset(agg_pk, 0, sizeof(*agg_pk));
+    }
+    if (keyagg_cache != NULL) {
+        memset(keyagg_cache, 0, sizeof(*keyagg_cache));
+    }
+    ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(pubkeys != NULL);
+    ARG_CHECK(n_pubkeys > 0);
+
+    /* Hash the list of public keys and find the second distinct one */
+    memset(ecmult_data.second_pk33, 0, sizeof(ecmult_data.second_pk33));
+    secp256k1_musig_keyagglist_sha256(&sha);
+    for (i = 0; i < n_pubkeys; i++) {
+        secp256k1_ge pk;
+        unsigned char pk33[33];
+        size_t size = sizeof(pk33);
+
+        ARG_CHECK(pubkeys[i] != NULL);
+        if (!secp256k1_pubkey_load(ctx, &pk, pubkeys[i])
+            || !secp256k1_eckey_pubkey_serialize(&pk, pk33, &size, 1)) {
+            return 0;
+        }
+        secp256k1_sha256_write(&sha, pk33, sizeof(pk33));
+        if (i == 0) {
+            memcpy(first_pk33, pk33, sizeof(pk33));
+        } else if (ecmult_data.second_pk33[0] == 0 && secp256k1_memcmp_var(pk33, first_pk33, sizeof(pk33)) != 0) {
+            memcpy(ecmult_data.second_pk33, pk33, sizeof(pk33));
+        }
+    }
+    secp256k1_sha256_finalize(&sha, ecmult_data.pk_hash);
+    ecmult_data.ctx = ctx;
+    ecmult_data.pubkeys = pubkeys;
+
+    if (scratch != NULL) {
+        if (!secp256k1_ecmult_multi_var(&ctx->error_callback, &ctx->ecmult_ctx, scratch, &qj, NULL, secp256k1_musig_pubkey_agg_callback, (void *) &ecmult_data, n_pubkeys)) {
+            return 0;
+        }
+    } else {
+        /* Without a scratch space, multiply batches of keys on the stack. */
+        secp256k1_gej pkj[ECMULT_SMALL_MAX_POINTS];
+        secp256k1_scalar coef[ECMULT_SMALL_MAX_POINTS];
+        secp256k1_gej tmpj;
+        size_t j, batch;
+
+        secp256k1_gej_set_infinity(&qj);
+        for (i = 0; i < n_pubkeys; i += batch) {
+            batch = n_pubkeys - i < ECMULT_SMALL_MAX_POINTS ? n_pubkeys - i : ECMULT_SMALL_MAX_POINTS;
+            for (j = 0; j < batch; j++) {
+                secp256k1_ge pk;
+                if (!secp256k1_musig_pubkey_agg_callback(&coef[j], &pk, i + j, (void *) &ecmult_data)) {
+                    return 0;
+                }
+                secp256k1_gej_set_ge(&pkj[j], &pk);
+            }
+            secp256k1_ecmult_small(&ctx->ecmult_ctx, &tmpj, pkj, coef, batch, NULL);
+            secp256k1_gej_add_var(&qj, &qj, &tmpj, NULL);
+        }
+    }
+    if (secp256k1_gej_is_infinity(&qj)) {
+        return 0;
+    }
+    secp256k1_ge_set_gej_var(&q, &qj);
+    secp256k1_fe_normalize_var(&q.x);
+    secp256k1_fe_normalize_var(&q.y);
+
+    if (keyagg_cache != NULL) {
+        secp256k1_musig_keyagg_cache_save(keyagg_cache, &q, ecmult_data.pk_hash, ecmult_data.second_pk33);
+    }
+    if (agg_pk != NULL) {
+        secp256k1_extrakeys_ge_even_y(&q);
+        secp256k1_xonly_pubkey_save(agg_pk, &q);
+    }
+    return 1;
+}
+
+int secp256k1_musig_pubkey_get(const secp256k1_context* ctx, secp256k1_pubkey *agg_pk, const secp256k1_musig_keyagg_cache *keyagg_cache) {
+    secp256k1_ge q;
+    const unsigned char *pk_hash, *second_pk33;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(agg_pk != NULL);
+    memset(agg_pk, 0, sizeof(*agg_pk));
+    ARG_CHECK(keyagg_cache != NULL);
+
+    if (!secp256k1_musig_keyagg_cache_load(ctx, &q, &pk_hash, &second_pk33, keyagg_cache)) {
+        return 0;
+    }
+    secp256k1_pubkey_save(agg_pk, &q);
+    return 1;
+}
+
+/* Derives the two secret nonces as specified by BIP-327's NonceGen. */
+static void secp256k1_musig_nonce_function(secp256k1_scalar *k, const unsigned char *session_id32, const unsigned char *seckey32, const unsigned char *pk33, const unsigned char *agg_pk32, const unsigned char *msg32, const unsigned char *extra_input32) {
+    secp256k1_sha256 sha;
+    unsigned char rand[32];
+    unsigned char buf[32];
+    unsigned char i;
+    int j;
+
+    if (seckey32 != NULL) {
+        secp256k1_musig_aux_sha256(&sha);
+        secp256k1_sha256_write(&sha, session_id32, 32);
+        secp256k1_sha256_finalize(&sha, rand);
+        for (j = 0; j < 32; j++) {
+            rand[j] ^= seckey32[j];
+        }
+    } else {
+        memcpy(rand, session_id32, 32);
+    }
+
+    for (i = 0; i < 2; i++) {
+        static const unsigned char len33 = 33, len32 = 32, len0 = 0, present = 1;
+        static const unsigned char msg_len[8] = { 0, 0, 0, 0, 0, 0, 0, 32 };
+        static const unsigned char extra_len[4] = { 0, 0, 0, 32 };
+        static const unsigned char no_extra_len[4] = { 0, 0, 0, 0 };
+
+        secp256k1_musig_nonce_sha256(&sha);
+        secp256k1_sha256_write(&sha, rand, 32);
+        secp256k1_sha256_write(&sha, &len33, 1);
+        secp256k1_sha256_write(&sha, pk33, 33);
+        if (agg_pk32 != NULL) {
+            secp256k1_sha256_write(&sha, &len32, 1);
+            secp256k1_sha256_write(&sha, agg_pk32, 32);
+        } else {
+            secp256k1_sha256_write(&sha, &len0, 1);
+        }
+        if (msg32 != NULL) {
+            secp256k1_sha256_write(&sha, &present, 1);
+            secp256k1_sha256_write(&sha, msg_len, sizeof(msg_len));
+            secp256k1_sha256_write(&sha, msg32, 32);
+        } else {
+            secp256k1_sha256_write(&sha, &len0, 1);
+        }
+        if (extra_input32 != NULL) {
+            secp256k1_sha256_write(&sha, extra_len, sizeof(extra_len));
+            secp256k1_sha256_write(&sha, extra_input32, 32);
+        } else {
+            secp256k1_sha256_write(&sha, no_extra_len, sizeof(no_extra_len));
+        }
+        secp256k1_sha256_write(&sha, &i, 1);
+        secp256k1_sha256_finalize(&sha, buf);
+        secp256k1_scalar_set_b32(&k[i], buf, NULL);
+    }
+    memset(rand, 0, sizeof(rand));
+    memset(buf, 0, sizeof(buf));
+}
+
+int secp256k1_musig_nonce_gen(const secp256k1_context* ctx, secp256k1_musig_secnonce *secnonce, secp256k1_musig_pubnonce *pubnonce, const unsigned char *session_id32, const unsigned char *seckey, const secp256k1_pubkey *pubkey, const unsigned char *msg32, const secp256k1_musig_keyagg_cache *keyagg_cache, const unsigned char *extra_input32) {
+    secp256k1_scalar k[2];
+    secp256k1_gej rj;
+    secp256k1_ge r[2];
+    secp256k1_ge pk;
+    unsigned char pk33[33];
+    unsigned char agg_pk32[32];
+    size_t size = sizeof(pk33);
+    int i;
+    int ret = 1;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(secnonce != NULL);
+    memset(secnonce, 0, sizeof(*secnonce));
+    ARG_CHECK(pubnonce != NULL);
+    memset(pubnonce, 0, sizeof(*pubnonce));
+    ARG_CHECK(session_id32 != NULL);
+    ARG_CHECK(pubkey != NULL);
+    ARG_CHECK(secp256k1_ecmult_gen_context_is_built(&ctx->ecmult_gen_ctx));
+
+    if (!secp256k1_pubkey_load(ctx, &pk, pubkey)
+        || !secp256k1_eckey_pubkey_serialize(&pk, pk33, &size, 1)) {
+        return 0;
+    }
+    if (keyagg_cache != NULL) {
+        secp256k1_ge q;
+        const unsigned char *pk_hash, *second_pk33;
+        if (!secp256k1_musig_keyagg_cache_load(ctx, &q, &pk_hash, &second_pk33, keyagg_cache)) {
+            return 0;
+        }
+        secp256k1_fe_get_b32(agg_pk32, &q.x);
+    }
+
+    secp256k1_musig_nonce_function(k, session_id32, seckey, pk33, keyagg_cache != NULL ? agg_pk32 : NULL, msg32, extra_input32);
+    for (i = 0; i < 2; i++) {
+        ret &= !secp256k1_scalar_is_zero(&k[i]);
+    }
+    /* A zero nonce only occurs with negligible probability, so revealing it
+     * is fine. */
+    secp256k1_declassify(ctx, &ret, sizeof(ret));
+    if (!ret) {
+        secp256k1_scalar_clear(&k[0]);
+        secp256k1_scalar_clear(&k[1]);
+        return 0;
+    }
+
+    for (i = 0; i < 2; i++) {
+        secp256k1_ecmult_gen(&ctx->ecmult_gen_ctx, &rj, &k[i]);
+        secp256k1_ge_set_gej(&r[i], &rj);
+        /* The public nonce is not secret. */
+        secp256k1_declassify(ctx, &r[i], sizeof(r[i]));
+    }
+    secp256k1_musig_secnonce_save(secnonce, k, &pk);
+    secp256k1_musig_nonce_save(pubnonce->data, secp256k1_musig_pubnonce_magic, r);
+    secp256k1_scalar_clear(&k[0]);
+    secp256k1_scalar_clear(&k[1]);
+    return 1;
+}
+
+int secp256k1_musig_nonce_agg(const secp256k1_context* ctx, secp256k1_musig_aggnonce *aggnonce, const secp256k1_musig_pubnonce * const* pubnonces, size_t n_pubnonces) {
+    secp256k1_gej rj[2];
+    secp256k1_ge r[2];
+    size_t i;
+    int j;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(aggnonce != NULL);
+    memset(aggnonce, 0, sizeof(*aggnonce));
+    ARG_CHECK(pubnonces != NULL);
+    ARG_CHECK(n_pubnonces > 0);
+
+    secp256k1_gej_set_infinity(&rj[0]);
+    secp256k1_gej_set_infinity(&rj[1]);
+    for (i = 0; i < n_pubnonces; i++) {
+        ARG_CHECK(pubnonces[i] != NULL);
+        if (!secp256k1_musig_pubnonce_load(ctx, r, pubnonces[i])) {
+            return 0;
+        }
+        for (j = 0; j < 2; j++) {
+            secp256k1_gej_add_ge_var(&rj[j], &rj[j], &r[j], NULL);
+        }
+    }
+    /* Both sums share one inversion. secp256k1_ge_set_all_gej_var leaves r
+     * untouched if both are infinity. */
+    secp256k1_ge_set_infinity(&r[0]);
+    secp256k1_ge_set_infinity(&r[1]);
+    secp256k1_ge_set_all_gej_var(r, rj, 2);
+    secp256k1_musig_nonce_save(aggnonce->data, secp256k1_musig_aggnonce_magic, r);
+    return 1;
+}
+
+int secp256k1_musig_nonce_process(const secp256k1_context* ctx, secp256k1_musig_session *session, const secp256k1_musig_aggnonce *aggnonce, const unsigned char *msg32, const secp256k1_musig_keyagg_cache *keyagg_cache) {
+    secp256k1_musig_session_internal session_i;
+    secp256k1_sha256 sha;
+    secp256k1_ge aggr[2];
+    secp256k1_ge q, r;
+    secp256k1_gej rj;
+    const unsigned char *pk_hash, *second_pk33;
+    unsigned char buf[66];
+    unsigned char qx[32];
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(session != NULL);
+    memset(session, 0, sizeof(*session));
+    ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(aggnonce != NULL);
+    ARG_CHECK(msg32 != NULL);
+    ARG_CHECK(keyagg_cache != NULL);
+
+    if (!secp256k1_musig_aggnonce_load(ctx, aggr, aggnonce)
+        || !secp256k1_musig_keyagg_cache_load(ctx, &q, &pk_hash, &second_pk33, keyagg_cache)) {
+        return 0;
+    }
+    secp256k1_fe_get_b32(qx, &q.x);
+
+    /* b = hash(aggnonce, Q.x, msg) */
+    secp256k1_musig_ge_serialize_ext(&buf[0], &aggr[0]);
+    secp256k1_musig_ge_serialize_ext(&buf[33], &aggr[1]);
+    secp256k1_musig_noncecoef_sha256(&sha);
+    secp256k1_sha256_write(&sha, buf, sizeof(buf));
+    secp256k1_sha256_write(&sha, qx, sizeof(qx));
+    secp256k1_sha256_write(&sha, msg32, 32);
+    secp256k1_sha256_finalize(&sha, buf);
+    secp256k1_scalar_set_b32(&session_i.noncecoef, buf, NULL);
+
+    /* R = R1 + b*R2, or G if that is infinity */
+    secp256k1_gej_set_ge(&rj, &aggr[1]);
+    secp256k1_ecmult(&ctx->ecmult_ctx, &rj, &rj, &session_i.noncecoef, NULL);
+    secp256k1_gej_add_ge_var(&rj, &rj, &aggr[0], NULL);
+    if (secp256k1_gej_is_infinity(&rj)) {
+        r = secp256k1_ge_const_g;
+    } else {
+        secp256k1_ge_set_gej_var(&r, &rj);
+    }
+    secp256k1_fe_normalize_var(&r.x);
+    secp256k1_fe_normalize_var(&r.y);
+    session_i.fin_nonce_parity = secp256k1_fe_is_odd(&r.y);
+    secp256k1_fe_get_b32(session_i.fin_nonce_x, &r.x);
+
+    secp256k1_schnorrsig_challenge(&session_i.challenge, session_i.fin_nonce_x, msg32, qx);
+    secp256k1_musig_session_save(session, &session_i);
+    return 1;
+}
+
+int secp256k1_musig_partial_sign(const secp256k1_context* ctx, secp256k1_musig_partial_sig *partial_sig, secp256k1_musig_secnonce *secnonce, const secp256k1_keypair *keypair, const secp256k1_musig_keyagg_cache *keyagg_cache, const secp256k1_musig_session *session) {
+    secp256k1_musig_session_internal session_i;
+    secp256k1_scalar k[2];
+    secp256k1_scalar sk, s, a;
+    secp256k1_ge pk, keypair_pk, q;
+    const unsigned char *pk_hash, *second_pk33;
+    unsigned char pk33[33];
+    size_t size = sizeof(pk33);
+    int ret;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(partial_sig != NULL);
+    memset(partial_sig, 0, sizeof(*partial_sig));
+    ARG_CHECK(secnonce != NULL);
+    /* Overwrite the secnonce right away so that it cannot be used twice, even
+     * if signing fails. */
+    ret = secp256k1_musig_secnonce_load(ctx, k, &pk, secnonce);
+    memset(secnonce, 0, sizeof(*secnonce));
+    if (!ret) {
+        secp256k1_scalar_clear(&k[0]);
+        secp256k1_scalar_clear(&k[1]);
+        return 0;
+    }
+    ARG_CHECK(keypair != NULL);
+    ARG_CHECK(keyagg_cache != NULL);
+    ARG_CHECK(session != NULL);
+
+    ret = secp256k1_keypair_load(ctx, &sk, &keypair_pk, keypair)
+        && secp256k1_fe_equal_var(&pk.x, &keypair_pk.x)
+        && secp256k1_fe_equal_var(&pk.y, &keypair_pk.y)
+        && secp256k1_musig_keyagg_cache_load(ctx, &q, &pk_hash, &second_pk33, keyagg_cache)
+        && secp256k1_musig_session_load(ctx, &session_i, session);
+    if (!ret) {
+        secp256k1_scalar_clear(&k[0]);
+        secp256k1_scalar_clear(&k[1]);
+        secp256k1_scalar_clear(&sk);
+        return 0;
+    }
+
+    /* The signature is for the x-only aggregate key, so the secret key is
+     * negated if the aggregate key has an odd Y. */
+    if (secp256k1_fe_is_odd(&q.y)) {
+        secp256k1_scalar_negate(&sk, &sk);
+    }
+    /* Likewise, the nonces are negated if the final nonce has an odd Y. */
+    if (session_i.fin_nonce_parity) {
+        secp256k1_scalar_negate(&k[0], &k[0]);
+        secp256k1_scalar_negate(&k[1], &k[1]);
+    }
+
+    /* s = k1 + b*k2 + e*a*sk */
+    secp256k1_eckey_pubkey_serialize(&pk, pk33, &size, 1);
+    secp256k1_musig_keyaggcoef(&a, pk_hash, pk33, second_pk33);
+    secp256k1_scalar_mul(&a, &a, &session_i.challenge);
+    secp256k1_scalar_mul(&s, &a, &sk);
+    secp256k1_scalar_mul(&k[1], &k[1], &session_i.noncecoef);
+    secp256k1_scalar_add(&s, &s, &k[1]);
+    secp256k1_scalar_add(&s, &s, &k[0]);
+    secp256k1_musig_partial_sig_save(partial_sig, &s);
+
+    secp256k1_scalar_clear(&k[0]);
+    secp256k1_scalar_clear(&k[1]);
+    secp256k1_scalar_clear(&sk);
+    secp256k1_scalar_clear(&s);
+    return 1;
+}
+
+int secp256k1_musig_partial_sig_verify(const secp256k1_context* ctx, const secp256k1_musig_partial_sig *partial_sig, const secp256k1_musig_pubnonce *pubnonce, const secp256k1_pubkey *pubkey, const secp256k1_musig_keyagg_cache *keyagg_cache, const secp256k1_musig_session *session) {
+    secp256k1_musig_session_internal session_i;
+    secp256k1_scalar s, a, b;
+    secp256k1_ge r[2];
+    secp256k1_ge pk, q;
+    secp256k1_gej r2j, pkj, tmpj;
+    const unsigned char *pk_hash, *second_pk33;
+    unsigned char pk33[33];
+    size_t size = sizeof(pk33);
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(partial_sig != NULL);
+    ARG_CHECK(pubnonce != NULL);
+    ARG_CHECK(pubkey != NULL);
+    ARG_CHECK(keyagg_cache != NULL);
+    ARG_CHECK(session != NULL);
+
+    if (!secp256k1_musig_partial_sig_load(ctx, &s, partial_sig)
+        || !secp256k1_musig_pubnonce_load(ctx, r, pubnonce)
+        || !secp256k1_pubkey_load(ctx, &pk, pubkey)
+        || !secp256k1_musig_keyagg_cache_load(ctx, &q, &pk_hash, &second_pk33, keyagg_cache)
+        || !secp256k1_musig_session_load(ctx, &session_i, session)) {
+        return 0;
+    }
+
+    /* Check s*G == Re + e*a*g*P with one multi-multiplication, where
+     * Re = R1 + b*R2, negated if the final nonce has an odd Y, and g is -1
+     * if the aggregate key has an odd Y and 1 otherwise. With the sign of
+     * the nonce moved to the right, this is
+     * s*G - (+-b)*R2 - e*a*g*P == +-R1. */
+    if (!secp256k1_eckey_pubkey_serialize(&pk, pk33, &size, 1)) {
+        return 0;
+    }
+    secp256k1_musig_keyaggcoef(&a, pk_hash, pk33, second_pk33);
+    secp256k1_scalar_mul(&a, &a, &session_i.challenge);
+    if (!secp256k1_fe_is_odd(&q.y)) {
+        secp256k1_scalar_negate(&a, &a);
+    }
+    b = session_i.noncecoef;
+    if (!session_i.fin_nonce_parity) {
+        secp256k1_scalar_negate(&b, &b);
+        secp256k1_ge_neg(&r[0], &r[0]);
+    }
+    secp256k1_gej_set_ge(&r2j, &r[1]);
+    secp256k1_gej_set_ge(&pkj, &pk);
+    secp256k1_ecmult_3(&ctx->ecmult_ctx, &tmpj, &r2j, &b, &pkj, &a, &s);
+    /* r[0] holds -(+-R1) */
+    secp256k1_gej_add_ge_var(&tmpj, &tmpj, &r[0], NULL);
+    return secp256k1_gej_is_infinity(&tmpj);
+}
+
+int secp256k1_musig_partial_sig_agg(const secp256k1_context* ctx, unsigned char *sig64, const secp256k1_musig_session *session, const secp256k1_musig_partial_sig * const* partial_sigs, size_t n_sigs) {
+    secp256k1_musig_session_internal session_i;
+    secp256k1_scalar s, term;
+    size_t i;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(sig64 != NULL);
+    ARG_CHECK(session != NULL);
+    ARG_CHECK(partial_sigs != NULL);
+
+    if (!secp256k1_musig_session_load(ctx, &session_i, session)) {
+        return 0;
+    }
+    secp256k1_scalar_set_int(&s, 0);
+    for (i = 0; i < n_sigs; i++) {
+        ARG_CHECK(partial_sigs[i] != NULL);
+        if (!secp256k1_musig_partial_sig_load(ctx, &term, partial_sigs[i])) {
+            return 0;
+        }
+        secp256k1_scalar_add(&s, &s, &term);
+    }
+    memcpy(&sig64[0], session_i.fin_nonce_x, 32);
+    secp256k1_scalar_get_b32(&sig64[32], &s);
+    return 1;
+}
+
+#endif /* SECP256K1_MODULE_MUSIG_MAIN_H */
@@ -0,0 +1,362 @@
+/**********************************************************************
+ * Distributed under the MIT software license, see the accompanying   *
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
+ **********************************************************************/
+
+#ifndef SECP256K1_MODULE_MUSIG_TESTS_H
+#define SECP256K1_MODULE_MUSIG_TESTS_H
+
+#include "include/secp256k1_musig.h"
+
+#define MUSIG_TEST_MAX_SIGNERS 5
+
+/* Checks that the hardcoded midstates match the tagged hashes. */
+void musig_test_sha256_tagged(void) {
+    static const char *tags[] = { "KeyAgg list", "KeyAgg coefficient", "MuSig/noncecoef", "MuSig/nonce", "MuSig/aux" };
+    void (*fns[])(secp256k1_sha256 *) = { secp256k1_musig_keyagglist_sha256, secp256k1_musig_keyaggcoef_sha256, secp256k1_musig_noncecoef_sha256, secp256k1_musig_nonce_sha256, secp256k1_musig_aux_sha256 };
+    secp256k1_sha256 sha, sha_optimized;
+    size_t i;
+
+    for (i = 0; i < sizeof(tags) / sizeof(tags[0]); i++) {
+        secp256k1_sha256_initialize_tagged(&sha, (const unsigned char *) tags[i], strlen(tags[i]));
+        fns[i](&sha_optimized);
+        test_sha256_eq(&sha, &sha_optimized);
+    }
+}
+
+/* Computes the aggregate key term by term with secp256k1_ecmult. */
+static void musig_test_pubkey_agg_naive(secp256k1_ge *q, const secp256k1_pubkey * const* pubkeys, size_t n) {
+    unsigned char pk33[MUSIG_TEST_MAX_SIGNERS * 8][33];
+    unsigned char second_pk33[33] = { 0 };
+    unsigned char pk_hash[32];
+    secp256k1_sha256 sha;
+    secp256k1_gej qj, tmpj;
+    secp256k1_ge pk;
+    secp256k1_scalar a;
+    size_t i, size;
+
+    CHECK(n <= MUSIG_TEST_MAX_SIGNERS * 8);
+    secp256k1_sha256_initialize_tagged(&sha, (const unsigned char *) "KeyAgg list", 11);
+    for (i = 0; i < n; i++) {
+        size = 33;
+        CHECK(secp256k1_ec_pubkey_serialize(ctx, pk33[i], &size, pubkeys[i], SECP256K1_EC_COMPRESSED));
+        secp256k1_sha256_write(&sha, pk33[i], 33);
+        if (second_pk33[0] == 0 && secp256k1_memcmp_var(pk33[i], pk33[0], 33) != 0) {
+            memcpy(second_pk33, pk33[i], 33);
+        }
+    }
+    secp256k1_sha256_finalize(&sha, pk_hash);
+
+    secp256k1_gej_set_infinity(&qj);
+    for (i = 0; i < n; i++) {
+        if (secp256k1_memcmp_var(pk33[i], second_pk33, 33) == 0) {
+            secp256k1_scalar_set_int(&a, 1);
+        } else {
+            unsigned char buf[32];
+            secp256k1_sha256_initialize_tagged(&sha, (const unsigned char *) "KeyAgg coefficient", 18);
+            secp256k1_sha256_write(&sha, pk_hash, 32);
+            secp256k1_sha256_write(&sha, pk33[i], 33);
+            secp256k1_sha256_finalize(&sha, buf);
+            secp256k1_scalar_set_b32(&a, buf, NULL);
+        }
+        CHECK(secp256k1_pubkey_load(ctx, &pk, pubkeys[i]));
+        secp256k1_gej_set_ge(&tmpj, &pk);
+        secp256k1_ecmult(&ctx->ecmult_ctx, &tmpj, &tmpj, &a, NULL);
+        secp256k1_gej_add_var(&qj, &qj, &tmpj, NULL);
+    }
+    CHECK(!secp256k1_gej_is_infinity(&qj));
+    secp256k1_ge_set_gej(q, &qj);
+    secp256k1_fe_normalize_var(&q->x);
+    secp256k1_fe_normalize_var(&q->y);
+}
+
+void musig_test_pubkey_agg(void) {
+    secp256k1_pubkey pubkeys[MUSIG_TEST_MAX_SIGNERS * 8];
+    const secp256k1_pubkey *pubkey_ptrs[MUSIG_TEST_MAX_SIGNERS * 8];
+    secp256k1_xonly_pubkey agg_pk, agg_pk_scratch;
+    secp256k1_musig_keyagg_cache cache, cache_scratch;
+    secp256k1_pubkey full_pk;
+    secp256k1_ge q, expected;
+    secp256k1_scratch_space *scratch_space = secp256k1_scratch_space_create(ctx, 1024 * 1024);
+    size_t sizes[] = { 1, 2, 3, ECMULT_SMALL_MAX_POINTS + 1, MUSIG_TEST_MAX_SIGNERS * 8 };
+    size_t i, j, k;
+
+    for (i = 0; i < MUSIG_TEST_MAX_SIGNERS * 8; i++) {
+        unsigned char sk[32];
+        secp256k1_testrand256(sk);
+        CHECK(secp256k1_ec_pubkey_create(ctx, &pubkeys[i], sk));
+        pubkey_ptrs[i] = &pubkeys[i];
+    }
+
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        for (j = 0; j < 3; j++) {
+            size_t n = sizes[i];
+            if (j == 1) {
+                /* Repeat the first key, so that the second distinct key is
+                 * found later in the list. */
+                pubkey_ptrs[n / 2] = &pubkeys[0];
+            } else if (j == 2) {
+                /* All keys are equal, there is no second distinct key. */
+                for (k = 0; k < n; k++) {
+                    pubkey_ptrs[k] = &pubkeys[0];
+                }
+            }
+            CHECK(secp256k1_musig_pubkey_agg(ctx, NULL, &agg_pk, &cache, pubkey_ptrs, n));
+            CHECK(secp256k1_musig_pubkey_agg(ctx, scratch_space, &agg_pk_scratch, &cache_scratch, pubkey_ptrs, n));
+            CHECK(secp256k1_memcmp_var(&agg_pk, &agg_pk_scratch, sizeof(agg_pk)) == 0);
+            CHECK(secp256k1_memcmp_var(&cache, &cache_scratch, sizeof(cache)) == 0);
+
+            /* Compare the full aggregate key with the term-by-term sum */
+            CHECK(secp256k1_musig_pubkey_get(ctx, &full_pk, &cache));
+            CHECK(secp256k1_pubkey_load(ctx, &q, &full_pk));
+            musig_test_pubkey_agg_naive(&expected, pubkey_ptrs, n);
+            ge_equals_ge(&q, &expected);
+            secp256k1_extrakeys_ge_even_y(&expected);
+            CHECK(secp256k1_xonly_pubkey_load(ctx, &q, &agg_pk));
+            ge_equals_ge(&q, &expected);
+
+            for (k = 0; k < n; k++) {
+                pubkey_ptrs[k] = &pubkeys[k];
+            }
+        }
+    }
+    secp256k1_scratch_space_destroy(ctx, scratch_space);
+}
+
+/* Runs a signing session of n signers and checks the final signature. */
+void musig_test_session(size_t n) {
+    unsigned char sk[MUSIG_TEST_MAX_SIGNERS][32];
+    secp256k1_keypair keypair[MUSIG_TEST_MAX_SIGNERS];
+    secp256k1_pubkey pk[MUSIG_TEST_MAX_SIGNERS];
+    const secp256k1_pubkey *pk_ptr[MUSIG_TEST_MAX_SIGNERS];
+    secp256k1_musig_secnonce secnonce[MUSIG_TEST_MAX_SIGNERS];
+    secp256k1_musig_pubnonce pubnonce[MUSIG_TEST_MAX_SIGNERS];
+    const secp256k1_musig_pubnonce *pubnonce_ptr[MUSIG_TEST_MAX_SIGNERS];
+    secp256k1_musig_partial_sig partial_sig[MUSIG_TEST_MAX_SIGNERS];
+    const secp256k1_musig_partial_sig *partial_sig_ptr[MUSIG_TEST_MAX_SIGNERS];
+    secp256k1_musig_keyagg_cache cache;
+    secp256k1_musig_aggnonce aggnonce, aggnonce_parsed;
+    secp256k1_musig_pubnonce pubnonce_parsed;
+    secp256k1_musig_partial_sig partial_sig_parsed;
+    secp256k1_musig_session session;
+    secp256k1_xonly_pubkey agg_pk;
+    unsigned char msg[32];
+    unsigned char session_id[32];
+    unsigned char buf[66], buf2[66];
+    unsigned char sig[64];
+    size_t i;
+
+    CHECK(n <= MUSIG_TEST_MAX_SIGNERS);
+    secp256k1_testrand256(msg);
+    for (i = 0; i < n; i++) {
+        secp256k1_testrand256(sk[i]);
+        CHECK(secp256k1_keypair_create(ctx, &keypair[i], sk[i]));
+        CHECK(secp256k1_keypair_pub(ctx, &pk[i], &keypair[i]));
+        pk_ptr[i] = &pk[i];
+        pubnonce_ptr[i] = &pubnonce[i];
+        partial_sig_ptr[i] = &partial_sig[i];
+    }
+    CHECK(secp256k1_musig_pubkey_agg(ctx, NULL, &agg_pk, &cache, pk_ptr, n));
+
+    for (i = 0; i < n; i++) {
+        secp256k1_testrand256(session_id);
+        /* Exercise both the minimal and the full set of nonce inputs */
+        if (i % 2 == 0) {
+            CHECK(secp256k1_musig_nonce_gen(ctx, &secnonce[i], &pubnonce[i], session_id, NULL, &pk[i], NULL, NULL, NULL));
+        } else {
+            CHECK(secp256k1_musig_nonce_gen(ctx, &secnonce[i], &pubnonce[i], session_id, sk[i], &pk[i], msg, &cache, msg));
+        }
+        CHECK(secp256k1_musig_pubnonce_serialize(ctx, buf, &pubnonce[i]));
+        CHECK(secp256k1_musig_pubnonce_parse(ctx, &pubnonce_parsed, buf));
+        CHECK(secp256k1_memcmp_var(&pubnonce_parsed, &pubnonce[i], sizeof(pubnonce_parsed)) == 0);
+    }
+    CHECK(secp256k1_musig_nonce_agg(ctx, &aggnonce, pubnonce_ptr, n));
+    CHECK(secp256k1_musig_aggnonce_serialize(ctx, buf, &aggnonce));
+    CHECK(secp256k1_musig_aggnonce_parse(ctx, &aggnonce_parsed, buf));
+    CHECK(secp256k1_musig_aggnonce_serialize(ctx, buf2, &aggnonce_parsed));
+    CHECK(secp256k1_memcmp_var(buf, buf2, sizeof(buf)) == 0);
+    CHECK(secp256k1_musig_nonce_process(ctx, &session, &aggnonce_parsed, msg, &cache));
+
+    for (i = 0; i < n; i++) {
+        CHECK(secp256k1_musig_partial_sign(ctx, &partial_sig[i], &secnonce[i], &keypair[i], &cache, &session));
+        CHECK(secp256k1_musig_partial_sig_verify(ctx, &partial_sig[i], &pubnonce[i], &pk[i], &cache, &session));
+        /* The partial signature does not verify for another signer */
+        CHECK(!secp256k1_musig_partial_sig_verify(ctx, &partial_sig[i], &pubnonce[(i + 1) % n], &pk[(i + 1) % n], &cache, &session) || n == 1);
+        CHECK(secp256k1_musig_partial_sig_serialize(ctx, buf, &partial_sig[i]));
+        CHECK(secp256k1_musig_partial_sig_parse(ctx, &partial_sig_parsed, buf));
+        CHECK(secp256k1_memcmp_var(&partial_sig_parsed, &partial_sig[i], sizeof(partial_sig_parsed)) == 0);
+    }
+    CHECK(secp256k1_musig_partial_sig_agg(ctx, sig, &session, partial_sig_ptr, n));
+    CHECK(secp256k1_schnorrsig_verify(ctx, sig, msg, &agg_pk));
+
+    /* A damaged partial signature fails to verify and gives an invalid signature */
+    CHECK(secp256k1_musig_partial_sig_serialize(ctx, buf, &partial_sig[0]));
+    buf[31] ^= 1;
+    CHECK(secp256k1_musig_partial_sig_parse(ctx, &partial_sig[0], buf));
+    CHECK(!secp256k1_musig_partial_sig_verify(ctx, &partial_sig[0], &pubnonce[0], &pk[0], &cache, &session));
+    CHECK(secp256k1_musig_partial_sig_agg(ctx, sig, &session, partial_sig_ptr, n));
+    CHECK(!secp256k1_schnorrsig_verify(ctx, sig, msg, &agg_pk));
+}
+
+/* Nonces that cancel out give an aggregate nonce at infinity, for which the
+ * final nonce is G. */
+void musig_test_nonce_infinity(void) {
+    unsigned char sk[32];
+    unsigned char session_id[32];
+    unsigned char msg[32];
+    unsigned char buf[66];
+    unsigned char zeros[66] = { 0 };
+    unsigned char sig[64];
+    secp256k1_keypair keypair;
+    secp256k1_pubkey pk;
+    const secp256k1_pubkey *pk_ptr = &pk;
+    secp256k1_xonly_pubkey agg_pk;
+    secp256k1_musig_keyagg_cache cache;
+    secp256k1_musig_secnonce secnonce;
+    secp256k1_musig_pubnonce pubnonce[2];
+    const secp256k1_musig_pubnonce *pubnonce_ptr[2];
+    secp256k1_musig_aggnonce aggnonce;
+    secp256k1_musig_session session;
+    secp256k1_musig_partial_sig partial_sig;
+    const secp256k1_musig_partial_sig *partial_sig_ptr = &partial_sig;
+
+    secp256k1_testrand256(sk);
+    secp256k1_testrand256(session_id);
+    secp256k1_testrand256(msg);
+    CHECK(secp256k1_keypair_create(ctx, &keypair, sk));
+    CHECK(secp256k1_keypair_pub(ctx, &pk, &keypair));
+    CHECK(secp256k1_musig_pubkey_agg(ctx, NULL, &agg_pk, &cache, &pk_ptr, 1));
+    CHECK(secp256k1_musig_nonce_gen(ctx, &secnonce, &pubnonce[0], session_id, sk, &pk, msg, &cache, NULL));
+
+    /* The second nonce is the negation of the first */
+    CHECK(secp256k1_musig_pubnonce_serialize(ctx, buf, &pubnonce[0]));
+    buf[0] ^= 1;
+    buf[33] ^= 1;
+    CHECK(secp256k1_musig_pubnonce_parse(ctx, &pubnonce[1], buf));
+    pubnonce_ptr[0] = &pubnonce[0];
+    pubnonce_ptr[1] = &pubnonce[1];
+    CHECK(secp256k1_musig_nonce_agg(ctx, &aggnonce, pubnonce_ptr, 2));
+    CHECK(secp256k1_musig_aggnonce_serialize(ctx, buf, &aggnonce));
+    CHECK(secp256k1_memcmp_var(buf, zeros, sizeof(buf)) == 0);
+    CHECK(secp256k1_musig_aggnonce_parse(ctx, &aggnonce, zeros));
+    CHECK(secp256k1_musig_nonce_process(ctx, &session, &aggnonce, msg, &cache));
+
+    /* The partial signature of the first signer does not make a valid
+     * signature, but the session is usable. */
+    CHECK(secp256k1_musig_partial_sign(ctx, &partial_sig, &secnonce, &keypair, &cache, &session));
+    CHECK(secp256k1_musig_partial_sig_agg(ctx, sig, &session, &partial_sig_ptr, 1));
+    CHECK(secp256k1_memcmp_var(sig, &zeros[0], 32) != 0);
+}
+
+void musig_test_api(void) {
+    unsigned char sk[32];
+    unsigned char session_id[32];
+    unsigned char msg[32];
+    unsigned char buf[66];
+    unsigned char max66[66];
+    secp256k1_keypair keypair, keypair2;
+    secp256k1_pubkey pk, agg_pk_full;
+    const secp256k1_pubkey *pk_ptr = &pk;
+    const secp256k1_pubkey *null_ptr = NULL;
+    secp256k1_xonly_pubkey agg_pk;
+    secp256k1_musig_keyagg_cache cache, invalid_cache;
+    secp256k1_musig_secnonce secnonce, secnonce_copy;
+    secp256k1_musig_pubnonce pubnonce;
+    const secp256k1_musig_pubnonce *pubnonce_ptr = &pubnonce;
+    secp256k1_musig_aggnonce aggnonce;
+    secp256k1_musig_session session;
+    secp256k1_musig_partial_sig partial_sig, partial_sig_tmp;
+
+    int ecount = 0;
+    secp256k1_context *none = api_test_context(SECP256K1_CONTEXT_NONE, &ecount);
+    secp256k1_context *sign = api_test_context(SECP256K1_CONTEXT_SIGN, &ecount);
+    secp256k1_context *verify = api_test_context(SECP256K1_CONTEXT_VERIFY, &ecount);
+    secp256k1_context *both = api_test_context(SECP256K1_CONTEXT_SIGN | SECP256K1_CONTEXT_VERIFY, &ecount);
+
+    secp256k1_testrand256(sk);
+    secp256k1_testrand256(session_id);
+    secp256k1_testrand256(msg);
+    memset(max66, 0xff, sizeof(max66));
+    memset(&invalid_cache, 0, sizeof(invalid_cache));
+    CHECK(secp256k1_keypair_create(ctx, &keypair, sk));
+    CHECK(secp256k1_keypair_pub(ctx, &pk, &keypair));
+
+    /* pubkey_agg */
+    CHECK(secp256k1_musig_pubkey_agg(none, NULL, &agg_pk, &cache, &pk_ptr, 1) == 0);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_musig_pubkey_agg(verify, NULL, &agg_pk, &cache, &pk_ptr, 0) == 0);
+    CHECK(ecount == 2);
+    CHECK(secp256k1_musig_pubkey_agg(verify, NULL, &agg_pk, &cache, &null_ptr, 1) == 0);
+    CHECK(ecount == 3);
+    CHECK(secp256k1_musig_pubkey_agg(verify, NULL, NULL, NULL, &pk_ptr, 1) == 1);
+    CHECK(secp256k1_musig_pubkey_agg(verify, NULL, &agg_pk, &cache, &pk_ptr, 1) == 1);
+    CHECK(secp256k1_musig_pubkey_get(none, &agg_pk_full, &invalid_cache) == 0);
+    CHECK(ecount == 4);
+
+    /* nonce_gen */
+    CHECK(secp256k1_musig_nonce_gen(verify, &secnonce, &pubnonce, session_id, sk, &pk, msg, &cache, NULL) == 0);
+    CHECK(ecount == 5);
+    CHECK(secp256k1_musig_nonce_gen(sign, &secnonce, &pubnonce, session_id, sk, &pk, msg, &invalid_cache, NULL) == 0);
+    CHECK(ecount == 6);
+    CHECK(secp256k1_musig_nonce_gen(sign, &secnonce, &pubnonce, session_id, sk, &pk, msg, &cache, NULL) == 1);
+    CHECK(ecount == 6);
+
+    /* parsing */
+    CHECK(secp256k1_musig_pubnonce_parse(none, &pubnonce, max66) == 0);
+    CHECK(secp256k1_musig_pubnonce_serialize(none, buf, &pubnonce) == 0);
+    CHECK(ecount == 7);
+    CHECK(secp256k1_musig_partial_sig_parse(none, &partial_sig, max66) == 0);
+    CHECK(secp256k1_musig_partial_sig_serialize(none, buf, &partial_sig) == 0);
+    CHECK(ecount == 8);
+    CHECK(secp256k1_musig_pubnonce_parse(none, &pubnonce, buf) == 0);
+    CHECK(secp256k1_musig_aggnonce_parse(none, &aggnonce, max66) == 0);
+
+    /* nonce_agg and nonce_process */
+    CHECK(secp256k1_musig_nonce_gen(sign, &secnonce, &pubnonce, session_id, sk, &pk, msg, &cache, NULL) == 1);
+    CHECK(secp256k1_musig_nonce_agg(none, &aggnonce, &pubnonce_ptr, 0) == 0);
+    CHECK(ecount == 9);
+    CHECK(secp256k1_musig_nonce_agg(none, &aggnonce, &pubnonce_ptr, 1) == 1);
+    CHECK(secp256k1_musig_nonce_process(none, &session, &aggnonce, msg, &cache) == 0);
+    CHECK(ecount == 10);
+    CHECK(secp256k1_musig_nonce_process(verify, &session, &aggnonce, msg, &invalid_cache) == 0);
+    CHECK(ecount == 11);
+    CHECK(secp256k1_musig_nonce_process(verify, &session, &aggnonce, msg, &cache) == 1);
+
+    /* partial_sign with a secnonce of another key fails and uses up the secnonce */
+    secp256k1_testrand256(sk);
+    CHECK(secp256k1_keypair_create(ctx, &keypair2, sk));
+    secnonce_copy = secnonce;
+    CHECK(secp256k1_musig_partial_sign(none, &partial_sig, &secnonce_copy, &keypair2, &cache, &session) == 0);
+    CHECK(ecount == 11);
+    CHECK(secp256k1_musig_partial_sign(none, &partial_sig, &secnonce_copy, &keypair, &cache, &session) == 0);
+    CHECK(ecount == 12);
+    /* A secnonce can only be used once */
+    CHECK(secp256k1_musig_partial_sign(none, &partial_sig, &secnonce, &keypair, &cache, &session) == 1);
+    CHECK(secp256k1_musig_partial_sign(none, &partial_sig_tmp, &secnonce, &keypair, &cache, &session) == 0);
+    CHECK(ecount == 13);
+
+    /* partial_sig_verify */
+    CHECK(secp256k1_musig_partial_sig_verify(none, &partial_sig, &pubnonce, &pk, &cache, &session) == 0);
+    CHECK(ecount == 14);
+    CHECK(secp256k1_musig_partial_sig_verify(both, &partial_sig, &pubnonce, &pk, &cache, &session) == 1);
+    CHECK(ecount == 14);
+
+    secp256k1_context_destroy(none);
+    secp256k1_context_destroy(sign);
+    secp256k1_context_destroy(verify);
+    secp256k1_context_destroy(both);
+}
+
+void run_musig_tests(void) {
+    int i;
+
+    musig_test_sha256_tagged();
+    musig_test_api();
+    musig_test_pubkey_agg();
+    musig_test_nonce_infinity();
+    for (i = 0; i < count; i++) {
+        musig_test_session(1 + secp256k1_testrand_int(MUSIG_TEST_MAX_SIGNERS));
+    }
+}
+
+#endif /* SECP256K1_MODULE_MUSIG_TESTS_H */
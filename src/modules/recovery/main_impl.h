@@ -84,30 +84,37 @@ int secp256k1_ecdsa_recoverable_signature_convert(const secp256k1_context* ctx,
     return 1;
 }
 
-static int secp256k1_ecdsa_sig_recover(const secp256k1_ecmult_context *ctx, const secp256k1_scalar *sigr, const secp256k1_scalar* sigs, secp256k1_ge *pubkey, const secp256k1_scalar *message, int recid) {
+/* Lifts the r value of a signature to the point R it was computed from, using
+ * the recovery id to select the x coordinate and the parity of y. */
+static int secp256k1_ecdsa_sig_lift_r(secp256k1_ge *r, const secp256k1_scalar *sigr, int recid) {
     unsigned char brx[32];
     secp256k1_fe fx;
+    int ret;
+
+    secp256k1_scalar_get_b32(brx, sigr);
+    ret = secp256k1_fe_set_b32(&fx, brx);
+    (void)ret;
+    VERIFY_CHECK(ret); /* brx comes from a scalar, so is less than the order; certainly less than p */
+    if (recid & 2) {
+        if (secp256k1_fe_cmp_var(&fx, &secp256k1_ecdsa_const_p_minus_order) >= 0) {
+            return 0;
+        }
+        secp256k1_fe_add(&fx, &secp256k1_ecdsa_const_order_as_fe);
+    }
+    return secp256k1_ge_set_xo_var(r, &fx, recid & 1);
+}
+
+static int secp256k1_ecdsa_sig_recover(const secp256k1_ecmult_context *ctx, const secp256k1_scalar *sigr, const secp256k1_scalar* sigs, secp256k1_ge *pubkey, const secp256k1_scalar *message, int recid) {
     secp256k1_ge x;
     secp256k1_gej xj;
     secp256k1_scalar rn, u1, u2;
     secp256k1_gej qj;
-    int r;
 
     if (secp256k1_scalar_is_zero(sigr) || secp256k1_scalar_is_zero(sigs)) {
         return 0;
     }
 
-    secp256k1_scalar_get_b32(brx, sigr);
-    r = secp256k1_fe_set_b32(&fx, brx);
-    (void)r;
-    VERIFY_CHECK(r); /* brx comes from a scalar, so is less than the order; certainly less than p */
-    if (recid & 2) {
-        if (secp256k1_fe_cmp_var(&fx, &secp256k1_ecdsa_const_p_minus_order) >= 0) {
-            return 0;
-        }
-        secp256k1_fe_add(&fx, &secp256k1_ecdsa_const_order_as_fe);
-    }
-    if (!secp256k1_ge_set_xo_var(&x, &fx, recid & 1)) {
+    if (!secp256k1_ecdsa_sig_lift_r(&x, sigr, recid)) {
         return 0;
     }
     secp256k1_gej_set_ge(&xj, &x);
@@ -157,4 +164,225 @@ int secp256k1_ecdsa_recover(const secp256k1_context* ctx, secp256k1_pubkey *pubk
     }
 }
 
+/* The number of signatures secp256k1_ecdsa_recover_batch processes at once */
+#define ECDSA_RECOVER_BATCH_SIZE 32
+
+int secp256k1_ecdsa_recover_batch(const secp256k1_context* ctx, secp256k1_pubkey *pubkeys, const secp256k1_ecdsa_recoverable_signature *const *sigs, const unsigned char *const *msg32s, size_t n) {
+    secp256k1_ge x[ECDSA_RECOVER_BATCH_SIZE];
+    secp256k1_scalar rs[ECDSA_RECOVER_BATCH_SIZE], ss[ECDSA_RECOVER_BATCH_SIZE];
+    secp256k1_scalar rn[ECDSA_RECOVER_BATCH_SIZE];
+    secp256k1_gej qj[ECDSA_RECOVER_BATCH_SIZE];
+    secp256k1_ge q[ECDSA_RECOVER_BATCH_SIZE];
+    size_t idx[ECDSA_RECOVER_BATCH_SIZE];
+    int valid[ECDSA_RECOVER_BATCH_SIZE];
+    size_t i, j, k, batch, n_valid;
+    int ret = 1;
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(pubkeys != NULL || n == 0);
+    ARG_CHECK(sigs != NULL || n == 0);
+    ARG_CHECK(msg32s != NULL || n == 0);
+    for (i = 0; i < n; i++) {
+        ARG_CHECK(sigs[i] != NULL);
+        ARG_CHECK(msg32s[i] != NULL);
+    }
+
+    for (i = 0; i < n; i += batch) {
+        batch = n - i < ECDSA_RECOVER_BATCH_SIZE ? n - i : ECDSA_RECOVER_BATCH_SIZE;
+        /* Lift the R points, and collect the r values of the liftable signatures
+         * to invert them together. */
+        n_valid = 0;
+        for (j = 0; j < batch; j++) {
+            secp256k1_scalar r, s;
+            int recid;
+            secp256k1_ecdsa_recoverable_signature_load(ctx, &r, &s, &recid, sigs[i + j]);
+            VERIFY_CHECK(recid >= 0 && recid < 4);  /* should have been caught in parse_compact */
+            valid[j] = !secp256k1_scalar_is_zero(&r) && !secp256k1_scalar_is_zero(&s)
+                && secp256k1_ecdsa_sig_lift_r(&x[n_valid], &r, recid);
+            if (valid[j]) {
+                rs[n_valid] = r;
+                ss[n_valid] = s;
+                idx[n_valid] = j;
+                n_valid++;
+            }
+        }
+        secp256k1_scalar_inverse_all_var(rn, rs, n_valid);
+        for (k = 0; k < n_valid; k++) {
+            secp256k1_scalar m, u1, u2;
+            secp256k1_gej xj;
+            secp256k1_scalar_set_b32(&m, msg32s[i + idx[k]], NULL);
+            secp256k1_gej_set_ge(&xj, &x[k]);
+            secp256k1_scalar_mul(&u1, &rn[k], &m);
+            secp256k1_scalar_negate(&u1, &u1);
+            secp256k1_scalar_mul(&u2, &rn[k], &ss[k]);
+            secp256k1_ecmult(&ctx->ecmult_ctx, &qj[k], &xj, &u2, &u1);
+            valid[idx[k]] = !secp256k1_gej_is_infinity(&qj[k]);
+        }
+        secp256k1_ge_set_all_gej_var(q, qj, n_valid);
+        for (j = 0; j < batch; j++) {
+            memset(&pubkeys[i + j], 0, sizeof(pubkeys[i + j]));
+        }
+        for (k = 0; k < n_valid; k++) {
+            if (valid[idx[k]]) {
+                secp256k1_pubkey_save(&pubkeys[i + idx[k]], &q[k]);
+            }
+        }
+        for (j = 0; j < batch; j++) {
+            ret &= valid[j];
+        }
+    }
+    return ret;
+}
+
+/* Data that is used by the batch verification ecmult callback */
+typedef struct {
+    const secp256k1_context *ctx;
+    /* Seed for the randomizers, committing to all signatures, messages and
+     * public keys of the batch */
+    unsigned char seed[32];
+    /* Caches the randomizer of the signature with index randomizer_idx */
+    secp256k1_scalar randomizer;
+    size_t randomizer_idx;
+    /* Signature, message, public key tuples to verify */
+    const secp256k1_ecdsa_recoverable_signature *const *sig;
+    const unsigned char *const *msg32;
+    const secp256k1_pubkey *const *pubkey;
+    size_t n_sigs;
+} secp256k1_ecdsa_verify_ecmult_context;
+
+/* Initializes SHA256 with fixed midstate. This midstate was computed by applying
+ * SHA256 to SHA256("ECDSA/batch")||SHA256("ECDSA/batch"). */
+static void secp256k1_ecdsa_sha256_tagged_batch(secp256k1_sha256 *sha) {
+    secp256k1_sha256_initialize(sha);
+    sha->s[0] = 0x352873dcul;
+    sha->s[1] = 0xd4c6ab0bul;
+    sha->s[2] = 0x3bc99ea0ul;
+    sha->s[3] = 0xa61085c2ul;
+    sha->s[4] = 0xf74cb370ul;
+    sha->s[5] = 0x45401bcbul;
+    sha->s[6] = 0xf7d2c0fbul;
+    sha->s[7] = 0xe333afaaul;
+    sha->bytes = 64;
+}
+
+/* Computes the randomizer of the idx-th signature from the seed. The first
+ * randomizer is always 1 because only the ratios of the randomizers matter. */
+static void secp256k1_ecdsa_verify_batch_randomizer(secp256k1_scalar *r, const unsigned char *seed32, size_t idx) {
+    secp256k1_sha256 sha;
+    unsigned char buf[32];
+    int i;
+
+    if (idx == 0) {
+        secp256k1_scalar_set_int(r, 1);
+        return;
+    }
+    for (i = 0; i < 8; i++) {
+        buf[i] = (unsigned char)((uint64_t)idx >> (8 * i));
+    }
+    secp256k1_sha256_initialize(&sha);
+    secp256k1_sha256_write(&sha, seed32, 32);
+    secp256k1_sha256_write(&sha, buf, 8);
+    secp256k1_sha256_finalize(&sha, buf);
+    secp256k1_scalar_set_b32(r, buf, NULL);
+}
+
+/* Callback function which is called by ecmult_multi in order to convert the ecmult_context
+ * consisting of signature, message and public key tuples into scalars and points. A
+ * signature (r, s) is valid iff m*G + r*P - s*R = 0, so every signature results in two
+ * (scalar,point)-tuples:
+ * (randomizer*r, P)
+ * (-randomizer*s, R) */
+static int secp256k1_ecdsa_verify_batch_ecmult_callback(secp256k1_scalar *sc, secp256k1_ge *pt, size_t idx, void *data) {
+    secp256k1_ecdsa_verify_ecmult_context *ecmult_context = (secp256k1_ecdsa_verify_ecmult_context *) data;
+    size_t sig_idx = idx / 2;
+    secp256k1_scalar r, s;
+    int recid;
+
+    VERIFY_CHECK(sig_idx < ecmult_context->n_sigs);
+    if (ecmult_context->randomizer_idx != sig_idx) {
+        secp256k1_ecdsa_verify_batch_randomizer(&ecmult_context->randomizer, ecmult_context->seed, sig_idx);
+        ecmult_context->randomizer_idx = sig_idx;
+    }
+
+    secp256k1_ecdsa_recoverable_signature_load(ecmult_context->ctx, &r, &s, &recid, ecmult_context->sig[sig_idx]);
+    if (idx % 2 == 0) {
+        if (!secp256k1_pubkey_load(ecmult_context->ctx, pt, ecmult_context->pubkey[sig_idx])) {
+            return 0;
+        }
+        secp256k1_scalar_mul(sc, &r, &ecmult_context->randomizer);
+    } else {
+        if (!secp256k1_ecdsa_sig_lift_r(pt, &r, recid)) {
+            return 0;
+        }
+        secp256k1_scalar_mul(sc, &s, &ecmult_context->randomizer);
+        secp256k1_scalar_negate(sc, sc);
+    }
+    return 1;
+}
+
+int secp256k1_ecdsa_verify_batch(const secp256k1_context* ctx, secp256k1_scratch_space *scratch, const secp256k1_ecdsa_recoverable_signature *const *sig, const unsigned char *const *msg32, const secp256k1_pubkey *const *pubkey, size_t n_sigs) {
+    secp256k1_ecdsa_verify_ecmult_context ecmult_context;
+    secp256k1_sha256 sha;
+    secp256k1_scalar g_sc;
+    secp256k1_gej rj;
+    size_t i;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(scratch != NULL);
+    /* The number of points given to ecmult_multi is 2*n_sigs. */
+    ARG_CHECK(n_sigs <= SIZE_MAX / 2);
+    ARG_CHECK(n_sigs == 0 || (sig != NULL && msg32 != NULL && pubkey != NULL));
+
+    /* Derive the seed for the randomizers from all inputs so that an attacker
+     * cannot choose invalid signatures that cancel out in the combination.
+     * Reject everything secp256k1_ecdsa_verify would reject on the way. */
+    secp256k1_ecdsa_sha256_tagged_batch(&sha);
+    for (i = 0; i < n_sigs; i++) {
+        secp256k1_scalar r, s;
+        secp256k1_ge q;
+        unsigned char buf[65];
+        size_t len = 33;
+        int recid;
+        ARG_CHECK(sig[i] != NULL);
+        ARG_CHECK(msg32[i] != NULL);
+        ARG_CHECK(pubkey[i] != NULL);
+        secp256k1_ecdsa_recoverable_signature_load(ctx, &r, &s, &recid, sig[i]);
+        if (secp256k1_scalar_is_zero(&r) || secp256k1_scalar_is_zero(&s) || secp256k1_scalar_is_high(&s)) {
+            return 0;
+        }
+        if (!secp256k1_pubkey_load(ctx, &q, pubkey[i])) {
+            return 0;
+        }
+        secp256k1_scalar_get_b32(&buf[0], &r);
+        secp256k1_scalar_get_b32(&buf[32], &s);
+        buf[64] = recid;
+        secp256k1_sha256_write(&sha, buf, 65);
+        secp256k1_sha256_write(&sha, msg32[i], 32);
+        secp256k1_eckey_pubkey_serialize(&q, buf, &len, 1);
+        secp256k1_sha256_write(&sha, buf, 33);
+    }
+    ecmult_context.ctx = ctx;
+    secp256k1_sha256_finalize(&sha, ecmult_context.seed);
+    ecmult_context.sig = sig;
+    ecmult_context.msg32 = msg32;
+    ecmult_context.pubkey = pubkey;
+    ecmult_context.n_sigs = n_sigs;
+
+    /* Compute sum(randomizer_i * m_i), the scalar of the generator. */
+    secp256k1_scalar_set_int(&g_sc, 0);
+    for (i = 0; i < n_sigs; i++) {
+        secp256k1_scalar m;
+        secp256k1_scalar_set_b32(&m, msg32[i], NULL);
+        secp256k1_ecdsa_verify_batch_randomizer(&ecmult_context.randomizer, ecmult_context.seed, i);
+        secp256k1_scalar_mul(&m, &m, &ecmult_context.randomizer);
+        secp256k1_scalar_add(&g_sc, &g_sc, &m);
+    }
+    /* Invalidate the cache, the callback starts at the first signature. */
+    ecmult_context.randomizer_idx = SIZE_MAX;
+
+    return secp256k1_ecmult_multi_var(&ctx->error_callback, &ctx->ecmult_ctx, scratch, &rj, &g_sc, secp256k1_ecdsa_verify_batch_ecmult_callback, (void *) &ecmult_context, 2 * n_sigs)
+            && secp256k1_gej_is_infinity(&rj);
+}
+
 #endif /* SECP256K1_MODULE_RECOVERY_MAIN_H */
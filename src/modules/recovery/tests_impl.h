@@ -205,6 +205,64 @@ void test_ecdsa_recovery_end_to_end(void) {
           secp256k1_memcmp_var(&pubkey, &recpubkey, sizeof(pubkey)) != 0);
 }
 
+void test_ecdsa_recover_batch(void) {
+    /* A mix of valid and unrecoverable signatures, compared to recovering one at a time. */
+    secp256k1_ecdsa_recoverable_signature rsigs[40];
+    const secp256k1_ecdsa_recoverable_signature *sigptr[40];
+    unsigned char messages[40][32];
+    const unsigned char *msgptr[40];
+    secp256k1_pubkey pubkeys[40], expected[40];
+    size_t i, n = 1 + secp256k1_testrand_int(40);
+    int all = 1;
+    int ecount = 0;
+
+    for (i = 0; i < 40; i++) {
+        sigptr[i] = &rsigs[i];
+        msgptr[i] = messages[i];
+    }
+    for (i = 0; i < n; i++) {
+        secp256k1_scalar key, msg, r, s;
+        unsigned char privkey[32];
+        int recid;
+        int kind = secp256k1_testrand_int(8);
+
+        random_scalar_order_test(&key);
+        random_scalar_order_test(&msg);
+        secp256k1_scalar_get_b32(privkey, &key);
+        secp256k1_scalar_get_b32(messages[i], &msg);
+        CHECK(secp256k1_ecdsa_sign_recoverable(ctx, &rsigs[i], messages[i], privkey, NULL, NULL) == 1);
+        secp256k1_ecdsa_recoverable_signature_load(ctx, &r, &s, &recid, &rsigs[i]);
+        if (kind == 0) {
+            secp256k1_ecdsa_recoverable_signature_save(&rsigs[i], &secp256k1_scalar_zero, &s, recid);
+        } else if (kind == 1) {
+            secp256k1_ecdsa_recoverable_signature_save(&rsigs[i], &r, &secp256k1_scalar_zero, recid);
+        } else if (kind == 2) {
+            /* Recovery ids 2 and 3 are almost never liftable */
+            secp256k1_ecdsa_recoverable_signature_save(&rsigs[i], &r, &s, recid | 2);
+        } else if (kind == 3) {
+            secp256k1_ecdsa_recoverable_signature_save(&rsigs[i], &r, &s, recid ^ 1);
+        }
+        if (!secp256k1_ecdsa_recover(ctx, &expected[i], &rsigs[i], messages[i])) {
+            all = 0;
+        }
+    }
+    CHECK(secp256k1_ecdsa_recover_batch(ctx, pubkeys, sigptr, msgptr, n) == all);
+    CHECK(secp256k1_memcmp_var(expected, pubkeys, n * sizeof(pubkeys[0])) == 0);
+
+    CHECK(secp256k1_ecdsa_recover_batch(ctx, NULL, NULL, NULL, 0) == 1);
+    secp256k1_context_set_illegal_callback(ctx, counting_illegal_callback_fn, &ecount);
+    CHECK(secp256k1_ecdsa_recover_batch(ctx, NULL, sigptr, msgptr, 1) == 0);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_ecdsa_recover_batch(ctx, pubkeys, NULL, msgptr, 1) == 0);
+    CHECK(ecount == 2);
+    CHECK(secp256k1_ecdsa_recover_batch(ctx, pubkeys, sigptr, NULL, 1) == 0);
+    CHECK(ecount == 3);
+    msgptr[0] = NULL;
+    CHECK(secp256k1_ecdsa_recover_batch(ctx, pubkeys, sigptr, msgptr, 1) == 0);
+    CHECK(ecount == 4);
+    secp256k1_context_set_illegal_callback(ctx, NULL, NULL);
+}
+
 /* Tests several edge cases. */
 void test_ecdsa_recovery_edge_cases(void) {
     const unsigned char msg32[32] = {
@@ -379,6 +437,226 @@ void test_ecdsa_recovery_edge_cases(void) {
     }
 }
 
+void test_ecdsa_verify_batch_api(void) {
+    secp256k1_context *none = secp256k1_context_create(SECP256K1_CONTEXT_NONE);
+    secp256k1_context *sign = secp256k1_context_create(SECP256K1_CONTEXT_SIGN);
+    secp256k1_context *vrfy = secp256k1_context_create(SECP256K1_CONTEXT_VERIFY);
+    secp256k1_scratch_space *scratch_space = secp256k1_scratch_space_create(ctx, 8192);
+    secp256k1_ecdsa_recoverable_signature recsig;
+    secp256k1_pubkey pubkey;
+    secp256k1_pubkey zero_pubkey;
+    unsigned char privkey[32] = { 1 };
+    unsigned char message[32] = { 2 };
+    const secp256k1_ecdsa_recoverable_signature *sigptr = &recsig;
+    const unsigned char *msgptr = message;
+    const secp256k1_pubkey *pkptr = &pubkey;
+    const secp256k1_pubkey *zero_pkptr = &zero_pubkey;
+    const secp256k1_ecdsa_recoverable_signature *null_sigptr = NULL;
+    int32_t ecount = 0;
+
+    secp256k1_context_set_error_callback(none, counting_illegal_callback_fn, &ecount);
+    secp256k1_context_set_error_callback(sign, counting_illegal_callback_fn, &ecount);
+    secp256k1_context_set_error_callback(vrfy, counting_illegal_callback_fn, &ecount);
+    secp256k1_context_set_illegal_callback(none, counting_illegal_callback_fn, &ecount);
+    secp256k1_context_set_illegal_callback(sign, counting_illegal_callback_fn, &ecount);
+    secp256k1_context_set_illegal_callback(vrfy, counting_illegal_callback_fn, &ecount);
+
+    CHECK(secp256k1_ec_pubkey_create(ctx, &pubkey, privkey) == 1);
+    CHECK(secp256k1_ecdsa_sign_recoverable(ctx, &recsig, message, privkey, NULL, NULL) == 1);
+    memset(&zero_pubkey, 0, sizeof(zero_pubkey));
+
+    CHECK(secp256k1_ecdsa_verify_batch(vrfy, scratch_space, &sigptr, &msgptr, &pkptr, 1) == 1);
+    CHECK(secp256k1_ecdsa_verify_batch(vrfy, scratch_space, NULL, NULL, NULL, 0) == 1);
+    CHECK(ecount == 0);
+    CHECK(secp256k1_ecdsa_verify_batch(none, scratch_space, &sigptr, &msgptr, &pkptr, 1) == 0);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_ecdsa_verify_batch(sign, scratch_space, &sigptr, &msgptr, &pkptr, 1) == 0);
+    CHECK(ecount == 2);
+    CHECK(secp256k1_ecdsa_verify_batch(vrfy, NULL, &sigptr, &msgptr, &pkptr, 1) == 0);
+    CHECK(ecount == 3);
+    CHECK(secp256k1_ecdsa_verify_batch(vrfy, scratch_space, NULL, &msgptr, &pkptr, 1) == 0);
+    CHECK(ecount == 4);
+    CHECK(secp256k1_ecdsa_verify_batch(vrfy, scratch_space, &sigptr, NULL, &pkptr, 1) == 0);
+    CHECK(ecount == 5);
+    CHECK(secp256k1_ecdsa_verify_batch(vrfy, scratch_space, &sigptr, &msgptr, NULL, 1) == 0);
+    CHECK(ecount == 6);
+    CHECK(secp256k1_ecdsa_verify_batch(vrfy, scratch_space, &null_sigptr, &msgptr, &pkptr, 1) == 0);
+    CHECK(ecount == 7);
+    CHECK(secp256k1_ecdsa_verify_batch(vrfy, scratch_space, &sigptr, &msgptr, &pkptr, SIZE_MAX / 2 + 1) == 0);
+    CHECK(ecount == 8);
+    CHECK(secp256k1_ecdsa_verify_batch(vrfy, scratch_space, &sigptr, &msgptr, &zero_pkptr, 1) == 0);
+    CHECK(ecount == 9);
+
+    secp256k1_scratch_space_destroy(ctx, scratch_space);
+    secp256k1_context_destroy(none);
+    secp256k1_context_destroy(sign);
+    secp256k1_context_destroy(vrfy);
+}
+
+void test_ecdsa_verify_batch_sha256_tagged(void) {
+    static const unsigned char tag[11] = {'E', 'C', 'D', 'S', 'A', '/', 'b', 'a', 't', 'c', 'h'};
+    secp256k1_sha256 sha;
+    secp256k1_sha256 sha_optimized;
+    unsigned char out[32];
+    unsigned char out_optimized[32];
+
+    secp256k1_sha256_initialize_tagged(&sha, tag, sizeof(tag));
+    secp256k1_ecdsa_sha256_tagged_batch(&sha_optimized);
+    secp256k1_sha256_write(&sha, tag, sizeof(tag));
+    secp256k1_sha256_write(&sha_optimized, tag, sizeof(tag));
+    secp256k1_sha256_finalize(&sha, out);
+    secp256k1_sha256_finalize(&sha_optimized, out_optimized);
+    CHECK(secp256k1_memcmp_var(out, out_optimized, 32) == 0);
+}
+
+#define N_BATCH_SIGS 32
+void test_ecdsa_verify_batch(void) {
+    secp256k1_scratch_space *scratch_space = secp256k1_scratch_space_create(ctx, 1024 * 1024);
+    secp256k1_ecdsa_recoverable_signature recsig[N_BATCH_SIGS];
+    secp256k1_pubkey pubkey[N_BATCH_SIGS];
+    unsigned char message[N_BATCH_SIGS][32];
+    const secp256k1_ecdsa_recoverable_signature *sigptr[N_BATCH_SIGS];
+    const unsigned char *msgptr[N_BATCH_SIGS];
+    const secp256k1_pubkey *pkptr[N_BATCH_SIGS];
+    secp256k1_ecdsa_recoverable_signature tmp_sig;
+    secp256k1_scalar r, s;
+    size_t n_sigs = 1 + secp256k1_testrand_int(N_BATCH_SIGS);
+    size_t i, bad;
+    int recid;
+
+    for (i = 0; i < n_sigs; i++) {
+        unsigned char privkey[32];
+        secp256k1_scalar key;
+        random_scalar_order_test(&key);
+        secp256k1_scalar_get_b32(privkey, &key);
+        secp256k1_testrand256(message[i]);
+        CHECK(secp256k1_ec_pubkey_create(ctx, &pubkey[i], privkey) == 1);
+        CHECK(secp256k1_ecdsa_sign_recoverable(ctx, &recsig[i], message[i], privkey, NULL, NULL) == 1);
+        sigptr[i] = &recsig[i];
+        msgptr[i] = message[i];
+        pkptr[i] = &pubkey[i];
+    }
+    CHECK(secp256k1_ecdsa_verify_batch(ctx, scratch_space, sigptr, msgptr, pkptr, n_sigs) == 1);
+    /* Without scratch space for all points at once, ecmult_multi batches internally */
+    {
+        secp256k1_scratch_space *small_scratch = secp256k1_scratch_space_create(ctx, secp256k1_strauss_scratch_size(3) + STRAUSS_SCRATCH_OBJECTS*ALIGNMENT);
+        CHECK(secp256k1_ecdsa_verify_batch(ctx, small_scratch, sigptr, msgptr, pkptr, n_sigs) == 1);
+        secp256k1_scratch_space_destroy(ctx, small_scratch);
+    }
+
+    bad = secp256k1_testrand_int(n_sigs);
+    tmp_sig = recsig[bad];
+    secp256k1_ecdsa_recoverable_signature_load(ctx, &r, &s, &recid, &recsig[bad]);
+
+    /* A wrong recovery id makes the batch fail */
+    secp256k1_ecdsa_recoverable_signature_save(&recsig[bad], &r, &s, recid ^ 1);
+    CHECK(secp256k1_ecdsa_verify_batch(ctx, scratch_space, sigptr, msgptr, pkptr, n_sigs) == 0);
+    secp256k1_ecdsa_recoverable_signature_save(&recsig[bad], &r, &s, recid ^ 2);
+    CHECK(secp256k1_ecdsa_verify_batch(ctx, scratch_space, sigptr, msgptr, pkptr, n_sigs) == 0);
+
+    /* High s values are rejected even with a matching recovery id */
+    secp256k1_scalar_negate(&s, &s);
+    secp256k1_ecdsa_recoverable_signature_save(&recsig[bad], &r, &s, recid ^ 1);
+    CHECK(secp256k1_ecdsa_verify_batch(ctx, scratch_space, sigptr, msgptr, pkptr, n_sigs) == 0);
+    secp256k1_scalar_negate(&s, &s);
+
+    /* Zero r or s values are rejected */
+    secp256k1_ecdsa_recoverable_signature_save(&recsig[bad], &secp256k1_scalar_zero, &s, recid);
+    CHECK(secp256k1_ecdsa_verify_batch(ctx, scratch_space, sigptr, msgptr, pkptr, n_sigs) == 0);
+    secp256k1_ecdsa_recoverable_signature_save(&recsig[bad], &r, &secp256k1_scalar_zero, recid);
+    CHECK(secp256k1_ecdsa_verify_batch(ctx, scratch_space, sigptr, msgptr, pkptr, n_sigs) == 0);
+    recsig[bad] = tmp_sig;
+
+    /* A wrong message or public key makes the batch fail */
+    {
+        size_t byte = secp256k1_testrand_int(32);
+        unsigned char bit = 1 << secp256k1_testrand_int(8);
+        message[bad][byte] ^= bit;
+        CHECK(secp256k1_ecdsa_verify_batch(ctx, scratch_space, sigptr, msgptr, pkptr, n_sigs) == 0);
+        message[bad][byte] ^= bit;
+    }
+    if (n_sigs > 1) {
+        pkptr[bad] = &pubkey[(bad + 1) % n_sigs];
+        CHECK(secp256k1_ecdsa_verify_batch(ctx, scratch_space, sigptr, msgptr, pkptr, n_sigs) == 0);
+        msgptr[bad] = message[(bad + 1) % n_sigs];
+        sigptr[bad] = &recsig[(bad + 1) % n_sigs];
+        /* Duplicate valid entries are fine */
+        CHECK(secp256k1_ecdsa_verify_batch(ctx, scratch_space, sigptr, msgptr, pkptr, n_sigs) == 1);
+    }
+
+    /* Two individually invalid signatures whose errors would cancel out in a plain sum */
+    if (n_sigs > 1) {
+        secp256k1_scalar r2, s2;
+        int recid2;
+        for (i = 0; i < n_sigs; i++) {
+            sigptr[i] = &recsig[i];
+            msgptr[i] = message[i];
+            pkptr[i] = &pubkey[i];
+        }
+        secp256k1_ecdsa_recoverable_signature_load(ctx, &r, &s, &recid, &recsig[0]);
+        secp256k1_ecdsa_recoverable_signature_load(ctx, &r2, &s2, &recid2, &recsig[1]);
+        secp256k1_ecdsa_recoverable_signature_save(&recsig[0], &r, &s2, recid);
+        secp256k1_ecdsa_recoverable_signature_save(&recsig[1], &r2, &s, recid2);
+        CHECK(secp256k1_ecdsa_verify_batch(ctx, scratch_space, sigptr, msgptr, pkptr, n_sigs) == 0);
+    }
+    secp256k1_scratch_space_destroy(ctx, scratch_space);
+}
+#undef N_BATCH_SIGS
+
+void test_ecdsa_verify_batch_high_r(void) {
+    /* Construct a signature whose nonce point has an x coordinate larger than
+     * the group order, which requires recovery ids 2 or 3. Such signatures
+     * cannot be produced by signing with a random nonce, so derive the
+     * public key from the signature instead. */
+    secp256k1_scratch_space *scratch_space = secp256k1_scratch_space_create(ctx, 8192);
+    secp256k1_ecdsa_recoverable_signature recsig;
+    secp256k1_ecdsa_signature sig;
+    secp256k1_pubkey pubkey;
+    unsigned char message[32];
+    unsigned char buf[32];
+    const secp256k1_ecdsa_recoverable_signature *sigptr = &recsig;
+    const unsigned char *msgptr = message;
+    const secp256k1_pubkey *pkptr = &pubkey;
+    secp256k1_scalar r, s, m, rinv, u1, u2;
+    secp256k1_fe x;
+    secp256k1_ge rp, q;
+    secp256k1_gej rpj, qj;
+    int recid;
+
+    x = secp256k1_ecdsa_const_order_as_fe;
+    do {
+        secp256k1_fe_add(&x, &secp256k1_fe_one);
+        secp256k1_fe_normalize_var(&x);
+        recid = 2 | secp256k1_testrand_bits(1);
+    } while (!secp256k1_ge_set_xo_var(&rp, &x, recid & 1));
+    secp256k1_fe_get_b32(buf, &x);
+    secp256k1_scalar_set_b32(&r, buf, NULL);
+    random_scalar_order_test(&s);
+    if (secp256k1_scalar_is_high(&s)) {
+        secp256k1_scalar_negate(&s, &s);
+    }
+    random_scalar_order_test(&m);
+    secp256k1_scalar_get_b32(message, &m);
+
+    /* Q = r^-1 * (s*R - m*G) */
+    secp256k1_scalar_inverse_var(&rinv, &r);
+    secp256k1_scalar_mul(&u1, &rinv, &m);
+    secp256k1_scalar_negate(&u1, &u1);
+    secp256k1_scalar_mul(&u2, &rinv, &s);
+    secp256k1_gej_set_ge(&rpj, &rp);
+    secp256k1_ecmult(&ctx->ecmult_ctx, &qj, &rpj, &u2, &u1);
+    secp256k1_ge_set_gej(&q, &qj);
+    secp256k1_pubkey_save(&pubkey, &q);
+
+    secp256k1_ecdsa_recoverable_signature_save(&recsig, &r, &s, recid);
+    CHECK(secp256k1_ecdsa_recoverable_signature_convert(ctx, &sig, &recsig) == 1);
+    CHECK(secp256k1_ecdsa_verify(ctx, &sig, message, &pubkey) == 1);
+    CHECK(secp256k1_ecdsa_verify_batch(ctx, scratch_space, &sigptr, &msgptr, &pkptr, 1) == 1);
+    secp256k1_ecdsa_recoverable_signature_save(&recsig, &r, &s, recid & 1);
+    CHECK(secp256k1_ecdsa_verify_batch(ctx, scratch_space, &sigptr, &msgptr, &pkptr, 1) == 0);
+    secp256k1_scratch_space_destroy(ctx, scratch_space);
+}
+
 void run_recovery_tests(void) {
     int i;
     for (i = 0; i < count; i++) {
@@ -387,7 +665,17 @@ void run_recovery_tests(void) {
     for (i = 0; i < 64*count; i++) {
         test_ecdsa_recovery_end_to_end();
     }
+    for (i = 0; i < count; i++) {
+        test_ecdsa_recover_batch();
+    }
     test_ecdsa_recovery_edge_cases();
+
+    test_ecdsa_verify_batch_api();
+    test_ecdsa_verify_batch_sha256_tagged();
+    for (i = 0; i < count; i++) {
+        test_ecdsa_verify_batch();
+        test_ecdsa_verify_batch_high_r();
+    }
 }
 
 #endif /* SECP256K1_MODULE_RECOVERY_TESTS_H */
@@ -47,22 +47,46 @@ static void secp256k1_nonce_function_bip340_sha256_tagged_aux(secp256k1_sha256 *
  * by using the correct tagged hash function. */
 static const unsigned char bip340_algo16[16] = "BIP0340/nonce\0\0\0";
 
+/* Set masked_key32 to key32 XOR the tagged hash of aux_rand32, as per BIP-340. */
+static void secp256k1_nonce_function_bip340_mask_key(unsigned char *masked_key32, const unsigned char *key32, const unsigned char *aux_rand32) {
+    secp256k1_sha256 sha;
+    int i;
+
+    secp256k1_nonce_function_bip340_sha256_tagged_aux(&sha);
+    secp256k1_sha256_write(&sha, aux_rand32, 32);
+    secp256k1_sha256_finalize(&sha, masked_key32);
+    for (i = 0; i < 32; i++) {
+        masked_key32[i] ^= key32[i];
+    }
+}
+
+/* Initialize sha with the part of the BIP-340 nonce hash that does not depend
+ * on the message: the tag, then the key (masked if aux_rand32 is non-NULL) and
+ * the public key, which fill exactly one SHA256 block. */
+static void secp256k1_nonce_function_bip340_key_midstate(secp256k1_sha256 *sha, const unsigned char *key32, const unsigned char *xonly_pk32, const unsigned char *aux_rand32) {
+    unsigned char masked_key[32];
+
+    secp256k1_nonce_function_bip340_sha256_tagged(sha);
+    if (aux_rand32 != NULL) {
+        secp256k1_nonce_function_bip340_mask_key(masked_key, key32, aux_rand32);
+        secp256k1_sha256_write(sha, masked_key, 32);
+        memset(masked_key, 0, sizeof(masked_key));
+    } else {
+        secp256k1_sha256_write(sha, key32, 32);
+    }
+    secp256k1_sha256_write(sha, xonly_pk32, 32);
+}
+
 static int nonce_function_bip340(unsigned char *nonce32, const unsigned char *msg32, const unsigned char *key32, const unsigned char *xonly_pk32, const unsigned char *algo16, void *data) {
     secp256k1_sha256 sha;
     unsigned char masked_key[32];
-    int i;
 
     if (algo16 == NULL) {
         return 0;
     }
 
     if (data != NULL) {
-        secp256k1_nonce_function_bip340_sha256_tagged_aux(&sha);
-        secp256k1_sha256_write(&sha, data, 32);
-        secp256k1_sha256_finalize(&sha, masked_key);
-        for (i = 0; i < 32; i++) {
-            masked_key[i] ^= key32[i];
-        }
+        secp256k1_nonce_function_bip340_mask_key(masked_key, key32, data);
     }
 
     /* Tag the hash with algo16 which is important to avoid nonce reuse across
@@ -187,6 +211,221 @@ int secp256k1_schnorrsig_sign(const secp256k1_context* ctx, unsigned char *sig64
     return ret;
 }
 
+/* The number of signatures secp256k1_schnorrsig_sign_batch brings R to affine
+ * coordinates for at once. */
+#define SCHNORRSIG_SIGN_BATCH_SIZE 32
+
+int secp256k1_schnorrsig_sign_batch(const secp256k1_context* ctx, unsigned char *sigs64, const unsigned char * const *msgs32, size_t n, const secp256k1_keypair *keypair, const unsigned char * const *aux_rand32) {
+    secp256k1_scalar k[SCHNORRSIG_SIGN_BATCH_SIZE];
+    secp256k1_gej rj[SCHNORRSIG_SIGN_BATCH_SIZE];
+    secp256k1_ge r[SCHNORRSIG_SIGN_BATCH_SIZE];
+    int valid[SCHNORRSIG_SIGN_BATCH_SIZE];
+    secp256k1_sha256 sha_key, sha;
+    secp256k1_scalar sk;
+    secp256k1_scalar e;
+    secp256k1_ge pk;
+    unsigned char buf[32];
+    unsigned char pk_buf[32];
+    unsigned char seckey[32];
+    size_t i, j, batch;
+    int ret = 1;
+    int all = 1;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(secp256k1_ecmult_gen_context_is_built(&ctx->ecmult_gen_ctx));
+    ARG_CHECK(sigs64 != NULL || n == 0);
+    ARG_CHECK(msgs32 != NULL || n == 0);
+    for (i = 0; i < n; i++) {
+        ARG_CHECK(msgs32[i] != NULL);
+    }
+    ARG_CHECK(keypair != NULL);
+
+    /* The key is loaded once, and hashed into a midstate for the nonces without
+     * auxiliary randomness. */
+    ret &= secp256k1_keypair_load(ctx, &sk, &pk, keypair);
+    if (secp256k1_fe_is_odd(&pk.y)) {
+        secp256k1_scalar_negate(&sk, &sk);
+    }
+    secp256k1_scalar_get_b32(seckey, &sk);
+    secp256k1_fe_get_b32(pk_buf, &pk.x);
+    secp256k1_nonce_function_bip340_key_midstate(&sha_key, seckey, pk_buf, NULL);
+
+    for (i = 0; i < n; i += batch) {
+        batch = n - i < SCHNORRSIG_SIGN_BATCH_SIZE ? n - i : SCHNORRSIG_SIGN_BATCH_SIZE;
+        for (j = 0; j < batch; j++) {
+            if (aux_rand32 != NULL && aux_rand32[i + j] != NULL) {
+                nonce_function_bip340(buf, msgs32[i + j], seckey, pk_buf, bip340_algo16, (void *)aux_rand32[i + j]);
+            } else {
+                sha = sha_key;
+                secp256k1_sha256_write(&sha, msgs32[i + j], 32);
+                secp256k1_sha256_finalize(&sha, buf);
+            }
+            secp256k1_scalar_set_b32(&k[j], buf, NULL);
+            valid[j] = ret & !secp256k1_scalar_is_zero(&k[j]);
+            secp256k1_scalar_cmov(&k[j], &secp256k1_scalar_one, !valid[j]);
+            secp256k1_ecmult_gen(&ctx->ecmult_gen_ctx, &rj[j], &k[j]);
+        }
+        secp256k1_ge_set_all_gej(r, rj, batch);
+
+        for (j = 0; j < batch; j++) {
+            unsigned char *sig64 = &sigs64[64 * (i + j)];
+            /* As in secp256k1_schnorrsig_sign, r is not a secret. */
+            secp256k1_declassify(ctx, &r[j], sizeof(r[j]));
+            secp256k1_fe_normalize_var(&r[j].y);
+            if (secp256k1_fe_is_odd(&r[j].y)) {
+                secp256k1_scalar_negate(&k[j], &k[j]);
+            }
+            secp256k1_fe_normalize_var(&r[j].x);
+            secp256k1_fe_get_b32(&sig64[0], &r[j].x);
+
+            secp256k1_schnorrsig_challenge(&e, &sig64[0], msgs32[i + j], pk_buf);
+            secp256k1_scalar_mul(&e, &e, &sk);
+            secp256k1_scalar_add(&e, &e, &k[j]);
+            secp256k1_scalar_get_b32(&sig64[32], &e);
+            secp256k1_memczero(sig64, 64, !valid[j]);
+            all &= valid[j];
+            secp256k1_scalar_clear(&k[j]);
+        }
+    }
+
+    secp256k1_scalar_clear(&sk);
+    memset(seckey, 0, sizeof(seckey));
+    memset(buf, 0, sizeof(buf));
+    memset(&sha_key, 0, sizeof(sha_key));
+    memset(&sha, 0, sizeof(sha));
+
+    return all & ret;
+}
+
+/* A session holds the nonce midstate after key||pk (data[0..31]), the secret key
+ * negated if needed for an even Y (data[32..63]), and the x-only public key
+ * (data[64..95]). */
+int secp256k1_schnorrsig_session_init(const secp256k1_context* ctx, secp256k1_schnorrsig_session *session, const secp256k1_keypair *keypair, const unsigned char *aux_rand32) {
+    secp256k1_sha256 sha;
+    secp256k1_scalar sk;
+    secp256k1_ge pk;
+    int ret;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(session != NULL);
+    memset(session, 0, sizeof(*session));
+    ARG_CHECK(keypair != NULL);
+
+    ret = secp256k1_keypair_load(ctx, &sk, &pk, keypair);
+    if (!ret) {
+        return 0;
+    }
+    /* As in secp256k1_schnorrsig_sign, sign for the key with an even Y. */
+    if (secp256k1_fe_is_odd(&pk.y)) {
+        secp256k1_scalar_negate(&sk, &sk);
+    }
+    secp256k1_scalar_get_b32(&session->data[32], &sk);
+    secp256k1_fe_get_b32(&session->data[64], &pk.x);
+    secp256k1_nonce_function_bip340_key_midstate(&sha, &session->data[32], &session->data[64], aux_rand32);
+    secp256k1_sha256_save_midstate(&session->data[0], &sha);
+
+    secp256k1_scalar_clear(&sk);
+    memset(&sha, 0, sizeof(sha));
+    return 1;
+}
+
+int secp256k1_schnorrsig_sign_session(const secp256k1_context* ctx, unsigned char *sig64, const unsigned char *msg32, const secp256k1_schnorrsig_session *session) {
+    secp256k1_sha256 sha;
+    secp256k1_scalar sk;
+    secp256k1_scalar e;
+    secp256k1_scalar k;
+    secp256k1_gej rj;
+    secp256k1_ge r;
+    unsigned char buf[32];
+    int ret;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(secp256k1_ecmult_gen_context_is_built(&ctx->ecmult_gen_ctx));
+    ARG_CHECK(sig64 != NULL);
+    ARG_CHECK(msg32 != NULL);
+    ARG_CHECK(session != NULL);
+
+    ret = secp256k1_scalar_set_b32_seckey(&sk, &session->data[32]);
+    /* As for keypairs, sk is only zero if secp256k1_schnorrsig_session_init
+     * failed (which zeroes the session) and its return value was ignored. */
+    secp256k1_declassify(ctx, &ret, sizeof(ret));
+    ARG_CHECK(ret);
+
+    /* Only the message block is left to hash for the nonce. */
+    secp256k1_sha256_load_midstate(&sha, &session->data[0]);
+    sha.bytes = 128;
+    secp256k1_sha256_write(&sha, msg32, 32);
+    secp256k1_sha256_finalize(&sha, buf);
+    secp256k1_scalar_set_b32(&k, buf, NULL);
+    ret = !secp256k1_scalar_is_zero(&k);
+    secp256k1_scalar_cmov(&k, &secp256k1_scalar_one, !ret);
+
+    secp256k1_ecmult_gen(&ctx->ecmult_gen_ctx, &rj, &k);
+    secp256k1_ge_set_gej(&r, &rj);
+
+    /* As in secp256k1_schnorrsig_sign, r is not a secret. */
+    secp256k1_declassify(ctx, &r, sizeof(r));
+    secp256k1_fe_normalize_var(&r.y);
+    if (secp256k1_fe_is_odd(&r.y)) {
+        secp256k1_scalar_negate(&k, &k);
+    }
+    secp256k1_fe_normalize_var(&r.x);
+    secp256k1_fe_get_b32(&sig64[0], &r.x);
+
+    secp256k1_schnorrsig_challenge(&e, &sig64[0], msg32, &session->data[64]);
+    secp256k1_scalar_mul(&e, &e, &sk);
+    secp256k1_scalar_add(&e, &e, &k);
+    secp256k1_scalar_get_b32(&sig64[32], &e);
+
+    secp256k1_memczero(sig64, 64, !ret);
+    secp256k1_scalar_clear(&k);
+    secp256k1_scalar_clear(&sk);
+    memset(buf, 0, sizeof(buf));
+    memset(&sha, 0, sizeof(sha));
+
+    return ret;
+}
+
+int secp256k1_schnorrsig_sign_pooled(const secp256k1_context* ctx, unsigned char *sig64, const unsigned char *msg32, const secp256k1_keypair *keypair, secp256k1_nonce_pool *pool) {
+    secp256k1_nonce_pool_entry entry;
+    secp256k1_scalar sk;
+    secp256k1_scalar e;
+    secp256k1_ge pk;
+    unsigned char pk_buf[32];
+    int ret;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(sig64 != NULL);
+    ARG_CHECK(msg32 != NULL);
+    ARG_CHECK(keypair != NULL);
+    ARG_CHECK(pool != NULL);
+
+    memset(sig64, 0, 64);
+    if (!secp256k1_nonce_pool_take(pool, &entry)) {
+        return 0;
+    }
+    ret = secp256k1_keypair_load(ctx, &sk, &pk, keypair);
+    /* As in secp256k1_schnorrsig_sign, sign for the key with an even Y. */
+    if (secp256k1_fe_is_odd(&pk.y)) {
+        secp256k1_scalar_negate(&sk, &sk);
+    }
+    secp256k1_fe_get_b32(pk_buf, &pk.x);
+
+    /* The pool stores nonces for which R has an even Y. */
+    memcpy(&sig64[0], entry.rx, 32);
+    secp256k1_schnorrsig_challenge(&e, &sig64[0], msg32, pk_buf);
+    secp256k1_scalar_mul(&e, &e, &sk);
+    secp256k1_scalar_add(&e, &e, &entry.k);
+    secp256k1_scalar_get_b32(&sig64[32], &e);
+
+    secp256k1_memczero(sig64, 64, !ret);
+    secp256k1_nonce_pool_entry_clear(&entry);
+    secp256k1_scalar_clear(&e);
+    secp256k1_scalar_clear(&sk);
+
+    return ret;
+}
+
 int secp256k1_schnorrsig_verify(const secp256k1_context* ctx, const unsigned char *sig64, const unsigned char *msg32, const secp256k1_xonly_pubkey *pubkey) {
     secp256k1_scalar s;
     secp256k1_scalar e;
@@ -236,4 +475,244 @@ int secp256k1_schnorrsig_verify(const secp256k1_context* ctx, const unsigned cha
            secp256k1_fe_equal_var(&rx, &r.x);
 }
 
+int secp256k1_schnorrsig_verify_prepared(const secp256k1_context* ctx, const unsigned char *sig64, const unsigned char *msg32, const secp256k1_pubkey_prepared *prepared) {
+    secp256k1_scalar s;
+    secp256k1_scalar e;
+    secp256k1_gej rj;
+    secp256k1_ge pk;
+    secp256k1_fe rx;
+    secp256k1_ge r;
+    unsigned char buf[32];
+    int overflow;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(sig64 != NULL);
+    ARG_CHECK(msg32 != NULL);
+    ARG_CHECK(prepared != NULL);
+
+    if (!secp256k1_fe_set_b32(&rx, &sig64[0])) {
+        return 0;
+    }
+
+    secp256k1_scalar_set_b32(&s, &sig64[32], &overflow);
+    if (overflow) {
+        return 0;
+    }
+
+    /* The first table entry is the key itself. */
+    secp256k1_ge_from_storage(&pk, &prepared->point.pre_a[0]);
+
+    /* Compute e. */
+    secp256k1_fe_get_b32(buf, &pk.x);
+    secp256k1_schnorrsig_challenge(&e, &sig64[0], msg32, buf);
+
+    /* Compute rj =  s*G + (-e)*pkj, where pkj is the key with even y. The tables
+     * are those of the key as given, which is -pkj if its y is odd. */
+    if (!secp256k1_fe_is_odd(&pk.y)) {
+        secp256k1_scalar_negate(&e, &e);
+    }
+    secp256k1_ecmult_prepared(&ctx->ecmult_ctx, &rj, &prepared->point, &e, &s);
+
+    secp256k1_ge_set_gej_var(&r, &rj);
+    if (secp256k1_ge_is_infinity(&r)) {
+        return 0;
+    }
+
+    secp256k1_fe_normalize_var(&r.y);
+    return !secp256k1_fe_is_odd(&r.y) &&
+           secp256k1_fe_equal_var(&rx, &r.x);
+}
+
+int secp256k1_schnorrsig_verify_cached(const secp256k1_context* ctx, secp256k1_sigcache *cache, const unsigned char *sig64, const unsigned char *msg32, const secp256k1_xonly_pubkey *pubkey) {
+    static const unsigned char tag = 'S';
+    secp256k1_sha256 hash;
+    secp256k1_ge pk;
+    unsigned char buf[32];
+    uint64_t entry[2];
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(cache != NULL);
+    ARG_CHECK(sig64 != NULL);
+    ARG_CHECK(msg32 != NULL);
+    ARG_CHECK(pubkey != NULL);
+
+    if (!secp256k1_xonly_pubkey_load(ctx, &pk, pubkey)) {
+        return 0;
+    }
+
+    /* Signatures have a single encoding, so their bytes identify them. */
+    secp256k1_sigcache_hasher(cache, &hash);
+    secp256k1_sha256_write(&hash, &tag, 1);
+    secp256k1_sha256_write(&hash, sig64, 64);
+    secp256k1_sha256_write(&hash, msg32, 32);
+    secp256k1_fe_get_b32(buf, &pk.x);
+    secp256k1_sha256_write(&hash, buf, 32);
+    secp256k1_sigcache_entry(entry, &hash);
+    if (secp256k1_sigcache_lookup(cache, entry)) {
+        return 1;
+    }
+
+    if (!secp256k1_schnorrsig_verify(ctx, sig64, msg32, pubkey)) {
+        return 0;
+    }
+    secp256k1_sigcache_insert(cache, entry);
+    return 1;
+}
+
+/* Data that is used by the batch verification ecmult callback */
+typedef struct {
+    const secp256k1_context *ctx;
+    /* Seed for the randomizers, committing to all signatures, messages and
+     * public keys of the batch */
+    unsigned char seed[32];
+    /* Caches the randomizer of the signature with index randomizer_idx. The
+     * callback is called twice per signature, so caching avoids hashing
+     * twice as often. */
+    secp256k1_scalar randomizer;
+    size_t randomizer_idx;
+    /* Signature, message, public key tuples to verify */
+    const unsigned char *const *sig;
+    const unsigned char *const *msg32;
+    const secp256k1_xonly_pubkey *const *pk;
+    size_t n_sigs;
+} secp256k1_schnorrsig_verify_ecmult_context;
+
+/* Initializes SHA256 with fixed midstate. This midstate was computed by applying
+ * SHA256 to SHA256("BIP0340/batch")||SHA256("BIP0340/batch"). */
+static void secp256k1_schnorrsig_sha256_tagged_batch(secp256k1_sha256 *sha) {
+    secp256k1_sha256_initialize(sha);
+    sha->s[0] = 0x79e3e0d2ul;
+    sha->s[1] = 0x12284f32ul;
+    sha->s[2] = 0xd7d89e1cul;
+    sha->s[3] = 0x6491ea9aul;
+    sha->s[4] = 0xad823b2ful;
+    sha->s[5] = 0xfacfe0b6ul;
+    sha->s[6] = 0x342b78baul;
+    sha->s[7] = 0x12ece87cul;
+    sha->bytes = 64;
+}
+
+/* Computes the randomizer of the idx-th signature from the seed. The first
+ * randomizer is always 1, which saves a scalar multiplication and does not
+ * reduce security because only the ratios of the randomizers matter. */
+static void secp256k1_schnorrsig_verify_batch_randomizer(secp256k1_scalar *r, const unsigned char *seed32, size_t idx) {
+    secp256k1_sha256 sha;
+    unsigned char buf[32];
+    int i;
+
+    if (idx == 0) {
+        secp256k1_scalar_set_int(r, 1);
+        return;
+    }
+    for (i = 0; i < 8; i++) {
+        buf[i] = (unsigned char)((uint64_t)idx >> (8 * i));
+    }
+    secp256k1_sha256_initialize(&sha);
+    secp256k1_sha256_write(&sha, seed32, 32);
+    secp256k1_sha256_write(&sha, buf, 8);
+    secp256k1_sha256_finalize(&sha, buf);
+    secp256k1_scalar_set_b32(r, buf, NULL);
+}
+
+/* Callback function which is called by ecmult_multi in order to convert the ecmult_context
+ * consisting of signature, message and public key tuples into scalars and points. Every
+ * signature results in two (scalar,point)-tuples:
+ * (randomizer, R)
+ * (randomizer*e, P) */
+static int secp256k1_schnorrsig_verify_batch_ecmult_callback(secp256k1_scalar *sc, secp256k1_ge *pt, size_t idx, void *data) {
+    secp256k1_schnorrsig_verify_ecmult_context *ecmult_context = (secp256k1_schnorrsig_verify_ecmult_context *) data;
+    size_t sig_idx = idx / 2;
+
+    VERIFY_CHECK(sig_idx < ecmult_context->n_sigs);
+    if (ecmult_context->randomizer_idx != sig_idx) {
+        secp256k1_schnorrsig_verify_batch_randomizer(&ecmult_context->randomizer, ecmult_context->seed, sig_idx);
+        ecmult_context->randomizer_idx = sig_idx;
+    }
+
+    if (idx % 2 == 0) {
+        secp256k1_fe rx;
+        *sc = ecmult_context->randomizer;
+        if (!secp256k1_fe_set_b32(&rx, &ecmult_context->sig[sig_idx][0])) {
+            return 0;
+        }
+        if (!secp256k1_ge_set_xo_var(pt, &rx, 0)) {
+            return 0;
+        }
+    } else {
+        unsigned char buf[32];
+        if (!secp256k1_xonly_pubkey_load(ecmult_context->ctx, pt, ecmult_context->pk[sig_idx])) {
+            return 0;
+        }
+        secp256k1_fe_get_b32(buf, &pt->x);
+        secp256k1_schnorrsig_challenge(sc, &ecmult_context->sig[sig_idx][0], ecmult_context->msg32[sig_idx], buf);
+        secp256k1_scalar_mul(sc, sc, &ecmult_context->randomizer);
+    }
+    return 1;
+}
+
+int secp256k1_schnorrsig_verify_batch(const secp256k1_context *ctx, secp256k1_scratch *scratch, const unsigned char *const *sig, const unsigned char *const *msg32, const secp256k1_xonly_pubkey *const *pk, size_t n_sigs) {
+    secp256k1_schnorrsig_verify_ecmult_context ecmult_context;
+    secp256k1_sha256 sha;
+    secp256k1_scalar s;
+    secp256k1_gej rj;
+    size_t i;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(scratch != NULL);
+    /* Check that n_sigs is less than half of the maximum size_t value. This is necessary because
+     * the number of points given to ecmult_multi is 2*n_sigs. */
+    ARG_CHECK(n_sigs <= SIZE_MAX / 2);
+    /* Check that n_sigs is less than 2^31 to ensure the same behavior of this function on 32-bit
+     * and 64-bit platforms. */
+    ARG_CHECK(n_sigs < ((uint32_t)1 << 31));
+    ARG_CHECK(n_sigs == 0 || (sig != NULL && msg32 != NULL && pk != NULL));
+
+    /* Derive the seed for the randomizers from all inputs so that an attacker
+     * cannot choose invalid signatures that cancel out in the combination. */
+    secp256k1_schnorrsig_sha256_tagged_batch(&sha);
+    for (i = 0; i < n_sigs; i++) {
+        secp256k1_ge pk_ge;
+        unsigned char buf[32];
+        ARG_CHECK(sig[i] != NULL);
+        ARG_CHECK(msg32[i] != NULL);
+        ARG_CHECK(pk[i] != NULL);
+        if (!secp256k1_xonly_pubkey_load(ctx, &pk_ge, pk[i])) {
+            return 0;
+        }
+        secp256k1_fe_get_b32(buf, &pk_ge.x);
+        secp256k1_sha256_write(&sha, sig[i], 64);
+        secp256k1_sha256_write(&sha, msg32[i], 32);
+        secp256k1_sha256_write(&sha, buf, 32);
+    }
+    ecmult_context.ctx = ctx;
+    secp256k1_sha256_finalize(&sha, ecmult_context.seed);
+    ecmult_context.sig = sig;
+    ecmult_context.msg32 = msg32;
+    ecmult_context.pk = pk;
+    ecmult_context.n_sigs = n_sigs;
+
+    /* Compute s = -sum(randomizer_i * s_i), the scalar of the generator. */
+    secp256k1_scalar_set_int(&s, 0);
+    for (i = 0; i < n_sigs; i++) {
+        int overflow;
+        secp256k1_scalar term;
+        secp256k1_scalar_set_b32(&term, &sig[i][32], &overflow);
+        if (overflow) {
+            return 0;
+        }
+        secp256k1_schnorrsig_verify_batch_randomizer(&ecmult_context.randomizer, ecmult_context.seed, i);
+        secp256k1_scalar_mul(&term, &term, &ecmult_context.randomizer);
+        secp256k1_scalar_add(&s, &s, &term);
+    }
+    secp256k1_scalar_negate(&s, &s);
+    /* Invalidate the cache, the callback starts at the first signature. */
+    ecmult_context.randomizer_idx = SIZE_MAX;
+
+    return secp256k1_ecmult_multi_var(&ctx->error_callback, &ctx->ecmult_ctx, scratch, &rj, &s, secp256k1_schnorrsig_verify_batch_ecmult_callback, (void *) &ecmult_context, 2 * n_sigs)
+            && secp256k1_gej_is_infinity(&rj);
+}
+
 #endif
@@ -9,6 +9,8 @@
 
 #include "secp256k1_schnorrsig.h"
 
+static secp256k1_scratch_space *scratch;
+
 /* Checks that a bit flip in the n_flip-th argument (that has n_bytes many
  * bytes) changes the hash function
  */
@@ -107,6 +109,9 @@ void test_schnorrsig_api(void) {
     secp256k1_xonly_pubkey pk[3];
     secp256k1_xonly_pubkey zero_pk;
     unsigned char sig[64];
+    const unsigned char *sigptr[1];
+    const unsigned char *msgptr[1];
+    const secp256k1_xonly_pubkey *pkptr[1];
 
     /** setup **/
     secp256k1_context *none = secp256k1_context_create(SECP256K1_CONTEXT_NONE);
@@ -135,6 +140,9 @@ void test_schnorrsig_api(void) {
     CHECK(secp256k1_keypair_xonly_pub(ctx, &pk[1], NULL, &keypairs[1]) == 1);
     CHECK(secp256k1_keypair_xonly_pub(ctx, &pk[2], NULL, &keypairs[2]) == 1);
     memset(&zero_pk, 0, sizeof(zero_pk));
+    sigptr[0] = sig;
+    msgptr[0] = msg;
+    pkptr[0] = &pk[0];
 
     /** main test body **/
     ecount = 0;
@@ -169,6 +177,33 @@ void test_schnorrsig_api(void) {
     CHECK(ecount == 5);
     CHECK(secp256k1_schnorrsig_verify(vrfy, sig, msg, &zero_pk) == 0);
     CHECK(ecount == 6);
+    CHECK(secp256k1_schnorrsig_verify_prepared(vrfy, sig, msg, NULL) == 0);
+    CHECK(ecount == 7);
+
+    ecount = 0;
+    CHECK(secp256k1_schnorrsig_verify_batch(none, scratch, sigptr, msgptr, pkptr, 1) == 0);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_schnorrsig_verify_batch(sign, scratch, sigptr, msgptr, pkptr, 1) == 0);
+    CHECK(ecount == 2);
+    CHECK(secp256k1_schnorrsig_verify_batch(vrfy, scratch, sigptr, msgptr, pkptr, 1) == 1);
+    CHECK(ecount == 2);
+    CHECK(secp256k1_schnorrsig_verify_batch(vrfy, scratch, NULL, NULL, NULL, 0) == 1);
+    CHECK(ecount == 2);
+    CHECK(secp256k1_schnorrsig_verify_batch(vrfy, scratch, NULL, msgptr, pkptr, 1) == 0);
+    CHECK(ecount == 3);
+    CHECK(secp256k1_schnorrsig_verify_batch(vrfy, scratch, sigptr, NULL, pkptr, 1) == 0);
+    CHECK(ecount == 4);
+    CHECK(secp256k1_schnorrsig_verify_batch(vrfy, scratch, sigptr, msgptr, NULL, 1) == 0);
+    CHECK(ecount == 5);
+    CHECK(secp256k1_schnorrsig_verify_batch(vrfy, scratch, sigptr, msgptr, pkptr, (size_t)1 << (sizeof(size_t)*8-1)) == 0);
+    CHECK(ecount == 6);
+    CHECK(secp256k1_schnorrsig_verify_batch(vrfy, scratch, sigptr, msgptr, pkptr, 1 << 31) == 0);
+    CHECK(ecount == 7);
+    CHECK(secp256k1_schnorrsig_verify_batch(vrfy, NULL, sigptr, msgptr, pkptr, 1) == 0);
+    CHECK(ecount == 8);
+    pkptr[0] = &zero_pk;
+    CHECK(secp256k1_schnorrsig_verify_batch(vrfy, scratch, sigptr, msgptr, pkptr, 1) == 0);
+    CHECK(ecount == 9);
 
     secp256k1_context_destroy(none);
     secp256k1_context_destroy(sign);
@@ -176,16 +211,21 @@ void test_schnorrsig_api(void) {
     secp256k1_context_destroy(both);
 }
 
-/* Checks that hash initialized by secp256k1_schnorrsig_sha256_tagged has the
- * expected state. */
+/* Checks that hash initialized by secp256k1_schnorrsig_sha256_tagged and
+ * secp256k1_schnorrsig_sha256_tagged_batch have the expected state. */
 void test_schnorrsig_sha256_tagged(void) {
     char tag[17] = "BIP0340/challenge";
+    char batch_tag[13] = "BIP0340/batch";
     secp256k1_sha256 sha;
     secp256k1_sha256 sha_optimized;
 
     secp256k1_sha256_initialize_tagged(&sha, (unsigned char *) tag, sizeof(tag));
     secp256k1_schnorrsig_sha256_tagged(&sha_optimized);
     test_sha256_eq(&sha, &sha_optimized);
+
+    secp256k1_sha256_initialize_tagged(&sha, (unsigned char *) batch_tag, sizeof(batch_tag));
+    secp256k1_schnorrsig_sha256_tagged_batch(&sha_optimized);
+    test_sha256_eq(&sha, &sha_optimized);
 }
 
 /* Helper function for schnorrsig_bip_vectors
@@ -193,11 +233,15 @@ void test_schnorrsig_sha256_tagged(void) {
 void test_schnorrsig_bip_vectors_check_signing(const unsigned char *sk, const unsigned char *pk_serialized, unsigned char *aux_rand, const unsigned char *msg, const unsigned char *expected_sig) {
     unsigned char sig[64];
     secp256k1_keypair keypair;
+    secp256k1_schnorrsig_session session;
     secp256k1_xonly_pubkey pk, pk_expected;
 
     CHECK(secp256k1_keypair_create(ctx, &keypair, sk));
     CHECK(secp256k1_schnorrsig_sign(ctx, sig, msg, &keypair, NULL, aux_rand));
     CHECK(secp256k1_memcmp_var(sig, expected_sig, 64) == 0);
+    CHECK(secp256k1_schnorrsig_session_init(ctx, &session, &keypair, aux_rand));
+    CHECK(secp256k1_schnorrsig_sign_session(ctx, sig, msg, &session));
+    CHECK(secp256k1_memcmp_var(sig, expected_sig, 64) == 0);
 
     CHECK(secp256k1_xonly_pubkey_parse(ctx, &pk_expected, pk_serialized));
     CHECK(secp256k1_keypair_xonly_pub(ctx, &pk, NULL, &keypair));
@@ -206,12 +250,33 @@ void test_schnorrsig_bip_vectors_check_signing(const unsigned char *sk, const un
 }
 
 /* Helper function for schnorrsig_bip_vectors
- * Checks that both verify and verify_batch (TODO) return the same value as expected. */
+ * Checks that both verify and verify_batch return the same value as expected. */
 void test_schnorrsig_bip_vectors_check_verify(const unsigned char *pk_serialized, const unsigned char *msg32, const unsigned char *sig, int expected) {
+    const unsigned char *msg_arr[1];
+    const unsigned char *sig_arr[1];
+    const secp256k1_xonly_pubkey *pk_arr[1];
     secp256k1_xonly_pubkey pk;
+    secp256k1_pubkey pubkey;
+    secp256k1_pubkey_prepared *prepared;
+    unsigned char pubkey_serialized[33];
+
+    sig_arr[0] = sig;
+    msg_arr[0] = msg32;
+    pk_arr[0] = &pk;
 
     CHECK(secp256k1_xonly_pubkey_parse(ctx, &pk, pk_serialized));
     CHECK(expected == secp256k1_schnorrsig_verify(ctx, sig, msg32, &pk));
+    CHECK(expected == secp256k1_schnorrsig_verify_batch(ctx, scratch, sig_arr, msg_arr, pk_arr, 1));
+
+    /* Both points with this X coordinate stand for the same x-only key. */
+    memcpy(&pubkey_serialized[1], pk_serialized, 32);
+    for (pubkey_serialized[0] = 2; pubkey_serialized[0] <= 3; pubkey_serialized[0]++) {
+        CHECK(secp256k1_ec_pubkey_parse(ctx, &pubkey, pubkey_serialized, 33));
+        prepared = secp256k1_pubkey_prepared_create(ctx, &pubkey);
+        CHECK(prepared != NULL);
+        CHECK(expected == secp256k1_schnorrsig_verify_prepared(ctx, sig, msg32, prepared));
+        secp256k1_pubkey_prepared_destroy(ctx, prepared);
+    }
 }
 
 /* Test vectors according to BIP-340 ("Schnorr Signatures for secp256k1"). See
@@ -692,12 +757,15 @@ void test_schnorrsig_sign(void) {
 
 #define N_SIGS 3
 /* Creates N_SIGS valid signatures and verifies them with verify and
- * verify_batch (TODO). Then flips some bits and checks that verification now
+ * verify_batch. Then flips some bits and checks that verification now
  * fails. */
 void test_schnorrsig_sign_verify(void) {
     unsigned char sk[32];
     unsigned char msg[N_SIGS][32];
     unsigned char sig[N_SIGS][64];
+    const unsigned char *sig_arr[N_SIGS];
+    const unsigned char *msg_arr[N_SIGS];
+    const secp256k1_xonly_pubkey *pk_arr[N_SIGS];
     size_t i;
     secp256k1_keypair keypair;
     secp256k1_xonly_pubkey pk;
@@ -711,30 +779,38 @@ void test_schnorrsig_sign_verify(void) {
         secp256k1_testrand256(msg[i]);
         CHECK(secp256k1_schnorrsig_sign(ctx, sig[i], msg[i], &keypair, NULL, NULL));
         CHECK(secp256k1_schnorrsig_verify(ctx, sig[i], msg[i], &pk));
+        sig_arr[i] = sig[i];
+        msg_arr[i] = msg[i];
+        pk_arr[i] = &pk;
     }
+    CHECK(secp256k1_schnorrsig_verify_batch(ctx, scratch, sig_arr, msg_arr, pk_arr, N_SIGS));
 
     {
         /* Flip a few bits in the signature and in the message and check that
-         * verify and verify_batch (TODO) fail */
+         * verify and verify_batch fail */
         size_t sig_idx = secp256k1_testrand_int(N_SIGS);
         size_t byte_idx = secp256k1_testrand_int(32);
         unsigned char xorbyte = secp256k1_testrand_int(254)+1;
         sig[sig_idx][byte_idx] ^= xorbyte;
         CHECK(!secp256k1_schnorrsig_verify(ctx, sig[sig_idx], msg[sig_idx], &pk));
+        CHECK(!secp256k1_schnorrsig_verify_batch(ctx, scratch, sig_arr, msg_arr, pk_arr, N_SIGS));
         sig[sig_idx][byte_idx] ^= xorbyte;
 
         byte_idx = secp256k1_testrand_int(32);
         sig[sig_idx][32+byte_idx] ^= xorbyte;
         CHECK(!secp256k1_schnorrsig_verify(ctx, sig[sig_idx], msg[sig_idx], &pk));
+        CHECK(!secp256k1_schnorrsig_verify_batch(ctx, scratch, sig_arr, msg_arr, pk_arr, N_SIGS));
         sig[sig_idx][32+byte_idx] ^= xorbyte;
 
         byte_idx = secp256k1_testrand_int(32);
         msg[sig_idx][byte_idx] ^= xorbyte;
         CHECK(!secp256k1_schnorrsig_verify(ctx, sig[sig_idx], msg[sig_idx], &pk));
+        CHECK(!secp256k1_schnorrsig_verify_batch(ctx, scratch, sig_arr, msg_arr, pk_arr, N_SIGS));
         msg[sig_idx][byte_idx] ^= xorbyte;
 
         /* Check that above bitflips have been reversed correctly */
         CHECK(secp256k1_schnorrsig_verify(ctx, sig[sig_idx], msg[sig_idx], &pk));
+        CHECK(secp256k1_schnorrsig_verify_batch(ctx, scratch, sig_arr, msg_arr, pk_arr, N_SIGS));
     }
 
     /* Test overflowing s */
@@ -742,6 +818,7 @@ void test_schnorrsig_sign_verify(void) {
     CHECK(secp256k1_schnorrsig_verify(ctx, sig[0], msg[0], &pk));
     memset(&sig[0][32], 0xFF, 32);
     CHECK(!secp256k1_schnorrsig_verify(ctx, sig[0], msg[0], &pk));
+    CHECK(!secp256k1_schnorrsig_verify_batch(ctx, scratch, sig_arr, msg_arr, pk_arr, N_SIGS));
 
     /* Test negative s */
     CHECK(secp256k1_schnorrsig_sign(ctx, sig[0], msg[0], &keypair, NULL, NULL));
@@ -750,9 +827,72 @@ void test_schnorrsig_sign_verify(void) {
     secp256k1_scalar_negate(&s, &s);
     secp256k1_scalar_get_b32(&sig[0][32], &s);
     CHECK(!secp256k1_schnorrsig_verify(ctx, sig[0], msg[0], &pk));
+    CHECK(!secp256k1_schnorrsig_verify_batch(ctx, scratch, sig_arr, msg_arr, pk_arr, N_SIGS));
+
+    /* The s values of two signatures can be swapped without changing the sum
+     * of the s values, which the randomizers must catch. */
+    CHECK(secp256k1_schnorrsig_sign(ctx, sig[0], msg[0], &keypair, NULL, NULL));
+    for (i = 0; i < 32; i++) {
+        unsigned char tmp = sig[0][32 + i];
+        sig[0][32 + i] = sig[1][32 + i];
+        sig[1][32 + i] = tmp;
+    }
+    CHECK(!secp256k1_schnorrsig_verify_batch(ctx, scratch, sig_arr, msg_arr, pk_arr, N_SIGS));
 }
 #undef N_SIGS
 
+/* Verifies batches whose sizes exceed what fits into small scratch spaces, so
+ * that ecmult_multi has to split them up, and checks that a single invalid
+ * signature is always detected. */
+void test_schnorrsig_verify_batch_sizes(void) {
+    const size_t n_max = 64;
+    unsigned char sk[32];
+    unsigned char (*msg)[32] = (unsigned char (*)[32])checked_malloc(&ctx->error_callback, n_max * 32);
+    unsigned char (*sig)[64] = (unsigned char (*)[64])checked_malloc(&ctx->error_callback, n_max * 64);
+    secp256k1_xonly_pubkey *pk = (secp256k1_xonly_pubkey *)checked_malloc(&ctx->error_callback, n_max * sizeof(*pk));
+    secp256k1_keypair *keypair = (secp256k1_keypair *)checked_malloc(&ctx->error_callback, n_max * sizeof(*keypair));
+    const unsigned char **sig_arr = (const unsigned char **)checked_malloc(&ctx->error_callback, n_max * sizeof(*sig_arr));
+    const unsigned char **msg_arr = (const unsigned char **)checked_malloc(&ctx->error_callback, n_max * sizeof(*msg_arr));
+    const secp256k1_xonly_pubkey **pk_arr = (const secp256k1_xonly_pubkey **)checked_malloc(&ctx->error_callback, n_max * sizeof(*pk_arr));
+    secp256k1_scratch_space *small_scratch = secp256k1_scratch_space_create(ctx, secp256k1_strauss_scratch_size(5) + STRAUSS_SCRATCH_OBJECTS*ALIGNMENT);
+    size_t i, n;
+
+    for (i = 0; i < n_max; i++) {
+        secp256k1_testrand256(sk);
+        secp256k1_testrand256(msg[i]);
+        CHECK(secp256k1_keypair_create(ctx, &keypair[i], sk));
+        CHECK(secp256k1_keypair_xonly_pub(ctx, &pk[i], NULL, &keypair[i]));
+        CHECK(secp256k1_schnorrsig_sign(ctx, sig[i], msg[i], &keypair[i], NULL, NULL));
+        sig_arr[i] = sig[i];
+        msg_arr[i] = msg[i];
+        pk_arr[i] = &pk[i];
+    }
+
+    for (n = 1; n <= n_max; n += 1 + secp256k1_testrand_int(16)) {
+        size_t bad = secp256k1_testrand_int(n);
+        CHECK(secp256k1_schnorrsig_verify_batch(ctx, scratch, sig_arr, msg_arr, pk_arr, n));
+        CHECK(secp256k1_schnorrsig_verify_batch(ctx, small_scratch, sig_arr, msg_arr, pk_arr, n));
+        msg[bad][0] ^= 1;
+        CHECK(!secp256k1_schnorrsig_verify_batch(ctx, scratch, sig_arr, msg_arr, pk_arr, n));
+        CHECK(!secp256k1_schnorrsig_verify_batch(ctx, small_scratch, sig_arr, msg_arr, pk_arr, n));
+        msg[bad][0] ^= 1;
+        /* A signature with an R that is not on the curve makes the batch fail. */
+        memset(sig[bad], 0xFF, 32);
+        CHECK(!secp256k1_schnorrsig_verify_batch(ctx, scratch, sig_arr, msg_arr, pk_arr, n));
+        CHECK(!secp256k1_schnorrsig_verify_batch(ctx, small_scratch, sig_arr, msg_arr, pk_arr, n));
+        CHECK(secp256k1_schnorrsig_sign(ctx, sig[bad], msg[bad], &keypair[bad], NULL, NULL));
+    }
+
+    secp256k1_scratch_space_destroy(ctx, small_scratch);
+    free(msg);
+    free(sig);
+    free(pk);
+    free(keypair);
+    free(sig_arr);
+    free(msg_arr);
+    free(pk_arr);
+}
+
 void test_schnorrsig_taproot(void) {
     unsigned char sk[32];
     secp256k1_keypair keypair;
@@ -789,8 +929,196 @@ void test_schnorrsig_taproot(void) {
     CHECK(secp256k1_xonly_pubkey_tweak_add_check(ctx, output_pk_bytes, pk_parity, &internal_pk, tweak) == 1);
 }
 
+void test_schnorrsig_verify_cached(void) {
+    unsigned char sk[32];
+    unsigned char salt[32];
+    unsigned char msg[32];
+    unsigned char sig[64];
+    secp256k1_keypair keypair;
+    secp256k1_xonly_pubkey pk;
+    secp256k1_sigcache *cache;
+    size_t hits, misses;
+    int ecount = 0;
+
+    secp256k1_testrand256(sk);
+    secp256k1_testrand256(salt);
+    secp256k1_testrand256(msg);
+    CHECK(secp256k1_keypair_create(ctx, &keypair, sk));
+    CHECK(secp256k1_keypair_xonly_pub(ctx, &pk, NULL, &keypair));
+    CHECK(secp256k1_schnorrsig_sign(ctx, sig, msg, &keypair, NULL, NULL));
+    cache = secp256k1_sigcache_create(ctx, 16, salt);
+    CHECK(cache != NULL);
+
+    secp256k1_context_set_illegal_callback(ctx, counting_illegal_callback_fn, &ecount);
+    CHECK(secp256k1_schnorrsig_verify_cached(ctx, NULL, sig, msg, &pk) == 0);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_schnorrsig_verify_cached(ctx, cache, NULL, msg, &pk) == 0);
+    CHECK(ecount == 2);
+    CHECK(secp256k1_schnorrsig_verify_cached(ctx, cache, sig, NULL, &pk) == 0);
+    CHECK(ecount == 3);
+    CHECK(secp256k1_schnorrsig_verify_cached(ctx, cache, sig, msg, NULL) == 0);
+    CHECK(ecount == 4);
+    secp256k1_context_set_illegal_callback(ctx, NULL, NULL);
+
+    CHECK(secp256k1_schnorrsig_verify_cached(ctx, cache, sig, msg, &pk) == 1);
+    CHECK(secp256k1_schnorrsig_verify_cached(ctx, cache, sig, msg, &pk) == 1);
+    sig[63] ^= 1;
+    CHECK(secp256k1_schnorrsig_verify_cached(ctx, cache, sig, msg, &pk) == 0);
+    secp256k1_sigcache_stats(ctx, cache, &hits, &misses, NULL);
+    CHECK(hits == 1);
+    CHECK(misses == 2);
+    secp256k1_sigcache_destroy(ctx, cache);
+}
+
+void test_schnorrsig_sign_batch(void) {
+    /* Compared to signing one message at a time */
+    unsigned char sk[32];
+    unsigned char msgs[40][32];
+    unsigned char aux[40][32];
+    const unsigned char *msg_ptrs[40];
+    const unsigned char *aux_ptrs[40];
+    unsigned char sigs[40 * 64];
+    unsigned char expected[40 * 64];
+    unsigned char zeros[64] = {0};
+    secp256k1_keypair keypair;
+    size_t i, n = 1 + secp256k1_testrand_int(40);
+    int use_aux = secp256k1_testrand_bits(1);
+    int ecount = 0;
+
+    secp256k1_testrand256(sk);
+    CHECK(secp256k1_keypair_create(ctx, &keypair, sk));
+    for (i = 0; i < n; i++) {
+        secp256k1_testrand256(msgs[i]);
+        secp256k1_testrand256(aux[i]);
+        msg_ptrs[i] = msgs[i];
+        aux_ptrs[i] = secp256k1_testrand_bits(1) ? aux[i] : NULL;
+        CHECK(secp256k1_schnorrsig_sign(ctx, &expected[64 * i], msgs[i], &keypair, NULL, use_aux ? (void *)aux_ptrs[i] : NULL) == 1);
+    }
+    CHECK(secp256k1_schnorrsig_sign_batch(ctx, sigs, msg_ptrs, n, &keypair, use_aux ? aux_ptrs : NULL) == 1);
+    CHECK(secp256k1_memcmp_var(sigs, expected, 64 * n) == 0);
+
+    CHECK(secp256k1_schnorrsig_sign_batch(ctx, NULL, NULL, 0, &keypair, NULL) == 1);
+    secp256k1_context_set_illegal_callback(ctx, counting_illegal_callback_fn, &ecount);
+    CHECK(secp256k1_schnorrsig_sign_batch(ctx, NULL, msg_ptrs, 1, &keypair, NULL) == 0);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_schnorrsig_sign_batch(ctx, sigs, NULL, 1, &keypair, NULL) == 0);
+    CHECK(ecount == 2);
+    CHECK(secp256k1_schnorrsig_sign_batch(ctx, sigs, msg_ptrs, 1, NULL, NULL) == 0);
+    CHECK(ecount == 3);
+    msg_ptrs[0] = NULL;
+    CHECK(secp256k1_schnorrsig_sign_batch(ctx, sigs, msg_ptrs, 1, &keypair, NULL) == 0);
+    CHECK(ecount == 4);
+    msg_ptrs[0] = msgs[0];
+    memset(&keypair, 0, sizeof(keypair));
+    CHECK(secp256k1_schnorrsig_sign_batch(ctx, sigs, msg_ptrs, 1, &keypair, NULL) == 0);
+    CHECK(ecount == 5);
+    CHECK(secp256k1_memcmp_var(sigs, zeros, 64) == 0);
+    secp256k1_context_set_illegal_callback(ctx, NULL, NULL);
+}
+
+void test_schnorrsig_sign_session(void) {
+    /* Compared to secp256k1_schnorrsig_sign with the same auxiliary randomness */
+    unsigned char sk[32];
+    unsigned char msg[32];
+    unsigned char aux[32];
+    unsigned char sig[64];
+    unsigned char expected[64];
+    unsigned char zeros[64] = {0};
+    secp256k1_keypair keypair;
+    secp256k1_schnorrsig_session session;
+    secp256k1_context *vrfy;
+    int use_aux = secp256k1_testrand_bits(1);
+    int i;
+    int ecount = 0;
+
+    secp256k1_testrand256(sk);
+    secp256k1_testrand256(aux);
+    CHECK(secp256k1_keypair_create(ctx, &keypair, sk));
+    CHECK(secp256k1_schnorrsig_session_init(ctx, &session, &keypair, use_aux ? aux : NULL) == 1);
+    for (i = 0; i < 4; i++) {
+        secp256k1_testrand256(msg);
+        CHECK(secp256k1_schnorrsig_sign(ctx, expected, msg, &keypair, NULL, use_aux ? aux : NULL) == 1);
+        CHECK(secp256k1_schnorrsig_sign_session(ctx, sig, msg, &session) == 1);
+        CHECK(secp256k1_memcmp_var(sig, expected, 64) == 0);
+    }
+
+    secp256k1_context_set_illegal_callback(ctx, counting_illegal_callback_fn, &ecount);
+    CHECK(secp256k1_schnorrsig_session_init(ctx, NULL, &keypair, NULL) == 0);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_schnorrsig_session_init(ctx, &session, NULL, NULL) == 0);
+    CHECK(ecount == 2);
+    CHECK(secp256k1_schnorrsig_sign_session(ctx, NULL, msg, &session) == 0);
+    CHECK(ecount == 3);
+    CHECK(secp256k1_schnorrsig_sign_session(ctx, sig, NULL, &session) == 0);
+    CHECK(ecount == 4);
+    CHECK(secp256k1_schnorrsig_sign_session(ctx, sig, msg, NULL) == 0);
+    CHECK(ecount == 5);
+    vrfy = secp256k1_context_create(SECP256K1_CONTEXT_VERIFY);
+    secp256k1_context_set_illegal_callback(vrfy, counting_illegal_callback_fn, &ecount);
+    CHECK(secp256k1_schnorrsig_sign_session(vrfy, sig, msg, &session) == 0);
+    CHECK(ecount == 6);
+    secp256k1_context_destroy(vrfy);
+    /* An invalid keypair gives a zeroed session, which cannot sign */
+    memset(&keypair, 0, sizeof(keypair));
+    CHECK(secp256k1_schnorrsig_session_init(ctx, &session, &keypair, NULL) == 0);
+    CHECK(ecount == 7);
+    CHECK(secp256k1_memcmp_var(session.data, zeros, 64) == 0);
+    CHECK(secp256k1_schnorrsig_sign_session(ctx, sig, msg, &session) == 0);
+    CHECK(ecount == 8);
+    secp256k1_context_set_illegal_callback(ctx, NULL, NULL);
+}
+
+void test_schnorrsig_sign_pooled(void) {
+    unsigned char sk[32];
+    unsigned char seed[32];
+    unsigned char msg[32];
+    unsigned char sig[64];
+    unsigned char zeros[64] = {0};
+    secp256k1_keypair keypair;
+    secp256k1_xonly_pubkey pk;
+    secp256k1_nonce_pool *pool;
+    int i;
+    int ecount = 0;
+
+    secp256k1_testrand256(sk);
+    secp256k1_testrand256(seed);
+    CHECK(secp256k1_keypair_create(ctx, &keypair, sk));
+    CHECK(secp256k1_keypair_xonly_pub(ctx, &pk, NULL, &keypair));
+    pool = secp256k1_nonce_pool_create(ctx, 4);
+    CHECK(pool != NULL);
+    CHECK(secp256k1_nonce_pool_fill(ctx, pool, seed) == 1);
+    for (i = 0; i < 4; i++) {
+        secp256k1_testrand256(msg);
+        CHECK(secp256k1_schnorrsig_sign_pooled(ctx, sig, msg, &keypair, pool) == 1);
+        CHECK(secp256k1_schnorrsig_verify(ctx, sig, msg, &pk) == 1);
+    }
+    CHECK(secp256k1_schnorrsig_sign_pooled(ctx, sig, msg, &keypair, pool) == 0);
+    CHECK(secp256k1_memcmp_var(sig, zeros, 64) == 0);
+
+    CHECK(secp256k1_nonce_pool_fill(ctx, pool, seed) == 1);
+    secp256k1_context_set_illegal_callback(ctx, counting_illegal_callback_fn, &ecount);
+    CHECK(secp256k1_schnorrsig_sign_pooled(ctx, NULL, msg, &keypair, pool) == 0);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_schnorrsig_sign_pooled(ctx, sig, NULL, &keypair, pool) == 0);
+    CHECK(ecount == 2);
+    CHECK(secp256k1_schnorrsig_sign_pooled(ctx, sig, msg, NULL, pool) == 0);
+    CHECK(ecount == 3);
+    CHECK(secp256k1_schnorrsig_sign_pooled(ctx, sig, msg, &keypair, NULL) == 0);
+    CHECK(ecount == 4);
+    CHECK(secp256k1_nonce_pool_count(ctx, pool) == 4);
+    /* An invalid keypair consumes a nonce and gives a zero signature */
+    memset(&keypair, 0, sizeof(keypair));
+    CHECK(secp256k1_schnorrsig_sign_pooled(ctx, sig, msg, &keypair, pool) == 0);
+    CHECK(ecount == 5);
+    CHECK(secp256k1_memcmp_var(sig, zeros, 64) == 0);
+    CHECK(secp256k1_nonce_pool_count(ctx, pool) == 3);
+    secp256k1_context_set_illegal_callback(ctx, NULL, NULL);
+    secp256k1_nonce_pool_destroy(ctx, pool);
+}
+
 void run_schnorrsig_tests(void) {
     int i;
+    scratch = secp256k1_scratch_space_create(ctx, 1024 * 1024);
     run_nonce_function_bip340_tests();
 
     test_schnorrsig_api();
@@ -799,8 +1127,14 @@ void run_schnorrsig_tests(void) {
     for (i = 0; i < count; i++) {
         test_schnorrsig_sign();
         test_schnorrsig_sign_verify();
+        test_schnorrsig_sign_batch();
+        test_schnorrsig_sign_session();
     }
+    test_schnorrsig_verify_batch_sizes();
     test_schnorrsig_taproot();
+    test_schnorrsig_verify_cached();
+    test_schnorrsig_sign_pooled();
+    secp256k1_scratch_space_destroy(ctx, scratch);
 }
 
 #endif
@@ -0,0 +1,178 @@
+/**********************************************************************
+ * Distributed under the MIT software license, see the accompanying   *
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
+ **********************************************************************/
+
+#ifndef SECP256K1_MODULE_SCHNORRSIG_HALFAGG_MAIN_H
+#define SECP256K1_MODULE_SCHNORRSIG_HALFAGG_MAIN_H
+
+#include "include/secp256k1.h"
+#include "include/secp256k1_schnorrsig_halfagg.h"
+#include "hash.h"
+
+/* Initializes SHA256 as a tagged hash with tag "HalfAgg/randomizer". */
+static void secp256k1_schnorrsig_halfagg_sha256_tagged(secp256k1_sha256 *sha) {
+    static const unsigned char tag[] = {'H', 'a', 'l', 'f', 'A', 'g', 'g', '/', 'r', 'a', 'n', 'd', 'o', 'm', 'i', 'z', 'e', 'r'};
+    secp256k1_sha256_initialize_tagged(sha, tag, sizeof(tag));
+}
+
+/* Appends r32||pk32||msg32 of the signature with index idx to the transcript of the
+ * signatures before it, and sets z to the randomizer of the signature: the hash of the
+ * transcript so far, or 1 for the first signature. */
+static void secp256k1_schnorrsig_halfagg_randomizer(secp256k1_scalar *z, secp256k1_sha256 *transcript, const unsigned char *r32, const unsigned char *pk32, const unsigned char *msg32, size_t idx) {
+    secp256k1_sha256 sha;
+    unsigned char buf[32];
+
+    secp256k1_sha256_write(transcript, r32, 32);
+    secp256k1_sha256_write(transcript, pk32, 32);
+    secp256k1_sha256_write(transcript, msg32, 32);
+    if (idx == 0) {
+        secp256k1_scalar_set_int(z, 1);
+        return;
+    }
+    sha = *transcript;
+    secp256k1_sha256_finalize(&sha, buf);
+    secp256k1_scalar_set_b32(z, buf, NULL);
+}
+
+int secp256k1_schnorrsig_halfagg_aggregate(const secp256k1_context* ctx, unsigned char *aggsig, size_t *aggsig_len, const unsigned char *const *sig, const unsigned char *const *msg32, const secp256k1_xonly_pubkey *const *pk, size_t n_sigs) {
+    secp256k1_sha256 transcript;
+    secp256k1_scalar s;
+    size_t i;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(aggsig != NULL);
+    ARG_CHECK(aggsig_len != NULL);
+    ARG_CHECK(n_sigs <= SECP256K1_SCHNORRSIG_HALFAGG_MAX_SIGS);
+    ARG_CHECK(*aggsig_len >= 32 * (n_sigs + 1));
+    ARG_CHECK(n_sigs == 0 || (sig != NULL && msg32 != NULL && pk != NULL));
+
+    /* s = sum(z_i * s_i) */
+    secp256k1_schnorrsig_halfagg_sha256_tagged(&transcript);
+    secp256k1_scalar_set_int(&s, 0);
+    for (i = 0; i < n_sigs; i++) {
+        secp256k1_ge pk_ge;
+        secp256k1_scalar z, term;
+        unsigned char buf[32];
+        int overflow;
+
+        ARG_CHECK(sig[i] != NULL);
+        ARG_CHECK(msg32[i] != NULL);
+        ARG_CHECK(pk[i] != NULL);
+        secp256k1_scalar_set_b32(&term, &sig[i][32], &overflow);
+        if (overflow || !secp256k1_xonly_pubkey_load(ctx, &pk_ge, pk[i])) {
+            memset(aggsig, 0, 32 * (n_sigs + 1));
+            return 0;
+        }
+        secp256k1_fe_get_b32(buf, &pk_ge.x);
+        secp256k1_schnorrsig_halfagg_randomizer(&z, &transcript, &sig[i][0], buf, msg32[i], i);
+        secp256k1_scalar_mul(&term, &term, &z);
+        secp256k1_scalar_add(&s, &s, &term);
+        memcpy(&aggsig[32 * i], &sig[i][0], 32);
+    }
+    secp256k1_scalar_get_b32(&aggsig[32 * n_sigs], &s);
+    *aggsig_len = 32 * (n_sigs + 1);
+    return 1;
+}
+
+/* Data that is used by the aggregate verification ecmult callback */
+typedef struct {
+    const secp256k1_context *ctx;
+    const unsigned char *aggsig;
+    const unsigned char *const *msg32;
+    const secp256k1_xonly_pubkey *const *pk;
+    /* The randomizers are chained: each hashes the transcript of all signatures up to
+     * its own. The transcript holds the first n_hashed signatures, and z is the
+     * randomizer of the last of them. ecmult_multi asks for the terms in order, so
+     * the transcript only ever has to be extended. */
+    secp256k1_sha256 transcript;
+    secp256k1_scalar z;
+    size_t n_hashed;
+} secp256k1_schnorrsig_halfagg_ecmult_context;
+
+/* Callback function which is called by ecmult_multi to get the terms of the aggregate
+ * signature check. Every signature results in two (scalar,point)-tuples:
+ * (z, R)
+ * (z*e, P) */
+static int secp256k1_schnorrsig_halfagg_ecmult_callback(secp256k1_scalar *sc, secp256k1_ge *pt, size_t idx, void *data) {
+    secp256k1_schnorrsig_halfagg_ecmult_context *ecmult_context = (secp256k1_schnorrsig_halfagg_ecmult_context *) data;
+    const unsigned char *r32;
+    unsigned char buf[32];
+    size_t sig_idx = idx / 2;
+
+    if (sig_idx + 1 < ecmult_context->n_hashed) {
+        /* Asked for an earlier signature: start over. */
+        secp256k1_schnorrsig_halfagg_sha256_tagged(&ecmult_context->transcript);
+        ecmult_context->n_hashed = 0;
+    }
+    while (ecmult_context->n_hashed <= sig_idx) {
+        size_t i = ecmult_context->n_hashed;
+        if (!secp256k1_xonly_pubkey_load(ecmult_context->ctx, pt, ecmult_context->pk[i])) {
+            return 0;
+        }
+        secp256k1_fe_get_b32(buf, &pt->x);
+        secp256k1_schnorrsig_halfagg_randomizer(&ecmult_context->z, &ecmult_context->transcript, &ecmult_context->aggsig[32 * i], buf, ecmult_context->msg32[i], i);
+        ecmult_context->n_hashed++;
+    }
+
+    r32 = &ecmult_context->aggsig[32 * sig_idx];
+    if (idx % 2 == 0) {
+        secp256k1_fe rx;
+        *sc = ecmult_context->z;
+        if (!secp256k1_fe_set_b32(&rx, r32)) {
+            return 0;
+        }
+        if (!secp256k1_ge_set_xo_var(pt, &rx, 0)) {
+            return 0;
+        }
+    } else {
+        if (!secp256k1_xonly_pubkey_load(ecmult_context->ctx, pt, ecmult_context->pk[sig_idx])) {
+            return 0;
+        }
+        secp256k1_fe_get_b32(buf, &pt->x);
+        secp256k1_schnorrsig_challenge(sc, r32, ecmult_context->msg32[sig_idx], buf);
+        secp256k1_scalar_mul(sc, sc, &ecmult_context->z);
+    }
+    return 1;
+}
+
+int secp256k1_schnorrsig_halfagg_verify(const secp256k1_context* ctx, secp256k1_scratch *scratch, const unsigned char *aggsig, size_t aggsig_len, const unsigned char *const *msg32, const secp256k1_xonly_pubkey *const *pk, size_t n_sigs) {
+    secp256k1_schnorrsig_halfagg_ecmult_context ecmult_context;
+    secp256k1_scalar s;
+    secp256k1_gej rj;
+    size_t i;
+    int overflow;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(scratch != NULL);
+    ARG_CHECK(aggsig != NULL);
+    ARG_CHECK(n_sigs <= SECP256K1_SCHNORRSIG_HALFAGG_MAX_SIGS);
+    ARG_CHECK(n_sigs == 0 || (msg32 != NULL && pk != NULL));
+    for (i = 0; i < n_sigs; i++) {
+        ARG_CHECK(msg32[i] != NULL);
+        ARG_CHECK(pk[i] != NULL);
+    }
+
+    if (aggsig_len != 32 * (n_sigs + 1)) {
+        return 0;
+    }
+    secp256k1_scalar_set_b32(&s, &aggsig[32 * n_sigs], &overflow);
+    if (overflow) {
+        return 0;
+    }
+    secp256k1_scalar_negate(&s, &s);
+
+    ecmult_context.ctx = ctx;
+    ecmult_context.aggsig = aggsig;
+    ecmult_context.msg32 = msg32;
+    ecmult_context.pk = pk;
+    secp256k1_schnorrsig_halfagg_sha256_tagged(&ecmult_context.transcript);
+    ecmult_context.n_hashed = 0;
+
+    /* sum(z_i*R_i + (z_i*e_i)*P_i) - s*G = 0 */
+    return secp256k1_ecmult_multi_var(&ctx->error_callback, &ctx->ecmult_ctx, scratch, &rj, &s, secp256k1_schnorrsig_halfagg_ecmult_callback, (void *) &ecmult_context, 2 * n_sigs)
+            && secp256k1_gej_is_infinity(&rj);
+}
+
+#endif /* SECP256K1_MODULE_SCHNORRSIG_HALFAGG_MAIN_H */
@@ -0,0 +1,236 @@
+/**********************************************************************
+ * Distributed under the MIT software license, see the accompanying   *
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
+ **********************************************************************/
+
+#ifndef SECP256K1_MODULE_SCHNORRSIG_HALFAGG_TESTS_H
+#define SECP256K1_MODULE_SCHNORRSIG_HALFAGG_TESTS_H
+
+#include "include/secp256k1_schnorrsig_halfagg.h"
+
+#define HALFAGG_TEST_N 24
+
+/* Signatures of HALFAGG_TEST_N random messages with random keys. */
+typedef struct {
+    secp256k1_keypair keypair[HALFAGG_TEST_N];
+    secp256k1_xonly_pubkey pk[HALFAGG_TEST_N];
+    unsigned char msg[HALFAGG_TEST_N][32];
+    unsigned char sig[HALFAGG_TEST_N][64];
+    const unsigned char *sig_arr[HALFAGG_TEST_N];
+    const unsigned char *msg_arr[HALFAGG_TEST_N];
+    const secp256k1_xonly_pubkey *pk_arr[HALFAGG_TEST_N];
+    unsigned char aggsig[32 * (HALFAGG_TEST_N + 1)];
+} halfagg_test_data;
+
+static void halfagg_test_setup(halfagg_test_data *data) {
+    size_t i;
+    for (i = 0; i < HALFAGG_TEST_N; i++) {
+        unsigned char sk[32];
+        secp256k1_testrand256(sk);
+        secp256k1_testrand256(data->msg[i]);
+        CHECK(secp256k1_keypair_create(ctx, &data->keypair[i], sk));
+        CHECK(secp256k1_keypair_xonly_pub(ctx, &data->pk[i], NULL, &data->keypair[i]));
+        CHECK(secp256k1_schnorrsig_sign(ctx, data->sig[i], data->msg[i], &data->keypair[i], NULL, NULL));
+        data->sig_arr[i] = data->sig[i];
+        data->msg_arr[i] = data->msg[i];
+        data->pk_arr[i] = &data->pk[i];
+    }
+}
+
+void test_schnorrsig_halfagg_api(void) {
+    halfagg_test_data data;
+    secp256k1_xonly_pubkey zero_pk;
+    const secp256k1_xonly_pubkey *zero_pk_arr[1];
+    size_t len;
+    int ecount;
+
+    secp256k1_context *none = secp256k1_context_create(SECP256K1_CONTEXT_NONE);
+    secp256k1_context *vrfy = secp256k1_context_create(SECP256K1_CONTEXT_VERIFY);
+    secp256k1_context_set_illegal_callback(none, counting_illegal_callback_fn, &ecount);
+    secp256k1_context_set_illegal_callback(vrfy, counting_illegal_callback_fn, &ecount);
+    halfagg_test_setup(&data);
+    memset(&zero_pk, 0, sizeof(zero_pk));
+    zero_pk_arr[0] = &zero_pk;
+
+    ecount = 0;
+    len = sizeof(data.aggsig);
+    CHECK(secp256k1_schnorrsig_halfagg_aggregate(none, data.aggsig, &len, data.sig_arr, data.msg_arr, data.pk_arr, 2) == 1);
+    CHECK(len == 96);
+    CHECK(ecount == 0);
+    CHECK(secp256k1_schnorrsig_halfagg_aggregate(none, NULL, &len, data.sig_arr, data.msg_arr, data.pk_arr, 2) == 0);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_schnorrsig_halfagg_aggregate(none, data.aggsig, NULL, data.sig_arr, data.msg_arr, data.pk_arr, 2) == 0);
+    CHECK(ecount == 2);
+    CHECK(secp256k1_schnorrsig_halfagg_aggregate(none, data.aggsig, &len, NULL, data.msg_arr, data.pk_arr, 2) == 0);
+    CHECK(ecount == 3);
+    CHECK(secp256k1_schnorrsig_halfagg_aggregate(none, data.aggsig, &len, data.sig_arr, NULL, data.pk_arr, 2) == 0);
+    CHECK(ecount == 4);
+    CHECK(secp256k1_schnorrsig_halfagg_aggregate(none, data.aggsig, &len, data.sig_arr, data.msg_arr, NULL, 2) == 0);
+    CHECK(ecount == 5);
+    len = 95;
+    CHECK(secp256k1_schnorrsig_halfagg_aggregate(none, data.aggsig, &len, data.sig_arr, data.msg_arr, data.pk_arr, 2) == 0);
+    CHECK(ecount == 6);
+    len = sizeof(data.aggsig);
+    CHECK(secp256k1_schnorrsig_halfagg_aggregate(none, data.aggsig, &len, data.sig_arr, data.msg_arr, data.pk_arr, SECP256K1_SCHNORRSIG_HALFAGG_MAX_SIGS + 1) == 0);
+    CHECK(ecount == 7);
+    CHECK(secp256k1_schnorrsig_halfagg_aggregate(none, data.aggsig, &len, data.sig_arr, data.msg_arr, zero_pk_arr, 1) == 0);
+    CHECK(ecount == 8);
+    CHECK(secp256k1_schnorrsig_halfagg_aggregate(none, data.aggsig, &len, NULL, NULL, NULL, 0) == 1);
+    CHECK(len == 32);
+    CHECK(ecount == 8);
+
+    ecount = 0;
+    len = sizeof(data.aggsig);
+    CHECK(secp256k1_schnorrsig_halfagg_aggregate(none, data.aggsig, &len, data.sig_arr, data.msg_arr, data.pk_arr, 2) == 1);
+    CHECK(secp256k1_schnorrsig_halfagg_verify(none, scratch, data.aggsig, len, data.msg_arr, data.pk_arr, 2) == 0);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_schnorrsig_halfagg_verify(vrfy, scratch, data.aggsig, len, data.msg_arr, data.pk_arr, 2) == 1);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_schnorrsig_halfagg_verify(vrfy, NULL, data.aggsig, len, data.msg_arr, data.pk_arr, 2) == 0);
+    CHECK(ecount == 2);
+    CHECK(secp256k1_schnorrsig_halfagg_verify(vrfy, scratch, NULL, len, data.msg_arr, data.pk_arr, 2) == 0);
+    CHECK(ecount == 3);
+    CHECK(secp256k1_schnorrsig_halfagg_verify(vrfy, scratch, data.aggsig, len, NULL, data.pk_arr, 2) == 0);
+    CHECK(ecount == 4);
+    CHECK(secp256k1_schnorrsig_halfagg_verify(vrfy, scratch, data.aggsig, len, data.msg_arr, NULL, 2) == 0);
+    CHECK(ecount == 5);
+    CHECK(secp256k1_schnorrsig_halfagg_verify(vrfy, scratch, data.aggsig, len, data.msg_arr, data.pk_arr, SECP256K1_SCHNORRSIG_HALFAGG_MAX_SIGS + 1) == 0);
+    CHECK(ecount == 6);
+    CHECK(secp256k1_schnorrsig_halfagg_verify(vrfy, scratch, data.aggsig, len, data.msg_arr, zero_pk_arr, 1) == 0);
+    CHECK(ecount == 6);
+    CHECK(secp256k1_schnorrsig_halfagg_verify(vrfy, scratch, data.aggsig, 64, data.msg_arr, zero_pk_arr, 1) == 0);
+    CHECK(ecount == 7);
+
+    secp256k1_context_destroy(none);
+    secp256k1_context_destroy(vrfy);
+}
+
+/* The aggregate of a single signature is the signature itself, as its randomizer is 1,
+ * and the aggregate of no signatures is s = 0. */
+void test_schnorrsig_halfagg_trivial(void) {
+    halfagg_test_data data;
+    unsigned char zero[32] = {0};
+    size_t len = sizeof(data.aggsig);
+
+    halfagg_test_setup(&data);
+    CHECK(secp256k1_schnorrsig_halfagg_aggregate(ctx, data.aggsig, &len, data.sig_arr, data.msg_arr, data.pk_arr, 1));
+    CHECK(len == 64);
+    CHECK(secp256k1_memcmp_var(data.aggsig, data.sig[0], 64) == 0);
+    CHECK(secp256k1_schnorrsig_halfagg_verify(ctx, scratch, data.aggsig, len, data.msg_arr, data.pk_arr, 1));
+
+    len = sizeof(data.aggsig);
+    CHECK(secp256k1_schnorrsig_halfagg_aggregate(ctx, data.aggsig, &len, NULL, NULL, NULL, 0));
+    CHECK(len == 32);
+    CHECK(secp256k1_memcmp_var(data.aggsig, zero, 32) == 0);
+    CHECK(secp256k1_schnorrsig_halfagg_verify(ctx, scratch, data.aggsig, len, NULL, NULL, 0));
+    data.aggsig[31] = 1;
+    CHECK(!secp256k1_schnorrsig_halfagg_verify(ctx, scratch, data.aggsig, len, NULL, NULL, 0));
+}
+
+/* Aggregates the first n signatures, and checks that the aggregate verifies with small and
+ * large scratch spaces, and that changing any input makes it fail. */
+void test_schnorrsig_halfagg_verify(void) {
+    halfagg_test_data data;
+    secp256k1_scratch_space *small_scratch = secp256k1_scratch_space_create(ctx, secp256k1_strauss_scratch_size(5) + STRAUSS_SCRATCH_OBJECTS*ALIGNMENT);
+    size_t n, len;
+
+    halfagg_test_setup(&data);
+    for (n = 2; n <= HALFAGG_TEST_N; n += 1 + secp256k1_testrand_int(8)) {
+        size_t bad = secp256k1_testrand_int(n);
+        size_t other = (bad + 1 + secp256k1_testrand_int(n - 1)) % n;
+        const secp256k1_xonly_pubkey *pk_tmp;
+        unsigned char sig_tmp[64];
+
+        len = sizeof(data.aggsig);
+        CHECK(secp256k1_schnorrsig_halfagg_aggregate(ctx, data.aggsig, &len, data.sig_arr, data.msg_arr, data.pk_arr, n));
+        CHECK(len == 32 * (n + 1));
+        CHECK(secp256k1_schnorrsig_halfagg_verify(ctx, scratch, data.aggsig, len, data.msg_arr, data.pk_arr, n));
+        CHECK(secp256k1_schnorrsig_halfagg_verify(ctx, small_scratch, data.aggsig, len, data.msg_arr, data.pk_arr, n));
+
+        /* Fewer signatures, or a different length */
+        CHECK(!secp256k1_schnorrsig_halfagg_verify(ctx, scratch, data.aggsig, len - 32, data.msg_arr, data.pk_arr, n - 1));
+        CHECK(!secp256k1_schnorrsig_halfagg_verify(ctx, scratch, data.aggsig, len - 1, data.msg_arr, data.pk_arr, n));
+        /* A different message */
+        data.msg[bad][secp256k1_testrand_int(32)] ^= 1 << secp256k1_testrand_int(8);
+        CHECK(!secp256k1_schnorrsig_halfagg_verify(ctx, scratch, data.aggsig, len, data.msg_arr, data.pk_arr, n));
+        CHECK(!secp256k1_schnorrsig_halfagg_verify(ctx, small_scratch, data.aggsig, len, data.msg_arr, data.pk_arr, n));
+        CHECK(secp256k1_schnorrsig_sign(ctx, data.sig[bad], data.msg[bad], &data.keypair[bad], NULL, NULL));
+        CHECK(secp256k1_schnorrsig_halfagg_aggregate(ctx, data.aggsig, &len, data.sig_arr, data.msg_arr, data.pk_arr, n));
+        /* A different order */
+        pk_tmp = data.pk_arr[bad];
+        data.pk_arr[bad] = data.pk_arr[other];
+        data.pk_arr[other] = pk_tmp;
+        CHECK(!secp256k1_schnorrsig_halfagg_verify(ctx, scratch, data.aggsig, len, data.msg_arr, data.pk_arr, n));
+        data.pk_arr[other] = data.pk_arr[bad];
+        data.pk_arr[bad] = pk_tmp;
+        /* A different R or s */
+        data.aggsig[32 * bad + secp256k1_testrand_int(32)] ^= 1 << secp256k1_testrand_int(8);
+        CHECK(!secp256k1_schnorrsig_halfagg_verify(ctx, scratch, data.aggsig, len, data.msg_arr, data.pk_arr, n));
+        CHECK(secp256k1_schnorrsig_halfagg_aggregate(ctx, data.aggsig, &len, data.sig_arr, data.msg_arr, data.pk_arr, n));
+        data.aggsig[32 * n + secp256k1_testrand_int(32)] ^= 1 << secp256k1_testrand_int(8);
+        CHECK(!secp256k1_schnorrsig_halfagg_verify(ctx, scratch, data.aggsig, len, data.msg_arr, data.pk_arr, n));
+        /* An s of at least the group order */
+        memset(&data.aggsig[32 * n], 0xFF, 32);
+        CHECK(!secp256k1_schnorrsig_halfagg_verify(ctx, scratch, data.aggsig, len, data.msg_arr, data.pk_arr, n));
+
+        /* The aggregate with one invalid signature is invalid, and one with an overflowing
+         * s part cannot be created. */
+        memcpy(sig_tmp, data.sig[bad], 64);
+        data.sig[bad][secp256k1_testrand_int(64)] ^= 1 << secp256k1_testrand_int(8);
+        if (secp256k1_schnorrsig_halfagg_aggregate(ctx, data.aggsig, &len, data.sig_arr, data.msg_arr, data.pk_arr, n)) {
+            CHECK(!secp256k1_schnorrsig_halfagg_verify(ctx, scratch, data.aggsig, len, data.msg_arr, data.pk_arr, n));
+        }
+        memset(&data.sig[bad][32], 0xFF, 32);
+        CHECK(!secp256k1_schnorrsig_halfagg_aggregate(ctx, data.aggsig, &len, data.sig_arr, data.msg_arr, data.pk_arr, n));
+        memcpy(data.sig[bad], sig_tmp, 64);
+    }
+    secp256k1_scratch_space_destroy(ctx, small_scratch);
+}
+
+/* The verification callback gives the same terms when it is asked for them out of order. */
+void test_schnorrsig_halfagg_callback(void) {
+    halfagg_test_data data;
+    secp256k1_schnorrsig_halfagg_ecmult_context ecmult_context;
+    secp256k1_scalar sc[4];
+    secp256k1_ge pt[4];
+    size_t len = sizeof(data.aggsig);
+    int i;
+
+    halfagg_test_setup(&data);
+    CHECK(secp256k1_schnorrsig_halfagg_aggregate(ctx, data.aggsig, &len, data.sig_arr, data.msg_arr, data.pk_arr, 3));
+    ecmult_context.ctx = ctx;
+    ecmult_context.aggsig = data.aggsig;
+    ecmult_context.msg32 = data.msg_arr;
+    ecmult_context.pk = data.pk_arr;
+    secp256k1_schnorrsig_halfagg_sha256_tagged(&ecmult_context.transcript);
+    ecmult_context.n_hashed = 0;
+    CHECK(secp256k1_schnorrsig_halfagg_ecmult_callback(&sc[0], &pt[0], 5, &ecmult_context));
+    CHECK(secp256k1_schnorrsig_halfagg_ecmult_callback(&sc[1], &pt[1], 2, &ecmult_context));
+    CHECK(secp256k1_schnorrsig_halfagg_ecmult_callback(&sc[2], &pt[2], 5, &ecmult_context));
+    CHECK(secp256k1_schnorrsig_halfagg_ecmult_callback(&sc[3], &pt[3], 2, &ecmult_context));
+    for (i = 0; i < 4; i++) {
+        secp256k1_fe_normalize_var(&pt[i].x);
+        secp256k1_fe_normalize_var(&pt[i].y);
+    }
+    CHECK(secp256k1_scalar_eq(&sc[0], &sc[2]));
+    CHECK(secp256k1_scalar_eq(&sc[1], &sc[3]));
+    ge_equals_ge(&pt[0], &pt[2]);
+    ge_equals_ge(&pt[1], &pt[3]);
+}
+
+void run_schnorrsig_halfagg_tests(void) {
+    int i;
+    scratch = secp256k1_scratch_space_create(ctx, 1024 * 1024);
+
+    test_schnorrsig_halfagg_api();
+    test_schnorrsig_halfagg_callback();
+    for (i = 0; i < count; i++) {
+        test_schnorrsig_halfagg_trivial();
+        test_schnorrsig_halfagg_verify();
+    }
+    secp256k1_scratch_space_destroy(ctx, scratch);
+}
+
+#undef HALFAGG_TEST_N
+
+#endif /* SECP256K1_MODULE_SCHNORRSIG_HALFAGG_TESTS_H */
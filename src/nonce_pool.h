@@ -0,0 +1,52 @@
+/**********************************************************************
+ * Distributed under the MIT software license, see the accompanying   *
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
+ **********************************************************************/
+
+#ifndef SECP256K1_NONCE_POOL_H
+#define SECP256K1_NONCE_POOL_H
+
+#include "util.h"
+#include "hash.h"
+#include "scalar.h"
+
+/* A pool of signing nonces k, each stored with what the signature needs of R = k*G.
+ * The nonces are generated by an RFC6979 HMAC-DRBG that every secp256k1_nonce_pool_fill
+ * rekeys with its output so far and the new seed, so a seed given twice to one pool
+ * does not repeat nonces. Every nonce is erased from the pool as it is taken. */
+
+typedef struct {
+    /** the nonce, negated if needed so that R has an even Y */
+    secp256k1_scalar k;
+    /** the inverse of k, for ECDSA */
+    secp256k1_scalar kinv;
+    /** the X coordinate of R */
+    unsigned char rx[32];
+} secp256k1_nonce_pool_entry;
+
+/* The public API exposes this as the opaque secp256k1_nonce_pool. */
+struct secp256k1_nonce_pool_struct {
+    secp256k1_rfc6979_hmac_sha256 rng;
+    int seeded;
+    secp256k1_nonce_pool_entry *entries;
+    size_t size;
+    /** the number of entries that have not been taken; they come first */
+    size_t count;
+    /** the allocator of the context the pool was created with */
+    secp256k1_allocator allocator;
+};
+
+/** Mixes seed32 into the nonce generator of pool. */
+static void secp256k1_nonce_pool_reseed(secp256k1_nonce_pool *pool, const unsigned char *seed32);
+
+/** Generates the next candidate nonce of pool. */
+static void secp256k1_nonce_pool_generate(secp256k1_nonce_pool *pool, unsigned char *nonce32);
+
+/** Moves an entry out of pool into entry, erasing it from the pool. Returns 0 if the
+ *  pool is empty. */
+static int secp256k1_nonce_pool_take(secp256k1_nonce_pool *pool, secp256k1_nonce_pool_entry *entry);
+
+/** Erases entry. */
+static void secp256k1_nonce_pool_entry_clear(secp256k1_nonce_pool_entry *entry);
+
+#endif /* SECP256K1_NONCE_POOL_H */
@@ -0,0 +1,49 @@
+/**********************************************************************
+ * Distributed under the MIT software license, see the accompanying   *
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
+ **********************************************************************/
+
+#ifndef SECP256K1_NONCE_POOL_IMPL_H
+#define SECP256K1_NONCE_POOL_IMPL_H
+
+#include "nonce_pool.h"
+#include "hash_impl.h"
+#include "scalar_impl.h"
+
+static void secp256k1_nonce_pool_reseed(secp256k1_nonce_pool *pool, const unsigned char *seed32) {
+    unsigned char keydata[64];
+
+    if (pool->seeded) {
+        secp256k1_rfc6979_hmac_sha256_generate(&pool->rng, keydata, 32);
+        secp256k1_rfc6979_hmac_sha256_finalize(&pool->rng);
+    } else {
+        memset(keydata, 0, 32);
+    }
+    memcpy(&keydata[32], seed32, 32);
+    secp256k1_rfc6979_hmac_sha256_initialize(&pool->rng, keydata, 64);
+    pool->seeded = 1;
+    memset(keydata, 0, sizeof(keydata));
+}
+
+static void secp256k1_nonce_pool_generate(secp256k1_nonce_pool *pool, unsigned char *nonce32) {
+    VERIFY_CHECK(pool->seeded);
+    secp256k1_rfc6979_hmac_sha256_generate(&pool->rng, nonce32, 32);
+}
+
+static void secp256k1_nonce_pool_entry_clear(secp256k1_nonce_pool_entry *entry) {
+    secp256k1_scalar_clear(&entry->k);
+    secp256k1_scalar_clear(&entry->kinv);
+    memset(entry->rx, 0, sizeof(entry->rx));
+}
+
+static int secp256k1_nonce_pool_take(secp256k1_nonce_pool *pool, secp256k1_nonce_pool_entry *entry) {
+    if (pool->count == 0) {
+        return 0;
+    }
+    pool->count--;
+    *entry = pool->entries[pool->count];
+    secp256k1_nonce_pool_entry_clear(&pool->entries[pool->count]);
+    return 1;
+}
+
+#endif /* SECP256K1_NONCE_POOL_IMPL_H */
@@ -7,6 +7,12 @@
 #ifndef SECP256K1_SCALAR_REPR_IMPL_H
 #define SECP256K1_SCALAR_REPR_IMPL_H
 
+#include "modinv64_impl.h"
+
+#if defined(USE_ASM_X86_64_ADX)
+#include "cpu_impl.h"
+#endif
+
 /* Limbs of the secp256k1 order. */
 #define SECP256K1_N_0 ((uint64_t)0xBFD25E8CD0364141ULL)
 #define SECP256K1_N_1 ((uint64_t)0xBAAEDCE6AF48A03BULL)
@@ -576,9 +582,105 @@ static void secp256k1_scalar_reduce_512(secp256k1_scalar *r, const uint64_t *l)
     secp256k1_scalar_reduce(r, c + secp256k1_scalar_check_overflow(r));
 }
 
+#ifdef USE_ASM_X86_64_ADX
+/** Returns whether the CPU supports the BMI2 (MULX) and ADX (ADCX/ADOX) instructions. */
+static int secp256k1_scalar_x86_64_adx_available(void) {
+    return secp256k1_cpu_x86_has(SECP256K1_CPU_X86_ADX);
+}
+
+/** secp256k1_scalar_mul_512 using MULX, which leaves the flags alone, and two independent
+ *  carry chains (ADCX uses only CF and ADOX only OF). Each row adds a[i] * b[0..3] to the
+ *  running sum; the accumulator registers rotate so that every row starts on r8. Must
+ *  only be called if secp256k1_scalar_x86_64_adx_available(). */
+static void secp256k1_scalar_mul_512_adx(uint64_t l[8], const secp256k1_scalar *a, const secp256k1_scalar *b) {
+    __asm__ __volatile__(
+    /* r14 = 0 */
+    "xorl %%r14d, %%r14d\n"
+    /* (r8,r9,r10,r11,r12) = a0 * b[0..3] */
+    "movq 0(%%rsi), %%rdx\n"
+    "mulxq 0(%%rcx), %%r8, %%r9\n"
+    "mulxq 8(%%rcx), %%rax, %%r10\n"
+    "addq %%rax, %%r9\n"
+    "mulxq 16(%%rcx), %%rax, %%r11\n"
+    "adcq %%rax, %%r10\n"
+    "mulxq 24(%%rcx), %%rax, %%r12\n"
+    "adcq %%rax, %%r11\n"
+    "adcq %%r14, %%r12\n"
+    /* Extract l0 */
+    "movq %%r8, 0(%%rdi)\n"
+    /* (r9,r10,r11,r12,r13) += a1 * b[0..3] */
+    "movq 8(%%rsi), %%rdx\n"
+    "xorl %%r13d, %%r13d\n"
+    "mulxq 0(%%rcx), %%rax, %%rbx\n"
+    "adcxq %%rax, %%r9\n"
+    "adoxq %%rbx, %%r10\n"
+    "mulxq 8(%%rcx), %%rax, %%rbx\n"
+    "adcxq %%rax, %%r10\n"
+    "adoxq %%rbx, %%r11\n"
+    "mulxq 16(%%rcx), %%rax, %%rbx\n"
+    "adcxq %%rax, %%r11\n"
+    "adoxq %%rbx, %%r12\n"
+    "mulxq 24(%%rcx), %%rax, %%rbx\n"
+    "adcxq %%rax, %%r12\n"
+    "adoxq %%rbx, %%r13\n"
+    "adcxq %%r14, %%r13\n"
+    /* Extract l1 */
+    "movq %%r9, 8(%%rdi)\n"
+    /* (r10,r11,r12,r13,r8) += a2 * b[0..3] */
+    "movq 16(%%rsi), %%rdx\n"
+    "xorl %%r8d, %%r8d\n"
+    "mulxq 0(%%rcx), %%rax, %%rbx\n"
+    "adcxq %%rax, %%r10\n"
+    "adoxq %%rbx, %%r11\n"
+    "mulxq 8(%%rcx), %%rax, %%rbx\n"
+    "adcxq %%rax, %%r11\n"
+    "adoxq %%rbx, %%r12\n"
+    "mulxq 16(%%rcx), %%rax, %%rbx\n"
+    "adcxq %%rax, %%r12\n"
+    "adoxq %%rbx, %%r13\n"
+    "mulxq 24(%%rcx), %%rax, %%rbx\n"
+    "adcxq %%rax, %%r13\n"
+    "adoxq %%rbx, %%r8\n"
+    "adcxq %%r14, %%r8\n"
+    /* Extract l2 */
+    "movq %%r10, 16(%%rdi)\n"
+    /* (r11,r12,r13,r8,r9) += a3 * b[0..3] */
+    "movq 24(%%rsi), %%rdx\n"
+    "xorl %%r9d, %%r9d\n"
+    "mulxq 0(%%rcx), %%rax, %%rbx\n"
+    "adcxq %%rax, %%r11\n"
+    "adoxq %%rbx, %%r12\n"
+    "mulxq 8(%%rcx), %%rax, %%rbx\n"
+    "adcxq %%rax, %%r12\n"
+    "adoxq %%rbx, %%r13\n"
+    "mulxq 16(%%rcx), %%rax, %%rbx\n"
+    "adcxq %%rax, %%r13\n"
+    "adoxq %%rbx, %%r8\n"
+    "mulxq 24(%%rcx), %%rax, %%rbx\n"
+    "adcxq %%rax, %%r8\n"
+    "adoxq %%rbx, %%r9\n"
+    "adcxq %%r14, %%r9\n"
+    /* Extract l3..l7 */
+    "movq %%r11, 24(%%rdi)\n"
+    "movq %%r12, 32(%%rdi)\n"
+    "movq %%r13, 40(%%rdi)\n"
+    "movq %%r8, 48(%%rdi)\n"
+    "movq %%r9, 56(%%rdi)\n"
+    :
+    : "D"(l), "S"(a->d), "c"(b->d)
+    : "rax", "rbx", "rdx", "r8", "r9", "r10", "r11", "r12", "r13", "r14", "cc", "memory");
+}
+#endif
+
 static void secp256k1_scalar_mul_512(uint64_t l[8], const secp256k1_scalar *a, const secp256k1_scalar *b) {
 #ifdef USE_ASM_X86_64
     const uint64_t *pb = b->d;
+#ifdef USE_ASM_X86_64_ADX
+    if (secp256k1_scalar_x86_64_adx_available()) {
+        secp256k1_scalar_mul_512_adx(l, a, b);
+        return;
+    }
+#endif
     __asm__ __volatile__(
     /* Preload */
     "movq 0(%%rdi), %%r15\n"
@@ -709,6 +811,111 @@ static void secp256k1_scalar_mul_512(uint64_t l[8], const secp256k1_scalar *a, c
     : "+d"(pb)
     : "S"(l), "D"(a->d)
     : "rax", "rbx", "rcx", "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15", "cc", "memory");
+#elif defined(USE_ASM_AARCH64)
+    /* Product scanning: column k sums a[i] * b[k - i] into the rotating 192-bit accumulator
+     * (c0,c1,c2), of which the low word is then l[k]. */
+    uint64_t a0, a1, a2, a3, b0, b1, b2, b3, c0, c1, c2, t0, t1;
+
+    __asm__ __volatile__(
+    "ldp %[a0], %[a1], [%[a]]\n"
+    "ldp %[a2], %[a3], [%[a], #16]\n"
+    "ldp %[b0], %[b1], [%[b]]\n"
+    "ldp %[b2], %[b3], [%[b], #16]\n"
+    /* Column 0 */
+    "mul %[c0], %[a0], %[b0]\n"
+    "umulh %[c1], %[a0], %[b0]\n"
+    "str %[c0], [%[l]]\n"
+    /* Column 1 */
+    "mul %[t0], %[a0], %[b1]\n"
+    "umulh %[t1], %[a0], %[b1]\n"
+    "adds %[c1], %[c1], %[t0]\n"
+    "adc %[c2], %[t1], xzr\n"
+    "mul %[t0], %[a1], %[b0]\n"
+    "umulh %[t1], %[a1], %[b0]\n"
+    "adds %[c1], %[c1], %[t0]\n"
+    "adcs %[c2], %[c2], %[t1]\n"
+    "adc %[c0], xzr, xzr\n"
+    "str %[c1], [%[l], #8]\n"
+    /* Column 2 */
+    "mul %[t0], %[a0], %[b2]\n"
+    "umulh %[t1], %[a0], %[b2]\n"
+    "adds %[c2], %[c2], %[t0]\n"
+    "adcs %[c0], %[c0], %[t1]\n"
+    "adc %[c1], xzr, xzr\n"
+    "mul %[t0], %[a1], %[b1]\n"
+    "umulh %[t1], %[a1], %[b1]\n"
+    "adds %[c2], %[c2], %[t0]\n"
+    "adcs %[c0], %[c0], %[t1]\n"
+    "adc %[c1], %[c1], xzr\n"
+    "mul %[t0], %[a2], %[b0]\n"
+    "umulh %[t1], %[a2], %[b0]\n"
+    "adds %[c2], %[c2], %[t0]\n"
+    "adcs %[c0], %[c0], %[t1]\n"
+    "adc %[c1], %[c1], xzr\n"
+    "str %[c2], [%[l], #16]\n"
+    /* Column 3 */
+    "mul %[t0], %[a0], %[b3]\n"
+    "umulh %[t1], %[a0], %[b3]\n"
+    "adds %[c0], %[c0], %[t0]\n"
+    "adcs %[c1], %[c1], %[t1]\n"
+    "adc %[c2], xzr, xzr\n"
+    "mul %[t0], %[a1], %[b2]\n"
+    "umulh %[t1], %[a1], %[b2]\n"
+    "adds %[c0], %[c0], %[t0]\n"
+    "adcs %[c1], %[c1], %[t1]\n"
+    "adc %[c2], %[c2], xzr\n"
+    "mul %[t0], %[a2], %[b1]\n"
+    "umulh %[t1], %[a2], %[b1]\n"
+    "adds %[c0], %[c0], %[t0]\n"
+    "adcs %[c1], %[c1], %[t1]\n"
+    "adc %[c2], %[c2], xzr\n"
+    "mul %[t0], %[a3], %[b0]\n"
+    "umulh %[t1], %[a3], %[b0]\n"
+    "adds %[c0], %[c0], %[t0]\n"
+    "adcs %[c1], %[c1], %[t1]\n"
+    "adc %[c2], %[c2], xzr\n"
+    "str %[c0], [%[l], #24]\n"
+    /* Column 4 */
+    "mul %[t0], %[a1], %[b3]\n"
+    "umulh %[t1], %[a1], %[b3]\n"
+    "adds %[c1], %[c1], %[t0]\n"
+    "adcs %[c2], %[c2], %[t1]\n"
+    "adc %[c0], xzr, xzr\n"
+    "mul %[t0], %[a2], %[b2]\n"
+    "umulh %[t1], %[a2], %[b2]\n"
+    "adds %[c1], %[c1], %[t0]\n"
+    "adcs %[c2], %[c2], %[t1]\n"
+    "adc %[c0], %[c0], xzr\n"
+    "mul %[t0], %[a3], %[b1]\n"
+    "umulh %[t1], %[a3], %[b1]\n"
+    "adds %[c1], %[c1], %[t0]\n"
+    "adcs %[c2], %[c2], %[t1]\n"
+    "adc %[c0], %[c0], xzr\n"
+    "str %[c1], [%[l], #32]\n"
+    /* Column 5 */
+    "mul %[t0], %[a2], %[b3]\n"
+    "umulh %[t1], %[a2], %[b3]\n"
+    "adds %[c2], %[c2], %[t0]\n"
+    "adcs %[c0], %[c0], %[t1]\n"
+    "adc %[c1], xzr, xzr\n"
+    "mul %[t0], %[a3], %[b2]\n"
+    "umulh %[t1], %[a3], %[b2]\n"
+    "adds %[c2], %[c2], %[t0]\n"
+    "adcs %[c0], %[c0], %[t1]\n"
+    "adc %[c1], %[c1], xzr\n"
+    "str %[c2], [%[l], #40]\n"
+    /* Column 6 */
+    "mul %[t0], %[a3], %[b3]\n"
+    "umulh %[t1], %[a3], %[b3]\n"
+    "adds %[c0], %[c0], %[t0]\n"
+    "adc %[c1], %[c1], %[t1]\n"
+    "stp %[c0], %[c1], [%[l], #48]\n"
+    : [a0] "=&r"(a0), [a1] "=&r"(a1), [a2] "=&r"(a2), [a3] "=&r"(a3),
+      [b0] "=&r"(b0), [b1] "=&r"(b1), [b2] "=&r"(b2), [b3] "=&r"(b3),
+      [c0] "=&r"(c0), [c1] "=&r"(c1), [c2] "=&r"(c2), [t0] "=&r"(t0), [t1] "=&r"(t1)
+    : [l] "r"(l), [a] "r"(a->d), [b] "r"(b->d)
+    : "cc", "memory");
+
 #else
     /* 160 bit accumulator. */
     uint64_t c0 = 0, c1 = 0;
@@ -955,4 +1162,74 @@ static SECP256K1_INLINE void secp256k1_scalar_cmov(secp256k1_scalar *r, const se
     r->d[3] = (r->d[3] & mask0) | (a->d[3] & mask1);
 }
 
+static void secp256k1_scalar_from_signed62(secp256k1_scalar *r, const secp256k1_modinv64_signed62 *a) {
+    const uint64_t a0 = a->v[0], a1 = a->v[1], a2 = a->v[2], a3 = a->v[3], a4 = a->v[4];
+
+    /* The output from secp256k1_modinv64{_var} should be normalized to range [0,modulus), and
+     * have limbs in [0,2^62). The modulus is < 2^256, so the top limb must be below 2^(256-62*4).
+     */
+    VERIFY_CHECK(a0 >> 62 == 0);
+    VERIFY_CHECK(a1 >> 62 == 0);
+    VERIFY_CHECK(a2 >> 62 == 0);
+    VERIFY_CHECK(a3 >> 62 == 0);
+    VERIFY_CHECK(a4 >> 8 == 0);
+
+    r->d[0] = a0      | a1 << 62;
+    r->d[1] = a1 >> 2 | a2 << 60;
+    r->d[2] = a2 >> 4 | a3 << 58;
+    r->d[3] = a3 >> 6 | a4 << 56;
+
+#ifdef VERIFY
+    VERIFY_CHECK(secp256k1_scalar_check_overflow(r) == 0);
+#endif
+}
+
+static void secp256k1_scalar_to_signed62(secp256k1_modinv64_signed62 *r, const secp256k1_scalar *a) {
+    const uint64_t M62 = UINT64_MAX >> 2;
+    const uint64_t a0 = a->d[0], a1 = a->d[1], a2 = a->d[2], a3 = a->d[3];
+
+#ifdef VERIFY
+    VERIFY_CHECK(secp256k1_scalar_check_overflow(a) == 0);
+#endif
+
+    r->v[0] =  a0                   & M62;
+    r->v[1] = (a0 >> 62 | a1 <<  2) & M62;
+    r->v[2] = (a1 >> 60 | a2 <<  4) & M62;
+    r->v[3] = (a2 >> 58 | a3 <<  6) & M62;
+    r->v[4] =  a3 >> 56;
+}
+
+static const secp256k1_modinv64_modinfo secp256k1_const_modinfo_scalar = {
+    {{0x3FD25E8CD0364141LL, 0x2ABB739ABD2280EELL, -0x15LL, 0, 256}},
+    0x34F20099AA774EC1LL
+};
+
+static void secp256k1_scalar_inverse_safegcd(secp256k1_scalar *r, const secp256k1_scalar *x) {
+    secp256k1_modinv64_signed62 s;
+#ifdef VERIFY
+    int zero_in = secp256k1_scalar_is_zero(x);
+#endif
+    secp256k1_scalar_to_signed62(&s, x);
+    secp256k1_modinv64(&s, &secp256k1_const_modinfo_scalar);
+    secp256k1_scalar_from_signed62(r, &s);
+
+#ifdef VERIFY
+    VERIFY_CHECK(secp256k1_scalar_is_zero(r) == zero_in);
+#endif
+}
+
+static void secp256k1_scalar_inverse_safegcd_var(secp256k1_scalar *r, const secp256k1_scalar *x) {
+    secp256k1_modinv64_signed62 s;
+#ifdef VERIFY
+    int zero_in = secp256k1_scalar_is_zero(x);
+#endif
+    secp256k1_scalar_to_signed62(&s, x);
+    secp256k1_modinv64_var(&s, &secp256k1_const_modinfo_scalar);
+    secp256k1_scalar_from_signed62(r, &s);
+
+#ifdef VERIFY
+    VERIFY_CHECK(secp256k1_scalar_is_zero(r) == zero_in);
+#endif
+}
+
 #endif /* SECP256K1_SCALAR_REPR_IMPL_H */
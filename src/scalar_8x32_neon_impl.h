@@ -0,0 +1,69 @@
+/**********************************************************************
+ * Distributed under the MIT software license, see the accompanying   *
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
+ **********************************************************************/
+
+#ifndef SECP256K1_SCALAR_8X32_NEON_IMPL_H
+#define SECP256K1_SCALAR_8X32_NEON_IMPL_H
+
+/* NEON versions of secp256k1_scalar_mul_512 and secp256k1_scalar_sqr_512. The 64 partial
+ * products are formed two at a time with vmull_u32. A full 64-bit product does not leave
+ * room to add up a column, so the low and high halves of every product are accumulated
+ * separately (with widening adds) into the column of the product and the next one. A
+ * column then collects at most 16 values of 32 bits, and the carries are propagated once
+ * at the end.
+ *
+ * Like field_10x26_neon_impl.h this is selected at compile time. */
+
+#include <stdint.h>
+#include <arm_neon.h>
+
+static void secp256k1_scalar_mul_512(uint32_t *l, const secp256k1_scalar *a, const secp256k1_scalar *b) {
+    /* even[k] holds the columns (2k, 2k+1), odd[k] the columns (2k+1, 2k+2). */
+    uint64x2_t even[8], odd[7];
+    uint32x2_t bv[4];
+    uint64_t c;
+    int i, k;
+
+    for (k = 0; k < 4; k++) {
+        bv[k] = vld1_u32(&b->d[2 * k]);
+    }
+    for (k = 0; k < 7; k++) {
+        even[k] = vdupq_n_u64(0);
+        odd[k] = vdupq_n_u64(0);
+    }
+    even[7] = vdupq_n_u64(0);
+    for (i = 0; i < 8; i += 2) {
+        const uint32x2_t ae = vdup_n_u32(a->d[i]);
+        const uint32x2_t ao = vdup_n_u32(a->d[i + 1]);
+        for (k = 0; k < 4; k++) {
+            /* a[i]*b[2k..2k+1] covers the columns (i+2k, i+2k+1), and its high halves the
+             * columns (i+2k+1, i+2k+2). */
+            const uint64x2_t pe = vmull_u32(ae, bv[k]);
+            const uint64x2_t po = vmull_u32(ao, bv[k]);
+            even[i / 2 + k] = vaddw_u32(even[i / 2 + k], vmovn_u64(pe));
+            odd[i / 2 + k] = vaddw_u32(odd[i / 2 + k], vshrn_n_u64(pe, 32));
+            odd[i / 2 + k] = vaddw_u32(odd[i / 2 + k], vmovn_u64(po));
+            even[i / 2 + k + 1] = vaddw_u32(even[i / 2 + k + 1], vshrn_n_u64(po, 32));
+        }
+    }
+
+    c = vgetq_lane_u64(even[0], 0);
+    l[0] = (uint32_t)c; c >>= 32;
+    for (k = 0; k < 7; k++) {
+        c += vgetq_lane_u64(even[k], 1) + vgetq_lane_u64(odd[k], 0);
+        l[2 * k + 1] = (uint32_t)c; c >>= 32;
+        c += vgetq_lane_u64(even[k + 1], 0) + vgetq_lane_u64(odd[k], 1);
+        l[2 * k + 2] = (uint32_t)c; c >>= 32;
+    }
+    c += vgetq_lane_u64(even[7], 1);
+    l[15] = (uint32_t)c;
+    VERIFY_CHECK((c >> 32) == 0);
+}
+
+static void secp256k1_scalar_sqr_512(uint32_t *l, const secp256k1_scalar *a) {
+    /* Forming all 64 products in pairs is as cheap as the 36 distinct ones one at a time. */
+    secp256k1_scalar_mul_512(l, a, a);
+}
+
+#endif /* SECP256K1_SCALAR_8X32_NEON_IMPL_H */
@@ -65,8 +65,8 @@ static int secp256k1_scalar_set_b32_seckey(secp256k1_scalar *r, const unsigned c
     return (!overflow) & (!secp256k1_scalar_is_zero(r));
 }
 
-static void secp256k1_scalar_inverse(secp256k1_scalar *r, const secp256k1_scalar *x) {
 #if defined(EXHAUSTIVE_TEST_ORDER)
+static void secp256k1_scalar_inverse(secp256k1_scalar *r, const secp256k1_scalar *x) {
     int i;
     *r = 0;
     for (i = 0; i < EXHAUSTIVE_TEST_ORDER; i++)
@@ -77,6 +77,11 @@ static void secp256k1_scalar_inverse(secp256k1_scalar *r, const secp256k1_scalar
     VERIFY_CHECK(*r != 0);
 }
 #else
+/* As for the field, every inversion backend is compiled so that bench_internal
+ * and the tests can compare them. */
+
+/** Constant-time inverse by exponentiation to n - 2 with an addition chain. */
+static void secp256k1_scalar_inverse_addchain(secp256k1_scalar *r, const secp256k1_scalar *x) {
     secp256k1_scalar *t;
     int i;
     /* First compute xN as x ^ (2^N - 1) for some values of N,
@@ -230,15 +235,22 @@ static void secp256k1_scalar_inverse(secp256k1_scalar *r, const secp256k1_scalar
     secp256k1_scalar_mul(r, t, &x6); /* 111111 */
 }
 
+static void secp256k1_scalar_inverse(secp256k1_scalar *r, const secp256k1_scalar *x) {
+#if defined(USE_SCALAR_INV_SAFEGCD)
+    secp256k1_scalar_inverse_safegcd(r, x);
+#else
+    secp256k1_scalar_inverse_addchain(r, x);
+#endif
+}
+
 SECP256K1_INLINE static int secp256k1_scalar_is_even(const secp256k1_scalar *a) {
     return !(a->d[0] & 1);
 }
 #endif
 
-static void secp256k1_scalar_inverse_var(secp256k1_scalar *r, const secp256k1_scalar *x) {
-#if defined(USE_SCALAR_INV_BUILTIN)
-    secp256k1_scalar_inverse(r, x);
-#elif defined(USE_SCALAR_INV_NUM)
+#ifndef USE_NUM_NONE
+/** Variable-time inverse with the bignum library. */
+static void secp256k1_scalar_inverse_num_var(secp256k1_scalar *r, const secp256k1_scalar *x) {
     unsigned char b[32];
     secp256k1_num n, m;
     secp256k1_scalar t = *x;
@@ -251,11 +263,77 @@ static void secp256k1_scalar_inverse_var(secp256k1_scalar *r, const secp256k1_sc
     /* Verify that the inverse was computed correctly, without GMP code. */
     secp256k1_scalar_mul(&t, &t, r);
     CHECK(secp256k1_scalar_is_one(&t));
+}
+#endif
+
+static void secp256k1_scalar_inverse_var(secp256k1_scalar *r, const secp256k1_scalar *x) {
+#if defined(USE_SCALAR_INV_SAFEGCD) && !defined(EXHAUSTIVE_TEST_ORDER)
+    secp256k1_scalar_inverse_safegcd_var(r, x);
+#elif defined(USE_SCALAR_INV_BUILTIN) || defined(USE_SCALAR_INV_SAFEGCD)
+    secp256k1_scalar_inverse(r, x);
+#elif defined(USE_SCALAR_INV_NUM)
+    secp256k1_scalar_inverse_num_var(r, x);
 #else
 #error "Please select scalar inverse implementation"
 #endif
 }
 
+static void secp256k1_scalar_inverse_all(secp256k1_scalar *r, const secp256k1_scalar *a, size_t len) {
+    secp256k1_scalar u;
+    size_t i;
+    /* Only the number of elements, which is public, affects the control flow. */
+    if (len < 1) {
+        return;
+    }
+
+    VERIFY_CHECK((r + len <= a) || (a + len <= r));
+
+    r[0] = a[0];
+
+    i = 0;
+    while (++i < len) {
+        secp256k1_scalar_mul(&r[i], &r[i - 1], &a[i]);
+    }
+
+    secp256k1_scalar_inverse(&u, &r[--i]);
+
+    while (i > 0) {
+        size_t j = i--;
+        secp256k1_scalar_mul(&r[j], &r[i], &u);
+        secp256k1_scalar_mul(&u, &u, &a[j]);
+    }
+
+    r[0] = u;
+    secp256k1_scalar_clear(&u);
+}
+
+static void secp256k1_scalar_inverse_all_var(secp256k1_scalar *r, const secp256k1_scalar *a, size_t len) {
+    secp256k1_scalar u;
+    size_t i;
+    if (len < 1) {
+        return;
+    }
+
+    VERIFY_CHECK((r + len <= a) || (a + len <= r));
+
+    r[0] = a[0];
+
+    i = 0;
+    while (++i < len) {
+        secp256k1_scalar_mul(&r[i], &r[i - 1], &a[i]);
+    }
+
+    secp256k1_scalar_inverse_var(&u, &r[--i]);
+
+    while (i > 0) {
+        size_t j = i--;
+        secp256k1_scalar_mul(&r[j], &r[i], &u);
+        secp256k1_scalar_mul(&u, &u, &a[j]);
+    }
+
+    r[0] = u;
+}
+
 /* These parameters are generated using sage/gen_exhaustive_groups.sage. */
 #if defined(EXHAUSTIVE_TEST_ORDER)
 #  if EXHAUSTIVE_TEST_ORDER == 13
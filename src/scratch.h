@@ -19,10 +19,30 @@ typedef struct secp256k1_scratch_space_struct {
     size_t alloc_size;
     /** maximum size available to allocate */
     size_t max_size;
+    /** the allocator that allocated this object, unused for children */
+    secp256k1_allocator allocator;
+    /** for a growable scratch space (whose data is allocated separately), the
+     *  size it may grow to; 0 for a fixed size */
+    size_t limit;
+    /** largest size allocated or asked for by secp256k1_scratch_grow so far */
+    size_t high_water;
+    /** where to report the performance degradations of the functions using this
+     *  object, inherited by children */
+    secp256k1_event_callback event_callback;
 } secp256k1_scratch;
 
+/** Growable scratch spaces grow to a multiple of this many bytes. */
+#define SCRATCH_GROW_CHUNK ((size_t)1 << 16)
+
 static secp256k1_scratch* secp256k1_scratch_create(const secp256k1_callback* error_callback, size_t max_size);
 
+/** Like secp256k1_scratch_create, but allocates with (and, when the scratch space is
+ *  destroyed, frees with) allocator. */
+static secp256k1_scratch* secp256k1_scratch_create_with_allocator(const secp256k1_callback* error_callback, const secp256k1_allocator* allocator, size_t max_size);
+
+/** Creates an empty scratch space that secp256k1_scratch_grow enlarges up to limit bytes. */
+static secp256k1_scratch* secp256k1_scratch_create_growable(const secp256k1_callback* error_callback, const secp256k1_allocator* allocator, size_t limit);
+
 static void secp256k1_scratch_destroy(const secp256k1_callback* error_callback, secp256k1_scratch* scratch);
 
 /** Returns an opaque object used to "checkpoint" a scratch space. Used
@@ -39,4 +59,18 @@ static size_t secp256k1_scratch_max_allocation(const secp256k1_callback* error_c
 /** Returns a pointer into the most recently allocated frame, or NULL if there is insufficient available space */
 static void *secp256k1_scratch_alloc(const secp256k1_callback* error_callback, secp256k1_scratch* scratch, size_t n);
 
+/** Called with the size an algorithm would like to have available before it
+ *  allocates from scratch. Grows a growable scratch space that has no
+ *  outstanding allocations towards size, and records size as the high-water
+ *  mark. Returns whether size bytes are available (a failure to grow is not an
+ *  error, as callers make do with the available space). */
+static int secp256k1_scratch_grow(const secp256k1_callback* error_callback, secp256k1_scratch* scratch, size_t size);
+
+/** Allocates size bytes from scratch and initializes child as an independent
+ *  scratch space on top of them, so that it can be used without touching (or
+ *  synchronizing with) scratch. Must not be destroyed; applying a checkpoint
+ *  of scratch from before this call releases it. Returns 0 if there is
+ *  insufficient available space. */
+static int secp256k1_scratch_alloc_child(const secp256k1_callback* error_callback, secp256k1_scratch* scratch, secp256k1_scratch* child, size_t size);
+
 #endif
@@ -10,19 +10,33 @@
 #include "util.h"
 #include "scratch.h"
 
-static secp256k1_scratch* secp256k1_scratch_create(const secp256k1_callback* error_callback, size_t size) {
+static secp256k1_scratch* secp256k1_scratch_create_with_allocator(const secp256k1_callback* error_callback, const secp256k1_allocator* allocator, size_t size) {
     const size_t base_alloc = ROUND_TO_ALIGN(sizeof(secp256k1_scratch));
-    void *alloc = checked_malloc(error_callback, base_alloc + size);
+    void *alloc = secp256k1_allocator_alloc(allocator, error_callback, base_alloc + size);
     secp256k1_scratch* ret = (secp256k1_scratch *)alloc;
     if (ret != NULL) {
         memset(ret, 0, sizeof(*ret));
         memcpy(ret->magic, "scratch", 8);
         ret->data = (void *) ((char *) alloc + base_alloc);
         ret->max_size = size;
+        ret->allocator = *allocator;
+    }
+    return ret;
+}
+
+static secp256k1_scratch* secp256k1_scratch_create_growable(const secp256k1_callback* error_callback, const secp256k1_allocator* allocator, size_t limit) {
+    secp256k1_scratch* ret = secp256k1_scratch_create_with_allocator(error_callback, allocator, 0);
+    if (ret != NULL) {
+        ret->data = NULL;
+        ret->limit = limit;
     }
     return ret;
 }
 
+static secp256k1_scratch* secp256k1_scratch_create(const secp256k1_callback* error_callback, size_t size) {
+    return secp256k1_scratch_create_with_allocator(error_callback, &default_allocator, size);
+}
+
 static void secp256k1_scratch_destroy(const secp256k1_callback* error_callback, secp256k1_scratch* scratch) {
     if (scratch != NULL) {
         VERIFY_CHECK(scratch->alloc_size == 0); /* all checkpoints should be applied */
@@ -31,7 +45,10 @@ static void secp256k1_scratch_destroy(const secp256k1_callback* error_callback,
             return;
         }
         memset(scratch->magic, 0, sizeof(scratch->magic));
-        free(scratch);
+        if (scratch->limit != 0) {
+            secp256k1_allocator_free(&scratch->allocator, scratch->data);
+        }
+        secp256k1_allocator_free(&scratch->allocator, scratch);
     }
 }
 
@@ -87,13 +104,64 @@ static void *secp256k1_scratch_alloc(const secp256k1_callback* error_callback, s
     }
 
     if (size > scratch->max_size - scratch->alloc_size) {
+        SECP256K1_COUNT(SCRATCH_EXHAUSTED);
         return NULL;
     }
     ret = (void *) ((char *) scratch->data + scratch->alloc_size);
     memset(ret, 0, size);
     scratch->alloc_size += size;
+    if (scratch->alloc_size > scratch->high_water) {
+        scratch->high_water = scratch->alloc_size;
+    }
 
     return ret;
 }
 
+static int secp256k1_scratch_grow(const secp256k1_callback* error_callback, secp256k1_scratch* scratch, size_t size) {
+    size_t new_size;
+    void *data;
+
+    if (secp256k1_memcmp_var(scratch->magic, "scratch", 8) != 0) {
+        secp256k1_callback_call(error_callback, "invalid scratch space");
+        return 0;
+    }
+    if (size > scratch->high_water) {
+        scratch->high_water = size;
+    }
+    if (size <= scratch->max_size || scratch->limit == 0 || scratch->alloc_size != 0) {
+        return size <= scratch->max_size;
+    }
+
+    new_size = size > scratch->limit ? scratch->limit : size;
+    if (new_size % SCRATCH_GROW_CHUNK != 0 && scratch->limit - new_size >= SCRATCH_GROW_CHUNK - new_size % SCRATCH_GROW_CHUNK) {
+        new_size += SCRATCH_GROW_CHUNK - new_size % SCRATCH_GROW_CHUNK;
+    }
+    if (new_size <= scratch->max_size) {
+        return 0;
+    }
+    /* Not checked_malloc: running out of memory here only means the caller
+     * uses smaller batches. */
+    data = secp256k1_allocator_try_alloc(&scratch->allocator, new_size);
+    if (data == NULL) {
+        return 0;
+    }
+    secp256k1_allocator_free(&scratch->allocator, scratch->data);
+    scratch->data = data;
+    scratch->max_size = new_size;
+    return size <= new_size;
+}
+
+static int secp256k1_scratch_alloc_child(const secp256k1_callback* error_callback, secp256k1_scratch* scratch, secp256k1_scratch* child, size_t size) {
+    void *data = secp256k1_scratch_alloc(error_callback, scratch, size);
+    if (data == NULL) {
+        return 0;
+    }
+    memset(child, 0, sizeof(*child));
+    memcpy(child->magic, "scratch", 8);
+    child->data = data;
+    child->max_size = ROUND_TO_ALIGN(size);
+    child->event_callback = scratch->event_callback;
+    return 1;
+}
+
 #endif
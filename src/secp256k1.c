@@ -9,6 +9,7 @@
 
 #include "assumptions.h"
 #include "util.h"
+#include "cpu_impl.h"
 #include "num_impl.h"
 #include "field_impl.h"
 #include "scalar_impl.h"
@@ -20,6 +21,8 @@
 #include "eckey_impl.h"
 #include "hash_impl.h"
 #include "scratch_impl.h"
+#include "sigcache_impl.h"
+#include "nonce_pool_impl.h"
 #include "selftest.h"
 
 #if defined(VALGRIND)
@@ -72,6 +75,12 @@ struct secp256k1_context_struct {
     secp256k1_ecmult_gen_context ecmult_gen_ctx;
     secp256k1_callback illegal_callback;
     secp256k1_callback error_callback;
+    /* passed on to the scratch spaces created with the context */
+    secp256k1_event_callback event_callback;
+    /* used for the objects allocated on behalf of the context */
+    secp256k1_allocator allocator;
+    /* frees the context itself, if created by secp256k1_context_create or _clone */
+    secp256k1_allocator own_allocator;
     int declassify;
 };
 
@@ -80,6 +89,9 @@ static const secp256k1_context secp256k1_context_no_precomp_ = {
     { 0 },
     { secp256k1_default_illegal_callback_fn, 0 },
     { secp256k1_default_error_callback_fn, 0 },
+    { NULL, 0 },
+    { NULL, NULL, 0 },
+    { NULL, NULL, 0 },
     0
 };
 const secp256k1_context *secp256k1_context_no_precomp = &secp256k1_context_no_precomp_;
@@ -107,10 +119,10 @@ size_t secp256k1_context_preallocated_size(unsigned int flags) {
 size_t secp256k1_context_preallocated_clone_size(const secp256k1_context* ctx) {
     size_t ret = ROUND_TO_ALIGN(sizeof(secp256k1_context));
     VERIFY_CHECK(ctx != NULL);
-    if (secp256k1_ecmult_gen_context_is_built(&ctx->ecmult_gen_ctx)) {
+    if (secp256k1_ecmult_gen_context_is_built(&ctx->ecmult_gen_ctx) && !secp256k1_ecmult_gen_context_is_external(&ctx->ecmult_gen_ctx)) {
         ret += SECP256K1_ECMULT_GEN_CONTEXT_PREALLOCATED_SIZE;
     }
-    if (secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx)) {
+    if (secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx) && !secp256k1_ecmult_context_is_external(&ctx->ecmult_ctx)) {
         ret += SECP256K1_ECMULT_CONTEXT_PREALLOCATED_SIZE;
     }
     return ret;
@@ -124,6 +136,8 @@ secp256k1_context* secp256k1_context_preallocated_create(void* prealloc, unsigne
     if (!secp256k1_selftest()) {
         secp256k1_callback_call(&default_error_callback, "self test failed");
     }
+    /* Select the code paths for this CPU before the tables are built with them. */
+    secp256k1_cpu_probe();
 
     prealloc_size = secp256k1_context_preallocated_size(flags);
     if (prealloc_size == 0) {
@@ -133,6 +147,10 @@ secp256k1_context* secp256k1_context_preallocated_create(void* prealloc, unsigne
     ret = (secp256k1_context*)manual_alloc(&prealloc, sizeof(secp256k1_context), base, prealloc_size);
     ret->illegal_callback = default_illegal_callback;
     ret->error_callback = default_error_callback;
+    ret->event_callback.fn = NULL;
+    ret->event_callback.data = NULL;
+    ret->allocator = default_allocator;
+    ret->own_allocator = default_allocator;
 
     secp256k1_ecmult_context_init(&ret->ecmult_ctx);
     secp256k1_ecmult_gen_context_init(&ret->ecmult_gen_ctx);
@@ -162,16 +180,19 @@ secp256k1_context* secp256k1_context_create(unsigned int flags) {
 }
 
 secp256k1_context* secp256k1_context_preallocated_clone(const secp256k1_context* ctx, void* prealloc) {
+    void* const base = prealloc;
     size_t prealloc_size;
     secp256k1_context* ret;
     VERIFY_CHECK(ctx != NULL);
     ARG_CHECK(prealloc != NULL);
 
     prealloc_size = secp256k1_context_preallocated_clone_size(ctx);
-    ret = (secp256k1_context*)prealloc;
-    memcpy(ret, ctx, prealloc_size);
-    secp256k1_ecmult_gen_context_finalize_memcpy(&ret->ecmult_gen_ctx, &ctx->ecmult_gen_ctx);
-    secp256k1_ecmult_context_finalize_memcpy(&ret->ecmult_ctx, &ctx->ecmult_ctx);
+    ret = (secp256k1_context*)manual_alloc(&prealloc, sizeof(secp256k1_context), base, prealloc_size);
+    *ret = *ctx;
+    /* The tables are copied one by one (rather than memcpy'ing the whole block), so
+     * that they are cache-line aligned in the new block as well. */
+    secp256k1_ecmult_gen_context_clone(&ret->ecmult_gen_ctx, &ctx->ecmult_gen_ctx, &prealloc);
+    secp256k1_ecmult_context_clone(&ret->ecmult_ctx, &ctx->ecmult_ctx, &prealloc);
     return ret;
 }
 
@@ -181,11 +202,95 @@ secp256k1_context* secp256k1_context_clone(const secp256k1_context* ctx) {
 
     VERIFY_CHECK(ctx != NULL);
     prealloc_size = secp256k1_context_preallocated_clone_size(ctx);
-    ret = (secp256k1_context*)checked_malloc(&ctx->error_callback, prealloc_size);
+    ret = (secp256k1_context*)secp256k1_allocator_alloc(&ctx->allocator, &ctx->error_callback, prealloc_size);
+    if (ret == NULL) {
+        return NULL;
+    }
     ret = secp256k1_context_preallocated_clone(ctx, ret);
+    ret->own_allocator = ctx->allocator;
     return ret;
 }
 
+size_t secp256k1_context_preallocated_clone_shared_size(const secp256k1_context* ctx) {
+    VERIFY_CHECK(ctx != NULL);
+    (void)ctx;
+    return ROUND_TO_ALIGN(sizeof(secp256k1_context));
+}
+
+secp256k1_context* secp256k1_context_preallocated_clone_shared(const secp256k1_context* ctx, void* prealloc) {
+    secp256k1_context* ret;
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(prealloc != NULL);
+
+    ret = (secp256k1_context*)prealloc;
+    *ret = *ctx;
+    secp256k1_ecmult_gen_context_share(&ret->ecmult_gen_ctx, &ctx->ecmult_gen_ctx);
+    secp256k1_ecmult_context_share(&ret->ecmult_ctx, &ctx->ecmult_ctx);
+    return ret;
+}
+
+secp256k1_context* secp256k1_context_clone_shared(const secp256k1_context* ctx) {
+    secp256k1_context* ret;
+
+    VERIFY_CHECK(ctx != NULL);
+    ret = (secp256k1_context*)secp256k1_allocator_alloc(&ctx->allocator, &ctx->error_callback, secp256k1_context_preallocated_clone_shared_size(ctx));
+    if (ret == NULL) {
+        return NULL;
+    }
+    ret = secp256k1_context_preallocated_clone_shared(ctx, ret);
+    ret->own_allocator = ctx->allocator;
+    return ret;
+}
+
+size_t secp256k1_context_verify_table_size(void) {
+    return SECP256K1_ECMULT_CONTEXT_SERIALIZED_SIZE;
+}
+
+int secp256k1_context_verify_table_serialize(const secp256k1_context* ctx, unsigned char *output, size_t outputlen) {
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(output != NULL);
+    ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(outputlen >= SECP256K1_ECMULT_CONTEXT_SERIALIZED_SIZE);
+
+    secp256k1_ecmult_context_serialize(&ctx->ecmult_ctx, output);
+    return 1;
+}
+
+int secp256k1_context_verify_table_build(const secp256k1_context* ctx, unsigned char *output, size_t outputlen, size_t part, size_t n_parts) {
+    size_t const n_entries = ECMULT_G_TABLES * (size_t)ECMULT_TABLE_SIZE(WINDOW_G);
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(output != NULL);
+    ARG_CHECK(outputlen >= SECP256K1_ECMULT_CONTEXT_SERIALIZED_SIZE);
+    ARG_CHECK(part < n_parts);
+
+    /* We cast to void* first to suppress a -Wcast-align warning. */
+    secp256k1_ecmult_table_build_range((secp256k1_ge_storage*)(void*)&output[ECMULT_TABLE_HEADER_SIZE],
+        n_entries / n_parts * part + (part < n_entries % n_parts ? part : n_entries % n_parts),
+        n_entries / n_parts * (part + 1) + (part + 1 < n_entries % n_parts ? part + 1 : n_entries % n_parts));
+    return 1;
+}
+
+int secp256k1_context_verify_table_finish(const secp256k1_context* ctx, unsigned char *output, size_t outputlen) {
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(output != NULL);
+    ARG_CHECK(outputlen >= SECP256K1_ECMULT_CONTEXT_SERIALIZED_SIZE);
+
+    secp256k1_ecmult_table_finish(output);
+    return 1;
+}
+
+int secp256k1_context_verify_table_load(secp256k1_context* ctx, const unsigned char *input, size_t inputlen) {
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(ctx != secp256k1_context_no_precomp);
+    ARG_CHECK(input != NULL);
+    ARG_CHECK(!secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+
+    if (inputlen != SECP256K1_ECMULT_CONTEXT_SERIALIZED_SIZE) {
+        return 0;
+    }
+    return secp256k1_ecmult_context_load(&ctx->ecmult_ctx, input);
+}
+
 void secp256k1_context_preallocated_destroy(secp256k1_context* ctx) {
     ARG_CHECK_NO_RETURN(ctx != secp256k1_context_no_precomp);
     if (ctx != NULL) {
@@ -196,8 +301,9 @@ void secp256k1_context_preallocated_destroy(secp256k1_context* ctx) {
 
 void secp256k1_context_destroy(secp256k1_context* ctx) {
     if (ctx != NULL) {
+        secp256k1_allocator const own_allocator = ctx->own_allocator;
         secp256k1_context_preallocated_destroy(ctx);
-        free(ctx);
+        secp256k1_allocator_free(&own_allocator, ctx);
     }
 }
 
@@ -219,9 +325,49 @@ void secp256k1_context_set_error_callback(secp256k1_context* ctx, void (*fun)(co
     ctx->error_callback.data = data;
 }
 
+void secp256k1_context_set_event_callback(secp256k1_context* ctx, void (*fun)(int event, size_t wanted, size_t available, void* data), const void* data) {
+    ARG_CHECK_NO_RETURN(ctx != secp256k1_context_no_precomp);
+    ctx->event_callback.fn = fun;
+    ctx->event_callback.data = data;
+}
+
+void secp256k1_context_set_allocator(secp256k1_context* ctx, void* (*alloc_fn)(size_t size, void* data), void (*free_fn)(void* ptr, void* data), const void* data) {
+    ARG_CHECK_NO_RETURN(ctx != secp256k1_context_no_precomp);
+    ARG_CHECK_NO_RETURN((alloc_fn == NULL) == (free_fn == NULL));
+    if (alloc_fn == NULL || free_fn == NULL) {
+        ctx->allocator = default_allocator;
+        return;
+    }
+    ctx->allocator.alloc = alloc_fn;
+    ctx->allocator.free = free_fn;
+    ctx->allocator.data = data;
+}
+
 secp256k1_scratch_space* secp256k1_scratch_space_create(const secp256k1_context* ctx, size_t max_size) {
+    secp256k1_scratch_space* ret;
     VERIFY_CHECK(ctx != NULL);
-    return secp256k1_scratch_create(&ctx->error_callback, max_size);
+    ret = secp256k1_scratch_create_with_allocator(&ctx->error_callback, &ctx->allocator, max_size);
+    if (ret != NULL) {
+        ret->event_callback = ctx->event_callback;
+    }
+    return ret;
+}
+
+secp256k1_scratch_space* secp256k1_scratch_space_create_growable(const secp256k1_context* ctx, size_t max_size) {
+    secp256k1_scratch_space* ret;
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(max_size > 0);
+    ret = secp256k1_scratch_create_growable(&ctx->error_callback, &ctx->allocator, max_size);
+    if (ret != NULL) {
+        ret->event_callback = ctx->event_callback;
+    }
+    return ret;
+}
+
+size_t secp256k1_scratch_space_high_water(const secp256k1_context* ctx, const secp256k1_scratch_space* scratch) {
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(scratch != NULL);
+    return scratch->high_water;
 }
 
 void secp256k1_scratch_space_destroy(const secp256k1_context *ctx, secp256k1_scratch_space* scratch) {
@@ -294,6 +440,59 @@ int secp256k1_ec_pubkey_parse(const secp256k1_context* ctx, secp256k1_pubkey* pu
     return 1;
 }
 
+/* The number of compressed keys secp256k1_ec_pubkey_parse_batch decompresses at once */
+#define EC_PUBKEY_PARSE_BATCH_SIZE 32
+
+int secp256k1_ec_pubkey_parse_batch(const secp256k1_context* ctx, secp256k1_pubkey* pubkeys, const unsigned char * const *inputs, const size_t *inputlens, size_t n) {
+    secp256k1_fe x[EC_PUBKEY_PARSE_BATCH_SIZE];
+    secp256k1_ge q[EC_PUBKEY_PARSE_BATCH_SIZE];
+    int odd[EC_PUBKEY_PARSE_BATCH_SIZE];
+    int valid[EC_PUBKEY_PARSE_BATCH_SIZE];
+    size_t idx[EC_PUBKEY_PARSE_BATCH_SIZE];
+    size_t i, j, batch = 0;
+    int ret = 1;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(pubkeys != NULL || n == 0);
+    for (i = 0; i < n; i++) {
+        memset(&pubkeys[i], 0, sizeof(pubkeys[i]));
+    }
+    ARG_CHECK(inputs != NULL || n == 0);
+    ARG_CHECK(inputlens != NULL || n == 0);
+    for (i = 0; i < n; i++) {
+        ARG_CHECK(inputs[i] != NULL);
+    }
+
+    for (i = 0; i < n; i++) {
+        const unsigned char *input = inputs[i];
+        if (inputlens[i] == 33 && (input[0] == SECP256K1_TAG_PUBKEY_EVEN || input[0] == SECP256K1_TAG_PUBKEY_ODD)) {
+            /* Queue compressed keys for decompression. */
+            if (secp256k1_fe_set_b32(&x[batch], input + 1)) {
+                odd[batch] = input[0] == SECP256K1_TAG_PUBKEY_ODD;
+                idx[batch++] = i;
+            } else {
+                ret = 0;
+            }
+        } else if (secp256k1_eckey_pubkey_parse(&q[0], input, inputlens[i]) && secp256k1_ge_is_in_correct_subgroup(&q[0])) {
+            secp256k1_pubkey_save(&pubkeys[i], &q[0]);
+        } else {
+            ret = 0;
+        }
+        if (batch == EC_PUBKEY_PARSE_BATCH_SIZE || (i == n - 1 && batch > 0)) {
+            secp256k1_ge_set_xo_batch_var(q, valid, x, odd, batch);
+            for (j = 0; j < batch; j++) {
+                if (valid[j] && secp256k1_ge_is_in_correct_subgroup(&q[j])) {
+                    secp256k1_pubkey_save(&pubkeys[idx[j]], &q[j]);
+                } else {
+                    ret = 0;
+                }
+            }
+            batch = 0;
+        }
+    }
+    return ret;
+}
+
 int secp256k1_ec_pubkey_serialize(const secp256k1_context* ctx, unsigned char *output, size_t *outputlen, const secp256k1_pubkey* pubkey, unsigned int flags) {
     secp256k1_ge Q;
     size_t len;
@@ -357,6 +556,33 @@ int secp256k1_ecdsa_signature_parse_der(const secp256k1_context* ctx, secp256k1_
     }
 }
 
+int secp256k1_ecdsa_signature_parse_der_batch(const secp256k1_context* ctx, secp256k1_ecdsa_signature* sigs, const unsigned char * const *inputs, const size_t *inputlens, size_t n) {
+    secp256k1_scalar r, s;
+    size_t i;
+    int ret = 1;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(sigs != NULL || n == 0);
+    ARG_CHECK(inputs != NULL || n == 0);
+    ARG_CHECK(inputlens != NULL || n == 0);
+    for (i = 0; i < n; i++) {
+        ARG_CHECK(inputs[i] != NULL);
+    }
+
+    for (i = 0; i < n; i++) {
+        /* The shortest DER encoding has two one-byte integers; anything shorter is
+         * rejected without parsing. Longer (overflowing) integers still parse, as
+         * with secp256k1_ecdsa_signature_parse_der. */
+        if (inputlens[i] >= 8 && secp256k1_ecdsa_sig_parse(&r, &s, inputs[i], inputlens[i])) {
+            secp256k1_ecdsa_signature_save(&sigs[i], &r, &s);
+        } else {
+            memset(&sigs[i], 0, sizeof(sigs[i]));
+            ret = 0;
+        }
+    }
+    return ret;
+}
+
 int secp256k1_ecdsa_signature_parse_compact(const secp256k1_context* ctx, secp256k1_ecdsa_signature* sig, const unsigned char *input64) {
     secp256k1_scalar r, s;
     int ret = 1;
@@ -439,11 +665,209 @@ int secp256k1_ecdsa_verify(const secp256k1_context* ctx, const secp256k1_ecdsa_s
             secp256k1_ecdsa_sig_verify(&ctx->ecmult_ctx, &r, &s, &q, &m));
 }
 
+int secp256k1_ecdsa_verify_many(const secp256k1_context* ctx, int *results, const secp256k1_ecdsa_signature *const *sigs, const unsigned char *const *msg32, const secp256k1_pubkey *const *pubkeys, size_t n) {
+    secp256k1_scalar r[ECMULT_LANES], s[ECMULT_LANES], m[ECMULT_LANES];
+    secp256k1_ge q[ECMULT_LANES];
+    int valid[ECMULT_LANES];
+    size_t lane_idx[ECMULT_LANES];
+    size_t i, j, k;
+    int all_valid = 1;
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(n == 0 || (sigs != NULL && msg32 != NULL && pubkeys != NULL));
+    for (i = 0; i < n; i++) {
+        ARG_CHECK(sigs[i] != NULL);
+        ARG_CHECK(msg32[i] != NULL);
+        ARG_CHECK(pubkeys[i] != NULL);
+    }
+
+    for (i = 0; i < n; i += ECMULT_LANES) {
+        size_t n_lanes = n - i < ECMULT_LANES ? n - i : ECMULT_LANES;
+        /* Signatures that fail the checks of secp256k1_ecdsa_verify before the
+         * multiplication do not take a lane. */
+        k = 0;
+        for (j = 0; j < n_lanes; j++) {
+            if (results != NULL) {
+                results[i + j] = 0;
+            }
+            secp256k1_ecdsa_signature_load(ctx, &r[k], &s[k], sigs[i + j]);
+            if (secp256k1_scalar_is_high(&s[k]) || !secp256k1_pubkey_load(ctx, &q[k], pubkeys[i + j])) {
+                all_valid = 0;
+                continue;
+            }
+            secp256k1_scalar_set_b32(&m[k], msg32[i + j], NULL);
+            lane_idx[k++] = i + j;
+        }
+        secp256k1_ecdsa_sig_verify_lanes(&ctx->ecmult_ctx, valid, r, s, q, m, k);
+        for (j = 0; j < k; j++) {
+            if (results != NULL) {
+                results[lane_idx[j]] = valid[j];
+            }
+            all_valid &= valid[j];
+        }
+    }
+    return all_valid;
+}
+
+struct secp256k1_pubkey_prepared_struct {
+    secp256k1_ecmult_prepared_point point;
+    /* The allocator of the context the object was created with */
+    secp256k1_allocator allocator;
+};
+
+secp256k1_pubkey_prepared* secp256k1_pubkey_prepared_create(const secp256k1_context* ctx, const secp256k1_pubkey *pubkey) {
+    secp256k1_pubkey_prepared *prepared;
+    secp256k1_ge p;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(pubkey != NULL);
+    if (!secp256k1_pubkey_load(ctx, &p, pubkey)) {
+        return NULL;
+    }
+
+    prepared = (secp256k1_pubkey_prepared *) secp256k1_allocator_alloc(&ctx->allocator, &ctx->error_callback, sizeof(*prepared));
+    if (prepared != NULL) {
+        secp256k1_ecmult_prepared_point_build(&prepared->point, &p);
+        prepared->allocator = ctx->allocator;
+    }
+    return prepared;
+}
+
+void secp256k1_pubkey_prepared_destroy(const secp256k1_context* ctx, secp256k1_pubkey_prepared *prepared) {
+    VERIFY_CHECK(ctx != NULL);
+    (void)ctx;
+    if (prepared != NULL) {
+        secp256k1_allocator_free(&prepared->allocator, prepared);
+    }
+}
+
+int secp256k1_ecdsa_verify_prepared(const secp256k1_context* ctx, const secp256k1_ecdsa_signature *sig, const unsigned char *msg32, const secp256k1_pubkey_prepared *prepared) {
+    secp256k1_scalar r, s;
+    secp256k1_scalar m;
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(msg32 != NULL);
+    ARG_CHECK(sig != NULL);
+    ARG_CHECK(prepared != NULL);
+
+    secp256k1_scalar_set_b32(&m, msg32, NULL);
+    secp256k1_ecdsa_signature_load(ctx, &r, &s, sig);
+    return (!secp256k1_scalar_is_high(&s) &&
+            secp256k1_ecdsa_sig_verify_prepared(&ctx->ecmult_ctx, &r, &s, &prepared->point, &m));
+}
+
+secp256k1_sigcache* secp256k1_sigcache_create(const secp256k1_context* ctx, size_t n_entries, const unsigned char *salt32) {
+    secp256k1_sigcache *cache;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(n_entries > 0);
+    ARG_CHECK(n_entries <= 0xFFFFFFFF && n_entries <= ((size_t)-1) / (2 * sizeof(uint64_t)));
+    ARG_CHECK(salt32 != NULL);
+
+    cache = (secp256k1_sigcache *) secp256k1_allocator_alloc(&ctx->allocator, &ctx->error_callback, sizeof(*cache));
+    if (cache == NULL) {
+        return NULL;
+    }
+    cache->table = (uint64_t (*)[2]) secp256k1_allocator_alloc(&ctx->allocator, &ctx->error_callback, n_entries * sizeof(*cache->table));
+    if (cache->table == NULL) {
+        secp256k1_allocator_free(&ctx->allocator, cache);
+        return NULL;
+    }
+    memset(cache->table, 0, n_entries * sizeof(*cache->table));
+    cache->size = n_entries;
+    cache->hits = cache->misses = cache->evictions = 0;
+    secp256k1_sha256_initialize(&cache->hasher);
+    secp256k1_sha256_write(&cache->hasher, salt32, 32);
+    cache->allocator = ctx->allocator;
+    return cache;
+}
+
+void secp256k1_sigcache_destroy(const secp256k1_context* ctx, secp256k1_sigcache *cache) {
+    VERIFY_CHECK(ctx != NULL);
+    (void)ctx;
+    if (cache != NULL) {
+        secp256k1_allocator_free(&cache->allocator, cache->table);
+        secp256k1_allocator_free(&cache->allocator, cache);
+    }
+}
+
+void secp256k1_sigcache_stats(const secp256k1_context* ctx, const secp256k1_sigcache *cache, size_t *hits, size_t *misses, size_t *evictions) {
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK_NO_RETURN(cache != NULL);
+    if (cache == NULL) {
+        return;
+    }
+    if (hits != NULL) {
+        *hits = ATOMIC_LOAD(&cache->hits);
+    }
+    if (misses != NULL) {
+        *misses = ATOMIC_LOAD(&cache->misses);
+    }
+    if (evictions != NULL) {
+        *evictions = ATOMIC_LOAD(&cache->evictions);
+    }
+}
+
+int secp256k1_ecdsa_verify_cached(const secp256k1_context* ctx, secp256k1_sigcache *cache, const secp256k1_ecdsa_signature *sig, const unsigned char *msg32, const secp256k1_pubkey *pubkey) {
+    static const unsigned char tag = 'E';
+    secp256k1_sha256 hash;
+    secp256k1_ge q;
+    secp256k1_scalar r, s;
+    secp256k1_scalar m;
+    unsigned char buf[64];
+    uint64_t entry[2];
+    size_t len = 33;
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(cache != NULL);
+    ARG_CHECK(msg32 != NULL);
+    ARG_CHECK(sig != NULL);
+    ARG_CHECK(pubkey != NULL);
+
+    secp256k1_ecdsa_signature_load(ctx, &r, &s, sig);
+    if (secp256k1_scalar_is_high(&s) || !secp256k1_pubkey_load(ctx, &q, pubkey)) {
+        return 0;
+    }
+
+    /* The entry commits to the signature, message and key in canonical form. */
+    secp256k1_sigcache_hasher(cache, &hash);
+    secp256k1_sha256_write(&hash, &tag, 1);
+    secp256k1_scalar_get_b32(&buf[0], &r);
+    secp256k1_scalar_get_b32(&buf[32], &s);
+    secp256k1_sha256_write(&hash, buf, 64);
+    secp256k1_sha256_write(&hash, msg32, 32);
+    secp256k1_eckey_pubkey_serialize(&q, buf, &len, 1);
+    secp256k1_sha256_write(&hash, buf, len);
+    secp256k1_sigcache_entry(entry, &hash);
+    if (secp256k1_sigcache_lookup(cache, entry)) {
+        return 1;
+    }
+
+    secp256k1_scalar_set_b32(&m, msg32, NULL);
+    if (!secp256k1_ecdsa_sig_verify(&ctx->ecmult_ctx, &r, &s, &q, &m)) {
+        return 0;
+    }
+    secp256k1_sigcache_insert(cache, entry);
+    return 1;
+}
+
 static SECP256K1_INLINE void buffer_append(unsigned char *buf, unsigned int *offset, const void *data, unsigned int len) {
     memcpy(buf + *offset, data, len);
     *offset += len;
 }
 
+#ifdef ENABLE_VERIFY_ONLY
+static int nonce_function_rfc6979(unsigned char *nonce32, const unsigned char *msg32, const unsigned char *key32, const unsigned char *algo16, void *data, unsigned int counter) {
+   /* Nothing is signed in a verification-only build, so leave RFC6979 out of it. */
+   (void)nonce32;
+   (void)msg32;
+   (void)key32;
+   (void)algo16;
+   (void)data;
+   (void)counter;
+   return 0;
+}
+#else
 static int nonce_function_rfc6979(unsigned char *nonce32, const unsigned char *msg32, const unsigned char *key32, const unsigned char *algo16, void *data, unsigned int counter) {
    unsigned char keydata[112];
    unsigned int offset = 0;
@@ -473,6 +897,7 @@ static int nonce_function_rfc6979(unsigned char *nonce32, const unsigned char *m
    secp256k1_rfc6979_hmac_sha256_finalize(&rng);
    return 1;
 }
+#endif
 
 const secp256k1_nonce_function secp256k1_nonce_function_rfc6979 = nonce_function_rfc6979;
 const secp256k1_nonce_function secp256k1_nonce_function_default = nonce_function_rfc6979;
@@ -547,6 +972,217 @@ int secp256k1_ecdsa_sign(const secp256k1_context* ctx, secp256k1_ecdsa_signature
     return ret;
 }
 
+/* A session holds the inner hash state of RFC6979's first HMAC after the fixed
+ * prefix and the first 31 bytes of the key, which end its second block
+ * (data[0..31]), and the secret key (data[32..63]). */
+int secp256k1_ecdsa_session_init(const secp256k1_context* ctx, secp256k1_ecdsa_session *session, const unsigned char *seckey) {
+    secp256k1_sha256 inner;
+    secp256k1_scalar sec;
+    int ret;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(session != NULL);
+    memset(session, 0, sizeof(*session));
+    ARG_CHECK(seckey != NULL);
+
+    ret = secp256k1_scalar_set_b32_seckey(&sec, seckey);
+    secp256k1_scalar_clear(&sec);
+    /* Like secp256k1_keypair_create, this reveals whether the key was valid. */
+    secp256k1_declassify(ctx, &ret, sizeof(ret));
+    if (!ret) {
+        return 0;
+    }
+    secp256k1_rfc6979_hmac_sha256_start(&inner);
+    secp256k1_sha256_write(&inner, seckey, 31);
+    secp256k1_sha256_save_midstate(&session->data[0], &inner);
+    memcpy(&session->data[32], seckey, 32);
+    memset(&inner, 0, sizeof(inner));
+    return 1;
+}
+
+/* The nonce function of secp256k1_ecdsa_sign_session: data is an RFC6979
+ * generator already initialized with the key, message and extra entropy, and
+ * the counter-th call returns its counter-th output, which is what
+ * nonce_function_rfc6979 returns for counter. */
+static int nonce_function_rfc6979_session(unsigned char *nonce32, const unsigned char *msg32, const unsigned char *key32, const unsigned char *algo16, void *data, unsigned int counter) {
+    (void)msg32;
+    (void)key32;
+    (void)algo16;
+    (void)counter;
+    secp256k1_rfc6979_hmac_sha256_generate((secp256k1_rfc6979_hmac_sha256*)data, nonce32, 32);
+    return 1;
+}
+
+int secp256k1_ecdsa_sign_session(const secp256k1_context* ctx, secp256k1_ecdsa_signature *signature, const unsigned char *msg32, const secp256k1_ecdsa_session *session, const unsigned char *ndata) {
+    secp256k1_rfc6979_hmac_sha256 rng;
+    secp256k1_sha256 inner;
+    secp256k1_scalar r, s;
+    unsigned char keydata[96];
+    unsigned int offset = 0;
+    int ret;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(secp256k1_ecmult_gen_context_is_built(&ctx->ecmult_gen_ctx));
+    ARG_CHECK(msg32 != NULL);
+    ARG_CHECK(signature != NULL);
+    ARG_CHECK(session != NULL);
+
+    /* The same key material as nonce_function_rfc6979. */
+    buffer_append(keydata, &offset, &session->data[32], 32);
+    buffer_append(keydata, &offset, msg32, 32);
+    if (ndata != NULL) {
+        buffer_append(keydata, &offset, ndata, 32);
+    }
+    secp256k1_sha256_load_midstate(&inner, &session->data[0]);
+    inner.bytes = 128;
+    secp256k1_sha256_write(&inner, &keydata[31], offset - 31);
+    secp256k1_rfc6979_hmac_sha256_initialize_started(&rng, &inner, keydata, offset);
+
+    ret = secp256k1_ecdsa_sign_inner(ctx, &r, &s, NULL, msg32, &session->data[32], nonce_function_rfc6979_session, &rng);
+    secp256k1_ecdsa_signature_save(signature, &r, &s);
+
+    secp256k1_rfc6979_hmac_sha256_finalize(&rng);
+    memset(keydata, 0, sizeof(keydata));
+    memset(&inner, 0, sizeof(inner));
+    return ret;
+}
+
+secp256k1_nonce_pool* secp256k1_nonce_pool_create(const secp256k1_context* ctx, size_t n_nonces) {
+    secp256k1_nonce_pool *pool;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(n_nonces > 0);
+    ARG_CHECK(n_nonces <= ((size_t)-1) / sizeof(secp256k1_nonce_pool_entry));
+
+    pool = (secp256k1_nonce_pool *) secp256k1_allocator_alloc(&ctx->allocator, &ctx->error_callback, sizeof(*pool));
+    if (pool == NULL) {
+        return NULL;
+    }
+    pool->entries = (secp256k1_nonce_pool_entry *) secp256k1_allocator_alloc(&ctx->allocator, &ctx->error_callback, n_nonces * sizeof(*pool->entries));
+    if (pool->entries == NULL) {
+        secp256k1_allocator_free(&ctx->allocator, pool);
+        return NULL;
+    }
+    memset(pool->entries, 0, n_nonces * sizeof(*pool->entries));
+    memset(&pool->rng, 0, sizeof(pool->rng));
+    pool->seeded = 0;
+    pool->size = n_nonces;
+    pool->count = 0;
+    pool->allocator = ctx->allocator;
+    return pool;
+}
+
+void secp256k1_nonce_pool_destroy(const secp256k1_context* ctx, secp256k1_nonce_pool *pool) {
+    size_t i;
+    VERIFY_CHECK(ctx != NULL);
+    (void)ctx;
+    if (pool != NULL) {
+        for (i = 0; i < pool->count; i++) {
+            secp256k1_nonce_pool_entry_clear(&pool->entries[i]);
+        }
+        secp256k1_rfc6979_hmac_sha256_finalize(&pool->rng);
+        memset(&pool->rng, 0, sizeof(pool->rng));
+        secp256k1_allocator_free(&pool->allocator, pool->entries);
+        secp256k1_allocator_free(&pool->allocator, pool);
+    }
+}
+
+/* The number of nonces secp256k1_nonce_pool_fill inverts at once */
+#define NONCE_POOL_FILL_BATCH_SIZE 32
+
+int secp256k1_nonce_pool_fill(const secp256k1_context* ctx, secp256k1_nonce_pool *pool, const unsigned char *seed32) {
+    unsigned char nonce32[32];
+    secp256k1_scalar k[NONCE_POOL_FILL_BATCH_SIZE], kinv[NONCE_POOL_FILL_BATCH_SIZE];
+    secp256k1_gej rj;
+    secp256k1_ge r;
+    size_t start, i;
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(secp256k1_ecmult_gen_context_is_built(&ctx->ecmult_gen_ctx));
+    ARG_CHECK(pool != NULL);
+    ARG_CHECK(seed32 != NULL);
+
+    secp256k1_nonce_pool_reseed(pool, seed32);
+    start = pool->count;
+    while (pool->count < pool->size) {
+        secp256k1_nonce_pool_entry *entry = &pool->entries[pool->count];
+        int is_nonce_valid;
+        if (pool->count % NONCE_POOL_FILL_BATCH_SIZE == 0) {
+            start = pool->count;
+        }
+        secp256k1_nonce_pool_generate(pool, nonce32);
+        is_nonce_valid = secp256k1_scalar_set_b32_seckey(&entry->k, nonce32);
+        /* The nonce is still secret here, but it being invalid is less likely than 1:2^255. */
+        secp256k1_declassify(ctx, &is_nonce_valid, sizeof(is_nonce_valid));
+        if (!is_nonce_valid) {
+            continue;
+        }
+        secp256k1_ecmult_gen(&ctx->ecmult_gen_ctx, &rj, &entry->k);
+        secp256k1_ge_set_gej(&r, &rj);
+        /* R will be part of a signature, so it is not a secret. */
+        secp256k1_declassify(ctx, &r, sizeof(r));
+        secp256k1_fe_normalize_var(&r.y);
+        if (secp256k1_fe_is_odd(&r.y)) {
+            secp256k1_scalar_negate(&entry->k, &entry->k);
+        }
+        secp256k1_fe_normalize_var(&r.x);
+        secp256k1_fe_get_b32(entry->rx, &r.x);
+        pool->count++;
+        /* Invert the nonces generated so far together, sharing one inversion. */
+        if (pool->count % NONCE_POOL_FILL_BATCH_SIZE == 0 || pool->count == pool->size) {
+            for (i = start; i < pool->count; i++) {
+                k[i - start] = pool->entries[i].k;
+            }
+            secp256k1_scalar_inverse_all(kinv, k, pool->count - start);
+            for (i = start; i < pool->count; i++) {
+                pool->entries[i].kinv = kinv[i - start];
+            }
+        }
+    }
+
+    memset(nonce32, 0, sizeof(nonce32));
+    memset(k, 0, sizeof(k));
+    memset(kinv, 0, sizeof(kinv));
+    secp256k1_gej_clear(&rj);
+    return 1;
+}
+
+size_t secp256k1_nonce_pool_count(const secp256k1_context* ctx, const secp256k1_nonce_pool *pool) {
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(pool != NULL);
+    return pool->count;
+}
+
+int secp256k1_ecdsa_sign_pooled(const secp256k1_context* ctx, secp256k1_ecdsa_signature *signature, const unsigned char *msg32, const unsigned char *seckey, secp256k1_nonce_pool *pool) {
+    secp256k1_nonce_pool_entry entry;
+    secp256k1_scalar sec, msg, r, s;
+    int ret;
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(msg32 != NULL);
+    ARG_CHECK(signature != NULL);
+    ARG_CHECK(seckey != NULL);
+    ARG_CHECK(pool != NULL);
+
+    memset(signature, 0, sizeof(*signature));
+    if (!secp256k1_nonce_pool_take(pool, &entry)) {
+        return 0;
+    }
+    ret = secp256k1_scalar_set_b32_seckey(&sec, seckey);
+    secp256k1_scalar_cmov(&sec, &secp256k1_scalar_one, !ret);
+    secp256k1_scalar_set_b32(&msg, msg32, NULL);
+    secp256k1_scalar_set_b32(&r, entry.rx, NULL);
+    secp256k1_ecdsa_sig_sign_s(&s, &r, &sec, &msg, &entry.kinv);
+    /* As in secp256k1_ecdsa_sig_sign, r or s being zero is cryptographically unreachable. */
+    ret &= !secp256k1_scalar_is_zero(&r) & !secp256k1_scalar_is_zero(&s);
+    secp256k1_scalar_cmov(&r, &secp256k1_scalar_zero, !ret);
+    secp256k1_scalar_cmov(&s, &secp256k1_scalar_zero, !ret);
+    secp256k1_ecdsa_signature_save(signature, &r, &s);
+
+    secp256k1_nonce_pool_entry_clear(&entry);
+    secp256k1_scalar_clear(&msg);
+    secp256k1_scalar_clear(&sec);
+    return ret;
+}
+
 int secp256k1_ec_seckey_verify(const secp256k1_context* ctx, const unsigned char *seckey) {
     secp256k1_scalar sec;
     int ret;
@@ -588,6 +1224,154 @@ int secp256k1_ec_pubkey_create(const secp256k1_context* ctx, secp256k1_pubkey *p
     return ret;
 }
 
+/* Number of public keys secp256k1_ec_pubkey_create_batch converts with one inversion. */
+#define EC_PUBKEY_CREATE_BATCH_SIZE 32
+
+int secp256k1_ec_pubkey_create_batch(const secp256k1_context* ctx, secp256k1_pubkey *pubkeys, const unsigned char * const *seckeys, size_t n) {
+    secp256k1_gej pj[EC_PUBKEY_CREATE_BATCH_SIZE];
+    secp256k1_ge p[EC_PUBKEY_CREATE_BATCH_SIZE];
+    int valid[EC_PUBKEY_CREATE_BATCH_SIZE];
+    secp256k1_scalar seckey_scalar;
+    size_t i, j, batch;
+    int ret = 1;
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(pubkeys != NULL || n == 0);
+    for (i = 0; i < n; i++) {
+        memset(&pubkeys[i], 0, sizeof(pubkeys[i]));
+    }
+    ARG_CHECK(secp256k1_ecmult_gen_context_is_built(&ctx->ecmult_gen_ctx));
+    ARG_CHECK(seckeys != NULL || n == 0);
+    for (i = 0; i < n; i++) {
+        ARG_CHECK(seckeys[i] != NULL);
+    }
+
+    for (i = 0; i < n; i += batch) {
+        batch = n - i < EC_PUBKEY_CREATE_BATCH_SIZE ? n - i : EC_PUBKEY_CREATE_BATCH_SIZE;
+        for (j = 0; j < batch; j++) {
+            valid[j] = secp256k1_scalar_set_b32_seckey(&seckey_scalar, seckeys[i + j]);
+            secp256k1_scalar_cmov(&seckey_scalar, &secp256k1_scalar_one, !valid[j]);
+            secp256k1_ecmult_gen(&ctx->ecmult_gen_ctx, &pj[j], &seckey_scalar);
+        }
+        secp256k1_ge_set_all_gej(p, pj, batch);
+        for (j = 0; j < batch; j++) {
+            secp256k1_pubkey_save(&pubkeys[i + j], &p[j]);
+            secp256k1_memczero(&pubkeys[i + j], sizeof(pubkeys[i + j]), !valid[j]);
+            ret &= valid[j];
+        }
+    }
+
+    secp256k1_scalar_clear(&seckey_scalar);
+    return ret;
+}
+
+/* Number of consecutive public keys secp256k1_ec_pubkey_create_range adds to one
+ * base point, sharing one inversion. */
+#define EC_PUBKEY_CREATE_RANGE_BATCH_SIZE 64
+
+static void secp256k1_ec_pubkey_create_range_save(unsigned char *x32, const secp256k1_ge *p) {
+    secp256k1_fe x = p->x;
+    secp256k1_fe_normalize_var(&x);
+    secp256k1_fe_get_b32(x32, &x);
+}
+
+int secp256k1_ec_pubkey_create_range(const secp256k1_context* ctx, unsigned char *xs32, const unsigned char *seckey, size_t n) {
+    /* g[j] = (j+1)*G */
+    secp256k1_ge g[EC_PUBKEY_CREATE_RANGE_BATCH_SIZE];
+    secp256k1_gej gj[EC_PUBKEY_CREATE_RANGE_BATCH_SIZE];
+    secp256k1_ge pts[EC_PUBKEY_CREATE_RANGE_BATCH_SIZE];
+    secp256k1_fe den[EC_PUBKEY_CREATE_RANGE_BATCH_SIZE];
+    secp256k1_fe inv[EC_PUBKEY_CREATE_RANGE_BATCH_SIZE];
+    secp256k1_scalar k;
+    secp256k1_gej bj;
+    secp256k1_ge b;
+    size_t i, j, c, m;
+    int ret = 1;
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(xs32 != NULL || n == 0);
+    if (n > 0) {
+        memset(xs32, 0, 32 * n);
+    }
+    ARG_CHECK(secp256k1_ecmult_gen_context_is_built(&ctx->ecmult_gen_ctx));
+    ARG_CHECK(seckey != NULL);
+
+    if (!secp256k1_scalar_set_b32_seckey(&k, seckey)) {
+        return 0;
+    }
+    if (n == 0) {
+        return 1;
+    }
+    secp256k1_ecmult_gen(&ctx->ecmult_gen_ctx, &bj, &k);
+    secp256k1_scalar_clear(&k);
+    secp256k1_ge_set_gej(&b, &bj);
+
+    m = n < EC_PUBKEY_CREATE_RANGE_BATCH_SIZE ? n : EC_PUBKEY_CREATE_RANGE_BATCH_SIZE;
+    secp256k1_gej_set_ge(&gj[0], &secp256k1_ge_const_g);
+    for (j = 1; j < m; j++) {
+        secp256k1_gej_add_ge_var(&gj[j], &gj[j - 1], &secp256k1_ge_const_g, NULL);
+    }
+    secp256k1_ge_set_all_gej_var(g, gj, m);
+
+    for (i = 0; i < n; i += c) {
+        int special = b.infinity;
+        c = n - i < m ? n - i : m;
+
+        /* Compute b + (j+1)*G for j < c with affine additions: the key of the
+         * following c-1 outputs, and the base of the next chunk. */
+        for (j = 0; j < c && !special; j++) {
+            secp256k1_fe_negate(&den[j], &b.x, 1);
+            secp256k1_fe_add(&den[j], &g[j].x);
+            special = secp256k1_fe_normalizes_to_zero_var(&den[j]);
+        }
+        if (special) {
+            /* b is infinity or the negation of or equal to one of the g, so some
+             * addition would be a doubling or give infinity. This is only
+             * reached for a handful of seckeys, so don't bother making it fast. */
+            for (j = 0; j < c; j++) {
+                secp256k1_gej_set_ge(&gj[j], &b);
+                secp256k1_gej_add_ge_var(&gj[j], &gj[j], &g[j], NULL);
+            }
+            secp256k1_ge_set_all_gej_var(pts, gj, c);
+        } else {
+            secp256k1_fe_inv_all_var(inv, den, c);
+            for (j = 0; j < c; j++) {
+                secp256k1_fe lambda, t;
+                /* lambda = (y2 - y1) / (x2 - x1) */
+                secp256k1_fe_negate(&t, &b.y, 1);
+                secp256k1_fe_add(&t, &g[j].y);
+                secp256k1_fe_mul(&lambda, &t, &inv[j]);
+                /* x3 = lambda^2 - x1 - x2 */
+                secp256k1_fe_sqr(&pts[j].x, &lambda);
+                secp256k1_fe_negate(&t, &b.x, 1);
+                secp256k1_fe_add(&pts[j].x, &t);
+                secp256k1_fe_negate(&t, &g[j].x, 1);
+                secp256k1_fe_add(&pts[j].x, &t);
+                secp256k1_fe_normalize_weak(&pts[j].x);
+                /* y3 = lambda*(x1 - x3) - y1 */
+                secp256k1_fe_negate(&t, &pts[j].x, 1);
+                secp256k1_fe_add(&t, &b.x);
+                secp256k1_fe_mul(&pts[j].y, &lambda, &t);
+                secp256k1_fe_negate(&t, &b.y, 1);
+                secp256k1_fe_add(&pts[j].y, &t);
+                secp256k1_fe_normalize_weak(&pts[j].y);
+                pts[j].infinity = 0;
+            }
+        }
+
+        for (j = 0; j < c; j++) {
+            const secp256k1_ge *p = j == 0 ? &b : &pts[j - 1];
+            if (p->infinity) {
+                /* The key is zero modulo the group order */
+                ret = 0;
+            } else {
+                secp256k1_ec_pubkey_create_range_save(&xs32[32 * (i + j)], p);
+            }
+        }
+        b = pts[c - 1];
+    }
+
+    return ret;
+}
+
 int secp256k1_ec_seckey_negate(const secp256k1_context* ctx, unsigned char *seckey) {
     secp256k1_scalar sec;
     int ret = 0;
@@ -679,6 +1463,117 @@ int secp256k1_ec_pubkey_tweak_add(const secp256k1_context* ctx, secp256k1_pubkey
     return ret;
 }
 
+/* The number of public keys secp256k1_ec_pubkey_tweak_add_batch_helper tweaks at once */
+#define EC_PUBKEY_TWEAK_ADD_BATCH_SIZE 32
+
+/* Sets p[i] to p[i] + tweaks[i]*G for every i with valid[i], for n up to
+ * EC_PUBKEY_TWEAK_ADD_BATCH_SIZE. valid[i] is cleared if the tweak overflows or the
+ * result is infinity. The results are made affine together, with one inversion. */
+static void secp256k1_ec_pubkey_tweak_add_batch_helper(const secp256k1_ecmult_context* ecmult_ctx, secp256k1_ge *p, int *valid, const unsigned char * const *tweaks, size_t n) {
+    secp256k1_gej pj[EC_PUBKEY_TWEAK_ADD_BATCH_SIZE];
+    secp256k1_gej inf;
+    secp256k1_scalar term;
+    size_t i;
+    int overflow;
+
+    VERIFY_CHECK(n <= EC_PUBKEY_TWEAK_ADD_BATCH_SIZE);
+    secp256k1_gej_set_infinity(&inf);
+    for (i = 0; i < n; i++) {
+        secp256k1_gej_set_infinity(&pj[i]);
+        if (!valid[i]) {
+            continue;
+        }
+        secp256k1_scalar_set_b32(&term, tweaks[i], &overflow);
+        if (overflow) {
+            valid[i] = 0;
+            continue;
+        }
+        /* Only the generator is multiplied; the key is added to the result. */
+        secp256k1_ecmult(ecmult_ctx, &pj[i], &inf, &secp256k1_scalar_zero, &term);
+        secp256k1_gej_add_ge_var(&pj[i], &pj[i], &p[i], NULL);
+        valid[i] = !secp256k1_gej_is_infinity(&pj[i]);
+    }
+    secp256k1_ge_set_all_gej_var(p, pj, n);
+}
+
+int secp256k1_ec_pubkey_tweak_add_batch(const secp256k1_context* ctx, secp256k1_pubkey *pubkeys, const unsigned char * const *tweaks, size_t n) {
+    secp256k1_ge p[EC_PUBKEY_TWEAK_ADD_BATCH_SIZE];
+    int valid[EC_PUBKEY_TWEAK_ADD_BATCH_SIZE];
+    size_t i, j, batch;
+    int ret = 1;
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(pubkeys != NULL || n == 0);
+    ARG_CHECK(tweaks != NULL || n == 0);
+    for (i = 0; i < n; i++) {
+        ARG_CHECK(tweaks[i] != NULL);
+    }
+
+    for (i = 0; i < n; i += batch) {
+        batch = n - i < EC_PUBKEY_TWEAK_ADD_BATCH_SIZE ? n - i : EC_PUBKEY_TWEAK_ADD_BATCH_SIZE;
+        for (j = 0; j < batch; j++) {
+            valid[j] = secp256k1_pubkey_load(ctx, &p[j], &pubkeys[i + j]);
+        }
+        secp256k1_ec_pubkey_tweak_add_batch_helper(&ctx->ecmult_ctx, p, valid, &tweaks[i], batch);
+        for (j = 0; j < batch; j++) {
+            memset(&pubkeys[i + j], 0, sizeof(pubkeys[i + j]));
+            if (valid[j]) {
+                secp256k1_pubkey_save(&pubkeys[i + j], &p[j]);
+            }
+            ret &= valid[j];
+        }
+    }
+    return ret;
+}
+
+int secp256k1_ec_pubkey_derive_batch(const secp256k1_context* ctx, secp256k1_pubkey *children, const secp256k1_pubkey *parent, const unsigned char * const *tweaks, size_t n) {
+    secp256k1_gej pj[EC_PUBKEY_TWEAK_ADD_BATCH_SIZE];
+    secp256k1_ge p[EC_PUBKEY_TWEAK_ADD_BATCH_SIZE];
+    int valid[EC_PUBKEY_TWEAK_ADD_BATCH_SIZE];
+    secp256k1_ge q;
+    secp256k1_scalar term;
+    size_t i, j, batch;
+    int overflow;
+    int ret = 1;
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(children != NULL || n == 0);
+    for (i = 0; i < n; i++) {
+        memset(&children[i], 0, sizeof(children[i]));
+    }
+    ARG_CHECK(secp256k1_ecmult_gen_context_is_built(&ctx->ecmult_gen_ctx));
+    ARG_CHECK(parent != NULL);
+    ARG_CHECK(tweaks != NULL || n == 0);
+    for (i = 0; i < n; i++) {
+        ARG_CHECK(tweaks[i] != NULL);
+    }
+    if (!secp256k1_pubkey_load(ctx, &q, parent)) {
+        return 0;
+    }
+
+    for (i = 0; i < n; i += batch) {
+        batch = n - i < EC_PUBKEY_TWEAK_ADD_BATCH_SIZE ? n - i : EC_PUBKEY_TWEAK_ADD_BATCH_SIZE;
+        for (j = 0; j < batch; j++) {
+            secp256k1_scalar_set_b32(&term, tweaks[i + j], &overflow);
+            valid[j] = !overflow;
+            /* The tweaks may be secret (in BIP32 they are derived from the chain code), so
+             * the multiplication uses the constant-time generator tables. */
+            secp256k1_ecmult_gen(&ctx->ecmult_gen_ctx, &pj[j], &term);
+            secp256k1_gej_add_ge_var(&pj[j], &pj[j], &q, NULL);
+            valid[j] &= !secp256k1_gej_is_infinity(&pj[j]);
+        }
+        secp256k1_ge_set_all_gej_var(p, pj, batch);
+        for (j = 0; j < batch; j++) {
+            if (valid[j]) {
+                secp256k1_pubkey_save(&children[i + j], &p[j]);
+            }
+            ret &= valid[j];
+        }
+    }
+
+    secp256k1_scalar_clear(&term);
+    return ret;
+}
+
 int secp256k1_ec_seckey_tweak_mul(const secp256k1_context* ctx, unsigned char *seckey, const unsigned char *tweak) {
     secp256k1_scalar factor;
     secp256k1_scalar sec;
@@ -735,6 +1630,40 @@ int secp256k1_context_randomize(secp256k1_context* ctx, const unsigned char *see
     return 1;
 }
 
+int secp256k1_context_reblind(secp256k1_context* ctx) {
+    VERIFY_CHECK(ctx != NULL);
+    if (secp256k1_ecmult_gen_context_is_built(&ctx->ecmult_gen_ctx)) {
+        secp256k1_ecmult_gen_reblind(&ctx->ecmult_gen_ctx);
+    }
+    return 1;
+}
+
+int secp256k1_counters_snapshot(const secp256k1_context* ctx, size_t *counts, size_t n) {
+    size_t i;
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(counts != NULL);
+    for (i = 0; i < n; i++) {
+#ifdef ENABLE_COUNTERS
+        counts[i] = i < SECP256K1_COUNTER_COUNT ? secp256k1_counters()[i] : 0;
+#else
+        counts[i] = 0;
+#endif
+    }
+#ifdef ENABLE_COUNTERS
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+void secp256k1_counters_reset(const secp256k1_context* ctx) {
+    VERIFY_CHECK(ctx != NULL);
+    (void)ctx;
+#ifdef ENABLE_COUNTERS
+    memset(secp256k1_counters(), 0, SECP256K1_COUNTER_COUNT * sizeof(size_t));
+#endif
+}
+
 int secp256k1_ec_pubkey_combine(const secp256k1_context* ctx, secp256k1_pubkey *pubnonce, const secp256k1_pubkey * const *pubnonces, size_t n) {
     size_t i;
     secp256k1_gej Qj;
@@ -759,6 +1688,84 @@ int secp256k1_ec_pubkey_combine(const secp256k1_context* ctx, secp256k1_pubkey *
     return 1;
 }
 
+/* The number of sums secp256k1_ec_pubkey_combine_batch makes affine at once */
+#define EC_PUBKEY_COMBINE_BATCH_SIZE 32
+
+int secp256k1_ec_pubkey_combine_batch(const secp256k1_context* ctx, secp256k1_pubkey *outs, size_t n_outs, const secp256k1_pubkey * const *ins, const size_t *group_sizes, int vartime) {
+    secp256k1_gej sumj[EC_PUBKEY_COMBINE_BATCH_SIZE];
+    secp256k1_ge sum[EC_PUBKEY_COMBINE_BATCH_SIZE];
+    int valid[EC_PUBKEY_COMBINE_BATCH_SIZE];
+    secp256k1_ge Q;
+    size_t i, j, k, batch, nonempty, total = 0;
+    int ret = 1;
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(outs != NULL || n_outs == 0);
+    for (i = 0; i < n_outs; i++) {
+        memset(&outs[i], 0, sizeof(outs[i]));
+    }
+    ARG_CHECK(group_sizes != NULL || n_outs == 0);
+    for (i = 0; i < n_outs; i++) {
+        total += group_sizes[i];
+    }
+    ARG_CHECK(ins != NULL || total == 0);
+
+    for (i = 0; i < n_outs; i += batch) {
+        batch = n_outs - i < EC_PUBKEY_COMBINE_BATCH_SIZE ? n_outs - i : EC_PUBKEY_COMBINE_BATCH_SIZE;
+        nonempty = 0;
+        for (j = 0; j < batch; j++) {
+            secp256k1_gej_set_infinity(&sumj[nonempty]);
+            for (k = 0; k < group_sizes[i + j]; k++) {
+                secp256k1_pubkey_load(ctx, &Q, *ins++);
+                if (vartime) {
+                    secp256k1_gej_add_ge_var(&sumj[nonempty], &sumj[nonempty], &Q, NULL);
+                } else {
+                    secp256k1_gej_add_ge(&sumj[nonempty], &sumj[nonempty], &Q);
+                }
+            }
+            valid[j] = !secp256k1_gej_is_infinity(&sumj[nonempty]);
+            /* The constant-time normalization does not skip infinities, so they are
+             * left out of the batch. */
+            nonempty += valid[j];
+        }
+        if (vartime) {
+            secp256k1_ge_set_all_gej_var(sum, sumj, nonempty);
+        } else {
+            secp256k1_ge_set_all_gej(sum, sumj, nonempty);
+        }
+        for (j = 0, k = 0; j < batch; j++) {
+            if (valid[j]) {
+                secp256k1_pubkey_save(&outs[i + j], &sum[k++]);
+            }
+            ret &= valid[j];
+        }
+    }
+    return ret;
+}
+
+int secp256k1_tagged_hasher_init(const secp256k1_context* ctx, secp256k1_tagged_hasher *hasher, const unsigned char *tag, size_t taglen) {
+    secp256k1_sha256 sha;
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(hasher != NULL);
+    ARG_CHECK(tag != NULL || taglen == 0);
+
+    secp256k1_sha256_initialize_tagged(&sha, tag, taglen);
+    secp256k1_sha256_save_midstate(hasher->data, &sha);
+    return 1;
+}
+
+int secp256k1_tagged_hasher_hash(const secp256k1_context* ctx, unsigned char *hash32, const secp256k1_tagged_hasher *hasher, const unsigned char *msg, size_t msglen) {
+    secp256k1_sha256 sha;
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(hash32 != NULL);
+    ARG_CHECK(hasher != NULL);
+    ARG_CHECK(msg != NULL || msglen == 0);
+
+    secp256k1_sha256_load_midstate(&sha, hasher->data);
+    secp256k1_sha256_write(&sha, msg, msglen);
+    secp256k1_sha256_finalize(&sha, hash32);
+    return 1;
+}
+
 #ifdef ENABLE_MODULE_ECDH
 # include "modules/ecdh/main_impl.h"
 #endif
@@ -774,3 +1781,19 @@ int secp256k1_ec_pubkey_combine(const secp256k1_context* ctx, secp256k1_pubkey *
 #ifdef ENABLE_MODULE_SCHNORRSIG
 # include "modules/schnorrsig/main_impl.h"
 #endif
+
+#ifdef ENABLE_MODULE_ECMULT_MULTI
+# include "modules/ecmult_multi/main_impl.h"
+#endif
+
+#ifdef ENABLE_MODULE_BATCH
+# include "modules/batch/main_impl.h"
+#endif
+
+#ifdef ENABLE_MODULE_MUSIG
+# include "modules/musig/main_impl.h"
+#endif
+
+#ifdef ENABLE_MODULE_SCHNORRSIG_HALFAGG
+# include "modules/schnorrsig_halfagg/main_impl.h"
+#endif
@@ -0,0 +1,57 @@
+/**********************************************************************
+ * Distributed under the MIT software license, see the accompanying   *
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
+ **********************************************************************/
+
+#ifndef SECP256K1_SIGCACHE_H
+#define SECP256K1_SIGCACHE_H
+
+#include <stdint.h>
+
+#include "util.h"
+#include "hash.h"
+
+/* A cache of successful verifications. Each entry is a 128-bit fingerprint, taken from
+ * a salted SHA256 of the signature, message and public key, and may be stored in one of
+ * SIGCACHE_WAYS slots that are derived from the fingerprint itself (so that an entry
+ * evicted from one slot can be moved to another, as in cuckoo hashing). Without the
+ * salt, the slots and fingerprints cannot be predicted.
+ *
+ * Lookups and inserts use relaxed atomic loads and stores of the 64-bit halves of the
+ * entries, without locks. A lookup that races with inserts may see halves of two
+ * different entries; that can only cause a spurious hit if both halves match, which is
+ * as unlikely as guessing a fingerprint. An insert that races with another may drop an
+ * entry, which only costs a later verification. */
+
+/** The number of slots an entry may be stored in */
+#define SIGCACHE_WAYS 4
+/** The number of entries an insert moves before it gives up and evicts one */
+#define SIGCACHE_MAX_KICKS 16
+
+/* The public API exposes this as the opaque secp256k1_sigcache. */
+struct secp256k1_sigcache_struct {
+    /** SHA256 state after the salt */
+    secp256k1_sha256 hasher;
+    /** the entries; {0, 0} marks an empty slot */
+    uint64_t (*table)[2];
+    size_t size;
+    size_t hits;
+    size_t misses;
+    size_t evictions;
+    /** the allocator of the context the cache was created with */
+    secp256k1_allocator allocator;
+};
+
+/** Initializes hash with the salted state of cache, to hash what identifies a verification. */
+static void secp256k1_sigcache_hasher(const secp256k1_sigcache *cache, secp256k1_sha256 *hash);
+
+/** Finalizes hash into an entry. */
+static void secp256k1_sigcache_entry(uint64_t entry[2], secp256k1_sha256 *hash);
+
+/** Returns 1 if entry is in the cache, updating the hit or miss counter. */
+static int secp256k1_sigcache_lookup(secp256k1_sigcache *cache, const uint64_t entry[2]);
+
+/** Adds entry to the cache, evicting another one if all of its slots are taken. */
+static void secp256k1_sigcache_insert(secp256k1_sigcache *cache, const uint64_t entry[2]);
+
+#endif /* SECP256K1_SIGCACHE_H */
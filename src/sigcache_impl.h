@@ -0,0 +1,105 @@
+/**********************************************************************
+ * Distributed under the MIT software license, see the accompanying   *
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
+ **********************************************************************/
+
+#ifndef SECP256K1_SIGCACHE_IMPL_H
+#define SECP256K1_SIGCACHE_IMPL_H
+
+#include "sigcache.h"
+#include "hash_impl.h"
+
+static void secp256k1_sigcache_hasher(const secp256k1_sigcache *cache, secp256k1_sha256 *hash) {
+    *hash = cache->hasher;
+}
+
+static void secp256k1_sigcache_entry(uint64_t entry[2], secp256k1_sha256 *hash) {
+    unsigned char buf[32];
+    int i;
+
+    secp256k1_sha256_finalize(hash, buf);
+    entry[0] = entry[1] = 0;
+    for (i = 0; i < 8; i++) {
+        entry[0] = (entry[0] << 8) | buf[i];
+        entry[1] = (entry[1] << 8) | buf[8 + i];
+    }
+    /* Keep entries distinct from empty slots. */
+    entry[0] |= 1;
+}
+
+/* The slots of entry, one from each 32-bit quarter of the fingerprint. */
+static void secp256k1_sigcache_slots(const secp256k1_sigcache *cache, size_t slots[SIGCACHE_WAYS], const uint64_t entry[2]) {
+    int i;
+    for (i = 0; i < SIGCACHE_WAYS; i++) {
+        uint64_t w = (entry[i >> 1] >> (32 * (i & 1))) & 0xFFFFFFFF;
+        slots[i] = (size_t)((w * cache->size) >> 32);
+    }
+}
+
+static int secp256k1_sigcache_slot_is(const secp256k1_sigcache *cache, size_t slot, const uint64_t entry[2]) {
+    return ATOMIC_LOAD(&cache->table[slot][0]) == entry[0] && ATOMIC_LOAD(&cache->table[slot][1]) == entry[1];
+}
+
+static int secp256k1_sigcache_lookup(secp256k1_sigcache *cache, const uint64_t entry[2]) {
+    size_t slots[SIGCACHE_WAYS];
+    int i;
+
+    secp256k1_sigcache_slots(cache, slots, entry);
+    for (i = 0; i < SIGCACHE_WAYS; i++) {
+        if (secp256k1_sigcache_slot_is(cache, slots[i], entry)) {
+            ATOMIC_INC(&cache->hits);
+            return 1;
+        }
+    }
+    ATOMIC_INC(&cache->misses);
+    return 0;
+}
+
+static void secp256k1_sigcache_insert(secp256k1_sigcache *cache, const uint64_t entry[2]) {
+    static const uint64_t empty[2] = {0, 0};
+    size_t slots[SIGCACHE_WAYS];
+    size_t last = (size_t)-1;
+    uint64_t cur[2], next[2];
+    int i, kick;
+
+    cur[0] = entry[0];
+    cur[1] = entry[1];
+    for (kick = 0; kick < SIGCACHE_MAX_KICKS; kick++) {
+        size_t victim = (size_t)-1;
+        secp256k1_sigcache_slots(cache, slots, cur);
+        for (i = 0; i < SIGCACHE_WAYS; i++) {
+            if (secp256k1_sigcache_slot_is(cache, slots[i], cur)) {
+                return;
+            }
+        }
+        for (i = 0; i < SIGCACHE_WAYS; i++) {
+            if (secp256k1_sigcache_slot_is(cache, slots[i], empty)) {
+                ATOMIC_STORE(&cache->table[slots[i]][1], cur[1]);
+                ATOMIC_STORE(&cache->table[slots[i]][0], cur[0]);
+                return;
+            }
+        }
+        /* All slots are taken: move out the entry of one of them, other than the one
+         * the current entry was just moved out of, and find it a new slot. */
+        for (i = 0; i < SIGCACHE_WAYS; i++) {
+            size_t slot = slots[(kick + i) % SIGCACHE_WAYS];
+            if (slot != last) {
+                victim = slot;
+                break;
+            }
+        }
+        if (victim == (size_t)-1) {
+            break;
+        }
+        next[0] = ATOMIC_LOAD(&cache->table[victim][0]);
+        next[1] = ATOMIC_LOAD(&cache->table[victim][1]);
+        ATOMIC_STORE(&cache->table[victim][1], cur[1]);
+        ATOMIC_STORE(&cache->table[victim][0], cur[0]);
+        cur[0] = next[0];
+        cur[1] = next[1];
+        last = victim;
+    }
+    ATOMIC_INC(&cache->evictions);
+}
+
+#endif /* SECP256K1_SIGCACHE_IMPL_H */
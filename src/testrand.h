@@ -41,6 +41,12 @@ static void secp256k1_testrand_flip(unsigned char *b, size_t len);
 /** Initialize the test RNG using (hex encoded) array up to 16 bytes, or randomly if hexseed is NULL. */
 static void secp256k1_testrand_init(const char* hexseed);
 
+/** Reseed the generator from the seed given to secp256k1_testrand_init and
+ *  index, so that the numbers drawn after it do not depend on what ran before.
+ *  Used to give every test group (and so every shard) its own reproducible
+ *  stream. */
+static void secp256k1_testrand_reseed_index(uint32_t index);
+
 /** Print final test information. */
 static void secp256k1_testrand_finish(void);
 
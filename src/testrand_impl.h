@@ -19,6 +19,7 @@ static uint32_t secp256k1_test_rng_precomputed[8];
 static int secp256k1_test_rng_precomputed_used = 8;
 static uint64_t secp256k1_test_rng_integer;
 static int secp256k1_test_rng_integer_bits_left = 0;
+static unsigned char secp256k1_test_seed16[16];
 
 SECP256K1_INLINE static void secp256k1_testrand_seed(const unsigned char *seed16) {
     secp256k1_rfc6979_hmac_sha256_initialize(&secp256k1_test_rng, seed16, 16);
@@ -146,9 +147,29 @@ static void secp256k1_testrand_init(const char* hexseed) {
     }
 
     printf("random seed = %02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x\n", seed16[0], seed16[1], seed16[2], seed16[3], seed16[4], seed16[5], seed16[6], seed16[7], seed16[8], seed16[9], seed16[10], seed16[11], seed16[12], seed16[13], seed16[14], seed16[15]);
+    memcpy(secp256k1_test_seed16, seed16, 16);
     secp256k1_testrand_seed(seed16);
 }
 
+static void secp256k1_testrand_reseed_index(uint32_t index) {
+    secp256k1_sha256 sha;
+    unsigned char buf[4];
+    unsigned char out32[32];
+
+    buf[0] = index >> 24;
+    buf[1] = index >> 16;
+    buf[2] = index >> 8;
+    buf[3] = index;
+    secp256k1_sha256_initialize(&sha);
+    secp256k1_sha256_write(&sha, secp256k1_test_seed16, 16);
+    secp256k1_sha256_write(&sha, buf, 4);
+    secp256k1_sha256_finalize(&sha, out32);
+    secp256k1_testrand_seed(out32);
+    secp256k1_test_rng_precomputed_used = 8;
+    secp256k1_test_rng_integer = 0;
+    secp256k1_test_rng_integer_bits_left = 0;
+}
+
 static void secp256k1_testrand_finish(void) {
     unsigned char run32[32];
     secp256k1_testrand256(run32);
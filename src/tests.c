@@ -18,6 +18,7 @@
 #include "include/secp256k1.h"
 #include "include/secp256k1_preallocated.h"
 #include "testrand_impl.h"
+#include "testshard_impl.h"
 
 #ifdef ENABLE_OPENSSL_TESTS
 #include "openssl/bn.h"
@@ -61,9 +62,10 @@ void random_field_element_test(secp256k1_fe *fe) {
     } while(1);
 }
 
-void random_field_element_magnitude(secp256k1_fe *fe) {
+/* Give fe a random magnitude of at most m, without changing its value. */
+void random_field_element_magnitude_max(secp256k1_fe *fe, int m) {
     secp256k1_fe zero;
-    int n = secp256k1_testrand_int(9);
+    int n = secp256k1_testrand_int(m + 1);
     secp256k1_fe_normalize(fe);
     if (n == 0) {
         return;
@@ -77,6 +79,10 @@ void random_field_element_magnitude(secp256k1_fe *fe) {
 #endif
 }
 
+void random_field_element_magnitude(secp256k1_fe *fe) {
+    random_field_element_magnitude_max(fe, 8);
+}
+
 void random_group_element_test(secp256k1_ge *ge) {
     secp256k1_fe fe;
     do {
@@ -333,6 +339,267 @@ void run_context_tests(int use_prealloc) {
 
 }
 
+void run_verify_table_tests(void) {
+    size_t const table_len = secp256k1_context_verify_table_size();
+    unsigned char *table = (unsigned char *)malloc(table_len);
+    unsigned char *copy = (unsigned char *)malloc(table_len);
+    unsigned char msg[32], key[32];
+    secp256k1_ecdsa_signature sig;
+    secp256k1_pubkey pubkey;
+    secp256k1_context *vrfy;
+    secp256k1_context *loaded;
+    secp256k1_context *cloned;
+    int32_t ecount = 0;
+
+    CHECK(table != NULL);
+    CHECK(copy != NULL);
+#ifdef USE_ECMULT_STATIC_VERIFY_TABLE
+    CHECK(secp256k1_context_preallocated_size(SECP256K1_CONTEXT_VERIFY) == secp256k1_context_preallocated_size(SECP256K1_CONTEXT_NONE));
+#endif
+    vrfy = secp256k1_context_create(SECP256K1_CONTEXT_VERIFY);
+    loaded = secp256k1_context_create(SECP256K1_CONTEXT_SIGN);
+    secp256k1_context_set_illegal_callback(loaded, counting_illegal_callback_fn, &ecount);
+
+    /* Serialization requires a context initialized for verification. */
+    CHECK(secp256k1_context_verify_table_serialize(loaded, table, table_len) == 0);
+    CHECK(ecount == 1);
+    secp256k1_context_set_illegal_callback(vrfy, counting_illegal_callback_fn, &ecount);
+    CHECK(secp256k1_context_verify_table_serialize(vrfy, table, table_len - 1) == 0);
+    CHECK(ecount == 2);
+    CHECK(secp256k1_context_verify_table_serialize(vrfy, table, table_len) == 1);
+    /* A context which already has tables cannot load others. */
+    CHECK(secp256k1_context_verify_table_load(vrfy, table, table_len) == 0);
+    CHECK(ecount == 3);
+    secp256k1_context_destroy(vrfy);
+
+    /* Truncated, corrupted or foreign tables are rejected. */
+    memcpy(copy, table, table_len);
+    CHECK(secp256k1_context_verify_table_load(loaded, copy, table_len - 1) == 0);
+    copy[secp256k1_testrand_int(table_len)] ^= 1 << secp256k1_testrand_int(8);
+    CHECK(secp256k1_context_verify_table_load(loaded, copy, table_len) == 0);
+    CHECK(ecount == 3);
+    CHECK(!secp256k1_ecmult_context_is_built(&loaded->ecmult_ctx));
+
+    CHECK(secp256k1_context_verify_table_load(loaded, table, table_len) == 1);
+    CHECK(secp256k1_ecmult_context_is_built(&loaded->ecmult_ctx));
+    CHECK(secp256k1_context_verify_table_load(loaded, table, table_len) == 0);
+    CHECK(ecount == 4);
+
+    /* The tables are not copied when cloning. */
+    CHECK(secp256k1_context_preallocated_clone_size(loaded) == secp256k1_context_preallocated_size(SECP256K1_CONTEXT_SIGN));
+    cloned = secp256k1_context_clone(loaded);
+    secp256k1_context_destroy(loaded);
+    CHECK(secp256k1_context_verify_table_serialize(cloned, copy, table_len) == 1);
+    CHECK(secp256k1_memcmp_var(copy, table, table_len) == 0);
+
+    /* Building the tables in parts, in any order, gives the same serialization. */
+    {
+        size_t n_parts = 1 + secp256k1_testrand_int(9);
+        size_t part;
+        memset(copy, 0, table_len);
+        for (part = n_parts; part > 0; part--) {
+            CHECK(secp256k1_context_verify_table_build(cloned, copy, table_len, part - 1, n_parts) == 1);
+        }
+        CHECK(secp256k1_context_verify_table_finish(cloned, copy, table_len) == 1);
+        CHECK(secp256k1_memcmp_var(copy, table, table_len) == 0);
+        secp256k1_context_set_illegal_callback(cloned, counting_illegal_callback_fn, &ecount);
+        CHECK(secp256k1_context_verify_table_build(cloned, copy, table_len, n_parts, n_parts) == 0);
+        CHECK(ecount == 5);
+        CHECK(secp256k1_context_verify_table_build(cloned, copy, table_len - 1, 0, n_parts) == 0);
+        CHECK(ecount == 6);
+        CHECK(secp256k1_context_verify_table_finish(cloned, copy, table_len - 1) == 0);
+        CHECK(ecount == 7);
+        secp256k1_context_set_illegal_callback(cloned, NULL, NULL);
+    }
+
+    secp256k1_testrand256(msg);
+    random_scalar_order_b32(key);
+    CHECK(secp256k1_ec_pubkey_create(cloned, &pubkey, key) == 1);
+    CHECK(secp256k1_ecdsa_sign(cloned, &sig, msg, key, NULL, NULL) == 1);
+    CHECK(secp256k1_ecdsa_verify(cloned, &sig, msg, &pubkey) == 1);
+    msg[0] ^= 1;
+    CHECK(secp256k1_ecdsa_verify(cloned, &sig, msg, &pubkey) == 0);
+
+    secp256k1_context_destroy(cloned);
+    free(copy);
+    free(table);
+}
+
+typedef struct {
+    size_t n_alloc;
+    size_t n_free;
+    int fail;
+} counting_allocator_data;
+
+static void* counting_alloc_fn(size_t size, void* data) {
+    counting_allocator_data *d = (counting_allocator_data*)data;
+    if (d->fail) {
+        return NULL;
+    }
+    d->n_alloc++;
+    return malloc(size);
+}
+
+static void counting_free_fn(void* ptr, void* data) {
+    counting_allocator_data *d = (counting_allocator_data*)data;
+    d->n_free++;
+    free(ptr);
+}
+
+void run_allocator_tests(void) {
+    int32_t ecount = 0;
+    counting_allocator_data d = { 0, 0, 0 };
+    secp256k1_context *none = secp256k1_context_create(SECP256K1_CONTEXT_NONE);
+    secp256k1_context *cloned;
+    secp256k1_scratch_space *scratch;
+
+    secp256k1_context_set_illegal_callback(none, counting_illegal_callback_fn, &ecount);
+    secp256k1_context_set_error_callback(none, counting_illegal_callback_fn, &ecount);
+    secp256k1_context_set_allocator(none, counting_alloc_fn, counting_free_fn, &d);
+
+    scratch = secp256k1_scratch_space_create(none, 1000);
+    CHECK(scratch != NULL);
+    CHECK(secp256k1_scratch_alloc(&none->error_callback, scratch, 500) != NULL);
+    cloned = secp256k1_context_clone(none);
+    CHECK(d.n_alloc == 2 && d.n_free == 0);
+
+    /* Objects are released with the allocator they were allocated with. */
+    secp256k1_context_set_allocator(none, NULL, NULL, NULL);
+    secp256k1_scratch_apply_checkpoint(&none->error_callback, scratch, 0);
+    secp256k1_scratch_space_destroy(none, scratch);
+    CHECK(d.n_free == 1);
+    scratch = secp256k1_scratch_space_create(none, 1000);
+    secp256k1_scratch_space_destroy(none, scratch);
+    CHECK(d.n_alloc == 2 && d.n_free == 1);
+
+    /* The clone uses (and is released with) the allocator it was cloned with. */
+    scratch = secp256k1_scratch_space_create(cloned, 1000);
+    secp256k1_context_set_allocator(cloned, NULL, NULL, NULL);
+    secp256k1_scratch_space_destroy(cloned, scratch);
+    secp256k1_context_destroy(cloned);
+    CHECK(d.n_alloc == 3 && d.n_free == 3);
+
+    /* A failing allocator triggers the error callback. */
+    d.fail = 1;
+    secp256k1_context_set_allocator(none, counting_alloc_fn, counting_free_fn, &d);
+    CHECK(secp256k1_scratch_space_create(none, 1000) == NULL);
+    CHECK(ecount == 1);
+
+    /* Setting only one of the functions is illegal, and restores the default. */
+    secp256k1_context_set_allocator(none, counting_alloc_fn, NULL, &d);
+    CHECK(ecount == 2);
+    scratch = secp256k1_scratch_space_create(none, 1000);
+    CHECK(scratch != NULL);
+    secp256k1_scratch_space_destroy(none, scratch);
+    CHECK(ecount == 2);
+    CHECK(d.n_alloc == 3 && d.n_free == 3);
+
+    secp256k1_context_destroy(none);
+}
+
+void run_context_clone_shared_tests(void) {
+    secp256k1_context *base = secp256k1_context_create(SECP256K1_CONTEXT_SIGN | SECP256K1_CONTEXT_VERIFY);
+    secp256k1_context *shared, *shared_prealloc, *copy;
+    void *prealloc;
+    unsigned char seckey[32], msg[32], seed[32];
+    secp256k1_ecdsa_signature sig, sig2;
+    secp256k1_pubkey pubkey;
+    secp256k1_scalar sc;
+
+    /* A shared copy only needs the context itself. */
+    CHECK(secp256k1_context_preallocated_clone_shared_size(base) == secp256k1_context_preallocated_size(SECP256K1_CONTEXT_NONE));
+#if !defined(USE_ECMULT_STATIC_PRECOMPUTATION) || !defined(USE_ECMULT_STATIC_VERIFY_TABLE)
+    /* Unless both tables are static, base owns a table that a full copy duplicates. */
+    CHECK(secp256k1_context_preallocated_clone_shared_size(base) < secp256k1_context_preallocated_clone_size(base));
+#endif
+    shared = secp256k1_context_clone_shared(base);
+    prealloc = malloc(secp256k1_context_preallocated_clone_shared_size(base));
+    CHECK(prealloc != NULL);
+    shared_prealloc = secp256k1_context_preallocated_clone_shared(base, prealloc);
+    CHECK(shared->ecmult_ctx.pre_g == base->ecmult_ctx.pre_g);
+    CHECK(shared->ecmult_gen_ctx.prec == base->ecmult_gen_ctx.prec);
+    /* Copying a shared copy does not copy the tables either. */
+    CHECK(secp256k1_context_preallocated_clone_size(shared) == secp256k1_context_preallocated_size(SECP256K1_CONTEXT_NONE));
+    copy = secp256k1_context_clone(shared);
+    CHECK(copy->ecmult_ctx.pre_g == base->ecmult_ctx.pre_g);
+    CHECK(copy->ecmult_gen_ctx.prec == base->ecmult_gen_ctx.prec);
+
+    /* Every copy has its own blinding, and they all sign and verify alike. */
+    random_scalar_order_test(&sc);
+    secp256k1_scalar_get_b32(seckey, &sc);
+    secp256k1_testrand256(msg);
+    secp256k1_testrand256(seed);
+    CHECK(secp256k1_context_randomize(shared, seed) == 1);
+    CHECK(secp256k1_memcmp_var(&shared->ecmult_gen_ctx.blind, &base->ecmult_gen_ctx.blind, sizeof(secp256k1_scalar)) != 0);
+    CHECK(secp256k1_context_randomize(shared_prealloc, NULL) == 1);
+    CHECK(secp256k1_ec_pubkey_create(base, &pubkey, seckey) == 1);
+    CHECK(secp256k1_ecdsa_sign(base, &sig, msg, seckey, NULL, NULL) == 1);
+    CHECK(secp256k1_ecdsa_sign(shared, &sig2, msg, seckey, NULL, NULL) == 1);
+    CHECK(secp256k1_memcmp_var(&sig, &sig2, sizeof(sig)) == 0);
+    CHECK(secp256k1_ecdsa_sign(shared_prealloc, &sig2, msg, seckey, NULL, NULL) == 1);
+    CHECK(secp256k1_memcmp_var(&sig, &sig2, sizeof(sig)) == 0);
+    CHECK(secp256k1_ecdsa_sign(copy, &sig2, msg, seckey, NULL, NULL) == 1);
+    CHECK(secp256k1_memcmp_var(&sig, &sig2, sizeof(sig)) == 0);
+    CHECK(secp256k1_ecdsa_verify(shared, &sig, msg, &pubkey) == 1);
+    CHECK(secp256k1_ecdsa_verify(copy, &sig, msg, &pubkey) == 1);
+
+    secp256k1_context_destroy(copy);
+    secp256k1_context_preallocated_destroy(shared_prealloc);
+    free(prealloc);
+    secp256k1_context_destroy(shared);
+    secp256k1_context_destroy(base);
+}
+
+static int context_tables_cache_aligned(const secp256k1_context *c) {
+    int ret = 1;
+#ifndef USE_ECMULT_STATIC_PRECOMPUTATION
+    ret &= ((uintptr_t)c->ecmult_gen_ctx.prec % CACHE_LINE_SIZE) == 0;
+#endif
+    if (!c->ecmult_ctx.external) {
+        ret &= ((uintptr_t)c->ecmult_ctx.pre_g % CACHE_LINE_SIZE) == 0;
+#ifndef USE_ECMULT_COMPACT_VERIFY_TABLE
+        ret &= ((uintptr_t)c->ecmult_ctx.pre_g_128 % CACHE_LINE_SIZE) == 0;
+#endif
+    }
+    return ret;
+}
+
+void run_context_table_alignment_tests(void) {
+    /* The tables are cache-line aligned wherever the preallocated block starts, also
+     * after cloning into a block with a different offset. */
+    const unsigned int flags = SECP256K1_CONTEXT_SIGN | SECP256K1_CONTEXT_VERIFY;
+    const size_t size = secp256k1_context_preallocated_size(flags);
+    unsigned char *block1 = malloc(size + CACHE_LINE_SIZE);
+    unsigned char *block2 = malloc(size + CACHE_LINE_SIZE);
+    unsigned char seckey[32], msg[32];
+    secp256k1_ecdsa_signature sig, sig2;
+    secp256k1_pubkey pubkey;
+    secp256k1_scalar sc;
+    size_t off;
+
+    CHECK(block1 != NULL && block2 != NULL);
+    random_scalar_order_test(&sc);
+    secp256k1_scalar_get_b32(seckey, &sc);
+    secp256k1_testrand256(msg);
+    for (off = 0; off < CACHE_LINE_SIZE; off += ALIGNMENT) {
+        secp256k1_context *c1 = secp256k1_context_preallocated_create(block1 + off, flags);
+        secp256k1_context *c2;
+        CHECK(c1 != NULL);
+        CHECK(context_tables_cache_aligned(c1));
+        CHECK(secp256k1_ecdsa_sign(c1, &sig, msg, seckey, NULL, NULL) == 1);
+        CHECK(secp256k1_ec_pubkey_create(c1, &pubkey, seckey) == 1);
+        c2 = secp256k1_context_preallocated_clone(c1, block2 + (CACHE_LINE_SIZE - ALIGNMENT - off));
+        CHECK(context_tables_cache_aligned(c2));
+        secp256k1_context_preallocated_destroy(c1);
+        CHECK(secp256k1_ecdsa_sign(c2, &sig2, msg, seckey, NULL, NULL) == 1);
+        CHECK(secp256k1_memcmp_var(&sig, &sig2, sizeof(sig)) == 0);
+        CHECK(secp256k1_ecdsa_verify(c2, &sig, msg, &pubkey) == 1);
+        secp256k1_context_preallocated_destroy(c2);
+    }
+    free(block1);
+    free(block2);
+}
+
 void run_scratch_tests(void) {
     const size_t adj_alloc = ((500 + ALIGNMENT - 1) / ALIGNMENT) * ALIGNMENT;
 
@@ -411,6 +678,39 @@ void run_scratch_tests(void) {
     CHECK(secp256k1_scratch_alloc(&none->error_callback, scratch, SIZE_MAX) == NULL);
     secp256k1_scratch_space_destroy(none, scratch);
 
+    /* Growable scratch spaces grow in chunks up to their limit, only when idle */
+    CHECK(secp256k1_scratch_space_create_growable(none, 0) == NULL);
+    CHECK(ecount == 6);
+    scratch = secp256k1_scratch_space_create_growable(none, 3 * SCRATCH_GROW_CHUNK);
+    CHECK(scratch != NULL);
+    CHECK(secp256k1_scratch_max_allocation(&none->error_callback, scratch, 0) == 0);
+    CHECK(secp256k1_scratch_space_high_water(none, scratch) == 0);
+    CHECK(secp256k1_scratch_grow(&none->error_callback, scratch, 1000) == 1);
+    CHECK(secp256k1_scratch_max_allocation(&none->error_callback, scratch, 0) == SCRATCH_GROW_CHUNK);
+    CHECK(secp256k1_scratch_space_high_water(none, scratch) == 1000);
+    CHECK(secp256k1_scratch_alloc(&none->error_callback, scratch, 2000) != NULL);
+    CHECK(secp256k1_scratch_space_high_water(none, scratch) == ROUND_TO_ALIGN(2000));
+    CHECK(secp256k1_scratch_grow(&none->error_callback, scratch, SCRATCH_GROW_CHUNK + 1) == 0);
+    CHECK(secp256k1_scratch_space_high_water(none, scratch) == SCRATCH_GROW_CHUNK + 1);
+    secp256k1_scratch_apply_checkpoint(&none->error_callback, scratch, 0);
+    CHECK(secp256k1_scratch_grow(&none->error_callback, scratch, SCRATCH_GROW_CHUNK + 1) == 1);
+    CHECK(secp256k1_scratch_max_allocation(&none->error_callback, scratch, 0) == 2 * SCRATCH_GROW_CHUNK);
+    CHECK(secp256k1_scratch_grow(&none->error_callback, scratch, 100 * SCRATCH_GROW_CHUNK) == 0);
+    CHECK(secp256k1_scratch_max_allocation(&none->error_callback, scratch, 0) == 3 * SCRATCH_GROW_CHUNK);
+    CHECK(secp256k1_scratch_space_high_water(none, scratch) == 100 * SCRATCH_GROW_CHUNK);
+    CHECK(secp256k1_scratch_alloc(&none->error_callback, scratch, 3 * SCRATCH_GROW_CHUNK) != NULL);
+    secp256k1_scratch_apply_checkpoint(&none->error_callback, scratch, 0);
+    secp256k1_scratch_space_destroy(none, scratch);
+
+    /* Fixed scratch spaces only record what was asked for */
+    scratch = secp256k1_scratch_space_create(none, 1000);
+    CHECK(secp256k1_scratch_grow(&none->error_callback, scratch, 500) == 1);
+    CHECK(secp256k1_scratch_grow(&none->error_callback, scratch, 2000) == 0);
+    CHECK(secp256k1_scratch_max_allocation(&none->error_callback, scratch, 0) == 1000);
+    CHECK(secp256k1_scratch_space_high_water(none, scratch) == 2000);
+    secp256k1_scratch_space_destroy(none, scratch);
+    CHECK(ecount == 6);
+
     /* cleanup */
     secp256k1_scratch_space_destroy(none, NULL); /* no-op */
     secp256k1_context_destroy(none);
@@ -454,6 +754,94 @@ void run_sha256_tests(void) {
     }
 }
 
+void run_sha256_transform_tests(void) {
+    /* SHA256 of 1000000 times 'a' */
+    static const unsigned char million_a[32] = {
+        0xcd, 0xc7, 0x6e, 0x5c, 0x99, 0x14, 0xfb, 0x92, 0x81, 0xa1, 0xc7, 0xe2, 0x84, 0xd7, 0x3e, 0x67,
+        0xf1, 0x80, 0x9a, 0x48, 0xa4, 0x97, 0x20, 0x0e, 0x04, 0x6d, 0x39, 0xcc, 0xc7, 0x11, 0x2c, 0xd0
+    };
+    unsigned char data[1 + 5 * 64];
+    unsigned char out1[32], out2[32];
+    secp256k1_sha256 hasher;
+    int i, j;
+
+    /* Write in pieces that are not a multiple of the block size, so both the buffered and the
+     * multi-block paths of secp256k1_sha256_write are used. */
+    memset(data, 'a', sizeof(data));
+    secp256k1_sha256_initialize(&hasher);
+    for (i = 0; i < 1000000 / 250; i++) {
+        secp256k1_sha256_write(&hasher, data, 250);
+    }
+    secp256k1_sha256_finalize(&hasher, out1);
+    CHECK(secp256k1_memcmp_var(out1, million_a, 32) == 0);
+
+    for (i = 0; i < count; i++) {
+        uint32_t state1[8], state2[8];
+        uint32_t chunk[16];
+        size_t blocks = 1 + secp256k1_testrand_int(5);
+        /* An unaligned start, to test the loads of the hardware implementations. */
+        const unsigned char *p = data + 1;
+        secp256k1_testrand_bytes_test(data, sizeof(data));
+        secp256k1_testrand_bytes_test((unsigned char*)state1, sizeof(state1));
+        memcpy(state2, state1, sizeof(state2));
+
+        /* The dispatched multi-block transform matches the portable one. */
+        secp256k1_sha256_transform_blocks(state1, p, blocks);
+        for (j = 0; j < (int)blocks; j++) {
+            memcpy(chunk, p + 64 * j, 64);
+            secp256k1_sha256_transform(state2, chunk);
+        }
+        CHECK(memcmp(state1, state2, sizeof(state1)) == 0);
+
+        /* Hashing everything at once matches hashing byte by byte. */
+        secp256k1_sha256_initialize(&hasher);
+        secp256k1_sha256_write(&hasher, p, sizeof(data) - 1);
+        secp256k1_sha256_finalize(&hasher, out1);
+        secp256k1_sha256_initialize(&hasher);
+        for (j = 0; j < (int)sizeof(data) - 1; j++) {
+            secp256k1_sha256_write(&hasher, p + j, 1);
+        }
+        secp256k1_sha256_finalize(&hasher, out2);
+        CHECK(secp256k1_memcmp_var(out1, out2, 32) == 0);
+    }
+}
+
+void run_tagged_hasher_tests(void) {
+    static const unsigned char tag[17] = "some custom tag!!";
+    secp256k1_tagged_hasher hasher;
+    secp256k1_sha256 sha;
+    unsigned char msg[100];
+    unsigned char out1[32], out2[32];
+    size_t msglen;
+    int32_t ecount = 0;
+
+    secp256k1_context_set_illegal_callback(ctx, counting_illegal_callback_fn, &ecount);
+    CHECK(secp256k1_tagged_hasher_init(ctx, NULL, tag, sizeof(tag)) == 0);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_tagged_hasher_init(ctx, &hasher, NULL, 1) == 0);
+    CHECK(ecount == 2);
+    CHECK(secp256k1_tagged_hasher_init(ctx, &hasher, NULL, 0) == 1);
+    CHECK(secp256k1_tagged_hasher_init(ctx, &hasher, tag, sizeof(tag)) == 1);
+    CHECK(secp256k1_tagged_hasher_hash(ctx, NULL, &hasher, msg, sizeof(msg)) == 0);
+    CHECK(ecount == 3);
+    CHECK(secp256k1_tagged_hasher_hash(ctx, out1, NULL, msg, sizeof(msg)) == 0);
+    CHECK(ecount == 4);
+    CHECK(secp256k1_tagged_hasher_hash(ctx, out1, &hasher, NULL, sizeof(msg)) == 0);
+    CHECK(ecount == 5);
+    CHECK(secp256k1_tagged_hasher_hash(ctx, out1, &hasher, NULL, 0) == 1);
+    secp256k1_context_set_illegal_callback(ctx, NULL, NULL);
+
+    /* A hasher gives the same results as secp256k1_sha256_initialize_tagged, and can be reused. */
+    secp256k1_testrand_bytes_test(msg, sizeof(msg));
+    for (msglen = 0; msglen <= sizeof(msg); msglen += 1 + secp256k1_testrand_int(20)) {
+        secp256k1_sha256_initialize_tagged(&sha, tag, sizeof(tag));
+        secp256k1_sha256_write(&sha, msg, msglen);
+        secp256k1_sha256_finalize(&sha, out1);
+        CHECK(secp256k1_tagged_hasher_hash(ctx, out2, &hasher, msg, msglen) == 1);
+        CHECK(secp256k1_memcmp_var(out1, out2, 32) == 0);
+    }
+}
+
 void run_hmac_sha256_tests(void) {
     static const char *keys[6] = {
         "\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b",
@@ -611,6 +999,27 @@ void run_rand_int(void) {
     }
 }
 
+/***** UTIL TESTS *****/
+
+void run_ctz_tests(void) {
+    static const uint32_t b32[] = {1, 0xffffffff, 0x5e56968f, 0xe0d63129};
+    static const uint64_t b64[] = {1, 0xffffffffffffffff, 0xbcd02462139b3fc3, 0x98b5f80c769693ef};
+    int shift;
+    unsigned i;
+    for (i = 0; i < sizeof(b32) / sizeof(b32[0]); ++i) {
+        for (shift = 0; shift < 32; ++shift) {
+            CHECK(secp256k1_ctz32_var_debruijn(b32[i] << shift) == shift);
+            CHECK(secp256k1_ctz32_var(b32[i] << shift) == shift);
+        }
+    }
+    for (i = 0; i < sizeof(b64) / sizeof(b64[0]); ++i) {
+        for (shift = 0; shift < 64; ++shift) {
+            CHECK(secp256k1_ctz64_var_debruijn(b64[i] << shift) == shift);
+            CHECK(secp256k1_ctz64_var(b64[i] << shift) == shift);
+        }
+    }
+}
+
 /***** NUM TESTS *****/
 
 #ifndef USE_NUM_NONE
@@ -1761,6 +2170,28 @@ void run_scalar_tests(void) {
             CHECK(secp256k1_scalar_eq(&r2, &zz));
         }
     }
+
+#if defined(USE_ASM_X86_64_ADX) && defined(SECP256K1_WIDEMUL_INT128)
+    if (secp256k1_scalar_x86_64_adx_available()) {
+        /* The MULX/ADX product agrees with the generic assembly one. */
+        for (i = 0; i < 16 * count; i++) {
+            secp256k1_scalar a, b;
+            uint64_t l1[8], l2[8];
+            if (i < 4) {
+                memset(&a, (i & 1) ? 0xFF : 0, sizeof(a));
+                memset(&b, (i & 2) ? 0xFF : 0, sizeof(b));
+            } else {
+                random_scalar_order_test(&a);
+                random_scalar_order_test(&b);
+            }
+            secp256k1_scalar_mul_512(l1, &a, &b);
+            secp256k1_cpu_x86_disable(SECP256K1_CPU_X86_ADX);
+            secp256k1_scalar_mul_512(l2, &a, &b);
+            secp256k1_cpu_x86_disable(0);
+            CHECK(memcmp(l1, l2, sizeof(l1)) == 0);
+        }
+    }
+#endif
 }
 
 /***** FIELD TESTS *****/
@@ -1937,6 +2368,23 @@ void run_field_misc(void) {
         secp256k1_fe_add(&q, &x);
         CHECK(check_fe_equal(&y, &z));
         CHECK(check_fe_equal(&q, &y));
+        /* Check that half and mul_int agree, for various magnitudes. */
+        random_fe_non_zero(&y);
+        random_field_element_magnitude(&y);
+        z = y;
+        secp256k1_fe_half(&z);
+        secp256k1_fe_mul_int(&z, 2);
+        CHECK(check_fe_equal(&y, &z));
+        secp256k1_fe_negate(&z, &y, 8);
+        secp256k1_fe_mul_int(&z, 3);
+        secp256k1_fe_half(&z);
+        secp256k1_fe_half(&z);
+        secp256k1_fe_mul_int(&z, 4);
+        secp256k1_fe_normalize_weak(&z);
+        secp256k1_fe_add(&z, &y);
+        secp256k1_fe_add(&z, &y);
+        secp256k1_fe_add(&z, &y);
+        CHECK(secp256k1_fe_normalizes_to_zero_var(&z));
     }
 }
 
@@ -1969,6 +2417,7 @@ void run_field_inv_all_var(void) {
     int i;
     /* Check it's safe to call for 0 elements */
     secp256k1_fe_inv_all_var(xi, x, 0);
+    secp256k1_fe_inv_all(xi, x, 0);
     for (i = 0; i < count; i++) {
         size_t j;
         size_t len = secp256k1_testrand_int(15) + 1;
@@ -1983,6 +2432,266 @@ void run_field_inv_all_var(void) {
         for (j = 0; j < len; j++) {
             CHECK(check_fe_equal(&x[j], &xii[j]));
         }
+        /* The constant-time version gives the same results */
+        secp256k1_fe_inv_all(xii, x, len);
+        for (j = 0; j < len; j++) {
+            CHECK(check_fe_equal(&xi[j], &xii[j]));
+        }
+        /* With a zero input, all outputs are zero */
+        secp256k1_fe_clear(&x[secp256k1_testrand_int(len)]);
+        secp256k1_fe_inv_all(xi, x, len);
+        for (j = 0; j < len; j++) {
+            CHECK(secp256k1_fe_normalizes_to_zero(&xi[j]));
+        }
+    }
+}
+
+void run_scalar_inverse_all(void) {
+    secp256k1_scalar x[16], xi[16], xii[16];
+    int i;
+    /* Check it's safe to call for 0 elements */
+    secp256k1_scalar_inverse_all_var(xi, x, 0);
+    secp256k1_scalar_inverse_all(xi, x, 0);
+    for (i = 0; i < count; i++) {
+        size_t j;
+        size_t len = secp256k1_testrand_int(15) + 1;
+        for (j = 0; j < len; j++) {
+            do {
+                random_scalar_order_test(&x[j]);
+            } while (secp256k1_scalar_is_zero(&x[j]));
+        }
+        secp256k1_scalar_inverse_all_var(xi, x, len);
+        for (j = 0; j < len; j++) {
+            secp256k1_scalar_inverse_var(&xii[j], &x[j]);
+            CHECK(secp256k1_scalar_eq(&xi[j], &xii[j]));
+        }
+        /* The constant-time version gives the same results */
+        secp256k1_scalar_inverse_all(xii, x, len);
+        for (j = 0; j < len; j++) {
+            CHECK(secp256k1_scalar_eq(&xi[j], &xii[j]));
+        }
+        /* With a zero input, all outputs are zero */
+        secp256k1_scalar_clear(&x[secp256k1_testrand_int(len)]);
+        secp256k1_scalar_inverse_all(xi, x, len);
+        for (j = 0; j < len; j++) {
+            CHECK(secp256k1_scalar_is_zero(&xi[j]));
+        }
+    }
+}
+
+void test_inverse_scalar(secp256k1_scalar* out, const secp256k1_scalar* x, int var) {
+    secp256k1_scalar l, r, t;
+
+#if defined(USE_SCALAR_INV_NUM)
+    /* The num-based variable time inverse does not support zero */
+    if (var && secp256k1_scalar_is_zero(x)) {
+        if (out) secp256k1_scalar_clear(out);
+        return;
+    }
+#endif
+    if (var) {
+        secp256k1_scalar_inverse_var(&l, x);
+    } else {
+        secp256k1_scalar_inverse(&l, x);
+    }
+    if (out) *out = l;
+    if (secp256k1_scalar_is_zero(x)) {
+        /* The inverse of 0 is defined to be 0 */
+        CHECK(secp256k1_scalar_is_zero(&l));
+        return;
+    }
+    secp256k1_scalar_mul(&t, x, &l);                /* t = x*(1/x) */
+    CHECK(secp256k1_scalar_is_one(&t));             /* x*(1/x) == 1 */
+    secp256k1_scalar_add(&r, x, &secp256k1_scalar_one); /* r = x+1 */
+    if (secp256k1_scalar_is_zero(&r)) return;
+    if (var) {
+        secp256k1_scalar_inverse_var(&r, &r);       /* r = 1/(x+1) */
+    } else {
+        secp256k1_scalar_inverse(&r, &r);
+    }
+    secp256k1_scalar_add(&l, &secp256k1_scalar_one, &l); /* l = 1 + 1/x */
+    secp256k1_scalar_mul(&l, &l, &r);               /* l = (1 + 1/x)/(x+1) = 1/x */
+    secp256k1_scalar_negate(&t, x);                 /* t = -x */
+    if (var) {
+        secp256k1_scalar_inverse_var(&t, &t);       /* t = -1/x */
+    } else {
+        secp256k1_scalar_inverse(&t, &t);
+    }
+    secp256k1_scalar_add(&l, &l, &t);               /* l = 1/x - 1/x = 0 */
+    CHECK(secp256k1_scalar_is_zero(&l));
+}
+
+void test_inverse_field(secp256k1_fe* out, const secp256k1_fe* x, int var) {
+    secp256k1_fe l, r, t;
+    static const secp256k1_fe fe_one = SECP256K1_FE_CONST(0, 0, 0, 0, 0, 0, 0, 1);
+    static const secp256k1_fe fe_minus_one = SECP256K1_FE_CONST(
+        0xFFFFFFFFUL, 0xFFFFFFFFUL, 0xFFFFFFFFUL, 0xFFFFFFFFUL,
+        0xFFFFFFFFUL, 0xFFFFFFFFUL, 0xFFFFFFFEUL, 0xFFFFFC2EUL
+    );
+
+#if defined(USE_FIELD_INV_NUM)
+    /* The num-based variable time inverse does not support zero */
+    t = *x;
+    if (var && secp256k1_fe_normalizes_to_zero_var(&t)) {
+        if (out) secp256k1_fe_clear(out);
+        return;
+    }
+#endif
+    if (var) {
+        secp256k1_fe_inv_var(&l, x);
+    } else {
+        secp256k1_fe_inv(&l, x);
+    }
+    if (out) *out = l;
+    t = *x;
+    if (secp256k1_fe_normalizes_to_zero_var(&t)) {
+        /* The inverse of 0 is defined to be 0 */
+        CHECK(secp256k1_fe_normalizes_to_zero(&l));
+        return;
+    }
+    secp256k1_fe_mul(&t, x, &l);                    /* t = x*(1/x) */
+    secp256k1_fe_add(&t, &fe_minus_one);            /* t = x*(1/x)-1 */
+    CHECK(secp256k1_fe_normalizes_to_zero(&t));     /* x*(1/x)-1 == 0 */
+    r = *x;                                         /* r = x */
+    secp256k1_fe_add(&r, &fe_one);                  /* r = x+1 */
+    if (secp256k1_fe_normalizes_to_zero(&r)) return;
+    if (var) {
+        secp256k1_fe_inv_var(&r, &r);               /* r = 1/(x+1) */
+    } else {
+        secp256k1_fe_inv(&r, &r);
+    }
+    secp256k1_fe_add(&l, &fe_one);                  /* l = 1/x+1 */
+    secp256k1_fe_mul(&l, &l, &r);                   /* l = (1/x+1)/(x+1) = 1/x */
+    secp256k1_fe_negate(&t, x, 2);                  /* t = -x */
+    if (var) {
+        secp256k1_fe_inv_var(&t, &t);               /* t = -1/x */
+    } else {
+        secp256k1_fe_inv(&t, &t);
+    }
+    secp256k1_fe_add(&l, &t);                       /* l = 1/x - 1/x = 0 */
+    CHECK(secp256k1_fe_normalizes_to_zero_var(&l));
+}
+
+/* Compare every compiled inversion backend, not only the configured one. */
+void test_inverse_backends(const secp256k1_fe* x_fe, const secp256k1_scalar* x_scalar) {
+    secp256k1_fe l, t;
+    secp256k1_scalar ls, ts;
+
+    secp256k1_fe_inv_addchain(&l, x_fe);
+    secp256k1_fe_inv_safegcd(&t, x_fe);
+    CHECK(check_fe_equal(&t, &l));
+    secp256k1_fe_inv_safegcd_var(&t, x_fe);
+    CHECK(check_fe_equal(&t, &l));
+    secp256k1_scalar_inverse_addchain(&ls, x_scalar);
+    secp256k1_scalar_inverse_safegcd(&ts, x_scalar);
+    CHECK(secp256k1_scalar_eq(&ts, &ls));
+    secp256k1_scalar_inverse_safegcd_var(&ts, x_scalar);
+    CHECK(secp256k1_scalar_eq(&ts, &ls));
+#ifndef USE_NUM_NONE
+    /* The num-based inverses do not support zero */
+    t = *x_fe;
+    if (!secp256k1_fe_normalizes_to_zero_var(&t)) {
+        secp256k1_fe_inv_num_var(&t, x_fe);
+        CHECK(check_fe_equal(&t, &l));
+    }
+    if (!secp256k1_scalar_is_zero(x_scalar)) {
+        secp256k1_scalar_inverse_num_var(&ts, x_scalar);
+        CHECK(secp256k1_scalar_eq(&ts, &ls));
+    }
+#endif
+}
+
+void run_inverse_tests(void) {
+    /* Fixed test cases for field inverses: pairs of (x, 1/x) mod p. */
+    static const secp256k1_fe fe_cases[][2] = {
+        /* 0 */
+        {SECP256K1_FE_CONST(0, 0, 0, 0, 0, 0, 0, 0),
+         SECP256K1_FE_CONST(0, 0, 0, 0, 0, 0, 0, 0)},
+        /* 1 */
+        {SECP256K1_FE_CONST(0, 0, 0, 0, 0, 0, 0, 1),
+         SECP256K1_FE_CONST(0, 0, 0, 0, 0, 0, 0, 1)},
+        /* -1 */
+        {SECP256K1_FE_CONST(0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff, 0xfffffffe, 0xfffffc2e),
+         SECP256K1_FE_CONST(0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff, 0xfffffffe, 0xfffffc2e)},
+        /* 2 */
+        {SECP256K1_FE_CONST(0, 0, 0, 0, 0, 0, 0, 2),
+         SECP256K1_FE_CONST(0x7fffffff, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff, 0x7ffffe18)},
+        /* 2**128 */
+        {SECP256K1_FE_CONST(0, 0, 0, 1, 0, 0, 0, 0),
+         SECP256K1_FE_CONST(0xbcb223fe, 0xdc24a059, 0xd838091d, 0xd2253530, 0xffffffff, 0xffffffff, 0xffffffff, 0x434dd931)}
+    };
+    /* Fixed test cases for scalar inverses: pairs of (x, 1/x) mod n. */
+    static const secp256k1_scalar scalar_cases[][2] = {
+        /* 0 */
+        {SECP256K1_SCALAR_CONST(0, 0, 0, 0, 0, 0, 0, 0),
+         SECP256K1_SCALAR_CONST(0, 0, 0, 0, 0, 0, 0, 0)},
+        /* 1 */
+        {SECP256K1_SCALAR_CONST(0, 0, 0, 0, 0, 0, 0, 1),
+         SECP256K1_SCALAR_CONST(0, 0, 0, 0, 0, 0, 0, 1)},
+        /* -1 */
+        {SECP256K1_SCALAR_CONST(0xffffffff, 0xffffffff, 0xffffffff, 0xfffffffe, 0xbaaedce6, 0xaf48a03b, 0xbfd25e8c, 0xd0364140),
+         SECP256K1_SCALAR_CONST(0xffffffff, 0xffffffff, 0xffffffff, 0xfffffffe, 0xbaaedce6, 0xaf48a03b, 0xbfd25e8c, 0xd0364140)},
+        /* 2 */
+        {SECP256K1_SCALAR_CONST(0, 0, 0, 0, 0, 0, 0, 2),
+         SECP256K1_SCALAR_CONST(0x7fffffff, 0xffffffff, 0xffffffff, 0xffffffff, 0x5d576e73, 0x57a4501d, 0xdfe92f46, 0x681b20a1)},
+        /* 2**128 */
+        {SECP256K1_SCALAR_CONST(0, 0, 0, 1, 0, 0, 0, 0),
+         SECP256K1_SCALAR_CONST(0x50a51ac8, 0x34b9ec24, 0x4b0dff66, 0x5588b13e, 0x9984d5b3, 0xcf80ef0f, 0xd6a23766, 0xa3ee9f22)}
+    };
+    int i, var, testrand;
+    unsigned char b32[32];
+    secp256k1_fe x_fe;
+    secp256k1_scalar x_scalar;
+    memset(b32, 0, sizeof(b32));
+    /* Test fixed test cases through test_inverse_{scalar,field}, both ways. */
+    for (i = 0; (size_t)i < sizeof(fe_cases)/sizeof(fe_cases[0]); ++i) {
+        for (var = 0; var <= 1; ++var) {
+            test_inverse_field(&x_fe, &fe_cases[i][0], var);
+            CHECK(check_fe_equal(&x_fe, &fe_cases[i][1]));
+            test_inverse_field(&x_fe, &fe_cases[i][1], var);
+            CHECK(check_fe_equal(&x_fe, &fe_cases[i][0]));
+        }
+    }
+    for (i = 0; (size_t)i < sizeof(fe_cases)/sizeof(fe_cases[0]); ++i) {
+        test_inverse_backends(&fe_cases[i][0], &scalar_cases[i][0]);
+    }
+    for (i = 0; (size_t)i < sizeof(scalar_cases)/sizeof(scalar_cases[0]); ++i) {
+        for (var = 0; var <= 1; ++var) {
+            test_inverse_scalar(&x_scalar, &scalar_cases[i][0], var);
+            CHECK(secp256k1_scalar_eq(&x_scalar, &scalar_cases[i][1]));
+            test_inverse_scalar(&x_scalar, &scalar_cases[i][1], var);
+            CHECK(secp256k1_scalar_eq(&x_scalar, &scalar_cases[i][0]));
+        }
+    }
+    /* Test inputs 0..999 and their respective negations. */
+    for (i = 0; i < 1000; ++i) {
+        b32[31] = i & 0xff;
+        b32[30] = (i >> 8) & 0xff;
+        secp256k1_scalar_set_b32(&x_scalar, b32, NULL);
+        secp256k1_fe_set_b32(&x_fe, b32);
+        for (var = 0; var <= 1; ++var) {
+            test_inverse_scalar(NULL, &x_scalar, var);
+            test_inverse_field(NULL, &x_fe, var);
+        }
+        secp256k1_scalar_negate(&x_scalar, &x_scalar);
+        secp256k1_fe_negate(&x_fe, &x_fe, 1);
+        for (var = 0; var <= 1; ++var) {
+            test_inverse_scalar(NULL, &x_scalar, var);
+            test_inverse_field(NULL, &x_fe, var);
+        }
+    }
+    /* test 128*count random inputs; half with testrand256_test, half with testrand256 */
+    for (testrand = 0; testrand <= 1; ++testrand) {
+        for (i = 0; i < 64 * count; ++i) {
+            (testrand ? secp256k1_testrand256_test : secp256k1_testrand256)(b32);
+            secp256k1_scalar_set_b32(&x_scalar, b32, NULL);
+            secp256k1_fe_set_b32(&x_fe, b32);
+            for (var = 0; var <= 1; ++var) {
+                test_inverse_scalar(NULL, &x_scalar, var);
+                test_inverse_field(NULL, &x_fe, var);
+            }
+            test_inverse_backends(&x_fe, &x_scalar);
+        }
     }
 }
 
@@ -2002,10 +2711,64 @@ void run_sqr(void) {
     }
 }
 
+#ifdef SECP256K1_FE_X8
+void run_field_x8(void) {
+    secp256k1_fe a[8], b[8], r[8], c;
+    secp256k1_fe_x8 va, vb;
+    int i, j;
+
+    if (!secp256k1_fe_x8_available()) {
+        return;
+    }
+    for (i = 0; i < 10*count; i++) {
+        for (j = 0; j < 8; j++) {
+            random_fe_test(&a[j]);
+            random_fe_test(&b[j]);
+            /* Cover magnitudes 1 and 2, and the maximum of 8 with limbs close to their limits. */
+            secp256k1_fe_negate(&a[j], &a[j], 1 + (int)secp256k1_testrand_bits(1) * 6);
+            if (j & 1) {
+                secp256k1_fe_negate(&b[j], &b[j], 7);
+            }
+        }
+        if (i == 0) {
+            /* All ones in every limb of the input (p - 1 and its negation) */
+            secp256k1_fe_set_int(&a[0], 1);
+            secp256k1_fe_negate(&a[0], &a[0], 1);
+            secp256k1_fe_normalize(&a[0]);
+            secp256k1_fe_negate(&b[0], &a[0], 7);
+            b[1] = a[0];
+        }
+
+        secp256k1_fe_x8_load(&va, &a[0], sizeof(secp256k1_fe));
+        secp256k1_fe_x8_load(&vb, &b[0], sizeof(secp256k1_fe));
+        secp256k1_fe_x8_mul(&vb, &va, &vb);
+        secp256k1_fe_x8_store(&r[0], sizeof(secp256k1_fe), &vb);
+        for (j = 0; j < 8; j++) {
+            secp256k1_fe_mul(&c, &a[j], &b[j]);
+            CHECK(check_fe_equal(&r[j], &c));
+        }
+
+        /* The results can be used as inputs again. */
+        secp256k1_fe_x8_sqr(&vb, &vb);
+        secp256k1_fe_x8_sqr(&va, &va);
+        secp256k1_fe_x8_mul(&va, &va, &vb);
+        secp256k1_fe_x8_store(&r[0], sizeof(secp256k1_fe), &va);
+        for (j = 0; j < 8; j++) {
+            secp256k1_fe_mul(&c, &a[j], &b[j]);
+            secp256k1_fe_sqr(&c, &c);
+            secp256k1_fe_mul(&c, &c, &a[j]);
+            secp256k1_fe_mul(&c, &c, &a[j]);
+            CHECK(check_fe_equal(&r[j], &c));
+        }
+    }
+}
+#endif
+
 void test_sqrt(const secp256k1_fe *a, const secp256k1_fe *k) {
     secp256k1_fe r1, r2;
     int v = secp256k1_fe_sqrt(&r1, a);
     CHECK((v == 0) == (k == NULL));
+    CHECK(secp256k1_fe_is_quad_var(a) == v);
 
     if (k != NULL) {
         /* Check that the returned root is +/- the given known answer */
@@ -2050,6 +2813,128 @@ void run_sqrt(void) {
     }
 }
 
+static int counters_ecmult_multi_callback(secp256k1_scalar *sc, secp256k1_ge *pt, size_t idx, void *cbdata) {
+    (void)idx;
+    (void)cbdata;
+    secp256k1_scalar_set_int(sc, 1);
+    *pt = secp256k1_ge_const_g;
+    return 1;
+}
+
+void run_counters_tests(void) {
+    size_t counts[SECP256K1_COUNTER_COUNT + 1];
+    unsigned char buf[64] = { 0 };
+    secp256k1_sha256 sha;
+    secp256k1_fe x, y;
+    secp256k1_gej p;
+    secp256k1_scratch *scratch;
+    int enabled, i;
+    int32_t ecount = 0;
+
+    secp256k1_context_set_illegal_callback(ctx, counting_illegal_callback_fn, &ecount);
+    CHECK(secp256k1_counters_snapshot(ctx, NULL, 1) == 0);
+    CHECK(ecount == 1);
+    secp256k1_context_set_illegal_callback(ctx, NULL, NULL);
+
+    secp256k1_counters_reset(ctx);
+    random_fe_non_zero(&x);
+    secp256k1_fe_inv(&y, &x);
+    secp256k1_fe_sqrt(&y, &x);
+    random_group_element_jacobian_test(&p, &secp256k1_ge_const_g);
+    secp256k1_gej_double_var(&p, &p, NULL);
+    secp256k1_sha256_initialize(&sha);
+    secp256k1_sha256_write(&sha, buf, 64);
+    secp256k1_sha256_finalize(&sha, buf);
+    scratch = secp256k1_scratch_create(&ctx->error_callback, 16);
+    CHECK(secp256k1_scratch_alloc(&ctx->error_callback, scratch, 32) == NULL);
+    secp256k1_scratch_destroy(&ctx->error_callback, scratch);
+    CHECK(secp256k1_ecmult_multi_var(&ctx->error_callback, &ctx->ecmult_ctx, NULL, &p, NULL, counters_ecmult_multi_callback, NULL, 1));
+
+    enabled = secp256k1_counters_snapshot(ctx, counts, SECP256K1_COUNTER_COUNT + 1);
+    CHECK(counts[SECP256K1_COUNTER_COUNT] == 0);
+#ifdef ENABLE_COUNTERS
+    CHECK(enabled == 1);
+    CHECK(counts[SECP256K1_COUNTER_FE_INV] == 1);
+    CHECK(counts[SECP256K1_COUNTER_FE_SQRT] == 1);
+    CHECK(counts[SECP256K1_COUNTER_FE_MUL] > 0);
+    CHECK(counts[SECP256K1_COUNTER_FE_SQR] > 0);
+    CHECK(counts[SECP256K1_COUNTER_GEJ_ADD] > 0);
+    CHECK(counts[SECP256K1_COUNTER_GEJ_DOUBLE] > 0);
+    CHECK(counts[SECP256K1_COUNTER_SHA256_TRANSFORM] >= 2);
+    CHECK(counts[SECP256K1_COUNTER_SCRATCH_EXHAUSTED] == 1);
+    CHECK(counts[SECP256K1_COUNTER_ECMULT_MULTI_SIMPLE] == 1);
+    secp256k1_counters_reset(ctx);
+    CHECK(secp256k1_counters_snapshot(ctx, counts, SECP256K1_COUNTER_COUNT) == 1);
+#else
+    CHECK(enabled == 0);
+#endif
+    for (i = 0; i < SECP256K1_COUNTER_COUNT; i++) {
+        CHECK(counts[i] == 0);
+    }
+}
+
+typedef struct {
+    int events[SECP256K1_EVENT_ECMULT_MULTI_SIMPLE + 1];
+    size_t wanted, available;
+} event_callback_data;
+
+static void event_callback_fn(int event, size_t wanted, size_t available, void* data) {
+    event_callback_data *d = (event_callback_data *)data;
+    CHECK(event >= SECP256K1_EVENT_SCRATCH_TOO_SMALL && event <= SECP256K1_EVENT_ECMULT_MULTI_SIMPLE);
+    d->events[event]++;
+    if (event == SECP256K1_EVENT_SCRATCH_TOO_SMALL) {
+        d->wanted = wanted;
+        d->available = available;
+    }
+}
+
+static void test_event_callback_ecmult_multi(size_t scratch_size, size_t n, event_callback_data *data) {
+    secp256k1_scratch_space *scratch = secp256k1_scratch_space_create(ctx, scratch_size);
+    secp256k1_gej r;
+    memset(data, 0, sizeof(*data));
+    CHECK(secp256k1_ecmult_multi_var(&ctx->error_callback, &ctx->ecmult_ctx, scratch, &r, NULL, counters_ecmult_multi_callback, NULL, n));
+    secp256k1_scratch_space_destroy(ctx, scratch);
+}
+
+void run_event_callback_tests(void) {
+    event_callback_data data;
+    size_t n = 2 * ECMULT_PIPPENGER_THRESHOLD;
+    size_t needed = secp256k1_ecmult_multi_scratch_size_helper(n);
+    size_t small_size = secp256k1_ecmult_multi_algorithm_scratch_size(n / 4, 1);
+
+    secp256k1_context_set_event_callback(ctx, event_callback_fn, &data);
+    /* Enough scratch space: no events */
+    test_event_callback_ecmult_multi(needed, n, &data);
+    CHECK(data.events[SECP256K1_EVENT_SCRATCH_TOO_SMALL] == 0);
+    CHECK(data.events[SECP256K1_EVENT_ECMULT_MULTI_SPLIT] == 0);
+    CHECK(data.events[SECP256K1_EVENT_ECMULT_MULTI_STRAUSS] == 0);
+    CHECK(data.events[SECP256K1_EVENT_ECMULT_MULTI_SIMPLE] == 0);
+    /* Room for a quarter of the points with Pippenger's algorithm, too few for it to
+     * be faster than Strauss', which is then used in smaller batches (unless a large
+     * WINDOW_A leaves no room for a single point with it) */
+    test_event_callback_ecmult_multi(small_size, n, &data);
+    CHECK(data.events[SECP256K1_EVENT_SCRATCH_TOO_SMALL] == 1);
+    CHECK(data.wanted == needed && data.available == small_size);
+    CHECK(data.events[SECP256K1_EVENT_ECMULT_MULTI_SPLIT] == 1);
+    CHECK(data.events[SECP256K1_EVENT_ECMULT_MULTI_STRAUSS] == (secp256k1_ecmult_multi_algorithm_scratch_size(1, 0) <= small_size));
+    CHECK(data.events[SECP256K1_EVENT_ECMULT_MULTI_SIMPLE] == 0);
+    /* No room for anything */
+    test_event_callback_ecmult_multi(1, n, &data);
+    CHECK(data.events[SECP256K1_EVENT_SCRATCH_TOO_SMALL] == 1);
+    CHECK(data.events[SECP256K1_EVENT_ECMULT_MULTI_SIMPLE] == 1);
+    /* A scratch space created after removing the callback reports nothing */
+    secp256k1_context_set_event_callback(ctx, NULL, NULL);
+    memset(&data, 0, sizeof(data));
+    {
+        secp256k1_scratch_space *scratch = secp256k1_scratch_space_create(ctx, 1);
+        secp256k1_gej r;
+        CHECK(secp256k1_ecmult_multi_var(&ctx->error_callback, &ctx->ecmult_ctx, scratch, &r, NULL, counters_ecmult_multi_callback, NULL, n));
+        secp256k1_scratch_space_destroy(ctx, scratch);
+    }
+    CHECK(data.events[SECP256K1_EVENT_SCRATCH_TOO_SMALL] == 0);
+    CHECK(data.events[SECP256K1_EVENT_ECMULT_MULTI_SIMPLE] == 0);
+}
+
 /***** GROUP TESTS *****/
 
 void ge_equals_ge(const secp256k1_ge *a, const secp256k1_ge *b) {
@@ -2139,9 +3024,9 @@ void test_ge(void) {
         for (j = 0; j < 4; j++) {
             random_field_element_magnitude(&ge[1 + j + 4 * i].x);
             random_field_element_magnitude(&ge[1 + j + 4 * i].y);
-            random_field_element_magnitude(&gej[1 + j + 4 * i].x);
-            random_field_element_magnitude(&gej[1 + j + 4 * i].y);
-            random_field_element_magnitude(&gej[1 + j + 4 * i].z);
+            random_field_element_magnitude_max(&gej[1 + j + 4 * i].x, SECP256K1_GEJ_X_MAGNITUDE_MAX);
+            random_field_element_magnitude_max(&gej[1 + j + 4 * i].y, SECP256K1_GEJ_Y_MAGNITUDE_MAX);
+            random_field_element_magnitude_max(&gej[1 + j + 4 * i].z, SECP256K1_GEJ_Z_MAGNITUDE_MAX);
         }
     }
 
@@ -2291,10 +3176,28 @@ void test_ge(void) {
         free(zr);
     }
 
-    /* Test batch gej -> ge conversion with many infinities. */
-    for (i = 0; i < 4 * runs + 1; i++) {
-        random_group_element_test(&ge[i]);
-        /* randomly set half the points to infinity */
+    /* Test constant-time batch gej -> ge conversion, which does not support infinity. */
+    {
+        secp256k1_gej *gej_finite = (secp256k1_gej *)checked_malloc(&ctx->error_callback, (4 * runs + 1) * sizeof(secp256k1_gej));
+        secp256k1_ge *ge_set_all = (secp256k1_ge *)checked_malloc(&ctx->error_callback, (4 * runs + 1) * sizeof(secp256k1_ge));
+        size_t n_finite = 0;
+        for (i = 0; i < 4 * runs + 1; i++) {
+            if (!secp256k1_gej_is_infinity(&gej[i])) {
+                gej_finite[n_finite++] = gej[i];
+            }
+        }
+        secp256k1_ge_set_all_gej(ge_set_all, gej_finite, n_finite);
+        for (i = 0; i < (int)n_finite; i++) {
+            ge_equals_gej(&ge_set_all[i], &gej_finite[i]);
+        }
+        free(ge_set_all);
+        free(gej_finite);
+    }
+
+    /* Test batch gej -> ge conversion with many infinities. */
+    for (i = 0; i < 4 * runs + 1; i++) {
+        random_group_element_test(&ge[i]);
+        /* randomly set half the points to infinity */
         if(secp256k1_fe_is_odd(&ge[i].x)) {
             secp256k1_ge_set_infinity(&ge[i]);
         }
@@ -2446,12 +3349,72 @@ void test_ec_combine(void) {
     }
 }
 
+#ifndef ENABLE_VERIFY_ONLY
+void test_ec_combine_batch(void) {
+    /* Random groups, including empty ones and ones summing to infinity, compared to
+     * combining one group at a time. */
+    secp256k1_pubkey data[120];
+    const secp256k1_pubkey* d[120];
+    secp256k1_pubkey outs[40], expected[40];
+    size_t sizes[40];
+    size_t i, j, n_in = 0, n_outs = 1 + secp256k1_testrand_int(40);
+    int all = 1;
+    int vartime, ecount = 0;
+
+    for (i = 0; i < n_outs; i++) {
+        secp256k1_scalar s, sum = SECP256K1_SCALAR_CONST(0, 0, 0, 0, 0, 0, 0, 0);
+        secp256k1_gej Qj;
+        secp256k1_ge Q;
+        int kind = secp256k1_testrand_int(8);
+
+        sizes[i] = kind == 0 ? 0 : (kind == 2 ? 2 : 1) + secp256k1_testrand_int(2);
+        for (j = 0; j < sizes[i]; j++) {
+            random_scalar_order_test(&s);
+            if (kind == 2 && j == sizes[i] - 1) {
+                /* The last key cancels the others */
+                secp256k1_scalar_negate(&s, &sum);
+            }
+            secp256k1_scalar_add(&sum, &sum, &s);
+            secp256k1_ecmult_gen(&ctx->ecmult_gen_ctx, &Qj, &s);
+            secp256k1_ge_set_gej(&Q, &Qj);
+            secp256k1_pubkey_save(&data[n_in + j], &Q);
+            d[n_in + j] = &data[n_in + j];
+        }
+        if (sizes[i] == 0) {
+            memset(&expected[i], 0, sizeof(expected[i]));
+            all = 0;
+        } else {
+            all &= secp256k1_ec_pubkey_combine(ctx, &expected[i], &d[n_in], sizes[i]);
+        }
+        n_in += sizes[i];
+    }
+    for (vartime = 0; vartime < 2; vartime++) {
+        CHECK(secp256k1_ec_pubkey_combine_batch(ctx, outs, n_outs, d, sizes, vartime) == all);
+        CHECK(secp256k1_memcmp_var(expected, outs, n_outs * sizeof(outs[0])) == 0);
+    }
+
+    CHECK(secp256k1_ec_pubkey_combine_batch(ctx, NULL, 0, NULL, NULL, 0) == 1);
+    secp256k1_context_set_illegal_callback(ctx, counting_illegal_callback_fn, &ecount);
+    CHECK(secp256k1_ec_pubkey_combine_batch(ctx, NULL, 1, d, sizes, 0) == 0);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_ec_pubkey_combine_batch(ctx, outs, 1, d, NULL, 0) == 0);
+    CHECK(ecount == 2);
+    sizes[0] = 1;
+    CHECK(secp256k1_ec_pubkey_combine_batch(ctx, outs, 1, NULL, sizes, 0) == 0);
+    CHECK(ecount == 3);
+    secp256k1_context_set_illegal_callback(ctx, NULL, NULL);
+}
+
 void run_ec_combine(void) {
     int i;
     for (i = 0; i < count * 8; i++) {
          test_ec_combine();
     }
+    for (i = 0; i < count; i++) {
+         test_ec_combine_batch();
+    }
 }
+#endif
 
 void test_group_decompress(const secp256k1_fe* x) {
     /* The input itself, normalized. */
@@ -2517,6 +3480,29 @@ void test_group_decompress(const secp256k1_fe* x) {
     }
 }
 
+void test_group_decompress_batch(void) {
+    /* Enough coordinates for the eight-way code and a remainder */
+    secp256k1_fe x[21];
+    secp256k1_ge ge[21], ge_one;
+    int odd[21], res[21];
+    size_t i, n = secp256k1_testrand_int(22);
+
+    /* Fill every entry, not just the first n, so that all inputs are set whatever n is. */
+    for (i = 0; i < 21; i++) {
+        random_fe_test(&x[i]);
+        odd[i] = secp256k1_testrand_bits(1);
+    }
+    secp256k1_ge_set_xo_batch_var(ge, res, x, odd, n);
+    for (i = 0; i < n; i++) {
+        CHECK(res[i] == secp256k1_ge_set_xo_var(&ge_one, &x[i], odd[i]));
+        if (res[i]) {
+            secp256k1_fe_normalize_var(&ge[i].y);
+            secp256k1_fe_normalize_var(&ge_one.y);
+            ge_equals_ge(&ge[i], &ge_one);
+        }
+    }
+}
+
 void run_group_decompress(void) {
     int i;
     for (i = 0; i < count * 4; i++) {
@@ -2524,6 +3510,9 @@ void run_group_decompress(void) {
         random_fe_test(&fe);
         test_group_decompress(&fe);
     }
+    for (i = 0; i < count; i++) {
+        test_group_decompress_batch();
+    }
 }
 
 /***** ECMULT TESTS *****/
@@ -2657,10 +3646,11 @@ static const secp256k1_scalar scalars_near_split_bounds[20] = {
 };
 
 void test_ecmult_target(const secp256k1_scalar* target, int mode) {
-    /* Mode: 0=ecmult_gen, 1=ecmult, 2=ecmult_const */
+    /* Mode: 0=ecmult_gen, 1=ecmult, 2=ecmult_const, 3=ecmult_prepared */
     secp256k1_scalar n1, n2;
     secp256k1_ge p;
     secp256k1_gej pj, p1j, p2j, ptj;
+    secp256k1_ecmult_prepared_point prep;
     static const secp256k1_scalar zero = SECP256K1_SCALAR_CONST(0, 0, 0, 0, 0, 0, 0, 0);
 
     /* Generate random n1,n2 such that n1+n2 = -target. */
@@ -2683,10 +3673,15 @@ void test_ecmult_target(const secp256k1_scalar* target, int mode) {
         secp256k1_ecmult(&ctx->ecmult_ctx, &p1j, &pj, &n1, &zero);
         secp256k1_ecmult(&ctx->ecmult_ctx, &p2j, &pj, &n2, &zero);
         secp256k1_ecmult(&ctx->ecmult_ctx, &ptj, &pj, target, &zero);
-    } else {
+    } else if (mode == 2) {
         secp256k1_ecmult_const(&p1j, &p, &n1, 256);
         secp256k1_ecmult_const(&p2j, &p, &n2, 256);
         secp256k1_ecmult_const(&ptj, &p, target, 256);
+    } else {
+        secp256k1_ecmult_prepared_point_build(&prep, &p);
+        secp256k1_ecmult_prepared(&ctx->ecmult_ctx, &p1j, &prep, &n1, &zero);
+        secp256k1_ecmult_prepared(&ctx->ecmult_ctx, &p2j, &prep, &n2, &zero);
+        secp256k1_ecmult_prepared(&ctx->ecmult_ctx, &ptj, &prep, target, &zero);
     }
 
     /* Add them all up: n1*P + n2*P + target*P = (n1+n2+target)*P = (n1+n1-n1-n2)*P = 0. */
@@ -2703,7 +3698,51 @@ void run_ecmult_near_split_bound(void) {
             test_ecmult_target(&scalars_near_split_bounds[j], 0);
             test_ecmult_target(&scalars_near_split_bounds[j], 1);
             test_ecmult_target(&scalars_near_split_bounds[j], 2);
+            test_ecmult_target(&scalars_near_split_bounds[j], 3);
+        }
+    }
+}
+
+void run_ecmult_short_scalars(void) {
+    /* Scalars at the bound below which secp256k1_ecmult_split_a skips the lambda split. */
+    static const secp256k1_scalar bounds[] = {
+        SECP256K1_SCALAR_CONST(0, 0, 0, 0, 0, 0, 0, 1),
+        SECP256K1_SCALAR_CONST(0, 0, 0, 0, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff),
+        SECP256K1_SCALAR_CONST(0, 0, 0, 1, 0, 0, 0, 0)
+    };
+    secp256k1_scalar s, s1, slam;
+    unsigned char b32[32];
+    int i, neg;
+    unsigned j;
+
+    for (j = 0; j < sizeof(bounds) / sizeof(bounds[0]); ++j) {
+        for (neg = 0; neg < 2; ++neg) {
+            s = bounds[j];
+            if (neg) {
+                secp256k1_scalar_negate(&s, &s);
+            }
+            secp256k1_ecmult_split_a(&s1, &slam, &s);
+            CHECK(secp256k1_scalar_is_zero(&slam) == (j < 2));
+            if (j < 2) {
+                CHECK(secp256k1_scalar_eq(&s1, &s));
+            }
+            for (i = 0; i < count; ++i) {
+                test_ecmult_target(&s, 1);
+                test_ecmult_target(&s, 3);
+            }
+        }
+    }
+    for (i = 0; i < 4*count; ++i) {
+        secp256k1_testrand256(b32);
+        memset(b32, 0, 16 + secp256k1_testrand_int(16));
+        secp256k1_scalar_set_b32(&s, b32, NULL);
+        if (secp256k1_testrand_bits(1)) {
+            secp256k1_scalar_negate(&s, &s);
         }
+        secp256k1_ecmult_split_a(&s1, &slam, &s);
+        CHECK(secp256k1_scalar_is_zero(&slam));
+        test_ecmult_target(&s, 1);
+        test_ecmult_target(&s, 3);
     }
 }
 
@@ -2831,6 +3870,148 @@ void run_ecmult_const_tests(void) {
     ecmult_const_chain_multiply();
 }
 
+/* Checks secp256k1_ecmult_3 against two calls to secp256k1_ecmult. */
+void test_ecmult_3_case(const secp256k1_gej *a, const secp256k1_scalar *na, const secp256k1_gej *b, const secp256k1_scalar *nb, const secp256k1_scalar *ng) {
+    secp256k1_gej r, r1, r2;
+
+    secp256k1_ecmult_3(&ctx->ecmult_ctx, &r, a, na, b, nb, ng);
+    secp256k1_ecmult(&ctx->ecmult_ctx, &r1, a, na, ng);
+    secp256k1_ecmult(&ctx->ecmult_ctx, &r2, b, nb, NULL);
+    secp256k1_gej_add_var(&r1, &r1, &r2, NULL);
+    secp256k1_gej_neg(&r1, &r1);
+    secp256k1_gej_add_var(&r, &r, &r1, NULL);
+    CHECK(secp256k1_gej_is_infinity(&r));
+}
+
+void test_ecmult_3(void) {
+    secp256k1_ge ge;
+    secp256k1_gej a, b, inf;
+    secp256k1_scalar na, nb, ng;
+
+    random_group_element_test(&ge);
+    random_group_element_jacobian_test(&a, &ge);
+    random_group_element_test(&ge);
+    random_group_element_jacobian_test(&b, &ge);
+    random_scalar_order_test(&na);
+    random_scalar_order_test(&nb);
+    random_scalar_order_test(&ng);
+    secp256k1_gej_set_infinity(&inf);
+
+    test_ecmult_3_case(&a, &na, &b, &nb, &ng);
+    test_ecmult_3_case(&a, &na, &b, &nb, NULL);
+    test_ecmult_3_case(&a, &na, &inf, &nb, &ng);
+    test_ecmult_3_case(&inf, &na, &b, &nb, &ng);
+    test_ecmult_3_case(&a, &secp256k1_scalar_zero, &b, &nb, &ng);
+    test_ecmult_3_case(&a, &na, &b, &secp256k1_scalar_zero, NULL);
+    test_ecmult_3_case(&inf, &na, &inf, &nb, NULL);
+    /* The same point twice, and terms that cancel out. */
+    test_ecmult_3_case(&a, &na, &a, &nb, &ng);
+    secp256k1_gej_neg(&b, &a);
+    test_ecmult_3_case(&a, &na, &b, &na, &ng);
+    test_ecmult_3_case(&a, &na, &b, &na, &secp256k1_scalar_zero);
+}
+
+void run_ecmult_3_tests(void) {
+    int i;
+    for (i = 0; i < count; i++) {
+        test_ecmult_3();
+    }
+}
+
+void test_ecmult_small(size_t num) {
+    secp256k1_gej a[2 * ECMULT_SMALL_MAX_POINTS + 1];
+    secp256k1_scalar na[2 * ECMULT_SMALL_MAX_POINTS + 1];
+    secp256k1_scalar ng;
+    secp256k1_gej r, expected, tmp;
+    size_t i;
+
+    CHECK(num <= 2 * ECMULT_SMALL_MAX_POINTS + 1);
+    random_scalar_order_test(&ng);
+    secp256k1_ecmult(&ctx->ecmult_ctx, &expected, NULL, &secp256k1_scalar_zero, &ng);
+    for (i = 0; i < num; i++) {
+        secp256k1_ge ge;
+        random_group_element_test(&ge);
+        random_group_element_jacobian_test(&a[i], &ge);
+        random_scalar_order_test(&na[i]);
+        /* Some of the terms vanish. */
+        switch (secp256k1_testrand_int(8)) {
+            case 0: secp256k1_gej_set_infinity(&a[i]); break;
+            case 1: na[i] = secp256k1_scalar_zero; break;
+        }
+        secp256k1_ecmult(&ctx->ecmult_ctx, &tmp, &a[i], &na[i], NULL);
+        secp256k1_gej_add_var(&expected, &expected, &tmp, NULL);
+    }
+
+    secp256k1_ecmult_small(&ctx->ecmult_ctx, &r, a, na, num, &ng);
+    secp256k1_gej_neg(&tmp, &expected);
+    secp256k1_gej_add_var(&tmp, &tmp, &r, NULL);
+    CHECK(secp256k1_gej_is_infinity(&tmp));
+
+    /* Without the G term */
+    secp256k1_ecmult(&ctx->ecmult_ctx, &tmp, NULL, &secp256k1_scalar_zero, &ng);
+    secp256k1_gej_neg(&tmp, &tmp);
+    secp256k1_gej_add_var(&expected, &expected, &tmp, NULL);
+    secp256k1_ecmult_small(&ctx->ecmult_ctx, &r, a, na, num, NULL);
+    secp256k1_gej_neg(&tmp, &expected);
+    secp256k1_gej_add_var(&tmp, &tmp, &r, NULL);
+    CHECK(secp256k1_gej_is_infinity(&tmp));
+}
+
+void run_ecmult_small_tests(void) {
+    int i;
+    test_ecmult_small(0);
+    test_ecmult_small(1);
+    test_ecmult_small(ECMULT_SMALL_MAX_POINTS);
+    /* More points than fit at once */
+    test_ecmult_small(ECMULT_SMALL_MAX_POINTS + 1);
+    test_ecmult_small(2 * ECMULT_SMALL_MAX_POINTS + 1);
+    for (i = 0; i < count; i++) {
+        test_ecmult_small(secp256k1_testrand_int(ECMULT_SMALL_MAX_POINTS + 1));
+    }
+}
+
+/* Checks secp256k1_ecmult_lanes against a call to secp256k1_ecmult per lane. */
+void test_ecmult_lanes(size_t n) {
+    secp256k1_gej a[ECMULT_LANES], r[ECMULT_LANES], expected;
+    secp256k1_scalar na[ECMULT_LANES], ng[ECMULT_LANES];
+    size_t i;
+
+    CHECK(n <= ECMULT_LANES);
+    for (i = 0; i < ECMULT_LANES; i++) {
+        secp256k1_ge ge;
+        random_group_element_test(&ge);
+        random_group_element_jacobian_test(&a[i], &ge);
+        random_scalar_order_test(&na[i]);
+        random_scalar_order_test(&ng[i]);
+        /* Some of the lanes have vanishing or short terms. */
+        switch (secp256k1_testrand_int(8)) {
+            case 0: secp256k1_gej_set_infinity(&a[i]); break;
+            case 1: na[i] = secp256k1_scalar_zero; break;
+            case 2: ng[i] = secp256k1_scalar_zero; break;
+            case 3: secp256k1_scalar_set_int(&na[i], secp256k1_testrand32()); break;
+            case 4: na[i] = secp256k1_scalar_zero; ng[i] = secp256k1_scalar_zero; break;
+        }
+    }
+    secp256k1_ecmult_lanes(&ctx->ecmult_ctx, r, a, na, ng, n);
+    for (i = 0; i < n; i++) {
+        secp256k1_ecmult(&ctx->ecmult_ctx, &expected, &a[i], &na[i], &ng[i]);
+        secp256k1_gej_neg(&expected, &expected);
+        secp256k1_gej_add_var(&expected, &expected, &r[i], NULL);
+        CHECK(secp256k1_gej_is_infinity(&expected));
+    }
+}
+
+void run_ecmult_lanes_tests(void) {
+    int i;
+    size_t n;
+    for (n = 0; n <= ECMULT_LANES; n++) {
+        test_ecmult_lanes(n);
+    }
+    for (i = 0; i < count; i++) {
+        test_ecmult_lanes(ECMULT_LANES);
+    }
+}
+
 typedef struct {
     secp256k1_scalar *sc;
     secp256k1_ge *pt;
@@ -3115,8 +4296,8 @@ void test_secp256k1_pippenger_bucket_window_inv(void) {
 
     CHECK(secp256k1_pippenger_bucket_window_inv(0) == 0);
     for(i = 1; i <= PIPPENGER_MAX_BUCKET_WINDOW; i++) {
-        /* Bucket_window of 8 is not used with endo */
-        if (i == 8) {
+        /* Skip unused windows, e.g. 8 with endo */
+        if (i > 1 && secp256k1_pippenger_bucket_window_inv(i) == secp256k1_pippenger_bucket_window_inv(i - 1)) {
             continue;
         }
         CHECK(secp256k1_pippenger_bucket_window(secp256k1_pippenger_bucket_window_inv(i)) == i);
@@ -3278,6 +4459,68 @@ void test_ecmult_multi_batching(void) {
     free(pt);
 }
 
+/* Exercises pippenger_wnaf_affine, including the doublings and cancellations in its
+ * affine buckets, by using enough points for a window of at least
+ * PIPPENGER_AFFINE_MIN_WINDOW and repeating (negated) points with equal scalars. */
+void test_ecmult_multi_pippenger_affine(void) {
+    static const int n_points = 1300;
+    int bucket_window = secp256k1_pippenger_bucket_window(n_points);
+    secp256k1_scratch *scratch;
+    secp256k1_scalar szero;
+    secp256k1_scalar *sc = (secp256k1_scalar *)checked_malloc(&ctx->error_callback, sizeof(secp256k1_scalar) * n_points);
+    secp256k1_ge *pt = (secp256k1_ge *)checked_malloc(&ctx->error_callback, sizeof(secp256k1_ge) * n_points);
+    secp256k1_gej r, r2;
+    ecmult_multi_data data;
+    int i;
+
+    CHECK(bucket_window >= PIPPENGER_AFFINE_MIN_WINDOW);
+    secp256k1_scalar_set_int(&szero, 0);
+    secp256k1_gej_set_infinity(&r2);
+    for (i = 0; i < n_points; i++) {
+        secp256k1_gej ptgj;
+        switch (i > 0 ? secp256k1_testrand_int(8) : 0) {
+        case 1:
+            pt[i] = pt[i - 1];
+            sc[i] = sc[i - 1];
+            break;
+        case 2:
+            secp256k1_ge_neg(&pt[i], &pt[i - 1]);
+            sc[i] = sc[i - 1];
+            break;
+        default:
+            random_group_element_test(&pt[i]);
+            random_scalar_order(&sc[i]);
+        }
+        secp256k1_gej_set_ge(&ptgj, &pt[i]);
+        secp256k1_ecmult(&ctx->ecmult_ctx, &ptgj, &ptgj, &sc[i], NULL);
+        secp256k1_gej_add_var(&r2, &r2, &ptgj, NULL);
+    }
+    data.sc = sc;
+    data.pt = pt;
+
+    scratch = secp256k1_scratch_create(&ctx->error_callback, secp256k1_pippenger_scratch_size(n_points, bucket_window) + PIPPENGER_SCRATCH_OBJECTS*ALIGNMENT);
+    CHECK(secp256k1_ecmult_pippenger_batch_single(&ctx->error_callback, &ctx->ecmult_ctx, scratch, &r, &szero, ecmult_multi_callback, &data, n_points));
+    secp256k1_gej_neg(&r2, &r2);
+    secp256k1_gej_add_var(&r, &r, &r2, NULL);
+    CHECK(secp256k1_gej_is_infinity(&r));
+
+    /* With equal scalars every window adds all points to the same bucket, which is
+     * finished in Jacobian coordinates after the first round. */
+    secp256k1_gej_set_infinity(&r2);
+    for (i = 0; i < n_points; i++) {
+        secp256k1_gej_add_ge_var(&r2, &r2, &pt[i], NULL);
+        sc[i] = sc[0];
+    }
+    secp256k1_ecmult(&ctx->ecmult_ctx, &r2, &r2, &sc[0], NULL);
+    CHECK(secp256k1_ecmult_pippenger_batch_single(&ctx->error_callback, &ctx->ecmult_ctx, scratch, &r, &szero, ecmult_multi_callback, &data, n_points));
+    secp256k1_gej_neg(&r2, &r2);
+    secp256k1_gej_add_var(&r, &r, &r2, NULL);
+    CHECK(secp256k1_gej_is_infinity(&r));
+    secp256k1_scratch_destroy(&ctx->error_callback, scratch);
+    free(sc);
+    free(pt);
+}
+
 void run_ecmult_multi_tests(void) {
     secp256k1_scratch *scratch;
 
@@ -3286,19 +4529,33 @@ void run_ecmult_multi_tests(void) {
     scratch = secp256k1_scratch_create(&ctx->error_callback, 819200);
     test_ecmult_multi(scratch, secp256k1_ecmult_multi_var);
     test_ecmult_multi(NULL, secp256k1_ecmult_multi_var);
-    test_ecmult_multi(scratch, secp256k1_ecmult_pippenger_batch_single);
-    test_ecmult_multi_batch_single(secp256k1_ecmult_pippenger_batch_single);
-    test_ecmult_multi(scratch, secp256k1_ecmult_strauss_batch_single);
-    test_ecmult_multi_batch_single(secp256k1_ecmult_strauss_batch_single);
     secp256k1_scratch_destroy(&ctx->error_callback, scratch);
 
     /* Run test_ecmult_multi with space for exactly one point */
     scratch = secp256k1_scratch_create(&ctx->error_callback, secp256k1_strauss_scratch_size(1) + STRAUSS_SCRATCH_OBJECTS*ALIGNMENT);
     test_ecmult_multi(scratch, secp256k1_ecmult_multi_var);
     secp256k1_scratch_destroy(&ctx->error_callback, scratch);
+}
+
+void run_ecmult_multi_pippenger_tests(void) {
+    secp256k1_scratch *scratch = secp256k1_scratch_create(&ctx->error_callback, 819200);
+    test_ecmult_multi(scratch, secp256k1_ecmult_pippenger_batch_single);
+    test_ecmult_multi_batch_single(secp256k1_ecmult_pippenger_batch_single);
+    secp256k1_scratch_destroy(&ctx->error_callback, scratch);
+}
+
+void run_ecmult_multi_strauss_tests(void) {
+    /* Room for the 32 points test_ecmult_multi uses at most, whatever WINDOW_A is */
+    secp256k1_scratch *scratch = secp256k1_scratch_create(&ctx->error_callback, secp256k1_strauss_scratch_size(32) + STRAUSS_SCRATCH_OBJECTS*ALIGNMENT);
+    test_ecmult_multi(scratch, secp256k1_ecmult_strauss_batch_single);
+    test_ecmult_multi_batch_single(secp256k1_ecmult_strauss_batch_single);
+    secp256k1_scratch_destroy(&ctx->error_callback, scratch);
+}
 
+void run_ecmult_multi_batching_tests(void) {
     test_ecmult_multi_batch_size_helper();
     test_ecmult_multi_batching();
+    test_ecmult_multi_pippenger_affine();
 }
 
 void test_wnaf(const secp256k1_scalar *number, int w) {
@@ -3570,8 +4827,58 @@ void test_ecmult_constants(void) {
     }
 }
 
+void test_ecmult_gen_powers_of_two(void) {
+    /* Test ecmult_gen() for 2^i and -2^i, which hit every bit position of the
+     * precomputed tables individually, against ecmult_const(). */
+    secp256k1_scalar x;
+    secp256k1_gej r, expected;
+    int i;
+    secp256k1_scalar_set_int(&x, 1);
+    for (i = 0; i < 256; i++) {
+        secp256k1_ecmult_gen(&ctx->ecmult_gen_ctx, &r, &x);
+        secp256k1_ecmult_const(&expected, &secp256k1_ge_const_g, &x, 256);
+        secp256k1_gej_neg(&expected, &expected);
+        secp256k1_gej_add_var(&r, &r, &expected, NULL);
+        CHECK(secp256k1_gej_is_infinity(&r));
+        secp256k1_scalar_negate(&x, &x);
+        secp256k1_gej_neg(&expected, &expected);
+        secp256k1_ecmult_gen(&ctx->ecmult_gen_ctx, &r, &x);
+        secp256k1_gej_add_var(&r, &r, &expected, NULL);
+        CHECK(secp256k1_gej_is_infinity(&r));
+        secp256k1_scalar_negate(&x, &x);
+        secp256k1_scalar_add(&x, &x, &x);
+    }
+}
+
+#ifndef ENABLE_VERIFY_ONLY
+void test_ecmult_gen_table_get(void) {
+    /* Every entry of every row is found by the table scan (and by the portable
+     * scan, if a vectorized one is in use). */
+    secp256k1_ge_storage r;
+    uint32_t i;
+    int j;
+    for (j = 0; j < ECMULT_GEN_PREC_N; j++) {
+        for (i = 0; i < ECMULT_GEN_PREC_G; i++) {
+            secp256k1_ecmult_gen_table_get(&r, (*ctx->ecmult_gen_ctx.prec)[j], i);
+            CHECK(secp256k1_memcmp_var(&r, &(*ctx->ecmult_gen_ctx.prec)[j][i], sizeof(r)) == 0);
+#ifdef USE_ECMULT_GEN_X86_AVX2
+            secp256k1_cpu_x86_disable(SECP256K1_CPU_X86_AVX2);
+            memset(&r, 0xFF, sizeof(r));
+            secp256k1_ecmult_gen_table_get(&r, (*ctx->ecmult_gen_ctx.prec)[j], i);
+            secp256k1_cpu_x86_disable(0);
+            CHECK(secp256k1_memcmp_var(&r, &(*ctx->ecmult_gen_ctx.prec)[j][i], sizeof(r)) == 0);
+#endif
+        }
+    }
+}
+#endif
+
 void run_ecmult_constants(void) {
     test_ecmult_constants();
+    test_ecmult_gen_powers_of_two();
+#ifndef ENABLE_VERIFY_ONLY
+    test_ecmult_gen_table_get();
+#endif
 }
 
 void test_ecmult_gen_blind(void) {
@@ -3609,12 +4916,70 @@ void test_ecmult_gen_blind_reset(void) {
     CHECK(gej_xyz_equals_gej(&initial, &ctx->ecmult_gen_ctx.initial));
 }
 
+void test_ecmult_gen_reblind(void) {
+    /* Test that re-blinding changes the blinding, but not the results of ecmult_gen(). */
+    secp256k1_scalar key;
+    secp256k1_scalar b;
+    secp256k1_gej pgej;
+    secp256k1_gej pgej2;
+    secp256k1_gej i;
+    secp256k1_ge pge;
+    random_scalar_order_test(&key);
+    secp256k1_ecmult_gen(&ctx->ecmult_gen_ctx, &pgej, &key);
+    b = ctx->ecmult_gen_ctx.blind;
+    i = ctx->ecmult_gen_ctx.initial;
+    secp256k1_ecmult_gen_reblind(&ctx->ecmult_gen_ctx);
+    CHECK(!secp256k1_scalar_eq(&b, &ctx->ecmult_gen_ctx.blind));
+    secp256k1_ecmult_gen(&ctx->ecmult_gen_ctx, &pgej2, &key);
+    CHECK(!gej_xyz_equals_gej(&pgej, &pgej2));
+    CHECK(!gej_xyz_equals_gej(&i, &ctx->ecmult_gen_ctx.initial));
+    secp256k1_ge_set_gej(&pge, &pgej);
+    ge_equals_gej(&pge, &pgej2);
+}
+
+void test_context_reblind(void) {
+    unsigned char seckey[32];
+    unsigned char msg[32];
+    unsigned char sig64[64], sig64_2[64];
+    secp256k1_ecdsa_signature sig;
+    secp256k1_pubkey pubkey;
+    secp256k1_scalar b;
+    secp256k1_context *sign = secp256k1_context_clone(ctx);
+    secp256k1_context *none = secp256k1_context_create(SECP256K1_CONTEXT_NONE);
+    int i;
+
+    secp256k1_testrand256(seckey);
+    secp256k1_testrand256(msg);
+    CHECK(secp256k1_ec_pubkey_create(sign, &pubkey, seckey) == 1);
+    /* Signing, which takes a const context, never re-blinds it */
+    b = sign->ecmult_gen_ctx.blind;
+    for (i = 0; i < 4; i++) {
+        CHECK(secp256k1_ecdsa_sign(sign, &sig, msg, seckey, NULL, NULL) == 1);
+    }
+    CHECK(secp256k1_scalar_eq(&b, &sign->ecmult_gen_ctx.blind));
+    CHECK(secp256k1_ecdsa_signature_serialize_compact(ctx, sig64, &sig) == 1);
+    /* An explicit reblind changes the blinding but not the signatures */
+    CHECK(secp256k1_context_reblind(sign) == 1);
+    CHECK(!secp256k1_scalar_eq(&b, &sign->ecmult_gen_ctx.blind));
+    CHECK(secp256k1_ecdsa_sign(sign, &sig, msg, seckey, NULL, NULL) == 1);
+    CHECK(secp256k1_ecdsa_verify(ctx, &sig, msg, &pubkey) == 1);
+    CHECK(secp256k1_ecdsa_signature_serialize_compact(ctx, sig64_2, &sig) == 1);
+    CHECK(secp256k1_memcmp_var(sig64, sig64_2, 64) == 0);
+
+    /* Without signing tables there is nothing to re-blind */
+    CHECK(secp256k1_context_reblind(none) == 1);
+    secp256k1_context_destroy(sign);
+    secp256k1_context_destroy(none);
+}
+
 void run_ecmult_gen_blind(void) {
     int i;
     test_ecmult_gen_blind_reset();
     for (i = 0; i < 10; i++) {
         test_ecmult_gen_blind();
+        test_ecmult_gen_reblind();
     }
+    test_context_reblind();
 }
 
 /***** ENDOMORPHISH TESTS *****/
@@ -4069,6 +5434,68 @@ void run_ec_pubkey_parse_test(void) {
     }
 }
 
+void run_ec_pubkey_create_batch_tests(void) {
+    const unsigned char orderc[32] = {
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfe,
+        0xba, 0xae, 0xdc, 0xe6, 0xaf, 0x48, 0xa0, 0x3b,
+        0xbf, 0xd2, 0x5e, 0x8c, 0xd0, 0x36, 0x41, 0x41
+    };
+    const unsigned char zeros[sizeof(secp256k1_pubkey)] = {0x00};
+    unsigned char seckeys[100][32];
+    const unsigned char *seckey_ptrs[100];
+    secp256k1_pubkey pubkeys[100];
+    secp256k1_pubkey pubkey;
+    secp256k1_context *vrfy = secp256k1_context_create(SECP256K1_CONTEXT_VERIFY);
+    int32_t ecount = 0;
+    int invalid;
+    size_t n, i;
+
+    secp256k1_context_set_illegal_callback(ctx, counting_illegal_callback_fn, &ecount);
+    secp256k1_context_set_illegal_callback(vrfy, counting_illegal_callback_fn, &ecount);
+    for (i = 0; i < 100; i++) {
+        random_scalar_order_b32(seckeys[i]);
+        seckey_ptrs[i] = seckeys[i];
+    }
+    CHECK(secp256k1_ec_pubkey_create_batch(ctx, NULL, NULL, 0) == 1);
+    CHECK(ecount == 0);
+    CHECK(secp256k1_ec_pubkey_create_batch(ctx, NULL, seckey_ptrs, 1) == 0);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_ec_pubkey_create_batch(ctx, pubkeys, NULL, 1) == 0);
+    CHECK(ecount == 2);
+    CHECK(secp256k1_ec_pubkey_create_batch(vrfy, pubkeys, seckey_ptrs, 1) == 0);
+    CHECK(ecount == 3);
+    seckey_ptrs[1] = NULL;
+    CHECK(secp256k1_ec_pubkey_create_batch(ctx, pubkeys, seckey_ptrs, 2) == 0);
+    CHECK(ecount == 4);
+    seckey_ptrs[1] = seckeys[1];
+    secp256k1_context_set_illegal_callback(ctx, NULL, NULL);
+    secp256k1_context_destroy(vrfy);
+
+    /* Compare with secp256k1_ec_pubkey_create for sizes around the internal batch size. */
+    for (n = 1; n <= 100; n += 1 + secp256k1_testrand_int(16)) {
+        invalid = secp256k1_testrand_bits(1);
+        if (invalid) {
+            /* Replace a random key by an overflowing or zero one. */
+            i = secp256k1_testrand_int(n);
+            if (secp256k1_testrand_bits(1)) {
+                memcpy(seckeys[i], orderc, 32);
+            } else {
+                memset(seckeys[i], 0, 32);
+            }
+        }
+        CHECK(secp256k1_ec_pubkey_create_batch(ctx, pubkeys, seckey_ptrs, n) == !invalid);
+        for (i = 0; i < n; i++) {
+            if (secp256k1_ec_pubkey_create(ctx, &pubkey, seckeys[i])) {
+                CHECK(secp256k1_memcmp_var(&pubkeys[i], &pubkey, sizeof(pubkey)) == 0);
+            } else {
+                CHECK(secp256k1_memcmp_var(&pubkeys[i], zeros, sizeof(pubkey)) == 0);
+                random_scalar_order_b32(seckeys[i]);
+            }
+        }
+    }
+}
+
 void run_eckey_edge_case_test(void) {
     const unsigned char orderc[32] = {
         0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
@@ -4661,29 +6088,686 @@ void run_random_pubkeys(void) {
     }
 }
 
-void run_ecdsa_end_to_end(void) {
+#ifndef ENABLE_VERIFY_ONLY
+void test_parse_batch(void) {
+    /* A mix of valid and invalid encodings, compared to parsing them one at a time. */
+    unsigned char keys[80][65];
+    unsigned char sigs[80][74];
+    const unsigned char *key_ptrs[80];
+    const unsigned char *sig_ptrs[80];
+    size_t key_lens[80];
+    size_t sig_lens[80];
+    secp256k1_pubkey pubkeys[80], expected_keys[80];
+    secp256k1_ecdsa_signature parsed_sigs[80], expected_sigs[80];
+    size_t i, n = 1 + secp256k1_testrand_int(80);
+    int all_keys = 1, all_sigs = 1;
+    int ecount = 0;
+
+    for (i = 0; i < n; i++) {
+        secp256k1_scalar sc;
+        secp256k1_gej pj;
+        secp256k1_ge p;
+        secp256k1_ecdsa_signature sig;
+        int kind = secp256k1_testrand_int(8);
+
+        random_scalar_order_test(&sc);
+        secp256k1_ecmult_gen(&ctx->ecmult_gen_ctx, &pj, &sc);
+        secp256k1_ge_set_gej(&p, &pj);
+        secp256k1_ecdsa_signature_save(&sig, &sc, &sc);
+        key_lens[i] = 65;
+        sig_lens[i] = 74;
+        CHECK(secp256k1_eckey_pubkey_serialize(&p, keys[i], &key_lens[i], kind < 5));
+        CHECK(secp256k1_ecdsa_signature_serialize_der(ctx, sigs[i], &sig_lens[i], &sig));
+        if (kind == 0) {
+            /* Corrupt the X coordinate, which may make it invalid. */
+            keys[i][1 + secp256k1_testrand_int(32)] ^= 1 + secp256k1_testrand_int(255);
+            sigs[i][secp256k1_testrand_int(sig_lens[i])] ^= 1 + secp256k1_testrand_int(255);
+        } else if (kind == 1) {
+            /* An X coordinate that is not a field element */
+            memset(&keys[i][1], 0xFF, 32);
+            sig_lens[i] = secp256k1_testrand_int(8);
+        } else if (kind == 2) {
+            key_lens[i]--;
+            sig_lens[i]--;
+        } else if (kind == 5) {
+            /* Hybrid encoding */
+            keys[i][0] = 6 + (keys[i][64] & 1);
+        }
+        key_ptrs[i] = keys[i];
+        sig_ptrs[i] = sigs[i];
+    }
+
+    for (i = 0; i < n; i++) {
+        all_keys &= secp256k1_ec_pubkey_parse(ctx, &expected_keys[i], keys[i], key_lens[i]);
+        all_sigs &= secp256k1_ecdsa_signature_parse_der(ctx, &expected_sigs[i], sigs[i], sig_lens[i]);
+    }
+    CHECK(secp256k1_ec_pubkey_parse_batch(ctx, pubkeys, key_ptrs, key_lens, n) == all_keys);
+    CHECK(secp256k1_ecdsa_signature_parse_der_batch(ctx, parsed_sigs, sig_ptrs, sig_lens, n) == all_sigs);
+    CHECK(secp256k1_memcmp_var(expected_keys, pubkeys, n * sizeof(pubkeys[0])) == 0);
+    CHECK(secp256k1_memcmp_var(expected_sigs, parsed_sigs, n * sizeof(parsed_sigs[0])) == 0);
+
+    CHECK(secp256k1_ec_pubkey_parse_batch(ctx, NULL, NULL, NULL, 0) == 1);
+    CHECK(secp256k1_ecdsa_signature_parse_der_batch(ctx, NULL, NULL, NULL, 0) == 1);
+    secp256k1_context_set_illegal_callback(ctx, counting_illegal_callback_fn, &ecount);
+    CHECK(secp256k1_ec_pubkey_parse_batch(ctx, NULL, key_ptrs, key_lens, 1) == 0);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_ec_pubkey_parse_batch(ctx, pubkeys, NULL, key_lens, 1) == 0);
+    CHECK(ecount == 2);
+    CHECK(secp256k1_ec_pubkey_parse_batch(ctx, pubkeys, key_ptrs, NULL, 1) == 0);
+    CHECK(ecount == 3);
+    CHECK(secp256k1_ecdsa_signature_parse_der_batch(ctx, NULL, sig_ptrs, sig_lens, 1) == 0);
+    CHECK(ecount == 4);
+    CHECK(secp256k1_ecdsa_signature_parse_der_batch(ctx, parsed_sigs, NULL, sig_lens, 1) == 0);
+    CHECK(ecount == 5);
+    CHECK(secp256k1_ecdsa_signature_parse_der_batch(ctx, parsed_sigs, sig_ptrs, NULL, 1) == 0);
+    CHECK(ecount == 6);
+    key_ptrs[0] = NULL;
+    CHECK(secp256k1_ec_pubkey_parse_batch(ctx, pubkeys, key_ptrs, key_lens, 1) == 0);
+    CHECK(ecount == 7);
+    secp256k1_context_set_illegal_callback(ctx, NULL, NULL);
+}
+
+void run_parse_batch_tests(void) {
     int i;
-    for (i = 0; i < 64*count; i++) {
-        test_ecdsa_end_to_end();
+    for (i = 0; i < count; i++) {
+        test_parse_batch();
     }
 }
 
-int test_ecdsa_der_parse(const unsigned char *sig, size_t siglen, int certainly_der, int certainly_not_der) {
-    static const unsigned char zeroes[32] = {0};
-#ifdef ENABLE_OPENSSL_TESTS
-    static const unsigned char max_scalar[32] = {
-        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfe,
-        0xba, 0xae, 0xdc, 0xe6, 0xaf, 0x48, 0xa0, 0x3b,
-        0xbf, 0xd2, 0x5e, 0x8c, 0xd0, 0x36, 0x41, 0x40
-    };
-#endif
+void test_ec_pubkey_tweak_add_batch(void) {
+    /* A mix of valid and invalid tweaks, compared to tweaking one key at a time. */
+    unsigned char tweaks[40][32];
+    const unsigned char *tweak_ptrs[40];
+    secp256k1_pubkey pubkeys[40], expected[40];
+    size_t i, n = 1 + secp256k1_testrand_int(40);
+    int all = 1;
+    int ecount = 0;
+
+    for (i = 0; i < n; i++) {
+        secp256k1_scalar sc, tw;
+        secp256k1_gej pj;
+        secp256k1_ge p;
+        int kind = secp256k1_testrand_int(8);
+
+        random_scalar_order_test(&sc);
+        secp256k1_ecmult_gen(&ctx->ecmult_gen_ctx, &pj, &sc);
+        secp256k1_ge_set_gej(&p, &pj);
+        secp256k1_pubkey_save(&pubkeys[i], &p);
+        random_scalar_order_test(&tw);
+        if (kind == 0) {
+            /* A tweak that cancels the key */
+            secp256k1_scalar_negate(&tw, &sc);
+        } else if (kind == 1) {
+            secp256k1_scalar_set_int(&tw, 0);
+        }
+        secp256k1_scalar_get_b32(tweaks[i], &tw);
+        if (kind == 2) {
+            memset(tweaks[i], 0xFF, 32);
+        }
+        tweak_ptrs[i] = tweaks[i];
+        expected[i] = pubkeys[i];
+        all &= secp256k1_ec_pubkey_tweak_add(ctx, &expected[i], tweaks[i]);
+    }
+    CHECK(secp256k1_ec_pubkey_tweak_add_batch(ctx, pubkeys, tweak_ptrs, n) == all);
+    CHECK(secp256k1_memcmp_var(expected, pubkeys, n * sizeof(pubkeys[0])) == 0);
 
-    int ret = 0;
+    CHECK(secp256k1_ec_pubkey_tweak_add_batch(ctx, NULL, NULL, 0) == 1);
+    secp256k1_context_set_illegal_callback(ctx, counting_illegal_callback_fn, &ecount);
+    CHECK(secp256k1_ec_pubkey_tweak_add_batch(ctx, NULL, tweak_ptrs, 1) == 0);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_ec_pubkey_tweak_add_batch(ctx, pubkeys, NULL, 1) == 0);
+    CHECK(ecount == 2);
+    tweak_ptrs[0] = NULL;
+    CHECK(secp256k1_ec_pubkey_tweak_add_batch(ctx, pubkeys, tweak_ptrs, 1) == 0);
+    CHECK(ecount == 3);
+    secp256k1_context_set_illegal_callback(ctx, NULL, NULL);
+}
 
-    secp256k1_ecdsa_signature sig_der;
-    unsigned char roundtrip_der[2048];
-    unsigned char compact_der[64];
+void test_ec_pubkey_derive_batch(void) {
+    /* Compared to tweaking copies of the parent one at a time. */
+    unsigned char tweaks[40][32];
+    const unsigned char *tweak_ptrs[40];
+    unsigned char sk[32];
+    secp256k1_pubkey parent, children[40], expected[40];
+    secp256k1_scalar sc;
+    size_t i, n = 1 + secp256k1_testrand_int(40);
+    int all = 1;
+    int ecount = 0;
+
+    random_scalar_order_test(&sc);
+    secp256k1_scalar_get_b32(sk, &sc);
+    CHECK(secp256k1_ec_pubkey_create(ctx, &parent, sk) == 1);
+    for (i = 0; i < n; i++) {
+        secp256k1_scalar tw;
+        int kind = secp256k1_testrand_int(8);
+
+        random_scalar_order_test(&tw);
+        if (kind == 0) {
+            /* A tweak that cancels the parent */
+            secp256k1_scalar_negate(&tw, &sc);
+        } else if (kind == 1) {
+            secp256k1_scalar_set_int(&tw, 0);
+        }
+        secp256k1_scalar_get_b32(tweaks[i], &tw);
+        if (kind == 2) {
+            memset(tweaks[i], 0xFF, 32);
+        }
+        tweak_ptrs[i] = tweaks[i];
+        expected[i] = parent;
+        all &= secp256k1_ec_pubkey_tweak_add(ctx, &expected[i], tweaks[i]);
+    }
+    CHECK(secp256k1_ec_pubkey_derive_batch(ctx, children, &parent, tweak_ptrs, n) == all);
+    CHECK(secp256k1_memcmp_var(expected, children, n * sizeof(children[0])) == 0);
+
+    CHECK(secp256k1_ec_pubkey_derive_batch(ctx, NULL, &parent, NULL, 0) == 1);
+    secp256k1_context_set_illegal_callback(ctx, counting_illegal_callback_fn, &ecount);
+    CHECK(secp256k1_ec_pubkey_derive_batch(ctx, NULL, &parent, tweak_ptrs, 1) == 0);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_ec_pubkey_derive_batch(ctx, children, NULL, tweak_ptrs, 1) == 0);
+    CHECK(ecount == 2);
+    CHECK(secp256k1_ec_pubkey_derive_batch(ctx, children, &parent, NULL, 1) == 0);
+    CHECK(ecount == 3);
+    tweak_ptrs[0] = NULL;
+    CHECK(secp256k1_ec_pubkey_derive_batch(ctx, children, &parent, tweak_ptrs, 1) == 0);
+    CHECK(ecount == 4);
+    tweak_ptrs[0] = tweaks[0];
+    memset(&parent, 0, sizeof(parent));
+    CHECK(secp256k1_ec_pubkey_derive_batch(ctx, children, &parent, tweak_ptrs, 1) == 0);
+    CHECK(ecount == 5);
+    secp256k1_context_set_illegal_callback(ctx, NULL, NULL);
+}
+
+void test_ec_pubkey_create_range(const secp256k1_scalar *k, size_t n) {
+    unsigned char xs[150 * 32];
+    unsigned char expected[150 * 32];
+    unsigned char seckey[32];
+    secp256k1_scalar ki = *k;
+    size_t i;
+    int all = 1;
+
+    CHECK(n <= 150);
+    for (i = 0; i < n; i++) {
+        secp256k1_pubkey pubkey;
+        unsigned char buf[33];
+        size_t len = sizeof(buf);
+        memset(&expected[32 * i], 0, 32);
+        secp256k1_scalar_get_b32(seckey, &ki);
+        if (secp256k1_ec_pubkey_create(ctx, &pubkey, seckey)) {
+            CHECK(secp256k1_ec_pubkey_serialize(ctx, buf, &len, &pubkey, SECP256K1_EC_COMPRESSED));
+            memcpy(&expected[32 * i], &buf[1], 32);
+        } else {
+            all = 0;
+        }
+        secp256k1_scalar_add(&ki, &ki, &secp256k1_scalar_one);
+    }
+    secp256k1_scalar_get_b32(seckey, k);
+    CHECK(secp256k1_ec_pubkey_create_range(ctx, xs, seckey, n) == (secp256k1_scalar_is_zero(k) ? 0 : all));
+    if (secp256k1_scalar_is_zero(k)) {
+        memset(expected, 0, 32 * n);
+    }
+    CHECK(secp256k1_memcmp_var(xs, expected, 32 * n) == 0);
+}
+
+void run_ec_pubkey_create_range_tests(void) {
+    secp256k1_context *vrfy;
+    secp256k1_scalar k;
+    unsigned char seckey[32];
+    unsigned char xs[32];
+    int i, ecount = 0;
+
+    for (i = 0; i < count; i++) {
+        random_scalar_order_test(&k);
+        test_ec_pubkey_create_range(&k, 1 + secp256k1_testrand_int(150));
+    }
+    /* Ranges that contain doublings, or pass through zero */
+    for (i = 0; i < 4; i++) {
+        secp256k1_scalar_set_int(&k, i);
+        test_ec_pubkey_create_range(&k, 150);
+        secp256k1_scalar_set_int(&k, 5 + 66 * i);
+        secp256k1_scalar_negate(&k, &k);
+        test_ec_pubkey_create_range(&k, 150);
+    }
+
+    secp256k1_scalar_set_int(&k, 1);
+    secp256k1_scalar_get_b32(seckey, &k);
+    CHECK(secp256k1_ec_pubkey_create_range(ctx, NULL, seckey, 0) == 1);
+    secp256k1_context_set_illegal_callback(ctx, counting_illegal_callback_fn, &ecount);
+    CHECK(secp256k1_ec_pubkey_create_range(ctx, NULL, seckey, 1) == 0);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_ec_pubkey_create_range(ctx, xs, NULL, 1) == 0);
+    CHECK(ecount == 2);
+    secp256k1_context_set_illegal_callback(ctx, NULL, NULL);
+    vrfy = secp256k1_context_create(SECP256K1_CONTEXT_VERIFY);
+    secp256k1_context_set_illegal_callback(vrfy, counting_illegal_callback_fn, &ecount);
+    CHECK(secp256k1_ec_pubkey_create_range(vrfy, xs, seckey, 1) == 0);
+    CHECK(ecount == 3);
+    secp256k1_context_destroy(vrfy);
+}
+
+void run_ec_pubkey_tweak_add_batch_tests(void) {
+    int i;
+    for (i = 0; i < count; i++) {
+        test_ec_pubkey_tweak_add_batch();
+        test_ec_pubkey_derive_batch();
+    }
+}
+#endif
+
+void run_ecdsa_end_to_end(void) {
+    int i;
+    for (i = 0; i < 64*count; i++) {
+        test_ecdsa_end_to_end();
+    }
+}
+
+void test_ecmult_prepared(void) {
+    secp256k1_ecmult_prepared_point prep;
+    secp256k1_scalar na, ng;
+    secp256k1_ge a;
+    secp256k1_gej aj, r1, r2;
+
+    random_group_element_test(&a);
+    random_scalar_order_test(&na);
+    random_scalar_order_test(&ng);
+    secp256k1_gej_set_ge(&aj, &a);
+    secp256k1_ecmult_prepared_point_build(&prep, &a);
+    secp256k1_ecmult(&ctx->ecmult_ctx, &r1, &aj, &na, &ng);
+    secp256k1_ecmult_prepared(&ctx->ecmult_ctx, &r2, &prep, &na, &ng);
+    secp256k1_gej_neg(&r2, &r2);
+    secp256k1_gej_add_var(&r1, &r1, &r2, NULL);
+    CHECK(secp256k1_gej_is_infinity(&r1));
+}
+
+void test_pubkey_prepared(void) {
+    secp256k1_pubkey pubkey, zero_pk;
+    secp256k1_pubkey_prepared *prepared;
+    secp256k1_ecdsa_signature sig;
+    secp256k1_scalar r, s;
+    unsigned char seckey[32];
+    unsigned char msg[32];
+    int ecount = 0;
+
+    secp256k1_testrand256_test(msg);
+    do {
+        secp256k1_testrand256_test(seckey);
+    } while (!secp256k1_ec_seckey_verify(ctx, seckey));
+    CHECK(secp256k1_ec_pubkey_create(ctx, &pubkey, seckey) == 1);
+    CHECK(secp256k1_ecdsa_sign(ctx, &sig, msg, seckey, NULL, NULL) == 1);
+
+    secp256k1_context_set_illegal_callback(ctx, counting_illegal_callback_fn, &ecount);
+    memset(&zero_pk, 0, sizeof(zero_pk));
+    CHECK(secp256k1_pubkey_prepared_create(ctx, NULL) == NULL);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_pubkey_prepared_create(ctx, &zero_pk) == NULL);
+    CHECK(ecount == 2);
+    prepared = secp256k1_pubkey_prepared_create(ctx, &pubkey);
+    CHECK(prepared != NULL);
+    CHECK(secp256k1_ecdsa_verify_prepared(ctx, NULL, msg, prepared) == 0);
+    CHECK(ecount == 3);
+    CHECK(secp256k1_ecdsa_verify_prepared(ctx, &sig, NULL, prepared) == 0);
+    CHECK(ecount == 4);
+    CHECK(secp256k1_ecdsa_verify_prepared(ctx, &sig, msg, NULL) == 0);
+    CHECK(ecount == 5);
+
+    CHECK(secp256k1_ecdsa_verify_prepared(ctx, &sig, msg, prepared) == 1);
+    /* High-S signatures are rejected, like by secp256k1_ecdsa_verify. */
+    secp256k1_ecdsa_signature_load(ctx, &r, &s, &sig);
+    secp256k1_scalar_negate(&s, &s);
+    secp256k1_ecdsa_signature_save(&sig, &r, &s);
+    CHECK(secp256k1_ecdsa_verify_prepared(ctx, &sig, msg, prepared) == 0);
+    secp256k1_scalar_negate(&s, &s);
+    secp256k1_ecdsa_signature_save(&sig, &r, &s);
+    msg[0] ^= 1;
+    CHECK(secp256k1_ecdsa_verify(ctx, &sig, msg, &pubkey) == 0);
+    CHECK(secp256k1_ecdsa_verify_prepared(ctx, &sig, msg, prepared) == 0);
+    secp256k1_pubkey_prepared_destroy(ctx, prepared);
+    secp256k1_pubkey_prepared_destroy(ctx, NULL);
+    CHECK(ecount == 5);
+    secp256k1_context_set_illegal_callback(ctx, NULL, NULL);
+}
+
+void run_pubkey_prepared_tests(void) {
+    int i;
+    for (i = 0; i < count; i++) {
+        test_ecmult_prepared();
+        test_pubkey_prepared();
+    }
+}
+
+#define VERIFY_MANY_TEST_N (2 * ECMULT_LANES + 1)
+
+void test_ecdsa_verify_many(void) {
+    secp256k1_ecdsa_signature sig_data[VERIFY_MANY_TEST_N];
+    secp256k1_pubkey pk_data[VERIFY_MANY_TEST_N];
+    unsigned char msg_data[VERIFY_MANY_TEST_N][32];
+    const secp256k1_ecdsa_signature *sigs[VERIFY_MANY_TEST_N];
+    const secp256k1_pubkey *pubkeys[VERIFY_MANY_TEST_N];
+    const unsigned char *msgs[VERIFY_MANY_TEST_N];
+    int results[VERIFY_MANY_TEST_N];
+    int ecount = 0;
+    int all_valid = 1;
+    size_t i, n;
+
+    for (i = 0; i < VERIFY_MANY_TEST_N; i++) {
+        unsigned char seckey[32];
+        secp256k1_scalar r, s;
+        do {
+            secp256k1_testrand256_test(seckey);
+        } while (!secp256k1_ec_seckey_verify(ctx, seckey));
+        secp256k1_testrand256_test(msg_data[i]);
+        CHECK(secp256k1_ec_pubkey_create(ctx, &pk_data[i], seckey) == 1);
+        CHECK(secp256k1_ecdsa_sign(ctx, &sig_data[i], msg_data[i], seckey, NULL, NULL) == 1);
+        /* Make some of the signatures invalid in different ways. */
+        switch (secp256k1_testrand_int(8)) {
+            case 0: msg_data[i][secp256k1_testrand_int(32)] ^= 1; break;
+            case 1:
+                secp256k1_ecdsa_signature_load(ctx, &r, &s, &sig_data[i]);
+                secp256k1_scalar_negate(&s, &s);
+                secp256k1_ecdsa_signature_save(&sig_data[i], &r, &s);
+                break;
+            case 2:
+                secp256k1_ecdsa_signature_load(ctx, &r, &s, &sig_data[i]);
+                secp256k1_ecdsa_signature_save(&sig_data[i], &secp256k1_scalar_zero, &s);
+                break;
+            case 3: memset(&pk_data[i], 0, sizeof(pk_data[i])); break;
+        }
+        sigs[i] = &sig_data[i];
+        pubkeys[i] = &pk_data[i];
+        msgs[i] = msg_data[i];
+    }
+
+    secp256k1_context_set_illegal_callback(ctx, counting_illegal_callback_fn, &ecount);
+    for (n = 0; n <= VERIFY_MANY_TEST_N; n++) {
+        for (i = 0; i < n; i++) {
+            results[i] = -1;
+        }
+        CHECK(secp256k1_ecdsa_verify_many(ctx, results, sigs, msgs, pubkeys, n) == all_valid);
+        CHECK(secp256k1_ecdsa_verify_many(ctx, NULL, sigs, msgs, pubkeys, n) == all_valid);
+        for (i = 0; i < n; i++) {
+            CHECK(results[i] == secp256k1_ecdsa_verify(ctx, sigs[i], msgs[i], pubkeys[i]));
+        }
+        if (n < VERIFY_MANY_TEST_N) {
+            all_valid &= secp256k1_ecdsa_verify(ctx, sigs[n], msgs[n], pubkeys[n]);
+        }
+    }
+    /* Loading the zeroed public keys above called the illegal callback. */
+    ecount = 0;
+    CHECK(secp256k1_ecdsa_verify_many(ctx, results, NULL, NULL, NULL, 0) == 1);
+    CHECK(ecount == 0);
+    CHECK(secp256k1_ecdsa_verify_many(ctx, results, NULL, msgs, pubkeys, 1) == 0);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_ecdsa_verify_many(ctx, results, sigs, NULL, pubkeys, 1) == 0);
+    CHECK(ecount == 2);
+    CHECK(secp256k1_ecdsa_verify_many(ctx, results, sigs, msgs, NULL, 1) == 0);
+    CHECK(ecount == 3);
+    sigs[1] = NULL;
+    CHECK(secp256k1_ecdsa_verify_many(ctx, results, sigs, msgs, pubkeys, 2) == 0);
+    CHECK(ecount == 4);
+    secp256k1_context_set_illegal_callback(ctx, NULL, NULL);
+}
+
+void run_ecdsa_verify_many_tests(void) {
+    int i;
+    for (i = 0; i < count; i++) {
+        test_ecdsa_verify_many();
+    }
+}
+
+void test_sigcache_table(void) {
+    /* Entries that are dropped are counted as evictions, so at any load every entry
+     * that was inserted is either found or counted. */
+    const unsigned char salt[32] = "sigcache test salt";
+    uint64_t entries[96][2];
+    secp256k1_sigcache *cache = secp256k1_sigcache_create(ctx, 64, salt);
+    size_t i, found = 0, hits, misses, evictions;
+
+    CHECK(cache != NULL);
+    for (i = 0; i < 96; i++) {
+        secp256k1_sha256 hash;
+        unsigned char buf[32];
+        secp256k1_testrand256(buf);
+        secp256k1_sigcache_hasher(cache, &hash);
+        secp256k1_sha256_write(&hash, buf, 32);
+        secp256k1_sigcache_entry(entries[i], &hash);
+        CHECK(!secp256k1_sigcache_lookup(cache, entries[i]));
+        secp256k1_sigcache_insert(cache, entries[i]);
+    }
+    for (i = 0; i < 96; i++) {
+        found += secp256k1_sigcache_lookup(cache, entries[i]);
+    }
+    secp256k1_sigcache_stats(ctx, cache, &hits, &misses, &evictions);
+    CHECK(found + evictions == 96);
+    CHECK(evictions >= 96 - 64);
+    CHECK(hits == found);
+    CHECK(misses == 96 + 96 - found);
+    secp256k1_sigcache_destroy(ctx, cache);
+}
+
+void test_sigcache_ecdsa(void) {
+    unsigned char salt[32];
+    unsigned char seckey[32];
+    unsigned char msg[8][32];
+    secp256k1_ecdsa_signature sig[8];
+    secp256k1_pubkey pubkey;
+    secp256k1_sigcache *cache;
+    size_t i, hits, misses, evictions;
+    int ecount = 0;
+
+    secp256k1_testrand256(salt);
+    do {
+        secp256k1_testrand256_test(seckey);
+    } while (!secp256k1_ec_seckey_verify(ctx, seckey));
+    CHECK(secp256k1_ec_pubkey_create(ctx, &pubkey, seckey) == 1);
+    for (i = 0; i < 8; i++) {
+        secp256k1_testrand256_test(msg[i]);
+        CHECK(secp256k1_ecdsa_sign(ctx, &sig[i], msg[i], seckey, NULL, NULL) == 1);
+    }
+
+    secp256k1_context_set_illegal_callback(ctx, counting_illegal_callback_fn, &ecount);
+    CHECK(secp256k1_sigcache_create(ctx, 0, salt) == NULL);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_sigcache_create(ctx, 16, NULL) == NULL);
+    CHECK(ecount == 2);
+    cache = secp256k1_sigcache_create(ctx, 16, salt);
+    CHECK(cache != NULL);
+    CHECK(secp256k1_ecdsa_verify_cached(ctx, NULL, &sig[0], msg[0], &pubkey) == 0);
+    CHECK(ecount == 3);
+    CHECK(secp256k1_ecdsa_verify_cached(ctx, cache, NULL, msg[0], &pubkey) == 0);
+    CHECK(ecount == 4);
+    CHECK(secp256k1_ecdsa_verify_cached(ctx, cache, &sig[0], NULL, &pubkey) == 0);
+    CHECK(ecount == 5);
+    CHECK(secp256k1_ecdsa_verify_cached(ctx, cache, &sig[0], msg[0], NULL) == 0);
+    CHECK(ecount == 6);
+    secp256k1_sigcache_stats(ctx, NULL, &hits, NULL, NULL);
+    CHECK(ecount == 7);
+    secp256k1_context_set_illegal_callback(ctx, NULL, NULL);
+
+    for (i = 0; i < 8; i++) {
+        CHECK(secp256k1_ecdsa_verify_cached(ctx, cache, &sig[i], msg[i], &pubkey) == 1);
+    }
+    for (i = 0; i < 8; i++) {
+        CHECK(secp256k1_ecdsa_verify_cached(ctx, cache, &sig[i], msg[i], &pubkey) == 1);
+    }
+    secp256k1_sigcache_stats(ctx, cache, &hits, &misses, &evictions);
+    CHECK(misses == 8);
+    CHECK(hits + evictions >= 8);
+    /* Incorrect signatures are not cached. */
+    msg[0][0] ^= 1;
+    CHECK(secp256k1_ecdsa_verify_cached(ctx, cache, &sig[0], msg[0], &pubkey) == 0);
+    CHECK(secp256k1_ecdsa_verify_cached(ctx, cache, &sig[0], msg[0], &pubkey) == 0);
+    secp256k1_sigcache_stats(ctx, cache, NULL, &misses, NULL);
+    CHECK(misses == 10);
+    secp256k1_sigcache_destroy(ctx, cache);
+    secp256k1_sigcache_destroy(ctx, NULL);
+}
+
+void run_sigcache_tests(void) {
+    int i;
+    for (i = 0; i < count; i++) {
+        test_sigcache_table();
+    }
+    test_sigcache_ecdsa();
+}
+
+void test_ecdsa_sign_session(void) {
+    /* Compared to secp256k1_ecdsa_sign with secp256k1_nonce_function_rfc6979 */
+    unsigned char seckey[32];
+    unsigned char msg[32];
+    unsigned char ndata[32];
+    unsigned char keydata[96];
+    unsigned char nonce[32];
+    unsigned char out[32];
+    unsigned char zeros[64] = {0};
+    secp256k1_ecdsa_signature sig, expected;
+    secp256k1_ecdsa_session session;
+    secp256k1_rfc6979_hmac_sha256 rng;
+    secp256k1_sha256 inner;
+    secp256k1_scalar sc;
+    int use_ndata = secp256k1_testrand_bits(1);
+    int i;
+    int ecount = 0;
+
+    random_scalar_order_test(&sc);
+    secp256k1_scalar_get_b32(seckey, &sc);
+    secp256k1_testrand256(ndata);
+    CHECK(secp256k1_ecdsa_session_init(ctx, &session, seckey) == 1);
+    for (i = 0; i < 4; i++) {
+        secp256k1_testrand256_test(msg);
+        CHECK(secp256k1_ecdsa_sign(ctx, &expected, msg, seckey, secp256k1_nonce_function_rfc6979, use_ndata ? ndata : NULL) == 1);
+        CHECK(secp256k1_ecdsa_sign_session(ctx, &sig, msg, &session, use_ndata ? ndata : NULL) == 1);
+        CHECK(secp256k1_memcmp_var(&sig, &expected, sizeof(sig)) == 0);
+    }
+
+    /* The generator of a session gives, call by call, the nonces of
+     * nonce_function_rfc6979 for increasing counters. */
+    memcpy(keydata, seckey, 32);
+    memcpy(keydata + 32, msg, 32);
+    memcpy(keydata + 64, ndata, 32);
+    secp256k1_rfc6979_hmac_sha256_start(&inner);
+    secp256k1_sha256_write(&inner, keydata, 96);
+    secp256k1_rfc6979_hmac_sha256_initialize_started(&rng, &inner, keydata, 96);
+    for (i = 0; i < 4; i++) {
+        CHECK(nonce_function_rfc6979(nonce, msg, seckey, NULL, ndata, i) == 1);
+        secp256k1_rfc6979_hmac_sha256_generate(&rng, out, 32);
+        CHECK(secp256k1_memcmp_var(nonce, out, 32) == 0);
+    }
+    secp256k1_rfc6979_hmac_sha256_finalize(&rng);
+
+    secp256k1_context_set_illegal_callback(ctx, counting_illegal_callback_fn, &ecount);
+    CHECK(secp256k1_ecdsa_session_init(ctx, NULL, seckey) == 0);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_ecdsa_session_init(ctx, &session, NULL) == 0);
+    CHECK(ecount == 2);
+    CHECK(secp256k1_memcmp_var(session.data, zeros, 64) == 0);
+    CHECK(secp256k1_ecdsa_session_init(ctx, &session, seckey) == 1);
+    CHECK(secp256k1_ecdsa_sign_session(ctx, NULL, msg, &session, NULL) == 0);
+    CHECK(ecount == 3);
+    CHECK(secp256k1_ecdsa_sign_session(ctx, &sig, NULL, &session, NULL) == 0);
+    CHECK(ecount == 4);
+    CHECK(secp256k1_ecdsa_sign_session(ctx, &sig, msg, NULL, NULL) == 0);
+    CHECK(ecount == 5);
+    secp256k1_context_set_illegal_callback(ctx, NULL, NULL);
+
+    /* An invalid secret key gives a zeroed session, which cannot sign */
+    memset(seckey, 0, 32);
+    CHECK(secp256k1_ecdsa_session_init(ctx, &session, seckey) == 0);
+    CHECK(secp256k1_memcmp_var(session.data, zeros, 64) == 0);
+    CHECK(secp256k1_ecdsa_sign_session(ctx, &sig, msg, &session, NULL) == 0);
+    CHECK(secp256k1_memcmp_var(&sig, zeros, sizeof(sig)) == 0);
+}
+
+void run_ecdsa_sign_session_tests(void) {
+    int i;
+    for (i = 0; i < count; i++) {
+        test_ecdsa_sign_session();
+    }
+}
+
+void test_nonce_pool_ecdsa(void) {
+    unsigned char seckey[32];
+    unsigned char seed[32];
+    unsigned char msg[32];
+    unsigned char r[16][32];
+    unsigned char sig64[64];
+    secp256k1_ecdsa_signature sig, sig2;
+    secp256k1_pubkey pubkey;
+    secp256k1_nonce_pool *pool;
+    secp256k1_scalar sc;
+    size_t i, j;
+    int ecount = 0;
+
+    random_scalar_order_test(&sc);
+    secp256k1_scalar_get_b32(seckey, &sc);
+    CHECK(secp256k1_ec_pubkey_create(ctx, &pubkey, seckey) == 1);
+    secp256k1_testrand256(seed);
+    secp256k1_testrand256_test(msg);
+    pool = secp256k1_nonce_pool_create(ctx, 8);
+    CHECK(pool != NULL);
+    CHECK(secp256k1_nonce_pool_count(ctx, pool) == 0);
+    CHECK(secp256k1_ecdsa_sign_pooled(ctx, &sig, msg, seckey, pool) == 0);
+
+    /* Fill the pool twice with the same seed: all sixteen nonces differ. */
+    for (i = 0; i < 16; i++) {
+        if (i % 8 == 0) {
+            CHECK(secp256k1_nonce_pool_fill(ctx, pool, seed) == 1);
+            CHECK(secp256k1_nonce_pool_count(ctx, pool) == 8);
+        }
+        secp256k1_testrand256_test(msg);
+        CHECK(secp256k1_ecdsa_sign_pooled(ctx, &sig, msg, seckey, pool) == 1);
+        CHECK(secp256k1_nonce_pool_count(ctx, pool) == 7 - i % 8);
+        CHECK(secp256k1_ecdsa_verify(ctx, &sig, msg, &pubkey) == 1);
+        CHECK(secp256k1_ecdsa_signature_normalize(ctx, NULL, &sig) == 0);
+        CHECK(secp256k1_ecdsa_signature_serialize_compact(ctx, sig64, &sig) == 1);
+        memcpy(r[i], sig64, 32);
+        for (j = 0; j < i; j++) {
+            CHECK(secp256k1_memcmp_var(r[i], r[j], 32) != 0);
+        }
+    }
+    CHECK(secp256k1_ecdsa_sign_pooled(ctx, &sig, msg, seckey, pool) == 0);
+
+    /* An invalid secret key consumes a nonce */
+    CHECK(secp256k1_nonce_pool_fill(ctx, pool, seed) == 1);
+    memset(seckey, 0, 32);
+    CHECK(secp256k1_ecdsa_sign_pooled(ctx, &sig, msg, seckey, pool) == 0);
+    CHECK(secp256k1_nonce_pool_count(ctx, pool) == 7);
+    memset(&sig2, 0, sizeof(sig2));
+    CHECK(secp256k1_memcmp_var(&sig, &sig2, sizeof(sig)) == 0);
+
+    secp256k1_context_set_illegal_callback(ctx, counting_illegal_callback_fn, &ecount);
+    CHECK(secp256k1_nonce_pool_create(ctx, 0) == NULL);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_nonce_pool_fill(ctx, NULL, seed) == 0);
+    CHECK(ecount == 2);
+    CHECK(secp256k1_nonce_pool_fill(ctx, pool, NULL) == 0);
+    CHECK(ecount == 3);
+    CHECK(secp256k1_nonce_pool_count(ctx, NULL) == 0);
+    CHECK(ecount == 4);
+    CHECK(secp256k1_ecdsa_sign_pooled(ctx, &sig, msg, seckey, NULL) == 0);
+    CHECK(ecount == 5);
+    CHECK(secp256k1_ecdsa_sign_pooled(ctx, &sig, msg, NULL, pool) == 0);
+    CHECK(ecount == 6);
+    CHECK(secp256k1_nonce_pool_count(ctx, pool) == 7);
+    secp256k1_context_set_illegal_callback(ctx, NULL, NULL);
+    secp256k1_nonce_pool_destroy(ctx, pool);
+    secp256k1_nonce_pool_destroy(ctx, NULL);
+}
+
+int test_ecdsa_der_parse(const unsigned char *sig, size_t siglen, int certainly_der, int certainly_not_der) {
+    static const unsigned char zeroes[32] = {0};
+#ifdef ENABLE_OPENSSL_TESTS
+    static const unsigned char max_scalar[32] = {
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfe,
+        0xba, 0xae, 0xdc, 0xe6, 0xaf, 0x48, 0xa0, 0x3b,
+        0xbf, 0xd2, 0x5e, 0x8c, 0xd0, 0x36, 0x41, 0x40
+    };
+#endif
+
+    int ret = 0;
+
+    secp256k1_ecdsa_signature sig_der;
+    unsigned char roundtrip_der[2048];
+    unsigned char compact_der[64];
     size_t len_der = 2048;
     int parsed_der = 0, valid_der = 0, roundtrips_der = 0;
 
@@ -5428,6 +7512,8 @@ void run_ecdsa_openssl(void) {
 }
 #endif
 
+/* The module tests all sign, so a verification-only build leaves them out. */
+#ifndef ENABLE_VERIFY_ONLY
 #ifdef ENABLE_MODULE_ECDH
 # include "modules/ecdh/tests_impl.h"
 #endif
@@ -5444,6 +7530,23 @@ void run_ecdsa_openssl(void) {
 # include "modules/schnorrsig/tests_impl.h"
 #endif
 
+#ifdef ENABLE_MODULE_ECMULT_MULTI
+# include "modules/ecmult_multi/tests_impl.h"
+#endif
+
+#ifdef ENABLE_MODULE_BATCH
+# include "modules/batch/tests_impl.h"
+#endif
+
+#ifdef ENABLE_MODULE_MUSIG
+# include "modules/musig/tests_impl.h"
+#endif
+
+#ifdef ENABLE_MODULE_SCHNORRSIG_HALFAGG
+# include "modules/schnorrsig_halfagg/tests_impl.h"
+#endif
+#endif /* ENABLE_VERIFY_ONLY */
+
 void run_secp256k1_memczero_test(void) {
     unsigned char buf1[6] = {1, 2, 3, 4, 5, 6};
     unsigned char buf2[sizeof(buf1)];
@@ -5614,118 +7717,289 @@ void run_cmov_tests(void) {
     ge_storage_cmov_test();
 }
 
-int main(int argc, char **argv) {
-    /* Disable buffering for stdout to improve reliability of getting
-     * diagnostic information. Happens right at the start of main because
-     * setbuf must be used before any other operation on the stream. */
-    setbuf(stdout, NULL);
-    /* Also disable buffering for stderr because it's not guaranteed that it's
-     * unbuffered on all systems. */
-    setbuf(stderr, NULL);
+#ifdef ENABLE_VERIFY_ONLY
+/* Signing fails as with a context created without SECP256K1_CONTEXT_SIGN, and
+ * verification works as usual. */
+void run_verify_only_tests(void) {
+    static const unsigned char pubkey33[33] = {
+        0x02, 0x84, 0xbf, 0x75, 0x62, 0x26, 0x2b, 0xbd, 0x69, 0x40, 0x08, 0x57, 0x48, 0xf3, 0xbe, 0x6a,
+        0xfa, 0x52, 0xae, 0x31, 0x71, 0x55, 0x18, 0x1e, 0xce, 0x31, 0xb6, 0x63, 0x51, 0xcc, 0xff, 0xa4,
+        0xb0
+    };
+    /* The RFC6979 signature of msg with the secret key seckey, which belongs to pubkey33 */
+    static const unsigned char sig_der[71] = {
+        0x30, 0x45, 0x02, 0x21, 0x00, 0xaa, 0xc5, 0x62, 0x16, 0x2a, 0x69, 0x48, 0xf3, 0x6b, 0x4f, 0x4a,
+        0x52, 0x11, 0x34, 0x0c, 0xdb, 0x38, 0xb8, 0x47, 0xa8, 0x92, 0xb0, 0xb6, 0xae, 0x3e, 0x66, 0x90,
+        0x0f, 0xf9, 0x35, 0x69, 0xfa, 0x02, 0x20, 0x10, 0x12, 0xfd, 0xb8, 0x1c, 0xb3, 0xf2, 0xf7, 0xaa,
+        0x07, 0x83, 0xce, 0x8b, 0xad, 0x08, 0x40, 0x9a, 0xc9, 0xfe, 0x41, 0x30, 0x6d, 0x83, 0x9a, 0x76,
+        0x32, 0xb5, 0xdd, 0x96, 0x60, 0x8a, 0x04
+    };
+    secp256k1_context *sign = secp256k1_context_create(SECP256K1_CONTEXT_SIGN);
+    secp256k1_context *sign_clone;
+    unsigned char seckey[32], msg[32], nonce[32], seed[32];
+    secp256k1_pubkey pubkey;
+    secp256k1_ecdsa_signature sig;
+    int ecount = 0;
+    int i;
 
-    /* find iteration count */
-    if (argc > 1) {
-        count = strtol(argv[1], NULL, 0);
+    for (i = 0; i < 32; i++) {
+        seckey[i] = i + 1;
+        msg[i] = 0x80 + i;
     }
-    printf("test count = %i\n", count);
+    secp256k1_testrand256(seed);
+    secp256k1_context_set_illegal_callback(sign, counting_illegal_callback_fn, &ecount);
 
-    /* find random seed */
-    secp256k1_testrand_init(argc > 2 ? argv[2] : NULL);
+    CHECK(secp256k1_context_preallocated_size(SECP256K1_CONTEXT_SIGN) == secp256k1_context_preallocated_size(SECP256K1_CONTEXT_NONE));
+    CHECK(secp256k1_context_randomize(sign, seed) == 1);
+    sign_clone = secp256k1_context_clone(sign);
+    CHECK(secp256k1_ec_pubkey_create(sign, &pubkey, seckey) == 0);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_ecdsa_sign(sign, &sig, msg, seckey, NULL, NULL) == 0);
+    CHECK(ecount == 2);
+    CHECK(secp256k1_nonce_function_rfc6979(nonce, msg, seckey, NULL, NULL, 0) == 0);
+    CHECK(secp256k1_nonce_function_default(nonce, msg, seckey, NULL, NULL, 0) == 0);
 
-    /* initialize */
+    CHECK(secp256k1_ec_pubkey_parse(ctx, &pubkey, pubkey33, sizeof(pubkey33)) == 1);
+    CHECK(secp256k1_ecdsa_signature_parse_der(ctx, &sig, sig_der, sizeof(sig_der)) == 1);
+    CHECK(secp256k1_ecdsa_verify(ctx, &sig, msg, &pubkey) == 1);
+    msg[secp256k1_testrand_int(32)] ^= 1 << secp256k1_testrand_int(8);
+    CHECK(secp256k1_ecdsa_verify(ctx, &sig, msg, &pubkey) == 0);
+
+    secp256k1_context_destroy(sign_clone);
+    secp256k1_context_destroy(sign);
+}
+#endif
+
+static void run_context_tests_heap(void) {
     run_context_tests(0);
+}
+
+static void run_context_tests_prealloc(void) {
     run_context_tests(1);
-    run_scratch_tests();
-    ctx = secp256k1_context_create(SECP256K1_CONTEXT_SIGN | SECP256K1_CONTEXT_VERIFY);
-    if (secp256k1_testrand_bits(1)) {
-        unsigned char rand32[32];
-        secp256k1_testrand256(rand32);
-        CHECK(secp256k1_context_randomize(ctx, secp256k1_testrand_bits(1) ? rand32 : NULL));
-    }
+}
 
-    run_rand_bits();
-    run_rand_int();
+/* The tests, in groups. Each group draws its random numbers from its own stream
+ * (see secp256k1_testrand_reseed_index), so that a group does the same whether
+ * it runs alone, in a shard, or after all the others. */
+/* A verification-only build runs only the groups that do not sign or compute
+ * public keys from secret keys. */
+static void (*const test_groups[])(void) = {
+    /* context tests */
+#ifdef ENABLE_VERIFY_ONLY
+    run_verify_only_tests,
+#else
+    run_context_tests_heap,
+    run_context_tests_prealloc,
+    run_context_clone_shared_tests,
+    run_context_table_alignment_tests,
+    run_verify_table_tests,
+#endif
+    run_scratch_tests,
+    run_allocator_tests,
+
+    run_rand_bits,
+    run_rand_int,
 
-    run_sha256_tests();
-    run_hmac_sha256_tests();
-    run_rfc6979_hmac_sha256_tests();
+    run_ctz_tests,
+
+    run_sha256_tests,
+    run_sha256_transform_tests,
+    run_tagged_hasher_tests,
+    run_hmac_sha256_tests,
+    run_rfc6979_hmac_sha256_tests,
 
 #ifndef USE_NUM_NONE
     /* num tests */
-    run_num_smalltests();
+    run_num_smalltests,
 #endif
 
     /* scalar tests */
-    run_scalar_tests();
+    run_scalar_tests,
 
     /* field tests */
-    run_field_inv();
-    run_field_inv_var();
-    run_field_inv_all_var();
-    run_field_misc();
-    run_field_convert();
-    run_sqr();
-    run_sqrt();
+    run_field_inv,
+    run_field_inv_var,
+    run_field_inv_all_var,
+    run_scalar_inverse_all,
+    run_field_misc,
+    run_field_convert,
+    run_sqr,
+#ifdef SECP256K1_FE_X8
+    run_field_x8,
+#endif
+    run_sqrt,
+    run_counters_tests,
+    run_event_callback_tests,
+
+    /* scalar/field inverse tests */
+    run_inverse_tests,
 
     /* group tests */
-    run_ge();
-    run_group_decompress();
+    run_ge,
+    run_group_decompress,
 
     /* ecmult tests */
-    run_wnaf();
-    run_point_times_order();
-    run_ecmult_near_split_bound();
-    run_ecmult_chain();
-    run_ecmult_constants();
-    run_ecmult_gen_blind();
-    run_ecmult_const_tests();
-    run_ecmult_multi_tests();
-    run_ec_combine();
+    run_wnaf,
+    run_point_times_order,
+#ifndef ENABLE_VERIFY_ONLY
+    run_ecmult_near_split_bound,
+#endif
+    run_ecmult_short_scalars,
+    run_ecmult_chain,
+#ifndef ENABLE_VERIFY_ONLY
+    run_ecmult_constants,
+    run_ecmult_gen_blind,
+#endif
+    run_ecmult_const_tests,
+    run_ecmult_3_tests,
+    run_ecmult_small_tests,
+    run_ecmult_lanes_tests,
+    run_ecmult_multi_tests,
+    run_ecmult_multi_pippenger_tests,
+    run_ecmult_multi_strauss_tests,
+    run_ecmult_multi_batching_tests,
+#ifndef ENABLE_VERIFY_ONLY
+    run_ec_combine,
+#endif
 
     /* endomorphism tests */
-    run_endomorphism_tests();
+    run_endomorphism_tests,
 
     /* EC point parser test */
-    run_ec_pubkey_parse_test();
+    run_ec_pubkey_parse_test,
 
+#ifndef ENABLE_VERIFY_ONLY
     /* EC key edge cases */
-    run_eckey_edge_case_test();
+    run_eckey_edge_case_test,
+    run_ec_pubkey_create_batch_tests,
+#endif
 
     /* EC key arithmetic test */
-    run_eckey_negate_test();
+    run_eckey_negate_test,
 
-#ifdef ENABLE_MODULE_ECDH
+#if defined(ENABLE_MODULE_ECDH) && !defined(ENABLE_VERIFY_ONLY)
     /* ecdh tests */
-    run_ecdh_tests();
+    run_ecdh_tests,
 #endif
 
     /* ecdsa tests */
-    run_random_pubkeys();
-    run_ecdsa_der_parse();
-    run_ecdsa_sign_verify();
-    run_ecdsa_end_to_end();
-    run_ecdsa_edge_cases();
+    run_random_pubkeys,
+    run_ecdsa_der_parse,
+#ifndef ENABLE_VERIFY_ONLY
+    run_ecdsa_sign_verify,
+    run_ecdsa_end_to_end,
+    run_ecdsa_sign_session_tests,
+    run_parse_batch_tests,
+    run_ec_pubkey_tweak_add_batch_tests,
+    run_ec_pubkey_create_range_tests,
+    run_pubkey_prepared_tests,
+    run_ecdsa_verify_many_tests,
+    run_sigcache_tests,
+    test_nonce_pool_ecdsa,
+    run_ecdsa_edge_cases,
 #ifdef ENABLE_OPENSSL_TESTS
-    run_ecdsa_openssl();
+    run_ecdsa_openssl,
 #endif
 
 #ifdef ENABLE_MODULE_RECOVERY
     /* ECDSA pubkey recovery tests */
-    run_recovery_tests();
+    run_recovery_tests,
 #endif
 
 #ifdef ENABLE_MODULE_EXTRAKEYS
-    run_extrakeys_tests();
+    run_extrakeys_tests,
 #endif
 
 #ifdef ENABLE_MODULE_SCHNORRSIG
-    run_schnorrsig_tests();
+    run_schnorrsig_tests,
+#endif
+
+#ifdef ENABLE_MODULE_ECMULT_MULTI
+    run_ecmult_multi_module_tests,
+#endif
+
+#ifdef ENABLE_MODULE_BATCH
+    run_batch_tests,
+#endif
+
+#ifdef ENABLE_MODULE_MUSIG
+    run_musig_tests,
+#endif
+
+#ifdef ENABLE_MODULE_SCHNORRSIG_HALFAGG
+    run_schnorrsig_halfagg_tests,
 #endif
+#endif /* ENABLE_VERIFY_ONLY */
 
     /* util tests */
-    run_secp256k1_memczero_test();
+    run_secp256k1_memczero_test,
+
+    run_cmov_tests,
+};
+
+static int num_shards = 1;
+
+/** Run the groups of shard index: those whose position is index modulo num_shards. */
+static void run_test_shard(int index) {
+    int i;
+    for (i = index; i < (int)(sizeof(test_groups) / sizeof(test_groups[0])); i += num_shards) {
+        secp256k1_testrand_reseed_index(i);
+        test_groups[i]();
+    }
+}
+
+int main(int argc, char **argv) {
+    int this_shard = -1;
+
+    /* Disable buffering for stdout to improve reliability of getting
+     * diagnostic information. Happens right at the start of main because
+     * setbuf must be used before any other operation on the stream. */
+    setbuf(stdout, NULL);
+    /* Also disable buffering for stderr because it's not guaranteed that it's
+     * unbuffered on all systems. */
+    setbuf(stderr, NULL);
+
+    /* find iteration count */
+    if (argc > 1) {
+        count = strtol(argv[1], NULL, 0);
+    }
+    printf("test count = %i\n", count);
 
-    run_cmov_tests();
+    /* find random seed */
+    secp256k1_testrand_init(argc > 2 ? argv[2] : NULL);
+
+    /* set up sharding: with only a number of shards, run them all in parallel */
+    if (argc > 3) {
+        num_shards = strtol(argv[3], NULL, 0);
+        if (argc > 4) {
+            this_shard = strtol(argv[4], NULL, 0);
+        }
+        if (num_shards < 1 || this_shard >= num_shards) {
+            fprintf(stderr, "Usage: %s [count] [seed] [numshards] [thisshard]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    /* initialize */
+    ctx = secp256k1_context_create(SECP256K1_CONTEXT_SIGN | SECP256K1_CONTEXT_VERIFY);
+    if (secp256k1_testrand_bits(1)) {
+        unsigned char rand32[32];
+        secp256k1_testrand256(rand32);
+        CHECK(secp256k1_context_randomize(ctx, secp256k1_testrand_bits(1) ? rand32 : NULL));
+    }
+
+    if (this_shard >= 0) {
+        printf("running tests for shard %i (out of [0..%i])\n", this_shard, num_shards - 1);
+        run_test_shard(this_shard);
+    } else if (num_shards > 1) {
+        printf("running %i shards\n", num_shards);
+        if (secp256k1_test_run_shards(num_shards, run_test_shard) != 0) {
+            fprintf(stderr, "rerun a failed shard alone with: %s %i <random seed> %i <shard>\n", argv[0], count, num_shards);
+            return 1;
+        }
+    } else {
+        run_test_shard(0);
+    }
 
     secp256k1_testrand_finish();
 
@@ -14,6 +14,7 @@
 #include <time.h>
 
 #undef USE_ECMULT_STATIC_PRECOMPUTATION
+#undef USE_ECMULT_STATIC_VERIFY_TABLE
 
 #ifndef EXHAUSTIVE_TEST_ORDER
 /* see group_impl.h for allowable values */
@@ -25,6 +26,7 @@
 #include "group.h"
 #include "secp256k1.c"
 #include "testrand_impl.h"
+#include "testshard_impl.h"
 
 static int count = 2;
 
@@ -352,43 +354,14 @@ void test_exhaustive_sign(const secp256k1_context *ctx, const secp256k1_ge *grou
 #include "src/modules/schnorrsig/tests_exhaustive_impl.h"
 #endif
 
-int main(int argc, char** argv) {
+/** Run the tests for the sections that skip_section assigns to this_core. */
+static void run_exhaustive_tests(void) {
     int i;
     secp256k1_gej groupj[EXHAUSTIVE_TEST_ORDER];
     secp256k1_ge group[EXHAUSTIVE_TEST_ORDER];
     unsigned char rand32[32];
     secp256k1_context *ctx;
 
-    /* Disable buffering for stdout to improve reliability of getting
-     * diagnostic information. Happens right at the start of main because
-     * setbuf must be used before any other operation on the stream. */
-    setbuf(stdout, NULL);
-    /* Also disable buffering for stderr because it's not guaranteed that it's
-     * unbuffered on all systems. */
-    setbuf(stderr, NULL);
-
-    printf("Exhaustive tests for order %lu\n", (unsigned long)EXHAUSTIVE_TEST_ORDER);
-
-    /* find iteration count */
-    if (argc > 1) {
-        count = strtol(argv[1], NULL, 0);
-    }
-    printf("test count = %i\n", count);
-
-    /* find random seed */
-    secp256k1_testrand_init(argc > 2 ? argv[2] : NULL);
-
-    /* set up split processing */
-    if (argc > 4) {
-        num_cores = strtol(argv[3], NULL, 0);
-        this_core = strtol(argv[4], NULL, 0);
-        if (num_cores < 1 || this_core >= num_cores) {
-            fprintf(stderr, "Usage: %s [count] [seed] [numcores] [thiscore]\n", argv[0]);
-            return 1;
-        }
-        printf("running tests for core %lu (out of [0..%lu])\n", (unsigned long)this_core, (unsigned long)num_cores - 1);
-    }
-
     while (count--) {
         /* Build context */
         ctx = secp256k1_context_create(SECP256K1_CONTEXT_SIGN | SECP256K1_CONTEXT_VERIFY);
@@ -446,6 +419,59 @@ int main(int argc, char** argv) {
 
         secp256k1_context_destroy(ctx);
     }
+}
+
+/** Run core index of num_cores, in a process of its own. */
+static void run_exhaustive_core(int index) {
+    this_core = index;
+    run_exhaustive_tests();
+}
+
+int main(int argc, char** argv) {
+    /* Disable buffering for stdout to improve reliability of getting
+     * diagnostic information. Happens right at the start of main because
+     * setbuf must be used before any other operation on the stream. */
+    setbuf(stdout, NULL);
+    /* Also disable buffering for stderr because it's not guaranteed that it's
+     * unbuffered on all systems. */
+    setbuf(stderr, NULL);
+
+    printf("Exhaustive tests for order %lu\n", (unsigned long)EXHAUSTIVE_TEST_ORDER);
+
+    /* find iteration count */
+    if (argc > 1) {
+        count = strtol(argv[1], NULL, 0);
+    }
+    printf("test count = %i\n", count);
+
+    /* find random seed */
+    secp256k1_testrand_init(argc > 2 ? argv[2] : NULL);
+
+    /* set up split processing: with only a number of cores, run them all in parallel */
+    if (argc > 4) {
+        num_cores = strtol(argv[3], NULL, 0);
+        this_core = strtol(argv[4], NULL, 0);
+        if (num_cores < 1 || this_core >= num_cores) {
+            fprintf(stderr, "Usage: %s [count] [seed] [numcores] [thiscore]\n", argv[0]);
+            return 1;
+        }
+        printf("running tests for core %lu (out of [0..%lu])\n", (unsigned long)this_core, (unsigned long)num_cores - 1);
+        run_exhaustive_tests();
+    } else if (argc > 3) {
+        num_cores = strtol(argv[3], NULL, 0);
+        if (num_cores < 1) {
+            fprintf(stderr, "Usage: %s [count] [seed] [numcores] [thiscore]\n", argv[0]);
+            return 1;
+        }
+        printf("running %lu cores\n", (unsigned long)num_cores);
+        /* Every core generates the same random group, so a failed one can be rerun alone with the same seed. */
+        if (secp256k1_test_run_shards(num_cores, run_exhaustive_core) != 0) {
+            fprintf(stderr, "rerun a failed core alone with: %s %i <random seed> %lu <core>\n", argv[0], count, (unsigned long)num_cores);
+            return 1;
+        }
+    } else {
+        run_exhaustive_tests();
+    }
 
     secp256k1_testrand_finish();
 
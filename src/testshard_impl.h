@@ -0,0 +1,72 @@
+/**********************************************************************
+ * Distributed under the MIT software license, see the accompanying   *
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
+ **********************************************************************/
+
+#ifndef SECP256K1_TESTSHARD_IMPL_H
+#define SECP256K1_TESTSHARD_IMPL_H
+
+/* Runs the shards of a test binary in parallel, one child process per shard.
+ * The tests keep their state (the context, the count, the random generator) in
+ * globals, so processes rather than threads: every child starts from a copy of
+ * the state the parent set up and can fail with abort() like a sequential run.
+ * Without fork (see configure), shards run one after the other. */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "util.h"
+
+#if defined(HAVE_FORK) && defined(HAVE_SYS_WAIT_H) && defined(HAVE_UNISTD_H)
+#define SECP256K1_TEST_FORK 1
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+/** Call run_shard(index) for every index in [0..num_shards-1], each in its own
+ *  process if possible. Returns the number of shards that failed, after
+ *  printing which ones did. A shard that runs in this process (because fork
+ *  is unavailable or failed) aborts the whole run if it fails. */
+static int secp256k1_test_run_shards(int num_shards, void (*run_shard)(int index)) {
+    int failures = 0;
+    int i;
+#ifdef SECP256K1_TEST_FORK
+    pid_t *pids = (pid_t*)malloc(num_shards * sizeof(pid_t));
+    int started;
+
+    CHECK(pids != NULL);
+    for (started = 0; started < num_shards; started++) {
+        /* Children inherit unflushed stdio buffers and would print them again. */
+        fflush(stdout);
+        fflush(stderr);
+        pids[started] = fork();
+        if (pids[started] == 0) {
+            run_shard(started);
+            exit(EXIT_SUCCESS);
+        }
+        if (pids[started] < 0) {
+            fprintf(stderr, "could not start shard %d; running the remaining shards in this process\n", started);
+            break;
+        }
+    }
+    for (i = started; i < num_shards; i++) {
+        run_shard(i);
+    }
+    for (i = 0; i < started; i++) {
+        int status;
+        if (waitpid(pids[i], &status, 0) != pids[i] || !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+            fprintf(stderr, "shard %d of %d failed\n", i, num_shards);
+            failures++;
+        }
+    }
+    free(pids);
+#else
+    for (i = 0; i < num_shards; i++) {
+        run_shard(i);
+    }
+#endif
+    return failures;
+}
+
+#endif /* SECP256K1_TESTSHARD_IMPL_H */
@@ -25,6 +25,18 @@ static SECP256K1_INLINE void secp256k1_callback_call(const secp256k1_callback *
     cb->fn(text, (void*)cb->data);
 }
 
+/* A callback for the events of secp256k1_context_set_event_callback; fn may be NULL. */
+typedef struct {
+    void (*fn)(int event, size_t wanted, size_t available, void* data);
+    const void* data;
+} secp256k1_event_callback;
+
+static SECP256K1_INLINE void secp256k1_event_callback_call(const secp256k1_event_callback * const cb, int event, size_t wanted, size_t available) {
+    if (cb->fn != NULL) {
+        cb->fn(event, wanted, available, (void*)cb->data);
+    }
+}
+
 #ifdef DETERMINISTIC
 #define TEST_FAILURE(msg) do { \
     fprintf(stderr, "%s\n", msg); \
@@ -43,6 +55,48 @@ static SECP256K1_INLINE void secp256k1_callback_call(const secp256k1_callback *
 #define EXPECT(x,c) (x)
 #endif
 
+/* Hint that the memory at p is going to be read soon. */
+#if SECP256K1_GNUC_PREREQ(3, 1)
+#define PREFETCH(p) __builtin_prefetch(p)
+#else
+#define PREFETCH(p) ((void)(p))
+#endif
+
+/* Relaxed atomic accesses of the words that threads may share without locks. Without
+ * compiler support for lock-free 64-bit atomics they are plain accesses. */
+#if defined(__ATOMIC_RELAXED) && defined(__GCC_ATOMIC_LLONG_LOCK_FREE) && __GCC_ATOMIC_LLONG_LOCK_FREE == 2
+#define ATOMIC_LOAD(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#define ATOMIC_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#define ATOMIC_INC(p) ((void)__atomic_fetch_add((p), 1, __ATOMIC_RELAXED))
+#else
+#define ATOMIC_LOAD(p) (*(p))
+#define ATOMIC_STORE(p, v) (*(p) = (v))
+#define ATOMIC_INC(p) ((void)++*(p))
+#endif
+
+/* Per-thread operation counters, read by secp256k1_counters_snapshot, which cost nothing
+ * unless the library is built with --enable-counters. SECP256K1_COUNT(FE_MUL) counts one
+ * operation of the kind SECP256K1_COUNTER_FE_MUL, SECP256K1_COUNT_N(FE_MUL, n) n of them. */
+#ifdef ENABLE_COUNTERS
+#include "include/secp256k1.h"
+# if defined(_MSC_VER)
+#  define SECP256K1_THREAD_LOCAL __declspec(thread)
+# elif defined(__GNUC__)
+#  define SECP256K1_THREAD_LOCAL __thread
+# else
+#  error "Counters need thread-local storage"
+# endif
+static SECP256K1_INLINE size_t *secp256k1_counters(void) {
+    static SECP256K1_THREAD_LOCAL size_t counters[SECP256K1_COUNTER_COUNT];
+    return counters;
+}
+#define SECP256K1_COUNT(kind) ((void)++secp256k1_counters()[SECP256K1_COUNTER_##kind])
+#define SECP256K1_COUNT_N(kind, n) ((void)(secp256k1_counters()[SECP256K1_COUNTER_##kind] += (n)))
+#else
+#define SECP256K1_COUNT(kind) ((void)0)
+#define SECP256K1_COUNT_N(kind, n) ((void)0)
+#endif
+
 #ifdef DETERMINISTIC
 #define CHECK(cond) do { \
     if (EXPECT(!(cond), 0)) { \
@@ -96,6 +150,48 @@ static SECP256K1_INLINE void *checked_malloc(const secp256k1_callback* cb, size_
     return ret;
 }
 
+/** A memory allocator: alloc returns a block of at least size bytes, suitably
+ *  aligned to hold an object of any type, or NULL; free releases a block that
+ *  alloc returned. Both are passed data. NULL functions stand for malloc and
+ *  free, so that code which only stores the default allocator (such as
+ *  secp256k1_context_preallocated_create) does not refer to them, and a static
+ *  link of a program that never allocates does not need them. */
+typedef struct {
+    void* (*alloc)(size_t size, void* data);
+    void (*free)(void* ptr, void* data);
+    const void* data;
+} secp256k1_allocator;
+
+static const secp256k1_allocator default_allocator = { NULL, NULL, NULL };
+
+/** Allocate with allocator, returning NULL on failure. */
+static SECP256K1_INLINE void *secp256k1_allocator_try_alloc(const secp256k1_allocator* allocator, size_t size) {
+    if (allocator->alloc == NULL) {
+        return malloc(size);
+    }
+    return allocator->alloc(size, (void*)allocator->data);
+}
+
+/** Like checked_malloc, but allocates with allocator. */
+static SECP256K1_INLINE void *secp256k1_allocator_alloc(const secp256k1_allocator* allocator, const secp256k1_callback* cb, size_t size) {
+    void *ret = secp256k1_allocator_try_alloc(allocator, size);
+    if (ret == NULL) {
+        secp256k1_callback_call(cb, "Out of memory");
+    }
+    return ret;
+}
+
+static SECP256K1_INLINE void secp256k1_allocator_free(const secp256k1_allocator* allocator, void *ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+    if (allocator->free == NULL) {
+        free(ptr);
+    } else {
+        allocator->free(ptr, (void*)allocator->data);
+    }
+}
+
 static SECP256K1_INLINE void *checked_realloc(const secp256k1_callback* cb, void *ptr, size_t size) {
     void *ret = realloc(ptr, size);
     if (ret == NULL) {
@@ -145,6 +241,23 @@ static SECP256K1_INLINE void *manual_alloc(void** prealloc_ptr, size_t alloc_siz
     return ret;
 }
 
+/* The precomputed tables are aligned to cache lines, so that every 64-byte
+ * secp256k1_ge_storage entry occupies exactly one line (and a single prefetch
+ * brings in a whole entry). */
+#define CACHE_LINE_SIZE 64
+
+/* The space manual_alloc_cache_aligned reserves for an object of size bytes. */
+#define CACHE_ALIGNED_ALLOC_SIZE(size) ROUND_TO_ALIGN((size) + CACHE_LINE_SIZE - 1)
+
+/* Like manual_alloc, but returns a pointer aligned to CACHE_LINE_SIZE (in absolute
+ * terms, whatever the alignment of base). Always reserves
+ * CACHE_ALIGNED_ALLOC_SIZE(alloc_size) bytes, so the layout of a preallocated
+ * block does not depend on its address. */
+static SECP256K1_INLINE void *manual_alloc_cache_aligned(void** prealloc_ptr, size_t alloc_size, void* base, size_t max_size) {
+    unsigned char* ret = (unsigned char*)manual_alloc(prealloc_ptr, CACHE_ALIGNED_ALLOC_SIZE(alloc_size), base, max_size);
+    return ret + (CACHE_LINE_SIZE - (size_t)((uintptr_t)ret % CACHE_LINE_SIZE)) % CACHE_LINE_SIZE;
+}
+
 /* Macro for restrict, when available and not in a VERIFY build. */
 #if defined(SECP256K1_BUILD) && defined(VERIFY)
 # define SECP256K1_RESTRICT
@@ -276,4 +389,69 @@ SECP256K1_GNUC_EXT typedef __int128 int128_t;
 # endif
 #endif
 
+#ifndef __has_builtin
+#define __has_builtin(x) 0
+#endif
+
+/* Determine the number of trailing zero bits in a (non-zero) 32-bit x.
+ * This function is only intended to be used as fallback for
+ * secp256k1_ctz32_var, but permits it to be tested separately. */
+static SECP256K1_INLINE int secp256k1_ctz32_var_debruijn(uint32_t x) {
+    static const uint8_t debruijn[32] = {
+        0x00, 0x01, 0x02, 0x18, 0x03, 0x13, 0x06, 0x19, 0x16, 0x04, 0x14, 0x0A,
+        0x10, 0x07, 0x0C, 0x1A, 0x1F, 0x17, 0x12, 0x05, 0x15, 0x09, 0x0F, 0x0B,
+        0x1E, 0x11, 0x08, 0x0E, 0x1D, 0x0D, 0x1C, 0x1B
+    };
+    return debruijn[((x & -x) * 0x04D7651FU) >> 27];
+}
+
+/* Determine the number of trailing zero bits in a (non-zero) 64-bit x.
+ * This function is only intended to be used as fallback for
+ * secp256k1_ctz64_var, but permits it to be tested separately. */
+static SECP256K1_INLINE int secp256k1_ctz64_var_debruijn(uint64_t x) {
+    static const uint8_t debruijn[64] = {
+        0, 1, 2, 53, 3, 7, 54, 27, 4, 38, 41, 8, 34, 55, 48, 28,
+        62, 5, 39, 46, 44, 42, 22, 9, 24, 35, 59, 56, 49, 18, 29, 11,
+        63, 52, 6, 26, 37, 40, 33, 47, 61, 45, 43, 21, 23, 58, 17, 10,
+        51, 25, 36, 32, 60, 20, 57, 16, 50, 31, 19, 15, 30, 14, 13, 12
+    };
+    return debruijn[((x & -x) * 0x022FDD63CC95386DULL) >> 58];
+}
+
+/* Determine the number of trailing zero bits in a (non-zero) 32-bit x. */
+static SECP256K1_INLINE int secp256k1_ctz32_var(uint32_t x) {
+    VERIFY_CHECK(x != 0);
+#if (__has_builtin(__builtin_ctz) || SECP256K1_GNUC_PREREQ(3,4))
+    /* If the unsigned type is sufficient to represent the largest uint32_t, consider __builtin_ctz. */
+    if (((unsigned)UINT32_MAX) == UINT32_MAX) {
+        return __builtin_ctz(x);
+    }
+#endif
+#if (__has_builtin(__builtin_ctzl) || SECP256K1_GNUC_PREREQ(3,4))
+    /* Otherwise consider __builtin_ctzl (the unsigned long type is always at least 32 bits). */
+    return __builtin_ctzl(x);
+#else
+    /* If no suitable CTZ builtin is available, use a (variable time) software emulation. */
+    return secp256k1_ctz32_var_debruijn(x);
+#endif
+}
+
+/* Determine the number of trailing zero bits in a (non-zero) 64-bit x. */
+static SECP256K1_INLINE int secp256k1_ctz64_var(uint64_t x) {
+    VERIFY_CHECK(x != 0);
+#if (__has_builtin(__builtin_ctzl) || SECP256K1_GNUC_PREREQ(3,4))
+    /* If the unsigned long type is sufficient to represent the largest uint64_t, consider __builtin_ctzl. */
+    if (((unsigned long)UINT64_MAX) == UINT64_MAX) {
+        return __builtin_ctzl(x);
+    }
+#endif
+#if (__has_builtin(__builtin_ctzll) || SECP256K1_GNUC_PREREQ(3,4))
+    /* Otherwise consider __builtin_ctzll (the unsigned long long type is always at least 64 bits). */
+    return __builtin_ctzll(x);
+#else
+    /* If no suitable CTZ builtin is available, use a (variable time) software emulation. */
+    return secp256k1_ctz64_var_debruijn(x);
+#endif
+}
+
 #endif /* SECP256K1_UTIL_H */
@@ -9,6 +9,10 @@
 #include "assumptions.h"
 #include "util.h"
 
+/* The library is compiled into this test, like into the unit tests, so that the
+ * internal constant-time functions (the inversion backends) can be checked too. */
+#include "secp256k1.c"
+
 #ifdef ENABLE_MODULE_ECDH
 # include "include/secp256k1_ecdh.h"
 #endif
@@ -25,10 +29,18 @@
 #include "include/secp256k1_schnorrsig.h"
 #endif
 
+#ifdef ENABLE_MODULE_MUSIG
+#include "include/secp256k1_musig.h"
+#endif
+
 int main(void) {
     secp256k1_context* ctx;
     secp256k1_ecdsa_signature signature;
+    secp256k1_ecdsa_session ecdsa_session;
     secp256k1_pubkey pubkey;
+    secp256k1_pubkey pubkeys[2];
+    secp256k1_nonce_pool *pool;
+    const unsigned char *keys[2];
     size_t siglen = 74;
     size_t outputlen = 33;
     int i;
@@ -44,6 +56,19 @@ int main(void) {
 #ifdef ENABLE_MODULE_EXTRAKEYS
     secp256k1_keypair keypair;
 #endif
+#ifdef ENABLE_MODULE_SCHNORRSIG
+    secp256k1_schnorrsig_session sign_session;
+#endif
+#ifdef ENABLE_MODULE_MUSIG
+    const secp256k1_pubkey *pubkey_ptr = &pubkey;
+    secp256k1_musig_keyagg_cache keyagg_cache;
+    secp256k1_musig_secnonce secnonce;
+    secp256k1_musig_pubnonce pubnonce;
+    const secp256k1_musig_pubnonce *pubnonce_ptr = &pubnonce;
+    secp256k1_musig_aggnonce aggnonce;
+    secp256k1_musig_session session;
+    secp256k1_musig_partial_sig partial_sig;
+#endif
 
     if (!RUNNING_ON_VALGRIND) {
         fprintf(stderr, "This test can only usefully be run inside valgrind.\n");
@@ -73,6 +98,15 @@ int main(void) {
     CHECK(ret);
     CHECK(secp256k1_ec_pubkey_serialize(ctx, spubkey, &outputlen, &pubkey, SECP256K1_EC_COMPRESSED) == 1);
 
+    /* Test batch keygen. */
+    keys[0] = key;
+    keys[1] = key;
+    VALGRIND_MAKE_MEM_UNDEFINED(key, 32);
+    ret = secp256k1_ec_pubkey_create_batch(ctx, pubkeys, keys, 2);
+    VALGRIND_MAKE_MEM_DEFINED(pubkeys, sizeof(pubkeys));
+    VALGRIND_MAKE_MEM_DEFINED(&ret, sizeof(ret));
+    CHECK(ret);
+
     /* Test signing. */
     VALGRIND_MAKE_MEM_UNDEFINED(key, 32);
     ret = secp256k1_ecdsa_sign(ctx, &signature, msg, key, NULL, NULL);
@@ -81,12 +115,48 @@ int main(void) {
     CHECK(ret);
     CHECK(secp256k1_ecdsa_signature_serialize_der(ctx, sig, &siglen, &signature));
 
+    /* Test signing with a session. */
+    VALGRIND_MAKE_MEM_UNDEFINED(key, 32);
+    ret = secp256k1_ecdsa_session_init(ctx, &ecdsa_session, key);
+    VALGRIND_MAKE_MEM_DEFINED(&ret, sizeof(ret));
+    CHECK(ret == 1);
+    ret = secp256k1_ecdsa_sign_session(ctx, &signature, msg, &ecdsa_session, NULL);
+    VALGRIND_MAKE_MEM_DEFINED(&signature, sizeof(secp256k1_ecdsa_signature));
+    VALGRIND_MAKE_MEM_DEFINED(&ret, sizeof(ret));
+    CHECK(ret);
+
+    /* Test signing with a nonce pool. */
+    pool = secp256k1_nonce_pool_create(ctx, 2);
+    CHECK(pool != NULL);
+    VALGRIND_MAKE_MEM_UNDEFINED(msg, 32);
+    ret = secp256k1_nonce_pool_fill(ctx, pool, msg);
+    VALGRIND_MAKE_MEM_DEFINED(&ret, sizeof(ret));
+    CHECK(ret);
+    VALGRIND_MAKE_MEM_DEFINED(msg, 32);
+    VALGRIND_MAKE_MEM_UNDEFINED(key, 32);
+    ret = secp256k1_ecdsa_sign_pooled(ctx, &signature, msg, key, pool);
+    VALGRIND_MAKE_MEM_DEFINED(&signature, sizeof(secp256k1_ecdsa_signature));
+    VALGRIND_MAKE_MEM_DEFINED(&ret, sizeof(ret));
+    CHECK(ret);
+
 #ifdef ENABLE_MODULE_ECDH
     /* Test ECDH. */
     VALGRIND_MAKE_MEM_UNDEFINED(key, 32);
     ret = secp256k1_ecdh(ctx, msg, &pubkey, key, NULL, NULL);
     VALGRIND_MAKE_MEM_DEFINED(&ret, sizeof(ret));
     CHECK(ret == 1);
+    VALGRIND_MAKE_MEM_UNDEFINED(key, 32);
+    ret = secp256k1_ecdh_xonly(ctx, msg, &pubkey, key, NULL, NULL);
+    VALGRIND_MAKE_MEM_DEFINED(&ret, sizeof(ret));
+    CHECK(ret == 1);
+    {
+        unsigned char *msg_ptr = msg;
+        const secp256k1_pubkey *pubkey_ptr = &pubkey;
+        VALGRIND_MAKE_MEM_UNDEFINED(key, 32);
+        ret = secp256k1_ecdh_batch(ctx, &msg_ptr, &pubkey_ptr, 1, key, NULL, NULL);
+        VALGRIND_MAKE_MEM_DEFINED(&ret, sizeof(ret));
+        CHECK(ret == 1);
+    }
 #endif
 
 #ifdef ENABLE_MODULE_RECOVERY
@@ -150,8 +220,66 @@ int main(void) {
     ret = secp256k1_schnorrsig_sign(ctx, sig, msg, &keypair, NULL, NULL);
     VALGRIND_MAKE_MEM_DEFINED(&ret, sizeof(ret));
     CHECK(ret == 1);
+    ret = secp256k1_schnorrsig_sign_pooled(ctx, sig, msg, &keypair, pool);
+    VALGRIND_MAKE_MEM_DEFINED(&ret, sizeof(ret));
+    CHECK(ret == 1);
+    keys[0] = msg;
+    ret = secp256k1_schnorrsig_sign_batch(ctx, sig, keys, 1, &keypair, NULL);
+    VALGRIND_MAKE_MEM_DEFINED(&ret, sizeof(ret));
+    CHECK(ret == 1);
+    ret = secp256k1_schnorrsig_session_init(ctx, &sign_session, &keypair, NULL);
+    VALGRIND_MAKE_MEM_DEFINED(&ret, sizeof(ret));
+    CHECK(ret == 1);
+    ret = secp256k1_schnorrsig_sign_session(ctx, sig, msg, &sign_session);
+    VALGRIND_MAKE_MEM_DEFINED(&ret, sizeof(ret));
+    CHECK(ret == 1);
 #endif
 
+#ifdef ENABLE_MODULE_MUSIG
+    VALGRIND_MAKE_MEM_UNDEFINED(key, 32);
+    ret = secp256k1_keypair_create(ctx, &keypair, key);
+    VALGRIND_MAKE_MEM_DEFINED(&ret, sizeof(ret));
+    CHECK(ret == 1);
+    ret = secp256k1_keypair_pub(ctx, &pubkey, &keypair);
+    VALGRIND_MAKE_MEM_DEFINED(&pubkey, sizeof(pubkey));
+    VALGRIND_MAKE_MEM_DEFINED(&ret, sizeof(ret));
+    CHECK(ret == 1);
+    ret = secp256k1_musig_pubkey_agg(ctx, NULL, NULL, &keyagg_cache, &pubkey_ptr, 1);
+    CHECK(ret == 1);
+    /* The session id is secret, like the key */
+    VALGRIND_MAKE_MEM_UNDEFINED(msg, 32);
+    ret = secp256k1_musig_nonce_gen(ctx, &secnonce, &pubnonce, msg, key, &pubkey, NULL, &keyagg_cache, NULL);
+    VALGRIND_MAKE_MEM_DEFINED(&ret, sizeof(ret));
+    CHECK(ret == 1);
+    VALGRIND_MAKE_MEM_DEFINED(msg, 32);
+    ret = secp256k1_musig_nonce_agg(ctx, &aggnonce, &pubnonce_ptr, 1);
+    CHECK(ret == 1);
+    ret = secp256k1_musig_nonce_process(ctx, &session, &aggnonce, msg, &keyagg_cache);
+    CHECK(ret == 1);
+    ret = secp256k1_musig_partial_sign(ctx, &partial_sig, &secnonce, &keypair, &keyagg_cache, &session);
+    VALGRIND_MAKE_MEM_DEFINED(&ret, sizeof(ret));
+    CHECK(ret == 1);
+#endif
+
+    /* Every constant-time inversion backend, whichever one is configured. */
+    {
+        secp256k1_fe fe;
+        secp256k1_scalar scalar;
+        VALGRIND_MAKE_MEM_UNDEFINED(key, 32);
+        secp256k1_scalar_set_b32(&scalar, key, NULL);
+        secp256k1_scalar_inverse_addchain(&scalar, &scalar);
+        secp256k1_scalar_inverse_safegcd(&scalar, &scalar);
+        secp256k1_scalar_inverse(&scalar, &scalar);
+        ret = secp256k1_fe_set_b32(&fe, key);
+        secp256k1_fe_inv_addchain(&fe, &fe);
+        secp256k1_fe_inv_safegcd(&fe, &fe);
+        secp256k1_fe_inv(&fe, &fe);
+        VALGRIND_MAKE_MEM_DEFINED(&ret, sizeof(ret));
+        CHECK(ret == 1);
+    }
+
+    secp256k1_nonce_pool_destroy(ctx, pool);
+
     secp256k1_context_destroy(ctx);
     return 0;
 }